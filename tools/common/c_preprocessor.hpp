@@ -0,0 +1,1085 @@
+/*
+ *   C lexer and preprocessor for the headers archives are made from
+ *   (header/lua_all.h): object- and function-like macros with # and ##,
+ *   conditional inclusion with defined() and integer constant
+ *   expressions, #undef and #error. #include is not followed; what system
+ *   headers would contribute (the <limits.h> constants) is predefined by
+ *   the caller for the data model it compiles for.
+ *
+ *   Expansion follows the hide-set algorithm of the standard (Prosser): a
+ *   token produced by expanding a macro is never expanded by that macro
+ *   again, and function-like macros take their arguments fully expanded
+ *   unless they are operands of # or ##.
+ *
+ *   A Preprocessor is a value. Copying one snapshots the macro table (its
+ *   entries are shared, not copied) and the conditional stack, so parts of
+ *   a header can be expanded in parallel once a pass over the directives
+ *   alone has found the state each part starts in. A run can also leave a
+ *   Trace of the macros it looked at and changed; another preprocessor
+ *   that agrees on those names would do the same, so builds of one header
+ *   under several configurations reuse each part's run where they can.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "common/hash.hpp"
+
+
+namespace common {
+
+struct CppError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct CToken {
+    enum Kind : uint8_t { IDENT, NUMBER, CHAR, STRING, PUNCT };
+
+    Kind kind = PUNCT;
+    bool space = false;  // preceded by white space
+    int line = 0;
+    std::string text;
+    std::shared_ptr<const std::vector<std::string>> hide;  // macros that may not expand it (sorted)
+
+    // Identifier, keyword or punctuator spelled 's'.
+    bool is(const char *s) const { return (kind == IDENT || kind == PUNCT) && text == s; }
+};
+
+// A source line after splicing and comment removal.
+struct CLine {
+    std::string text;
+    int line = 0;
+};
+
+// Joins backslash-newlines and replaces comments by a space. A comment
+// spanning lines joins them, as the standard has comments removed before
+// directives are recognized.
+inline std::vector<CLine> c_lines(const char *p, size_t n, int first_line = 1) {
+    std::vector<CLine> out;
+    CLine cur;
+    cur.line = first_line;
+    int line = first_line;
+    char quote = 0;
+    bool block = false;
+    for (size_t i = 0; i < n; i++) {
+        char c = p[i];
+        if (c == '\\' && (i + 1 < n && (p[i + 1] == '\n' || (p[i + 1] == '\r' && i + 2 < n && p[i + 2] == '\n')))) {
+            i += p[i + 1] == '\r' ? 2 : 1;
+            line++;
+            continue;
+        }
+        if (c == '\n') {
+            line++;
+            if (block) {
+                continue;
+            }
+            quote = 0;  // unterminated literals end with the line
+            out.push_back(std::move(cur));
+            cur = CLine();
+            cur.line = line;
+            continue;
+        }
+        if (block) {
+            if (c == '*' && i + 1 < n && p[i + 1] == '/') {
+                block = false;
+                i++;
+                cur.text += ' ';
+            }
+            continue;
+        }
+        if (quote) {
+            cur.text += c;
+            if (c == '\\' && i + 1 < n && p[i + 1] != '\n') {
+                cur.text += p[++i];
+            } else if (c == quote) {
+                quote = 0;
+            }
+            continue;
+        }
+        if (c == '/' && i + 1 < n && p[i + 1] == '*') {
+            block = true;
+            i++;
+            continue;
+        }
+        if (c == '/' && i + 1 < n && p[i + 1] == '/') {
+            while (i + 1 < n && p[i + 1] != '\n') {
+                i++;
+            }
+            continue;
+        }
+        if (c == '"' || c == '\'') {
+            quote = c;
+        }
+        if (c != '\r') {
+            cur.text += c;
+        }
+    }
+    if (!cur.text.empty()) {
+        out.push_back(std::move(cur));
+    }
+    return out;
+}
+
+// Tokens of one logical line (c_lines), from 'pos'.
+inline void c_lex(const std::string &s, int line, std::vector<CToken> &out, size_t pos = 0) {
+    static const char *const puncts[] = {"...", "<<=", ">>=", "->", "++", "--", "<<", ">>", "<=", ">=", "==",
+                                         "!=",  "&&",  "||",  "*=", "/=", "%=", "+=", "-=", "&=", "^=", "|=",
+                                         "##"};
+    auto ident = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$'; };
+    bool space = false;
+    size_t n = s.size();
+    while (pos < n) {
+        char c = s[pos];
+        if (c == ' ' || c == '\t' || c == '\f' || c == '\v' || c == '\r') {
+            space = true;
+            pos++;
+            continue;
+        }
+        CToken t;
+        t.line = line;
+        t.space = space;
+        space = false;
+        size_t start = pos;
+        bool prefix = (c == 'L' || c == 'u' || c == 'U') && pos + 1 < n && (s[pos + 1] == '"' || s[pos + 1] == '\'');
+        if (prefix || c == '"' || c == '\'') {
+            char q = s[prefix ? pos + 1 : pos];
+            pos += prefix ? 2 : 1;
+            while (pos < n && s[pos] != q) {
+                pos += s[pos] == '\\' ? 2 : 1;
+            }
+            pos = std::min(pos + 1, n);
+            t.kind = q == '"' ? CToken::STRING : CToken::CHAR;
+        } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+                   (c == '.' && pos + 1 < n && std::isdigit(static_cast<unsigned char>(s[pos + 1])))) {
+            pos++;
+            while (pos < n) {
+                char d = s[pos];
+                if ((d == '+' || d == '-') && std::strchr("eEpP", s[pos - 1])) {
+                    pos++;
+                } else if (ident(d) || d == '.') {
+                    pos++;
+                } else {
+                    break;
+                }
+            }
+            t.kind = CToken::NUMBER;
+        } else if (ident(c)) {
+            while (pos < n && ident(s[pos])) {
+                pos++;
+            }
+            t.kind = CToken::IDENT;
+        } else {
+            size_t len = 1;
+            for (const char *p : puncts) {
+                size_t l = std::strlen(p);
+                if (s.compare(pos, l, p) == 0) {
+                    len = l;
+                    break;
+                }
+            }
+            pos += len;
+            t.kind = CToken::PUNCT;
+        }
+        t.text = s.substr(start, pos - start);
+        out.push_back(std::move(t));
+    }
+}
+
+// Integer constant expressions: #if conditions, and the array sizes, enum
+// values and bit widths of declarations. Identifiers and type names left
+// after macro expansion are resolved by the scope.
+class ConstantExpression {
+  public:
+    struct Value {
+        int64_t v = 0;
+        bool is_unsigned = false;
+        unsigned bits = 32;  // int, or 64 for long long, size_t, and everything in #if
+    };
+
+    struct Scope {
+        virtual ~Scope() = default;
+        // Value of an identifier (enum constant); false if unknown.
+        virtual bool constant(const std::string &, int64_t &) const { return false; }
+        // A type name at t[pos], as in casts and sizeof: advances pos past it.
+        virtual bool type_name(const std::vector<CToken> &, size_t &, uint64_t & /*size*/, bool & /*is_integer*/,
+                               bool & /*is_signed*/) const {
+            return false;
+        }
+        bool preprocessor = false;  // unknown identifiers are 0, arithmetic is in intmax_t
+    };
+
+    static Value evaluate(const std::vector<CToken> &t, const Scope &scope) {
+        ConstantExpression e(t, scope);
+        Value v = e.conditional(true);
+        if (e.pos_ != t.size()) {
+            e.fail("unexpected '" + t[e.pos_].text + "'");
+        }
+        return v;
+    }
+
+    // Value of a number or character token; false for floating literals.
+    static bool literal(const CToken &t, Value &v) {
+        if (t.kind == CToken::CHAR) {
+            size_t i = t.text.find('\'') + 1;
+            v = Value();
+            v.v = char_value(t.text, i);
+            return true;
+        }
+        const std::string &s = t.text;
+        bool hex = s.size() > 1 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X');
+        size_t end = s.size();
+        bool u = false;
+        int longs = 0;
+        while (end > 0 && std::strchr("uUlL", s[end - 1])) {
+            end--;
+            if (s[end] == 'u' || s[end] == 'U') {
+                u = true;
+            } else {
+                longs++;
+            }
+        }
+        std::string digits = s.substr(0, end);
+        if (digits.find('.') != std::string::npos ||
+            (!hex && digits.find_first_of("eE") != std::string::npos) || digits.find_first_of("pP") != std::string::npos) {
+            return false;
+        }
+        char *stop = nullptr;
+        uint64_t x = std::strtoull(digits.c_str(), &stop, hex ? 16 : digits.size() > 1 && digits[0] == '0' ? 8 : 10);
+        if (!stop || *stop) {
+            return false;
+        }
+        v.v = int64_t(x);
+        v.bits = longs || x > UINT32_MAX || (!u && x > INT32_MAX && !hex) ? 64 : 32;
+        v.is_unsigned = u || (v.bits == 64 ? x > uint64_t(INT64_MAX) : x > INT32_MAX);
+        return true;
+    }
+
+  private:
+    ConstantExpression(const std::vector<CToken> &t, const Scope &scope) : t_(t), scope_(scope) {}
+
+    static int64_t char_value(const std::string &s, size_t &i) {
+        if (i >= s.size() || s[i] != '\\') {
+            return i < s.size() ? static_cast<signed char>(s[i++]) : 0;
+        }
+        i++;
+        char c = i < s.size() ? s[i++] : 0;
+        switch (c) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case 'a': return '\a';
+        case 'b': return '\b';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case 'x': {
+            int64_t v = 0;
+            while (i < s.size() && std::isxdigit(static_cast<unsigned char>(s[i]))) {
+                v = v * 16 + (std::isdigit(static_cast<unsigned char>(s[i])) ? s[i] - '0' : (s[i] | 0x20) - 'a' + 10);
+                i++;
+            }
+            return static_cast<signed char>(v);
+        }
+        default:
+            if (c >= '0' && c <= '7') {
+                int64_t v = c - '0';
+                for (int k = 0; k < 2 && i < s.size() && s[i] >= '0' && s[i] <= '7'; k++) {
+                    v = v * 8 + (s[i++] - '0');
+                }
+                return static_cast<signed char>(v);
+            }
+            return c;
+        }
+    }
+
+    [[noreturn]] void fail(const std::string &msg) const { throw CppError(msg); }
+
+    bool at(const char *s) const { return pos_ < t_.size() && t_[pos_].is(s); }
+
+    void expect(const char *s) {
+        if (!at(s)) {
+            fail(std::string("expected '") + s + "'");
+        }
+        pos_++;
+    }
+
+    Value fit(Value v) const {
+        if (scope_.preprocessor) {
+            v.bits = 64;
+        }
+        if (v.bits < 64) {
+            uint64_t m = (uint64_t(1) << v.bits) - 1;
+            uint64_t x = uint64_t(v.v) & m;
+            v.v = v.is_unsigned || !(x >> (v.bits - 1)) ? int64_t(x) : int64_t(x | ~m);
+        }
+        return v;
+    }
+
+    // Usual arithmetic conversions of two integer operands.
+    Value common_type(const Value &a, const Value &b) const {
+        Value r;
+        r.bits = std::max(a.bits, b.bits);
+        r.is_unsigned = (a.is_unsigned && a.bits == r.bits) || (b.is_unsigned && b.bits == r.bits);
+        return r;
+    }
+
+    static Value boolean(bool b) {
+        Value v;
+        v.v = b;
+        return v;
+    }
+
+    Value conditional(bool live) {
+        Value c = binary(0, live);
+        if (!at("?")) {
+            return c;
+        }
+        pos_++;
+        Value a = conditional(live && c.v);
+        expect(":");
+        Value b = conditional(live && !c.v);
+        Value r = common_type(a, b);
+        r.v = c.v ? a.v : b.v;
+        return fit(r);
+    }
+
+    static int precedence(const std::string &op) {
+        static const char *const levels[][4] = {{"||"}, {"&&"}, {"|"}, {"^"}, {"&"}, {"==", "!="},
+                                                {"<", ">", "<=", ">="}, {"<<", ">>"}, {"+", "-"}, {"*", "/", "%"}};
+        for (int l = 0; l < 10; l++) {
+            for (const char *o : levels[l]) {
+                if (o && op == o) {
+                    return l;
+                }
+            }
+        }
+        return -1;
+    }
+
+    Value binary(int level, bool live) {
+        if (level == 10) {
+            return unary(live);
+        }
+        Value a = binary(level + 1, live);
+        while (pos_ < t_.size() && t_[pos_].kind == CToken::PUNCT && precedence(t_[pos_].text) == level) {
+            std::string op = t_[pos_++].text;
+            if (op == "||" || op == "&&") {
+                bool rhs_live = live && (op == "||" ? !a.v : a.v);
+                Value b = binary(level + 1, rhs_live);
+                a = boolean(op == "||" ? (a.v || b.v) : (a.v && b.v));
+                continue;
+            }
+            Value b = binary(level + 1, live);
+            a = apply(op, a, b, live);
+        }
+        return a;
+    }
+
+    Value apply(const std::string &op, Value a, Value b, bool live) const {
+        if (op == "<<" || op == ">>") {
+            Value r = a;
+            if (a.bits < 32) {
+                r.bits = 32;
+            }
+            unsigned s = unsigned(b.v) & 63;
+            if (op == "<<") {
+                r.v = int64_t(uint64_t(a.v) << s);
+            } else {
+                r.v = a.is_unsigned ? int64_t(uint64_t(a.v) >> s) : a.v >> s;
+            }
+            return fit(r);
+        }
+        Value r = common_type(a, b);
+        uint64_t x = uint64_t(a.v), y = uint64_t(b.v);
+        bool u = r.is_unsigned;
+        if (op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" || op == ">=") {
+            if (u && r.bits < 64) {
+                uint64_t m = (uint64_t(1) << r.bits) - 1;
+                x &= m;
+                y &= m;
+            }
+            bool lt = u ? x < y : a.v < b.v;
+            bool eq = x == y;
+            bool v = op == "==" ? eq : op == "!=" ? !eq : op == "<" ? lt : op == ">" ? !lt && !eq : op == "<=" ? lt || eq : !lt;
+            return boolean(v);
+        }
+        if ((op == "/" || op == "%") && y == 0) {
+            if (live) {
+                fail("division by zero");
+            }
+            r.v = 0;
+            return r;
+        }
+        switch (op[0]) {
+        case '+': r.v = int64_t(x + y); break;
+        case '-': r.v = int64_t(x - y); break;
+        case '*': r.v = int64_t(x * y); break;
+        case '/': r.v = u ? int64_t(x / y) : (b.v == -1 ? int64_t(0 - x) : a.v / b.v); break;
+        case '%': r.v = u ? int64_t(x % y) : (b.v == -1 ? 0 : a.v % b.v); break;
+        case '&': r.v = int64_t(x & y); break;
+        case '|': r.v = int64_t(x | y); break;
+        case '^': r.v = int64_t(x ^ y); break;
+        default: fail("operator '" + op + "'");
+        }
+        return fit(r);
+    }
+
+    Value unary(bool live) {
+        if (pos_ >= t_.size()) {
+            fail("expression ends early");
+        }
+        const CToken &t = t_[pos_];
+        if (t.is("+") || t.is("-") || t.is("~") || t.is("!")) {
+            pos_++;
+            Value v = unary(live);
+            if (t.is("!")) {
+                return boolean(!v.v);
+            }
+            if (v.bits < 32) {
+                v.bits = 32;
+            }
+            v.v = t.is("-") ? int64_t(0 - uint64_t(v.v)) : t.is("~") ? ~v.v : v.v;
+            return fit(v);
+        }
+        if (t.is("sizeof")) {
+            pos_++;
+            size_t save = pos_;
+            uint64_t size = 0;
+            bool integer = false, is_signed = false;
+            if (at("(")) {
+                pos_++;
+                if (scope_.type_name(t_, pos_, size, integer, is_signed) && at(")")) {
+                    pos_++;
+                    Value v;
+                    v.v = int64_t(size);
+                    v.is_unsigned = true;
+                    v.bits = 64;
+                    return v;
+                }
+            }
+            pos_ = save;
+            fail("sizeof of an expression");
+        }
+        if (t.is("(")) {
+            size_t save = ++pos_;
+            uint64_t size = 0;
+            bool integer = false, is_signed = false;
+            if (scope_.type_name(t_, pos_, size, integer, is_signed) && at(")")) {
+                pos_++;
+                Value v = unary(live);
+                if (!integer || size == 0 || size > 8) {
+                    fail("cast to a type that is not an integer");
+                }
+                v.bits = unsigned(std::max<uint64_t>(size * 8, 32));
+                v.is_unsigned = !is_signed && size * 8 >= 32;
+                if (size < 8) {
+                    unsigned bits = unsigned(size * 8);
+                    uint64_t m = (uint64_t(1) << bits) - 1;
+                    uint64_t x = uint64_t(v.v) & m;
+                    v.v = !is_signed || !(x >> (bits - 1)) ? int64_t(x) : int64_t(x | ~m);
+                }
+                return fit(v);
+            }
+            pos_ = save;
+            Value v = conditional(live);
+            expect(")");
+            return v;
+        }
+        if (t.kind == CToken::NUMBER || t.kind == CToken::CHAR) {
+            Value v;
+            if (!literal(t, v)) {
+                fail("'" + t.text + "' is not an integer");
+            }
+            pos_++;
+            return fit(v);
+        }
+        if (t.kind == CToken::IDENT) {
+            pos_++;
+            Value v;
+            if (scope_.constant(t.text, v.v)) {
+                v.bits = v.v < INT32_MIN || v.v > INT32_MAX ? 64 : 32;
+                return fit(v);
+            }
+            if (scope_.preprocessor) {
+                return Value();
+            }
+            fail("'" + t.text + "' is not a constant");
+        }
+        fail("unexpected '" + t.text + "'");
+    }
+
+    const std::vector<CToken> &t_;
+    const Scope &scope_;
+    size_t pos_ = 0;
+};
+
+struct Macro {
+    std::string name;
+    bool function = false;
+    bool variadic = false;
+    std::vector<std::string> params;  // __VA_ARGS__ last when variadic
+    std::vector<CToken> body;
+    int line = 0;
+    uint64_t fingerprint = 0;  // of the definition, not of where it is
+};
+
+class Preprocessor {
+    struct Cond {
+        bool active;
+        bool taken;  // a branch was taken (or the whole group is skipped)
+        bool seen_else;
+        int line;
+
+        bool operator==(const Cond &o) const {
+            return active == o.active && taken == o.taken && seen_else == o.seen_else && line == o.line;
+        }
+    };
+
+  public:
+    using Macros = std::unordered_map<std::string, std::shared_ptr<const Macro>>;
+
+    // An object-like macro whose expansion is an integer ("#define LUA_OK 0"),
+    // which Ghidra keeps as a define_NAME enum.
+    struct Define {
+        std::string name;
+        int64_t value = 0;
+        int line = 0;
+    };
+
+    // What a run read and changed: the state of every macro it looked up,
+    // defined or undefined before the run, and after it. Replaying it on a
+    // preprocessor in the same state for those names (and with the same
+    // conditionals open) is the same as running the lines again.
+    class Trace {
+      public:
+        size_t reads() const { return before_.size(); }
+
+      private:
+        friend class Preprocessor;
+        std::vector<std::pair<std::string, uint64_t>> before_;
+        std::vector<std::pair<std::string, std::shared_ptr<const Macro>>> after_;  // null: undefined
+        std::vector<Cond> conds_before_, conds_after_;
+    };
+
+    explicit Preprocessor(std::string file = "") : file_(std::move(file)) {}
+
+    const std::string &file() const { return file_; }
+    const Macros &macros() const { return macros_; }
+
+    // -D NAME=VALUE
+    void define(const std::string &name, const std::string &value = "1") {
+        std::vector<CToken> t;
+        c_lex(name + " " + value, 0, t);
+        define(t, 0);
+    }
+
+    void undef(const std::string &name) { macros_.erase(name); }
+
+    // -D that the header cannot change: its #define and #undef of 'name'
+    // are ignored, as for the options luaconf.h sets unconditionally
+    // (LUA_32BITS, LUAI_MAXSTACK).
+    void force(const std::string &name, const std::string &value = "1") {
+        locked_.erase(name);
+        define(name, value);
+        locked_.insert(name);
+    }
+
+    // Runs the directives of 'lines'. With 'out', the text of the lines that
+    // are not skipped is expanded into it; with 'defines', integer
+    // object-like macros are collected as they are defined; with 'trace',
+    // what the run depended on and did is recorded for replay().
+    void run(const std::vector<CLine> &lines, std::vector<CToken> *out, std::vector<Define> *defines = nullptr,
+             Trace *trace = nullptr) {
+        std::unordered_map<std::string, uint64_t> seen;
+        std::unordered_set<std::string> changed;
+        if (trace) {
+            *trace = Trace();
+            trace->conds_before_ = conds_;
+            seen_ = &seen;
+            changed_ = &changed;
+        }
+        struct Untrace {
+            Preprocessor &p;
+            ~Untrace() {
+                p.seen_ = nullptr;
+                p.changed_ = nullptr;
+            }
+        } untrace{*this};
+        std::vector<CToken> text;
+        for (const CLine &l : lines) {
+            size_t p = l.text.find_first_not_of(" \t\f\v");
+            if (p != std::string::npos && l.text[p] == '#') {
+                if (out && !text.empty()) {
+                    expand_into(text, *out);
+                    text.clear();
+                }
+                directive(l, p + 1, defines);
+            } else if (out && active() && p != std::string::npos) {
+                c_lex(l.text, l.line, text);
+            }
+        }
+        if (out && !text.empty()) {
+            expand_into(text, *out);
+        }
+        if (trace) {
+            trace->before_.assign(seen.begin(), seen.end());
+            std::sort(trace->before_.begin(), trace->before_.end());
+            for (const std::string &name : changed) {
+                auto it = macros_.find(name);
+                trace->after_.emplace_back(name, it == macros_.end() ? nullptr : it->second);
+            }
+            trace->conds_after_ = conds_;
+        }
+    }
+
+    // Whether replaying 't' here would do what its run did.
+    bool matches(const Trace &t) const {
+        if (t.conds_before_ != conds_) {
+            return false;
+        }
+        for (const auto &r : t.before_) {
+            if (state(r.first) != r.second) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The effect of the run 't' was recorded from, if it matches().
+    bool replay(const Trace &t) {
+        if (!matches(t)) {
+            return false;
+        }
+        for (const auto &w : t.after_) {
+            if (w.second) {
+                macros_[w.first] = w.second;
+            } else {
+                macros_.erase(w.first);
+            }
+        }
+        conds_ = t.conds_after_;
+        return true;
+    }
+
+    // Throws if a conditional is still open.
+    void finish() const {
+        if (!conds_.empty()) {
+            throw CppError(where(conds_.back().line) + "unterminated conditional");
+        }
+    }
+
+    // Macro expansion of 'in'.
+    std::vector<CToken> expand(const std::vector<CToken> &in) const {
+        std::vector<CToken> out;
+        expand_into(in, out);
+        return out;
+    }
+
+  private:
+    using HideSet = std::shared_ptr<const std::vector<std::string>>;
+
+    bool locked(const std::string &name) const { return locked_.count(name) != 0; }
+
+    // What a trace compares: the definition of 'name' (0: none) and whether
+    // it is forced.
+    uint64_t state(const std::string &name) const {
+        auto it = macros_.find(name);
+        uint64_t s = it == macros_.end() ? 0 : it->second->fingerprint;
+        return locked(name) ? ~s : s;
+    }
+
+    // Records the state of 'name' before the traced run first used it.
+    void touch(const std::string &name) const {
+        if (seen_ && !seen_->count(name)) {
+            seen_->emplace(name, state(name));
+        }
+    }
+
+    std::string where(int line) const { return (file_.empty() ? "" : file_ + ":") + std::to_string(line) + ": "; }
+
+    bool active() const { return conds_.empty() || conds_.back().active; }
+
+    static bool hidden(const CToken &t, const std::string &name) {
+        return t.hide && std::binary_search(t.hide->begin(), t.hide->end(), name);
+    }
+
+    static HideSet with(const HideSet &h, const std::string &name) {
+        auto v = std::make_shared<std::vector<std::string>>(h ? *h : std::vector<std::string>());
+        v->insert(std::lower_bound(v->begin(), v->end(), name), name);
+        return v;
+    }
+
+    static HideSet merged(const HideSet &a, const HideSet &b) {
+        if (!a || a->empty()) {
+            return b;
+        }
+        if (!b || b->empty()) {
+            return a;
+        }
+        auto v = std::make_shared<std::vector<std::string>>();
+        std::set_union(a->begin(), a->end(), b->begin(), b->end(), std::back_inserter(*v));
+        return v;
+    }
+
+    static HideSet common(const HideSet &a, const HideSet &b) {
+        auto v = std::make_shared<std::vector<std::string>>();
+        if (a && b) {
+            std::set_intersection(a->begin(), a->end(), b->begin(), b->end(), std::back_inserter(*v));
+        }
+        return v;
+    }
+
+    void directive(const CLine &l, size_t pos, std::vector<Define> *defines) {
+        std::vector<CToken> t;
+        c_lex(l.text, l.line, t, pos);
+        if (t.empty()) {
+            return;
+        }
+        const std::string &d = t[0].text;
+        std::vector<CToken> rest(t.begin() + 1, t.end());
+        if (d == "if" || d == "ifdef" || d == "ifndef") {
+            if (!active()) {
+                conds_.push_back({false, true, false, l.line});
+                return;
+            }
+            bool v;
+            if (d == "if") {
+                v = condition(rest, l.line);
+            } else {
+                if (rest.empty() || rest[0].kind != CToken::IDENT) {
+                    throw CppError(where(l.line) + "#" + d + " without a macro name");
+                }
+                touch(rest[0].text);
+                v = macros_.count(rest[0].text) == (d == "ifdef" ? 1u : 0u);
+            }
+            conds_.push_back({v, v, false, l.line});
+            return;
+        }
+        if (d == "elif" || d == "else" || d == "endif") {
+            if (conds_.empty() || (d != "endif" && conds_.back().seen_else)) {
+                throw CppError(where(l.line) + "#" + d + " out of place");
+            }
+            Cond &c = conds_.back();
+            if (d == "endif") {
+                conds_.pop_back();
+            } else if (d == "else") {
+                c.active = !c.taken;
+                c.taken = true;
+                c.seen_else = true;
+            } else {
+                c.active = !c.taken && condition(rest, l.line);
+                c.taken = c.taken || c.active;
+            }
+            return;
+        }
+        if (!active()) {
+            return;
+        }
+        if (d == "define") {
+            bool keep = !rest.empty() && locked(rest[0].text);
+            if (keep) {
+                touch(rest[0].text);
+            }
+            const Macro &m = keep ? *macros_.at(rest[0].text) : define(rest, l.line);
+            if (defines && !m.function && !m.body.empty()) {
+                ConstantExpression::Scope scope;
+                scope.preprocessor = false;
+                try {
+                    ConstantExpression::Value v = ConstantExpression::evaluate(expand(m.body), scope);
+                    defines->push_back({m.name, v.v, l.line});
+                } catch (const CppError &) {
+                    // not an integer constant: a string, a type, an expression on variables
+                }
+            }
+        } else if (d == "undef") {
+            if (!rest.empty() && !locked(rest[0].text)) {
+                touch(rest[0].text);
+                if (changed_) {
+                    changed_->insert(rest[0].text);
+                }
+                macros_.erase(rest[0].text);
+            }
+        } else if (d == "error") {
+            throw CppError(where(l.line) + "#error" + l.text.substr(l.text.find("error") + 5));
+        }
+        // #include, #pragma, #line, #warning: nothing to do here
+    }
+
+    bool condition(std::vector<CToken> t, int line) const {
+        std::vector<CToken> r;
+        for (size_t i = 0; i < t.size(); i++) {
+            if (!t[i].is("defined")) {
+                r.push_back(t[i]);
+                continue;
+            }
+            bool paren = i + 1 < t.size() && t[i + 1].is("(");
+            size_t n = i + (paren ? 2 : 1);
+            if (n >= t.size() || t[n].kind != CToken::IDENT || (paren && (n + 1 >= t.size() || !t[n + 1].is(")")))) {
+                throw CppError(where(line) + "malformed defined()");
+            }
+            CToken v = t[i];
+            v.kind = CToken::NUMBER;
+            touch(t[n].text);
+            v.text = macros_.count(t[n].text) ? "1" : "0";
+            r.push_back(v);
+            i = n + (paren ? 1 : 0);
+        }
+        ConstantExpression::Scope scope;
+        scope.preprocessor = true;
+        try {
+            return ConstantExpression::evaluate(expand(r), scope).v != 0;
+        } catch (const CppError &e) {
+            throw CppError(where(line) + "#if: " + e.what());
+        }
+    }
+
+    const Macro &define(const std::vector<CToken> &t, int line) {
+        if (t.empty() || t[0].kind != CToken::IDENT) {
+            throw CppError(where(line) + "#define without a macro name");
+        }
+        auto m = std::make_shared<Macro>();
+        m->name = t[0].text;
+        m->line = line;
+        size_t i = 1;
+        if (i < t.size() && t[i].is("(") && !t[i].space) {
+            m->function = true;
+            for (i++; i < t.size() && !t[i].is(")"); i++) {
+                if (t[i].is(",")) {
+                    continue;
+                }
+                if (t[i].is("...")) {
+                    m->variadic = true;
+                    m->params.push_back("__VA_ARGS__");
+                } else if (t[i].kind == CToken::IDENT) {
+                    m->params.push_back(t[i].text);
+                } else {
+                    throw CppError(where(line) + "bad parameter list of " + m->name);
+                }
+            }
+            if (i == t.size()) {
+                throw CppError(where(line) + "unterminated parameter list of " + m->name);
+            }
+            i++;
+        }
+        m->body.assign(t.begin() + long(i), t.end());
+        if (!m->body.empty()) {
+            m->body[0].space = false;
+        }
+        uint64_t h = hash_string(m->name, uint64_t(m->function) | uint64_t(m->variadic) << 1);
+        for (const std::string &p : m->params) {
+            h = combine(h, hash_string(p));
+        }
+        for (const CToken &b : m->body) {
+            h = combine(h, hash_string(b.text, uint64_t(b.kind) << 1 | uint64_t(b.space)));
+        }
+        m->fingerprint = h | 1;
+        touch(m->name);
+        if (changed_) {
+            changed_->insert(m->name);
+        }
+        auto &slot = macros_[m->name];
+        slot = m;
+        return *slot;
+    }
+
+    int param(const Macro &m, const CToken &t) const {
+        if (!m.function || t.kind != CToken::IDENT) {
+            return -1;
+        }
+        for (size_t k = 0; k < m.params.size(); k++) {
+            if (m.params[k] == t.text) {
+                return int(k);
+            }
+        }
+        return -1;
+    }
+
+    static CToken stringize(const std::vector<CToken> &arg, const CToken &at) {
+        CToken s = at;
+        s.kind = CToken::STRING;
+        s.text = "\"";
+        for (size_t i = 0; i < arg.size(); i++) {
+            if (i && arg[i].space) {
+                s.text += ' ';
+            }
+            bool literal = arg[i].kind == CToken::STRING || arg[i].kind == CToken::CHAR;
+            for (char c : arg[i].text) {
+                if (literal && (c == '"' || c == '\\')) {
+                    s.text += '\\';
+                }
+                s.text += c;
+            }
+        }
+        s.text += '"';
+        return s;
+    }
+
+    // a ## b: the spelling of both, lexed again.
+    static std::vector<CToken> paste(const CToken &a, const CToken &b) {
+        std::vector<CToken> r;
+        c_lex(a.text + b.text, a.line, r);
+        if (!r.empty()) {
+            r[0].space = a.space;
+        }
+        return r;
+    }
+
+    // The body of 'm' with its parameters replaced, # and ## applied.
+    std::vector<CToken> substitute(const Macro &m, const std::vector<std::vector<CToken>> &args) const {
+        std::vector<std::vector<CToken>> expanded(args.size());
+        std::vector<bool> done(args.size());
+        std::vector<CToken> r;
+        CToken marker;  // placemarker for an empty operand of ##
+        marker.kind = CToken::PUNCT;
+        bool pasting = false;
+        const std::vector<CToken> &b = m.body;
+        for (size_t i = 0; i < b.size(); i++) {
+            if (b[i].is("##") && i > 0 && i + 1 < b.size()) {
+                pasting = true;
+                continue;
+            }
+            std::vector<CToken> ins;
+            int k;
+            if (b[i].is("#") && m.function && i + 1 < b.size() && (k = param(m, b[i + 1])) >= 0) {
+                ins.push_back(stringize(args[size_t(k)], b[i]));
+                i++;
+            } else if ((k = param(m, b[i])) >= 0) {
+                bool raw = pasting || (i + 1 < b.size() && b[i + 1].is("##"));
+                if (raw) {
+                    ins = args[size_t(k)];
+                    if (ins.empty()) {
+                        ins.push_back(marker);
+                    }
+                } else {
+                    if (!done[size_t(k)]) {
+                        expanded[size_t(k)] = expand(args[size_t(k)]);
+                        done[size_t(k)] = true;
+                    }
+                    ins = expanded[size_t(k)];
+                }
+                if (!ins.empty()) {
+                    ins[0].space = b[i].space;
+                }
+            } else {
+                ins.push_back(b[i]);
+            }
+            if (pasting) {
+                pasting = false;
+                // GNU ", ## __VA_ARGS__" drops the comma when there are no variable arguments
+                if (m.variadic && b[i].text == "__VA_ARGS__" && !r.empty() && r.back().is(",") &&
+                    ins.size() == 1 && ins[0].text.empty()) {
+                    r.pop_back();
+                    continue;
+                }
+                if (!r.empty() && !ins.empty()) {
+                    CToken left = r.back();
+                    r.pop_back();
+                    if (left.text.empty()) {
+                        r.insert(r.end(), ins.begin(), ins.end());
+                    } else if (ins[0].text.empty()) {
+                        r.push_back(left);
+                        r.insert(r.end(), ins.begin() + 1, ins.end());
+                    } else {
+                        std::vector<CToken> p = paste(left, ins[0]);
+                        r.insert(r.end(), p.begin(), p.end());
+                        r.insert(r.end(), ins.begin() + 1, ins.end());
+                    }
+                    continue;
+                }
+            }
+            r.insert(r.end(), ins.begin(), ins.end());
+        }
+        r.erase(std::remove_if(r.begin(), r.end(), [](const CToken &t) { return t.text.empty(); }), r.end());
+        return r;
+    }
+
+    void expand_into(const std::vector<CToken> &in, std::vector<CToken> &out) const {
+        std::vector<CToken> stack(in.rbegin(), in.rend());  // next token at the back
+        while (!stack.empty()) {
+            CToken t = std::move(stack.back());
+            stack.pop_back();
+            if (t.kind == CToken::IDENT) {
+                touch(t.text);
+            }
+            auto it = t.kind == CToken::IDENT ? macros_.find(t.text) : macros_.end();
+            if (it == macros_.end() || hidden(t, t.text)) {
+                out.push_back(std::move(t));
+                continue;
+            }
+            const Macro &m = *it->second;
+            std::vector<std::vector<CToken>> args;
+            HideSet hs;
+            if (!m.function) {
+                hs = with(t.hide, m.name);
+            } else {
+                if (stack.empty() || !stack.back().is("(")) {
+                    out.push_back(std::move(t));
+                    continue;
+                }
+                stack.pop_back();
+                args.emplace_back();
+                int depth = 0;
+                bool closed = false;
+                CToken close;
+                while (!stack.empty()) {
+                    CToken a = std::move(stack.back());
+                    stack.pop_back();
+                    if (depth == 0 && a.is(")")) {
+                        close = std::move(a);
+                        closed = true;
+                        break;
+                    }
+                    if (depth == 0 && a.is(",") && !(m.variadic && args.size() == m.params.size())) {
+                        args.emplace_back();
+                        continue;
+                    }
+                    depth += a.is("(") ? 1 : a.is(")") ? -1 : 0;
+                    args.back().push_back(std::move(a));
+                }
+                if (!closed) {
+                    throw CppError(where(t.line) + "unterminated call of macro " + m.name);
+                }
+                if (m.params.empty() && args.size() == 1 && args[0].empty()) {
+                    args.clear();
+                }
+                if (m.variadic && args.size() + 1 == m.params.size()) {
+                    args.emplace_back();
+                }
+                if (args.size() != m.params.size()) {
+                    throw CppError(where(t.line) + "macro " + m.name + " takes " + std::to_string(m.params.size()) +
+                                   " arguments, given " + std::to_string(args.size()));
+                }
+                hs = with(common(t.hide, close.hide), m.name);
+            }
+            std::vector<CToken> body = substitute(m, args);
+            for (size_t i = 0; i < body.size(); i++) {
+                body[i].hide = merged(body[i].hide, hs);
+                body[i].line = t.line;
+            }
+            if (!body.empty()) {
+                body[0].space = t.space;
+            }
+            stack.insert(stack.end(), body.rbegin(), body.rend());
+        }
+    }
+
+    std::string file_;
+    Macros macros_;
+    std::unordered_set<std::string> locked_;
+    std::vector<Cond> conds_;
+    std::unordered_map<std::string, uint64_t> *seen_ = nullptr;  // while a traced run is on
+    std::unordered_set<std::string> *changed_ = nullptr;
+};
+
+}  // namespace common
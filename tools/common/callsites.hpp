@@ -0,0 +1,881 @@
+/*
+ *   Direct calls to named functions, with the constant arguments set up
+ *   right before them.
+ *
+ *   CallTargets collects every address through which code reaches a
+ *   function: its definition when the object has one, the PLT stubs that
+ *   jump through its GOT slot, and the GOT slot itself for -fno-plt calls
+ *   ("call [rip + slot]"). The stubs are recognized by the indirect jump
+ *   each PLT entry ends in:
+ *
+ *     x86-64   jmp [rip + slot]                   (also after endbr64 / bnd)
+ *     i386     jmp [slot] / jmp [ebx + slot-got]
+ *     AArch64  adrp x16, page; ldr x17, [x16, #off]
+ *     ARM      add ip, pc, #a; add ip, ip, #b; ldr pc, [ip, #c]!
+ *     MIPS     lui t7, %hi(slot); lw t9, %lo(slot)(t7)   (.plt)
+ *              lw t9, -0x7ff0(gp) ... li t8, symbol index   (.MIPS.stubs)
+ *
+ *   MIPS PIC code calls through the global part of the GOT instead
+ *   ("lw t9, off(gp); jalr t9"); those slots are matched to dynamic symbols
+ *   with DT_MIPS_LOCAL_GOTNO / DT_MIPS_GOTSYM, and the delay slot after a
+ *   call, which often completes an argument, is taken into account.
+ *
+ *   scan_direct_calls() sweeps the executable sections for call (and tail
+ *   jump) instructions to those addresses and reports, per call, the
+ *   first four arguments that are constants at the call: immediates,
+ *   PC-relative addresses (lea rip / adrp+add / adr / ldr+add pc / lui+addiu),
+ *   ARM literal pool words and MIPS GOT entries. As in jni_callsite.hpp this is not a disassembler:
+ *   a value set more than ARG_WINDOW bytes before the call, or clobbered by an
+ *   instruction the trackers do not model, may be missed or stale, so
+ *   callers should check decoded values for plausibility.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/elf.hpp"
+
+
+namespace common {
+
+struct DirectCall {
+    uint64_t addr;     // of the call instruction
+    int function;      // index into the names given to CallTargets
+    bool tail;         // jmp/b rather than a call
+    uint64_t args[4];  // first four arguments
+    unsigned known;    // bit k set when args[k] is a constant
+};
+
+namespace detail {
+
+inline uint32_t rd32(const uint8_t *p, bool le) {
+    return le ? (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24)
+              : (uint32_t(p[3]) | uint32_t(p[2]) << 8 | uint32_t(p[1]) << 16 | uint32_t(p[0]) << 24);
+}
+
+inline uint16_t rd16(const uint8_t *p, bool le) {
+    return le ? uint16_t(p[0] | p[1] << 8) : uint16_t(p[1] | p[0] << 8);
+}
+
+// A32 rotated immediate of a data-processing instruction.
+inline uint32_t arm_imm(uint32_t w) {
+    uint32_t v = w & 0xff, r = ((w >> 8) & 0xf) * 2;
+    return r ? (v >> r) | (v << (32 - r)) : v;
+}
+
+// Page address computed by an AArch64 adrp at 'pc'.
+inline uint64_t adrp_page(uint64_t pc, uint32_t w) {
+    int64_t imm = int64_t(uint64_t(((w >> 5) & 0x7ffff) << 2 | ((w >> 29) & 3)) << 43) >> 31;
+    return (pc & ~uint64_t(0xfff)) + uint64_t(imm);
+}
+
+}  // namespace detail
+
+class CallTargets {
+  public:
+    CallTargets(const ElfFile &elf, const std::vector<std::string> &names) : names_(names) {
+        std::unordered_map<std::string, int> index;
+        for (size_t i = 0; i < names.size(); i++) {
+            index.emplace(names[i], int(i));
+        }
+        for (const ElfSymbol &s : elf.symbols()) {
+            auto it = index.find(s.name);
+            if (it != index.end() && s.defined() && s.function()) {
+                code_.emplace(elf.machine() == EM_ARM ? s.value & ~uint64_t(1) : s.value, it->second);
+            }
+        }
+        uint16_t m = elf.machine();
+        for (const ElfRelocation &r : elf.dynamic_relocations()) {
+            auto it = index.find(r.sym_name);
+            if (it != index.end() && (r.type == jump_slot_type(m) || r.type == glob_dat_type(m))) {
+                slots_.emplace(r.offset, it->second);
+            }
+        }
+        if (m == EM_MIPS) {
+            mips_got(elf, index);
+        }
+        find_stubs(elf, index);
+    }
+
+    const std::vector<std::string> &names() const { return names_; }
+    bool empty() const { return code_.empty() && slots_.empty(); }
+
+    // MIPS: the value of gp in PIC code (_gp, 0x7ff0 past the GOT), 0 if unknown.
+    uint64_t mips_gp() const { return gp_; }
+
+    // Function reached by a direct call to 'a' / an indirect call through 'slot', or -1.
+    int at(uint64_t a) const {
+        auto it = code_.find(a);
+        return it == code_.end() ? -1 : it->second;
+    }
+    int through(uint64_t slot) const {
+        auto it = slots_.find(slot);
+        return it == slots_.end() ? -1 : it->second;
+    }
+
+    static uint32_t jump_slot_type(uint16_t machine) {
+        switch (machine) {
+        case EM_386: return 7;         // R_386_JMP_SLOT
+        case EM_ARM: return 22;        // R_ARM_JUMP_SLOT
+        case EM_X86_64: return 7;      // R_X86_64_JUMP_SLOT
+        case EM_AARCH64: return 1026;  // R_AARCH64_JUMP_SLOT
+        case EM_MIPS: return 127;      // R_MIPS_JUMP_SLOT
+        default: return 0;
+        }
+    }
+
+    static uint32_t glob_dat_type(uint16_t machine) {
+        switch (machine) {
+        case EM_386: return 6;         // R_386_GLOB_DAT
+        case EM_ARM: return 21;        // R_ARM_GLOB_DAT
+        case EM_X86_64: return 6;      // R_X86_64_GLOB_DAT
+        case EM_AARCH64: return 1025;  // R_AARCH64_GLOB_DAT
+        case EM_MIPS: return 51;       // R_MIPS_GLOB_DAT
+        default: return 0;
+        }
+    }
+
+  private:
+    // Global GOT entry k (after the local ones) belongs to dynamic symbol
+    // DT_MIPS_GOTSYM + k.
+    void mips_got(const ElfFile &elf, const std::unordered_map<std::string, int> &index) {
+        uint64_t got = 0, local = 0, gotsym = 0, symtabno = 0;
+        for (const auto &d : elf.dynamic_entries()) {
+            switch (d.first) {
+            case 3: got = d.second; break;                  // DT_PLTGOT
+            case 0x7000000a: local = d.second; break;       // DT_MIPS_LOCAL_GOTNO
+            case 0x70000011: symtabno = d.second; break;    // DT_MIPS_SYMTABNO
+            case 0x70000013: gotsym = d.second; break;      // DT_MIPS_GOTSYM
+            default: break;
+            }
+        }
+        const ElfSymbol *gp = elf.find_symbol("_gp");
+        gp_ = gp ? gp->value : got ? got + 0x7ff0 : 0;
+        const ElfSection *dynsym = nullptr;
+        for (const ElfSection &s : elf.sections()) {
+            dynsym = !dynsym && s.type == 11 ? &s : dynsym;
+        }
+        if (!got || !dynsym) {
+            return;
+        }
+        for (uint64_t k = gotsym; k < symtabno; k++) {
+            auto it = index.find(elf.symbol_name(*dynsym, k));
+            if (it != index.end()) {
+                slots_.emplace(got + (local + k - gotsym) * 4, it->second);
+            }
+        }
+    }
+
+    void find_stubs(const ElfFile &elf, const std::unordered_map<std::string, int> &index) {
+        if (elf.machine() == EM_MIPS) {
+            mips_stubs(elf, index);
+        }
+        if (slots_.empty()) {
+            return;
+        }
+        bool le = elf.little_endian();
+        uint64_t got = 0;
+        if (const ElfSection *g = elf.section(".got.plt")) {
+            got = g->addr;
+        } else if (const ElfSection *g = elf.section(".got")) {
+            got = g->addr;
+        }
+        for (const ElfSection &s : elf.sections()) {
+            const uint8_t *p = s.exec() && s.name.compare(0, 4, ".plt") == 0 ? elf.section_data(s) : nullptr;
+            if (!p) {
+                continue;
+            }
+            size_t n = size_t(s.size);
+            for (size_t i = 0; i + 6 <= n; i++) {
+                uint64_t slot = 0;
+                size_t start = i;
+                switch (elf.machine()) {
+                case EM_X86_64:
+                    if (p[i] == 0xff && p[i + 1] == 0x25) {
+                        slot = s.addr + i + 6 + uint64_t(int64_t(int32_t(detail::rd32(p + i + 2, true))));
+                        start = x86_stub_start(p, i);
+                    }
+                    break;
+                case EM_386:
+                    if (p[i] == 0xff && (p[i + 1] == 0x25 || p[i + 1] == 0xa3)) {
+                        slot = uint32_t((p[i + 1] == 0xa3 ? got : 0) + detail::rd32(p + i + 2, true));
+                        start = x86_stub_start(p, i);
+                    }
+                    break;
+                case EM_AARCH64:
+                    if (i % 4 == 0 && i + 8 <= n) {
+                        uint32_t w = detail::rd32(p + i, le), w2 = detail::rd32(p + i + 4, le);
+                        if ((w & 0x9f00001f) == 0x90000010 && (w2 & 0xffc003ff) == 0xf9400211) {
+                            slot = detail::adrp_page(s.addr + i, w) + ((w2 >> 10) & 0xfff) * 8;
+                            start = i >= 4 && detail::rd32(p + i - 4, le) == 0xd503245f ? i - 4 : i;  // bti c
+                        }
+                    }
+                    break;
+                case EM_ARM:
+                    if (i % 4 == 0 && i + 12 <= n) {
+                        uint32_t w = detail::rd32(p + i, le), w2 = detail::rd32(p + i + 4, le), w3 = detail::rd32(p + i + 8, le);
+                        if ((w & 0xfffff000) == 0xe28fc000 && (w2 & 0xfffff000) == 0xe28cc000 &&
+                            (w3 & 0xfffff000) == 0xe5bcf000) {
+                            slot = uint32_t(s.addr + i + 8 + detail::arm_imm(w) + detail::arm_imm(w2) + (w3 & 0xfff));
+                            // Thumb callers enter through "bx pc; nop" in front of the entry
+                            if (i >= 4 && detail::rd16(p + i - 4, le) == 0x4778) {
+                                add_stub(slot, s.addr + i - 4);
+                            }
+                        }
+                    }
+                    break;
+                case EM_MIPS:
+                    if (i % 4 == 0 && i + 8 <= n) {
+                        uint32_t w = detail::rd32(p + i, le), w2 = detail::rd32(p + i + 4, le);
+                        if ((w & 0xffff0000) == 0x3c0f0000 && (w2 & 0xffff0000) == 0x8df90000) {
+                            slot = uint32_t((w & 0xffff) << 16) + uint32_t(int32_t(int16_t(w2 & 0xffff)));
+                        }
+                    }
+                    break;
+                default:
+                    return;
+                }
+                if (slot) {
+                    add_stub(slot, s.addr + start);
+                }
+            }
+        }
+    }
+
+    // Lazy-binding stubs of non-PIC MIPS executables, one per imported
+    // function: "lw t9, -0x7ff0(gp); move t7, ra; jalr t9; li t8, index",
+    // the index possibly split into lui/ori for large symbol tables.
+    void mips_stubs(const ElfFile &elf, const std::unordered_map<std::string, int> &index) {
+        const ElfSection *stubs = elf.section(".MIPS.stubs");
+        const uint8_t *p = stubs ? elf.section_data(*stubs) : nullptr;
+        const ElfSection *dynsym = nullptr;
+        for (const ElfSection &s : elf.sections()) {
+            dynsym = !dynsym && s.type == 11 ? &s : dynsym;
+        }
+        if (!p || !dynsym) {
+            return;
+        }
+        bool le = elf.little_endian();
+        for (size_t i = 0; i + 16 <= stubs->size; i += 4) {
+            if (detail::rd32(p + i, le) != 0x8f998010) {
+                continue;
+            }
+            uint32_t sym = 0;
+            for (size_t k = i + 4; k < i + 20 && k + 4 <= stubs->size; k += 4) {
+                uint32_t w = detail::rd32(p + k, le);
+                if ((w & 0xffff0000) == 0x3c180000) {  // lui t8
+                    sym = (w & 0xffff) << 16;
+                } else if ((w & 0xffff0000) == 0x24180000 || (w & 0xffff0000) == 0x37180000 ||
+                           (w & 0xffff0000) == 0x34180000) {  // addiu t8, zero / ori t8, t8 / ori t8, zero
+                    sym |= w & 0xffff;
+                    break;
+                }
+            }
+            auto it = sym ? index.find(elf.symbol_name(*dynsym, sym)) : index.end();
+            if (it != index.end()) {
+                code_.emplace(stubs->addr + i, it->second);
+            }
+        }
+    }
+
+    void add_stub(uint64_t slot, uint64_t stub) {
+        auto it = slots_.find(slot);
+        if (it != slots_.end()) {
+            code_.emplace(stub, it->second);
+        }
+    }
+
+    // Back over "bnd" and endbr64/endbr32 in front of the jump.
+    static size_t x86_stub_start(const uint8_t *p, size_t i) {
+        if (i >= 1 && p[i - 1] == 0xf2) {
+            i--;
+        }
+        if (i >= 4 && p[i - 4] == 0xf3 && p[i - 3] == 0x0f && p[i - 2] == 0x1e && (p[i - 1] & 0xfe) == 0xfa) {
+            i -= 4;
+        }
+        return i;
+    }
+
+  private:
+    std::vector<std::string> names_;
+    std::unordered_map<uint64_t, int> code_;   // entry address -> function
+    std::unordered_map<uint64_t, int> slots_;  // GOT slot -> function
+    uint64_t gp_ = 0;
+};
+
+namespace detail {
+
+// Byte distance over which an argument keeps the constant it was given.
+constexpr uint64_t ARG_WINDOW = 64;
+constexpr uint64_t ARG_NONE = ~uint64_t(0);
+
+// Constants held by the registers (or, on i386, outgoing stack slots) that
+// carry the first four arguments.
+struct ArgTracker {
+    uint64_t val[32];
+    uint64_t at[32];  // offset at which the value became available
+    // i386: the last "push reg" instructions and the value pushed
+    uint64_t push_at[8], push_val[8];
+    unsigned pushes = 0;
+
+    ArgTracker() {
+        clear();
+        std::memset(push_at, 0xff, sizeof push_at);
+    }
+
+    void clear() { std::memset(at, 0xff, sizeof at); }
+    void set(unsigned r, uint64_t v, uint64_t now) {
+        val[r] = v;
+        at[r] = now;
+    }
+    void kill(unsigned r) { at[r] = ARG_NONE; }
+    bool live(unsigned r, uint64_t now) const { return at[r] != ARG_NONE && at[r] <= now && now - at[r] <= ARG_WINDOW; }
+
+    // args[k] from register regs[k]
+    void fill(DirectCall &c, const unsigned (&regs)[4], uint64_t now, uint64_t mask) const {
+        c.known = 0;
+        for (unsigned k = 0; k < 4; k++) {
+            if (live(regs[k], now)) {
+                c.args[k] = val[regs[k]] & mask;
+                c.known |= 1u << k;
+            }
+        }
+    }
+};
+
+class Sweep {
+  public:
+    Sweep(const ElfFile &elf, const CallTargets &t) : elf_(elf), t_(t), le_(elf.little_endian()) {}
+
+    template <typename Fn>
+    void aarch64(const uint8_t *p, size_t n, uint64_t base, Fn &fn) const {
+        static const unsigned regs[4] = {0, 1, 2, 3};
+        ArgTracker a;
+        for (size_t i = 0; i + 4 <= n; i += 4) {
+            uint32_t w = detail::rd32(p + i, le_);
+            uint64_t pc = base + i;
+            unsigned rd = w & 31, hw = (w >> 21) & 3;
+            uint64_t imm16 = (w >> 5) & 0xffff;
+            if ((w & 0x7f800000) == 0x52800000) {  // movz
+                a.set(rd, imm16 << (16 * hw), i);
+            } else if ((w & 0x7f800000) == 0x12800000) {  // movn
+                uint64_t v = ~(imm16 << (16 * hw));
+                a.set(rd, w & 0x80000000 ? v : v & 0xffffffff, i);
+            } else if ((w & 0x7f800000) == 0x72800000) {  // movk
+                if (a.live(rd, i)) {
+                    uint64_t mask = uint64_t(0xffff) << (16 * hw);
+                    a.set(rd, (a.val[rd] & ~mask) | (imm16 << (16 * hw)), i);
+                }
+            } else if ((w & 0x7fffffe0) == 0x2a1f03e0) {  // mov wd, wzr
+                a.set(rd, 0, i);
+            } else if ((w & 0x9f000000) == 0x90000000) {  // adrp
+                a.set(rd, detail::adrp_page(pc, w), i);
+            } else if ((w & 0x9f000000) == 0x10000000) {  // adr
+                int64_t imm = int64_t(uint64_t(((w >> 5) & 0x7ffff) << 2 | ((w >> 29) & 3)) << 43) >> 43;
+                a.set(rd, pc + uint64_t(imm), i);
+            } else if ((w & 0x7f800000) == 0x11000000) {  // add rd, rn, #imm12{, lsl 12}
+                unsigned rn = (w >> 5) & 31;
+                uint64_t imm = uint64_t((w >> 10) & 0xfff) << (w & 0x00400000 ? 12 : 0);
+                if (rn != 31 && a.live(rn, i)) {
+                    a.set(rd, a.val[rn] + imm, i);
+                } else {
+                    a.kill(rd);
+                }
+            } else if ((w & 0x7c000000) == 0x14000000) {  // b / bl
+                uint64_t target = pc + uint64_t(int64_t(int32_t(w << 6) >> 4));
+                report(fn, t_.at(target), pc, !(w & 0x80000000), a, regs, i, ~uint64_t(0));
+                if (w & 0x80000000) {
+                    a.clear();
+                }
+            } else if ((w & 0xfffffc1f) == 0xd63f0000) {  // blr
+                a.clear();
+            } else if ((w & 0x0a000000) == 0x08000000) {  // loads and stores
+                if (w & 0x00400000) {
+                    a.kill(rd);
+                }
+            } else if ((w & 0x1c000000) != 0x14000000 && (w & 0x0e000000) != 0x0e000000) {  // not branch or SIMD
+                a.kill(rd);
+            }
+        }
+    }
+
+    template <typename Fn>
+    void a32(const uint8_t *p, size_t n, uint64_t base, Fn &fn) const {
+        static const unsigned regs[4] = {0, 1, 2, 3};
+        ArgTracker a;
+        for (size_t i = 0; i + 4 <= n; i += 4) {
+            uint32_t w = detail::rd32(p + i, le_);
+            uint64_t pc = base + i;
+            unsigned rd = (w >> 12) & 15;
+            if ((w >> 28) == 0xf) {
+                if ((w & 0xfe000000) == 0xfa000000) {  // blx imm (to Thumb)
+                    uint64_t target = uint32_t(pc + 8 + uint32_t(int32_t(w << 8) >> 6) + ((w >> 23) & 2));
+                    report(fn, t_.at(target), pc, false, a, regs, i, 0xffffffff);
+                    a.clear();
+                }
+                continue;
+            }
+            if ((w & 0x0fef0000) == 0x03a00000) {  // mov rd, #imm
+                a.set(rd, detail::arm_imm(w), i);
+            } else if ((w & 0x0fef0000) == 0x03e00000) {  // mvn rd, #imm
+                a.set(rd, uint32_t(~detail::arm_imm(w)), i);
+            } else if ((w & 0x0ff00000) == 0x03000000) {  // movw
+                a.set(rd, ((w >> 4) & 0xf000) | (w & 0xfff), i);
+            } else if ((w & 0x0ff00000) == 0x03400000) {  // movt
+                if (a.live(rd, i)) {
+                    a.set(rd, (a.val[rd] & 0xffff) | (((w >> 4) & 0xf000) | (w & 0xfff)) << 16, i);
+                }
+            } else if ((w & 0x0f7f0000) == 0x051f0000) {  // ldr rd, [pc, #+-imm12]
+                uint64_t lit = uint32_t(pc + 8 + (w & 0x00800000 ? (w & 0xfff) : 0 - (w & 0xfff)));
+                literal(a, rd, lit, i);
+            } else if ((w & 0x0fff0000) == 0x028f0000) {  // adr: add rd, pc, #imm
+                a.set(rd, uint32_t(pc + 8 + detail::arm_imm(w)), i);
+            } else if ((w & 0x0fff0ff0) == 0x008f0000 && (w & 15) == rd) {  // add rd, pc, rd
+                if (a.live(rd, i)) {
+                    a.set(rd, uint32_t(a.val[rd] + pc + 8), i);
+                }
+            } else if ((w & 0x0e000000) == 0x0a000000) {  // b / bl
+                uint64_t target = uint32_t(pc + 8 + uint32_t(int32_t(w << 8) >> 6));
+                bool link = w & 0x01000000;
+                report(fn, t_.at(target), pc, !link, a, regs, i, 0xffffffff);
+                if (link) {
+                    a.clear();
+                }
+            } else if ((w & 0x0ffffff0) == 0x012fff30) {  // blx rm
+                a.clear();
+            } else if ((w & 0x0c000000) == 0x00000000) {  // data processing, except tst/teq/cmp/cmn
+                unsigned op = (w >> 21) & 0xf;
+                if (!(op >= 8 && op <= 11 && (w & 0x00100000))) {
+                    a.kill(rd);
+                }
+            } else if ((w & 0x0c100000) == 0x04100000) {  // ldr/ldrb
+                a.kill(rd);
+            } else if ((w & 0x0e100000) == 0x08100000) {  // ldm / pop
+                for (unsigned r = 0; r < 4; r++) {
+                    if (w & (1u << r)) {
+                        a.kill(r);
+                    }
+                }
+            }
+        }
+    }
+
+    // Linear sweep; 32-bit Thumb-2 encodings start with 0b11101, 0b11110 or 0b11111.
+    template <typename Fn>
+    void thumb(const uint8_t *p, size_t n, uint64_t base, Fn &fn) const {
+        static const unsigned regs[4] = {0, 1, 2, 3};
+        ArgTracker a;
+        for (size_t i = 0; i + 2 <= n;) {
+            uint16_t h = detail::rd16(p + i, le_);
+            uint64_t pc = base + i;
+            if ((h & 0xe000) == 0xe000 && (h & 0x1800) != 0) {
+                if (i + 4 > n) {
+                    break;
+                }
+                uint16_t h2 = detail::rd16(p + i + 2, le_);
+                thumb32(h, h2, pc, a, regs, i, fn);
+                i += 4;
+                continue;
+            }
+            unsigned lo = h & 7, hi = (h >> 8) & 7;
+            if ((h & 0xf800) == 0x2000) {  // movs rd, #imm8
+                a.set(hi, h & 0xff, i);
+            } else if ((h & 0xf800) == 0x4800) {  // ldr rd, [pc, #imm8*4]
+                literal(a, hi, ((pc + 4) & ~uint64_t(3)) + (h & 0xff) * 4, i);
+            } else if ((h & 0xf800) == 0xa000) {  // adr rd, #imm8*4
+                a.set(hi, ((pc + 4) & ~uint64_t(3)) + (h & 0xff) * 4, i);
+            } else if ((h & 0xff78) == 0x4478) {  // add rdn, pc
+                unsigned r = lo | ((h >> 4) & 8);
+                if (a.live(r, i)) {
+                    a.set(r, uint32_t(a.val[r] + pc + 4), i);
+                }
+            } else if ((h & 0xff00) == 0x4600) {  // mov rd, rm
+                unsigned r = lo | ((h >> 4) & 8), m = (h >> 3) & 15;
+                if (a.live(m, i)) {
+                    a.set(r, a.val[m], i);
+                } else {
+                    a.kill(r);
+                }
+            } else if ((h & 0xff87) == 0x4780) {  // blx rm
+                a.clear();
+            } else if ((h & 0xe000) == 0x0000 || (h & 0xf000) == 0x3000) {  // shifts, add/sub
+                a.kill((h & 0xf000) == 0x3000 ? hi : lo);
+            } else if ((h & 0xfc00) == 0x4000) {  // data processing, except tst/cmp/cmn
+                unsigned op = (h >> 6) & 15;
+                if (op != 8 && op != 10 && op != 11) {
+                    a.kill(lo);
+                }
+            } else if ((h & 0xf800) == 0x6800 || (h & 0xf800) == 0x7800 || (h & 0xf800) == 0x8800 ||
+                       ((h & 0xf000) == 0x5000 && (h & 0x0e00) >= 0x0600)) {  // loads
+                a.kill(lo);
+            } else if ((h & 0xf800) == 0x9800) {  // ldr rd, [sp, #imm8*4]
+                a.kill(hi);
+            } else if ((h & 0xfe00) == 0xbc00) {  // pop
+                for (unsigned r = 0; r < 4; r++) {
+                    if (h & (1u << r)) {
+                        a.kill(r);
+                    }
+                }
+            }
+            i += 2;
+        }
+    }
+
+    // x86 and x86-64: byte-granular, every offset is tried as an instruction start.
+    template <typename Fn>
+    void x86(const uint8_t *p, size_t n, uint64_t base, bool x64, Fn &fn) const {
+        // rdi, rsi, rdx, rcx on x86-64; outgoing stack slots 0-3 on i386
+        static const unsigned regs64[4] = {7, 6, 2, 1}, slots32[4] = {16, 17, 18, 19};
+        const unsigned (&regs)[4] = x64 ? regs64 : slots32;
+        uint64_t mask = x64 ? ~uint64_t(0) : 0xffffffff;
+        ArgTracker a;
+        for (size_t i = 0; i + 2 <= n; i++) {
+            uint64_t pc = base + i;
+            if ((p[i] == 0xe8 || p[i] == 0xe9) && i + 5 <= n) {  // call / jmp rel32
+                uint64_t target = (pc + 5 + uint64_t(int64_t(int32_t(detail::rd32(p + i + 1, true))))) & mask;
+                int f = t_.at(target);
+                if (f >= 0) {
+                    report(fn, f, pc, p[i] == 0xe9, a, regs, i, mask, p);
+                    a.clear();
+                }
+                continue;
+            }
+            if (p[i] == 0xff && (p[i + 1] == 0x15 || p[i + 1] == 0x25 || (!x64 && p[i + 1] == 0x93)) && i + 6 <= n) {
+                uint64_t disp = uint64_t(int64_t(int32_t(detail::rd32(p + i + 2, true))));
+                uint64_t slot = p[i + 1] == 0x93 ? got_ + disp : x64 ? pc + 6 + disp : disp;
+                int f = t_.through(slot & mask);
+                if (f >= 0) {
+                    report(fn, f, pc, p[i + 1] == 0x25, a, regs, i, mask, p);
+                    a.clear();
+                }
+                continue;
+            }
+            size_t j = i;
+            unsigned rex = 0;
+            if (x64 && (p[j] & 0xf0) == 0x40) {
+                rex = p[j++];
+            }
+            if (j + 2 > n) {
+                break;
+            }
+            uint8_t op = p[j], modrm = p[j + 1];
+            unsigned mod = modrm >> 6, reg = ((modrm >> 3) & 7) | (rex & 4 ? 8 : 0), rm = (modrm & 7) | (rex & 1 ? 8 : 0);
+            size_t end = 0;  // of a recognized instruction with an immediate
+            if (op >= 0xb8 && op <= 0xbf) {  // mov r, imm32 / imm64
+                unsigned r = (op & 7) | (rex & 1 ? 8 : 0);
+                if (rex & 8 && j + 9 <= n) {
+                    end = j + 9;
+                    a.set(r, uint64_t(detail::rd32(p + j + 1, true)) | uint64_t(detail::rd32(p + j + 5, true)) << 32,
+                          end);
+                } else if (j + 5 <= n) {
+                    end = j + 5;
+                    a.set(r, detail::rd32(p + j + 1, true), end);
+                }
+            } else if (op == 0xc7 && mod == 3 && ((modrm >> 3) & 7) == 0 && j + 6 <= n) {  // mov r, simm32
+                uint32_t v = detail::rd32(p + j + 2, true);
+                end = j + 6;
+                a.set(rm, rex & 8 ? uint64_t(int64_t(int32_t(v))) : v, end);
+            } else if (!x64 && op == 0xc7 && j + 7 <= n && modrm == 0x04 && p[j + 2] == 0x24) {  // mov [esp], imm32
+                end = j + 7;
+                a.set(16, detail::rd32(p + j + 3, true), end);
+            } else if (!x64 && op == 0xc7 && j + 8 <= n && modrm == 0x44 && p[j + 2] == 0x24 && p[j + 3] % 4 == 0 &&
+                       p[j + 3] < 16) {  // mov [esp + 4k], imm32
+                end = j + 8;
+                a.set(16 + p[j + 3] / 4, detail::rd32(p + j + 4, true), end);
+            } else if ((op == 0x31 || op == 0x33) && mod == 3 && reg == rm) {  // xor r, r
+                a.set(rm, 0, j + 2);
+            } else if (op == 0x8d && mod == 0 && (modrm & 7) == 5 && j + 6 <= n) {  // lea r, [rip + disp32]
+                uint64_t disp = uint64_t(int64_t(int32_t(detail::rd32(p + j + 2, true))));
+                end = j + 6;
+                a.set(reg, x64 ? base + end + disp : disp & mask, end);
+            } else if (!x64 && op == 0x8d && mod == 2 && (modrm & 7) == 3 && j + 6 <= n) {  // lea r, [ebx + disp32]
+                end = j + 6;
+                a.set(reg, (got_ + detail::rd32(p + j + 2, true)) & mask, end);  // PIC code keeps the GOT in ebx
+            } else if (!x64 && op == 0x89 && j + 3 <= n && (modrm & 0xc7) == 0x04 && p[j + 2] == 0x24) {
+                unsigned r = (modrm >> 3) & 7;  // mov [esp], r
+                a.live(r, i) ? a.set(16, a.val[r], j + 3) : a.kill(16);
+            } else if (!x64 && op == 0x89 && j + 4 <= n && (modrm & 0xc7) == 0x44 && p[j + 2] == 0x24 &&
+                       p[j + 3] % 4 == 0 && p[j + 3] < 16) {  // mov [esp + 4k], r
+                unsigned r = (modrm >> 3) & 7, k = 16 + p[j + 3] / 4;
+                a.live(r, i) ? a.set(k, a.val[r], j + 4) : a.kill(k);
+            } else if ((op == 0x89 || op == 0x8b) && mod == 3) {  // mov r, r
+                a.kill(op == 0x89 ? rm : reg);
+            } else if (!x64 && op >= 0x50 && op <= 0x57) {  // push r
+                unsigned r = op & 7, k = a.pushes++ % 8;
+                a.push_at[k] = i;
+                a.push_val[k] = a.live(r, i) ? a.val[r] : ARG_NONE;
+            }
+            if (end) {
+                i = end - 1;  // the immediate's bytes are not instructions
+            }
+        }
+    }
+
+    template <typename Fn>
+    void mips(const uint8_t *p, size_t n, uint64_t base, Fn &fn) const {
+        static const unsigned regs[4] = {4, 5, 6, 7};  // a0-a3
+        MipsState st;
+        uint64_t mask = elf_.is64() ? ~uint64_t(0) : 0xffffffff;
+        for (size_t i = 0; i + 4 <= n; i += 4) {
+            uint32_t w = detail::rd32(p + i, le_);
+            uint64_t pc = base + i;
+            unsigned op = w >> 26, rs = (w >> 21) & 31;
+            bool call = false, tail = false;
+            int f = -1;
+            if (op == 3 || op == 2) {  // jal / j
+                f = t_.at(((pc + 4) & ~uint64_t(0x0fffffff)) | uint64_t(w & 0x03ffffff) << 2);
+                call = op == 3;
+                tail = op == 2;
+            } else if ((w & 0xffff0000) == 0x04110000) {  // bal
+                f = t_.at(pc + 4 + uint64_t(int64_t(int16_t(w & 0xffff)) * 4));
+                call = true;
+            } else if ((w & 0xfc1f003e) == 0x00000008) {  // jr / jalr rs
+                call = w & 1;
+                tail = !call && rs == 25;  // jr t9; jr ra returns
+                if (st.slot_at[rs] != ARG_NONE && i - st.slot_at[rs] <= ARG_WINDOW) {
+                    f = t_.through(st.slot[rs]);
+                } else if (st.a.live(rs, i)) {
+                    f = t_.at(st.a.val[rs]);
+                }
+            }
+            if ((call || tail) && i + 8 <= n) {
+                MipsState d = st;  // the delay slot runs before the callee
+                mips_step(d, detail::rd32(p + i + 4, le_), i + 4);
+                report(fn, f, pc, tail, d.a, regs, i + 4, mask);
+            }
+            if (call) {
+                st.a.clear();
+                std::memset(st.slot_at, 0xff, sizeof st.slot_at);
+            } else {
+                mips_step(st, w, i);
+            }
+        }
+    }
+
+    void set_got(uint64_t got) { got_ = got; }
+
+  private:
+    struct MipsState {
+        ArgTracker a;
+        uint64_t slot[32];     // GOT slot the register was loaded from
+        uint64_t slot_at[32];
+
+        MipsState() { std::memset(slot_at, 0xff, sizeof slot_at); }
+    };
+
+    void mips_step(MipsState &st, uint32_t w, size_t i) const {
+        ArgTracker &a = st.a;
+        unsigned op = w >> 26, rs = (w >> 21) & 31, rt = (w >> 16) & 31, rd = (w >> 11) & 31;
+        uint32_t imm = w & 0xffff, simm = uint32_t(int32_t(int16_t(imm)));
+        unsigned dest = op == 0 ? rd : rt;
+        st.slot_at[dest] = ARG_NONE;
+        if (op == 0x0f) {  // lui
+            a.set(rt, imm << 16, i);
+        } else if (op == 0x09 || op == 0x0d) {  // addiu / ori
+            uint32_t v = op == 0x09 ? simm : imm;
+            if (rs == 0) {
+                a.set(rt, v, i);
+            } else if (a.live(rs, i)) {
+                a.set(rt, uint32_t(op == 0x09 ? a.val[rs] + v : a.val[rs] | v), i);
+            } else {
+                a.kill(rt);
+            }
+        } else if (op == 0x23 && rs == 28 && t_.mips_gp()) {  // lw rt, off(gp): a GOT entry
+            uint64_t slot = uint32_t(t_.mips_gp() + simm);
+            st.slot[rt] = slot;
+            st.slot_at[rt] = i;
+            if (const uint8_t *q = elf_.at_vaddr(slot, 4)) {
+                a.set(rt, detail::rd32(q, le_), i);
+            } else {
+                a.kill(rt);
+            }
+        } else if (op == 0 && ((w & 63) == 0x21 || (w & 63) == 0x25) && (rs == 0 || rt == 0)) {  // move
+            unsigned from = rs ? rs : rt;
+            if (from == 0) {
+                a.set(rd, 0, i);
+            } else if (a.live(from, i)) {
+                a.set(rd, a.val[from], i);
+            } else {
+                a.kill(rd);
+            }
+        } else if (op == 0 || op == 0x1c || (op >= 0x08 && op <= 0x0e) || (op >= 0x20 && op <= 0x26)) {
+            a.kill(dest);  // other ALU results and loads
+        }
+    }
+
+    template <typename Fn>
+    void thumb32(uint16_t h, uint16_t h2, uint64_t pc, ArgTracker &a, const unsigned (&regs)[4], size_t i,
+                 Fn &fn) const {
+        unsigned rd = (h2 >> 8) & 15;
+        if ((h & 0xf800) == 0xf000 && (h2 & 0x8000)) {  // b.w / bl / blx
+            bool link = h2 & 0x4000;
+            if (!link && (h2 & 0x1000) == 0) {
+                return;  // conditional b.w
+            }
+            uint32_t s = (h >> 10) & 1, j1 = (h2 >> 13) & 1, j2 = (h2 >> 11) & 1;
+            uint32_t off = s << 24 | (1 - (j1 ^ s)) << 23 | (1 - (j2 ^ s)) << 22 | (h & 0x3ffu) << 12 |
+                           (h2 & 0x7ffu) << 1;
+            uint64_t from = (h2 & 0x1000) ? pc + 4 : (pc + 4) & ~uint64_t(3);  // blx targets are word aligned
+            uint64_t target = uint32_t(from + uint32_t(int32_t(off << 7) >> 7));
+            report(fn, t_.at(target), pc, !link, a, regs, i, 0xffffffff);
+            if (link) {
+                a.clear();
+            }
+        } else if ((h & 0xfb40) == 0xf240 && !(h2 & 0x8000)) {  // movw / movt
+            uint32_t v = (h & 0xfu) << 12 | (h & 0x400u) << 1 | (h2 >> 4 & 0x700u) | (h2 & 0xffu);
+            if (!(h & 0x80)) {
+                a.set(rd, v, i);
+            } else if (a.live(rd, i)) {
+                a.set(rd, (a.val[rd] & 0xffff) | v << 16, i);
+            }
+        } else if ((h & 0xfbef) == 0xf04f && !(h2 & 0x8000)) {  // mov.w rd, #imm
+            a.set(rd, thumb_expand_imm((h & 0x400u) << 1 | (h2 >> 4 & 0x700u) | (h2 & 0xffu)), i);
+        } else if ((h & 0xff7f) == 0xf85f) {  // ldr.w rt, [pc, #+-imm12]
+            uint64_t at = ((pc + 4) & ~uint64_t(3));
+            literal(a, h2 >> 12, uint32_t(h & 0x80 ? at + (h2 & 0xfff) : at - (h2 & 0xfff)), i);
+        } else if ((h & 0xfff0) == 0xe8b0 || (h & 0xffff) == 0xe8bd) {  // ldmia.w / pop.w
+            for (unsigned r = 0; r < 4; r++) {
+                if (h2 & (1u << r)) {
+                    a.kill(r);
+                }
+            }
+        } else if ((h & 0xfe10) == 0xf810) {  // loads
+            a.kill(h2 >> 12);
+        } else if ((h & 0xfa00) == 0xf000 || (h & 0xfe00) == 0xea00 || (h & 0xfe00) == 0xeb00) {  // data processing
+            a.kill(rd);
+        }
+    }
+
+    static uint32_t thumb_expand_imm(uint32_t imm12) {
+        uint32_t imm8 = imm12 & 0xff;
+        if ((imm12 >> 10) == 0) {
+            switch ((imm12 >> 8) & 3) {
+            case 0: return imm8;
+            case 1: return imm8 << 16 | imm8;
+            case 2: return imm8 << 24 | imm8 << 8;
+            default: return imm8 << 24 | imm8 << 16 | imm8 << 8 | imm8;
+            }
+        }
+        uint32_t v = 0x80 | (imm12 & 0x7f), r = imm12 >> 7;
+        return (v >> r) | (v << (32 - r));
+    }
+
+    // rd = word at 'addr' (a literal pool entry)
+    void literal(ArgTracker &a, unsigned rd, uint64_t addr, size_t i) const {
+        if (const uint8_t *q = elf_.at_vaddr(addr, 4)) {
+            a.set(rd, detail::rd32(q, le_), i);
+        } else {
+            a.kill(rd);
+        }
+    }
+
+    template <typename Fn>
+    void report(Fn &fn, int f, uint64_t pc, bool tail, const ArgTracker &a, const unsigned (&regs)[4], size_t i,
+                uint64_t mask, const uint8_t *code = nullptr) const {
+        if (f < 0) {
+            return;
+        }
+        DirectCall c{pc, f, tail, {}, 0};
+        a.fill(c, regs, i, mask);
+        if (code && regs[0] == 16) {
+            pushed_args(code, i, a, c);
+        }
+        fn(c);
+    }
+
+    // i386: arguments pushed right before the call, walking back from it over
+    // push imm32 / push imm8 / push reg / push [ebp+d8] / push [esp+d8], and
+    // over the lea/mov that load the register pushed next.
+    static void pushed_args(const uint8_t *p, size_t call, const ArgTracker &a, DirectCall &c) {
+        size_t at = call;
+        for (unsigned k = 0; k < 4;) {
+            if (at >= 5 && p[at - 5] == 0x68) {
+                c.args[k] = detail::rd32(p + at - 4, true);
+                c.known |= 1u << k;
+                at -= 5;
+            } else if (at >= 2 && p[at - 2] == 0x6a) {
+                c.args[k] = uint32_t(int32_t(int8_t(p[at - 1])));
+                c.known |= 1u << k;
+                at -= 2;
+            } else if (at >= 3 && p[at - 3] == 0xff && p[at - 2] == 0x75) {
+                at -= 3;
+            } else if (at >= 4 && p[at - 4] == 0xff && p[at - 3] == 0x74 && p[at - 2] == 0x24) {
+                at -= 4;
+            } else if (at >= 1 && p[at - 1] >= 0x50 && p[at - 1] <= 0x57) {
+                for (unsigned q = 0; q < 8; q++) {
+                    if (a.push_at[q] == at - 1 && a.push_val[q] != ARG_NONE) {
+                        c.args[k] = a.push_val[q];
+                        c.known |= 1u << k;
+                    }
+                }
+                at -= 1;
+            } else if (at >= 6 && p[at - 6] == 0x8d && (p[at - 5] & 0xc7) == 0x83) {  // lea r, [ebx + disp32]
+                at -= 6;
+                continue;
+            } else if (at >= 5 && p[at - 5] >= 0xb8 && p[at - 5] <= 0xbf) {  // mov r, imm32
+                at -= 5;
+                continue;
+            } else {
+                break;
+            }
+            k++;
+        }
+    }
+
+    const ElfFile &elf_;
+    const CallTargets &t_;
+    bool le_;
+    uint64_t got_ = 0;
+};
+
+}  // namespace detail
+
+// Calls fn(DirectCall) for every call to one of the functions of 'targets'
+// in the executable sections of 'elf'. ARM code is swept both as A32 and
+// as Thumb; MIPS is read as 32-bit code.
+template <typename Fn>
+void scan_direct_calls(const ElfFile &elf, const CallTargets &targets, Fn &&fn) {
+    if (targets.empty()) {
+        return;
+    }
+    detail::Sweep sweep(elf, targets);
+    if (const ElfSection *g = elf.section(".got.plt")) {
+        sweep.set_got(g->addr);
+    } else if (const ElfSection *g = elf.section(".got")) {
+        sweep.set_got(g->addr);
+    }
+    for (const ElfSection &s : elf.sections()) {
+        const uint8_t *p = s.alloc() && s.exec() ? elf.section_data(s) : nullptr;
+        if (!p || s.name.compare(0, 4, ".plt") == 0 || s.name == ".MIPS.stubs") {
+            continue;
+        }
+        size_t n = size_t(s.size);
+        switch (elf.machine()) {
+        case EM_AARCH64:
+            sweep.aarch64(p, n, s.addr, fn);
+            break;
+        case EM_ARM:
+            sweep.a32(p, n, s.addr, fn);
+            sweep.thumb(p, n, s.addr, fn);
+            break;
+        case EM_X86_64:
+            sweep.x86(p, n, s.addr, true, fn);
+            break;
+        case EM_386:
+            sweep.x86(p, n, s.addr, false, fn);
+            break;
+        case EM_MIPS:
+            sweep.mips(p, n, s.addr, fn);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+}  // namespace common
@@ -0,0 +1,210 @@
+/*
+ *   Streaming writer for column-oriented tables.
+ *
+ *   Every column goes to its own file in Arrow's buffer layout, so rows never
+ *   have to be held in memory and the result can be mapped straight into
+ *   numpy/pandas/pyarrow:
+ *
+ *     TABLE.COLUMN.bin        fixed-width values, little-endian
+ *     TABLE.COLUMN.off/.dat   strings: int64 offsets (rows + 1, starting at
+ *                             0) into the concatenated UTF-8/byte data
+ *     TABLE.schema            "COLUMN TYPE" per line, then "rows N"
+ *
+ *   Types are u8, i32, u32, i64, u64, f64 and str. Each column buffers up to
+ *   1 MiB before writing.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace common {
+
+enum class ColType { U8, I32, U32, I64, U64, F64, STR };
+
+inline const char *coltype_name(ColType t) {
+    switch (t) {
+    case ColType::U8: return "u8";
+    case ColType::I32: return "i32";
+    case ColType::U32: return "u32";
+    case ColType::I64: return "i64";
+    case ColType::U64: return "u64";
+    case ColType::F64: return "f64";
+    case ColType::STR: return "str";
+    }
+    return "?";
+}
+
+class BufferedFile {
+  public:
+    explicit BufferedFile(const std::string &path) : path_(path), f_(std::fopen(path.c_str(), "wb")) {
+        if (!f_) {
+            throw std::runtime_error(path + ": " + std::strerror(errno));
+        }
+        buf_.reserve(CAPACITY);
+    }
+
+    BufferedFile(const BufferedFile &) = delete;
+    BufferedFile &operator=(const BufferedFile &) = delete;
+
+    ~BufferedFile() {
+        if (f_) {
+            std::fclose(f_);
+        }
+    }
+
+    void write(const void *p, size_t n) {
+        if (buf_.size() + n > CAPACITY) {
+            flush();
+            if (n > CAPACITY) {
+                put(p, n);
+                return;
+            }
+        }
+        const uint8_t *b = static_cast<const uint8_t *>(p);
+        buf_.insert(buf_.end(), b, b + n);
+    }
+
+    template <typename T>
+    void write_le(T v) {
+        uint8_t b[sizeof(T)];
+        uint64_t u = 0;
+        std::memcpy(&u, &v, sizeof(T));
+        for (size_t i = 0; i < sizeof(T); i++) {
+            b[i] = static_cast<uint8_t>(u >> (8 * i));
+        }
+        write(b, sizeof b);
+    }
+
+    void flush() {
+        put(buf_.data(), buf_.size());
+        buf_.clear();
+    }
+
+    void close() {
+        flush();
+        if (std::fclose(f_) != 0) {
+            f_ = nullptr;
+            throw std::runtime_error(path_ + ": write error");
+        }
+        f_ = nullptr;
+    }
+
+  private:
+    static constexpr size_t CAPACITY = 1 << 20;
+
+    void put(const void *p, size_t n) {
+        if (n && std::fwrite(p, 1, n, f_) != n) {
+            throw std::runtime_error(path_ + ": write error");
+        }
+    }
+
+    std::string path_;
+    FILE *f_;
+    std::vector<uint8_t> buf_;
+};
+
+class TableWriter {
+  public:
+    using Schema = std::vector<std::pair<std::string, ColType>>;
+
+    TableWriter(const std::string &dir, const std::string &table, Schema schema)
+        : base_(dir + "/" + table), schema_(std::move(schema)) {
+        for (const auto &c : schema_) {
+            Column col;
+            col.type = c.second;
+            if (c.second == ColType::STR) {
+                col.file.reset(new BufferedFile(base_ + "." + c.first + ".off"));
+                col.data.reset(new BufferedFile(base_ + "." + c.first + ".dat"));
+                col.file->write_le<int64_t>(0);
+            } else {
+                col.file.reset(new BufferedFile(base_ + "." + c.first + ".bin"));
+            }
+            cols_.push_back(std::move(col));
+        }
+    }
+
+    // Values of one row, appended in schema order:
+    //   t.u64(id).i32(line).str(name).end_row();
+    TableWriter &u8(uint8_t v) { return put(ColType::U8, v); }
+    TableWriter &i32(int32_t v) { return put(ColType::I32, v); }
+    TableWriter &u32(uint32_t v) { return put(ColType::U32, v); }
+    TableWriter &i64(int64_t v) { return put(ColType::I64, v); }
+    TableWriter &u64(uint64_t v) { return put(ColType::U64, v); }
+    TableWriter &f64(double v) { return put(ColType::F64, v); }
+
+    TableWriter &str(const char *s, size_t n) {
+        Column &c = next(ColType::STR);
+        c.data->write(s, n);
+        c.bytes += n;
+        c.file->write_le<int64_t>(static_cast<int64_t>(c.bytes));
+        return *this;
+    }
+
+    TableWriter &str(const std::string &s) { return str(s.data(), s.size()); }
+
+    void end_row() {
+        if (col_ != cols_.size()) {
+            throw std::logic_error(base_ + ": incomplete row");
+        }
+        col_ = 0;
+        rows_++;
+    }
+
+    uint64_t rows() const { return rows_; }
+
+    void close() {
+        for (Column &c : cols_) {
+            c.file->close();
+            if (c.data) {
+                c.data->close();
+            }
+        }
+        BufferedFile schema(base_ + ".schema");
+        std::string text;
+        for (const auto &c : schema_) {
+            text += c.first + " " + coltype_name(c.second) + "\n";
+        }
+        text += "rows " + std::to_string(rows_) + "\n";
+        schema.write(text.data(), text.size());
+        schema.close();
+    }
+
+  private:
+    struct Column {
+        ColType type;
+        std::unique_ptr<BufferedFile> file;  // values, or string offsets
+        std::unique_ptr<BufferedFile> data;  // string bytes
+        uint64_t bytes = 0;
+    };
+
+    Column &next(ColType t) {
+        if (col_ >= cols_.size() || cols_[col_].type != t) {
+            throw std::logic_error(base_ + ": value does not match schema column " + std::to_string(col_));
+        }
+        return cols_[col_++];
+    }
+
+    template <typename T>
+    TableWriter &put(ColType t, T v) {
+        next(t).file->write_le<T>(v);
+        return *this;
+    }
+
+    std::string base_;
+    Schema schema_;
+    std::vector<Column> cols_;
+    size_t col_ = 0;
+    uint64_t rows_ = 0;
+};
+
+}  // namespace common
@@ -0,0 +1,458 @@
+/*
+ *   Raw DEFLATE (RFC 1951) encoder and CRC-32, for the zip entries of the
+ *   archives the tools write.
+ *
+ *   LZ77 as zlib does it at its default level: hash chains over 3-byte
+ *   prefixes, walked at most MAX_CHAIN steps (stopping at a match of
+ *   NICE_MATCH bytes), and lazy matching, where a match is only taken if
+ *   the next position does not start a longer one. Every BLOCK_SYMBOLS
+ *   symbols a block is written with whichever of dynamic Huffman codes
+ *   (built for its symbols, lengths limited by halving the counts until
+ *   they fit), the fixed codes and stored bytes is smallest. The buffer
+ *   files this is meant for are mostly runs of zeros between small records
+ *   of similar shape, which is where dynamic codes pay off: the runs cost a
+ *   few bits per 258 bytes and the records' repeated field layouts become
+ *   short codes. The output is deterministic.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <utility>
+#include <vector>
+
+
+namespace common {
+
+inline uint32_t crc32(const uint8_t *p, size_t n, uint32_t crc = 0) {
+    static const struct Table {
+        uint32_t t[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) {
+                    c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                }
+                t[i] = c;
+            }
+        }
+    } table;
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) {
+        crc = table.t[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+namespace detail {
+
+class Deflater {
+  public:
+    explicit Deflater(std::vector<uint8_t> &out) : out_(out) {}
+
+    void run(const uint8_t *in, size_t n) {
+        in_ = in;
+        std::vector<uint32_t> head(HASH_SIZE, NONE), prev(n, NONE);
+        // Links position i into its chain; returns the previous position
+        // with the same 3-byte prefix.
+        auto insert = [&](size_t i) {
+            if (i + MIN_MATCH > n) {
+                return NONE;
+            }
+            uint32_t h = hash(in + i), p = head[h];
+            prev[i] = p;
+            head[h] = uint32_t(i);
+            return p;
+        };
+        auto longest = [&](size_t i, uint32_t cand, size_t &dist) {
+            size_t best = 0, max = std::min<size_t>(MAX_MATCH, n - i);
+            size_t limit = i > WINDOW ? i - WINDOW : 0;
+            for (int chain = MAX_CHAIN; cand != NONE && cand >= limit && chain > 0; chain--, cand = prev[cand]) {
+                const uint8_t *p = in + cand, *q = in + i;
+                if (p[best] != q[best] || p[0] != q[0]) {
+                    continue;
+                }
+                size_t len = 0;
+                while (len < max && p[len] == q[len]) {
+                    len++;
+                }
+                if (len > best) {
+                    best = len;
+                    dist = i - cand;
+                    if (len >= std::min(max, NICE_MATCH)) {
+                        break;
+                    }
+                }
+            }
+            return best < MIN_MATCH || (best == MIN_MATCH && dist > TOO_FAR) ? size_t(0) : best;
+        };
+
+        size_t i = 0, pending_len = 0, pending_dist = 0;
+        bool pending = false;  // a match or literal found at i - 1, not yet emitted
+        while (i < n) {
+            uint32_t cand = insert(i);
+            size_t len = 0, dist = 0;
+            if (!pending || pending_len < NICE_MATCH) {
+                len = longest(i, cand, dist);
+            }
+            if (pending && pending_len && len <= pending_len) {
+                match(pending_len, pending_dist);
+                for (size_t k = i + 1; k < i - 1 + pending_len; k++) {
+                    insert(k);
+                }
+                i += pending_len - 1;
+                pending = false;
+                continue;
+            }
+            if (pending) {
+                literal(in[i - 1]);
+            }
+            pending = true;
+            pending_len = len;
+            pending_dist = dist;
+            i++;
+        }
+        if (pending) {
+            if (pending_len) {
+                match(pending_len, pending_dist);
+            } else {
+                literal(in[n - 1]);
+            }
+        }
+        flush(true);
+        if (bitcnt_) {
+            out_.push_back(uint8_t(bitbuf_));
+        }
+    }
+
+  private:
+    static constexpr size_t MIN_MATCH = 3;
+    static constexpr size_t MAX_MATCH = 258;
+    static constexpr size_t NICE_MATCH = 128;
+    static constexpr int MAX_CHAIN = 128;
+    static constexpr size_t TOO_FAR = 4096;  // a 3-byte match further back rarely beats three literals
+    static constexpr size_t WINDOW = 32768;
+    static constexpr int HASH_BITS = 15;
+    static constexpr size_t HASH_SIZE = size_t(1) << HASH_BITS;
+    static constexpr size_t BLOCK_SYMBOLS = 16384;
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    static const uint16_t *length_base() {
+        static const uint16_t b[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                       31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        return b;
+    }
+    static const uint8_t *length_extra() {
+        static const uint8_t e[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        return e;
+    }
+    static const uint16_t *dist_base() {
+        static const uint16_t b[30] = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                       33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                       1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        return b;
+    }
+    static const uint8_t *dist_extra() {
+        static const uint8_t e[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                      6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        return e;
+    }
+
+    static unsigned length_code(size_t len) {
+        static const struct Codes {
+            uint8_t code[MAX_MATCH + 1];  // length -> symbol - 257
+            Codes() {
+                const uint16_t *b = length_base();
+                for (int s = 0, len = 3; len <= int(MAX_MATCH); len++) {
+                    while (s < 28 && len >= b[s + 1]) {
+                        s++;
+                    }
+                    code[len] = uint8_t(s);
+                }
+            }
+        } codes;
+        return codes.code[len];
+    }
+
+    static unsigned dist_code(size_t dist) {
+        const uint16_t *b = dist_base();
+        return unsigned(std::upper_bound(b, b + 30, dist) - b - 1);
+    }
+
+    static uint32_t hash(const uint8_t *p) {
+        uint32_t v = uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16;
+        return (v * 0x9e3779b1u) >> (32 - HASH_BITS);
+    }
+
+    static uint32_t reverse(uint32_t c, int len) {
+        uint32_t r = 0;
+        for (int k = 0; k < len; k++, c >>= 1) {
+            r = r << 1 | (c & 1);
+        }
+        return r;
+    }
+
+    // Huffman code lengths for 'freq', none longer than 'limit'. Symbols
+    // that occur get at least one bit, and at least two symbols get a code
+    // (decoders want complete codes).
+    static std::vector<uint8_t> code_lengths(std::vector<uint32_t> freq, int limit) {
+        size_t used = 0;
+        for (size_t s = 0; s < freq.size() && used < 2; s++) {
+            used += freq[s] != 0;
+        }
+        for (size_t s = 0; s < freq.size() && used < 2; s++) {
+            if (!freq[s]) {
+                freq[s] = 1;
+                used++;
+            }
+        }
+        std::vector<uint8_t> len(freq.size(), 0);
+        for (;;) {
+            using Node = std::pair<uint64_t, int>;  // weight, node
+            std::priority_queue<Node, std::vector<Node>, std::greater<Node>> q;
+            std::vector<int> parent;
+            for (size_t s = 0; s < freq.size(); s++) {
+                if (freq[s]) {
+                    q.emplace(freq[s], int(parent.size()));
+                    parent.push_back(-1);
+                }
+            }
+            while (q.size() > 1) {
+                Node a = q.top();
+                q.pop();
+                Node b = q.top();
+                q.pop();
+                int up = int(parent.size());
+                parent.push_back(-1);
+                parent[size_t(a.second)] = parent[size_t(b.second)] = up;
+                q.emplace(a.first + b.first, up);
+            }
+            int longest = 0;
+            for (size_t s = 0, leaf = 0; s < freq.size(); s++) {
+                if (freq[s]) {
+                    int depth = 0;
+                    for (int p = parent[leaf++]; p >= 0; p = parent[size_t(p)]) {
+                        depth++;
+                    }
+                    len[s] = uint8_t(depth);
+                    longest = std::max(longest, depth);
+                }
+            }
+            if (longest <= limit) {
+                return len;
+            }
+            for (uint32_t &f : freq) {
+                f = f ? (f + 1) / 2 : 0;
+            }
+        }
+    }
+
+    // Canonical codes (RFC 1951 3.2.2), bit-reversed for LSB-first output.
+    static std::vector<uint16_t> codes(const std::vector<uint8_t> &len) {
+        uint16_t count[16] = {}, next[16] = {};
+        for (uint8_t l : len) {
+            count[l]++;
+        }
+        count[0] = 0;
+        for (int b = 1, code = 0; b < 16; b++) {
+            code = (code + count[b - 1]) << 1;
+            next[b] = uint16_t(code);
+        }
+        std::vector<uint16_t> out(len.size(), 0);
+        for (size_t s = 0; s < len.size(); s++) {
+            if (len[s]) {
+                out[s] = uint16_t(reverse(next[len[s]]++, len[s]));
+            }
+        }
+        return out;
+    }
+
+    struct Symbol {
+        uint16_t value;  // literal byte, or match length
+        uint16_t dist;   // 0 for a literal
+    };
+
+    void literal(uint8_t c) {
+        block_.push_back({c, 0});
+        covered_++;
+        if (block_.size() >= BLOCK_SYMBOLS) {
+            flush(false);
+        }
+    }
+
+    void match(size_t len, size_t dist) {
+        block_.push_back({uint16_t(len), uint16_t(dist)});
+        covered_ += len;
+        if (block_.size() >= BLOCK_SYMBOLS) {
+            flush(false);
+        }
+    }
+
+    // Writes the symbols collected so far as one block (several if stored).
+    void flush(bool last) {
+        std::vector<uint32_t> lfreq(286, 0), dfreq(30, 0);
+        uint64_t extra = 0;
+        for (const Symbol &s : block_) {
+            if (!s.dist) {
+                lfreq[s.value]++;
+                continue;
+            }
+            unsigned l = length_code(s.value), d = dist_code(s.dist);
+            lfreq[257 + l]++;
+            dfreq[d]++;
+            extra += length_extra()[l] + dist_extra()[d];
+        }
+        lfreq[256]++;
+
+        std::vector<uint8_t> ll = code_lengths(lfreq, 15), dl = code_lengths(dfreq, 15);
+        size_t nl = 286, nd = 30;
+        while (nl > 257 && !ll[nl - 1]) {
+            nl--;
+        }
+        while (nd > 1 && !dl[nd - 1]) {
+            nd--;
+        }
+        // Code lengths of both codes, run-length coded with 16 (repeat the
+        // last 3-6 times), 17 (3-10 zeros) and 18 (11-138 zeros).
+        std::vector<uint8_t> all(ll.begin(), ll.begin() + long(nl));
+        all.insert(all.end(), dl.begin(), dl.begin() + long(nd));
+        std::vector<std::pair<uint8_t, uint8_t>> rle;  // symbol, extra bits value
+        for (size_t k = 0; k < all.size();) {
+            size_t run = 1;
+            while (k + run < all.size() && all[k + run] == all[k]) {
+                run++;
+            }
+            if (all[k] == 0 && run >= 3) {
+                run = std::min<size_t>(run, 138);
+                rle.emplace_back(run >= 11 ? 18 : 17, uint8_t(run - (run >= 11 ? 11 : 3)));
+            } else if (all[k] != 0 && run >= 4) {
+                run = std::min<size_t>(run, 7);
+                rle.emplace_back(all[k], 0);
+                rle.emplace_back(16, uint8_t(run - 4));
+            } else {
+                run = 1;
+                rle.emplace_back(all[k], 0);
+            }
+            k += run;
+        }
+        std::vector<uint32_t> cfreq(19, 0);
+        for (const auto &r : rle) {
+            cfreq[r.first]++;
+        }
+        std::vector<uint8_t> cl = code_lengths(cfreq, 7);
+        static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+        size_t nc = 19;
+        while (nc > 4 && !cl[order[nc - 1]]) {
+            nc--;
+        }
+
+        auto fixed_length = [](size_t s) { return s < 144 ? 8 : s < 256 ? 9 : s < 280 ? 7 : 8; };
+        uint64_t dynamic = 17 + 3 * nc + extra, fixed = 3 + extra, stored = 0;
+        for (const auto &r : rle) {
+            dynamic += cl[r.first] + (r.first == 16 ? 2 : r.first == 17 ? 3 : r.first == 18 ? 7 : 0);
+        }
+        for (size_t s = 0; s < 286; s++) {
+            dynamic += uint64_t(lfreq[s]) * ll[s];
+            fixed += uint64_t(lfreq[s]) * fixed_length(s);
+        }
+        for (size_t s = 0; s < 30; s++) {
+            dynamic += uint64_t(dfreq[s]) * dl[s];
+            fixed += uint64_t(dfreq[s]) * 5;
+        }
+        size_t raw = covered_ - start_;
+        stored = (raw / 65535 + 1) * 40 + 8 * uint64_t(raw) + 7;
+
+        if (stored < std::min(dynamic, fixed)) {
+            const uint8_t *p = in_ + start_;
+            do {
+                size_t chunk = std::min<size_t>(raw, 65535);
+                raw -= chunk;
+                bits(last && !raw, 1);
+                bits(0, 2);
+                if (bitcnt_) {
+                    bits(0, 8 - bitcnt_);
+                }
+                bits(uint32_t(chunk), 16);
+                bits(uint32_t(~chunk & 0xffff), 16);
+                out_.insert(out_.end(), p, p + chunk);
+                p += chunk;
+            } while (raw);
+        } else if (fixed <= dynamic) {
+            std::vector<uint8_t> fl(288), fd(30, 5);
+            for (size_t s = 0; s < 288; s++) {
+                fl[s] = uint8_t(fixed_length(s));
+            }
+            bits(last, 1);
+            bits(1, 2);
+            symbols(codes(fl), fl, codes(fd), fd);
+        } else {
+            bits(last, 1);
+            bits(2, 2);
+            bits(uint32_t(nl - 257), 5);
+            bits(uint32_t(nd - 1), 5);
+            bits(uint32_t(nc - 4), 4);
+            for (size_t k = 0; k < nc; k++) {
+                bits(cl[order[k]], 3);
+            }
+            std::vector<uint16_t> cc = codes(cl);
+            for (const auto &r : rle) {
+                bits(cc[r.first], cl[r.first]);
+                if (r.first >= 16) {
+                    bits(r.second, r.first == 16 ? 2 : r.first == 17 ? 3 : 7);
+                }
+            }
+            symbols(codes(ll), ll, codes(dl), dl);
+        }
+        block_.clear();
+        start_ = covered_;
+    }
+
+    void symbols(const std::vector<uint16_t> &lc, const std::vector<uint8_t> &ll, const std::vector<uint16_t> &dc,
+                 const std::vector<uint8_t> &dl) {
+        for (const Symbol &s : block_) {
+            if (!s.dist) {
+                bits(lc[s.value], ll[s.value]);
+                continue;
+            }
+            unsigned l = length_code(s.value), d = dist_code(s.dist);
+            bits(lc[257 + l], ll[257 + l]);
+            bits(uint32_t(s.value - length_base()[l]), length_extra()[l]);
+            bits(dc[d], dl[d]);
+            bits(uint32_t(s.dist - dist_base()[d]), dist_extra()[d]);
+        }
+        bits(lc[256], ll[256]);
+    }
+
+    // LSB first, as extra bits and header fields are stored
+    void bits(uint32_t v, int n) {
+        bitbuf_ |= uint64_t(v) << bitcnt_;
+        bitcnt_ += n;
+        while (bitcnt_ >= 8) {
+            out_.push_back(uint8_t(bitbuf_));
+            bitbuf_ >>= 8;
+            bitcnt_ -= 8;
+        }
+    }
+
+    std::vector<uint8_t> &out_;
+    const uint8_t *in_ = nullptr;
+    std::vector<Symbol> block_;
+    size_t start_ = 0;    // first input byte of the block
+    size_t covered_ = 0;  // input bytes in blocks and block_
+    uint64_t bitbuf_ = 0;
+    int bitcnt_ = 0;
+};
+
+}  // namespace detail
+
+// Compresses n bytes at 'in' into one raw deflate stream appended to 'out'.
+inline void deflate(const uint8_t *in, size_t n, std::vector<uint8_t> &out) {
+    detail::Deflater(out).run(in, n);
+}
+
+}  // namespace common
@@ -0,0 +1,593 @@
+/*
+ *   Read-only ELF view over a mapped file: sections, program headers and
+ *   symbols (.symtab and .dynsym), with byte order taken from the file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace common {
+
+// e_machine values the tools know how to look into.
+enum ElfMachine : uint16_t {
+    EM_386 = 3,
+    EM_MIPS = 8,
+    EM_PPC = 20,
+    EM_PPC64 = 21,
+    EM_ARM = 40,
+    EM_X86_64 = 62,
+    EM_AARCH64 = 183,
+    EM_RISCV = 243,
+};
+
+struct ElfSection {
+    std::string name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t addr;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t entsize;
+    uint32_t link;
+    uint32_t info;
+
+    bool alloc() const { return flags & 0x2; }
+    bool exec() const { return flags & 0x4; }
+    bool write() const { return flags & 0x1; }
+    bool nobits() const { return type == 8; }
+};
+
+struct ElfProgramHeader {
+    uint32_t type;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t filesz;
+    uint64_t memsz;
+};
+
+struct ElfSymbol {
+    std::string name;
+    uint64_t value;
+    uint64_t size;
+    uint8_t type;   // STT_*
+    uint8_t bind;   // STB_*
+    uint16_t shndx;
+    bool dynamic;   // from .dynsym
+
+    bool defined() const { return shndx != 0; }
+    bool function() const { return type == 2; }
+};
+
+// A dynamic relocation, from SHT_REL/SHT_RELA, Android's packed APS2
+// sections or SHT_RELR (which only holds relative relocations).
+struct ElfRelocation {
+    uint64_t offset;     // r_offset (a virtual address in shared objects)
+    uint32_t type;       // R_*
+    uint32_t sym;        // index into the dynamic symbol table, 0 for none
+    int64_t addend;
+    bool rela;           // addend is explicit; otherwise it is the word at offset
+    uint64_t sym_value;  // st_value of 'sym' when it is defined
+    bool sym_defined;
+    std::string sym_name;
+};
+
+// Relocation types that store base + addend, and symbol + addend with the
+// width of a pointer, per machine (0 where the machine is not handled).
+inline uint32_t relative_reloc_type(uint16_t machine) {
+    switch (machine) {
+    case EM_386: return 8;         // R_386_RELATIVE
+    case EM_ARM: return 23;        // R_ARM_RELATIVE
+    case EM_X86_64: return 8;      // R_X86_64_RELATIVE
+    case EM_AARCH64: return 1027;  // R_AARCH64_RELATIVE
+    case EM_RISCV: return 3;       // R_RISCV_RELATIVE
+    default: return 0;
+    }
+}
+
+inline uint32_t absolute_reloc_type(uint16_t machine) {
+    switch (machine) {
+    case EM_386: return 1;         // R_386_32
+    case EM_ARM: return 2;         // R_ARM_ABS32
+    case EM_X86_64: return 1;      // R_X86_64_64
+    case EM_AARCH64: return 257;   // R_AARCH64_ABS64
+    case EM_RISCV: return 2;       // R_RISCV_64
+    default: return 0;
+    }
+}
+
+class ElfFile {
+  public:
+    static bool is_elf(const uint8_t *d, size_t n) {
+        return n >= 52 && std::memcmp(d, "\x7f" "ELF", 4) == 0 && (d[4] == 1 || d[4] == 2) &&
+               (d[5] == 1 || d[5] == 2);
+    }
+
+    // Non-owning: 'data' must outlive the ElfFile.
+    ElfFile(const uint8_t *data, size_t size) : d_(data), n_(size) {
+        if (!is_elf(data, size)) {
+            throw std::runtime_error("not an ELF file");
+        }
+        is64_ = d_[4] == 2;
+        little_ = d_[5] == 1;
+        type_ = u16(16);
+        machine_ = u16(18);
+        flags_ = u32(is64_ ? 48 : 36);
+        parse_program_headers();
+        parse_sections();
+    }
+
+    bool is64() const { return is64_; }
+    bool little_endian() const { return little_; }
+    unsigned pointer_size() const { return is64_ ? 8 : 4; }
+    uint16_t type() const { return type_; }
+    uint16_t machine() const { return machine_; }
+    uint32_t flags() const { return flags_; }
+    const uint8_t *data() const { return d_; }
+    size_t size() const { return n_; }
+
+    const std::vector<ElfSection> &sections() const { return sections_; }
+    const std::vector<ElfProgramHeader> &segments() const { return phdrs_; }
+
+    const ElfSection *section(const std::string &name) const {
+        for (const ElfSection &s : sections_) {
+            if (s.name == name) {
+                return &s;
+            }
+        }
+        return nullptr;
+    }
+
+    // File bytes of a section (nullptr for SHT_NOBITS or truncated files).
+    const uint8_t *section_data(const ElfSection &s) const {
+        if (s.nobits() || s.offset > n_ || s.size > n_ - s.offset) {
+            return nullptr;
+        }
+        return d_ + s.offset;
+    }
+
+    // File bytes backing [vaddr, vaddr+len), looked up through PT_LOAD segments
+    // (or allocated sections when the file has no program headers).
+    const uint8_t *at_vaddr(uint64_t vaddr, uint64_t len = 1) const {
+        for (const ElfProgramHeader &p : phdrs_) {
+            if (p.type == 1 && vaddr >= p.vaddr && vaddr - p.vaddr < p.filesz && p.filesz - (vaddr - p.vaddr) >= len) {
+                uint64_t off = p.offset + (vaddr - p.vaddr);
+                return off + len <= n_ ? d_ + off : nullptr;
+            }
+        }
+        if (phdrs_.empty()) {
+            for (const ElfSection &s : sections_) {
+                if (s.alloc() && !s.nobits() && vaddr >= s.addr && vaddr - s.addr < s.size &&
+                    s.size - (vaddr - s.addr) >= len) {
+                    uint64_t off = s.offset + (vaddr - s.addr);
+                    return off + len <= n_ ? d_ + off : nullptr;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    // Virtual address of a file offset, or 0 if the offset is not loaded.
+    uint64_t vaddr_of_offset(uint64_t off) const {
+        for (const ElfProgramHeader &p : phdrs_) {
+            if (p.type == 1 && off >= p.offset && off - p.offset < p.filesz) {
+                return p.vaddr + (off - p.offset);
+            }
+        }
+        return 0;
+    }
+
+    // NUL-terminated string at a virtual address, bounded by 'max'.
+    std::string cstring_at(uint64_t vaddr, size_t max = 4096) const {
+        const uint8_t *p = at_vaddr(vaddr);
+        if (!p) {
+            return {};
+        }
+        size_t avail = static_cast<size_t>(n_ - (p - d_));
+        size_t len = 0;
+        while (len < avail && len < max && p[len]) {
+            len++;
+        }
+        if (len == avail || len == max) {
+            return {};
+        }
+        return std::string(reinterpret_cast<const char *>(p), len);
+    }
+
+    const std::vector<ElfSymbol> &symbols() const {
+        if (!symbols_loaded_) {
+            load_symbols();
+        }
+        return symbols_;
+    }
+
+    // First defined symbol named 'name' (.symtab preferred over .dynsym).
+    const ElfSymbol *find_symbol(const std::string &name) const {
+        const std::vector<ElfSymbol> &syms = symbols();
+        if (by_name_.empty() && !syms.empty()) {
+            for (size_t i = 0; i < syms.size(); i++) {
+                if (syms[i].defined() && !syms[i].name.empty()) {
+                    by_name_.emplace(syms[i].name, i);
+                }
+            }
+        }
+        auto it = by_name_.find(name);
+        return it == by_name_.end() ? nullptr : &syms[it->second];
+    }
+
+    // Names of undefined dynamic symbols (what the object imports).
+    std::vector<std::string> imports() const {
+        std::vector<std::string> out;
+        for (const ElfSymbol &s : symbols()) {
+            if (s.dynamic && !s.defined() && !s.name.empty()) {
+                out.push_back(s.name);
+            }
+        }
+        return out;
+    }
+
+    // Relocations of the allocated relocation sections, i.e. those the
+    // dynamic loader applies. Relocations against object files are not read.
+    std::vector<ElfRelocation> dynamic_relocations() const {
+        std::vector<ElfRelocation> out;
+        for (const ElfSection &s : sections_) {
+            const uint8_t *p = s.alloc() ? section_data(s) : nullptr;
+            if (!p) {
+                continue;
+            }
+            switch (s.type) {
+            case 9:   // SHT_REL
+            case 4: {  // SHT_RELA
+                bool rela = s.type == 4;
+                uint64_t ent = (is64_ ? 16 : 8) + (rela ? (is64_ ? 8 : 4) : 0);
+                for (uint64_t o = 0; o + ent <= s.size; o += ent) {
+                    uint64_t info = decode(p + o + pointer_size(), pointer_size());
+                    int64_t addend = 0;
+                    if (rela) {
+                        addend = is64_ ? int64_t(decode(p + o + 16, 8)) : int32_t(decode(p + o + 8, 4));
+                    }
+                    uint32_t type = is64_ ? uint32_t(info) : uint32_t(info & 0xff);
+                    uint32_t sym = is64_ ? uint32_t(info >> 32) : uint32_t(info >> 8);
+                    out.push_back(relocation(s, decode(p + o, pointer_size()), type, sym, addend, rela));
+                }
+                break;
+            }
+            case 0x60000001:    // SHT_ANDROID_REL
+            case 0x60000002:    // SHT_ANDROID_RELA
+                unpack_android(s, p, s.type == 0x60000002, out);
+                break;
+            case 19:            // SHT_RELR
+            case 0x6fffff00:    // SHT_ANDROID_RELR
+                unpack_relr(p, s.size, out);
+                break;
+            default:
+                break;
+            }
+        }
+        return out;
+    }
+
+    // (d_tag, d_val) pairs of the SHT_DYNAMIC section, up to DT_NULL.
+    std::vector<std::pair<uint64_t, uint64_t>> dynamic_entries() const {
+        std::vector<std::pair<uint64_t, uint64_t>> out;
+        for (const ElfSection &s : sections_) {
+            const uint8_t *p = s.type == 6 ? section_data(s) : nullptr;
+            unsigned w = pointer_size();
+            for (uint64_t o = 0; p && o + 2 * w <= s.size; o += 2 * w) {
+                uint64_t tag = decode(p + o, w);
+                if (tag == 0) {
+                    break;
+                }
+                out.push_back({tag, decode(p + o + w, w)});
+            }
+        }
+        return out;
+    }
+
+    // Name of entry 'index' of a symbol table section ("" when out of range).
+    std::string symbol_name(const ElfSection &symtab, uint64_t index) const {
+        uint64_t ent = is64_ ? 24 : 16;
+        if (symtab.link >= sections_.size() || index * ent + ent > symtab.size ||
+            symtab.offset + index * ent + ent > n_) {
+            return {};
+        }
+        return strtab_string(sections_[symtab.link], u32(symtab.offset + index * ent));
+    }
+
+    uint16_t u16(uint64_t off) const { return static_cast<uint16_t>(read(off, 2)); }
+    uint32_t u32(uint64_t off) const { return static_cast<uint32_t>(read(off, 4)); }
+    uint64_t u64(uint64_t off) const { return read(off, 8); }
+    uint64_t word(uint64_t off) const { return read(off, is64_ ? 8 : 4); }
+
+    uint64_t decode(const uint8_t *p, unsigned width) const {
+        uint64_t v = 0;
+        if (little_) {
+            for (unsigned i = width; i-- > 0;) {
+                v = (v << 8) | p[i];
+            }
+        } else {
+            for (unsigned i = 0; i < width; i++) {
+                v = (v << 8) | p[i];
+            }
+        }
+        return v;
+    }
+
+  private:
+    uint64_t read(uint64_t off, unsigned width) const {
+        if (off > n_ || n_ - off < width) {
+            throw std::runtime_error("truncated ELF file");
+        }
+        return decode(d_ + off, width);
+    }
+
+    ElfRelocation relocation(const ElfSection &rel, uint64_t offset, uint32_t type, uint32_t sym, int64_t addend,
+                             bool rela) const {
+        ElfRelocation r{offset, type, sym, addend, rela, 0, false, {}};
+        if (sym != 0 && rel.link < sections_.size()) {
+            const ElfSection &symtab = sections_[rel.link];
+            uint64_t ent = is64_ ? 24 : 16;
+            uint64_t o = symtab.offset + uint64_t(sym) * ent;
+            if (uint64_t(sym) * ent + ent <= symtab.size && o + ent <= n_) {
+                r.sym_value = is64_ ? u64(o + 8) : u32(o + 4);
+                r.sym_defined = u16(o + (is64_ ? 6 : 14)) != 0;
+                if (symtab.link < sections_.size()) {
+                    r.sym_name = strtab_string(sections_[symtab.link], u32(o));
+                }
+            }
+        }
+        return r;
+    }
+
+    // Android packed relocations (bionic's "APS2"): SLEB128 groups of
+    // relocations sharing an offset delta, info and/or addend.
+    void unpack_android(const ElfSection &s, const uint8_t *p, bool rela, std::vector<ElfRelocation> &out) const {
+        if (s.size < 4 || std::memcmp(p, "APS2", 4) != 0) {
+            return;
+        }
+        const uint8_t *q = p + 4, *end = p + s.size;
+        auto sleb = [&]() {
+            int64_t v = 0;
+            unsigned shift = 0;
+            uint8_t b;
+            do {
+                if (q == end) {
+                    throw std::runtime_error("truncated packed relocations");
+                }
+                b = *q++;
+                v |= int64_t(b & 0x7f) << shift;
+                shift += 7;
+            } while ((b & 0x80) && shift < 64);
+            if (shift < 64 && (b & 0x40)) {
+                v |= -(int64_t(1) << shift);
+            }
+            return v;
+        };
+        enum { BY_INFO = 1, BY_OFFSET_DELTA = 2, BY_ADDEND = 4, HAS_ADDEND = 8 };
+        uint64_t count = uint64_t(sleb());
+        uint64_t offset = uint64_t(sleb());
+        uint64_t info = 0;
+        int64_t addend = 0;
+        for (uint64_t done = 0; done < count;) {
+            uint64_t group = uint64_t(sleb());
+            int64_t flags = sleb();
+            if (group == 0 || group > count - done) {
+                throw std::runtime_error("bad packed relocation group");
+            }
+            uint64_t delta = flags & BY_OFFSET_DELTA ? uint64_t(sleb()) : 0;
+            if (flags & BY_INFO) {
+                info = uint64_t(sleb());
+            }
+            bool has_addend = rela && (flags & HAS_ADDEND);
+            if (has_addend && (flags & BY_ADDEND)) {
+                addend += sleb();
+            } else if (!has_addend) {
+                addend = 0;
+            }
+            for (uint64_t i = 0; i < group; i++) {
+                offset += flags & BY_OFFSET_DELTA ? delta : uint64_t(sleb());
+                if (!(flags & BY_INFO)) {
+                    info = uint64_t(sleb());
+                }
+                if (has_addend && !(flags & BY_ADDEND)) {
+                    addend += sleb();
+                }
+                uint32_t type = is64_ ? uint32_t(info) : uint32_t(info & 0xff);
+                uint32_t sym = is64_ ? uint32_t(info >> 32) : uint32_t(info >> 8);
+                out.push_back(relocation(s, offset, type, sym, addend, rela));
+            }
+            done += group;
+        }
+    }
+
+    // SHT_RELR: an address word, then bitmap words (low bit set) marking
+    // which of the following 63 (or 31) words are relocated as well.
+    void unpack_relr(const uint8_t *p, uint64_t size, std::vector<ElfRelocation> &out) const {
+        unsigned w = pointer_size();
+        uint32_t type = relative_reloc_type(machine_);
+        uint64_t where = 0;
+        for (uint64_t o = 0; o + w <= size; o += w) {
+            uint64_t e = decode(p + o, w);
+            if ((e & 1) == 0) {
+                out.push_back({e, type, 0, 0, false, 0, false, {}});
+                where = e + w;
+                continue;
+            }
+            for (unsigned b = 1; b < w * 8; b++) {
+                if ((e >> b) & 1) {
+                    out.push_back({where + (b - 1) * w, type, 0, 0, false, 0, false, {}});
+                }
+            }
+            where += uint64_t(w * 8 - 1) * w;
+        }
+    }
+
+    void parse_program_headers() {
+        uint64_t phoff = word(is64_ ? 32 : 28);
+        unsigned phentsize = u16(is64_ ? 54 : 42);
+        unsigned phnum = u16(is64_ ? 56 : 44);
+        if (phoff == 0 || phentsize == 0) {
+            return;
+        }
+        for (unsigned i = 0; i < phnum; i++) {
+            uint64_t p = phoff + uint64_t(i) * phentsize;
+            if (p + phentsize > n_) {
+                break;
+            }
+            ElfProgramHeader h;
+            h.type = u32(p);
+            if (is64_) {
+                h.flags = u32(p + 4);
+                h.offset = u64(p + 8);
+                h.vaddr = u64(p + 16);
+                h.filesz = u64(p + 32);
+                h.memsz = u64(p + 40);
+            } else {
+                h.offset = u32(p + 4);
+                h.vaddr = u32(p + 8);
+                h.filesz = u32(p + 16);
+                h.memsz = u32(p + 20);
+                h.flags = u32(p + 24);
+            }
+            phdrs_.push_back(h);
+        }
+    }
+
+    void parse_sections() {
+        uint64_t shoff = word(is64_ ? 40 : 32);
+        unsigned shentsize = u16(is64_ ? 58 : 46);
+        unsigned shnum = u16(is64_ ? 60 : 48);
+        unsigned shstrndx = u16(is64_ ? 62 : 50);
+        if (shoff == 0 || shentsize == 0 || shoff >= n_) {
+            return;
+        }
+        std::vector<uint32_t> names;
+        for (unsigned i = 0; i < shnum; i++) {
+            uint64_t s = shoff + uint64_t(i) * shentsize;
+            if (s + shentsize > n_) {
+                break;
+            }
+            ElfSection h;
+            names.push_back(u32(s));
+            h.type = u32(s + 4);
+            if (is64_) {
+                h.flags = u64(s + 8);
+                h.addr = u64(s + 16);
+                h.offset = u64(s + 24);
+                h.size = u64(s + 32);
+                h.link = u32(s + 40);
+                h.info = u32(s + 44);
+                h.entsize = u64(s + 56);
+            } else {
+                h.flags = u32(s + 8);
+                h.addr = u32(s + 12);
+                h.offset = u32(s + 16);
+                h.size = u32(s + 20);
+                h.link = u32(s + 24);
+                h.info = u32(s + 28);
+                h.entsize = u32(s + 36);
+            }
+            sections_.push_back(h);
+        }
+        if (shstrndx < sections_.size()) {
+            const ElfSection &strtab = sections_[shstrndx];
+            for (size_t i = 0; i < sections_.size(); i++) {
+                sections_[i].name = strtab_string(strtab, names[i]);
+            }
+        }
+    }
+
+    std::string strtab_string(const ElfSection &strtab, uint64_t idx) const {
+        if (strtab.offset > n_ || idx >= strtab.size) {
+            return {};
+        }
+        // Clamped to the file without overflowing: a corrupt header may put
+        // the table, or the string, past its end.
+        uint64_t end = strtab.offset + std::min<uint64_t>(strtab.size, n_ - strtab.offset);
+        uint64_t start = idx < end - strtab.offset ? strtab.offset + idx : end;
+        if (start >= end) {
+            return {};
+        }
+        const uint8_t *p = d_ + start;
+        const uint8_t *z = static_cast<const uint8_t *>(std::memchr(p, 0, end - start));
+        return z ? std::string(reinterpret_cast<const char *>(p), z - p) : std::string();
+    }
+
+    void load_symbols() const {
+        symbols_loaded_ = true;
+        for (const ElfSection &s : sections_) {
+            if (s.type != 2 /* SHT_SYMTAB */ && s.type != 11 /* SHT_DYNSYM */) {
+                continue;
+            }
+            if (s.link >= sections_.size()) {
+                continue;
+            }
+            const ElfSection &strtab = sections_[s.link];
+            uint64_t ent = is64_ ? 24 : 16;
+            if (s.offset > n_ || s.size > n_ - s.offset) {
+                continue;
+            }
+            for (uint64_t o = s.offset + ent; o + ent <= s.offset + s.size; o += ent) {
+                ElfSymbol sym;
+                uint32_t name = u32(o);
+                uint8_t info;
+                if (is64_) {
+                    info = d_[o + 4];
+                    sym.shndx = u16(o + 6);
+                    sym.value = u64(o + 8);
+                    sym.size = u64(o + 16);
+                } else {
+                    sym.value = u32(o + 4);
+                    sym.size = u32(o + 8);
+                    info = d_[o + 12];
+                    sym.shndx = u16(o + 14);
+                }
+                sym.type = info & 0xf;
+                sym.bind = info >> 4;
+                sym.dynamic = s.type == 11;
+                sym.name = strtab_string(strtab, name);
+                symbols_.push_back(std::move(sym));
+            }
+        }
+        // .symtab entries first so that find_symbol prefers them
+        std::stable_partition(symbols_.begin(), symbols_.end(), [](const ElfSymbol &s) { return !s.dynamic; });
+    }
+
+    const uint8_t *d_;
+    size_t n_;
+    bool is64_ = false;
+    bool little_ = true;
+    uint16_t type_ = 0;
+    uint16_t machine_ = 0;
+    uint32_t flags_ = 0;
+    std::vector<ElfProgramHeader> phdrs_;
+    std::vector<ElfSection> sections_;
+    mutable bool symbols_loaded_ = false;
+    mutable std::vector<ElfSymbol> symbols_;
+    mutable std::unordered_map<std::string, size_t> by_name_;
+};
+
+inline const char *machine_name(uint16_t m) {
+    switch (m) {
+    case EM_386: return "i386";
+    case EM_MIPS: return "mips";
+    case EM_PPC: return "ppc";
+    case EM_PPC64: return "ppc64";
+    case EM_ARM: return "arm";
+    case EM_X86_64: return "x86_64";
+    case EM_AARCH64: return "aarch64";
+    case EM_RISCV: return "riscv";
+    default: return "unknown";
+    }
+}
+
+}  // namespace common
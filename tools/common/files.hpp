@@ -0,0 +1,43 @@
+/*
+ *   Expansion of command-line paths into the regular files below them.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+
+namespace common {
+
+// Regular files under the given paths, sorted; symlinks are not followed so
+// that firmware trees with looping links terminate. Missing paths are
+// reported on stderr as "tool: path: ...".
+inline std::vector<std::string> collect_files(const std::vector<std::string> &paths, const char *tool) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    for (const std::string &p : paths) {
+        std::error_code ec;
+        fs::file_status st = fs::symlink_status(p, ec);
+        if (fs::is_regular_file(st)) {
+            files.push_back(p);
+        } else if (fs::is_directory(st)) {
+            for (fs::recursive_directory_iterator it(p, fs::directory_options::skip_permission_denied, ec), end;
+                 !ec && it != end; it.increment(ec)) {
+                if (it->is_regular_file(ec) && !it->is_symlink(ec)) {
+                    files.push_back(it->path().string());
+                }
+            }
+        } else if (ec || !fs::exists(st)) {
+            std::fprintf(stderr, "%s: %s: no such file or directory\n", tool, p.c_str());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+}  // namespace common
@@ -0,0 +1,73 @@
+/*
+ *   Fast non-cryptographic 64-bit hashing for content memoization and
+ *   hash-keyed indexes.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+
+namespace common {
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    x ^= x >> 32;
+    return x;
+}
+
+inline uint64_t combine(uint64_t h, uint64_t v) {
+    return mix64(h ^ (v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+}
+
+// Four independent lanes over 32-byte blocks, folded at the end.
+inline uint64_t hash_bytes(const void *data, size_t n, uint64_t seed = 0) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    const uint64_t K = 0x9fb21c651e98df25ULL;
+    uint64_t a = seed ^ 0x243f6a8885a308d3ULL, b = seed ^ 0x13198a2e03707344ULL;
+    uint64_t c = seed ^ 0xa4093822299f31d0ULL, d = seed ^ 0x082efa98ec4e6c89ULL;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        uint64_t w[4];
+        std::memcpy(w, p + i, 32);
+        a = (a ^ w[0]) * K;
+        b = (b ^ w[1]) * K;
+        c = (c ^ w[2]) * K;
+        d = (d ^ w[3]) * K;
+        a ^= a >> 29;
+        b ^= b >> 29;
+        c ^= c >> 29;
+        d ^= d >> 29;
+    }
+    uint64_t h = combine(combine(combine(mix64(a), b), c), d);
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = combine(h, w);
+    }
+    uint64_t tail = 0;
+    for (size_t k = 0; i < n; i++, k++) {
+        tail |= uint64_t(p[i]) << (8 * k);
+    }
+    return combine(combine(h, tail), n);
+}
+
+inline uint64_t hash_string(const std::string &s, uint64_t seed = 0) {
+    return hash_bytes(s.data(), s.size(), seed);
+}
+
+inline std::string hex64(uint64_t v) {
+    static const char digits[] = "0123456789abcdef";
+    std::string s(16, '0');
+    for (int i = 15; i >= 0; i--, v >>= 4) {
+        s[i] = digits[v & 15];
+    }
+    return s;
+}
+
+}  // namespace common
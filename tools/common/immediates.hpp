@@ -0,0 +1,274 @@
+/*
+ *   Architecture-aware extraction of 32-bit constants materialized by code.
+ *
+ *   This is not a disassembler: for each supported instruction set it
+ *   recognizes the handful of encodings compilers use to put a constant in a
+ *   register or compare against one, and reports (offset, value) pairs:
+ *
+ *     x86/x86-64  every little-endian 32-bit word (imm32/disp32 are stored raw)
+ *     ARM         literal pool words, A32 rotated immediates, movw/movt pairs,
+ *                 Thumb movs/cmp imm8, Thumb-2 modified immediates and movw/movt
+ *     AArch64     literal pool words, movz/movn (+movk), add/sub/cmp imm12
+ *     MIPS        literal pool words, lui (+ori/addiu), addiu/ori/slti rs=$zero
+ *     PowerPC     literal pool words, lis (+ori/addi), li, cmpwi/cmplwi
+ *
+ *   Offsets are relative to the start of the scanned buffer.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/elf.hpp"
+
+
+namespace common {
+
+namespace detail {
+
+inline uint32_t rd32(const uint8_t *p, bool le) {
+    return le ? (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24)
+              : (uint32_t(p[3]) | uint32_t(p[2]) << 8 | uint32_t(p[1]) << 16 | uint32_t(p[0]) << 24);
+}
+
+inline uint16_t rd16(const uint8_t *p, bool le) {
+    return le ? uint16_t(p[0] | p[1] << 8) : uint16_t(p[1] | p[0] << 8);
+}
+
+inline uint32_t ror32(uint32_t v, unsigned r) {
+    r &= 31;
+    return r ? (v >> r) | (v << (32 - r)) : v;
+}
+
+// ThumbExpandImm (ARMv7-M ARM, A5.3.2)
+inline uint32_t thumb_expand_imm(uint32_t imm12) {
+    uint32_t imm8 = imm12 & 0xff;
+    if ((imm12 >> 10) == 0) {
+        switch ((imm12 >> 8) & 3) {
+        case 0: return imm8;
+        case 1: return imm8 << 16 | imm8;
+        case 2: return imm8 << 24 | imm8 << 8;
+        default: return imm8 << 24 | imm8 << 16 | imm8 << 8 | imm8;
+        }
+    }
+    return ror32(0x80 | (imm12 & 0x7f), imm12 >> 7);
+}
+
+template <typename Fn>
+void scan_x86(const uint8_t *p, size_t n, Fn &fn) {
+    for (size_t i = 0; i + 4 <= n; i++) {
+        fn(i, rd32(p + i, true));
+    }
+}
+
+template <typename Fn>
+void scan_arm(const uint8_t *p, size_t n, bool le, Fn &fn) {
+    // A32 and literal pools (word aligned)
+    uint32_t movw_val[16];
+    size_t movw_at[16];
+    std::memset(movw_at, 0xff, sizeof movw_at);
+    for (size_t i = 0; i + 4 <= n; i += 4) {
+        uint32_t w = rd32(p + i, le);
+        fn(i, w);
+        if ((w >> 28) == 0xf) {
+            continue;
+        }
+        if ((w & 0x0e000000) == 0x02000000) {
+            unsigned op = (w >> 21) & 0xf;
+            // mov/mvn/cmp/cmn/add/sub with rotated immediate
+            if (op == 0xd || op == 0xa || op == 0xb || op == 0x4 || op == 0x2 || op == 0xf) {
+                uint32_t v = ror32(w & 0xff, ((w >> 8) & 0xf) * 2);
+                fn(i, op == 0xf ? ~v : op == 0xb ? uint32_t(0) - v : v);
+            }
+        }
+        if ((w & 0x0ff00000) == 0x03000000) {  // movw
+            unsigned rd = (w >> 12) & 0xf;
+            uint32_t v = ((w >> 4) & 0xf000) | (w & 0xfff);
+            movw_val[rd] = v;
+            movw_at[rd] = i;
+            fn(i, v);
+        } else if ((w & 0x0ff00000) == 0x03400000) {  // movt
+            unsigned rd = (w >> 12) & 0xf;
+            if (movw_at[rd] != size_t(-1) && i - movw_at[rd] <= 16) {
+                fn(movw_at[rd], (((w >> 4) & 0xf000) | (w & 0xfff)) << 16 | movw_val[rd]);
+            }
+        }
+    }
+
+    // Thumb / Thumb-2 (halfword aligned)
+    std::memset(movw_at, 0xff, sizeof movw_at);
+    for (size_t i = 0; i + 2 <= n; i += 2) {
+        uint16_t h = rd16(p + i, le);
+        if ((h & 0xf000) == 0x2000) {  // movs rd,#imm8 / cmp rn,#imm8
+            fn(i, h & 0xff);
+            continue;
+        }
+        if ((h & 0xf800) < 0xe800 || i + 4 > n) {
+            continue;
+        }
+        uint16_t h2 = rd16(p + i + 2, le);
+        uint32_t imm12 = ((h & 0x400u) << 1) | ((h2 >> 4) & 0x700u) | (h2 & 0xffu);
+        unsigned rd = (h2 >> 8) & 0xf;
+        if ((h & 0xfb40) == 0xf240 && !(h2 & 0x8000)) {  // movw / movt
+            uint32_t v = ((h & 0xfu) << 12) | imm12;
+            if (h & 0x80) {
+                if (movw_at[rd] != size_t(-1) && i - movw_at[rd] <= 16) {
+                    fn(movw_at[rd], v << 16 | movw_val[rd]);
+                }
+            } else {
+                movw_val[rd] = v;
+                movw_at[rd] = i;
+                fn(i, v);
+            }
+        } else if ((h & 0xfa00) == 0xf000 && !(h2 & 0x8000)) {  // data processing, modified immediate
+            unsigned op = (h >> 5) & 0xf;
+            uint32_t v = thumb_expand_imm(imm12);
+            if (op == 0x2 && (h & 0xf) == 0xf) {  // mov.w
+                fn(i, v);
+            } else if (op == 0x3 && (h & 0xf) == 0xf) {  // mvn
+                fn(i, ~v);
+            } else if (op == 0xd && rd == 0xf) {  // cmp.w
+                fn(i, v);
+            } else if (op == 0x8 && rd == 0xf) {  // cmn.w
+                fn(i, uint32_t(0) - v);
+            }
+        }
+    }
+}
+
+template <typename Fn>
+void scan_aarch64(const uint8_t *p, size_t n, bool le, Fn &fn) {
+    uint64_t reg_val[32];
+    size_t reg_at[32];
+    std::memset(reg_at, 0xff, sizeof reg_at);
+    for (size_t i = 0; i + 4 <= n; i += 4) {
+        uint32_t w = rd32(p + i, le);
+        fn(i, w);
+        unsigned rd = w & 0x1f;
+        unsigned hw = (w >> 21) & 3;
+        uint64_t imm16 = (w >> 5) & 0xffff;
+        if ((w & 0x7f800000) == 0x52800000) {  // movz
+            reg_val[rd] = imm16 << (16 * hw);
+            reg_at[rd] = i;
+            fn(i, uint32_t(reg_val[rd]));
+        } else if ((w & 0x7f800000) == 0x12800000) {  // movn
+            uint64_t v = ~(imm16 << (16 * hw));
+            if (!(w & 0x80000000)) {
+                v &= 0xffffffff;
+            }
+            reg_val[rd] = v;
+            reg_at[rd] = i;
+            fn(i, uint32_t(v));
+        } else if ((w & 0x7f800000) == 0x72800000) {  // movk
+            if (reg_at[rd] != size_t(-1) && i - reg_at[rd] <= 16) {
+                uint64_t mask = uint64_t(0xffff) << (16 * hw);
+                reg_val[rd] = (reg_val[rd] & ~mask) | (imm16 << (16 * hw));
+                fn(reg_at[rd], uint32_t(reg_val[rd]));
+            }
+        } else if ((w & 0x1f000000) == 0x11000000) {  // add/sub/cmp/cmn imm12
+            uint32_t v = (w >> 10) & 0xfff;
+            if (w & 0x00400000) {
+                v <<= 12;
+            }
+            bool sub = w & 0x40000000;
+            fn(i, v);
+            if (sub) {
+                fn(i, uint32_t(0) - v);
+            }
+        }
+    }
+}
+
+template <typename Fn>
+void scan_mips(const uint8_t *p, size_t n, bool le, Fn &fn) {
+    uint32_t lui_val[32];
+    size_t lui_at[32];
+    std::memset(lui_at, 0xff, sizeof lui_at);
+    for (size_t i = 0; i + 4 <= n; i += 4) {
+        uint32_t w = rd32(p + i, le);
+        fn(i, w);
+        unsigned op = w >> 26, rs = (w >> 21) & 0x1f, rt = (w >> 16) & 0x1f;
+        uint32_t imm = w & 0xffff;
+        uint32_t simm = uint32_t(int32_t(int16_t(imm)));
+        if (op == 0x0f) {  // lui
+            lui_val[rt] = imm << 16;
+            lui_at[rt] = i;
+            fn(i, imm << 16);
+        } else if (op == 0x0d || op == 0x09) {  // ori / addiu
+            uint32_t v = op == 0x0d ? imm : simm;
+            if (rs == 0) {
+                fn(i, v);
+            } else if (lui_at[rs] != size_t(-1) && i - lui_at[rs] <= 32) {
+                fn(lui_at[rs], lui_val[rs] + v);  // lui's low half is zero, so + is | for ori
+            }
+        } else if (op == 0x0a || op == 0x0b) {  // slti / sltiu
+            fn(i, simm);
+        }
+    }
+}
+
+template <typename Fn>
+void scan_ppc(const uint8_t *p, size_t n, bool le, Fn &fn) {
+    uint32_t lis_val[32];
+    size_t lis_at[32];
+    std::memset(lis_at, 0xff, sizeof lis_at);
+    for (size_t i = 0; i + 4 <= n; i += 4) {
+        uint32_t w = rd32(p + i, le);
+        fn(i, w);
+        unsigned op = w >> 26, rt = (w >> 21) & 0x1f, ra = (w >> 16) & 0x1f;
+        uint32_t imm = w & 0xffff;
+        uint32_t simm = uint32_t(int32_t(int16_t(imm)));
+        if (op == 15 && ra == 0) {  // lis
+            lis_val[rt] = imm << 16;
+            lis_at[rt] = i;
+            fn(i, imm << 16);
+        } else if (op == 14) {  // addi / li
+            if (ra == 0) {
+                fn(i, simm);
+            } else if (lis_at[ra] != size_t(-1) && i - lis_at[ra] <= 32) {
+                fn(lis_at[ra], lis_val[ra] + simm);
+            }
+        } else if (op == 24) {  // ori (rs in bits 21-25, ra is the target)
+            if (lis_at[rt] != size_t(-1) && i - lis_at[rt] <= 32) {
+                fn(lis_at[rt], lis_val[rt] | imm);
+            }
+        } else if (op == 11) {  // cmpwi
+            fn(i, simm);
+        } else if (op == 10) {  // cmplwi
+            fn(i, imm);
+        }
+    }
+}
+
+}  // namespace detail
+
+// Calls fn(offset, value) for every constant recognized in 'code'.
+template <typename Fn>
+void scan_immediates(uint16_t machine, bool little_endian, const uint8_t *code, size_t n, Fn &&fn) {
+    switch (machine) {
+    case EM_386:
+    case EM_X86_64:
+        detail::scan_x86(code, n, fn);
+        break;
+    case EM_ARM:
+        detail::scan_arm(code, n, little_endian, fn);
+        break;
+    case EM_AARCH64:
+        detail::scan_aarch64(code, n, little_endian, fn);
+        break;
+    case EM_MIPS:
+        detail::scan_mips(code, n, little_endian, fn);
+        break;
+    case EM_PPC:
+    case EM_PPC64:
+        detail::scan_ppc(code, n, little_endian, fn);
+        break;
+    default:
+        for (size_t i = 0; i + 4 <= n; i += 4) {
+            fn(i, detail::rd32(code + i, little_endian));
+        }
+    }
+}
+
+}  // namespace common
@@ -0,0 +1,259 @@
+/*
+ *   Raw DEFLATE (RFC 1951) decoder, for the zip entries inside archives the
+ *   tools read. Canonical Huffman decoding by code length, as in zlib's
+ *   puff.c: small and dependency-free rather than fast.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+
+namespace common {
+
+namespace detail {
+
+class Inflater {
+  public:
+    Inflater(const uint8_t *in, size_t n, std::vector<uint8_t> &out) : in_(in), n_(n), out_(out) {}
+
+    size_t run() {
+        int last;
+        do {
+            last = bits(1);
+            switch (bits(2)) {
+            case 0: stored(); break;
+            case 1: fixed(); break;
+            case 2: dynamic(); break;
+            default: throw std::runtime_error("deflate: invalid block type");
+            }
+        } while (!last);
+        return pos_;
+    }
+
+  private:
+    static constexpr int MAXBITS = 15;
+
+    struct Huffman {
+        uint16_t count[MAXBITS + 1];
+        uint16_t symbol[288];
+    };
+
+    int bits(int need) {
+        uint32_t val = bitbuf_;
+        while (bitcnt_ < need) {
+            if (pos_ >= n_) {
+                throw std::runtime_error("deflate: unexpected end of data");
+            }
+            val |= uint32_t(in_[pos_++]) << bitcnt_;
+            bitcnt_ += 8;
+        }
+        bitbuf_ = val >> need;
+        bitcnt_ -= need;
+        return static_cast<int>(val & ((1u << need) - 1));
+    }
+
+    void stored() {
+        bitbuf_ = 0;
+        bitcnt_ = 0;
+        if (pos_ + 4 > n_) {
+            throw std::runtime_error("deflate: unexpected end of data");
+        }
+        unsigned len = in_[pos_] | in_[pos_ + 1] << 8;
+        unsigned nlen = in_[pos_ + 2] | in_[pos_ + 3] << 8;
+        pos_ += 4;
+        if (len != (~nlen & 0xffff)) {
+            throw std::runtime_error("deflate: stored block length mismatch");
+        }
+        if (len > n_ - pos_) {
+            throw std::runtime_error("deflate: unexpected end of data");
+        }
+        out_.insert(out_.end(), in_ + pos_, in_ + pos_ + len);
+        pos_ += len;
+    }
+
+    int decode(const Huffman &h) {
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len <= MAXBITS; len++) {
+            code |= bits(1);
+            int count = h.count[len];
+            if (code - count < first) {
+                return h.symbol[index + (code - first)];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        throw std::runtime_error("deflate: invalid Huffman code");
+    }
+
+    // Returns 0 for a complete code, > 0 for an incomplete one.
+    static int construct(Huffman &h, const uint16_t *length, int n) {
+        for (int len = 0; len <= MAXBITS; len++) {
+            h.count[len] = 0;
+        }
+        for (int symbol = 0; symbol < n; symbol++) {
+            h.count[length[symbol]]++;
+        }
+        if (h.count[0] == n) {
+            return 0;
+        }
+        int left = 1;
+        for (int len = 1; len <= MAXBITS; len++) {
+            left <<= 1;
+            left -= h.count[len];
+            if (left < 0) {
+                throw std::runtime_error("deflate: over-subscribed code");
+            }
+        }
+        uint16_t offs[MAXBITS + 1];
+        offs[1] = 0;
+        for (int len = 1; len < MAXBITS; len++) {
+            offs[len + 1] = offs[len] + h.count[len];
+        }
+        for (int symbol = 0; symbol < n; symbol++) {
+            if (length[symbol] != 0) {
+                h.symbol[offs[length[symbol]]++] = static_cast<uint16_t>(symbol);
+            }
+        }
+        return left;
+    }
+
+    void codes(const Huffman &lencode, const Huffman &distcode) {
+        static const uint16_t lbase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                           31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const uint8_t lext[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                         2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const uint16_t dbase[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,
+                                           33,  49,  65,  97,  129, 193,  257,  385,  513,  769,
+                                           1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static const uint8_t dext[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                         6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        for (;;) {
+            int symbol = decode(lencode);
+            if (symbol < 256) {
+                out_.push_back(static_cast<uint8_t>(symbol));
+                continue;
+            }
+            if (symbol == 256) {
+                return;
+            }
+            symbol -= 257;
+            if (symbol >= 29) {
+                throw std::runtime_error("deflate: invalid length symbol");
+            }
+            size_t len = lbase[symbol] + static_cast<size_t>(bits(lext[symbol]));
+            symbol = decode(distcode);
+            if (symbol >= 30) {
+                throw std::runtime_error("deflate: invalid distance symbol");
+            }
+            size_t dist = dbase[symbol] + static_cast<size_t>(bits(dext[symbol]));
+            if (dist > out_.size()) {
+                throw std::runtime_error("deflate: distance too far back");
+            }
+            size_t from = out_.size() - dist;
+            for (size_t i = 0; i < len; i++) {
+                out_.push_back(out_[from + i]);  // may overlap what is being written
+            }
+        }
+    }
+
+    void fixed() {
+        if (!fixed_built_) {
+            uint16_t lengths[288];
+            int symbol = 0;
+            for (; symbol < 144; symbol++) lengths[symbol] = 8;
+            for (; symbol < 256; symbol++) lengths[symbol] = 9;
+            for (; symbol < 280; symbol++) lengths[symbol] = 7;
+            for (; symbol < 288; symbol++) lengths[symbol] = 8;
+            construct(fixed_len_, lengths, 288);
+            for (symbol = 0; symbol < 30; symbol++) lengths[symbol] = 5;
+            construct(fixed_dist_, lengths, 30);
+            fixed_built_ = true;
+        }
+        codes(fixed_len_, fixed_dist_);
+    }
+
+    void dynamic() {
+        static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+        uint16_t lengths[320];
+        int nlen = bits(5) + 257;
+        int ndist = bits(5) + 1;
+        int ncode = bits(4) + 4;
+        if (nlen > 286 || ndist > 30) {
+            throw std::runtime_error("deflate: bad counts");
+        }
+        int index = 0;
+        for (; index < ncode; index++) {
+            lengths[order[index]] = static_cast<uint16_t>(bits(3));
+        }
+        for (; index < 19; index++) {
+            lengths[order[index]] = 0;
+        }
+        Huffman lencode, distcode;
+        if (construct(lencode, lengths, 19) != 0) {
+            throw std::runtime_error("deflate: incomplete code-length code");
+        }
+        index = 0;
+        while (index < nlen + ndist) {
+            int symbol = decode(lencode);
+            if (symbol < 16) {
+                lengths[index++] = static_cast<uint16_t>(symbol);
+                continue;
+            }
+            uint16_t len = 0;
+            if (symbol == 16) {
+                if (index == 0) {
+                    throw std::runtime_error("deflate: repeat with no previous length");
+                }
+                len = lengths[index - 1];
+                symbol = 3 + bits(2);
+            } else if (symbol == 17) {
+                symbol = 3 + bits(3);
+            } else {
+                symbol = 11 + bits(7);
+            }
+            if (index + symbol > nlen + ndist) {
+                throw std::runtime_error("deflate: too many lengths");
+            }
+            while (symbol--) {
+                lengths[index++] = len;
+            }
+        }
+        if (lengths[256] == 0) {
+            throw std::runtime_error("deflate: no end-of-block code");
+        }
+        int err = construct(lencode, lengths, nlen);
+        if (err && nlen - lencode.count[0] != 1) {
+            throw std::runtime_error("deflate: incomplete literal/length code");
+        }
+        err = construct(distcode, lengths + nlen, ndist);
+        if (err && ndist - distcode.count[0] != 1) {
+            throw std::runtime_error("deflate: incomplete distance code");
+        }
+        codes(lencode, distcode);
+    }
+
+    const uint8_t *in_;
+    size_t n_;
+    size_t pos_ = 0;
+    uint32_t bitbuf_ = 0;
+    int bitcnt_ = 0;
+    std::vector<uint8_t> &out_;
+    Huffman fixed_len_, fixed_dist_;
+    bool fixed_built_ = false;
+};
+
+}  // namespace detail
+
+// Decompresses the raw deflate stream at 'in', appending to 'out'. Returns the
+// number of input bytes consumed (the stream is self-terminating).
+inline size_t inflate(const uint8_t *in, size_t n, std::vector<uint8_t> &out) {
+    return detail::Inflater(in, n, out).run();
+}
+
+}  // namespace common
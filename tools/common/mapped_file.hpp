@@ -0,0 +1,100 @@
+/*
+ *   Read-only memory mapping of a whole file.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace common {
+
+class MappedFile {
+  public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string &path) : path_(path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error(path + ": " + std::strerror(errno));
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::runtime_error(path + ": " + std::strerror(err));
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                int err = errno;
+                ::close(fd);
+                throw std::runtime_error(path + ": mmap: " + std::strerror(err));
+            }
+            data_ = static_cast<const uint8_t *>(p);
+        }
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&o) noexcept { *this = std::move(o); }
+    MappedFile &operator=(MappedFile &&o) noexcept {
+        if (this != &o) {
+            unmap();
+            path_ = std::move(o.path_);
+            data_ = o.data_;
+            size_ = o.size_;
+            o.data_ = nullptr;
+            o.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~MappedFile() { unmap(); }
+
+    // Hint the kernel about the access pattern of [off, off+len).
+    void advise(int advice, size_t off = 0, size_t len = 0) const {
+        if (!data_) {
+            return;
+        }
+        size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        size_t start = off & ~(page - 1);
+        size_t end = len ? off + len : size_;
+        if (end > size_) {
+            end = size_;
+        }
+        ::madvise(const_cast<uint8_t *>(data_) + start, end - start, advice);
+    }
+
+    const uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+    const std::string &path() const { return path_; }
+
+  private:
+    void unmap() {
+        if (data_) {
+            ::munmap(const_cast<uint8_t *>(data_), size_);
+            data_ = nullptr;
+            size_ = 0;
+        }
+    }
+
+    std::string path_;
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}  // namespace common
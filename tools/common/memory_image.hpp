@@ -0,0 +1,165 @@
+/*
+ *   Virtual-address view over a process memory dump.
+ *
+ *   Two inputs are understood:
+ *     - ELF core files (ET_CORE); every PT_LOAD segment with file backing is
+ *       mapped at its p_vaddr
+ *     - raw dumps, mapped as one segment at a caller-supplied base address
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "common/mapped_file.hpp"
+
+
+namespace common {
+
+struct Segment {
+    uint64_t vaddr;
+    uint64_t size;   // bytes backed by the file
+    const uint8_t *data;
+};
+
+class MemoryImage {
+  public:
+    MemoryImage(const std::string &path, uint64_t raw_base = 0)
+        : file_(path) {
+        if (!load_core()) {
+            segments_.push_back({raw_base, file_.size(), file_.data()});
+        }
+        std::sort(segments_.begin(), segments_.end(),
+                  [](const Segment &a, const Segment &b) { return a.vaddr < b.vaddr; });
+    }
+
+    bool little_endian() const { return little_endian_; }
+    void set_little_endian(bool le) { little_endian_ = le; }
+
+    // ELF class of the core (4 or 8), or 0 for raw dumps.
+    unsigned elf_pointer_size() const { return elf_ptr_size_; }
+
+    const std::vector<Segment> &segments() const { return segments_; }
+    const MappedFile &file() const { return file_; }
+
+    // Pointer to 'len' contiguous bytes at 'addr', or nullptr if any part of
+    // the range is not present in the dump.
+    const uint8_t *at(uint64_t addr, uint64_t len = 1) const {
+        auto it = std::upper_bound(segments_.begin(), segments_.end(), addr,
+                                   [](uint64_t a, const Segment &s) { return a < s.vaddr; });
+        if (it == segments_.begin()) {
+            return nullptr;
+        }
+        --it;
+        uint64_t off = addr - it->vaddr;
+        if (off >= it->size || it->size - off < len) {
+            return nullptr;
+        }
+        return it->data + off;
+    }
+
+    bool contains(uint64_t addr, uint64_t len = 1) const { return at(addr, len) != nullptr; }
+
+    // Bytes present from 'addr' to the end of its segment, 0 if none.
+    uint64_t extent(uint64_t addr) const {
+        auto it = std::upper_bound(segments_.begin(), segments_.end(), addr,
+                                   [](uint64_t a, const Segment &s) { return a < s.vaddr; });
+        if (it == segments_.begin()) {
+            return 0;
+        }
+        --it;
+        uint64_t off = addr - it->vaddr;
+        return off < it->size ? it->size - off : 0;
+    }
+
+    // Unsigned integer of 'width' bytes (1, 2, 4 or 8) in dump byte order.
+    bool read(uint64_t addr, unsigned width, uint64_t &out) const {
+        const uint8_t *p = at(addr, width);
+        if (!p) {
+            return false;
+        }
+        out = decode(p, width);
+        return true;
+    }
+
+    uint64_t read_or(uint64_t addr, unsigned width, uint64_t fallback) const {
+        uint64_t v;
+        return read(addr, width, v) ? v : fallback;
+    }
+
+    uint64_t decode(const uint8_t *p, unsigned width) const {
+        uint64_t v = 0;
+        if (little_endian_) {
+            for (unsigned i = width; i-- > 0;) {
+                v = (v << 8) | p[i];
+            }
+        } else {
+            for (unsigned i = 0; i < width; i++) {
+                v = (v << 8) | p[i];
+            }
+        }
+        return v;
+    }
+
+  private:
+    bool load_core() {
+        const uint8_t *d = file_.data();
+        size_t n = file_.size();
+        if (n < 52 || std::memcmp(d, "\x7f" "ELF", 4) != 0) {
+            return false;
+        }
+        bool is64 = d[4] == 2;
+        if (is64 && n < 64) {  // the ELF header, whose program header fields end at 58
+            return false;
+        }
+        little_endian_ = d[5] == 1;
+        uint16_t type = static_cast<uint16_t>(decode(d + 16, 2));
+        if (type != 4 /* ET_CORE */) {
+            return false;
+        }
+        elf_ptr_size_ = is64 ? 8 : 4;
+        uint64_t phoff = is64 ? decode(d + 32, 8) : decode(d + 28, 4);
+        unsigned phentsize = static_cast<unsigned>(decode(d + (is64 ? 54 : 42), 2));
+        unsigned phnum = static_cast<unsigned>(decode(d + (is64 ? 56 : 44), 2));
+        uint64_t phsize = is64 ? 56 : 32;  // sizeof(Elf64_Phdr), sizeof(Elf32_Phdr)
+        for (unsigned i = 0; i < phnum; i++) {
+            // phoff + i * phentsize + phsize <= n, without overflow
+            uint64_t rel = static_cast<uint64_t>(i) * phentsize;
+            if (phoff > n || rel > n - phoff || n - phoff - rel < phsize) {
+                break;
+            }
+            const uint8_t *p = d + phoff + rel;
+            if (decode(p, 4) != 1 /* PT_LOAD */) {
+                continue;
+            }
+            uint64_t off, vaddr, filesz;
+            if (is64) {
+                off = decode(p + 8, 8);
+                vaddr = decode(p + 16, 8);
+                filesz = decode(p + 32, 8);
+            } else {
+                off = decode(p + 4, 4);
+                vaddr = decode(p + 8, 4);
+                filesz = decode(p + 16, 4);
+            }
+            if (filesz == 0 || off >= n) {
+                continue;
+            }
+            filesz = std::min<uint64_t>(filesz, n - off);
+            segments_.push_back({vaddr, filesz, d + off});
+        }
+        return true;
+    }
+
+    MappedFile file_;
+    std::vector<Segment> segments_;
+    bool little_endian_ = true;
+    unsigned elf_ptr_size_ = 0;
+};
+
+}  // namespace common
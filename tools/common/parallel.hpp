@@ -0,0 +1,75 @@
+/*
+ *   Minimal work distribution helpers shared by the batch tools.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace common {
+
+inline unsigned default_jobs() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+// Calls fn(i) for every i in [0, count) on up to 'jobs' threads. Work items are
+// claimed dynamically, so uneven item costs (large vs small files) balance out.
+// The first exception thrown by any worker is rethrown on the calling thread.
+template <typename Fn>
+void parallel_for(size_t count, unsigned jobs, Fn &&fn) {
+    if (count == 0) {
+        return;
+    }
+    jobs = std::max(1u, std::min<unsigned>(jobs, static_cast<unsigned>(count)));
+    if (jobs == 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_lock;
+    auto worker = [&]() {
+        for (;;) {
+            size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= count) {
+                return;
+            }
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> g(error_lock);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next.store(count, std::memory_order_relaxed);
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(jobs - 1);
+    for (unsigned t = 1; t < jobs; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : pool) {
+        t.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace common
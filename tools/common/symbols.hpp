@@ -0,0 +1,63 @@
+/*
+ *   Defined symbols of an ELF file by address: the object or function
+ *   starting at an address, and the function containing one. ARM function
+ *   symbols are keyed without their Thumb bit.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/elf.hpp"
+
+
+namespace common {
+
+class SymbolMap {
+  public:
+    explicit SymbolMap(const ElfFile &elf) {
+        bool arm = elf.machine() == EM_ARM;
+        for (const ElfSymbol &s : elf.symbols()) {
+            if (s.defined() && !s.name.empty() && (s.type == 1 /* STT_OBJECT */ || s.function())) {
+                uint64_t a = s.function() && arm ? s.value & ~uint64_t(1) : s.value;
+                at_.emplace(a, &s.name);
+                if (s.function()) {
+                    functions_.push_back({a, &s});
+                }
+            }
+        }
+        std::sort(functions_.begin(), functions_.end(),
+                  [](const Function &x, const Function &y) { return x.addr < y.addr; });
+    }
+
+    // Name of the symbol at 'a', or nullptr.
+    const char *at(uint64_t a) const {
+        auto it = at_.find(a);
+        return it == at_.end() ? nullptr : it->second->c_str();
+    }
+
+    // Function containing 'a' ("?" if none does).
+    const char *containing(uint64_t a) const {
+        auto it = std::upper_bound(functions_.begin(), functions_.end(), a,
+                                   [](uint64_t v, const Function &f) { return v < f.addr; });
+        if (it == functions_.begin()) {
+            return "?";
+        }
+        --it;
+        return it->sym->size == 0 || a - it->addr < it->sym->size ? it->sym->name.c_str() : "?";
+    }
+
+  private:
+    struct Function {
+        uint64_t addr;
+        const ElfSymbol *sym;
+    };
+    std::unordered_map<uint64_t, const std::string *> at_;
+    std::vector<Function> functions_;
+};
+
+}  // namespace common
@@ -0,0 +1,209 @@
+/*
+ *   Pointer-sized views of ELF data sections, for scanners that look for
+ *   statically initialized tables of pointers (JNINativeMethod arrays,
+ *   Curl_handler structures, ...).
+ *
+ *   data_words() returns a section as an array of words with the dynamic
+ *   relocations applied, so PIC objects read as if loaded at address 0.
+ *   classify_ranges() marks in two bitmaps which words point into two
+ *   address ranges, four words per instruction with AVX2 (two with NEON);
+ *   a table layout then becomes a handful of shifted bitmap ANDs
+ *   (mask_at), and only the surviving positions are decoded.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "common/elf.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COMMON_WORDS_AVX2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define COMMON_WORDS_NEON 1
+#endif
+
+
+namespace common {
+
+// [lo, hi) of virtual addresses.
+struct Range {
+    uint64_t lo = ~uint64_t(0);
+    uint64_t hi = 0;
+
+    void add(uint64_t a, uint64_t n) {
+        lo = std::min(lo, a);
+        hi = std::max(hi, a + n);
+    }
+    bool contains(uint64_t a) const { return a >= lo && a < hi; }
+    bool empty() const { return lo >= hi; }
+};
+
+// Hull of the executable sections and of the read-only data sections.
+struct ImageRanges {
+    Range code;
+    Range rodata;
+
+    explicit ImageRanges(const ElfFile &elf) {
+        for (const ElfSection &s : elf.sections()) {
+            if (!s.alloc() || s.nobits() || s.size == 0) {
+                continue;
+            }
+            if (s.exec()) {
+                code.add(s.addr, s.size);
+            } else if (!s.write() && s.type == 1 /* SHT_PROGBITS */) {
+                rodata.add(s.addr, s.size);
+            }
+        }
+    }
+};
+
+// A data section from its first pointer-aligned address on.
+struct DataWords {
+    uint64_t base = 0;
+    unsigned width = 8;
+    std::vector<uint64_t> w;
+
+    uint64_t addr(size_t i) const { return base + i * uint64_t(width); }
+};
+
+namespace detail {
+
+inline bool host_little() {
+    const uint16_t one = 1;
+    uint8_t b;
+    std::memcpy(&b, &one, 1);
+    return b == 1;
+}
+
+// Sets the mask bits of w[i, n).
+inline void ranges_scalar(const uint64_t *w, size_t i, size_t n, const Range &a, const Range &b, uint64_t *ma,
+                          uint64_t *mb) {
+    for (; i < n; i++) {
+        ma[i >> 6] |= uint64_t(w[i] - a.lo < a.hi - a.lo) << (i & 63);
+        mb[i >> 6] |= uint64_t(w[i] - b.lo < b.hi - b.lo) << (i & 63);
+    }
+}
+
+#if COMMON_WORDS_AVX2
+// Unsigned x - lo < span as a signed compare with the sign bits flipped.
+__attribute__((target("avx2"))) inline void ranges_avx2(const uint64_t *w, size_t n, const Range &a,
+                                                        const Range &b, uint64_t *ma, uint64_t *mb) {
+    const __m256i sign = _mm256_set1_epi64x(int64_t(uint64_t(1) << 63));
+    const __m256i alo = _mm256_set1_epi64x(int64_t(a.lo));
+    const __m256i blo = _mm256_set1_epi64x(int64_t(b.lo));
+    const __m256i aspan = _mm256_xor_si256(_mm256_set1_epi64x(int64_t(a.hi - a.lo)), sign);
+    const __m256i bspan = _mm256_xor_si256(_mm256_set1_epi64x(int64_t(b.hi - b.lo)), sign);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(w + i));
+        __m256i da = _mm256_xor_si256(_mm256_sub_epi64(v, alo), sign);
+        __m256i db = _mm256_xor_si256(_mm256_sub_epi64(v, blo), sign);
+        uint64_t ka = unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(aspan, da))));
+        uint64_t kb = unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(bspan, db))));
+        // i is a multiple of 4, so the four bits never straddle a mask word
+        ma[i >> 6] |= ka << (i & 63);
+        mb[i >> 6] |= kb << (i & 63);
+    }
+    ranges_scalar(w, i, n, a, b, ma, mb);
+}
+
+inline bool have_avx2() {
+    static const bool yes = __builtin_cpu_supports("avx2");
+    return yes;
+}
+#endif
+
+#if COMMON_WORDS_NEON
+inline void ranges_neon(const uint64_t *w, size_t n, const Range &a, const Range &b, uint64_t *ma, uint64_t *mb) {
+    const uint64x2_t alo = vdupq_n_u64(a.lo), aspan = vdupq_n_u64(a.hi - a.lo);
+    const uint64x2_t blo = vdupq_n_u64(b.lo), bspan = vdupq_n_u64(b.hi - b.lo);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        uint64x2_t v = vld1q_u64(w + i);
+        uint64x2_t ka = vcltq_u64(vsubq_u64(v, alo), aspan);
+        uint64x2_t kb = vcltq_u64(vsubq_u64(v, blo), bspan);
+        ma[i >> 6] |= ((vgetq_lane_u64(ka, 0) & 1) | (vgetq_lane_u64(ka, 1) & 2)) << (i & 63);
+        mb[i >> 6] |= ((vgetq_lane_u64(kb, 0) & 1) | (vgetq_lane_u64(kb, 1) & 2)) << (i & 63);
+    }
+    ranges_scalar(w, i, n, a, b, ma, mb);
+}
+#endif
+
+}  // namespace detail
+
+// Number of mask words for n words, with one spare so that mask_at can
+// read past the end.
+inline size_t mask_words(size_t n) { return (n + 63) / 64 + 1; }
+
+// Sets bit i of in_a / in_b when w[i] lies in a / b. The masks must hold
+// mask_words(n) zeroed words.
+inline void classify_ranges(const uint64_t *w, size_t n, const Range &a, const Range &b, uint64_t *in_a,
+                            uint64_t *in_b) {
+#if COMMON_WORDS_AVX2
+    if (detail::have_avx2()) {
+        detail::ranges_avx2(w, n, a, b, in_a, in_b);
+        return;
+    }
+#elif COMMON_WORDS_NEON
+    detail::ranges_neon(w, n, a, b, in_a, in_b);
+    return;
+#endif
+    detail::ranges_scalar(w, 0, n, a, b, in_a, in_b);
+}
+
+// Bits [64k, 64k + 64) of the mask shifted down by 'by' words (< 64), i.e.
+// bit j says whether word 64k + j + by is marked.
+inline uint64_t mask_at(const std::vector<uint64_t> &m, size_t k, unsigned by) {
+    return by ? (m[k] >> by) | (m[k + 1] << (64 - by)) : m[k];
+}
+
+// Section contents as pointer-sized words with the relative and absolute
+// dynamic relocations applied ('relocs' from ElfFile::dynamic_relocations).
+inline DataWords data_words(const ElfFile &elf, const ElfSection &s, const std::vector<ElfRelocation> &relocs) {
+    DataWords d;
+    unsigned ptr = elf.pointer_size();
+    const uint8_t *p = elf.section_data(s);
+    uint64_t skip = (ptr - s.addr % ptr) % ptr;
+    size_t n = p && s.size > skip ? (s.size - skip) / ptr : 0;
+    d.width = ptr;
+    d.base = s.addr + skip;
+    d.w.resize(n);
+    if (n == 0) {
+        return d;
+    }
+    p += skip;
+    if (ptr == 8 && elf.little_endian() && detail::host_little()) {
+        std::memcpy(d.w.data(), p, n * 8);
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            d.w[i] = elf.decode(p + i * ptr, ptr);
+        }
+    }
+    uint32_t relative = relative_reloc_type(elf.machine());
+    uint32_t absolute = absolute_reloc_type(elf.machine());
+    for (const ElfRelocation &r : relocs) {
+        if (r.offset < d.base || r.offset - d.base >= n * ptr || (r.offset - d.base) % ptr) {
+            continue;
+        }
+        uint64_t &v = d.w[(r.offset - d.base) / ptr];
+        if (r.type == relative && relative) {
+            v = r.rela ? uint64_t(r.addend) : v;
+        } else if (r.type == absolute && absolute && r.sym_defined) {
+            v = r.sym_value + (r.rela ? uint64_t(r.addend) : v);
+        } else {
+            continue;
+        }
+        if (ptr == 4) {
+            v &= 0xffffffff;
+        }
+    }
+    return d;
+}
+
+}  // namespace common
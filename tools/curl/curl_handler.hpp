@@ -0,0 +1,240 @@
+/*
+ *   Static Curl_handler tables (lib/urldata.h) in linked binaries.
+ *
+ *   Every protocol libcurl is built with has one const Curl_handler:
+ *
+ *     { "HTTPS", http_setup_conn, Curl_http, Curl_http_done, ZERO_NULL,
+ *       Curl_http_connect, https_connecting, ZERO_NULL, https_getsock, ...,
+ *       PORT_HTTPS, CURLPROTO_HTTPS, CURLPROTO_HTTP, PROTOPT_SSL | ... }
+ *
+ *   The member list and its types come from libcurl.gdt (HandlerLayout),
+ *   laid out again for each pointer width since the archive was built from
+ *   64-bit DWARF. A handler starts with a pointer to the scheme string, its
+ *   callbacks point into code or are NULL, 'protocol' is one CURLPROTO_* bit
+ *   and 'defport' a port number; the pointer members are checked for all
+ *   positions of a data section at once with bitmaps (common/words.hpp) and
+ *   only survivors have their scheme string and integers read.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "common/elf.hpp"
+#include "common/words.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace curl {
+
+enum class FieldKind {
+    STRING,    // char *
+    CODE,      // pointer to a function definition
+    POINTER,   // any other pointer
+    INTEGER,
+    OTHER,
+};
+
+struct HandlerField {
+    std::string name;
+    uint64_t offset;
+    uint64_t size;
+    FieldKind kind;
+    std::string signature;  // function declaration for CODE members
+};
+
+struct HandlerLayout {
+    std::string name;  // "Curl_handler"
+    unsigned pointer_size = 0;
+    uint64_t size = 0;
+    std::vector<HandlerField> fields;
+    int scheme = -1, defport = -1, protocol = -1;  // indexes into fields
+
+    // Layout of structure 'name' for the given pointer width.
+    static HandlerLayout from_archive(const gdt::Archive &a, const std::string &name, unsigned pointer_size) {
+        const gdt::DataType *s = a.find(name);
+        if (!s || s->table() != gdt::T_COMPOSITE) {
+            throw std::runtime_error("no structure named " + name);
+        }
+        gdt::DataOrganization org = gdt::DataOrganization::for_pointer_size(pointer_size);
+        org.relayout = true;
+        gdt::TypeLayout l = a.layout(s->id, org);
+        HandlerLayout h;
+        h.name = name;
+        h.pointer_size = pointer_size;
+        h.size = l.size;
+        for (size_t i = 0; i < s->components.size(); i++) {
+            const gdt::Component &c = s->components[i];
+            HandlerField f{c.name, l.offsets[i], a.layout(c.type, org).size, FieldKind::OTHER, {}};
+            const gdt::DataType *t = a.get(a.resolve(c.type));
+            const gdt::DataType *to = t && t->table() == gdt::T_POINTER ? a.get(a.resolve(t->target)) : nullptr;
+            if (to && to->table() == gdt::T_FUNCDEF) {
+                f.kind = FieldKind::CODE;
+                f.signature = a.decl(to->id, c.name);
+            } else if (to && to->name == "char") {
+                f.kind = FieldKind::STRING;
+            } else if (t && t->table() == gdt::T_POINTER) {
+                f.kind = FieldKind::POINTER;
+            } else if (t && (t->table() == gdt::T_BUILTIN || t->table() == gdt::T_ENUM) && f.size >= 1 &&
+                       f.size <= 8) {
+                f.kind = FieldKind::INTEGER;
+            }
+            if (f.kind == FieldKind::STRING && h.scheme < 0) {
+                h.scheme = static_cast<int>(h.fields.size());
+            } else if (f.kind == FieldKind::INTEGER && c.name == "defport") {
+                h.defport = static_cast<int>(h.fields.size());
+            } else if (f.kind == FieldKind::INTEGER && c.name == "protocol") {
+                h.protocol = static_cast<int>(h.fields.size());
+            }
+            h.fields.push_back(std::move(f));
+        }
+        if (h.scheme < 0 || h.fields[h.scheme].offset % pointer_size) {
+            throw std::runtime_error(name + " has no scheme string member");
+        }
+        if (h.size / pointer_size >= 64) {
+            throw std::runtime_error(name + " is too large for the word filter");
+        }
+        return h;
+    }
+};
+
+struct Handler {
+    uint64_t addr;
+    std::string scheme;
+    int64_t defport = -1;
+    uint64_t protocol = 0;
+    std::vector<uint64_t> values;  // per field: pointer value (Thumb bit cleared) or integer
+};
+
+class HandlerScanner {
+  public:
+    HandlerScanner(const HandlerLayout &layout, const common::ElfFile &elf)
+        : l_(layout), elf_(elf), ranges_(elf), ptr_(elf.pointer_size()) {
+        if (layout.pointer_size != ptr_) {
+            throw std::logic_error("handler layout does not match the pointer width");
+        }
+    }
+
+    std::vector<Handler> scan() const {
+        std::vector<Handler> out;
+        if (ranges_.code.empty() || ranges_.rodata.empty()) {
+            return out;
+        }
+        std::vector<common::ElfRelocation> relocs = elf_.dynamic_relocations();
+        for (const common::ElfSection &s : elf_.sections()) {
+            if (s.alloc() && !s.exec() && s.type == 1 && s.size >= l_.size) {
+                scan_section(s, relocs, out);
+            }
+        }
+        return out;
+    }
+
+  private:
+    void scan_section(const common::ElfSection &s, const std::vector<common::ElfRelocation> &relocs,
+                      std::vector<Handler> &out) const {
+        common::DataWords d = common::data_words(elf_, s, relocs);
+        size_t n = d.w.size();
+        size_t words = (l_.size + ptr_ - 1) / ptr_;
+        std::vector<uint64_t> in_ro(common::mask_words(n)), in_code(common::mask_words(n));
+        std::vector<uint64_t> null(common::mask_words(n)), unused(common::mask_words(n));
+        common::classify_ranges(d.w.data(), n, ranges_.rodata, ranges_.code, in_ro.data(), in_code.data());
+        common::Range zero;
+        zero.add(0, 1);
+        common::classify_ranges(d.w.data(), n, zero, zero, null.data(), unused.data());
+
+        unsigned scheme = unsigned(l_.fields[l_.scheme].offset / ptr_);
+        for (size_t k = 0; k + 1 < in_ro.size(); k++) {
+            uint64_t cand = common::mask_at(in_ro, k, scheme);
+            uint64_t any_code = 0;
+            for (const HandlerField &f : l_.fields) {
+                if (f.kind == FieldKind::CODE && cand) {
+                    unsigned at = unsigned(f.offset / ptr_);
+                    uint64_t code = common::mask_at(in_code, k, at);
+                    cand &= code | common::mask_at(null, k, at);
+                    any_code |= code;
+                }
+            }
+            cand &= any_code;
+            while (cand) {
+                size_t i = k * 64 + static_cast<size_t>(__builtin_ctzll(cand));
+                cand &= cand - 1;
+                Handler h;
+                if (i + words <= n && decode(d, i, h)) {
+                    out.push_back(std::move(h));
+                }
+            }
+        }
+    }
+
+    bool decode(const common::DataWords &d, size_t i, Handler &h) const {
+        h.addr = d.addr(i);
+        const uint8_t *raw = elf_.at_vaddr(h.addr, l_.size);
+        if (!raw) {
+            return false;
+        }
+        for (const HandlerField &f : l_.fields) {
+            uint64_t v = 0;
+            if (f.kind == FieldKind::STRING || f.kind == FieldKind::CODE || f.kind == FieldKind::POINTER) {
+                v = f.offset % ptr_ == 0 ? d.w[i + f.offset / ptr_] : 0;
+            } else if (f.kind == FieldKind::INTEGER) {
+                v = elf_.decode(raw + f.offset, unsigned(f.size));
+            }
+            if (f.kind == FieldKind::CODE && v) {
+                v = elf_.machine() == common::EM_ARM ? v & ~uint64_t(1) : v;
+                if (!in_code_section(v)) {
+                    return false;
+                }
+            }
+            h.values.push_back(v);
+        }
+        h.scheme = elf_.cstring_at(h.values[l_.scheme], 32);
+        if (!scheme_name(h.scheme)) {
+            return false;
+        }
+        if (l_.protocol >= 0) {
+            h.protocol = h.values[l_.protocol];
+            if (h.protocol == 0 || (h.protocol & (h.protocol - 1))) {
+                return false;
+            }
+        }
+        if (l_.defport >= 0) {
+            if (h.values[l_.defport] > 65535) {
+                return false;
+            }
+            h.defport = int64_t(h.values[l_.defport]);
+        }
+        return true;
+    }
+
+    // "HTTPS", "POP3", "RTMPTE", ...
+    static bool scheme_name(const std::string &s) {
+        if (s.empty() || s.size() > 16 || !(s[0] >= 'A' && s[0] <= 'Z')) {
+            return false;
+        }
+        for (char c : s) {
+            if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool in_code_section(uint64_t a) const {
+        for (const common::ElfSection &s : elf_.sections()) {
+            if (s.alloc() && s.exec() && a >= s.addr && a - s.addr < s.size) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const HandlerLayout &l_;
+    const common::ElfFile &elf_;
+    common::ImageRanges ranges_;
+    unsigned ptr_;
+};
+
+}  // namespace curl
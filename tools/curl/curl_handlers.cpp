@@ -0,0 +1,167 @@
+/*
+ *   curl_handlers: find the static Curl_handler tables of libcurl in the
+ *   executables and libraries of a firmware image and name every protocol
+ *   callback.
+ *
+ *   The structure is taken from a .gdt archive (gdt/libcurl.gdt) and laid
+ *   out once per pointer width before the files are scanned in parallel;
+ *   each file is searched with the layout of its width
+ *   (curl::HandlerScanner). Output, one line per non-NULL callback:
+ *
+ *     file  handler  scheme  member  address  symbol  signature
+ *
+ *   or with --tables one line per handler:
+ *
+ *     file  handler  scheme  defport  protocol  symbol
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/curl/curl_handlers.cpp -o curl_handlers
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/elf.hpp"
+#include "common/files.hpp"
+#include "common/mapped_file.hpp"
+#include "common/parallel.hpp"
+#include "curl/curl_handler.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace {
+
+struct Options {
+    std::string structure = "Curl_handler";
+    bool tables = false;
+    unsigned jobs = common::default_jobs();
+    std::string archive;
+    std::vector<std::string> paths;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: curl_handlers [options] libcurl.gdt path...\n"
+                 "  --struct NAME  handler structure in the archive (default Curl_handler)\n"
+                 "  --tables       one line per handler instead of one per callback\n"
+                 "  -j N           number of files scanned in parallel\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--struct") {
+            o.structure = next();
+        } else if (a == "--tables") {
+            o.tables = true;
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (o.archive.empty()) {
+            o.archive = a;
+        } else {
+            o.paths.push_back(a);
+        }
+    }
+    if (o.archive.empty() || o.paths.empty()) {
+        usage();
+    }
+    return o;
+}
+
+std::unordered_map<uint64_t, const std::string *> symbols_by_address(const common::ElfFile &elf) {
+    std::unordered_map<uint64_t, const std::string *> m;
+    for (const common::ElfSymbol &s : elf.symbols()) {
+        if (s.defined() && !s.name.empty() && (s.type == 1 /* STT_OBJECT */ || s.function())) {
+            uint64_t a = s.function() && elf.machine() == common::EM_ARM ? s.value & ~uint64_t(1) : s.value;
+            m.emplace(a, &s.name);
+        }
+    }
+    return m;
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    curl::HandlerLayout layouts[2];
+    try {
+        gdt::Archive a(opt.archive);
+        layouts[0] = curl::HandlerLayout::from_archive(a, opt.structure, 4);
+        layouts[1] = curl::HandlerLayout::from_archive(a, opt.structure, 8);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "curl_handlers: %s: %s\n", opt.archive.c_str(), e.what());
+        return 1;
+    }
+
+    std::vector<std::string> files = common::collect_files(opt.paths, "curl_handlers");
+    std::vector<std::string> text(files.size());
+    std::mutex lock;
+    int status = 0;
+
+    common::parallel_for(files.size(), opt.jobs, [&](size_t i) {
+        std::ostringstream o;
+        try {
+            common::MappedFile f(files[i]);
+            if (!common::ElfFile::is_elf(f.data(), f.size())) {
+                return;
+            }
+            common::ElfFile elf(f.data(), f.size());
+            const curl::HandlerLayout &l = layouts[elf.pointer_size() == 8];
+            std::vector<curl::Handler> handlers = curl::HandlerScanner(l, elf).scan();
+            if (handlers.empty()) {
+                return;
+            }
+            auto syms = symbols_by_address(elf);
+            auto name = [&](uint64_t a) {
+                auto it = syms.find(a);
+                return it == syms.end() ? "?" : it->second->c_str();
+            };
+            char addr[32], line[96];
+            for (const curl::Handler &h : handlers) {
+                std::snprintf(addr, sizeof addr, "\t0x%08" PRIx64 "\t", h.addr);
+                if (opt.tables) {
+                    std::snprintf(line, sizeof line, "\t%" PRId64 "\t0x%" PRIx64 "\t", h.defport, h.protocol);
+                    o << files[i] << addr << h.scheme << line << name(h.addr) << '\n';
+                    continue;
+                }
+                for (size_t k = 0; k < l.fields.size(); k++) {
+                    if (l.fields[k].kind != curl::FieldKind::CODE || h.values[k] == 0) {
+                        continue;
+                    }
+                    std::snprintf(line, sizeof line, "\t0x%08" PRIx64 "\t", h.values[k]);
+                    o << files[i] << addr << h.scheme << '\t' << l.fields[k].name << line << name(h.values[k])
+                      << '\t' << l.fields[k].signature << '\n';
+                }
+            }
+        } catch (const std::exception &e) {
+            std::lock_guard<std::mutex> g(lock);
+            std::fprintf(stderr, "curl_handlers: %s: %s\n", files[i].c_str(), e.what());
+            status = 1;
+            return;
+        }
+        std::lock_guard<std::mutex> g(lock);
+        text[i] = o.str();
+    });
+
+    for (const std::string &t : text) {
+        std::fwrite(t.data(), 1, t.size(), stdout);
+    }
+    return status;
+}
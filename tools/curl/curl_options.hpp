@@ -0,0 +1,496 @@
+/*
+ *   CURLoption ids decoded with a .gdt archive of libcurl.
+ *
+ *   curl.h numbers every option as CURLOPTTYPE_<type> + n, the type base
+ *   saying what curl_easy_setopt's third argument is:
+ *
+ *     CURLOPT_WRITEFUNCTION = CURLOPTTYPE_FUNCTIONPOINT + 11
+ *     CURLOPT_URL           = CURLOPTTYPE_STRINGPOINT + 2
+ *
+ *   The type bases and the callback signatures come from the archive
+ *   (define_CURLOPTTYPE_*, curl_write_callback, ...). Archives made from
+ *   DWARF do not list the option names (CURLoption is only ever used as a
+ *   parameter type, so its enumerators are not emitted), hence the names and
+ *   numbers of curl 7.69 are built in below; CURLOPT_* enumerators the
+ *   archive does have take precedence. OptionTable is built once and only
+ *   read afterwards, so one table can be shared by all scanning threads.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gdt/gdt_types.hpp"
+
+
+namespace curl {
+
+enum class OptionType {
+    LONG,
+    OBJECTPOINT,    // void * passed back to callbacks, buffers, handles
+    STRINGPOINT,    // char *, copied by libcurl
+    SLISTPOINT,     // struct curl_slist *
+    FUNCTIONPOINT,  // callback
+    OFF_T,          // curl_off_t
+};
+
+inline const char *type_name(OptionType t) {
+    switch (t) {
+    case OptionType::LONG: return "LONG";
+    case OptionType::OBJECTPOINT: return "OBJECTPOINT";
+    case OptionType::STRINGPOINT: return "STRINGPOINT";
+    case OptionType::SLISTPOINT: return "SLISTPOINT";
+    case OptionType::FUNCTIONPOINT: return "FUNCTIONPOINT";
+    case OptionType::OFF_T: return "OFF_T";
+    }
+    return "?";
+}
+
+struct OptionInfo {
+    uint64_t id = 0;
+    std::string name;       // "CURLOPT_WRITEFUNCTION"
+    OptionType type = OptionType::LONG;
+    std::string argument;   // C declaration of the argument: "long", "char *",
+                            // "size_t CURLOPT_WRITEFUNCTION(char *buffer, ...)"
+    std::string family;     // constant family naming LONG values ("CURLAUTH")
+};
+
+namespace detail {
+
+// Option number, type (L long, O object, S string, P slist, F function,
+// T off_t), name without CURLOPT_, and the callback typedef or the constant
+// family of the value.
+struct KnownOption {
+    uint16_t number;
+    char type;
+    const char *name;
+    const char *extra;
+};
+
+inline const std::vector<KnownOption> &known_options() {
+    static const std::vector<KnownOption> all = {
+        {1, 'O', "WRITEDATA", ""},
+        {2, 'S', "URL", ""},
+        {3, 'L', "PORT", ""},
+        {4, 'S', "PROXY", ""},
+        {5, 'S', "USERPWD", ""},
+        {6, 'S', "PROXYUSERPWD", ""},
+        {7, 'S', "RANGE", ""},
+        {9, 'O', "READDATA", ""},
+        {10, 'O', "ERRORBUFFER", ""},
+        {11, 'F', "WRITEFUNCTION", "curl_write_callback"},
+        {12, 'F', "READFUNCTION", "curl_read_callback"},
+        {13, 'L', "TIMEOUT", ""},
+        {14, 'L', "INFILESIZE", ""},
+        {15, 'O', "POSTFIELDS", ""},
+        {16, 'S', "REFERER", ""},
+        {17, 'S', "FTPPORT", ""},
+        {18, 'S', "USERAGENT", ""},
+        {19, 'L', "LOW_SPEED_LIMIT", ""},
+        {20, 'L', "LOW_SPEED_TIME", ""},
+        {21, 'L', "RESUME_FROM", ""},
+        {22, 'S', "COOKIE", ""},
+        {23, 'P', "HTTPHEADER", ""},
+        {24, 'O', "HTTPPOST", ""},
+        {25, 'S', "SSLCERT", ""},
+        {26, 'S', "KEYPASSWD", ""},
+        {27, 'L', "CRLF", ""},
+        {28, 'P', "QUOTE", ""},
+        {29, 'O', "HEADERDATA", ""},
+        {31, 'S', "COOKIEFILE", ""},
+        {32, 'L', "SSLVERSION", ""},
+        {33, 'L', "TIMECONDITION", "curl_TimeCond"},
+        {34, 'L', "TIMEVALUE", ""},
+        {36, 'S', "CUSTOMREQUEST", ""},
+        {37, 'O', "STDERR", ""},
+        {39, 'P', "POSTQUOTE", ""},
+        {41, 'L', "VERBOSE", ""},
+        {42, 'L', "HEADER", ""},
+        {43, 'L', "NOPROGRESS", ""},
+        {44, 'L', "NOBODY", ""},
+        {45, 'L', "FAILONERROR", ""},
+        {46, 'L', "UPLOAD", ""},
+        {47, 'L', "POST", ""},
+        {48, 'L', "DIRLISTONLY", ""},
+        {50, 'L', "APPEND", ""},
+        {51, 'L', "NETRC", "CURL_NETRC_OPTION"},
+        {52, 'L', "FOLLOWLOCATION", ""},
+        {53, 'L', "TRANSFERTEXT", ""},
+        {54, 'L', "PUT", ""},
+        {56, 'F', "PROGRESSFUNCTION", "curl_progress_callback"},
+        {57, 'O', "XFERINFODATA", ""},
+        {58, 'L', "AUTOREFERER", ""},
+        {59, 'L', "PROXYPORT", ""},
+        {60, 'L', "POSTFIELDSIZE", ""},
+        {61, 'L', "HTTPPROXYTUNNEL", ""},
+        {62, 'S', "INTERFACE", ""},
+        {63, 'S', "KRBLEVEL", ""},
+        {64, 'L', "SSL_VERIFYPEER", ""},
+        {65, 'S', "CAINFO", ""},
+        {68, 'L', "MAXREDIRS", ""},
+        {69, 'L', "FILETIME", ""},
+        {70, 'P', "TELNETOPTIONS", ""},
+        {71, 'L', "MAXCONNECTS", ""},
+        {74, 'L', "FRESH_CONNECT", ""},
+        {75, 'L', "FORBID_REUSE", ""},
+        {76, 'S', "RANDOM_FILE", ""},
+        {77, 'S', "EGDSOCKET", ""},
+        {78, 'L', "CONNECTTIMEOUT", ""},
+        {79, 'F', "HEADERFUNCTION", "curl_write_callback"},
+        {80, 'L', "HTTPGET", ""},
+        {81, 'L', "SSL_VERIFYHOST", ""},
+        {82, 'S', "COOKIEJAR", ""},
+        {83, 'S', "SSL_CIPHER_LIST", ""},
+        {84, 'L', "HTTP_VERSION", ""},
+        {85, 'L', "FTP_USE_EPSV", ""},
+        {86, 'S', "SSLCERTTYPE", ""},
+        {87, 'S', "SSLKEY", ""},
+        {88, 'S', "SSLKEYTYPE", ""},
+        {89, 'S', "SSLENGINE", ""},
+        {90, 'L', "SSLENGINE_DEFAULT", ""},
+        {91, 'L', "DNS_USE_GLOBAL_CACHE", ""},
+        {92, 'L', "DNS_CACHE_TIMEOUT", ""},
+        {93, 'P', "PREQUOTE", ""},
+        {94, 'F', "DEBUGFUNCTION", "curl_debug_callback"},
+        {95, 'O', "DEBUGDATA", ""},
+        {96, 'L', "COOKIESESSION", ""},
+        {97, 'S', "CAPATH", ""},
+        {98, 'L', "BUFFERSIZE", ""},
+        {99, 'L', "NOSIGNAL", ""},
+        {100, 'O', "SHARE", ""},
+        {101, 'L', "PROXYTYPE", "curl_proxytype"},
+        {102, 'S', "ACCEPT_ENCODING", ""},
+        {103, 'O', "PRIVATE", ""},
+        {104, 'P', "HTTP200ALIASES", ""},
+        {105, 'L', "UNRESTRICTED_AUTH", ""},
+        {106, 'L', "FTP_USE_EPRT", ""},
+        {107, 'L', "HTTPAUTH", "CURLAUTH"},
+        {108, 'F', "SSL_CTX_FUNCTION", "curl_ssl_ctx_callback"},
+        {109, 'O', "SSL_CTX_DATA", ""},
+        {110, 'L', "FTP_CREATE_MISSING_DIRS", ""},
+        {111, 'L', "PROXYAUTH", "CURLAUTH"},
+        {112, 'L', "FTP_RESPONSE_TIMEOUT", ""},
+        {113, 'L', "IPRESOLVE", "CURL_IPRESOLVE"},
+        {114, 'L', "MAXFILESIZE", ""},
+        {115, 'T', "INFILESIZE_LARGE", ""},
+        {116, 'T', "RESUME_FROM_LARGE", ""},
+        {117, 'T', "MAXFILESIZE_LARGE", ""},
+        {118, 'S', "NETRC_FILE", ""},
+        {119, 'L', "USE_SSL", "curl_usessl"},
+        {120, 'T', "POSTFIELDSIZE_LARGE", ""},
+        {121, 'L', "TCP_NODELAY", ""},
+        {129, 'L', "FTPSSLAUTH", "curl_ftpauth"},
+        {130, 'F', "IOCTLFUNCTION", "curl_ioctl_callback"},
+        {131, 'O', "IOCTLDATA", ""},
+        {134, 'S', "FTP_ACCOUNT", ""},
+        {135, 'S', "COOKIELIST", ""},
+        {136, 'L', "IGNORE_CONTENT_LENGTH", ""},
+        {137, 'L', "FTP_SKIP_PASV_IP", ""},
+        {138, 'L', "FTP_FILEMETHOD", "curl_ftpfile"},
+        {139, 'L', "LOCALPORT", ""},
+        {140, 'L', "LOCALPORTRANGE", ""},
+        {141, 'L', "CONNECT_ONLY", ""},
+        {142, 'F', "CONV_FROM_NETWORK_FUNCTION", "curl_conv_callback"},
+        {143, 'F', "CONV_TO_NETWORK_FUNCTION", "curl_conv_callback"},
+        {144, 'F', "CONV_FROM_UTF8_FUNCTION", "curl_conv_callback"},
+        {145, 'T', "MAX_SEND_SPEED_LARGE", ""},
+        {146, 'T', "MAX_RECV_SPEED_LARGE", ""},
+        {147, 'S', "FTP_ALTERNATIVE_TO_USER", ""},
+        {148, 'F', "SOCKOPTFUNCTION", "curl_sockopt_callback"},
+        {149, 'O', "SOCKOPTDATA", ""},
+        {150, 'L', "SSL_SESSIONID_CACHE", ""},
+        {151, 'L', "SSH_AUTH_TYPES", "CURLSSH_AUTH"},
+        {152, 'S', "SSH_PUBLIC_KEYFILE", ""},
+        {153, 'S', "SSH_PRIVATE_KEYFILE", ""},
+        {154, 'L', "FTP_SSL_CCC", "curl_ftpccc"},
+        {155, 'L', "TIMEOUT_MS", ""},
+        {156, 'L', "CONNECTTIMEOUT_MS", ""},
+        {157, 'L', "HTTP_TRANSFER_DECODING", ""},
+        {158, 'L', "HTTP_CONTENT_DECODING", ""},
+        {159, 'L', "NEW_FILE_PERMS", ""},
+        {160, 'L', "NEW_DIRECTORY_PERMS", ""},
+        {161, 'L', "POSTREDIR", "CURL_REDIR"},
+        {162, 'S', "SSH_HOST_PUBLIC_KEY_MD5", ""},
+        {163, 'F', "OPENSOCKETFUNCTION", "curl_opensocket_callback"},
+        {164, 'O', "OPENSOCKETDATA", ""},
+        {165, 'O', "COPYPOSTFIELDS", ""},
+        {166, 'L', "PROXY_TRANSFER_MODE", ""},
+        {167, 'F', "SEEKFUNCTION", "curl_seek_callback"},
+        {168, 'O', "SEEKDATA", ""},
+        {169, 'S', "CRLFILE", ""},
+        {170, 'S', "ISSUERCERT", ""},
+        {171, 'L', "ADDRESS_SCOPE", ""},
+        {172, 'L', "CERTINFO", ""},
+        {173, 'S', "USERNAME", ""},
+        {174, 'S', "PASSWORD", ""},
+        {175, 'S', "PROXYUSERNAME", ""},
+        {176, 'S', "PROXYPASSWORD", ""},
+        {177, 'S', "NOPROXY", ""},
+        {178, 'L', "TFTP_BLKSIZE", ""},
+        {179, 'S', "SOCKS5_GSSAPI_SERVICE", ""},
+        {180, 'L', "SOCKS5_GSSAPI_NEC", ""},
+        {181, 'L', "PROTOCOLS", "CURLPROTO"},
+        {182, 'L', "REDIR_PROTOCOLS", "CURLPROTO"},
+        {183, 'S', "SSH_KNOWNHOSTS", ""},
+        {184, 'F', "SSH_KEYFUNCTION", "curl_sshkeycallback"},
+        {185, 'O', "SSH_KEYDATA", ""},
+        {186, 'S', "MAIL_FROM", ""},
+        {187, 'P', "MAIL_RCPT", ""},
+        {188, 'L', "FTP_USE_PRET", ""},
+        {189, 'L', "RTSP_REQUEST", ""},
+        {190, 'S', "RTSP_SESSION_ID", ""},
+        {191, 'S', "RTSP_STREAM_URI", ""},
+        {192, 'S', "RTSP_TRANSPORT", ""},
+        {193, 'L', "RTSP_CLIENT_CSEQ", ""},
+        {194, 'L', "RTSP_SERVER_CSEQ", ""},
+        {195, 'O', "INTERLEAVEDATA", ""},
+        {196, 'F', "INTERLEAVEFUNCTION", "curl_write_callback"},
+        {197, 'L', "WILDCARDMATCH", ""},
+        {198, 'F', "CHUNK_BGN_FUNCTION", "curl_chunk_bgn_callback"},
+        {199, 'F', "CHUNK_END_FUNCTION", "curl_chunk_end_callback"},
+        {200, 'F', "FNMATCH_FUNCTION", "curl_fnmatch_callback"},
+        {201, 'O', "CHUNK_DATA", ""},
+        {202, 'O', "FNMATCH_DATA", ""},
+        {203, 'P', "RESOLVE", ""},
+        {204, 'S', "TLSAUTH_USERNAME", ""},
+        {205, 'S', "TLSAUTH_PASSWORD", ""},
+        {206, 'S', "TLSAUTH_TYPE", ""},
+        {207, 'L', "TRANSFER_ENCODING", ""},
+        {208, 'F', "CLOSESOCKETFUNCTION", "curl_closesocket_callback"},
+        {209, 'O', "CLOSESOCKETDATA", ""},
+        {210, 'L', "GSSAPI_DELEGATION", "CURLGSSAPI_DELEGATION"},
+        {211, 'S', "DNS_SERVERS", ""},
+        {212, 'L', "ACCEPTTIMEOUT_MS", ""},
+        {213, 'L', "TCP_KEEPALIVE", ""},
+        {214, 'L', "TCP_KEEPIDLE", ""},
+        {215, 'L', "TCP_KEEPINTVL", ""},
+        {216, 'L', "SSL_OPTIONS", "CURLSSLOPT"},
+        {217, 'S', "MAIL_AUTH", ""},
+        {218, 'L', "SASL_IR", ""},
+        {219, 'F', "XFERINFOFUNCTION", "curl_xferinfo_callback"},
+        {220, 'S', "XOAUTH2_BEARER", ""},
+        {221, 'S', "DNS_INTERFACE", ""},
+        {222, 'S', "DNS_LOCAL_IP4", ""},
+        {223, 'S', "DNS_LOCAL_IP6", ""},
+        {224, 'S', "LOGIN_OPTIONS", ""},
+        {225, 'L', "SSL_ENABLE_NPN", ""},
+        {226, 'L', "SSL_ENABLE_ALPN", ""},
+        {227, 'L', "EXPECT_100_TIMEOUT_MS", ""},
+        {228, 'P', "PROXYHEADER", ""},
+        {229, 'L', "HEADEROPT", "CURLHEADER"},
+        {230, 'S', "PINNEDPUBLICKEY", ""},
+        {231, 'S', "UNIX_SOCKET_PATH", ""},
+        {232, 'L', "SSL_VERIFYSTATUS", ""},
+        {233, 'L', "SSL_FALSESTART", ""},
+        {234, 'L', "PATH_AS_IS", ""},
+        {235, 'S', "PROXY_SERVICE_NAME", ""},
+        {236, 'S', "SERVICE_NAME", ""},
+        {237, 'L', "PIPEWAIT", ""},
+        {238, 'S', "DEFAULT_PROTOCOL", ""},
+        {239, 'L', "STREAM_WEIGHT", ""},
+        {240, 'O', "STREAM_DEPENDS", ""},
+        {241, 'O', "STREAM_DEPENDS_E", ""},
+        {242, 'L', "TFTP_NO_OPTIONS", ""},
+        {243, 'P', "CONNECT_TO", ""},
+        {244, 'L', "TCP_FASTOPEN", ""},
+        {245, 'L', "KEEP_SENDING_ON_ERROR", ""},
+        {246, 'S', "PROXY_CAINFO", ""},
+        {247, 'S', "PROXY_CAPATH", ""},
+        {248, 'L', "PROXY_SSL_VERIFYPEER", ""},
+        {249, 'L', "PROXY_SSL_VERIFYHOST", ""},
+        {250, 'L', "PROXY_SSLVERSION", ""},
+        {251, 'S', "PROXY_TLSAUTH_USERNAME", ""},
+        {252, 'S', "PROXY_TLSAUTH_PASSWORD", ""},
+        {253, 'S', "PROXY_TLSAUTH_TYPE", ""},
+        {254, 'S', "PROXY_SSLCERT", ""},
+        {255, 'S', "PROXY_SSLCERTTYPE", ""},
+        {256, 'S', "PROXY_SSLKEY", ""},
+        {257, 'S', "PROXY_SSLKEYTYPE", ""},
+        {258, 'S', "PROXY_KEYPASSWD", ""},
+        {259, 'S', "PROXY_SSL_CIPHER_LIST", ""},
+        {260, 'S', "PROXY_CRLFILE", ""},
+        {261, 'L', "PROXY_SSL_OPTIONS", "CURLSSLOPT"},
+        {262, 'S', "PRE_PROXY", ""},
+        {263, 'S', "PROXY_PINNEDPUBLICKEY", ""},
+        {264, 'S', "ABSTRACT_UNIX_SOCKET", ""},
+        {265, 'L', "SUPPRESS_CONNECT_HEADERS", ""},
+        {266, 'S', "REQUEST_TARGET", ""},
+        {267, 'L', "SOCKS5_AUTH", "CURLAUTH"},
+        {268, 'L', "SSH_COMPRESSION", ""},
+        {269, 'O', "MIMEPOST", ""},
+        {270, 'T', "TIMEVALUE_LARGE", ""},
+        {271, 'L', "HAPPY_EYEBALLS_TIMEOUT_MS", ""},
+        {272, 'F', "RESOLVER_START_FUNCTION", "curl_resolver_start_callback"},
+        {273, 'O', "RESOLVER_START_DATA", ""},
+        {274, 'L', "HAPROXYPROTOCOL", ""},
+        {275, 'L', "DNS_SHUFFLE_ADDRESSES", ""},
+        {276, 'S', "TLS13_CIPHERS", ""},
+        {277, 'S', "PROXY_TLS13_CIPHERS", ""},
+        {278, 'L', "DISALLOW_USERNAME_IN_URL", ""},
+        {279, 'S', "DOH_URL", ""},
+        {280, 'L', "UPLOAD_BUFFERSIZE", ""},
+        {281, 'L', "UPKEEP_INTERVAL_MS", ""},
+        {282, 'O', "CURLU", ""},
+        {283, 'F', "TRAILERFUNCTION", "curl_trailer_callback"},
+        {284, 'O', "TRAILERDATA", ""},
+        {285, 'L', "HTTP09_ALLOWED", ""},
+        {286, 'L', "ALTSVC_CTRL", "CURLALTSVC"},
+        {287, 'S', "ALTSVC", ""},
+        {288, 'L', "MAXAGE_CONN", ""},
+        {289, 'S', "SASL_AUTHZID", ""},
+        {290, 'L', "MAIL_RCPT_ALLLOWFAILS", ""},
+    };
+    return all;
+}
+
+}  // namespace detail
+
+class OptionTable {
+  public:
+    explicit OptionTable(const gdt::Archive &a) {
+        const char *bases[] = {"LONG", "OBJECTPOINT", "STRINGPOINT", "SLISTPOINT", "FUNCTIONPOINT", "OFF_T"};
+        for (int t = 0; t < 6; t++) {
+            base_[t] = define_value(a, std::string("CURLOPTTYPE_") + bases[t]);
+        }
+        if (base_[0] < 0 || base_[1] < 0 || base_[4] < 0 || base_[5] < 0) {
+            throw std::runtime_error("archive has no CURLOPTTYPE_* constants");
+        }
+        // curl.h before 7.52 only had OBJECTPOINT for all pointers to data
+        for (int t : {2, 3}) {
+            base_[t] = base_[t] < 0 ? base_[1] : base_[t];
+        }
+        for (const detail::KnownOption &k : detail::known_options()) {
+            OptionType t = from_letter(k.type);
+            OptionInfo o;
+            o.id = uint64_t(base_[int(t)]) + k.number;
+            o.name = std::string("CURLOPT_") + k.name;
+            o.type = t;
+            if (t == OptionType::FUNCTIONPOINT) {
+                o.argument = callback(a, k.extra, o.name);
+            } else if (t == OptionType::LONG && *k.extra) {
+                o.family = k.extra;
+            }
+            options_.emplace(o.id, o);
+        }
+        // enumerators of CURLoption in archives that have them
+        for (const gdt::DataType *t : a.types()) {
+            if (t->table() != gdt::T_ENUM || t->name != "CURLoption") {
+                continue;
+            }
+            for (const gdt::EnumValue &v : t->values) {
+                if (v.name.compare(0, 8, "CURLOPT_") == 0 && v.name.compare(0, 12, "CURLOPTTYPE_") != 0 &&
+                    v.value > 0) {
+                    OptionInfo &o = options_[uint64_t(v.value)];
+                    if (o.name.empty()) {
+                        o.id = uint64_t(v.value);
+                        o.type = range_type(o.id);
+                    }
+                    o.name = v.name;
+                }
+            }
+        }
+        for (auto &kv : options_) {
+            if (kv.second.argument.empty()) {
+                kv.second.argument = argument(kv.second.type);
+            }
+        }
+    }
+
+    // Option with id 'id', or nullptr when the id names no known option.
+    const OptionInfo *find(uint64_t id) const {
+        auto it = options_.find(id);
+        return it == options_.end() ? nullptr : &it->second;
+    }
+
+    // Whether 'id' lies in the range of one of the option types at all.
+    bool plausible(uint64_t id) const {
+        for (int64_t b : base_) {
+            if (id > uint64_t(b) && id - uint64_t(b) < 10000) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Type of an unknown id by the range it falls into.
+    OptionType range_type(uint64_t id) const {
+        OptionType best = OptionType::LONG;
+        int64_t at = -1;
+        for (int t = 0; t < 6; t++) {
+            if (base_[t] > at && uint64_t(base_[t]) <= id && t != 2 && t != 3) {
+                at = base_[t];
+                best = OptionType(t);
+            }
+        }
+        return best;
+    }
+
+    size_t size() const { return options_.size(); }
+
+  private:
+    static OptionType from_letter(char c) {
+        switch (c) {
+        case 'O': return OptionType::OBJECTPOINT;
+        case 'S': return OptionType::STRINGPOINT;
+        case 'P': return OptionType::SLISTPOINT;
+        case 'F': return OptionType::FUNCTIONPOINT;
+        case 'T': return OptionType::OFF_T;
+        default: return OptionType::LONG;
+        }
+    }
+
+    static std::string argument(OptionType t) {
+        switch (t) {
+        case OptionType::LONG: return "long";
+        case OptionType::OBJECTPOINT: return "void *";
+        case OptionType::STRINGPOINT: return "char *";
+        case OptionType::SLISTPOINT: return "struct curl_slist *";
+        case OptionType::FUNCTIONPOINT: return "void (*)()";
+        case OptionType::OFF_T: return "curl_off_t";
+        }
+        return "?";
+    }
+
+    // Value of the one-value enum define_NAME, or -1.
+    static int64_t define_value(const gdt::Archive &a, const std::string &name) {
+        const gdt::DataType *t = a.find("define_" + name);
+        if (!t || t->table() != gdt::T_ENUM) {
+            return -1;
+        }
+        for (const gdt::EnumValue &v : t->values) {
+            if (v.name == name) {
+                return v.value;
+            }
+        }
+        return -1;
+    }
+
+    // Declaration of the callback type 'name' for a function called 'as'; of
+    // the function definitions by that name the one with parameter names.
+    static std::string callback(const gdt::Archive &a, const std::string &name, const std::string &as) {
+        std::string best;
+        for (const gdt::DataType *t : a.types()) {
+            if (t->name != name) {
+                continue;
+            }
+            const gdt::DataType *f = a.get(a.resolve(t->id));
+            if (f && f->table() == gdt::T_POINTER) {
+                f = a.get(a.resolve(f->target));
+            }
+            if (f && f->table() == gdt::T_FUNCDEF) {
+                std::string d = a.decl(f->id, as);
+                best = d.size() > best.size() ? d : best;
+            }
+        }
+        return best.empty() ? name : best;
+    }
+
+    int64_t base_[6];
+    std::unordered_map<uint64_t, OptionInfo> options_;
+};
+
+}  // namespace curl
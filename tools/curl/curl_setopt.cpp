@@ -0,0 +1,232 @@
+/*
+ *   curl_setopt: list the curl_easy_setopt calls of the executables and
+ *   libraries of a firmware image with their option and, where it is a
+ *   constant, the value set.
+ *
+ *   Calls are found through the PLT or the definition of curl_easy_setopt
+ *   (common/callsites.hpp). The option id is decoded with libcurl.gdt
+ *   (curl::OptionTable, built once and shared by the worker threads) into
+ *   its name and argument type, and the third argument is shown as that
+ *   type: the string of a STRINGPOINT option, the function a callback
+ *   option points to together with the callback's signature, the named
+ *   flags of a LONG option such as CURLOPT_HTTPAUTH. Output, one line per
+ *   call:
+ *
+ *     file  call  caller  option  type  value  declaration
+ *
+ *   "?" marks what is not a constant at the call.
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/curl/curl_setopt.cpp -o curl_setopt
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/callsites.hpp"
+#include "common/elf.hpp"
+#include "common/files.hpp"
+#include "common/mapped_file.hpp"
+#include "common/parallel.hpp"
+#include "common/symbols.hpp"
+#include "curl/curl_options.hpp"
+#include "gdt/gdt_consts.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace {
+
+struct Options {
+    std::string function = "curl_easy_setopt";
+    bool known_only = false;
+    unsigned jobs = common::default_jobs();
+    std::string archive;
+    std::vector<std::string> paths;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: curl_setopt [options] libcurl.gdt path...\n"
+                 "  --function NAME  setopt function (default curl_easy_setopt)\n"
+                 "  --known          only calls whose option is a known constant\n"
+                 "  -j N             number of files scanned in parallel\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--function") {
+            o.function = next();
+        } else if (a == "--known") {
+            o.known_only = true;
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (o.archive.empty()) {
+            o.archive = a;
+        } else {
+            o.paths.push_back(a);
+        }
+    }
+    if (o.archive.empty() || o.paths.empty()) {
+        usage();
+    }
+    return o;
+}
+
+std::string c_literal(const std::string &s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\t') {
+            out += "\\t";
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char esc[8];
+            std::snprintf(esc, sizeof esc, "\\x%02x", static_cast<unsigned char>(c));
+            out += esc;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+std::string hex(uint64_t v) {
+    char b[24];
+    std::snprintf(b, sizeof b, "0x%" PRIx64, v);
+    return b;
+}
+
+// The third argument as the option's type says it is.
+std::string value(const common::ElfFile &elf, const common::SymbolMap &syms, const gdt::ConstantIndex &consts,
+                  const curl::OptionInfo &o, const common::DirectCall &c) {
+    if (!(c.known & 4)) {
+        return "?";
+    }
+    uint64_t v = c.args[2];
+    switch (o.type) {
+    case curl::OptionType::LONG: {
+        const gdt::ConstantFamily *f = o.family.empty() ? nullptr : consts.family(o.family);
+        if (elf.pointer_size() == 4) {
+            v = uint64_t(int64_t(int32_t(v)));
+        }
+        if (f && v) {
+            return consts.decompose(elf.pointer_size() == 4 ? uint32_t(v) : v, *f);
+        }
+        return std::to_string(int64_t(v));
+    }
+    case curl::OptionType::OFF_T:
+        if (elf.pointer_size() == 4) {  // two registers / stack slots, low word first
+            if (!(c.known & 8)) {
+                return "?";
+            }
+            v = (v & 0xffffffff) | c.args[3] << 32;
+        }
+        return std::to_string(int64_t(v));
+    case curl::OptionType::STRINGPOINT:
+        if (v && elf.at_vaddr(v)) {
+            return c_literal(elf.cstring_at(v));
+        }
+        return v ? hex(v) : "NULL";
+    default: {
+        if (!v) {
+            return "NULL";
+        }
+        bool thumb = o.type == curl::OptionType::FUNCTIONPOINT && elf.machine() == common::EM_ARM;
+        uint64_t a = thumb ? v & ~uint64_t(1) : v;
+        const char *name = syms.at(a);
+        return name ? hex(v) + " " + name : hex(v);
+    }
+    }
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::unique_ptr<gdt::Archive> archive;
+    std::unique_ptr<curl::OptionTable> table;
+    std::unique_ptr<gdt::ConstantIndex> consts;
+    try {
+        archive.reset(new gdt::Archive(opt.archive));
+        table.reset(new curl::OptionTable(*archive));
+        consts.reset(new gdt::ConstantIndex(*archive));
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "curl_setopt: %s: %s\n", opt.archive.c_str(), e.what());
+        return 1;
+    }
+    const curl::OptionTable &options = *table;
+
+    std::vector<std::string> files = common::collect_files(opt.paths, "curl_setopt");
+    std::vector<std::string> text(files.size());
+    std::mutex lock;
+    int status = 0;
+
+    common::parallel_for(files.size(), opt.jobs, [&](size_t i) {
+        std::ostringstream o;
+        try {
+            common::MappedFile f(files[i]);
+            if (!common::ElfFile::is_elf(f.data(), f.size())) {
+                return;
+            }
+            common::ElfFile elf(f.data(), f.size());
+            common::CallTargets targets(elf, {opt.function});
+            if (targets.empty()) {
+                return;
+            }
+            std::vector<common::DirectCall> calls;
+            common::scan_direct_calls(elf, targets, [&](const common::DirectCall &c) { calls.push_back(c); });
+            std::sort(calls.begin(), calls.end(),
+                      [](const common::DirectCall &x, const common::DirectCall &y) { return x.addr < y.addr; });
+            common::SymbolMap syms(elf);
+            for (const common::DirectCall &c : calls) {
+                const curl::OptionInfo *info = c.known & 2 ? options.find(c.args[1]) : nullptr;
+                if (opt.known_only && !info) {
+                    continue;
+                }
+                o << files[i] << '\t' << hex(c.addr) << '\t' << syms.containing(c.addr) << '\t';
+                if (info) {
+                    o << info->name << '\t' << curl::type_name(info->type) << '\t'
+                      << value(elf, syms, *consts, *info, c) << '\t' << info->argument << '\n';
+                } else if (c.known & 2 && options.plausible(c.args[1])) {
+                    o << c.args[1] << '\t' << curl::type_name(options.range_type(c.args[1])) << "\t?\t?\n";
+                } else {
+                    o << "?\t?\t?\t?\n";
+                }
+            }
+        } catch (const std::exception &e) {
+            std::lock_guard<std::mutex> g(lock);
+            std::fprintf(stderr, "curl_setopt: %s: %s\n", files[i].c_str(), e.what());
+            status = 1;
+            return;
+        }
+        std::lock_guard<std::mutex> g(lock);
+        text[i] = o.str();
+    });
+
+    for (const std::string &t : text) {
+        std::fwrite(t.data(), 1, t.size(), stdout);
+    }
+    return status;
+}
@@ -0,0 +1,267 @@
+/*
+ *   Category tree of an archive, numbered by an Euler tour: a depth-first
+ *   walk gives every category the interval [enter, exit) of the preorder
+ *   positions of its subtree, and the types are kept in one array sorted by
+ *   the preorder position of their category. The types under a category
+ *   ("/DWARF/urldata.h" and all below it) are then one slice of that array,
+ *   found with two reads, and whether a category lies under another is two
+ *   comparisons, where Archive::category_path() walks parent pointers per
+ *   type.
+ *
+ *   Children are walked in name order, so a path is found by a binary
+ *   search per component, and the categories whose paths start with a
+ *   given string ("/DWARF/http": /DWARF/http.h, /DWARF/http2.c,
+ *   /DWARF/http_chunks.h) are a run of siblings whose subtrees follow each
+ *   other in preorder: one slice again.
+ *
+ *   Building takes a sort of each category's children and a counting sort
+ *   of the types. Categories whose parent is missing, or that lie on a
+ *   parent cycle, become roots of their own after the archive's root.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gdt/gdt_types.hpp"
+
+
+namespace gdt {
+
+// Consecutive types of CategoryIndex::types().
+struct TypeRange {
+    const DataType *const *first = nullptr;
+    const DataType *const *last = nullptr;
+
+    const DataType *const *begin() const { return first; }
+    const DataType *const *end() const { return last; }
+    size_t size() const { return size_t(last - first); }
+    bool empty() const { return first == last; }
+};
+
+class CategoryIndex {
+  public:
+    explicit CategoryIndex(const Archive &a) {
+        // Children by parent, in name order; parentless categories are roots.
+        std::unordered_map<int64_t, std::vector<const Category *>> children;
+        std::vector<const Category *> roots;
+        for (const auto &kv : a.categories()) {
+            const Category &c = kv.second;
+            if (c.parent < 0 || c.parent == c.id || !a.categories().count(c.parent)) {
+                roots.push_back(&c);
+            } else {
+                children[c.parent].push_back(&c);
+            }
+        }
+        std::stable_partition(roots.begin(), roots.end(), [](const Category *c) { return c->parent < 0; });
+        auto by_name = [](const Category *x, const Category *y) {
+            return x->name != y->name ? x->name < y->name : x->id < y->id;
+        };
+        for (auto &kv : children) {
+            std::sort(kv.second.begin(), kv.second.end(), by_name);
+        }
+
+        // Preorder from each root; what no root reaches is on a cycle and
+        // starts a tree of its own.
+        std::vector<std::pair<const Category *, size_t>> stack;  // category, parent position
+        auto tour = [&](const Category *root) {
+            stack.emplace_back(root, NONE);
+            while (!stack.empty()) {
+                const Category *c = stack.back().first;
+                size_t parent = stack.back().second;
+                stack.pop_back();
+                size_t pos = nodes_.size();
+                pre_[c->id] = pos;
+                nodes_.push_back({c->id, c, parent, 0, 0, 0});
+                auto it = children.find(c->id);
+                if (it == children.end()) {
+                    continue;
+                }
+                for (auto k = it->second.rbegin(); k != it->second.rend(); ++k) {
+                    if (!pre_.count((*k)->id)) {
+                        stack.emplace_back(*k, pos);
+                    }
+                }
+            }
+        };
+        for (const Category *r : roots) {
+            tour(r);
+        }
+        for (const auto &kv : a.categories()) {
+            if (!pre_.count(kv.first)) {
+                tour(&kv.second);
+            }
+        }
+
+        // Subtree ends, backwards so children close before their parents,
+        // and each node's children in name order (which is preorder).
+        for (size_t i = nodes_.size(); i-- > 0;) {
+            Node &n = nodes_[i];
+            n.exit = std::max(n.exit, i + 1);
+            if (n.parent != NONE) {
+                nodes_[n.parent].exit = std::max(nodes_[n.parent].exit, n.exit);
+            }
+        }
+        std::vector<size_t> count(nodes_.size());
+        for (size_t i = 0; i < nodes_.size(); i++) {
+            if (nodes_[i].parent != NONE) {
+                count[nodes_[i].parent]++;
+            }
+        }
+        size_t at = 0;
+        for (size_t i = 0; i < nodes_.size(); i++) {
+            nodes_[i].kids = at;
+            at += count[i];
+            nodes_[i].kids_end = nodes_[i].kids;
+        }
+        kids_.resize(at);
+        for (size_t i = 0; i < nodes_.size(); i++) {
+            if (nodes_[i].parent != NONE) {
+                Node &p = nodes_[nodes_[i].parent];
+                kids_[p.kids_end++] = i;
+            }
+        }
+
+        // Types by the position of their category; those of categories the
+        // table lacks go last, under none.
+        std::vector<size_t> pos(a.types().size());
+        start_.assign(nodes_.size() + 2, 0);
+        for (size_t i = 0; i < a.types().size(); i++) {
+            auto it = pre_.find(a.types()[i]->category);
+            pos[i] = it == pre_.end() ? nodes_.size() : it->second;
+            start_[pos[i] + 1]++;
+        }
+        for (size_t i = 1; i < start_.size(); i++) {
+            start_[i] += start_[i - 1];
+        }
+        types_.resize(a.types().size());
+        std::vector<size_t> fill(start_.begin(), start_.end() - 1);
+        for (size_t i = 0; i < a.types().size(); i++) {
+            types_[fill[pos[i]]++] = a.types()[i];
+        }
+    }
+
+    // Categories, in preorder.
+    size_t size() const { return nodes_.size(); }
+    int64_t category(size_t pos) const { return nodes_.at(pos).id; }
+
+    // The preorder position of a category and one past its subtree's last.
+    std::pair<size_t, size_t> interval(int64_t category) const {
+        auto it = pre_.find(category);
+        return it == pre_.end() ? std::make_pair(NONE, NONE) : std::make_pair(it->second, nodes_[it->second].exit);
+    }
+
+    // All types, grouped by category in preorder.
+    const std::vector<const DataType *> &types() const { return types_; }
+
+    // The category at 'path' ("/", "/DWARF/urldata.h"), NULL_ID if none.
+    int64_t find(const std::string &path) const {
+        size_t pos = node(path);
+        return pos == NONE ? NULL_ID : nodes_[pos].id;
+    }
+
+    // 'category' is 'ancestor' or lies below it.
+    bool contains(int64_t ancestor, int64_t category) const {
+        auto a = interval(ancestor);
+        auto it = pre_.find(category);
+        return a.first != NONE && it != pre_.end() && a.first <= it->second && it->second < a.second;
+    }
+
+    // The types of a category and of all categories below it.
+    TypeRange under(int64_t category) const {
+        auto i = interval(category);
+        return i.first == NONE ? TypeRange{} : slice(i.first, i.second);
+    }
+
+    // The types of the category itself.
+    TypeRange in(int64_t category) const {
+        auto i = interval(category);
+        return i.first == NONE ? TypeRange{} : slice(i.first, i.first + 1);
+    }
+
+    // The types of every category whose path starts with 'prefix': "/DWARF/"
+    // is all below /DWARF, "/DWARF/url" the subtrees of its children named
+    // url*, "/" everything under the root.
+    TypeRange prefix(const std::string &prefix) const {
+        if (prefix == "/") {
+            return under(find("/"));
+        }
+        size_t slash = prefix.rfind('/');
+        if (slash == std::string::npos) {
+            return {};
+        }
+        // "//..." names no category; node() takes "/" for the root only.
+        size_t parent = slash == 0 ? node("/") : slash == 1 ? NONE : node(prefix.substr(0, slash));
+        if (parent == NONE) {
+            return {};
+        }
+        std::string part = prefix.substr(slash + 1);
+        auto run = children(parent, part);
+        if (run.first == run.second) {
+            return {};
+        }
+        return slice(kids_[run.first], nodes_[kids_[run.second - 1]].exit);
+    }
+
+  private:
+    static constexpr size_t NONE = size_t(-1);
+
+    struct Node {
+        int64_t id;
+        const Category *cat;
+        size_t parent;    // preorder position, NONE for a root
+        size_t exit;      // one past the subtree
+        size_t kids;      // its children in kids_: [kids, kids_end)
+        size_t kids_end;
+    };
+
+    TypeRange slice(size_t from, size_t to) const {
+        return {types_.data() + start_[from], types_.data() + start_[to]};
+    }
+
+    // The children of 'pos' whose names start with 'part', as a range of kids_.
+    std::pair<size_t, size_t> children(size_t pos, const std::string &part) const {
+        const Node &n = nodes_[pos];
+        auto first = std::lower_bound(kids_.begin() + n.kids, kids_.begin() + n.kids_end, part,
+                                      [&](size_t k, const std::string &s) { return nodes_[k].cat->name < s; });
+        auto last = first;
+        while (last != kids_.begin() + n.kids_end && nodes_[*last].cat->name.compare(0, part.size(), part) == 0) {
+            ++last;
+        }
+        return {size_t(first - kids_.begin()), size_t(last - kids_.begin())};
+    }
+
+    size_t node(const std::string &path) const {
+        if (nodes_.empty() || path.empty() || path[0] != '/') {
+            return NONE;
+        }
+        size_t pos = 0;
+        for (size_t b = 1; b < path.size();) {
+            size_t e = std::min(path.find('/', b), path.size());
+            std::string part = path.substr(b, e - b);
+            b = e + 1;
+            if (part.empty()) {
+                return NONE;
+            }
+            auto run = children(pos, part);
+            if (run.first == run.second || nodes_[kids_[run.first]].cat->name != part) {
+                return NONE;
+            }
+            pos = kids_[run.first];
+        }
+        return pos;
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<size_t> kids_;
+    std::unordered_map<int64_t, size_t> pre_;  // category id -> preorder position
+    std::vector<size_t> start_;                // preorder position -> first of its types in types_
+    std::vector<const DataType *> types_;
+};
+
+}  // namespace gdt
@@ -0,0 +1,227 @@
+/*
+ *   gdt_cc: compile a C header straight into a .gdt archive, without
+ *   Ghidra's "Parse C Source".
+ *
+ *   The header is split into parts at its section banners, the way
+ *   header/lua_all.h marks the Lua headers it concatenates: a "// name.h"
+ *   line between two lines of nothing but slashes and asterisks
+ *   (text before the first banner is a part named after the file). One
+ *   pass over the preprocessor directives alone finds the macros and open
+ *   conditionals each part starts with; then the parts are preprocessed
+ *   and parsed in parallel (common/c_preprocessor.hpp, gdt/gdt_cparse.hpp)
+ *   and merged in header order into one archive (gdt/gdt_compile.hpp),
+ *   which goes out through the native writer (gdt/gdt_write.hpp). Each
+ *   part is a category with /functions and /defines below it, as in the
+ *   archives Ghidra makes from lua_all.h.
+ *
+ *   Types are laid out for --org (lp64 by default); the <limits.h>
+ *   constants are predefined to match it. The options of the Ghidra
+ *   profile go on the command line as -D/-U, e.g. for 32-bit Linux:
+ *
+ *     gdt_cc --org ilp32 -DLUA_USE_LINUX -DLUA_USE_C89 header/lua_all.h lua32.gdt
+ *
+ *   --force sets a macro the header cannot change (luaconf.h defines
+ *   LUA_32BITS and LUAI_MAXSTACK unconditionally), --skip leaves a part
+ *   out. gdt_matrix builds many such variants at once.
+ *
+ *   Declarations that do not compile are left out and reported on stderr
+ *   as "gdt_cc: file:line: message". One line per archive:
+ *
+ *     out  parts  types  categories  bytes
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/gdt/gdt_cc.cpp -o gdt_cc
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/c_preprocessor.hpp"
+#include "common/hash.hpp"
+#include "common/mapped_file.hpp"
+#include "common/parallel.hpp"
+#include "gdt/gdt_compile.hpp"
+#include "gdt/gdt_cparse.hpp"
+#include "gdt/gdt_types.hpp"
+#include "gdt/gdt_write.hpp"
+
+
+namespace {
+
+struct Options {
+    std::vector<std::pair<char, std::string>> macros;  // 'D'/'F' NAME[=VALUE] or 'U' NAME, in order
+    std::vector<std::string> skip;
+    std::string org = "lp64";
+    std::string name;
+    std::string id;
+    int64_t time = -1;
+    unsigned jobs = common::default_jobs();
+    std::string in;
+    std::string out;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: gdt_cc [options] header.h out.gdt\n"
+                 "  -D NAME[=VALUE]  define a macro (also -DNAME)\n"
+                 "  -U NAME          undefine a macro\n"
+                 "  --force NAME[=V] define a macro the header cannot redefine or undefine\n"
+                 "  --skip PART      leave out a part of the header (as named by its banner)\n"
+                 "  --org ORG        data organization: lp64 (default), llp64, ilp32, i386\n"
+                 "  --name NAME      archive name (default: the output file name without .gdt)\n"
+                 "  --id HEX         universal id of the archive (default: a hash of name and org)\n"
+                 "  --time MS        creation time of the types, ms since 1970 (default: now)\n"
+                 "  -j N             parts parsed in parallel\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if ((a.rfind("-D", 0) == 0 || a.rfind("-U", 0) == 0) && a.size() >= 2) {
+            o.macros.emplace_back(a[1], a.size() > 2 ? a.substr(2) : std::string(next()));
+        } else if (a == "--force") {
+            o.macros.emplace_back('F', next());
+        } else if (a == "--skip") {
+            o.skip.push_back(next());
+        } else if (a == "--org") {
+            o.org = next();
+        } else if (a == "--name") {
+            o.name = next();
+        } else if (a == "--id") {
+            o.id = next();
+        } else if (a == "--time") {
+            o.time = std::strtoll(next(), nullptr, 10);
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (o.in.empty()) {
+            o.in = a;
+        } else if (o.out.empty()) {
+            o.out = a;
+        } else {
+            usage();
+        }
+    }
+    if (o.out.empty()) {
+        usage();
+    }
+    return o;
+}
+
+std::string basename(const std::string &path) { return path.substr(path.find_last_of('/') + 1); }
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::string where = opt.in;
+    try {
+        gdt::DataOrganization org = gdt::DataOrganization::named(opt.org);
+        std::string name = opt.name;
+        if (name.empty()) {
+            name = basename(opt.out);
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".gdt") == 0) {
+                name.resize(name.size() - 4);
+            }
+        }
+        int64_t id = int64_t(common::mix64(common::hash_string(name + "/" + org.name)) >> 1);
+        if (!opt.id.empty()) {
+            id = static_cast<int64_t>(std::strtoull(opt.id.c_str(), nullptr, 16));
+        }
+        int64_t time = opt.time >= 0 ? opt.time
+                                     : std::chrono::duration_cast<std::chrono::milliseconds>(
+                                           std::chrono::system_clock::now().time_since_epoch())
+                                           .count();
+
+        common::MappedFile file(opt.in);
+        const char *text = reinterpret_cast<const char *>(file.data());
+        std::vector<gdt::HeaderPart> parts = gdt::header_parts(text, file.size(), basename(opt.in));
+        for (const std::string &s : opt.skip) {
+            auto it = std::find_if(parts.begin(), parts.end(), [&](const gdt::HeaderPart &p) { return p.name == s; });
+            if (it == parts.end()) {
+                throw std::runtime_error("no part " + s);
+            }
+            parts.erase(it);
+        }
+
+        common::Preprocessor pp(opt.in);
+        gdt::predefine(pp, org);
+        for (const auto &m : opt.macros) {
+            size_t eq = m.second.find('=');
+            std::string name = m.second.substr(0, eq), value = eq == std::string::npos ? "1" : m.second.substr(eq + 1);
+            if (m.first == 'U') {
+                pp.undef(m.second);
+            } else if (m.first == 'F') {
+                pp.force(name, value);
+            } else {
+                pp.define(name, value);
+            }
+        }
+
+        // Directives only, in order: the state every part starts in.
+        std::vector<std::vector<common::CLine>> lines(parts.size());
+        std::vector<common::Preprocessor> starts;
+        for (size_t k = 0; k < parts.size(); k++) {
+            lines[k] = common::c_lines(text + parts[k].begin, parts[k].end - parts[k].begin, parts[k].line);
+            starts.push_back(pp);
+            pp.run(lines[k], nullptr);
+        }
+        pp.finish();
+
+        std::vector<gdt::CUnit> units(parts.size());
+        common::parallel_for(parts.size(), opt.jobs, [&](size_t k) {
+            common::Preprocessor p = starts[k];
+            std::vector<common::CToken> tokens;
+            units[k].name = parts[k].name;
+            p.run(lines[k], &tokens, &units[k].defines);
+            gdt::CParser(tokens, units[k]).parse();
+        });
+
+        gdt::Compiler compiler(org, time);
+        std::vector<gdt::CDiagnostic> diags;
+        for (const gdt::CUnit &u : units) {
+            compiler.add(u);
+            diags.insert(diags.end(), u.diagnostics.begin(), u.diagnostics.end());
+        }
+        for (const gdt::CUnit &u : units) {
+            compiler.add_defines(u);
+        }
+        diags.insert(diags.end(), compiler.warnings().begin(), compiler.warnings().end());
+        std::stable_sort(diags.begin(), diags.end(),
+                         [](const gdt::CDiagnostic &a, const gdt::CDiagnostic &b) { return a.line < b.line; });
+        for (const gdt::CDiagnostic &d : diags) {
+            std::fprintf(stderr, "gdt_cc: %s:%d: %s\n", opt.in.c_str(), d.line, d.message.c_str());
+        }
+
+        gdt::ArchiveWriter w;
+        compiler.write(w);
+        where = opt.out;
+        w.write(opt.out, id, name);
+        common::MappedFile written(opt.out);
+        std::printf("%s\t%zu\t%zu\t%zu\t%zu\n", opt.out.c_str(), parts.size(), compiler.types(),
+                    compiler.categories(), written.size());
+    } catch (const common::CppError &e) {
+        std::fprintf(stderr, "gdt_cc: %s\n", e.what());  // file:line: message
+        return 1;
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "gdt_cc: %s: %s\n", where.c_str(), e.what());
+        return 1;
+    }
+    return 0;
+}
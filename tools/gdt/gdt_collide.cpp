@@ -0,0 +1,155 @@
+/*
+ *   gdt_collide: report the data types that several archives (or several
+ *   categories of one archive) declare differently under the same name.
+ *
+ *   The archives are loaded in parallel; then one pass over all their named
+ *   types files each under its name with its structural signature
+ *   (gdt/gdt_hash.hpp), and names with more than one signature are
+ *   reported, one line per place that declares them:
+ *
+ *     name  status  variant  archive  category  summary
+ *
+ *   status is "conflict" when two different declarations share a category
+ *   path (Ghidra turns the second into NAME.conflict when both archives
+ *   are applied to one program) and "shadow" when they live in different
+ *   categories (both survive, but lookups by name pick one). variant
+ *   numbers the distinct declarations of the name. --all also lists names
+ *   declared identically in several places ("duplicate").
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/gdt/gdt_collide.cpp -o gdt_collide
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/parallel.hpp"
+#include "gdt/gdt_hash.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace {
+
+struct Options {
+    bool all = false;
+    unsigned jobs = common::default_jobs();
+    std::vector<std::string> archives;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: gdt_collide [options] archive.gdt...\n"
+                 "  --all   also list names declared identically in several places\n"
+                 "  -j N    number of archives loaded in parallel\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--all") {
+            o.all = true;
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else {
+            o.archives.push_back(a);
+        }
+    }
+    if (o.archives.empty()) {
+        usage();
+    }
+    return o;
+}
+
+struct Place {
+    size_t archive;
+    const gdt::DataType *type;
+    uint64_t signature;
+    std::string category;
+};
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::vector<std::unique_ptr<gdt::Archive>> archives(opt.archives.size());
+    int status = 0;
+    common::parallel_for(archives.size(), opt.jobs, [&](size_t i) {
+        try {
+            archives[i].reset(new gdt::Archive(opt.archives[i]));
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "gdt_collide: %s: %s\n", opt.archives[i].c_str(), e.what());
+            status = 1;
+        }
+    });
+
+    std::unordered_map<std::string, std::vector<Place>> by_name;
+    size_t types = 0;
+    for (size_t i = 0; i < archives.size(); i++) {
+        if (!archives[i]) {
+            continue;
+        }
+        const gdt::Archive &a = *archives[i];
+        for (const gdt::DataType *t : a.types()) {
+            if (!gdt::named_kind(t->table()) || t->name.empty()) {
+                continue;
+            }
+            by_name[t->name].push_back({i, t, gdt::signature(a, *t), a.category_path(t->category)});
+            types++;
+        }
+    }
+
+    std::vector<const std::string *> names;
+    for (const auto &kv : by_name) {
+        if (kv.second.size() > 1) {
+            names.push_back(&kv.first);
+        }
+    }
+    std::sort(names.begin(), names.end(), [](const std::string *a, const std::string *b) { return *a < *b; });
+
+    size_t conflicts = 0, shadows = 0, duplicates = 0;
+    for (const std::string *name : names) {
+        const std::vector<Place> &places = by_name[*name];
+        std::vector<uint64_t> variants;
+        std::map<std::string, uint64_t> at_path;
+        bool conflict = false;
+        for (const Place &p : places) {
+            if (std::find(variants.begin(), variants.end(), p.signature) == variants.end()) {
+                variants.push_back(p.signature);
+            }
+            auto ins = at_path.emplace(p.category, p.signature);
+            conflict = conflict || (!ins.second && ins.first->second != p.signature);
+        }
+        const char *status_name = conflict ? "conflict" : variants.size() > 1 ? "shadow" : "duplicate";
+        (conflict ? conflicts : variants.size() > 1 ? shadows : duplicates)++;
+        if (variants.size() == 1 && !opt.all) {
+            continue;
+        }
+        for (const Place &p : places) {
+            size_t v = size_t(std::find(variants.begin(), variants.end(), p.signature) - variants.begin()) + 1;
+            const std::string &path = opt.archives[p.archive];
+            std::printf("%s\t%s\t%zu\t%s\t%s\t%s\n", name->c_str(), status_name, v,
+                        path.substr(path.rfind('/') + 1).c_str(), p.category.c_str(),
+                        gdt::summary(*archives[p.archive], *p.type).c_str());
+        }
+    }
+    std::printf("# %zu named types, %zu names in several places: %zu conflicts, %zu shadowed, %zu duplicates\n",
+                types, names.size(), conflicts, shadows, duplicates);
+    return status;
+}
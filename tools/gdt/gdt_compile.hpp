@@ -0,0 +1,702 @@
+/*
+ *   Data type archives compiled from C declarations (gdt_cparse.hpp), in
+ *   the shape Ghidra's C parser gives them (gdt/lua.gdt):
+ *
+ *   - every part of a header (a CUnit, e.g. "// lobject.h" of lua_all.h)
+ *     is a category, with its function prototypes in /<part>/functions
+ *     and its integer #defines as define_<NAME> enums (8 bytes, one value)
+ *     in /<part>/defines;
+ *   - types merge by name across parts: a tag used in one part and defined
+ *     in a later one is one type, filled in and moved to the category of
+ *     its definition, and repeated typedefs and prototypes are one type;
+ *   - a typedef naming a struct, union or enum of the same name, or an
+ *     anonymous one, is that type under the name; a typedef of a function
+ *     pointer is a function definition of that name, and the typedef name
+ *     stands for a pointer to it; qualifiers are dropped;
+ *   - composites are laid out for the data organization compiled for
+ *     (gdt_types.hpp, System V rules) and stored with explicit offsets
+ *     ("internal alignment" -1); structures count their padding bytes as
+ *     components, as Ghidra does for them;
+ *   - universal ids are hashes of kind, category path and name, so a
+ *     rebuilt archive keeps the ids programs refer to.
+ *
+ *   Parts are added in header order, since each may use the types and enum
+ *   constants of the ones before it; array sizes, enum values and bit
+ *   widths are evaluated then, with sizeof and casts of the types defined
+ *   so far. A declaration that does not compile is left out and reported.
+ *   The #defines of the parts are added after all of their types.
+ *   A Compiler is a value: builds that share their first parts can copy it
+ *   after them and go on separately.
+ *
+ *   header_parts() splits a header at its section banners and predefine()
+ *   sets what <limits.h> would for a data organization, for the tools that
+ *   compile whole headers (gdt_cc, gdt_matrix).
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/c_preprocessor.hpp"
+#include "common/hash.hpp"
+#include "gdt/gdt_cparse.hpp"
+#include "gdt/gdt_types.hpp"
+#include "gdt/gdt_write.hpp"
+
+
+namespace gdt {
+
+class Compiler {
+  public:
+    // 'time' (ms since the epoch) is the sync and change time of every type.
+    Compiler(const DataOrganization &org, int64_t time) : org_(org), time_(time) {
+        next_[T_BUILTIN] = 100;
+        paths_[0] = "";
+    }
+
+    // The types and prototypes of a part.
+    void add(const CUnit &u) {
+        Context c;
+        c.unit = &u;
+        c.category = category(0, u.name);
+        c.records.assign(u.records.size(), NULL_ID);
+        for (const CItem &it : u.items) {
+            try {
+                item(c, it);
+            } catch (const common::CppError &e) {
+                warnings_.push_back({it.decl.decl.line, e.what()});
+            }
+        }
+    }
+
+    // The integer #defines of a part. No declaration refers to them (they
+    // are expanded before parsing), so they go in after the types of all
+    // parts, and builds that differ only in constants share every type.
+    void add_defines(const CUnit &u) {
+        Context c;
+        c.unit = &u;
+        c.category = category(0, u.name);
+        for (const common::Preprocessor::Define &d : u.defines) {
+            define(c, d);
+        }
+    }
+
+    const std::vector<CDiagnostic> &warnings() const { return warnings_; }
+    size_t types() const { return types_.size(); }
+    size_t categories() const { return categories_.size() + 1; }
+
+    void write(ArchiveWriter &w) const {
+        for (const auto &kv : categories_) {
+            w.add(kv.second);
+        }
+        for (const DataType &t : types_) {
+            DataType d = t;
+            if (d.table() != T_BUILTIN) {
+                uint64_t h = common::hash_string(paths_.at(d.category) + "/" + d.name, d.table());
+                d.universal_id = std::max<int64_t>(1, int64_t(common::mix64(h) >> 1));
+                d.source_sync_time = d.last_change_time = time_;
+            }
+            if (d.table() == T_POINTER || d.table() == T_ARRAY) {
+                d.universal_id = d.source_sync_time = d.last_change_time = 0;
+            }
+            w.add(d);
+        }
+    }
+
+  private:
+    struct Context {
+        const CUnit *unit = nullptr;
+        int64_t category = 0;
+        int64_t functions = -1;
+        int64_t defines = -1;
+        std::vector<int64_t> records;  // by CUnit::records index, once compiled
+    };
+
+    // Enum constants, sizeof and casts for the expressions of declarations.
+    struct Scope : common::ConstantExpression::Scope {
+        Scope(Compiler &comp, Context &ctx) : c(comp), x(ctx) {}
+
+        bool constant(const std::string &name, int64_t &v) const override {
+            auto it = c.constants_.find(name);
+            if (it == c.constants_.end()) {
+                return false;
+            }
+            v = it->second;
+            return true;
+        }
+
+        bool type_name(const std::vector<CToken> &t, size_t &pos, uint64_t &size, bool &is_integer,
+                       bool &is_signed) const override {
+            if (pos >= t.size() || t[pos].kind != CToken::IDENT ||
+                !(CParser::type_keyword(t[pos].text) || c.typedefs_.count(t[pos].text))) {
+                return false;
+            }
+            CUnit scratch;
+            CParser p(t, scratch, pos);
+            CDecl d;
+            if (!p.type_name(d) || !scratch.records.empty()) {
+                return false;
+            }
+            int64_t id = c.derive(x, c.base(x, d.spec, ""), d.decl.ops, d.decl.ops.size());
+            size = c.layout(id).size;
+            c.scalar_kind(id, is_integer, is_signed);
+            pos = p.pos();
+            return true;
+        }
+
+        Compiler &c;
+        Context &x;
+    };
+
+    static const char *builtin_class(const std::string &name) {
+        static const std::map<std::string, const char *> classes = {
+            {"void", "VoidDataType"},         {"bool", "BooleanDataType"},
+            {"char", "CharDataType"},         {"schar", "SignedCharDataType"},
+            {"uchar", "UnsignedCharDataType"}, {"short", "ShortDataType"},
+            {"ushort", "UnsignedShortDataType"}, {"int", "IntegerDataType"},
+            {"uint", "UnsignedIntegerDataType"}, {"long", "LongDataType"},
+            {"ulong", "UnsignedLongDataType"}, {"longlong", "LongLongDataType"},
+            {"ulonglong", "UnsignedLongLongDataType"}, {"float", "FloatDataType"},
+            {"double", "DoubleDataType"},     {"longdouble", "LongDoubleDataType"},
+        };
+        auto it = classes.find(name);
+        return it == classes.end() ? nullptr : it->second;
+    }
+
+    [[noreturn]] static void fail(const std::string &msg) { throw common::CppError(msg); }
+
+    int64_t category(int64_t parent, const std::string &name) {
+        auto key = std::make_pair(parent, name);
+        auto it = category_ids_.find(key);
+        if (it != category_ids_.end()) {
+            return it->second;
+        }
+        int64_t id = int64_t(categories_.size()) + 1;
+        categories_[id] = Category{id, name, parent};
+        category_ids_[key] = id;
+        paths_[id] = paths_[parent] + "/" + name;
+        return id;
+    }
+
+    int64_t functions(Context &c) {
+        if (c.functions < 0) {
+            c.functions = category(c.category, "functions");
+        }
+        return c.functions;
+    }
+
+    DataType &create(uint8_t table, const std::string &name, int64_t cat) {
+        types_.emplace_back();
+        DataType &t = types_.back();
+        t.id = make_id(table, next_[table]++);
+        t.name = name;
+        t.category = cat;
+        by_id_[t.id] = types_.size() - 1;
+        return t;
+    }
+
+    DataType &get(int64_t id) { return types_[by_id_.at(id)]; }
+
+    const DataType *find(int64_t id) const {
+        auto it = by_id_.find(id);
+        return it == by_id_.end() ? nullptr : &types_[it->second];
+    }
+
+    TypeLayout layout(int64_t id) const {
+        return Layouter([this](int64_t i) { return find(i); }, org_).layout(id);
+    }
+
+    // Integer-ness and signedness of a scalar type, for casts.
+    void scalar_kind(int64_t id, bool &is_integer, bool &is_signed) const {
+        const DataType *t = find(id);
+        while (t && t->table() == T_TYPEDEF) {
+            t = find(t->target);
+        }
+        is_integer = is_signed = false;
+        if (!t) {
+            return;
+        }
+        if (t->table() == T_POINTER) {
+            is_integer = true;
+        } else if (t->table() == T_ENUM) {
+            is_integer = is_signed = true;
+        } else if (t->table() == T_BUILTIN) {
+            static const std::set<std::string> integers = {"bool", "char",  "schar", "uchar",    "short",
+                                                           "ushort", "int", "uint",  "long",     "ulong",
+                                                           "longlong", "ulonglong"};
+            is_integer = integers.count(t->name) != 0;
+            is_signed = is_integer && t->name[0] != 'u' && t->name != "bool";
+        }
+    }
+
+    int64_t builtin(const std::string &name) {
+        auto it = builtins_.find(name);
+        if (it != builtins_.end()) {
+            return it->second;
+        }
+        const char *cls = builtin_class(name);
+        if (!cls) {
+            fail("unknown built-in type " + name);
+        }
+        DataType &t = create(T_BUILTIN, name, 0);
+        t.class_name = std::string("ghidra.program.model.data.") + cls;
+        builtins_[name] = t.id;
+        return t.id;
+    }
+
+    int64_t pointer(int64_t target) {
+        auto it = pointers_.find(target);
+        if (it != pointers_.end()) {
+            return it->second;
+        }
+        int64_t cat = get(target).category;
+        DataType &t = create(T_POINTER, "", cat);
+        t.target = target;
+        pointers_[target] = t.id;
+        return t.id;
+    }
+
+    int64_t array(int64_t element, int64_t count) {
+        auto key = std::make_pair(element, count);
+        auto it = arrays_.find(key);
+        if (it != arrays_.end()) {
+            return it->second;
+        }
+        int64_t cat = get(element).category;
+        DataType &t = create(T_ARRAY, "", cat);
+        t.target = element;
+        t.count = int32_t(count);
+        arrays_[key] = t.id;
+        return t.id;
+    }
+
+    int64_t evaluate(Context &c, const std::vector<CToken> &t) {
+        Scope s(*this, c);
+        return common::ConstantExpression::evaluate(t, s).v;
+    }
+
+    // The type a declaration specifier names. 'anon' names an anonymous
+    // struct, union or enum defined in it.
+    int64_t base(Context &c, const CTypeSpec &s, const std::string &anon) {
+        switch (s.kind) {
+        case CTypeSpec::BUILTIN:
+            return builtin(s.name);
+        case CTypeSpec::NAME: {
+            auto it = typedefs_.find(s.name);
+            if (it == typedefs_.end()) {
+                fail("unknown type name '" + s.name + "'");
+            }
+            return it->second;
+        }
+        default:
+            return s.body >= 0 ? record(c, s.body, anon) : tag(c, s.tag, s.name);
+        }
+    }
+
+    // The type of a tag, declared incomplete when first seen.
+    int64_t tag(Context &c, char kind, const std::string &name) {
+        auto it = tags_.find(name);
+        if (it != tags_.end()) {
+            return it->second;
+        }
+        DataType &t = create(kind == 'e' ? T_ENUM : T_COMPOSITE, name, c.category);
+        t.is_union = kind == 'u';
+        t.length = kind == 'e' ? 4 : 0;
+        tags_[name] = t.id;
+        return t.id;
+    }
+
+    // Applies ops[0, n) to the type 'id'.
+    int64_t derive(Context &c, int64_t id, const std::vector<CDerived> &ops, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            const CDerived &d = ops[i];
+            if (d.kind == CDerived::POINTER) {
+                id = pointer(id);
+            } else if (d.kind == CDerived::ARRAY) {
+                if (d.dim.empty()) {
+                    fail("array without a size");
+                }
+                int64_t count = evaluate(c, d.dim);
+                if (count <= 0 || count > INT32_MAX) {
+                    fail("array size " + std::to_string(count));
+                }
+                id = array(id, count);
+            } else {
+                id = function(c, "", id, d);
+            }
+        }
+        return id;
+    }
+
+    // Parameters are adjusted: arrays and functions are passed as pointers.
+    int64_t parameter(Context &c, const CDecl &p) {
+        const std::vector<CDerived> &ops = p.decl.ops;
+        int64_t id = base(c, p.spec, "");
+        if (!ops.empty() && ops.back().kind == CDerived::ARRAY) {
+            return pointer(derive(c, id, ops, ops.size() - 1));
+        }
+        id = derive(c, id, ops, ops.size());
+        return !ops.empty() && ops.back().kind == CDerived::FUNCTION ? pointer(id) : id;
+    }
+
+    // "_func_int_lua_State_ptr" for function types that have no name.
+    std::string spelled(int64_t id) const {
+        const DataType *t = find(id);
+        if (!t) {
+            return "undefined";
+        }
+        if (t->table() == T_POINTER) {
+            return spelled(t->target) + "_ptr";
+        }
+        if (t->table() == T_ARRAY) {
+            return spelled(t->target) + "_" + std::to_string(t->count);
+        }
+        return t->name;
+    }
+
+    int64_t function(Context &c, const std::string &name, int64_t ret, const CDerived &d) {
+        std::vector<Parameter> params;
+        for (const CDecl &p : d.params) {
+            Parameter q;
+            q.type = parameter(c, p);
+            q.name = p.decl.name;
+            q.ordinal = int32_t(params.size());
+            q.length = int32_t(layout(q.type).size);
+            params.push_back(std::move(q));
+        }
+        std::string n = name;
+        if (n.empty()) {
+            n = "_func_" + spelled(ret);
+            for (const Parameter &p : params) {
+                n += "_" + spelled(p.type);
+            }
+            if (d.varargs) {
+                n += "_varargs";
+            }
+        }
+        auto it = functions_.find(n);
+        if (it != functions_.end()) {
+            return it->second;
+        }
+        DataType &t = create(T_FUNCDEF, n, functions(c));
+        t.return_type = ret;
+        t.flags = d.varargs ? 0x1 : 0;
+        t.params = std::move(params);
+        functions_[n] = t.id;
+        return t.id;
+    }
+
+    int64_t record(Context &c, int index, const std::string &anon) {
+        if (c.records[size_t(index)] != NULL_ID) {
+            return c.records[size_t(index)];
+        }
+        const CRecord &r = c.unit->records[size_t(index)];
+        std::string name = r.tag.empty() ? anon : r.tag;
+        if (r.kind == 'e') {
+            return enumeration(c, index, name);
+        }
+        if (name.empty()) {
+            fail("anonymous " + std::string(r.kind == 'u' ? "union" : "struct") + " without a name");
+        }
+        int64_t id;
+        if (!r.tag.empty()) {
+            id = tag(c, r.kind, r.tag);
+        } else {
+            DataType &t = create(T_COMPOSITE, name, c.category);
+            t.is_union = r.kind == 'u';
+            id = t.id;
+        }
+        c.records[size_t(index)] = id;
+        if (!defined_.insert(id).second) {
+            return id;  // defined by an earlier part
+        }
+
+        DataType d = get(id);
+        d.components.clear();
+        std::vector<unsigned> widths;  // bit-field widths, 0 for other members
+        for (size_t k = 0; k < r.members.size(); k++) {
+            const CDecl &m = r.members[k];
+            const std::vector<CDerived> &ops = m.decl.ops;
+            if (!ops.empty() && ops.back().kind == CDerived::ARRAY && ops.back().dim.empty()) {
+                warnings_.push_back({m.decl.line, "flexible array member '" + m.decl.name + "' left out"});
+                continue;
+            }
+            std::string inner = name + "_" + (m.decl.name.empty() ? std::to_string(k) : m.decl.name);
+            Component comp;
+            comp.type = derive(c, base(c, m.spec, inner), ops, ops.size());
+            comp.name = m.decl.name;
+            comp.ordinal = int32_t(d.components.size());
+            unsigned width = 0;
+            if (m.decl.bitfield) {
+                int64_t w = evaluate(c, m.decl.bits);
+                if (w < 0 || w > 64) {
+                    fail("bit-field width " + std::to_string(w));
+                }
+                width = unsigned(w);
+                comp.type = bitfield(comp.type, 0, width);
+            }
+            widths.push_back(width);
+            d.components.push_back(std::move(comp));
+        }
+
+        DataType laid = d;
+        laid.packing = 0;  // natural alignment
+        Layouter lay([this](int64_t i) { return find(i); }, org_);
+        TypeLayout l = lay.layout(laid);
+        uint64_t covered = 0, end = 0;
+        for (size_t k = 0; k < d.components.size(); k++) {
+            Component &comp = d.components[k];
+            if (widths[k] || table_of(comp.type) == T_BITFIELD) {
+                uint64_t bit = l.bit_offsets[k];
+                comp.offset = int32_t(bit / 8);
+                comp.size = int32_t(std::max<uint64_t>(1, (bit % 8 + widths[k] + 7) / 8));
+                comp.type = bitfield(BitField(comp.type).base, unsigned(bit % 8), widths[k]);
+            } else {
+                comp.offset = int32_t(l.offsets[k]);
+                comp.size = int32_t(lay.layout(comp.type).size);
+            }
+            if (!d.is_union && uint64_t(comp.offset) >= end) {
+                covered += uint64_t(comp.offset) - end;
+                end = uint64_t(comp.offset) + uint64_t(comp.size);
+            }
+        }
+        DataType &t = get(id);
+        t.components = std::move(d.components);
+        t.length = int32_t(l.size);
+        t.packing = -1;
+        t.alignment = 0;
+        t.category = c.category;
+        t.num_components = t.is_union ? 0 : int32_t(t.components.size() + covered + (l.size - std::min(l.size, end)));
+        return id;
+    }
+
+    // Bit-field ids pack the base type's key and kind (gdt_types.hpp).
+    int64_t bitfield(int64_t base, unsigned bit_offset, unsigned width) {
+        static const std::map<uint8_t, int64_t> kinds = {{T_BUILTIN, 0}, {T_TYPEDEF, 1}, {T_ENUM, 2}};
+        auto k = kinds.find(table_of(base));
+        if (k == kinds.end()) {
+            fail("bit-field of a type that is not an integer");
+        }
+        return make_id(T_BITFIELD, key_of(base) << 24 | k->second << 21 | int64_t(bit_offset) << 8 | int64_t(width));
+    }
+
+    // Enum constants are known from here on, also those of anonymous enums,
+    // which have no type.
+    int64_t enumeration(Context &c, int index, const std::string &name) {
+        const CRecord &r = c.unit->records[size_t(index)];
+        std::vector<EnumValue> values;
+        int64_t next = 0;
+        for (const auto &e : r.enumerators) {
+            int64_t v = e.second.empty() ? next : evaluate(c, e.second);
+            constants_[e.first] = v;
+            values.push_back(EnumValue{0, e.first, v});
+            next = v + 1;
+        }
+        if (name.empty()) {
+            c.records[size_t(index)] = builtin("int");
+            return c.records[size_t(index)];
+        }
+        int64_t id;
+        if (!r.tag.empty()) {
+            id = tag(c, 'e', r.tag);
+        } else {
+            id = create(T_ENUM, name, c.category).id;
+        }
+        c.records[size_t(index)] = id;
+        if (defined_.insert(id).second) {
+            DataType &t = get(id);
+            bool wide = false;
+            for (const EnumValue &v : values) {
+                wide = wide || v.value < INT32_MIN || v.value > int64_t(UINT32_MAX);
+            }
+            t.values = std::move(values);
+            t.length = wide ? 8 : 4;
+            t.category = c.category;
+        }
+        return id;
+    }
+
+    void item(Context &c, const CItem &it) {
+        const CDecl &d = it.decl;
+        const std::vector<CDerived> &ops = d.decl.ops;
+        const std::string &name = d.decl.name;
+        size_t n = ops.size();
+        if (it.kind == CItem::RECORD) {
+            if (d.spec.body >= 0 && c.unit->records[size_t(d.spec.body)].tag.empty() &&
+                c.unit->records[size_t(d.spec.body)].kind != 'e') {
+                return;  // "struct { ... } variable;"
+            }
+            base(c, d.spec, "");
+            return;
+        }
+        if (it.kind == CItem::FUNCTION) {
+            if (functions_.count(name)) {
+                return;
+            }
+            function(c, name, derive(c, base(c, d.spec, ""), ops, n - 1), ops.back());
+            return;
+        }
+
+        int64_t target;
+        int64_t id = base(c, d.spec, name);
+        if (n == 0 && d.spec.kind == CTypeSpec::TAG && (d.spec.name.empty() || d.spec.name == name)) {
+            target = id;  // the struct, union or enum itself
+        } else if (n >= 2 && ops[n - 2].kind == CDerived::FUNCTION && ops[n - 1].kind == CDerived::POINTER) {
+            target = pointer(typedefs_.count(name) ? find_function(name)
+                                                   : function(c, name, derive(c, id, ops, n - 2), ops[n - 2]));
+        } else if (n >= 1 && ops[n - 1].kind == CDerived::FUNCTION) {
+            target = typedefs_.count(name) ? find_function(name)
+                                           : function(c, name, derive(c, id, ops, n - 1), ops[n - 1]);
+        } else {
+            int64_t to = derive(c, id, ops, n);
+            auto prev = typedefs_.find(name);
+            if (prev != typedefs_.end()) {
+                const DataType *p = find(prev->second);
+                if (prev->second != to && !(p && p->table() == T_TYPEDEF && p->target == to)) {
+                    warnings_.push_back({d.decl.line, "typedef " + name + " redefined differently; first kept"});
+                }
+                return;
+            }
+            DataType &t = create(T_TYPEDEF, name, c.category);
+            t.target = to;
+            target = t.id;
+        }
+        typedefs_.emplace(name, target);
+    }
+
+    int64_t find_function(const std::string &name) {
+        auto it = functions_.find(name);
+        if (it == functions_.end()) {
+            fail("typedef " + name + " redefined as a function type");
+        }
+        return it->second;
+    }
+
+    void define(Context &c, const common::Preprocessor::Define &d) {
+        if (c.defines < 0) {
+            c.defines = category(c.category, "defines");
+        }
+        auto key = std::make_pair(c.defines, d.name);
+        auto it = defines_.find(key);
+        DataType *t;
+        if (it != defines_.end()) {
+            t = &get(it->second);
+        } else {
+            t = &create(T_ENUM, "define_" + d.name, c.defines);
+            t->length = 8;
+            defines_[key] = t->id;
+        }
+        t->values.assign(1, EnumValue{0, d.name, d.value});
+    }
+
+    DataOrganization org_;
+    int64_t time_;
+    std::deque<DataType> types_;  // stable addresses: references live across create()
+    std::unordered_map<int64_t, size_t> by_id_;  // index into types_, so a copy of the compiler is independent
+    std::map<uint8_t, int64_t> next_;
+    std::map<int64_t, Category> categories_;
+    std::map<std::pair<int64_t, std::string>, int64_t> category_ids_;
+    std::map<int64_t, std::string> paths_;
+    std::unordered_map<std::string, int64_t> builtins_, typedefs_, tags_, functions_, constants_;
+    std::unordered_map<int64_t, int64_t> pointers_;
+    std::map<std::pair<int64_t, int64_t>, int64_t> arrays_;
+    std::map<std::pair<int64_t, std::string>, int64_t> defines_;
+    std::set<int64_t> defined_;
+    std::vector<CDiagnostic> warnings_;
+};
+
+
+// A part of a header: the text after a "// name.h" line between two lines
+// of nothing but slashes and asterisks, as header/lua_all.h separates the
+// headers it concatenates. Text before the first banner is a part too.
+struct HeaderPart {
+    std::string name;
+    size_t begin = 0;  // byte offsets
+    size_t end = 0;
+    int line = 1;
+};
+
+inline std::vector<HeaderPart> header_parts(const char *p, size_t n, const std::string &first) {
+    struct Line {
+        size_t begin, end;
+    };
+    std::vector<Line> lines;
+    for (size_t b = 0; b < n;) {
+        size_t e = b;
+        while (e < n && p[e] != '\n') {
+            e++;
+        }
+        lines.push_back({b, e});
+        b = e + 1;
+    }
+    auto text = [&](size_t i) {
+        std::string s(p + lines[i].begin, lines[i].end - lines[i].begin);
+        size_t a = s.find_first_not_of(" \t\r"), z = s.find_last_not_of(" \t\r");
+        return a == std::string::npos ? std::string() : s.substr(a, z - a + 1);
+    };
+    auto banner = [&](size_t i) {
+        std::string s = text(i);
+        return s.size() >= 8 && s.compare(0, 2, "/*") == 0 && s.compare(s.size() - 2, 2, "*/") == 0 &&
+               s.find_first_not_of("/*") == std::string::npos;
+    };
+    std::vector<HeaderPart> parts(1);
+    parts[0].name = first;
+    for (size_t i = 0; i + 2 < lines.size(); i++) {
+        std::string title = text(i + 1);
+        if (banner(i) && banner(i + 2) && title.compare(0, 2, "//") == 0) {
+            parts.back().end = lines[i].begin;
+            HeaderPart next;
+            size_t a = title.find_first_not_of("/ \t");
+            next.name = a == std::string::npos ? first : title.substr(a);
+            next.begin = lines[i].begin;
+            next.line = int(i) + 1;
+            parts.push_back(next);
+            i += 2;
+        }
+    }
+    parts.back().end = n;
+    return parts;
+}
+
+// What <limits.h> and the compiler would define for the data organization.
+inline void predefine(common::Preprocessor &pp, const DataOrganization &org) {
+    bool long64 = org.long_size == 8, ptr64 = org.pointer_size == 8;
+    const std::pair<const char *, const char *> defs[] = {
+        {"__STDC__", "1"},
+        {"__STDC_VERSION__", "199901L"},
+        {"CHAR_BIT", "8"},
+        {"SCHAR_MIN", "(-128)"},
+        {"SCHAR_MAX", "127"},
+        {"UCHAR_MAX", "255"},
+        {"CHAR_MIN", "(-128)"},
+        {"CHAR_MAX", "127"},
+        {"SHRT_MIN", "(-32768)"},
+        {"SHRT_MAX", "32767"},
+        {"USHRT_MAX", "65535"},
+        {"INT_MIN", "(-INT_MAX - 1)"},
+        {"INT_MAX", "2147483647"},
+        {"UINT_MAX", "4294967295U"},
+        {"LONG_MIN", "(-LONG_MAX - 1L)"},
+        {"LONG_MAX", long64 ? "9223372036854775807L" : "2147483647L"},
+        {"ULONG_MAX", long64 ? "18446744073709551615UL" : "4294967295UL"},
+        {"LLONG_MIN", "(-LLONG_MAX - 1LL)"},
+        {"LLONG_MAX", "9223372036854775807LL"},
+        {"ULLONG_MAX", "18446744073709551615ULL"},
+        {"SIZE_MAX", ptr64 ? "18446744073709551615UL" : "4294967295U"},
+        {"PTRDIFF_MAX", ptr64 ? "9223372036854775807L" : "2147483647"},
+        {"__SIZEOF_POINTER__", ptr64 ? "8" : "4"},
+        {"__SIZEOF_LONG__", long64 ? "8" : "4"},
+    };
+    for (const auto &d : defs) {
+        pp.define(d.first, d.second);
+    }
+}
+
+}  // namespace gdt
@@ -0,0 +1,147 @@
+/*
+ *   gdt_consts: name integer constants with the enumeration values of a .gdt
+ *   archive (gdt::ConstantIndex).
+ *
+ *   Values come from the command line or, one or more per line, from stdin,
+ *   so a decompiler pass can pipe every immediate operand through one
+ *   process. Output is one line per value:
+ *
+ *     value  ENUM::NAME,ENUM::NAME,...         (default: exact matches,
+ *                                               by enum and name)
+ *     value  CURLAUTH_BASIC|CURLAUTH_NTLM      (--family CURLAUTH)
+ *     value  FAMILY  decomposition             (--flags, one line per family
+ *                                               with the value as a member or
+ *                                               whose flags cover it)
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -Itools tools/gdt/gdt_consts.cpp -o gdt_consts
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gdt/gdt_consts.hpp"
+
+
+namespace {
+
+struct Options {
+    bool defines_only = false;
+    bool flags = false;
+    bool list = false;
+    std::string family;
+    std::string archive;
+    std::vector<std::string> values;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: gdt_consts [options] archive.gdt [value...]\n"
+                 "  --defines      only use define_* enums\n"
+                 "  --family NAME  decompose values into the flags of one family (CURLAUTH, CURLPROTO, ...)\n"
+                 "  --flags        name values in every family that has them or whose flags cover them\n"
+                 "  --families     list the families with their flag masks\n"
+                 "values are read from stdin when none are given\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--defines") {
+            o.defines_only = true;
+        } else if (a == "--family") {
+            o.family = next();
+        } else if (a == "--flags") {
+            o.flags = true;
+        } else if (a == "--families") {
+            o.list = true;
+        } else if (a.size() > 1 && a[0] == '-' && !(a[1] >= '0' && a[1] <= '9')) {
+            usage();
+        } else if (o.archive.empty()) {
+            o.archive = a;
+        } else {
+            o.values.push_back(a);
+        }
+    }
+    if (o.archive.empty()) {
+        usage();
+    }
+    return o;
+}
+
+bool parse_value(const std::string &s, uint64_t &v) {
+    char *end = nullptr;
+    v = s[0] == '-' ? uint64_t(std::strtoll(s.c_str(), &end, 0)) : std::strtoull(s.c_str(), &end, 0);
+    return end && *end == 0 && end != s.c_str();
+}
+
+void query(const gdt::ConstantIndex &idx, const Options &opt, const gdt::ConstantFamily *family,
+           const std::string &text) {
+    uint64_t v;
+    if (!parse_value(text, v)) {
+        std::fprintf(stderr, "gdt_consts: not a number: %s\n", text.c_str());
+        return;
+    }
+    if (family) {
+        std::printf("%s\t%s\n", text.c_str(), idx.decompose(v, *family).c_str());
+    } else if (opt.flags) {
+        for (const auto &kv : idx.families()) {
+            const gdt::ConstantFamily &f = kv.second;
+            if (v && (f.exact.count(v) || (v & ~f.flags) == 0)) {
+                std::printf("%s\t%s\t%s\n", text.c_str(), f.name.c_str(), idx.decompose(v, f).c_str());
+            }
+        }
+    } else {
+        std::string names;
+        for (const gdt::Constant *c : idx.lookup(v)) {
+            names += (names.empty() ? "" : ",") + c->type->name + "::" + c->value->name;
+        }
+        std::printf("%s\t%s\n", text.c_str(), names.empty() ? "-" : names.c_str());
+    }
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    try {
+        gdt::Archive a(opt.archive);
+        gdt::ConstantIndex idx(a, opt.defines_only);
+        if (opt.list) {
+            for (const auto &kv : idx.families()) {
+                std::printf("%s\t%zu\t0x%" PRIx64 "\n", kv.first.c_str(), kv.second.members.size(), kv.second.flags);
+            }
+            return 0;
+        }
+        const gdt::ConstantFamily *family = nullptr;
+        if (!opt.family.empty() && !(family = idx.family(opt.family))) {
+            throw std::runtime_error("no constant family named " + opt.family);
+        }
+        if (!opt.values.empty()) {
+            for (const std::string &v : opt.values) {
+                query(idx, opt, family, v);
+            }
+        } else {
+            for (std::string v; std::cin >> v;) {
+                query(idx, opt, family, v);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "gdt_consts: %s: %s\n", opt.archive.c_str(), e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+/*
+ *   Reverse index of the enumeration values of a .gdt archive: value ->
+ *   (enum, name), and decomposition of bit masks into named flags.
+ *
+ *   Archives made from headers carry #defines as one-value enums
+ *   ("define_CURLAUTH_NTLM" holding CURLAUTH_NTLM = 8). Such values are
+ *   grouped into families by name: the family of a name is its shortest
+ *   proper '_'-prefix that at least two names continue and whose names
+ *   mostly have distinct values (CURLAUTH_DIGEST_IE -> CURLAUTH, but
+ *   CURL_POLL_IN -> CURL_POLL since CURL_* reuse small numbers); among
+ *   prefixes continued by the same names the longest is taken
+ *   (CURLSSH_AUTH rather than CURLSSH). Names without such a prefix fall
+ *   back to the longest prefix shared at all (CURLPAUSE). Values of real
+ *   enums form the family named after their type.
+ *
+ *   Exact lookups are one hash probe. Each family that is a set of flags
+ *   (mostly single-bit values, not the run 0, 1, 2, ... of a sequential
+ *   enum) keeps the name of every single-bit value by bit position, so a
+ *   decomposition costs one probe plus one table read per set bit of the
+ *   queried value, independent of how many constants the archive holds.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "gdt/gdt_types.hpp"
+
+
+namespace gdt {
+
+struct Constant {
+    const DataType *type;
+    const EnumValue *value;
+    std::string family;
+};
+
+struct ConstantFamily {
+    std::string name;
+    std::vector<const Constant *> members;
+    std::array<const Constant *, 64> bit{};  // first single-bit member per bit
+    uint64_t flags = 0;                       // bits with a name
+    std::unordered_map<uint64_t, const Constant *> exact;
+};
+
+class ConstantIndex {
+  public:
+    // With defines_only, enums not named define_* are left out.
+    explicit ConstantIndex(const Archive &a, bool defines_only = false) {
+        std::vector<std::pair<const DataType *, const EnumValue *>> all;
+        for (const DataType *t : a.types()) {
+            if (t->table() != T_ENUM || (defines_only && !is_define(*t))) {
+                continue;
+            }
+            for (const EnumValue &v : t->values) {
+                all.push_back({t, &v});
+            }
+        }
+        // names continuing after each '_'-prefix, for family assignment
+        std::unordered_map<std::string, Prefix> prefixes;
+        for (const auto &tv : all) {
+            if (is_define(*tv.first)) {
+                const std::string &n = tv.second->name;
+                for (size_t u = n.find('_', 1); u != std::string::npos; u = n.find('_', u + 1)) {
+                    Prefix &p = prefixes[n.substr(0, u)];
+                    p.names++;
+                    p.values.insert(tv.second->value);
+                }
+            }
+        }
+        constants_.reserve(all.size());
+        for (const auto &tv : all) {
+            Constant c{tv.first, tv.second, tv.first->name};
+            if (is_define(*tv.first)) {
+                c.family = define_family(tv.second->name, prefixes);
+            }
+            constants_.push_back(std::move(c));
+        }
+        for (const Constant &c : constants_) {
+            for (uint64_t key : keys(c.value->value)) {
+                std::vector<const Constant *> &same = by_value_[key];
+                bool dup = false;
+                for (const Constant *o : same) {
+                    dup = dup || o->value->name == c.value->name;
+                }
+                if (!dup) {
+                    same.push_back(&c);
+                }
+            }
+            ConstantFamily &f = families_[c.family];
+            f.name = c.family;
+            f.members.push_back(&c);
+            uint64_t v = uint64_t(c.value->value);
+            for (uint64_t key : keys(c.value->value)) {
+                f.exact.emplace(key, &c);
+            }
+            if (v && !(v & (v - 1))) {
+                unsigned b = unsigned(__builtin_ctzll(v));
+                if (!f.bit[b]) {
+                    f.bit[b] = &c;
+                    f.flags |= v;
+                }
+            }
+        }
+        for (auto &kv : families_) {
+            if (!flag_set(kv.second)) {
+                kv.second.bit.fill(nullptr);
+                kv.second.flags = 0;
+            }
+        }
+    }
+
+    const std::vector<Constant> &constants() const { return constants_; }
+    const std::map<std::string, ConstantFamily> &families() const { return families_; }
+
+    const ConstantFamily *family(const std::string &name) const {
+        auto it = families_.find(name);
+        return it == families_.end() ? nullptr : &it->second;
+    }
+
+    // Constants equal to v; negative values are also found by their 32-bit
+    // two's complement (0xffffffef for CURLAUTH_ANY = ~CURLAUTH_DIGEST_IE).
+    const std::vector<const Constant *> &lookup(uint64_t v) const {
+        static const std::vector<const Constant *> none;
+        auto it = by_value_.find(v);
+        return it == by_value_.end() ? none : it->second;
+    }
+
+    // "CURLAUTH_BASIC|CURLAUTH_NTLM", an exact member name if there is one,
+    // and bits without a name as a trailing hex remainder ("...|0x100").
+    std::string decompose(uint64_t v, const ConstantFamily &f) const {
+        auto e = f.exact.find(v);
+        if (e != f.exact.end()) {
+            return e->second->value->name;
+        }
+        std::string out;
+        for (uint64_t bits = v & f.flags; bits; bits &= bits - 1) {
+            out += (out.empty() ? "" : "|") + f.bit[__builtin_ctzll(bits)]->value->name;
+        }
+        if (v & ~f.flags) {
+            char rest[24];
+            std::snprintf(rest, sizeof rest, "0x%llx", static_cast<unsigned long long>(v & ~f.flags));
+            out += (out.empty() ? "" : "|") + std::string(rest);
+        }
+        return out;
+    }
+
+    static bool is_define(const DataType &t) { return t.name.compare(0, 7, "define_") == 0; }
+
+  private:
+    struct Prefix {
+        unsigned names = 0;
+        std::unordered_set<int64_t> values;
+    };
+
+    static std::string define_family(const std::string &n, const std::unordered_map<std::string, Prefix> &prefixes) {
+        std::string best, shared;  // shared: longest prefix continued by two names
+        unsigned best_names = 0;
+        for (size_t u = n.find('_', 1); u != std::string::npos; u = n.find('_', u + 1)) {
+            const Prefix &p = prefixes.at(n.substr(0, u));
+            if (p.names < 2) {
+                break;
+            }
+            shared = n.substr(0, u);
+            if (best.empty() ? p.values.size() * 4 >= p.names * 3 : p.names == best_names) {
+                best = shared;
+                best_names = p.names;
+            } else if (!best.empty()) {
+                break;
+            }
+        }
+        return !best.empty() ? best : !shared.empty() ? shared : n;
+    }
+
+    // Whether a family's values are flags rather than a count: most of its
+    // distinct non-zero values are single bits (masks such as
+    // CURLAUTH_ANY may be among the rest), and they are not a run 1, 2, 3,
+    // ... as in a sequential enum, whose 1, 2, 4 and 8 are no flags.
+    static bool flag_set(const ConstantFamily &f) {
+        std::set<uint64_t> values;
+        for (const Constant *c : f.members) {
+            if (c->value->value) {
+                values.insert(uint64_t(c->value->value));
+            }
+        }
+        size_t single = 0;
+        for (uint64_t v : values) {
+            single += !(v & (v - 1));
+        }
+        bool run = values.size() >= 2 && *values.begin() == 1 && *values.rbegin() == values.size();
+        return single >= 2 && single * 2 > values.size() && !run;
+    }
+
+    static std::vector<uint64_t> keys(int64_t v) {
+        std::vector<uint64_t> k{uint64_t(v)};
+        if (v < 0 && v >= INT32_MIN) {
+            k.push_back(uint64_t(uint32_t(v)));
+        }
+        return k;
+    }
+
+    std::vector<Constant> constants_;
+    std::unordered_map<uint64_t, std::vector<const Constant *>> by_value_;
+    std::map<std::string, ConstantFamily> families_;
+};
+
+}  // namespace gdt
@@ -0,0 +1,563 @@
+/*
+ *   Declarations of a preprocessed C header (common/c_preprocessor.hpp), as
+ *   the type compiler (gdt_compile.hpp) needs them: typedefs, struct, union
+ *   and enum definitions and function prototypes. Variables are dropped
+ *   (archives hold types) and function bodies skipped.
+ *
+ *   Parsing needs no symbol table, so parts of a header parse
+ *   independently of each other: an identifier in declaration specifiers
+ *   is a type name when no type specifier came before it ("lua_State *L",
+ *   but "unsigned x"). Array sizes, enum values and bit widths stay token
+ *   sequences; the compiler evaluates them once it knows the enum
+ *   constants and type sizes of all parts.
+ *
+ *   A declaration that does not parse is skipped up to the next ';' (or
+ *   the '}' closing it) and noted in the unit's diagnostics.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/c_preprocessor.hpp"
+
+
+namespace gdt {
+
+using common::CToken;
+
+struct CDecl;
+
+// Derived type of a declarator: pointer to, array of, function returning.
+struct CDerived {
+    enum Kind : uint8_t { POINTER, ARRAY, FUNCTION };
+
+    Kind kind = POINTER;
+    std::vector<CToken> dim;     // arrays; empty for []
+    std::vector<CDecl> params;   // functions
+    bool varargs = false;
+};
+
+struct CTypeSpec {
+    enum Kind : uint8_t { BUILTIN, NAME, TAG };
+
+    Kind kind = BUILTIN;
+    std::string name;   // built-in ("int", "uchar", "longlong") or typedef name, or tag (empty when anonymous)
+    char tag = 0;       // 's', 'u' or 'e'
+    int body = -1;      // index of the definition in CUnit::records when given here
+};
+
+struct CDeclarator {
+    std::string name;
+    std::vector<CDerived> ops;  // in the order they apply to the base type
+    std::vector<CToken> bits;   // bit-field width
+    bool bitfield = false;
+    int line = 0;
+
+    bool is_function() const { return !ops.empty() && ops.back().kind == CDerived::FUNCTION; }
+};
+
+struct CDecl {
+    CTypeSpec spec;
+    CDeclarator decl;
+};
+
+struct CRecord {
+    char kind = 's';  // 's' struct, 'u' union, 'e' enum
+    std::string tag;
+    std::vector<CDecl> members;
+    std::vector<std::pair<std::string, std::vector<CToken>>> enumerators;  // value tokens empty: previous + 1
+    int line = 0;
+};
+
+struct CItem {
+    enum Kind : uint8_t { TYPEDEF, FUNCTION, RECORD };
+
+    Kind kind = RECORD;
+    CDecl decl;  // RECORD: the specifier only ("struct X { ... };", "struct X;")
+};
+
+struct CDiagnostic {
+    int line = 0;
+    std::string message;
+};
+
+// The declarations of one part of a header.
+struct CUnit {
+    std::string name;
+    std::vector<CRecord> records;
+    std::vector<CItem> items;
+    std::vector<common::Preprocessor::Define> defines;
+    std::vector<CDiagnostic> diagnostics;
+};
+
+class CParser {
+  public:
+    CParser(const std::vector<CToken> &t, CUnit &unit, size_t pos = 0) : t_(t), unit_(unit), pos_(pos) {}
+
+    size_t pos() const { return pos_; }
+
+    void parse() {
+        while (pos_ < t_.size()) {
+            size_t start = pos_;
+            try {
+                declaration();
+            } catch (const common::CppError &e) {
+                unit_.diagnostics.push_back({t_[std::min(start, t_.size() - 1)].line, e.what()});
+                recover(start);
+            }
+        }
+    }
+
+    // A type name as in casts and sizeof: specifiers and an abstract
+    // declarator. False when no specifier starts at pos().
+    bool type_name(CDecl &d) {
+        size_t save = pos_;
+        bool is_typedef = false;
+        try {
+            if (!specifiers(d.spec, is_typedef)) {
+                pos_ = save;
+                return false;
+            }
+            declarator(d.decl);
+        } catch (const common::CppError &) {
+            pos_ = save;
+            return false;
+        }
+        if (!d.decl.name.empty()) {
+            pos_ = save;
+            return false;
+        }
+        return true;
+    }
+
+    static bool type_keyword(const std::string &s) {
+        static const char *const words[] = {"void",   "char",   "short",    "int",    "long",   "float",
+                                            "double", "signed", "unsigned", "_Bool",  "struct", "union",
+                                            "enum",   "const",  "volatile", "__signed__"};
+        for (const char *w : words) {
+            if (s == w) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    [[noreturn]] void fail(const std::string &msg) const {
+        throw common::CppError(msg + (pos_ < t_.size() ? " at '" + t_[pos_].text + "'" : " at end of input"));
+    }
+
+    bool at(const char *s) const { return pos_ < t_.size() && t_[pos_].is(s); }
+
+    bool accept(const char *s) {
+        if (at(s)) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(const char *s) {
+        if (!accept(s)) {
+            fail(std::string("expected '") + s + "'");
+        }
+    }
+
+    int line() const { return pos_ < t_.size() ? t_[pos_].line : (t_.empty() ? 0 : t_.back().line); }
+
+    // Skips a balanced group opened at pos() ("(", "[" or "{").
+    void skip_group() {
+        int depth = 0;
+        do {
+            if (pos_ >= t_.size()) {
+                fail("unbalanced brackets");
+            }
+            const CToken &k = t_[pos_++];
+            depth += k.is("(") || k.is("[") || k.is("{") ? 1 : k.is(")") || k.is("]") || k.is("}") ? -1 : 0;
+        } while (depth > 0);
+    }
+
+    // Tokens up to (not including) one of the closers at depth 0.
+    std::vector<CToken> until(const char *a, const char *b = nullptr) {
+        std::vector<CToken> r;
+        int depth = 0;
+        while (pos_ < t_.size()) {
+            const CToken &k = t_[pos_];
+            if (depth == 0 && (k.is(a) || (b && k.is(b)))) {
+                return r;
+            }
+            depth += k.is("(") || k.is("[") || k.is("{") ? 1 : k.is(")") || k.is("]") || k.is("}") ? -1 : 0;
+            r.push_back(k);
+            pos_++;
+        }
+        fail(std::string("expected '") + a + "'");
+    }
+
+    // Skips the declaration starting at 'start': up to the ';' ending it,
+    // or past the body of a function definition.
+    void recover(size_t start) {
+        pos_ = start;
+        int depth = 0;
+        bool body = false;
+        while (pos_ < t_.size()) {
+            const CToken &k = t_[pos_++];
+            if (k.is("(") || k.is("[") || k.is("{")) {
+                if (depth++ == 0 && k.is("{")) {
+                    body = pos_ >= 2 && t_[pos_ - 2].is(")");
+                }
+            } else if (k.is(")") || k.is("]") || k.is("}")) {
+                depth = std::max(depth - 1, 0);
+                if (depth == 0 && k.is("}") && body) {
+                    return;
+                }
+            } else if (k.is(";") && depth == 0) {
+                return;
+            }
+        }
+    }
+
+    // __attribute__((...)), __declspec(...), __asm__("...")
+    bool attribute() {
+        if (pos_ < t_.size() && (t_[pos_].is("__attribute__") || t_[pos_].is("__attribute") ||
+                                 t_[pos_].is("__declspec") || t_[pos_].is("__asm__") || t_[pos_].is("asm") ||
+                                 t_[pos_].is("__asm"))) {
+            pos_++;
+            if (at("(")) {
+                skip_group();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    bool qualifier() {
+        static const char *const words[] = {"const",      "volatile",   "restrict", "__restrict", "__restrict__",
+                                            "__const",    "_Atomic",    "__volatile__", "__extension__"};
+        for (const char *w : words) {
+            if (accept(w)) {
+                return true;
+            }
+        }
+        return attribute();
+    }
+
+    // Declaration specifiers; false if there were none.
+    bool specifiers(CTypeSpec &s, bool &is_typedef) {
+        static const char *const storage[] = {"extern", "static",   "auto",     "register", "inline",
+                                              "__inline", "__inline__", "_Noreturn", "_Thread_local"};
+        int n_void = 0, n_char = 0, n_short = 0, n_int = 0, n_long = 0, n_float = 0, n_double = 0, n_bool = 0;
+        bool is_signed = false, is_unsigned = false, named = false, any = false;
+        for (;;) {
+            if (pos_ >= t_.size()) {
+                break;
+            }
+            const CToken &k = t_[pos_];
+            bool words = n_void + n_char + n_short + n_int + n_long + n_float + n_double + n_bool > 0 ||
+                         is_signed || is_unsigned;
+            if (k.is("typedef")) {
+                is_typedef = true;
+            } else if (std::find_if(std::begin(storage), std::end(storage), [&](const char *w) { return k.is(w); }) !=
+                       std::end(storage)) {
+            } else if (qualifier()) {
+                any = true;
+                continue;
+            } else if (k.is("void")) {
+                n_void++;
+            } else if (k.is("char")) {
+                n_char++;
+            } else if (k.is("short")) {
+                n_short++;
+            } else if (k.is("int")) {
+                n_int++;
+            } else if (k.is("long")) {
+                n_long++;
+            } else if (k.is("float")) {
+                n_float++;
+            } else if (k.is("double")) {
+                n_double++;
+            } else if (k.is("_Bool") || k.is("bool")) {
+                n_bool++;
+            } else if (k.is("signed") || k.is("__signed__") || k.is("__signed")) {
+                is_signed = true;
+            } else if (k.is("unsigned")) {
+                is_unsigned = true;
+            } else if ((k.is("struct") || k.is("union") || k.is("enum")) && !words && !named) {
+                pos_++;
+                record(s, k.text[0]);
+                named = true;
+                any = true;
+                continue;
+            } else if (k.kind == CToken::IDENT && !words && !named && !type_keyword(k.text)) {
+                s.kind = CTypeSpec::NAME;
+                s.name = k.text;
+                named = true;
+            } else {
+                break;
+            }
+            pos_++;
+            any = true;
+        }
+        if (!named) {
+            s.kind = CTypeSpec::BUILTIN;
+            if (n_void) {
+                s.name = "void";
+            } else if (n_bool) {
+                s.name = "bool";
+            } else if (n_char) {
+                s.name = is_unsigned ? "uchar" : is_signed ? "schar" : "char";
+            } else if (n_short) {
+                s.name = is_unsigned ? "ushort" : "short";
+            } else if (n_long >= 2) {
+                s.name = is_unsigned ? "ulonglong" : "longlong";
+            } else if (n_double) {
+                s.name = n_long ? "longdouble" : "double";
+            } else if (n_float) {
+                s.name = "float";
+            } else if (n_long) {
+                s.name = is_unsigned ? "ulong" : "long";
+            } else {
+                s.name = is_unsigned ? "uint" : "int";  // also implicit int
+            }
+        }
+        return any;
+    }
+
+    // After "struct", "union" or "enum": tag and/or body.
+    void record(CTypeSpec &s, char kind) {
+        s.kind = CTypeSpec::TAG;
+        s.tag = kind;
+        while (attribute()) {
+        }
+        if (pos_ < t_.size() && t_[pos_].kind == CToken::IDENT) {
+            s.name = t_[pos_++].text;
+        }
+        while (attribute()) {
+        }
+        if (!at("{")) {
+            if (s.name.empty()) {
+                fail("anonymous declaration without a body");
+            }
+            return;
+        }
+        CRecord r;
+        r.kind = kind;
+        r.tag = s.name;
+        r.line = line();
+        pos_++;
+        if (kind == 'e') {
+            while (!accept("}")) {
+                if (pos_ >= t_.size() || t_[pos_].kind != CToken::IDENT) {
+                    fail("expected an enumerator");
+                }
+                std::string name = t_[pos_++].text;
+                std::vector<CToken> value;
+                if (accept("=")) {
+                    value = until(",", "}");
+                    if (value.empty()) {
+                        fail("empty enumerator value");
+                    }
+                }
+                r.enumerators.emplace_back(name, std::move(value));
+                if (!accept(",")) {
+                    expect("}");
+                    break;
+                }
+            }
+        } else {
+            while (!accept("}")) {
+                if (accept(";")) {
+                    continue;
+                }
+                CDecl base;
+                bool is_typedef = false;
+                if (!specifiers(base.spec, is_typedef)) {
+                    fail("expected a member declaration");
+                }
+                if (at(";")) {  // anonymous struct or union member
+                    pos_++;
+                    base.decl.line = line();
+                    r.members.push_back(std::move(base));
+                    continue;
+                }
+                for (;;) {
+                    CDecl m;
+                    m.spec = base.spec;
+                    declarator(m.decl);
+                    if (accept(":")) {
+                        m.decl.bitfield = true;
+                        m.decl.bits = until(",", ";");
+                    }
+                    while (attribute()) {
+                    }
+                    r.members.push_back(std::move(m));
+                    if (!accept(",")) {
+                        break;
+                    }
+                }
+                expect(";");
+            }
+        }
+        while (attribute()) {
+        }
+        s.body = int(unit_.records.size());
+        unit_.records.push_back(std::move(r));
+    }
+
+    // '(' of a declarator: nested declarator rather than a parameter list.
+    bool nested() const {
+        if (pos_ + 1 >= t_.size()) {
+            return false;
+        }
+        const CToken &k = t_[pos_ + 1];
+        if (k.is("*") || k.is("^") || k.is("__attribute__")) {
+            return true;
+        }
+        return k.kind == CToken::IDENT && !type_keyword(k.text) && pos_ + 2 < t_.size() &&
+               (t_[pos_ + 2].is(")") || t_[pos_ + 2].is("["));
+    }
+
+    // Declarator, possibly abstract (no name).
+    void declarator(CDeclarator &d) {
+        d.line = line();
+        int pointers = 0;
+        while (accept("*")) {
+            pointers++;
+            while (qualifier()) {
+            }
+        }
+        while (attribute()) {
+        }
+        CDeclarator inner;
+        bool has_inner = false;
+        if (at("(") && nested()) {
+            pos_++;
+            declarator(inner);
+            expect(")");
+            has_inner = true;
+        } else if (pos_ < t_.size() && t_[pos_].kind == CToken::IDENT && !type_keyword(t_[pos_].text)) {
+            d.name = t_[pos_++].text;
+        }
+        std::vector<CDerived> suffixes;
+        for (;;) {
+            if (accept("[")) {
+                CDerived a;
+                a.kind = CDerived::ARRAY;
+                while (accept("static") || qualifier()) {
+                }
+                a.dim = until("]");
+                pos_++;
+                suffixes.push_back(std::move(a));
+            } else if (accept("(")) {
+                CDerived f;
+                f.kind = CDerived::FUNCTION;
+                parameters(f);
+                suffixes.push_back(std::move(f));
+            } else {
+                break;
+            }
+        }
+        while (attribute()) {
+        }
+        d.ops.assign(size_t(pointers), CDerived());
+        d.ops.insert(d.ops.end(), std::make_move_iterator(suffixes.rbegin()), std::make_move_iterator(suffixes.rend()));
+        if (has_inner) {
+            d.name = inner.name;
+            d.ops.insert(d.ops.end(), std::make_move_iterator(inner.ops.begin()),
+                         std::make_move_iterator(inner.ops.end()));
+        }
+    }
+
+    // After '(': "void)", ")" (no prototype) or the parameter declarations.
+    void parameters(CDerived &f) {
+        if (accept(")")) {
+            return;
+        }
+        if (at("void") && pos_ + 1 < t_.size() && t_[pos_ + 1].is(")")) {
+            pos_ += 2;
+            return;
+        }
+        for (;;) {
+            if (accept("...")) {
+                f.varargs = true;
+                expect(")");
+                return;
+            }
+            CDecl p;
+            bool is_typedef = false;
+            if (!specifiers(p.spec, is_typedef)) {
+                fail("expected a parameter declaration");
+            }
+            declarator(p.decl);
+            f.params.push_back(std::move(p));
+            if (accept(")")) {
+                return;
+            }
+            expect(",");
+        }
+    }
+
+    void declaration() {
+        if (accept(";")) {
+            return;
+        }
+        CTypeSpec spec;
+        bool is_typedef = false;
+        if (!specifiers(spec, is_typedef)) {
+            fail("expected a declaration");
+        }
+        bool recorded = false;
+        auto record_item = [&]() {
+            if (spec.kind == CTypeSpec::TAG && !recorded) {
+                CItem it;
+                it.kind = CItem::RECORD;
+                it.decl.spec = spec;
+                it.decl.decl.line = line();
+                unit_.items.push_back(std::move(it));
+                recorded = true;
+            }
+        };
+        if (accept(";")) {
+            record_item();
+            return;
+        }
+        for (;;) {
+            CItem it;
+            it.decl.spec = spec;
+            declarator(it.decl.decl);
+            if (it.decl.decl.name.empty()) {
+                fail("expected a declarator name");
+            }
+            if (accept("=")) {
+                until(",", ";");
+            }
+            if (is_typedef) {
+                it.kind = CItem::TYPEDEF;
+                unit_.items.push_back(std::move(it));
+            } else if (it.decl.decl.is_function()) {
+                it.kind = CItem::FUNCTION;
+                unit_.items.push_back(std::move(it));
+                if (at("{")) {  // definition
+                    skip_group();
+                    return;
+                }
+            } else if (spec.body >= 0) {  // a variable of a type defined here
+                record_item();
+            }
+            if (!accept(",")) {
+                break;
+            }
+        }
+        expect(";");
+    }
+
+    const std::vector<CToken> &t_;
+    CUnit &unit_;
+    size_t pos_ = 0;
+};
+
+}  // namespace gdt
@@ -0,0 +1,359 @@
+/*
+ *   Read-only access to the database inside a Ghidra data type archive
+ *   (.gdt, a "packed database").
+ *
+ *   Layers, outermost first:
+ *
+ *     container   Java serialization stream: block data holding the packed
+ *                 database magic and item name, followed by a zip entry
+ *                 FOLDER_ITEM (deflate, sizes in a data descriptor)
+ *     buffer file header block, then 16 KiB blocks: flag byte (0 = in use),
+ *                 big-endian buffer id, 16379 bytes of buffer data
+ *     tables      buffer 0 holds the database parameters; parameter 0 is the
+ *                 root of the master table, whose records describe every
+ *                 table (name, root buffer, key type, field types and names)
+ *     records     B-tree nodes keyed by long (node types 0-2) or by a field
+ *                 value (3-4); fields are big-endian byte/short/int/long,
+ *                 length-prefixed string/binary (-1 = null) and boolean
+ *
+ *   Only the primary tables (index column -1, long keys) are of interest to
+ *   the tools; index tables are listed but not decoded.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/inflate.hpp"
+#include "common/mapped_file.hpp"
+
+
+namespace gdt {
+
+constexpr uint64_t PACKED_DB_MAGIC = 0x2e30212634e92c20ull;
+constexpr uint64_t BUFFER_FILE_MAGIC = 0x2f30312c34292c2aull;
+constexpr size_t BLOCK_SIZE = 0x4000;
+constexpr size_t BLOCK_HEADER = 5;  // flag byte + buffer id
+constexpr size_t BUFFER_SIZE = BLOCK_SIZE - BLOCK_HEADER;
+
+// Field types of Ghidra's db package
+enum FieldType : uint8_t {
+    F_BYTE = 0,
+    F_SHORT = 1,
+    F_INT = 2,
+    F_LONG = 3,
+    F_STRING = 4,
+    F_BINARY = 5,
+    F_BOOLEAN = 6,
+};
+
+// B-tree node types
+enum NodeType : uint8_t {
+    LONGKEY_INTERIOR = 0,
+    LONGKEY_VAR_REC = 1,
+    LONGKEY_FIXED_REC = 2,
+    VARKEY_INTERIOR = 3,
+    VARKEY_REC = 4,
+};
+
+class FormatError : public std::runtime_error {
+  public:
+    explicit FormatError(const std::string &msg) : std::runtime_error(msg) {}
+};
+
+struct Value {
+    int64_t i = 0;      // byte/short/int/long/boolean
+    std::string s;      // string/binary
+    bool null = false;  // null string/binary
+};
+
+typedef std::vector<Value> Record;
+
+struct TableSchema {
+    std::string name;
+    int32_t version = 0;
+    int32_t root = -1;  // buffer id, -1 for an empty table
+    uint8_t key_type = F_LONG;
+    std::vector<uint8_t> field_types;
+    std::vector<std::string> field_names;  // key name first
+    int32_t index_column = -1;             // -1 for primary tables
+    int64_t max_key = 0;
+    int32_t records = 0;
+
+    // Position of a (non-key) field by name, -1 if absent.
+    int field(const std::string &n) const {
+        for (size_t i = 1; i < field_names.size(); i++) {
+            if (field_names[i] == n) {
+                return static_cast<int>(i - 1);
+            }
+        }
+        return -1;
+    }
+};
+
+inline uint32_t be32(const uint8_t *p) {
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+}
+
+inline uint64_t be64(const uint8_t *p) {
+    return uint64_t(be32(p)) << 32 | be32(p + 4);
+}
+
+// Unpacks FOLDER_ITEM from a .gdt container; returns the buffer file image.
+inline std::vector<uint8_t> unpack_container(const uint8_t *d, size_t n) {
+    // STREAM_MAGIC, STREAM_VERSION, TC_BLOCKDATA with a one-byte length
+    if (n < 14 || d[0] != 0xac || d[1] != 0xed || d[4] != 0x77 || be64(d + 6) != PACKED_DB_MAGIC) {
+        throw FormatError("not a packed database");
+    }
+    size_t zip = 6 + d[5];
+    if (zip + 30 > n || std::memcmp(d + zip, "PK\x03\x04", 4) != 0) {
+        throw FormatError("packed database: no zip entry");
+    }
+    const uint8_t *h = d + zip;
+    unsigned method = h[8] | h[9] << 8;
+    size_t name_len = h[26] | h[27] << 8;
+    size_t extra_len = h[28] | h[29] << 8;
+    size_t data = zip + 30 + name_len + extra_len;
+    if (data > n || std::string(reinterpret_cast<const char *>(h + 30), name_len) != "FOLDER_ITEM") {
+        throw FormatError("packed database: unexpected zip entry");
+    }
+    std::vector<uint8_t> out;
+    if (method == 8) {
+        common::inflate(d + data, n - data, out);
+    } else if (method == 0) {
+        size_t size = h[18] | h[19] << 8 | size_t(h[20]) << 16 | size_t(h[21]) << 24;
+        if (size > n - data) {
+            throw FormatError("packed database: truncated entry");
+        }
+        out.assign(d + data, d + data + size);
+    } else {
+        throw FormatError("packed database: unsupported compression method");
+    }
+    return out;
+}
+
+class Database {
+  public:
+    // Opens a .gdt container, or a bare buffer file (an unpacked FOLDER_ITEM).
+    explicit Database(const std::string &path) {
+        common::MappedFile f(path);
+        const uint8_t *d = f.data();
+        if (f.size() >= 8 && be64(d) == BUFFER_FILE_MAGIC) {
+            image_.assign(d, d + f.size());
+        } else {
+            image_ = unpack_container(d, f.size());
+        }
+        load();
+    }
+
+    Database(const uint8_t *d, size_t n) {
+        image_ = n >= 8 && be64(d) == BUFFER_FILE_MAGIC ? std::vector<uint8_t>(d, d + n) : unpack_container(d, n);
+        load();
+    }
+
+    const std::vector<TableSchema> &tables() const { return tables_; }
+
+    // The primary table named 'name', or nullptr.
+    const TableSchema *table(const std::string &name) const {
+        for (const TableSchema &t : tables_) {
+            if (t.name == name && t.index_column == -1) {
+                return &t;
+            }
+        }
+        return nullptr;
+    }
+
+    // Calls fn(key, record) for every record of a long-keyed table, in key order.
+    void scan(const TableSchema &t, const std::function<void(int64_t, const Record &)> &fn) const {
+        if (t.root >= 0) {
+            scan_node(t, t.root, fn, 0);
+        }
+    }
+
+    const uint8_t *buffer(int32_t id) const {
+        auto it = buffers_.find(id);
+        if (it == buffers_.end()) {
+            throw FormatError("missing buffer " + std::to_string(id));
+        }
+        return it->second;
+    }
+
+    const std::vector<uint8_t> &image() const { return image_; }
+    int32_t master_root() const { return master_root_; }
+    // The universal id of a data type archive (0 if the parameters lack it).
+    int64_t database_id() const { return database_id_; }
+
+  private:
+    void load() {
+        if (image_.size() < 2 * BLOCK_SIZE || be64(image_.data()) != BUFFER_FILE_MAGIC) {
+            throw FormatError("not a buffer file");
+        }
+        for (size_t off = BLOCK_SIZE; off + BLOCK_SIZE <= image_.size(); off += BLOCK_SIZE) {
+            const uint8_t *b = image_.data() + off;
+            if (b[0] == 0) {
+                buffers_[static_cast<int32_t>(be32(b + 1))] = b + BLOCK_HEADER;
+            }
+        }
+        // DBParms: node type, length, version byte, then one int per
+        // parameter: master table root, database id high and low word
+        const uint8_t *p = buffer(0);
+        master_root_ = static_cast<int32_t>(be32(p + 6));
+        if (be32(p + 1) >= 13) {
+            database_id_ = static_cast<int64_t>(uint64_t(be32(p + 10)) << 32 | be32(p + 14));
+        }
+
+        TableSchema master;
+        master.name = "Master Table";
+        master.root = master_root_;
+        master.field_types = {F_STRING, F_INT, F_INT, F_BYTE, F_BINARY, F_STRING, F_INT, F_LONG, F_INT};
+        scan(master, [&](int64_t, const Record &r) {
+            TableSchema t;
+            t.name = r[0].s;
+            t.version = static_cast<int32_t>(r[1].i);
+            t.root = static_cast<int32_t>(r[2].i);
+            t.key_type = static_cast<uint8_t>(r[3].i);
+            t.field_types.assign(r[4].s.begin(), r[4].s.end());
+            size_t start = 0;
+            const std::string &names = r[5].s;
+            for (size_t semi; (semi = names.find(';', start)) != std::string::npos; start = semi + 1) {
+                t.field_names.push_back(names.substr(start, semi - start));
+            }
+            t.index_column = static_cast<int32_t>(r[6].i);
+            t.max_key = r[7].i;
+            t.records = static_cast<int32_t>(r[8].i);
+            tables_.push_back(std::move(t));
+        });
+    }
+
+    static size_t fixed_length(uint8_t t) {
+        switch (t) {
+        case F_BYTE:
+        case F_BOOLEAN: return 1;
+        case F_SHORT: return 2;
+        case F_INT: return 4;
+        case F_LONG: return 8;
+        default: return 0;
+        }
+    }
+
+    static size_t read_field(const uint8_t *b, size_t off, uint8_t t, Value &v) {
+        auto need = [&](size_t n) {
+            if (off + n > BUFFER_SIZE) {
+                throw FormatError("record crosses buffer end");
+            }
+        };
+        v.null = false;
+        switch (t) {
+        case F_BYTE:
+            need(1);
+            v.i = static_cast<int8_t>(b[off]);
+            return off + 1;
+        case F_BOOLEAN:
+            need(1);
+            v.i = b[off] != 0;
+            return off + 1;
+        case F_SHORT:
+            need(2);
+            v.i = static_cast<int16_t>(b[off] << 8 | b[off + 1]);
+            return off + 2;
+        case F_INT:
+            need(4);
+            v.i = static_cast<int32_t>(be32(b + off));
+            return off + 4;
+        case F_LONG:
+            need(8);
+            v.i = static_cast<int64_t>(be64(b + off));
+            return off + 8;
+        case F_STRING:
+        case F_BINARY: {
+            need(4);
+            int32_t len = static_cast<int32_t>(be32(b + off));
+            off += 4;
+            if (len < 0) {
+                v.null = true;
+                v.s.clear();
+                return off;
+            }
+            need(static_cast<size_t>(len));
+            v.s.assign(reinterpret_cast<const char *>(b + off), static_cast<size_t>(len));
+            return off + static_cast<size_t>(len);
+        }
+        default:
+            throw FormatError("unknown field type " + std::to_string(t));
+        }
+    }
+
+    static void read_record(const uint8_t *b, size_t off, const TableSchema &t, Record &r) {
+        r.resize(t.field_types.size());
+        for (size_t i = 0; i < t.field_types.size(); i++) {
+            off = read_field(b, off, t.field_types[i], r[i]);
+        }
+    }
+
+    void scan_node(const TableSchema &t, int32_t id, const std::function<void(int64_t, const Record &)> &fn,
+                   int depth) const {
+        if (depth > 32) {
+            throw FormatError(t.name + ": B-tree too deep");
+        }
+        const uint8_t *b = buffer(id);
+        uint32_t n = be32(b + 1);
+        Record r;
+        switch (b[0]) {
+        case LONGKEY_INTERIOR:
+            if (5 + size_t(n) * 12 > BUFFER_SIZE) {
+                throw FormatError(t.name + ": bad interior node");
+            }
+            for (uint32_t k = 0; k < n; k++) {
+                scan_node(t, static_cast<int32_t>(be32(b + 5 + k * 12 + 8)), fn, depth + 1);
+            }
+            break;
+        case LONGKEY_VAR_REC:
+            if (13 + size_t(n) * 13 > BUFFER_SIZE) {
+                throw FormatError(t.name + ": bad record node");
+            }
+            for (uint32_t k = 0; k < n; k++) {
+                const uint8_t *e = b + 13 + k * 13;
+                if (e[12]) {
+                    throw FormatError(t.name + ": indirect (chained) records are not supported");
+                }
+                read_record(b, be32(e + 8), t, r);
+                fn(static_cast<int64_t>(be64(e)), r);
+            }
+            break;
+        case LONGKEY_FIXED_REC: {
+            size_t len = 0;
+            for (uint8_t ft : t.field_types) {
+                if (!fixed_length(ft)) {
+                    throw FormatError(t.name + ": variable field in fixed-length node");
+                }
+                len += fixed_length(ft);
+            }
+            if (13 + size_t(n) * (8 + len) > BUFFER_SIZE) {
+                throw FormatError(t.name + ": bad record node");
+            }
+            for (uint32_t k = 0; k < n; k++) {
+                size_t off = 13 + k * (8 + len);
+                read_record(b, off + 8, t, r);
+                fn(static_cast<int64_t>(be64(b + off)), r);
+            }
+            break;
+        }
+        default:
+            throw FormatError(t.name + ": unsupported node type " + std::to_string(b[0]));
+        }
+    }
+
+    std::vector<uint8_t> image_;
+    std::unordered_map<int32_t, const uint8_t *> buffers_;
+    int32_t master_root_ = -1;
+    int64_t database_id_ = 0;
+    std::vector<TableSchema> tables_;
+};
+
+}  // namespace gdt
@@ -0,0 +1,453 @@
+/*
+ *   Writing Ghidra packed databases: the inverse of gdt_db.hpp.
+ *
+ *   Tables are bulk-loaded rather than inserted one record at a time: the
+ *   rows are sorted by key and packed left to right into as few leaves as
+ *   they fit in, the leaves are linked, and interior levels are built over
+ *   them until a single root remains. A primary table may name long
+ *   columns to index; each index table is written right after it under the
+ *   same name, keyed by (indexed value, primary key) with no fields, as
+ *   Ghidra's field indexes are (variable-key nodes, key type 0x80 | field
+ *   type).
+ *
+ *   The image is a buffer file in which every buffer is in use: the header
+ *   block (magic, file id, format version 1, block size, no free buffer, no
+ *   parameters), DBParms in buffer 0, the tables, and the master table
+ *   last. pack_container() wraps the image the way Ghidra's ItemSerializer
+ *   does: serialized header, then a deflated FOLDER_ITEM zip entry closed
+ *   by a data descriptor, without a central directory.
+ *
+ *   Records are stored inline; one longer than a quarter of a node would
+ *   need Ghidra's chained (indirect) storage and is rejected.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/columnar.hpp"
+#include "common/deflate.hpp"
+#include "common/hash.hpp"
+#include "gdt/gdt_db.hpp"
+
+
+namespace gdt {
+
+constexpr uint8_t INDEX_KEY_FLAG = 0x80;
+constexpr int64_t NO_MAX_KEY = INT64_MIN;  // max key of index and empty tables
+
+struct Row {
+    Value key;  // .i for long keys, .s for string keys
+    Record fields;
+};
+
+struct TableData {
+    TableSchema schema;            // name, version, key type, field types and names
+    std::vector<int32_t> indexed;  // long columns with an index table
+    std::vector<Row> rows;
+};
+
+namespace detail {
+
+inline void put_be(std::string &out, uint64_t v, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) {
+        out.push_back(static_cast<char>(v >> (8 * i)));
+    }
+}
+
+inline void put_field(std::string &out, uint8_t type, const Value &v) {
+    switch (type) {
+    case F_BYTE:
+    case F_BOOLEAN: put_be(out, uint64_t(v.i), 1); break;
+    case F_SHORT: put_be(out, uint64_t(v.i), 2); break;
+    case F_INT: put_be(out, uint64_t(v.i), 4); break;
+    case F_LONG: put_be(out, uint64_t(v.i), 8); break;
+    case F_STRING:
+    case F_BINARY:
+        if (v.null) {
+            put_be(out, uint32_t(-1), 4);
+        } else {
+            put_be(out, v.s.size(), 4);
+            out += v.s;
+        }
+        break;
+    default: throw FormatError("unknown field type " + std::to_string(type));
+    }
+}
+
+inline void store_be(uint8_t *p, uint64_t v, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) {
+        *p++ = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+}  // namespace detail
+
+class DatabaseWriter {
+  public:
+    // database_id is what a data type archive is known by (its universal
+    // id); file_id that of the buffer file, derived from it by default.
+    explicit DatabaseWriter(int64_t database_id, uint64_t file_id = 0)
+        : database_id_(database_id), file_id_(file_id ? file_id : common::mix64(uint64_t(database_id))) {
+        allocate();  // buffer 0: DBParms
+    }
+
+    // Tables are numbered in the order they are added, indexes right after
+    // their table.
+    void add(TableData t) {
+        TableSchema &s = t.schema;
+        if (s.field_names.size() != s.field_types.size() + 1) {
+            throw FormatError(s.name + ": one name per field and one for the key expected");
+        }
+        for (const Row &r : t.rows) {
+            if (r.fields.size() != s.field_types.size()) {
+                throw FormatError(s.name + ": record with " + std::to_string(r.fields.size()) + " fields");
+            }
+        }
+        s.index_column = -1;
+        s.records = int32_t(t.rows.size());
+        s.max_key = NO_MAX_KEY;
+        if (s.key_type == F_LONG) {
+            std::sort(t.rows.begin(), t.rows.end(), [](const Row &a, const Row &b) { return a.key.i < b.key.i; });
+            if (!t.rows.empty()) {
+                s.max_key = t.rows.back().key.i;
+            }
+            s.root = long_tree(s, t.rows);
+        } else if (s.key_type == F_STRING) {
+            std::sort(t.rows.begin(), t.rows.end(), [](const Row &a, const Row &b) { return a.key.s < b.key.s; });
+            std::vector<std::pair<std::string, std::string>> entries;
+            for (const Row &r : t.rows) {
+                std::string k, rec;
+                detail::put_field(k, F_STRING, r.key);
+                encode(s, r.fields, rec);
+                entries.emplace_back(std::move(k), std::move(rec));
+            }
+            s.root = var_tree(s, F_STRING, entries);
+        } else {
+            throw FormatError(s.name + ": unsupported key type " + std::to_string(s.key_type));
+        }
+        master(s);
+
+        for (int32_t col : t.indexed) {
+            if (col < 0 || size_t(col) >= s.field_types.size() || s.field_types[size_t(col)] != F_LONG ||
+                s.key_type != F_LONG) {
+                throw FormatError(s.name + ": only long columns of long-keyed tables are indexed");
+            }
+            std::vector<std::pair<int64_t, int64_t>> keys;
+            for (const Row &r : t.rows) {
+                keys.emplace_back(r.fields[size_t(col)].i, r.key.i);
+            }
+            std::sort(keys.begin(), keys.end());
+            std::vector<std::pair<std::string, std::string>> entries;
+            for (const auto &k : keys) {
+                std::string b;
+                detail::put_be(b, uint64_t(k.first), 8);
+                detail::put_be(b, uint64_t(k.second), 8);
+                entries.emplace_back(std::move(b), std::string());
+            }
+            TableSchema ix;
+            ix.name = s.name;
+            ix.key_type = INDEX_KEY_FLAG | F_LONG;
+            ix.field_names = {"IndexKey"};
+            ix.index_column = col;
+            ix.max_key = NO_MAX_KEY;
+            ix.records = s.records;
+            ix.root = var_tree(ix, ix.key_type, entries);
+            master(ix);
+        }
+    }
+
+    // The buffer file. The master table is written here, so call it once,
+    // after the last add().
+    std::vector<uint8_t> image() {
+        TableSchema m;
+        m.name = "Master Table";
+        m.field_types = {F_STRING, F_INT, F_INT, F_BYTE, F_BINARY, F_STRING, F_INT, F_LONG, F_INT};
+        int32_t root = long_tree(m, master_);
+
+        uint8_t *p = buffer(0);
+        p[0] = 9;  // chained buffer data node
+        detail::store_be(p + 1, 13, 4);
+        p[5] = 1;  // DBParms version
+        detail::store_be(p + 6, uint32_t(root), 4);
+        detail::store_be(p + 10, uint64_t(database_id_) >> 32, 4);
+        detail::store_be(p + 14, uint64_t(database_id_) & 0xffffffffu, 4);
+
+        std::vector<uint8_t> out(BLOCK_SIZE * (buffers_.size() + 1), 0);
+        uint8_t *h = out.data();
+        detail::store_be(h, BUFFER_FILE_MAGIC, 8);
+        detail::store_be(h + 8, file_id_, 8);
+        detail::store_be(h + 16, 1, 4);  // header format version
+        detail::store_be(h + 20, BLOCK_SIZE, 4);
+        detail::store_be(h + 24, uint32_t(-1), 4);  // first free buffer: none
+        detail::store_be(h + 28, 0, 4);             // user parameters
+        for (size_t i = 0; i < buffers_.size(); i++) {
+            uint8_t *b = out.data() + BLOCK_SIZE * (i + 1);
+            b[0] = 0;  // in use
+            detail::store_be(b + 1, i, 4);
+            std::memcpy(b + BLOCK_HEADER, buffers_[i].data(), BUFFER_SIZE);
+        }
+        return out;
+    }
+
+  private:
+    static constexpr size_t LEAF_HEADER = 13;      // type, count, previous and next leaf
+    static constexpr size_t LONG_ENTRY = 13;       // key, record offset, indirect flag
+    static constexpr size_t LONG_INTERIOR = 12;    // key, child
+    static constexpr size_t VAR_LEAF_HEADER = 14;  // type, key type, count, previous and next leaf
+    static constexpr size_t VAR_ENTRY = 5;         // key offset, indirect flag
+    static constexpr size_t VAR_INTERIOR_HEADER = 6;
+    static constexpr size_t VAR_INTERIOR = 8;      // key offset, child
+    static constexpr size_t MAX_RECORD = ((BUFFER_SIZE - LEAF_HEADER) >> 2) - LONG_ENTRY;
+
+    static size_t fixed_length(const TableSchema &s) {
+        size_t len = 0;
+        for (uint8_t t : s.field_types) {
+            switch (t) {
+            case F_BYTE:
+            case F_BOOLEAN: len += 1; break;
+            case F_SHORT: len += 2; break;
+            case F_INT: len += 4; break;
+            case F_LONG: len += 8; break;
+            default: return 0;
+            }
+        }
+        return len;
+    }
+
+    static void encode(const TableSchema &s, const Record &r, std::string &out) {
+        for (size_t i = 0; i < r.size(); i++) {
+            detail::put_field(out, s.field_types[i], r[i]);
+        }
+        if (out.size() > MAX_RECORD) {
+            throw FormatError(s.name + ": record of " + std::to_string(out.size()) +
+                              " bytes would need chained storage");
+        }
+    }
+
+    int32_t allocate() {
+        buffers_.emplace_back(BUFFER_SIZE, 0);
+        return int32_t(buffers_.size() - 1);
+    }
+
+    uint8_t *buffer(int32_t id) { return buffers_[size_t(id)].data(); }
+
+    void master(const TableSchema &s) {
+        Row r;
+        r.key.i = int64_t(master_.size());
+        r.fields.resize(9);
+        r.fields[0].s = s.name;
+        r.fields[1].i = s.version;
+        r.fields[2].i = s.root;
+        r.fields[3].i = s.key_type;
+        r.fields[4].s.assign(s.field_types.begin(), s.field_types.end());
+        for (const std::string &n : s.field_names) {
+            r.fields[5].s += n + ";";
+        }
+        r.fields[6].i = s.index_column;
+        r.fields[7].i = s.max_key;
+        r.fields[8].i = s.records;
+        master_.push_back(std::move(r));
+    }
+
+    // Links leaf 'id' after the previous leaf of its level.
+    void link(std::vector<int32_t> &leaves, int32_t id, size_t prev_at, size_t next_at) {
+        detail::store_be(buffer(id) + prev_at, uint32_t(leaves.empty() ? -1 : leaves.back()), 4);
+        detail::store_be(buffer(id) + next_at, uint32_t(-1), 4);
+        if (!leaves.empty()) {
+            detail::store_be(buffer(leaves.back()) + next_at, uint32_t(id), 4);
+        }
+        leaves.push_back(id);
+    }
+
+    // Rows sorted by key; returns the root buffer, -1 for no rows.
+    int32_t long_tree(const TableSchema &s, const std::vector<Row> &rows) {
+        if (rows.empty()) {
+            return -1;
+        }
+        size_t fixed = fixed_length(s);
+        std::vector<std::pair<int64_t, int32_t>> level;  // first key, node
+        std::vector<int32_t> leaves;
+        std::string rec;
+        for (size_t i = 0; i < rows.size();) {
+            int32_t id = allocate();
+            link(leaves, id, 5, 9);
+            uint8_t *b = buffer(id);
+            level.emplace_back(rows[i].key.i, id);
+            uint32_t n = 0;
+            if (fixed) {
+                b[0] = LONGKEY_FIXED_REC;
+                for (; i < rows.size() && LEAF_HEADER + (n + 1) * (8 + fixed) <= BUFFER_SIZE; i++, n++) {
+                    rec.clear();
+                    encode(s, rows[i].fields, rec);
+                    uint8_t *e = b + LEAF_HEADER + n * (8 + fixed);
+                    detail::store_be(e, uint64_t(rows[i].key.i), 8);
+                    std::memcpy(e + 8, rec.data(), rec.size());
+                }
+            } else {
+                b[0] = LONGKEY_VAR_REC;
+                size_t end = BUFFER_SIZE;  // records grow down from the end
+                for (; i < rows.size(); i++, n++) {
+                    rec.clear();
+                    encode(s, rows[i].fields, rec);
+                    if (LEAF_HEADER + (n + 1) * LONG_ENTRY + rec.size() > end) {
+                        break;
+                    }
+                    end -= rec.size();
+                    std::memcpy(b + end, rec.data(), rec.size());
+                    uint8_t *e = b + LEAF_HEADER + n * LONG_ENTRY;
+                    detail::store_be(e, uint64_t(rows[i].key.i), 8);
+                    detail::store_be(e + 8, end, 4);
+                    e[12] = 0;
+                }
+            }
+            detail::store_be(b + 1, n, 4);
+        }
+        while (level.size() > 1) {
+            std::vector<std::pair<int64_t, int32_t>> up;
+            const size_t per = (BUFFER_SIZE - 5) / LONG_INTERIOR;
+            for (size_t i = 0; i < level.size(); i += per) {
+                int32_t id = allocate();
+                uint8_t *b = buffer(id);
+                size_t n = std::min(per, level.size() - i);
+                b[0] = LONGKEY_INTERIOR;
+                detail::store_be(b + 1, n, 4);
+                for (size_t k = 0; k < n; k++) {
+                    detail::store_be(b + 5 + k * LONG_INTERIOR, uint64_t(level[i + k].first), 8);
+                    detail::store_be(b + 5 + k * LONG_INTERIOR + 8, uint32_t(level[i + k].second), 4);
+                }
+                up.emplace_back(level[i].first, id);
+            }
+            level.swap(up);
+        }
+        return level[0].second;
+    }
+
+    // (encoded key, encoded record) sorted by key; returns the root, -1 for
+    // none.
+    int32_t var_tree(const TableSchema &s, uint8_t key_type,
+                     const std::vector<std::pair<std::string, std::string>> &entries) {
+        if (entries.empty()) {
+            return -1;
+        }
+        std::vector<std::pair<const std::string *, int32_t>> level;
+        std::vector<int32_t> leaves;
+        for (size_t i = 0; i < entries.size();) {
+            int32_t id = allocate();
+            link(leaves, id, 6, 10);
+            uint8_t *b = buffer(id);
+            b[0] = VARKEY_REC;
+            b[1] = key_type;
+            level.emplace_back(&entries[i].first, id);
+            size_t end = BUFFER_SIZE;
+            uint32_t n = 0;
+            for (; i < entries.size(); i++, n++) {
+                const std::string &k = entries[i].first, &r = entries[i].second;
+                if (k.size() + r.size() > MAX_RECORD) {
+                    throw FormatError(s.name + ": key and record would need chained storage");
+                }
+                if (VAR_LEAF_HEADER + (n + 1) * VAR_ENTRY + k.size() + r.size() > end) {
+                    break;
+                }
+                end -= k.size() + r.size();
+                std::memcpy(b + end, k.data(), k.size());
+                std::memcpy(b + end + k.size(), r.data(), r.size());
+                uint8_t *e = b + VAR_LEAF_HEADER + n * VAR_ENTRY;
+                detail::store_be(e, end, 4);
+                e[4] = 0;
+            }
+            detail::store_be(b + 2, n, 4);
+        }
+        while (level.size() > 1) {
+            std::vector<std::pair<const std::string *, int32_t>> up;
+            for (size_t i = 0; i < level.size();) {
+                int32_t id = allocate();
+                uint8_t *b = buffer(id);
+                b[0] = VARKEY_INTERIOR;
+                b[1] = key_type;
+                up.emplace_back(level[i].first, id);
+                size_t end = BUFFER_SIZE;
+                uint32_t n = 0;
+                for (; i < level.size(); i++, n++) {
+                    const std::string &k = *level[i].first;
+                    if (VAR_INTERIOR_HEADER + (n + 1) * VAR_INTERIOR + k.size() > end) {
+                        break;
+                    }
+                    end -= k.size();
+                    std::memcpy(b + end, k.data(), k.size());
+                    uint8_t *e = b + VAR_INTERIOR_HEADER + n * VAR_INTERIOR;
+                    detail::store_be(e, end, 4);
+                    detail::store_be(e + 4, uint32_t(level[i].second), 4);
+                }
+                detail::store_be(b + 2, n, 4);
+            }
+            level.swap(up);
+        }
+        return level[0].second;
+    }
+
+    int64_t database_id_;
+    uint64_t file_id_;
+    std::vector<std::vector<uint8_t>> buffers_;
+    std::vector<Row> master_;
+};
+
+// The image wrapped as a .gdt: Java serialization stream with the packed
+// database header (item name, content type "Archive", image length) in
+// block data, then the zip entry.
+inline std::vector<uint8_t> pack_container(const std::vector<uint8_t> &image, const std::string &name = "Untitled") {
+    std::string block;
+    detail::put_be(block, PACKED_DB_MAGIC, 8);
+    detail::put_be(block, 1, 4);  // format version
+    for (const std::string &s : {name, std::string("Archive")}) {
+        detail::put_be(block, s.size(), 2);  // writeUTF; names are expected to be ASCII
+        block += s;
+    }
+    detail::put_be(block, 0, 4);  // file type
+    detail::put_be(block, image.size(), 8);
+    if (block.size() > 255) {
+        throw FormatError("packed database: item name too long");
+    }
+
+    std::vector<uint8_t> out = {0xac, 0xed, 0x00, 0x05, 0x77, uint8_t(block.size())};
+    out.insert(out.end(), block.begin(), block.end());
+    auto le = [&](uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            out.push_back(uint8_t(v >> (8 * i)));
+        }
+    };
+    const std::string entry = "FOLDER_ITEM";
+    le(0x04034b50, 4);
+    le(20, 2);      // version needed
+    le(0x0808, 2);  // data descriptor follows, UTF-8 name
+    le(8, 2);       // deflate
+    le(0, 2);       // time and date: 1980-01-01, for reproducible output
+    le(0x21, 2);
+    le(0, 4);       // CRC and sizes are in the descriptor
+    le(0, 4);
+    le(0, 4);
+    le(entry.size(), 2);
+    le(0, 2);
+    out.insert(out.end(), entry.begin(), entry.end());
+    size_t start = out.size();
+    common::deflate(image.data(), image.size(), out);
+    size_t compressed = out.size() - start;
+    le(0x08074b50, 4);
+    le(common::crc32(image.data(), image.size()), 4);
+    le(compressed, 4);
+    le(image.size(), 4);
+    return out;
+}
+
+inline void write_file(const std::string &path, const std::vector<uint8_t> &data) {
+    common::BufferedFile f(path);
+    f.write(data.data(), data.size());
+    f.close();
+}
+
+}  // namespace gdt
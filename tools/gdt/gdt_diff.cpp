@@ -0,0 +1,132 @@
+/*
+ *   gdt_diff: what changed between two versions of a .gdt archive.
+ *
+ *   The named types of both are paired up by universal id, then by path
+ *   and name (gdt/gdt_diff.hpp); types with equal structural signatures
+ *   are unchanged, the others are compared member by member. One line per
+ *   difference, in the order of the old archive's types:
+ *
+ *     change  kind  path  what  key  before  after
+ *
+ *   change is "added", "removed" or "changed"; for added and removed types
+ *   what/key are empty and before/after summarize the type. For changed
+ *   ones, what names the attribute ("name", "category", "length",
+ *   "member", "value", "parameter", "target", "return", ...), key the
+ *   member, value or parameter, and before/after list only what differs
+ *   ("offset 12, size 4" / "offset 16, size 8"), empty for an addition or
+ *   a removal. path is the type's path in the new archive (the old one
+ *   for removed types). The last line counts the types:
+ *
+ *     # 723 types, 726 types: 3 added, 0 removed, 12 changed, 708 unchanged
+ *
+ *   The exit status is 0 when nothing changed and 1 when something did, as
+ *   for diff(1); 2 on errors. --quiet prints only the last line.
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/gdt/gdt_diff.cpp -o gdt_diff
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/parallel.hpp"
+#include "gdt/gdt_diff.hpp"
+#include "gdt/gdt_hash.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace {
+
+struct Options {
+    bool quiet = false;
+    std::string old_path;
+    std::string new_path;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: gdt_diff [options] old.gdt new.gdt\n"
+                 "  --quiet  print only the counts\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--quiet" || a == "-q") {
+            o.quiet = true;
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (o.old_path.empty()) {
+            o.old_path = a;
+        } else if (o.new_path.empty()) {
+            o.new_path = a;
+        } else {
+            usage();
+        }
+    }
+    if (o.new_path.empty()) {
+        usage();
+    }
+    return o;
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    const std::string paths[2] = {opt.old_path, opt.new_path};
+    std::unique_ptr<gdt::Archive> archives[2];
+    bool failed = false;
+    common::parallel_for(2, 2, [&](size_t i) {
+        try {
+            archives[i].reset(new gdt::Archive(paths[i]));
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "gdt_diff: %s: %s\n", paths[i].c_str(), e.what());
+            failed = true;
+        }
+    });
+    if (failed) {
+        return 2;
+    }
+    const gdt::Archive &a = *archives[0], &b = *archives[1];
+
+    size_t types[2] = {0, 0}, added = 0, removed = 0, changed = 0, unchanged = 0;
+    for (const gdt::TypeMatch &m : gdt::match_types(a, b)) {
+        types[0] += m.a != nullptr;
+        types[1] += m.b != nullptr;
+        if (!m.a || !m.b) {
+            const gdt::Archive &in = m.a ? a : b;
+            const gdt::DataType &t = m.a ? *m.a : *m.b;
+            (m.a ? removed : added)++;
+            if (!opt.quiet) {
+                std::string s = gdt::summary(in, t);
+                std::printf("%s\t%s\t%s\t\t\t%s\t%s\n", m.a ? "removed" : "added", gdt::kind_name(t),
+                            gdt::type_path(in, t).c_str(), m.a ? s.c_str() : "", m.a ? "" : s.c_str());
+            }
+            continue;
+        }
+        std::vector<gdt::Difference> diffs = gdt::differences(a, *m.a, b, *m.b);
+        if (diffs.empty()) {
+            unchanged++;
+            continue;
+        }
+        changed++;
+        if (opt.quiet) {
+            continue;
+        }
+        std::string path = gdt::type_path(b, *m.b);
+        for (const gdt::Difference &d : diffs) {
+            std::printf("changed\t%s\t%s\t%s\t%s\t%s\t%s\n", gdt::kind_name(*m.b), path.c_str(), d.what.c_str(),
+                        d.key.c_str(), d.before.c_str(), d.after.c_str());
+        }
+    }
+    std::printf("# %zu types, %zu types: %zu added, %zu removed, %zu changed, %zu unchanged\n", types[0], types[1],
+                added, removed, changed, unchanged);
+    return added || removed || changed ? 1 : 0;
+}
@@ -0,0 +1,271 @@
+/*
+ *   Differences between the named data types of two archives.
+ *
+ *   match_types() pairs the types of the old archive with those of the new
+ *   one: first by universal id (what Ghidra itself follows when an archive
+ *   is updated), then by category path and name, then by name alone, each
+ *   step taking only keys that are unique on both sides. What is left is
+ *   removed or added. A pair whose name or category differ is a rename or
+ *   a move.
+ *
+ *   differences() compares the two types of a pair. Their structural
+ *   signatures (gdt_hash.hpp) are compared first, so unchanged types cost
+ *   one hash each; for the others the members, values or parameters are
+ *   lined up by name (unnamed members by offset, parameters by position)
+ *   and only the attributes that differ are reported. Types a member
+ *   refers to enter by name, so a changed type is reported once, not again
+ *   for everything that uses it; the stored layout (offsets, sizes,
+ *   lengths) is compared as recorded, which is what programs see.
+ *
+ *   Both are linear in the number of types and members, apart from the
+ *   ordering of the output.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "gdt/gdt_hash.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace gdt {
+
+// 'a' from the old archive, 'b' from the new one; one of them is null for
+// a removed or added type.
+struct TypeMatch {
+    const DataType *a = nullptr;
+    const DataType *b = nullptr;
+};
+
+// "/lstate.h/lua_State"
+inline std::string type_path(const Archive &a, const DataType &t) {
+    std::string c = a.category_path(t.category);
+    return (c == "/" ? "" : c) + "/" + t.name;
+}
+
+// Pairs the named types 'left' of 'a' with the named types 'right' of 'b':
+// in the order of 'left', then the unpaired ones of 'right' in their order.
+inline std::vector<TypeMatch> match_types(const Archive &a, const std::vector<const DataType *> &left,
+                                          const Archive &b, const std::vector<const DataType *> &right) {
+    std::unordered_map<const DataType *, const DataType *> pair_of;  // left -> right
+    std::unordered_set<const DataType *> taken;                       // right
+    // One round: keys seen once on each side pair up.
+    auto round = [&](const std::function<std::string(const Archive &, const DataType &)> &key) {
+        std::unordered_map<std::string, std::pair<const DataType *, int>> l, r;
+        for (const DataType *t : left) {
+            if (!pair_of.count(t)) {
+                std::string k = key(a, *t);
+                if (!k.empty()) {
+                    auto &e = l[k];
+                    e.first = t;
+                    e.second++;
+                }
+            }
+        }
+        for (const DataType *t : right) {
+            if (!taken.count(t)) {
+                std::string k = key(b, *t);
+                if (!k.empty()) {
+                    auto &e = r[k];
+                    e.first = t;
+                    e.second++;
+                }
+            }
+        }
+        for (const auto &kv : l) {
+            auto it = r.find(kv.first);
+            if (kv.second.second == 1 && it != r.end() && it->second.second == 1) {
+                pair_of[kv.second.first] = it->second.first;
+                taken.insert(it->second.first);
+            }
+        }
+    };
+    round([](const Archive &, const DataType &t) {
+        return t.universal_id ? std::to_string(t.table()) + ":" + std::to_string(t.universal_id) : std::string();
+    });
+    round([](const Archive &x, const DataType &t) { return std::to_string(t.table()) + ":" + type_path(x, t); });
+    round([](const Archive &, const DataType &t) { return std::to_string(t.table()) + ":" + t.name; });
+
+    std::vector<TypeMatch> out;
+    for (const DataType *t : left) {
+        auto it = pair_of.find(t);
+        out.push_back({t, it == pair_of.end() ? nullptr : it->second});
+    }
+    for (const DataType *t : right) {
+        if (!taken.count(t)) {
+            out.push_back({nullptr, t});
+        }
+    }
+    return out;
+}
+
+// All named types of the old archive with those of the new one.
+inline std::vector<TypeMatch> match_types(const Archive &a, const Archive &b) {
+    std::vector<const DataType *> left, right;
+    for (const DataType *t : a.types()) {
+        if (named_kind(t->table())) {
+            left.push_back(t);
+        }
+    }
+    for (const DataType *t : b.types()) {
+        if (named_kind(t->table())) {
+            right.push_back(t);
+        }
+    }
+    return match_types(a, left, b, right);
+}
+
+// One attribute of a type that differs: 'what' is "name", "category",
+// "length", "member", "value", "parameter", ...; 'key' the member, value
+// or parameter ("" for the type itself). An empty 'before' is an
+// addition, an empty 'after' a removal.
+struct Difference {
+    std::string what;
+    std::string key;
+    std::string before;
+    std::string after;
+};
+
+namespace diff_detail {
+
+// Adds "label old" / "label new" to the descriptions when the two differ.
+inline void attribute(std::string &before, std::string &after, const char *label, const std::string &x,
+                      const std::string &y) {
+    if (x != y) {
+        before += (before.empty() ? "" : ", ") + std::string(label) + " " + x;
+        after += (after.empty() ? "" : ", ") + std::string(label) + " " + y;
+    }
+}
+
+// Members by name; unnamed ones by offset, repeats numbered.
+inline std::vector<std::pair<std::string, const Component *>> keyed(const DataType &t) {
+    std::vector<std::pair<std::string, const Component *>> out;
+    std::unordered_map<std::string, int> seen;
+    for (const Component &c : t.components) {
+        std::string k = c.name.empty() ? "@" + std::to_string(c.offset) : c.name;
+        int n = seen[k]++;
+        out.emplace_back(n ? k + "#" + std::to_string(n + 1) : k, &c);
+    }
+    return out;
+}
+
+inline std::string describe(const Archive &a, const Component &c) {
+    return a.type_name(c.type) + ", offset " + std::to_string(c.offset) + ", " + std::to_string(c.size) + " bytes";
+}
+
+}  // namespace diff_detail
+
+inline std::vector<Difference> differences(const Archive &a, const DataType &x, const Archive &b, const DataType &y) {
+    using diff_detail::attribute;
+    std::vector<Difference> out;
+    if (x.name != y.name) {
+        out.push_back({"name", "", x.name, y.name});
+    }
+    std::string cx = a.category_path(x.category), cy = b.category_path(y.category);
+    if (cx != cy) {
+        out.push_back({"category", "", cx, cy});
+    }
+    if (signature(a, x) == signature(b, y)) {
+        return out;
+    }
+    auto scalar = [&](const char *what, const std::string &p, const std::string &q) {
+        if (p != q) {
+            out.push_back({what, "", p, q});
+        }
+    };
+    scalar("length", std::to_string(x.length), std::to_string(y.length));
+    switch (x.table()) {
+    case T_COMPOSITE: {
+        scalar("kind", kind_name(x), kind_name(y));
+        scalar("packing", std::to_string(x.packing), std::to_string(y.packing));
+        auto mx = diff_detail::keyed(x), my = diff_detail::keyed(y);
+        std::unordered_map<std::string, const Component *> by_key;
+        for (const auto &m : my) {
+            by_key.emplace(m.first, m.second);
+        }
+        std::unordered_set<std::string> matched;
+        for (const auto &m : mx) {
+            auto it = by_key.find(m.first);
+            if (it == by_key.end()) {
+                out.push_back({"member", m.first, diff_detail::describe(a, *m.second), ""});
+                continue;
+            }
+            matched.insert(m.first);
+            const Component &p = *m.second, &q = *it->second;
+            std::string before, after;
+            attribute(before, after, "type", a.type_name(p.type), b.type_name(q.type));
+            attribute(before, after, "offset", std::to_string(p.offset), std::to_string(q.offset));
+            attribute(before, after, "size", std::to_string(p.size), std::to_string(q.size));
+            if (!before.empty()) {
+                out.push_back({"member", m.first, before, after});
+            }
+        }
+        for (const auto &m : my) {
+            if (!matched.count(m.first)) {
+                out.push_back({"member", m.first, "", diff_detail::describe(b, *m.second)});
+            }
+        }
+        break;
+    }
+    case T_ENUM: {
+        std::unordered_map<std::string, int64_t> vy;
+        for (const EnumValue &v : y.values) {
+            vy.emplace(v.name, v.value);
+        }
+        std::unordered_set<std::string> matched;
+        for (const EnumValue &v : x.values) {
+            auto it = vy.find(v.name);
+            if (it == vy.end()) {
+                out.push_back({"value", v.name, std::to_string(v.value), ""});
+            } else {
+                matched.insert(v.name);
+                if (it->second != v.value) {
+                    out.push_back({"value", v.name, std::to_string(v.value), std::to_string(it->second)});
+                }
+            }
+        }
+        for (const EnumValue &v : y.values) {
+            if (!matched.count(v.name)) {
+                out.push_back({"value", v.name, "", std::to_string(v.value)});
+            }
+        }
+        break;
+    }
+    case T_TYPEDEF:
+        scalar("target", a.type_name(x.target), b.type_name(y.target));
+        break;
+    case T_FUNCDEF:
+        scalar("return", a.type_name(x.return_type), b.type_name(y.return_type));
+        scalar("varargs", x.varargs() ? "yes" : "no", y.varargs() ? "yes" : "no");
+        for (size_t i = 0; i < std::max(x.params.size(), y.params.size()); i++) {
+            std::string key = std::to_string(i + 1);
+            if (i >= y.params.size()) {
+                out.push_back({"parameter", key, a.type_name(x.params[i].type), ""});
+            } else if (i >= x.params.size()) {
+                out.push_back({"parameter", key, "", b.type_name(y.params[i].type)});
+            } else {
+                std::string p = a.type_name(x.params[i].type), q = b.type_name(y.params[i].type);
+                if (p != q) {
+                    out.push_back({"parameter", key, p, q});
+                }
+            }
+        }
+        break;
+    case T_BUILTIN:
+        scalar("class", x.class_name, y.class_name);
+        break;
+    default:
+        break;
+    }
+    return out;
+}
+
+}  // namespace gdt
@@ -0,0 +1,267 @@
+/*
+ *   gdt_flat: convert .gdt archives to flat type archives (.gdtf,
+ *   gdt/gdt_flat.hpp), which are mapped and read in place: opening one is
+ *   checking its header, and a type is found by id through a directory
+ *   array and by name through one hash probe, where a .gdt has to be
+ *   inflated and its B-trees walked into the type model first.
+ *
+ *   Each in.gdt is written to outdir/in.gdtf (outdir and its parents
+ *   are created if missing), -j N of them at a time, one line each:
+ *
+ *     out  types  bytes (input bytes)
+ *
+ *   --check maps the result and compares every field of every type,
+ *   member, category and source archive with the input, and every lookup
+ *   by id and name. --bench N then times, best of N rounds, opening the
+ *   input and the output and looking up all their types by id and by
+ *   name, and adds to the line
+ *
+ *     open ms (input open ms)  lookup ms (input lookup ms)
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/gdt/gdt_flat.cpp -o gdt_flat
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/mapped_file.hpp"
+#include "common/parallel.hpp"
+#include "gdt/gdt_db_write.hpp"
+#include "gdt/gdt_flat.hpp"
+#include "gdt/gdt_hash.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace {
+
+struct Options {
+    bool check = false;
+    int bench = 0;
+    unsigned jobs = common::default_jobs();
+    std::vector<std::string> in;
+    std::string out;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: gdt_flat [options] in.gdt... outdir\n"
+                 "  --check    map each output and compare it with its input\n"
+                 "  --bench N  time opening and lookups, flat against .gdt, best of N rounds\n"
+                 "  -j N       archives converted in parallel\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--check") {
+            o.check = true;
+        } else if (a == "--bench") {
+            o.bench = std::atoi(next());
+            if (o.bench < 1) {
+                usage();
+            }
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else {
+            o.in.push_back(a);
+        }
+    }
+    if (o.in.size() < 2) {
+        usage();
+    }
+    o.out = o.in.back();
+    o.in.pop_back();
+    return o;
+}
+
+std::string basename(const std::string &path) { return path.substr(path.find_last_of('/') + 1); }
+
+std::string stem(const std::string &path) {
+    std::string s = basename(path);
+    return s.substr(0, s.find_last_of('.'));
+}
+
+void expect(bool ok, const gdt::Archive &a, int64_t id, const char *what) {
+    if (!ok) {
+        throw std::runtime_error(a.type_name(id) + ": " + what + " differs");
+    }
+}
+
+// Throws at the first difference between the input and its flat form.
+void compare(const gdt::Archive &a, const gdt::FlatArchive &f) {
+    if (f.types() != a.types().size() || f.database_id() != a.db().database_id()) {
+        throw std::runtime_error("type count or universal id differs");
+    }
+    for (size_t i = 0; i < f.types(); i++) {
+        const gdt::DataType &t = *a.types()[i];
+        gdt::DataType u = f.data_type(f.type(i));
+        expect(u.id == t.id && u.name == t.name && u.comment == t.comment && u.category == t.category &&
+                   u.class_name == t.class_name,
+               a, t.id, "identity");
+        expect(u.target == t.target && u.length == t.length && u.count == t.count && u.is_union == t.is_union &&
+                   u.packing == t.packing && u.alignment == t.alignment && u.num_components == t.num_components &&
+                   u.return_type == t.return_type && u.flags == t.flags,
+               a, t.id, "shape");
+        expect(u.source_archive == t.source_archive && u.universal_id == t.universal_id &&
+                   u.source_sync_time == t.source_sync_time && u.last_change_time == t.last_change_time,
+               a, t.id, "provenance");
+        expect(u.components.size() == t.components.size() && u.params.size() == t.params.size() &&
+                   u.values.size() == t.values.size(),
+               a, t.id, "member count");
+        for (size_t k = 0; k < t.components.size(); k++) {
+            const gdt::Component &c = t.components[k], &d = u.components[k];
+            expect(c.offset == d.offset && c.type == d.type && c.name == d.name && c.comment == d.comment &&
+                       c.size == d.size && c.ordinal == d.ordinal,
+                   a, t.id, "component");
+        }
+        for (size_t k = 0; k < t.params.size(); k++) {
+            const gdt::Parameter &p = t.params[k], &q = u.params[k];
+            expect(p.type == q.type && p.name == q.name && p.comment == q.comment && p.ordinal == q.ordinal &&
+                       p.length == q.length,
+                   a, t.id, "parameter");
+        }
+        for (size_t k = 0; k < t.values.size(); k++) {
+            expect(t.values[k].name == u.values[k].name && t.values[k].value == u.values[k].value, a, t.id, "value");
+        }
+        expect(f.get(t.id) == &f.type(i), a, t.id, "lookup by id");
+        if (gdt::named_kind(t.table())) {
+            const gdt::FlatType *g = f.find(t.name);
+            expect(g && g->id == a.find(t.name)->id, a, t.id, "lookup by name");
+        }
+        expect(f.category_path(t.category) == a.category_path(t.category), a, t.id, "category path");
+    }
+    for (const auto &kv : a.categories()) {
+        const gdt::FlatCategory *c = f.category(kv.first);
+        if (!c || c->parent != kv.second.parent || f.str(c->name) != kv.second.name) {
+            throw std::runtime_error("category " + a.category_path(kv.first) + " differs");
+        }
+    }
+    if (f.source_archives() != a.source_archives().size()) {
+        throw std::runtime_error("source archive count differs");
+    }
+    for (size_t i = 0; i < f.source_archives(); i++) {
+        const gdt::SourceArchive &s = a.source_archives()[i];
+        const gdt::FlatSource &g = f.source_archive(i);
+        if (g.id != s.id || f.str(g.domain_file_id) != s.domain_file_id || f.str(g.name) != s.name ||
+            g.type != s.type || g.last_sync_time != s.last_sync_time || bool(g.dirty) != bool(s.dirty)) {
+            throw std::runtime_error("source archive " + s.name + " differs");
+        }
+    }
+    if (f.get(gdt::DEFAULT_ID) || f.find("\x01no such type")) {
+        throw std::runtime_error("lookup of a missing type succeeds");
+    }
+}
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Best times of opening and of looking up every type by id and name.
+struct Timing {
+    double open = 1e300;
+    double lookup = 1e300;
+};
+
+template <class A>
+void time_round(const std::string &path, const std::vector<std::pair<int64_t, std::string>> &keys, Timing &t) {
+    auto t0 = std::chrono::steady_clock::now();
+    A a(path);
+    t.open = std::min(t.open, ms_since(t0));
+    t0 = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for (const auto &k : keys) {
+        found += a.get(k.first) != nullptr;
+        found += !k.second.empty() && a.find(k.second) != nullptr;
+    }
+    t.lookup = std::min(t.lookup, ms_since(t0));
+    if (found == 0 && !keys.empty()) {
+        throw std::runtime_error("benchmark found no types");
+    }
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::error_code ec;
+    std::filesystem::create_directories(opt.out, ec);
+    if (ec || !std::filesystem::is_directory(opt.out, ec)) {
+        std::fprintf(stderr, "gdt_flat: %s: %s\n", opt.out.c_str(), ec ? ec.message().c_str() : "not a directory");
+        return 1;
+    }
+    std::vector<std::string> lines(opt.in.size());
+    bool failed = false;
+    common::parallel_for(opt.in.size(), opt.jobs, [&](size_t i) {
+        std::string out = opt.out + "/" + stem(opt.in[i]) + ".gdtf";
+        std::string where = opt.in[i];
+        try {
+            gdt::Archive in(opt.in[i]);
+            std::vector<uint8_t> image = gdt::flat_image(in, stem(opt.in[i]));
+            where = out;
+            gdt::write_file(out, image);
+            if (opt.check) {
+                compare(in, gdt::FlatArchive(out));
+            }
+            common::MappedFile before(opt.in[i]);
+            char buf[512];
+            std::snprintf(buf, sizeof buf, "%s\t%zu\t%zu (%zu)", out.c_str(), in.types().size(), image.size(),
+                          before.size());
+            lines[i] = buf;
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "gdt_flat: %s: %s\n", where.c_str(), e.what());
+            failed = true;
+        }
+    });
+    if (failed) {
+        return 1;
+    }
+
+    // One archive at a time, so the rounds do not compete for the cores.
+    for (size_t i = 0; i < opt.in.size(); i++) {
+        if (opt.bench > 0) {
+            std::string out = opt.out + "/" + stem(opt.in[i]) + ".gdtf";
+            try {
+                std::vector<std::pair<int64_t, std::string>> keys;
+                {
+                    gdt::Archive in(opt.in[i]);
+                    for (const gdt::DataType *t : in.types()) {
+                        keys.emplace_back(t->id, gdt::named_kind(t->table()) ? t->name : std::string());
+                    }
+                }
+                Timing gdt_time, flat_time;
+                for (int r = 0; r < opt.bench; r++) {
+                    time_round<gdt::Archive>(opt.in[i], keys, gdt_time);
+                    time_round<gdt::FlatArchive>(out, keys, flat_time);
+                }
+                char buf[256];
+                std::snprintf(buf, sizeof buf, "\t%.3f (%.3f)\t%.3f (%.3f)", flat_time.open, gdt_time.open,
+                              flat_time.lookup, gdt_time.lookup);
+                lines[i] += buf;
+            } catch (const std::exception &e) {
+                std::fprintf(stderr, "gdt_flat: %s: %s\n", out.c_str(), e.what());
+                return 1;
+            }
+        }
+        std::printf("%s\n", lines[i].c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,491 @@
+/*
+ *   Flat type archives (.gdtf): the type model of gdt_types.hpp in one
+ *   little-endian file that is mapped and used in place, for tools that do
+ *   not need Ghidra to read what they write.
+ *
+ *     header      magic "GDTFLAT", version, archive id and name, and the
+ *                 offset and count of every section
+ *     strings     UTF-8, NUL-terminated; records refer to them by offset
+ *                 and length
+ *     categories  sorted by id: id, parent, name
+ *     types       fixed 120-byte records, in the order of Archive::types()
+ *     directory   per table (the top byte of an id), one slot per key up to
+ *                 the largest: the index of the type, or ~0
+ *     components, parameters, values
+ *                 each type's run in ordinal order (FlatType::first and
+ *                 ::members)
+ *     names       open-addressed table of the named types, hashed with
+ *                 common::hash_string and probed linearly; the first of a
+ *                 name in type order comes first, as in Archive::find()
+ *     sources     source archives
+ *
+ *   Sections start at multiples of 8 and every record is naturally aligned,
+ *   so the sections are arrays of the structs below. Opening a file checks
+ *   the header and that each section lies within it; a type is reached by
+ *   id with two array reads and by name with one hash, without decoding
+ *   anything. String and member references are checked when followed.
+ *
+ *   Keys are dense in the archives Ghidra writes and in those written here,
+ *   so the directory is an array per table; a table whose keys are sparser
+ *   than one in MAX_SPARSE is refused rather than blown up. Component,
+ *   parameter and value ids are not kept (nothing refers to them and the
+ *   .gdt writer numbers them afresh).
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "common/hash.hpp"
+#include "common/mapped_file.hpp"
+#include "gdt/gdt_hash.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace gdt {
+
+constexpr char FLAT_MAGIC[8] = {'G', 'D', 'T', 'F', 'L', 'A', 'T', 0};
+constexpr uint32_t FLAT_VERSION = 1;
+constexpr uint32_t FLAT_NONE = UINT32_MAX;
+
+struct FlatString {
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct FlatSection {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct FlatHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;  // 0x01020304
+    int64_t database_id;
+    FlatString name;
+    FlatSection strings, categories, types, directory, components, params, values, names, sources;
+    uint32_t table_first[16];  // directory slot of key 0 of each table
+    uint32_t table_slots[16];  // largest key + 1, 0 for an empty table
+};
+
+struct FlatCategory {
+    int64_t id;
+    int64_t parent;
+    FlatString name;
+};
+
+struct FlatType {
+    int64_t id;
+    int64_t universal_id;
+    int64_t target;
+    int64_t return_type;
+    int64_t source_archive;
+    int64_t category;
+    int64_t source_sync_time;
+    int64_t last_change_time;
+    FlatString name;
+    FlatString comment;
+    FlatString class_name;
+    int32_t length;
+    int32_t count;
+    int32_t packing;
+    int32_t alignment;
+    int32_t num_components;
+    uint32_t first;    // first component, parameter or value
+    uint32_t members;  // number of them
+    uint8_t is_union;
+    uint8_t flags;
+    uint8_t table;
+    uint8_t pad;
+};
+
+struct FlatComponent {
+    int64_t type;
+    FlatString name;
+    FlatString comment;
+    int32_t offset;
+    int32_t size;
+    int32_t ordinal;
+    int32_t pad;
+};
+
+struct FlatParameter {
+    int64_t type;
+    FlatString name;
+    FlatString comment;
+    int32_t ordinal;
+    int32_t length;
+};
+
+struct FlatValue {
+    int64_t value;
+    FlatString name;
+};
+
+struct FlatSource {
+    int64_t id;
+    int64_t last_sync_time;
+    FlatString domain_file_id;
+    FlatString name;
+    uint8_t type;
+    uint8_t dirty;
+    uint8_t pad[6];
+};
+
+static_assert(sizeof(FlatHeader) == 304, "FlatHeader layout");
+static_assert(sizeof(FlatCategory) == 24 && sizeof(FlatType) == 120 && sizeof(FlatComponent) == 40 &&
+                  sizeof(FlatParameter) == 32 && sizeof(FlatValue) == 16 && sizeof(FlatSource) == 40,
+              "flat record layout");
+
+// A table needs one type per MAX_SPARSE directory slots (plus 1024 slots of slack).
+constexpr size_t MAX_SPARSE = 16;
+
+// The flat image of an archive; 'name' is recorded in the header.
+inline std::vector<uint8_t> flat_image(const Archive &a, const std::string &name = "") {
+    std::string strings(1, '\0');  // offset 0: ""
+    std::unordered_map<std::string, uint32_t> interned;
+    auto str = [&](const std::string &s) {
+        if (s.empty()) {
+            return FlatString{0, 0};
+        }
+        auto it = interned.find(s);
+        if (it == interned.end()) {
+            if (strings.size() + s.size() + 1 > UINT32_MAX) {
+                throw FormatError("flat archive: string pool over 4 GiB");
+            }
+            it = interned.emplace(s, uint32_t(strings.size())).first;
+            strings += s;
+            strings.push_back('\0');
+        }
+        return FlatString{it->second, uint32_t(s.size())};
+    };
+
+    FlatHeader h;
+    std::memset(&h, 0, sizeof h);
+    std::memcpy(h.magic, FLAT_MAGIC, 8);
+    h.version = FLAT_VERSION;
+    h.byte_order = 0x01020304;
+    h.database_id = a.db().database_id();
+
+    std::vector<FlatCategory> categories;
+    for (const auto &kv : a.categories()) {
+        categories.push_back({kv.second.id, kv.second.parent, str(kv.second.name)});
+    }
+    std::vector<FlatType> types;
+    std::vector<FlatComponent> components;
+    std::vector<FlatParameter> params;
+    std::vector<FlatValue> values;
+    int64_t largest[16];
+    std::fill(largest, largest + 16, -1);
+    size_t per_table[16] = {};
+    for (const DataType *t : a.types()) {
+        FlatType f;
+        std::memset(&f, 0, sizeof f);
+        f.id = t->id;
+        f.universal_id = t->universal_id;
+        f.target = t->target;
+        f.return_type = t->return_type;
+        f.source_archive = t->source_archive;
+        f.category = t->category;
+        f.source_sync_time = t->source_sync_time;
+        f.last_change_time = t->last_change_time;
+        f.name = str(t->name);
+        f.comment = str(t->comment);
+        f.class_name = str(t->class_name);
+        f.length = t->length;
+        f.count = t->count;
+        f.packing = t->packing;
+        f.alignment = t->alignment;
+        f.num_components = t->num_components;
+        f.is_union = t->is_union;
+        f.flags = t->flags;
+        f.table = t->table();
+        if (!t->components.empty()) {
+            f.first = uint32_t(components.size());
+            f.members = uint32_t(t->components.size());
+            for (const Component &c : t->components) {
+                components.push_back({c.type, str(c.name), str(c.comment), c.offset, c.size, c.ordinal, 0});
+            }
+        } else if (!t->params.empty()) {
+            f.first = uint32_t(params.size());
+            f.members = uint32_t(t->params.size());
+            for (const Parameter &p : t->params) {
+                params.push_back({p.type, str(p.name), str(p.comment), p.ordinal, p.length});
+            }
+        } else if (!t->values.empty()) {
+            f.first = uint32_t(values.size());
+            f.members = uint32_t(t->values.size());
+            for (const EnumValue &v : t->values) {
+                values.push_back({v.value, str(v.name)});
+            }
+        }
+        if (f.table >= 16) {
+            throw FormatError("flat archive: type id " + std::to_string(t->id) + " out of range");
+        }
+        largest[f.table] = std::max(largest[f.table], key_of(t->id));
+        per_table[f.table]++;
+        types.push_back(f);
+    }
+
+    std::vector<uint32_t> directory;
+    for (int tb = 0; tb < 16; tb++) {
+        if (largest[tb] < 0) {
+            continue;
+        }
+        uint64_t slots = uint64_t(largest[tb]) + 1;
+        if (slots > MAX_SPARSE * per_table[tb] + 1024 || directory.size() + slots > UINT32_MAX) {
+            throw FormatError("flat archive: keys of table " + std::to_string(tb) + " too sparse");
+        }
+        h.table_first[tb] = uint32_t(directory.size());
+        h.table_slots[tb] = uint32_t(slots);
+        directory.resize(directory.size() + slots, FLAT_NONE);
+    }
+    for (size_t i = 0; i < types.size(); i++) {
+        directory[h.table_first[types[i].table] + size_t(key_of(types[i].id))] = uint32_t(i);
+    }
+
+    size_t named = 0;
+    for (const FlatType &f : types) {
+        named += named_kind(f.table);
+    }
+    size_t capacity = 8;
+    while (capacity < 2 * named) {
+        capacity *= 2;
+    }
+    std::vector<uint32_t> names(capacity, FLAT_NONE);
+    for (size_t i = 0; i < types.size(); i++) {
+        if (!named_kind(types[i].table)) {
+            continue;
+        }
+        size_t slot = common::hash_string(a.types()[i]->name) & (capacity - 1);
+        while (names[slot] != FLAT_NONE) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        names[slot] = uint32_t(i);
+    }
+
+    std::vector<FlatSource> sources;
+    for (const SourceArchive &s : a.source_archives()) {
+        FlatSource f;
+        std::memset(&f, 0, sizeof f);
+        f.id = s.id;
+        f.last_sync_time = s.last_sync_time;
+        f.domain_file_id = str(s.domain_file_id);
+        f.name = str(s.name);
+        f.type = s.type;
+        f.dirty = s.dirty;
+        sources.push_back(f);
+    }
+    h.name = str(name);
+
+    std::vector<uint8_t> out(sizeof h);
+    auto section = [&](FlatSection &sec, const void *p, size_t count, size_t size) {
+        out.resize((out.size() + 7) & ~size_t(7), 0);
+        sec.offset = out.size();
+        sec.count = count;
+        const uint8_t *b = static_cast<const uint8_t *>(p);
+        out.insert(out.end(), b, b + count * size);
+    };
+    section(h.strings, strings.data(), strings.size(), 1);
+    section(h.categories, categories.data(), categories.size(), sizeof(FlatCategory));
+    section(h.types, types.data(), types.size(), sizeof(FlatType));
+    section(h.directory, directory.data(), directory.size(), sizeof(uint32_t));
+    section(h.components, components.data(), components.size(), sizeof(FlatComponent));
+    section(h.params, params.data(), params.size(), sizeof(FlatParameter));
+    section(h.values, values.data(), values.size(), sizeof(FlatValue));
+    section(h.names, names.data(), names.size(), sizeof(uint32_t));
+    section(h.sources, sources.data(), sources.size(), sizeof(FlatSource));
+    std::memcpy(out.data(), &h, sizeof h);
+    return out;
+}
+
+// A mapped .gdtf.
+class FlatArchive {
+  public:
+    explicit FlatArchive(const std::string &path) : file_(path) {
+        const uint8_t *d = file_.data();
+        if (file_.size() < sizeof(FlatHeader) || std::memcmp(d, FLAT_MAGIC, 8) != 0) {
+            throw FormatError("not a flat type archive");
+        }
+        h_ = reinterpret_cast<const FlatHeader *>(d);
+        if (h_->version != FLAT_VERSION) {
+            throw FormatError("flat archive version " + std::to_string(h_->version));
+        }
+        if (h_->byte_order != 0x01020304) {
+            throw FormatError("flat archive: byte order of the host is not little-endian");
+        }
+        strings_ = section<char>(h_->strings);
+        categories_ = section<FlatCategory>(h_->categories);
+        types_ = section<FlatType>(h_->types);
+        directory_ = section<uint32_t>(h_->directory);
+        components_ = section<FlatComponent>(h_->components);
+        params_ = section<FlatParameter>(h_->params);
+        values_ = section<FlatValue>(h_->values);
+        names_ = section<uint32_t>(h_->names);
+        sources_ = section<FlatSource>(h_->sources);
+        if (h_->strings.count == 0 || h_->names.count == 0 || (h_->names.count & (h_->names.count - 1)) != 0) {
+            throw FormatError("flat archive: malformed string pool or name table");
+        }
+        for (int tb = 0; tb < 16; tb++) {
+            if (uint64_t(h_->table_first[tb]) + h_->table_slots[tb] > h_->directory.count) {
+                throw FormatError("flat archive: directory out of bounds");
+            }
+        }
+    }
+
+    int64_t database_id() const { return h_->database_id; }
+    std::string_view name() const { return str(h_->name); }
+    size_t types() const { return size_t(h_->types.count); }
+    const FlatType &type(size_t i) const { return types_[i]; }
+    const FlatType *begin() const { return types_; }
+    const FlatType *end() const { return types_ + h_->types.count; }
+
+    const FlatType *get(int64_t id) const {
+        uint8_t tb = table_of(id);
+        uint64_t key = uint64_t(key_of(id));
+        if (tb >= 16 || key >= h_->table_slots[tb]) {
+            return nullptr;
+        }
+        uint32_t i = directory_[h_->table_first[tb] + key];
+        return i < h_->types.count ? &types_[i] : nullptr;
+    }
+
+    // First named type called 'name', in type order. A table without an
+    // empty slot is probed once around.
+    const FlatType *find(std::string_view name) const {
+        size_t mask = size_t(h_->names.count) - 1;
+        size_t slot = common::hash_bytes(name.data(), name.size()) & mask;
+        for (size_t probes = 0; probes < h_->names.count; probes++, slot = (slot + 1) & mask) {
+            uint32_t i = names_[slot];
+            if (i >= h_->types.count) {
+                return nullptr;
+            }
+            if (str(types_[i].name) == name) {
+                return &types_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    std::string_view str(FlatString s) const {
+        if (uint64_t(s.offset) + s.size >= h_->strings.count) {
+            throw FormatError("flat archive: string out of bounds");
+        }
+        return std::string_view(strings_ + s.offset, s.size);
+    }
+
+    // The components of a composite, the parameters of a function
+    // definition and the values of an enum; 'n' is set to their number.
+    const FlatComponent *components(const FlatType &t, size_t &n) const {
+        return run(components_, h_->components, t, T_COMPOSITE, n);
+    }
+    const FlatParameter *params(const FlatType &t, size_t &n) const {
+        return run(params_, h_->params, t, T_FUNCDEF, n);
+    }
+    const FlatValue *values(const FlatType &t, size_t &n) const { return run(values_, h_->values, t, T_ENUM, n); }
+
+    const FlatCategory *category(int64_t id) const {
+        const FlatCategory *b = categories_, *e = categories_ + h_->categories.count;
+        const FlatCategory *c = std::lower_bound(b, e, id, [](const FlatCategory &x, int64_t v) { return x.id < v; });
+        return c != e && c->id == id ? c : nullptr;
+    }
+
+    // "/jni_all.h/functions", as Archive::category_path().
+    std::string category_path(int64_t id) const {
+        std::string path;
+        for (int depth = 0; depth < 64; depth++) {
+            const FlatCategory *c = category(id);
+            if (!c || c->parent < 0) {
+                break;
+            }
+            path = "/" + std::string(str(c->name)) + path;
+            id = c->parent;
+        }
+        return path.empty() ? "/" : path;
+    }
+
+    size_t source_archives() const { return size_t(h_->sources.count); }
+    const FlatSource &source_archive(size_t i) const { return sources_[i]; }
+
+    // 't' as a DataType of the model, for code written against Archive.
+    DataType data_type(const FlatType &t) const {
+        DataType d;
+        d.id = t.id;
+        d.name = std::string(str(t.name));
+        d.comment = std::string(str(t.comment));
+        d.category = t.category;
+        d.class_name = std::string(str(t.class_name));
+        d.target = t.target;
+        d.length = t.length;
+        d.count = t.count;
+        d.is_union = t.is_union;
+        d.packing = t.packing;
+        d.alignment = t.alignment;
+        d.num_components = t.num_components;
+        d.return_type = t.return_type;
+        d.flags = t.flags;
+        d.source_archive = t.source_archive;
+        d.universal_id = t.universal_id;
+        d.source_sync_time = t.source_sync_time;
+        d.last_change_time = t.last_change_time;
+        size_t n;
+        const FlatComponent *c = components(t, n);
+        for (size_t k = 0; k < n; k++) {
+            d.components.push_back({0, c[k].offset, c[k].type, std::string(str(c[k].name)),
+                                    std::string(str(c[k].comment)), c[k].size, c[k].ordinal});
+        }
+        const FlatParameter *p = params(t, n);
+        for (size_t k = 0; k < n; k++) {
+            d.params.push_back({0, p[k].type, std::string(str(p[k].name)), std::string(str(p[k].comment)),
+                                p[k].ordinal, p[k].length});
+        }
+        const FlatValue *v = values(t, n);
+        for (size_t k = 0; k < n; k++) {
+            d.values.push_back({0, std::string(str(v[k].name)), v[k].value});
+        }
+        return d;
+    }
+
+  private:
+    template <class T>
+    const T *section(const FlatSection &s) const {
+        if (s.offset % 8 != 0 || s.offset > file_.size() || s.count > (file_.size() - s.offset) / sizeof(T)) {
+            throw FormatError("flat archive: section out of bounds");
+        }
+        return reinterpret_cast<const T *>(file_.data() + s.offset);
+    }
+
+    template <class T>
+    static const T *run(const T *base, const FlatSection &sec, const FlatType &t, uint8_t table, size_t &n) {
+        n = t.table == table ? t.members : 0;
+        if (n == 0) {
+            return base;
+        }
+        if (uint64_t(t.first) + n > sec.count) {
+            throw FormatError("flat archive: members out of bounds");
+        }
+        return base + t.first;
+    }
+
+    common::MappedFile file_;
+    const FlatHeader *h_ = nullptr;
+    const char *strings_ = nullptr;
+    const FlatCategory *categories_ = nullptr;
+    const FlatType *types_ = nullptr;
+    const uint32_t *directory_ = nullptr;
+    const FlatComponent *components_ = nullptr;
+    const FlatParameter *params_ = nullptr;
+    const FlatValue *values_ = nullptr;
+    const uint32_t *names_ = nullptr;
+    const FlatSource *sources_ = nullptr;
+};
+
+}  // namespace gdt
@@ -0,0 +1,110 @@
+/*
+ *   Structural signatures of the named data types of an archive.
+ *
+ *   A signature is a 64-bit hash of what a type declares, not of where it
+ *   lives: the kind, the stored size and, per kind,
+ *
+ *     composite   union flag, packing, and per member offset, size, name and
+ *                 type name
+ *     enum        size and every (name, value)
+ *     typedef     the name of the type it stands for
+ *     function    return type, parameter types and varargs (parameter
+ *                 names are documentation and left out)
+ *     built-in    the implementing class
+ *
+ *   Types referenced by a member or a typedef enter by name only, so a
+ *   signature is computed from the type's own record in time linear in its
+ *   members, and a change to a referenced type shows up as a difference of
+ *   that type rather than of everything using it. Category paths and ids
+ *   are left out: the same declaration hashes the same in every archive.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "common/hash.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace gdt {
+
+// Kinds that have a name of their own (pointers and arrays are spelled
+// from their target).
+inline bool named_kind(uint8_t table) {
+    return table == T_BUILTIN || table == T_COMPOSITE || table == T_TYPEDEF || table == T_FUNCDEF ||
+           table == T_ENUM;
+}
+
+inline const char *kind_name(const DataType &t) {
+    switch (t.table()) {
+    case T_BUILTIN: return "builtin";
+    case T_COMPOSITE: return t.is_union ? "union" : "struct";
+    case T_TYPEDEF: return "typedef";
+    case T_FUNCDEF: return "function";
+    case T_ENUM: return "enum";
+    case T_POINTER: return "pointer";
+    case T_ARRAY: return "array";
+    default: return "?";
+    }
+}
+
+inline uint64_t signature(const Archive &a, const DataType &t) {
+    using common::combine;
+    using common::hash_string;
+    uint64_t h = combine(t.table(), uint64_t(int64_t(t.length)));
+    switch (t.table()) {
+    case T_COMPOSITE:
+        h = combine(combine(h, t.is_union), uint64_t(int64_t(t.packing)));
+        for (const Component &c : t.components) {
+            h = combine(h, uint64_t(int64_t(c.offset)));
+            h = combine(h, uint64_t(int64_t(c.size)));
+            h = combine(h, hash_string(c.name));
+            h = combine(h, hash_string(a.type_name(c.type)));
+        }
+        break;
+    case T_ENUM:
+        for (const EnumValue &v : t.values) {
+            h = combine(combine(h, hash_string(v.name)), uint64_t(v.value));
+        }
+        break;
+    case T_TYPEDEF:
+        h = combine(h, hash_string(a.type_name(t.target)));
+        break;
+    case T_FUNCDEF:
+        h = combine(combine(h, hash_string(a.type_name(t.return_type))), t.varargs());
+        for (const Parameter &p : t.params) {
+            h = combine(h, hash_string(a.type_name(p.type)));
+        }
+        break;
+    case T_BUILTIN:
+        h = combine(h, hash_string(t.class_name));
+        break;
+    default:
+        break;
+    }
+    return h;
+}
+
+// One line of what the signature covers, for reports: "struct, 12 members,
+// 48 bytes", "typedef ulong", "int f(char *)".
+inline std::string summary(const Archive &a, const DataType &t) {
+    switch (t.table()) {
+    case T_COMPOSITE:
+        return std::string(kind_name(t)) + ", " + std::to_string(t.components.size()) + " members, " +
+               std::to_string(t.length) + " bytes";
+    case T_ENUM:
+        return "enum, " + std::to_string(t.values.size()) + " values, " + std::to_string(t.length) + " bytes";
+    case T_TYPEDEF:
+        return "typedef " + a.type_name(t.target);
+    case T_FUNCDEF:
+        return a.decl(t.id, t.name);
+    case T_BUILTIN:
+        return "builtin " + t.class_name.substr(t.class_name.rfind('.') + 1);
+    default:
+        return kind_name(t);
+    }
+}
+
+}  // namespace gdt
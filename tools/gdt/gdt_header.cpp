@@ -0,0 +1,127 @@
+/*
+ *   gdt_header: write the types of a .gdt archive back out as C headers,
+ *   one per file category (curl.h, DWARF/urldata.h, nvram.h, jni_all.h)
+ *   plus one named after the archive for types outside any file, under
+ *   outdir (gdt/gdt_header.hpp). The headers include each other as their
+ *   declarations need and compile on their own, for the data organization
+ *   given with --org (default: the one under which most of the archive's
+ *   stored offsets and sizes come out as laid out).
+ *
+ *   Renamed types, dropped defines and composites whose layout could not
+ *   be reproduced go to stderr. One line per header on stdout:
+ *
+ *     path  declarations  bytes
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -Itools tools/gdt/gdt_header.cpp -o gdt_header
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/stat.h>
+
+#include "common/columnar.hpp"
+#include "gdt/gdt_header.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace {
+
+struct Options {
+    std::string org;
+    std::string in;
+    std::string out;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: gdt_header [options] archive.gdt outdir\n"
+                 "  --org NAME  data organization the layouts are checked for: lp64, llp64, ilp32, i386\n"
+                 "              (default: guessed from the archive)\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--org") {
+            o.org = next();
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (o.in.empty()) {
+            o.in = a;
+        } else if (o.out.empty()) {
+            o.out = a;
+        } else {
+            usage();
+        }
+    }
+    if (o.out.empty()) {
+        usage();
+    }
+    return o;
+}
+
+std::string basename(const std::string &path) { return path.substr(path.find_last_of('/') + 1); }
+
+// Creates the directories leading to 'path'.
+void make_parents(const std::string &path) {
+    for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+        std::string dir = path.substr(0, slash);
+        if (::mkdir(dir.c_str(), 0777) != 0 && errno != EEXIST) {
+            throw std::runtime_error(dir + ": " + std::strerror(errno));
+        }
+    }
+}
+
+// Counts what goes through to the file.
+struct CountingFile {
+    common::BufferedFile file;
+    size_t bytes = 0;
+
+    void write(const void *p, size_t n) {
+        file.write(p, n);
+        bytes += n;
+    }
+};
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::string where = opt.in;
+    try {
+        gdt::Archive a(opt.in);
+        gdt::DataOrganization org = opt.org.empty() ? gdt::guess_organization(a) : gdt::DataOrganization::named(opt.org);
+        gdt::CHeaders headers(a, basename(opt.in), org);
+        for (const std::string &note : headers.notes()) {
+            std::fprintf(stderr, "gdt_header: %s: %s\n", opt.in.c_str(), note.c_str());
+        }
+        for (size_t h = 0; h < headers.headers().size(); h++) {
+            const gdt::HeaderFile &f = headers.headers()[h];
+            where = opt.out + "/" + f.path;
+            make_parents(where);
+            CountingFile out{common::BufferedFile(where)};
+            headers.write(h, out);
+            out.file.close();
+            std::printf("%s\t%zu\t%zu\n", where.c_str(), f.decls.size(), out.bytes);
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "gdt_header: %s: %s\n", where.c_str(), e.what());
+        return 1;
+    }
+    return 0;
+}
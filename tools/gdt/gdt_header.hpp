@@ -0,0 +1,1147 @@
+/*
+ *   C headers from a data type archive: the way back from a .gdt to the
+ *   declarations it was parsed or imported from.
+ *
+ *   Every category whose name is a file ("curl.h", "http2.c") becomes a
+ *   header at its path, with the types of its subcategories ("functions",
+ *   "defines", "/urldata.h/Curl_handler"); types outside any file go to a
+ *   header named after the archive. A header holds, in dependency order:
+ *
+ *     composites  "struct/union NAME { ... };", all tags the header uses
+ *                 forward-declared on top so pointer cycles resolve
+ *     enums       "enum NAME { ... };" (the "defines" categories as
+ *                 #define lines)
+ *     typedefs    "typedef TARGET NAME;"
+ *     functions   prototypes for the "functions" categories; a function
+ *                 definition other types refer to is a function type,
+ *                 "typedef void lua_Hook(lua_State *L, lua_Debug *ar);",
+ *                 or, with a name Ghidra made up ("_func_12",
+ *                 "anon_subr_..."), spelled out where a pointer refers to
+ *                 it, as C writes function pointers
+ *
+ *   and includes the headers that declare what it needs first. A
+ *   declaration needs what it names (typedefs, enums: neither can be
+ *   declared ahead in ISO C) and the complete types it holds by value; tags
+ *   reached through pointers need nothing, so a depth-first walk over
+ *   these edges orders any archive in time linear in its types and
+ *   members. Each declaration is spelled out only when written.
+ *
+ *   C has one name per tag and per ordinary identifier where an archive has
+ *   one per category, so a name declared again in another category is
+ *   shared when the declarations are the same (structural signature,
+ *   gdt_hash.hpp) and numbered (NAME_2) when they differ. Names that are
+ *   not identifiers or are keywords are mended, and an enum whose size is
+ *   not that of int is spelled as the integer type of its size where used.
+ *
+ *   Stored offsets are kept. Members of a composite that is not packed are
+ *   written in offset order with explicit padding; when the natural layout
+ *   for the data organization (Layouter) still differs from the archive,
+ *   the composite is written under #pragma pack(1), and if that does not
+ *   match either the natural form stays and the composite is counted as
+ *   inexact. Packed composites carry their #pragma pack and _Alignas.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "gdt/gdt_hash.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace gdt {
+
+// 's' made a C identifier that is no keyword.
+inline std::string c_identifier(const std::string &s) {
+    static const std::unordered_set<std::string> keywords = {
+        "auto",      "break",    "case",     "char",       "const",    "continue",     "default",        "do",
+        "double",    "else",     "enum",     "extern",     "float",    "for",          "goto",           "if",
+        "inline",    "int",      "long",     "register",   "restrict", "return",       "short",          "signed",
+        "sizeof",    "static",   "struct",   "switch",     "typedef",  "union",        "unsigned",       "void",
+        "volatile",  "while",    "_Alignas", "_Alignof",   "_Atomic",  "_Bool",        "_Complex",       "_Generic",
+        "_Imaginary", "_Noreturn", "_Static_assert", "_Thread_local", "bool", "true", "false", "alignas",
+        "alignof",   "static_assert", "thread_local", "typeof", "nullptr", "constexpr"};
+    std::string r = s;
+    for (char &c : r) {
+        if (!(std::isalnum(static_cast<unsigned char>(c)) || c == '_')) {
+            c = '_';
+        }
+    }
+    if (r.empty() || std::isdigit(static_cast<unsigned char>(r[0]))) {
+        r = "_" + r;
+    }
+    return keywords.count(r) ? r + "_" : r;
+}
+
+// A file of the set, relative to the output directory.
+struct HeaderFile {
+    std::string path;             // "DWARF/urldata.h"
+    std::string category;         // "/DWARF/urldata.h", empty for the archive's own
+    std::vector<size_t> includes;  // headers it includes, by index
+    std::vector<int64_t> tags;     // composites it forward-declares
+    std::vector<size_t> decls;     // its declarations, in order
+    size_t owner;                  // header holding its declarations (itself unless in a cycle)
+};
+
+class CHeaders {
+  public:
+    // 'name' is the archive's file name ("libcurl.gdt"); the header for
+    // types outside any file is named after it.
+    CHeaders(const Archive &a, const std::string &name, const DataOrganization &org)
+        : a_(a), name_(name), stem_(name.substr(0, name.find_last_of('.'))), org_(org),
+          sizes_([this](int64_t id) { return get(id); }, org) {
+        classify();
+        assign_names();
+        for (Decl &d : decls_) {
+            d.header = header_of(d.t->category);
+            if (d.kind == Decl::COMPOSITE) {
+                plan(d);
+            }
+        }
+        link();
+        order();
+        check_layouts();
+    }
+
+    const std::vector<HeaderFile> &headers() const { return headers_; }
+    // Renamed types, dropped defines, inexact layouts, include cycles.
+    const std::vector<std::string> &notes() const { return notes_; }
+    size_t declarations() const { return decls_.size(); }
+    size_t inexact() const { return inexact_; }
+
+    // Writes header 'h' to 'out' (anything with write(const void *, size_t)),
+    // one declaration at a time.
+    template <class Out>
+    void write(size_t h, Out &out) const {
+        const HeaderFile &f = headers_[h];
+        std::string guard = "GDT_" + upper(c_identifier(stem_) + "_" + c_identifier(f.path));
+        std::string s = "/* " + f.path + ": " + (f.category.empty() ? "types outside the headers" : f.category) +
+                        " of " + name_ +
+                        (f.owner == h ? " (" + std::to_string(f.decls.size()) + " declarations)"
+                                      : ", declared in " + headers_[f.owner].path) +
+                        " */\n\n#ifndef " + guard + "\n#define " + guard + "\n\n";
+        for (size_t g : f.includes) {
+            s += "#include \"" + relative(f.path, headers_[g].path) + "\"\n";
+        }
+        s += f.includes.empty() ? "" : "\n";
+        for (int64_t tag : f.tags) {
+            s += std::string(get(tag)->is_union ? "union " : "struct ") + names_.at(tag) + ";\n";
+        }
+        s += f.tags.empty() ? "" : "\n";
+        out.write(s.data(), s.size());
+        bool block = false, written = false;
+        for (size_t i : f.decls) {
+            s.clear();
+            const Decl &d = decls_[i];
+            if (d.kind == Decl::OPAQUE) {
+                continue;  // forward-declared above
+            }
+            bool multi = d.kind == Decl::COMPOSITE || d.kind == Decl::ENUM || d.kind == Decl::DEFINES;
+            if ((multi || block) && written) {
+                s += "\n";
+            }
+            block = multi;
+            written = true;
+            declare(d, s);
+            out.write(s.data(), s.size());
+        }
+        s = "\n#endif /* " + guard + " */\n";
+        out.write(s.data(), s.size());
+    }
+
+  private:
+    struct Member {
+        int index;       // component, -1 for padding
+        uint32_t bytes;  // padding
+        std::string name;
+        bool overlaps;   // cannot be placed: written as a comment
+    };
+
+    struct Decl {
+        enum Kind { COMPOSITE, OPAQUE, ENUM, DEFINES, TYPEDEF, FUNCTYPE, PROTOTYPE };
+        Kind kind;
+        const DataType *t;
+        size_t header = 0;
+        std::vector<size_t> needs;
+        std::vector<int64_t> tags;                // composites it mentions
+        std::vector<Member> members;         // composites
+        std::vector<std::string> constants;  // enums and defines; empty where dropped
+        int pack = 0;                        // #pragma pack, 0 for none
+    };
+
+    // Synthetic built-in and padding arrays for the layout check.
+    static constexpr int64_t SYNTHETIC = int64_t(0xf0) << 48;
+
+    const DataType *get(int64_t id) const { return a_.get(canon(id)); }
+
+    // Types declared in another's place, through a forward declaration
+    // that was completed later.
+    int64_t canon(int64_t id) const {
+        for (auto c = canon_.find(id); c != canon_.end(); c = canon_.find(id)) {
+            id = c->second;
+        }
+        return id;
+    }
+
+    static std::string upper(std::string s) {
+        for (char &c : s) {
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+        return s;
+    }
+
+    static std::string comment(const std::string &s) {
+        std::string r;
+        for (size_t i = 0; i < s.size(); i++) {
+            char c = s[i];
+            r += c == '\n' || c == '\r' || c == '\t' ? ' ' : c;
+            if (c == '*' && i + 1 < s.size() && s[i + 1] == '/') {
+                r += ' ';
+            }
+        }
+        return r;
+    }
+
+    // "DWARF/urldata.h" including "curl.h": "../curl.h".
+    static std::string relative(const std::string &from, const std::string &to) {
+        size_t common = 0;
+        for (size_t i = 0; i < from.size() && i < to.size() && from[i] == to[i]; i++) {
+            if (from[i] == '/') {
+                common = i + 1;
+            }
+        }
+        std::string r;
+        for (size_t i = common; i < from.size(); i++) {
+            if (from[i] == '/') {
+                r += "../";
+            }
+        }
+        return r + to.substr(common);
+    }
+
+    static const char *builtin_spelling(const DataType &t, int &bytes) {
+        static const std::map<std::string, std::pair<const char *, int>> spellings = {
+            {"VoidDataType", {"void", 0}},
+            {"BooleanDataType", {"_Bool", 0}},
+            {"CharDataType", {"char", 0}},
+            {"SignedCharDataType", {"signed char", 0}},
+            {"UnsignedCharDataType", {"unsigned char", 0}},
+            {"ShortDataType", {"short", 0}},
+            {"UnsignedShortDataType", {"unsigned short", 0}},
+            {"IntegerDataType", {"int", 0}},
+            {"UnsignedIntegerDataType", {"unsigned int", 0}},
+            {"LongDataType", {"long", 0}},
+            {"UnsignedLongDataType", {"unsigned long", 0}},
+            {"LongLongDataType", {"long long", 0}},
+            {"UnsignedLongLongDataType", {"unsigned long long", 0}},
+            {"FloatDataType", {"float", 0}},
+            {"DoubleDataType", {"double", 0}},
+            {"LongDoubleDataType", {"long double", 0}},
+            {"ByteDataType", {"unsigned char", 0}},
+            {"SignedByteDataType", {"signed char", 0}},
+            {"WordDataType", {"unsigned short", 0}},
+            {"SignedWordDataType", {"short", 0}},
+            {"DWordDataType", {"unsigned int", 0}},
+            {"SignedDWordDataType", {"int", 0}},
+            {"QWordDataType", {"unsigned long long", 0}},
+            {"SignedQWordDataType", {"long long", 0}},
+            {"Undefined1DataType", {"unsigned char", 0}},
+            {"Undefined2DataType", {"unsigned short", 0}},
+            {"Undefined4DataType", {"unsigned int", 0}},
+            {"Undefined8DataType", {"unsigned long long", 0}},
+            {"Undefined3DataType", {"unsigned char", 3}},
+            {"Undefined5DataType", {"unsigned char", 5}},
+            {"Undefined6DataType", {"unsigned char", 6}},
+            {"Undefined7DataType", {"unsigned char", 7}},
+            {"WideCharDataType", {"int", 0}},
+            {"WideChar16DataType", {"unsigned short", 0}},
+            {"WideChar32DataType", {"unsigned int", 0}},
+        };
+        auto it = spellings.find(t.class_name.substr(t.class_name.rfind('.') + 1));
+        bytes = it == spellings.end() ? 0 : it->second.second;
+        return it == spellings.end() ? "unsigned char" : it->second.first;
+    }
+
+    // An enum that is not written as "enum NAME": the integer of its size.
+    static const char *enum_integer(const DataType &t) {
+        bool is_signed = false;
+        for (const EnumValue &v : t.values) {
+            is_signed = is_signed || v.value < 0;
+        }
+        switch (t.length) {
+        case 1: return is_signed ? "signed char" : "unsigned char";
+        case 2: return is_signed ? "short" : "unsigned short";
+        case 8: return is_signed ? "long long" : "unsigned long long";
+        default: return is_signed ? "int" : "unsigned int";
+        }
+    }
+
+    const Decl *decl_of(int64_t id) const {
+        auto it = index_.find(canon(id));
+        return it == index_.end() ? nullptr : &decls_[it->second];
+    }
+
+    bool spelled_as_enum(const DataType &t) const {
+        const Decl *d = decl_of(t.id);
+        return d && d->kind == Decl::ENUM && (t.length == 4 || t.length <= 0);
+    }
+
+    // C declaration of 'inner' with type 'id', as Archive::decl() but with
+    // the names written here.
+    std::string decl(int64_t id, const std::string &inner, int depth = 0) const {
+        std::string space = inner.empty() ? "" : " ";
+        if (depth > 64) {
+            throw FormatError("type nesting too deep at " + a_.type_name(id));
+        }
+        if (table_of(id) == T_BITFIELD) {
+            BitField bf(id);
+            return decl(bf.base, inner, depth + 1) + " : " + std::to_string(bf.bit_size);
+        }
+        const DataType *t = get(id);
+        if (!t) {
+            return "unsigned char" + space + inner;
+        }
+        switch (t->table()) {
+        case T_BUILTIN: {
+            if (t->class_name.size() >= 15 && t->class_name.compare(t->class_name.size() - 15, 15, "PointerDataType") == 0) {
+                return "void *" + inner;
+            }
+            int bytes = 0;
+            std::string base = builtin_spelling(*t, bytes);
+            return base + space + inner + (bytes ? "[" + std::to_string(bytes) + "]" : "");
+        }
+        case T_POINTER: {
+            if (t->target == NULL_ID) {
+                return "void *" + inner;
+            }
+            const DataType *to = get(t->target);
+            bool wrap = to && (to->table() == T_ARRAY || (to->table() == T_FUNCDEF && !typedefd(*to)));
+            return decl(t->target, wrap ? "(*" + inner + ")" : "*" + inner, depth + 1);
+        }
+        case T_ARRAY:
+            return decl(t->target, inner + "[" + std::to_string(std::max(0, t->count)) + "]", depth + 1);
+        case T_FUNCDEF: {
+            if (typedefd(*t)) {
+                return names_.at(t->id) + space + inner;
+            }
+            return prototype(*t, inner, depth);
+        }
+        case T_COMPOSITE:
+            return std::string(t->is_union ? "union " : "struct ") + names_.at(t->id) + space + inner;
+        case T_ENUM:
+            return (spelled_as_enum(*t) ? "enum " + names_.at(t->id) : std::string(enum_integer(*t))) + space + inner;
+        case T_TYPEDEF:
+            return names_.at(t->id) + space + inner;
+        default:
+            return "unsigned char" + space + inner;
+        }
+    }
+
+    bool typedefd(const DataType &f) const {
+        const Decl *d = decl_of(f.id);
+        return d && d->kind == Decl::FUNCTYPE;
+    }
+
+    std::string prototype(const DataType &f, const std::string &inner, int depth) const {
+        std::string args;
+        std::set<std::string> seen;
+        for (const Parameter &p : f.params) {
+            std::string n = p.name.empty() ? "" : c_identifier(p.name);
+            while (!n.empty() && !seen.insert(n).second) {
+                n += "_";
+            }
+            args += (args.empty() ? "" : ", ") + decl(p.type, n, depth + 1);
+        }
+        if (f.varargs()) {
+            args += args.empty() ? "..." : ", ...";
+        } else if (args.empty()) {
+            args = "void";
+        }
+        int64_t ret = f.return_type == NULL_ID ? DEFAULT_ID : f.return_type;
+        return decl(ret, inner + "(" + args + ")", depth + 1);
+    }
+
+    // What declaring something of type 'id' needs first: the declarations
+    // it names and, if held by 'value', those that complete it. Tags go to
+    // 'tags' for forward declarations.
+    void needs(int64_t id, bool value, std::vector<size_t> &out, std::vector<int64_t> &tags, int depth = 0) const {
+        if (depth > 64) {
+            throw FormatError("type nesting too deep at " + a_.type_name(id));
+        }
+        if (table_of(id) == T_BITFIELD) {
+            needs(BitField(id).base, true, out, tags, depth + 1);
+            return;
+        }
+        const DataType *t = get(id);
+        if (!t) {
+            return;
+        }
+        auto named = [&]() {
+            auto it = index_.find(t->id);
+            if (it != index_.end()) {
+                out.push_back(it->second);
+            }
+        };
+        switch (t->table()) {
+        case T_POINTER:
+            if (t->target != NULL_ID) {
+                needs(t->target, false, out, tags, depth + 1);
+            }
+            break;
+        case T_ARRAY:
+            needs(t->target, true, out, tags, depth + 1);
+            break;
+        case T_TYPEDEF:
+            named();
+            if (value) {
+                needs(t->target, true, out, tags, depth + 1);
+            }
+            break;
+        case T_ENUM:
+            if (spelled_as_enum(*t)) {
+                named();
+            }
+            break;
+        case T_COMPOSITE:
+            tags.push_back(t->id);
+            if (value) {
+                named();
+            }
+            break;
+        case T_FUNCDEF:
+            if (typedefd(*t)) {
+                named();
+                break;
+            }
+            needs(t->return_type == NULL_ID ? DEFAULT_ID : t->return_type, false, out, tags, depth + 1);
+            for (const Parameter &p : t->params) {
+                needs(p.type, false, out, tags, depth + 1);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    static const std::string &category_name(const Archive &a, int64_t cat) {
+        static const std::string none;
+        auto it = a.categories().find(cat);
+        return it == a.categories().end() ? none : it->second.name;
+    }
+
+    // Function definitions reached by pointer from another type, and those
+    // that would expand into themselves.
+    void classify() {
+        std::unordered_set<int64_t> referenced;
+        auto refer = [&](int64_t id) {
+            if (table_of(id) != T_BITFIELD) {
+                referenced.insert(id);
+            }
+        };
+        for (const DataType *t : a_.types()) {
+            if (t->table() == T_POINTER || t->table() == T_ARRAY || t->table() == T_TYPEDEF) {
+                refer(t->target);
+            }
+            for (const Component &c : t->components) {
+                refer(c.type);
+            }
+            for (const Parameter &p : t->params) {
+                refer(p.type);
+            }
+            refer(t->return_type);
+        }
+        std::unordered_set<int64_t> cyclic = expansion_cycles();
+        for (const DataType *t : a_.types()) {
+            Decl d;
+            d.t = t;
+            const std::string &cat = category_name(a_, t->category);
+            switch (t->table()) {
+            case T_COMPOSITE:
+                d.kind = t->components.empty() && t->length <= 0 ? Decl::OPAQUE : Decl::COMPOSITE;
+                break;
+            case T_ENUM:
+                if (cat == "defines") {
+                    d.kind = Decl::DEFINES;
+                } else if (!t->values.empty()) {
+                    d.kind = Decl::ENUM;
+                } else {
+                    continue;
+                }
+                break;
+            case T_TYPEDEF:
+                d.kind = Decl::TYPEDEF;
+                break;
+            case T_FUNCDEF: {
+                bool made = t->name.rfind("_func_", 0) == 0 || t->name.rfind("anon_subr_", 0) == 0;
+                bool used = referenced.count(t->id) != 0;
+                if (cyclic.count(t->id) || (used && !made) || (!used && cat != "functions")) {
+                    d.kind = Decl::FUNCTYPE;
+                } else if (!used) {
+                    d.kind = Decl::PROTOTYPE;
+                } else {
+                    continue;
+                }
+                break;
+            }
+            default:
+                continue;
+            }
+            decls_.push_back(std::move(d));
+        }
+    }
+
+    // Function definitions whose signature reaches themselves through
+    // pointers and arrays only; they cannot be spelled out in place.
+    std::unordered_set<int64_t> expansion_cycles() const {
+        std::unordered_map<int64_t, int> state;
+        std::unordered_set<int64_t> cyclic;
+        std::function<void(int64_t, int)> visit_type;
+        std::function<void(const DataType &)> visit = [&](const DataType &f) {
+            int &s = state[f.id];
+            if (s == 1) {
+                cyclic.insert(f.id);
+            }
+            if (s) {
+                return;
+            }
+            s = 1;
+            visit_type(f.return_type, 0);
+            for (const Parameter &p : f.params) {
+                visit_type(p.type, 0);
+            }
+            state[f.id] = 2;
+        };
+        visit_type = [&](int64_t id, int depth) {
+            const DataType *t = table_of(id) == T_BITFIELD || depth > 64 ? nullptr : a_.get(id);
+            if (!t) {
+                return;
+            }
+            if (t->table() == T_POINTER || t->table() == T_ARRAY) {
+                visit_type(t->target, depth + 1);
+            } else if (t->table() == T_FUNCDEF) {
+                visit(*t);
+            }
+        };
+        for (const DataType *t : a_.types()) {
+            if (t->table() == T_FUNCDEF) {
+                visit(*t);
+            }
+        }
+        return cyclic;
+    }
+
+    // C names for the declarations, in type order: the first of a name
+    // keeps it, the same declaration again shares it, a different one is
+    // numbered.
+    void assign_names() {
+        struct Holder {
+            size_t decl;
+            uint64_t signature;
+        };
+        std::unordered_map<std::string, Holder> tags, ordinary;
+        std::unordered_set<std::string> used;  // every identifier, for defines
+        auto unique = [&](std::unordered_map<std::string, Holder> &space, const std::string &n, size_t k) {
+            std::string r = n;
+            for (int i = 2; space.count(r); i++) {
+                r = n + "_" + std::to_string(i);
+            }
+            space[r] = Holder{k, 0};
+            return r;
+        };
+        std::vector<Decl> kept;
+        std::vector<bool> dropped(decls_.size());
+        for (size_t k = 0; k < decls_.size(); k++) {
+            Decl &d = decls_[k];
+            const DataType &t = *d.t;
+            if (d.kind == Decl::DEFINES) {
+                continue;
+            }
+            bool tag = d.kind == Decl::COMPOSITE || d.kind == Decl::OPAQUE || d.kind == Decl::ENUM;
+            auto &space = tag ? tags : ordinary;
+            std::string n = c_identifier(t.name);
+            uint64_t sig = signature(a_, t);
+            auto it = space.find(n);
+            if (it != space.end()) {
+                Decl &first = decls_[it->second.decl];
+                bool same_tag = tag && first.t->table() == t.table() && first.t->is_union == t.is_union;
+                if (same_tag && d.kind == Decl::OPAQUE) {
+                    canon_[t.id] = first.t->id;
+                    dropped[k] = true;
+                    continue;
+                }
+                if (same_tag && first.kind == Decl::OPAQUE && d.kind == Decl::COMPOSITE) {
+                    canon_[first.t->id] = t.id;
+                    dropped[it->second.decl] = true;
+                    names_[t.id] = n;
+                    it->second = Holder{k, sig};
+                    continue;
+                }
+                if (first.kind == d.kind && it->second.signature == sig) {
+                    canon_[t.id] = first.t->id;
+                    dropped[k] = true;
+                    continue;
+                }
+            }
+            std::string r = unique(space, n, k);
+            space[r].signature = sig;
+            if (r != t.name) {
+                renamed_[t.id] = t.name;
+                if (r != n) {
+                    notes_.push_back(std::string(kind_name(t)) + " " + t.name + " in " + a_.category_path(t.category) +
+                                     " renamed " + r + ": the name is taken");
+                }
+            }
+            names_[t.id] = r;
+        }
+        // Enum constants share the ordinary names.
+        for (size_t k = 0; k < decls_.size(); k++) {
+            Decl &d = decls_[k];
+            if (d.kind != Decl::ENUM || dropped[k]) {
+                continue;
+            }
+            for (const EnumValue &v : d.t->values) {
+                d.constants.push_back(unique(ordinary, c_identifier(v.name), k));
+            }
+        }
+        for (const auto &kv : tags) {
+            used.insert(kv.first);
+        }
+        for (const auto &kv : ordinary) {
+            used.insert(kv.first);
+        }
+        for (const DataType *t : a_.types()) {
+            for (const Component &c : t->components) {
+                used.insert(c_identifier(c.name));
+            }
+            for (const Parameter &p : t->params) {
+                used.insert(c_identifier(p.name));
+            }
+        }
+        size_t clashes = 0;
+        for (size_t k = 0; k < decls_.size(); k++) {
+            Decl &d = decls_[k];
+            if (d.kind != Decl::DEFINES) {
+                continue;
+            }
+            for (const EnumValue &v : d.t->values) {
+                std::string n = c_identifier(v.name);
+                bool ok = n == v.name && used.insert(n).second;
+                clashes += !ok;
+                d.constants.push_back(ok ? n : std::string());
+            }
+        }
+        if (clashes) {
+            notes_.push_back(std::to_string(clashes) + " defines left out: their names are taken");
+        }
+        for (size_t k = 0; k < decls_.size(); k++) {
+            if (!dropped[k]) {
+                index_[decls_[k].t->id] = kept.size();
+                kept.push_back(std::move(decls_[k]));
+            }
+        }
+        decls_ = std::move(kept);
+    }
+
+    size_t header_of(int64_t cat) {
+        auto memo = header_by_category_.find(cat);
+        if (memo != header_by_category_.end()) {
+            return memo->second;
+        }
+        int64_t file = -1;
+        for (int64_t c = cat, depth = 0; depth < 64; depth++) {
+            auto it = a_.categories().find(c);
+            if (it == a_.categories().end() || it->second.parent < 0) {
+                break;
+            }
+            if (it->second.name.find('.') != std::string::npos) {
+                file = c;
+            }
+            c = it->second.parent;
+        }
+        std::string category = file < 0 ? "" : a_.category_path(file);
+        std::string path = file < 0 ? stem_ + ".h" : category.substr(1);
+        if (path.size() < 2 || path.compare(path.size() - 2, 2, ".h") != 0) {
+            path += ".h";
+        }
+        size_t h = headers_.size();
+        for (size_t i = 0; i < headers_.size(); i++) {
+            if (headers_[i].path == path) {
+                h = i;
+            }
+        }
+        if (h == headers_.size()) {
+            headers_.push_back(HeaderFile{path, category, {}, {}, {}, h});
+        } else if (headers_[h].category.empty()) {
+            headers_[h].category = category;
+        }
+        return header_by_category_[cat] = h;
+    }
+
+    // Members of a composite in the order written: stored offsets with
+    // explicit padding unless packed. Member sizes are those of the data
+    // organization; the archive's may be another's.
+    void plan(Decl &d) {
+        const DataType &t = *d.t;
+        std::set<std::string> seen;
+        auto name = [&](const Component &c) {
+            std::string n = c.name.empty() ? "" : c_identifier(c.name);
+            if (n.empty()) {
+                char buf[32];
+                std::snprintf(buf, sizeof buf, t.is_union ? "field%d" : "field_0x%x", t.is_union ? c.ordinal : c.offset);
+                n = buf;
+            }
+            while (!seen.insert(n).second) {
+                n += "_";
+            }
+            return n;
+        };
+        auto pad = [&](uint32_t bytes) {
+            std::string n = "_pad" + std::to_string(d.members.size());
+            while (!seen.insert(n).second) {
+                n += "_";
+            }
+            d.members.push_back(Member{-1, bytes, n, false});
+        };
+        std::vector<size_t> order(t.components.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        if (t.packing >= 0 || t.is_union) {
+            for (size_t i : order) {
+                d.members.push_back(Member{int(i), 0, name(t.components[i]), false});
+            }
+            if (d.members.empty()) {
+                pad(uint32_t(std::max(1, t.length)));
+            }
+            return;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t x, size_t y) { return t.components[x].offset < t.components[y].offset; });
+        int64_t cursor = 0;
+        for (size_t i : order) {
+            const Component &c = t.components[i];
+            bool bits = table_of(c.type) == T_BITFIELD;
+            if (c.offset < cursor && !bits) {
+                d.members.push_back(Member{int(i), 0, name(c), true});
+                continue;
+            }
+            if (c.offset > cursor) {
+                pad(uint32_t(c.offset - cursor));
+                cursor = c.offset;
+            }
+            d.members.push_back(Member{int(i), 0, name(c), false});
+            int64_t size = bits ? std::max(0, c.size) : int64_t(sizes_.layout(c.type).size);
+            cursor = std::max<int64_t>(cursor, int64_t(c.offset) + size);
+        }
+        if (t.length > cursor) {
+            pad(uint32_t(t.length - cursor));
+        }
+    }
+
+    void link() {
+        for (size_t k = 0; k < decls_.size(); k++) {
+            Decl &d = decls_[k];
+            const DataType &t = *d.t;
+            std::vector<int64_t> tags;
+            switch (d.kind) {
+            case Decl::COMPOSITE:
+                tags.push_back(t.id);
+                for (const Member &m : d.members) {
+                    if (m.index >= 0 && !m.overlaps) {
+                        needs(t.components[size_t(m.index)].type, true, d.needs, tags);
+                    }
+                }
+                break;
+            case Decl::OPAQUE:
+                tags.push_back(t.id);
+                break;
+            case Decl::TYPEDEF:
+                needs(t.target, false, d.needs, tags);
+                break;
+            case Decl::FUNCTYPE:
+            case Decl::PROTOTYPE:
+                needs(t.return_type == NULL_ID ? DEFAULT_ID : t.return_type, false, d.needs, tags);
+                for (const Parameter &p : t.params) {
+                    needs(p.type, false, d.needs, tags);
+                }
+                break;
+            default:
+                break;
+            }
+            d.needs.erase(std::remove(d.needs.begin(), d.needs.end(), k), d.needs.end());
+            for (int64_t tag : tags) {
+                d.tags.push_back(canon(tag));
+            }
+        }
+    }
+
+    // Depth first, dependencies before dependents, otherwise in type order;
+    // then per header, and the headers each one needs.
+    void order() {
+        std::vector<int> state(decls_.size(), 0);
+        size_t cycles = 0;
+        for (size_t root = 0; root < decls_.size(); root++) {
+            if (state[root]) {
+                continue;
+            }
+            std::vector<std::pair<size_t, size_t>> stack{{root, 0}};
+            state[root] = 1;
+            while (!stack.empty()) {
+                auto &top = stack.back();
+                const Decl &d = decls_[top.first];
+                if (top.second < d.needs.size()) {
+                    size_t n = d.needs[top.second++];
+                    if (state[n] == 0) {
+                        state[n] = 1;
+                        stack.push_back({n, 0});
+                    } else if (state[n] == 1) {
+                        cycles++;
+                    }
+                    continue;
+                }
+                state[top.first] = 2;
+                sorted_.push_back(top.first);
+                stack.pop_back();
+            }
+        }
+        if (cycles) {
+            notes_.push_back(std::to_string(cycles) + " dependency cycles between declarations");
+        }
+        group();
+        merge_cycles();
+    }
+
+    // Declarations, includes and forward declarations of each header.
+    void group() {
+        std::set<std::pair<size_t, size_t>> included;
+        std::set<std::pair<size_t, int64_t>> tagged;
+        for (HeaderFile &h : headers_) {
+            h.includes.clear();
+            h.tags.clear();
+            h.decls.clear();
+        }
+        for (size_t k : sorted_) {
+            const Decl &d = decls_[k];
+            HeaderFile &h = headers_[d.header];
+            h.decls.push_back(k);
+            for (size_t n : d.needs) {
+                size_t g = decls_[n].header;
+                if (g != d.header && included.insert({d.header, g}).second) {
+                    h.includes.push_back(g);
+                }
+            }
+            for (int64_t tag : d.tags) {
+                if (tagged.insert({d.header, tag}).second) {
+                    h.tags.push_back(tag);
+                }
+            }
+        }
+        for (size_t h = 0; h < headers_.size(); h++) {
+            if (headers_[h].owner != h) {
+                headers_[h].includes.push_back(headers_[h].owner);
+            }
+        }
+    }
+
+    // Headers that need each other (DWARF/urldata.h and DWARF/http.h: a
+    // typedef of one used in a structure of the other, itself held in the
+    // first) cannot both come first. The declarations of such a cycle go to
+    // the one with the most of them, and the others include it.
+    void merge_cycles() {
+        size_t n = headers_.size(), next = 0;
+        std::vector<size_t> index(n, SIZE_MAX), low(n, 0), stack;
+        std::vector<bool> on(n, false);
+        std::vector<std::vector<size_t>> cycles;
+        std::function<void(size_t)> visit = [&](size_t h) {
+            index[h] = low[h] = next++;
+            stack.push_back(h);
+            on[h] = true;
+            for (size_t g : headers_[h].includes) {
+                if (index[g] == SIZE_MAX) {
+                    visit(g);
+                    low[h] = std::min(low[h], low[g]);
+                } else if (on[g]) {
+                    low[h] = std::min(low[h], index[g]);
+                }
+            }
+            if (low[h] == index[h]) {
+                std::vector<size_t> scc;
+                size_t g;
+                do {
+                    g = stack.back();
+                    stack.pop_back();
+                    on[g] = false;
+                    scc.push_back(g);
+                } while (g != h);
+                if (scc.size() > 1) {
+                    cycles.push_back(scc);
+                }
+            }
+        };
+        for (size_t h = 0; h < n; h++) {
+            if (index[h] == SIZE_MAX) {
+                visit(h);
+            }
+        }
+        if (cycles.empty()) {
+            return;
+        }
+        for (const std::vector<size_t> &scc : cycles) {
+            size_t owner = scc.front();
+            for (size_t h : scc) {
+                if (headers_[h].decls.size() > headers_[owner].decls.size()) {
+                    owner = h;
+                }
+            }
+            for (size_t h : scc) {
+                headers_[h].owner = owner;
+                if (h != owner) {
+                    notes_.push_back(headers_[h].path + " declared in " + headers_[owner].path +
+                                     ": the two need each other");
+                }
+            }
+        }
+        for (Decl &d : decls_) {
+            d.header = headers_[d.header].owner;
+        }
+        group();
+    }
+
+    // Lays out each composite as written, in declaration order so what it
+    // holds is settled first, and falls back to #pragma pack(1) where the
+    // natural layout differs from the archive.
+    void check_layouts() {
+        std::unordered_map<int64_t, DataType> synthetic;
+        DataType uchar;
+        uchar.id = make_id(T_BUILTIN, SYNTHETIC);
+        uchar.class_name = "ghidra.program.model.data.UnsignedCharDataType";
+        auto lookup = [&](int64_t id) -> const DataType * {
+            if (id == uchar.id) {
+                return &uchar;
+            }
+            auto s = synthetic.find(canon(id));
+            if (s != synthetic.end()) {
+                return &s->second;
+            }
+            return get(id);
+        };
+        Layouter layouter(lookup, org_);
+        for (size_t k : sorted_) {
+            Decl &d = decls_[k];
+            if (d.kind != Decl::COMPOSITE) {
+                continue;
+            }
+            const DataType &t = *d.t;
+            auto form = [&](int packing) {
+                DataType s = t;
+                s.packing = t.packing >= 0 ? t.packing : packing;
+                s.components.clear();
+                for (const Member &m : d.members) {
+                    if (m.overlaps) {
+                        continue;
+                    }
+                    Component c;
+                    if (m.index >= 0) {
+                        c = t.components[size_t(m.index)];
+                    } else {
+                        c.type = make_id(T_ARRAY, SYNTHETIC + m.bytes);
+                        c.size = int32_t(m.bytes);
+                        DataType &p = synthetic[c.type];
+                        p.id = c.type;
+                        p.target = uchar.id;
+                        p.count = int32_t(m.bytes);
+                        p.length = 1;
+                    }
+                    s.components.push_back(c);
+                }
+                return s;
+            };
+            auto matches = [&](const DataType &s) {
+                TypeLayout l = layouter.layout(s);
+                size_t j = 0;
+                for (const Member &m : d.members) {
+                    if (m.overlaps) {
+                        continue;
+                    }
+                    if (m.index >= 0) {
+                        const Component &c = t.components[size_t(m.index)];
+                        uint64_t bit = table_of(c.type) == T_BITFIELD ? BitField(c.type).bit_offset : 0;
+                        if (l.bit_offsets[j] != uint64_t(c.offset) * 8 + bit) {
+                            return false;
+                        }
+                    }
+                    j++;
+                }
+                return t.length <= 0 || l.size == uint64_t(t.length);
+            };
+            DataType s = form(0);
+            if (t.is_union && t.packing < 0 && layouter.layout(s).size < uint64_t(std::max(0, t.length))) {
+                d.members.push_back(Member{-1, uint32_t(t.length), "_size", false});
+                s = form(0);
+            }
+            d.pack = std::max(0, t.packing);
+            if (!matches(s)) {
+                DataType p = form(1);
+                if (t.packing < 0 && matches(p)) {
+                    d.pack = 1;
+                    s = std::move(p);
+                } else {
+                    inexact_++;
+                    notes_.push_back(std::string(kind_name(t)) + " " + t.name + ": layout differs from the archive");
+                }
+            }
+            synthetic[t.id] = std::move(s);
+        }
+    }
+
+    static std::string number(int64_t v) {
+        std::string s = std::to_string(v);
+        if (v > INT32_MAX || v < INT32_MIN) {
+            s += "LL";
+        }
+        return v < 0 ? "(" + s + ")" : s;
+    }
+
+    void declare(const Decl &d, std::string &s) const {
+        const DataType &t = *d.t;
+        std::string name = d.kind == Decl::DEFINES ? "" : names_.at(t.id);
+        if (!t.comment.empty()) {
+            s += "/* " + comment(t.comment) + " */\n";
+        }
+        auto r = renamed_.find(t.id);
+        if (r != renamed_.end()) {
+            s += "/* " + comment(r->second) + " in the archive */\n";
+        }
+        switch (d.kind) {
+        case Decl::OPAQUE:
+            break;
+        case Decl::COMPOSITE: {
+            if (d.pack) {
+                s += "#pragma pack(push, " + std::to_string(d.pack) + ")\n";
+            }
+            s += std::string(t.is_union ? "union " : "struct ") + name + " {\n";
+            bool aligned = t.alignment <= 0;
+            for (size_t i = 0; i < d.members.size(); i++) {
+                const Member &m = d.members[i];
+                if (m.index < 0) {
+                    s += "    unsigned char " + m.name + "[" + std::to_string(m.bytes) + "];\n";
+                    continue;
+                }
+                const Component &c = t.components[size_t(m.index)];
+                std::string inner = m.name;
+                int64_t type = c.type;
+                const DataType *ct = table_of(type) == T_BITFIELD ? nullptr : get(type);
+                if (ct && ct->table() == T_ARRAY && ct->count <= 0) {
+                    bool last = i + 1 == d.members.size() && i > 0 && !t.is_union;
+                    inner += last ? "[]" : "[0]";
+                    type = ct->target;
+                }
+                std::string line = decl(type, inner) + ";";
+                if (m.overlaps) {
+                    char at[32];
+                    std::snprintf(at, sizeof at, " at 0x%x", c.offset);
+                    line = "/* overlaps: " + comment(line) + at + " */";
+                } else if (!aligned && table_of(c.type) != T_BITFIELD) {
+                    line = "_Alignas(" + std::to_string(t.alignment) + ") " + line;
+                    aligned = true;
+                }
+                s += "    " + line;
+                if (!c.comment.empty()) {
+                    s += " /* " + comment(c.comment) + " */";
+                }
+                s += "\n";
+            }
+            s += "};\n";
+            if (d.pack) {
+                s += "#pragma pack(pop)\n";
+            }
+            break;
+        }
+        case Decl::ENUM:
+            s += "enum " + name + " {\n";
+            for (size_t i = 0; i < t.values.size(); i++) {
+                s += "    " + d.constants[i] + " = " + number(t.values[i].value) +
+                     (i + 1 < t.values.size() ? ",\n" : "\n");
+            }
+            s += "};\n";
+            break;
+        case Decl::DEFINES:
+            for (size_t i = 0; i < t.values.size(); i++) {
+                if (!d.constants[i].empty()) {
+                    s += "#define " + d.constants[i] + " " + number(t.values[i].value) + "\n";
+                }
+            }
+            break;
+        case Decl::TYPEDEF:
+            s += "typedef " + decl(t.target, name) + ";\n";
+            break;
+        case Decl::FUNCTYPE:
+            s += "typedef " + prototype(t, name, 0) + ";\n";
+            break;
+        case Decl::PROTOTYPE:
+            s += std::string(t.no_return() ? "_Noreturn " : "") + prototype(t, name, 0) + ";\n";
+            break;
+        }
+    }
+
+    const Archive &a_;
+    std::string name_;
+    std::string stem_;
+    DataOrganization org_;
+    Layouter sizes_;  // as stored, for padding
+    std::vector<Decl> decls_;
+    std::vector<size_t> sorted_;                        // declarations, dependencies first
+    std::unordered_map<int64_t, size_t> index_;         // type id -> declaration
+    std::unordered_map<int64_t, int64_t> canon_;        // type id -> the one declared in its place
+    std::unordered_map<int64_t, std::string> names_;    // type id -> C name
+    std::unordered_map<int64_t, std::string> renamed_;  // type id -> name in the archive
+    std::vector<HeaderFile> headers_;
+    std::unordered_map<int64_t, size_t> header_by_category_;
+    std::vector<std::string> notes_;
+    size_t inexact_ = 0;
+};
+
+// The data organization an archive was made for: the one under which
+// laying out its composites afresh reproduces most stored offsets and
+// sizes (the stored size of a pointer member is not to be trusted: DWARF
+// imports into 32-bit archives keep 4 for 8-byte pointers). The first of
+// 'names' on ties.
+inline DataOrganization guess_organization(const Archive &a,
+                                           const std::vector<std::string> &names = {"lp64", "ilp32", "llp64", "i386"}) {
+    DataOrganization best = DataOrganization::named(names.at(0));
+    size_t best_score = 0;
+    for (const std::string &name : names) {
+        DataOrganization org = DataOrganization::named(name);
+        org.relayout = true;
+        Layouter layouter([&a](int64_t id) { return a.get(id); }, org);
+        size_t score = 0;
+        for (const DataType *t : a.types()) {
+            if (t->table() != T_COMPOSITE || t->components.empty()) {
+                continue;
+            }
+            TypeLayout l = layouter.layout(*t);
+            for (size_t i = 0; i < t->components.size(); i++) {
+                score += l.offsets[i] == uint64_t(std::max(0, t->components[i].offset));
+            }
+            score += t->length > 0 && l.size == uint64_t(t->length);
+        }
+        if (score > best_score) {
+            best = DataOrganization::named(name);
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+}  // namespace gdt
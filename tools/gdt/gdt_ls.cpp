@@ -0,0 +1,182 @@
+/*
+ *   gdt_ls: list an archive by category. Without paths, the category tree
+ *   in preorder, one line per category:
+ *
+ *     path  types in it  types under it
+ *
+ *   With paths, the types under each: a category path takes the category
+ *   and everything below it ("/DWARF/urldata.h"), a path ending in '*'
+ *   every category whose path starts with the rest ("/DWARF/url*"); -d
+ *   takes only the types directly in a category. One line per type:
+ *
+ *     category  name  kind
+ *
+ *   Queries are slices of the archive's category index
+ *   (gdt/gdt_categories.hpp). --bench N times, best of N rounds, building
+ *   the index and collecting the types under every category with it,
+ *   against doing so by walking each type's parent pointers, instead of
+ *   listing:
+ *
+ *     archive  categories  types  index ms (walk ms)  build ms
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -Itools tools/gdt/gdt_ls.cpp -o gdt_ls
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gdt/gdt_categories.hpp"
+#include "gdt/gdt_hash.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace {
+
+struct Options {
+    bool direct = false;
+    int bench = 0;
+    std::string in;
+    std::vector<std::string> paths;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: gdt_ls [options] archive.gdt [path...]\n"
+                 "  -d         only the types directly in each category\n"
+                 "  --bench N  time subtree queries over all categories, index against parent walks\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "-d") {
+            o.direct = true;
+        } else if (a == "--bench") {
+            o.bench = std::atoi(next());
+            if (o.bench < 1) {
+                usage();
+            }
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (o.in.empty()) {
+            o.in = a;
+        } else {
+            o.paths.push_back(a);
+        }
+    }
+    if (o.in.empty()) {
+        usage();
+    }
+    return o;
+}
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Whether 'cat' is 'ancestor' or below it, by parent pointers.
+bool below(const gdt::Archive &a, int64_t cat, int64_t ancestor) {
+    for (int depth = 0; depth < 64; depth++) {
+        if (cat == ancestor) {
+            return true;
+        }
+        auto it = a.categories().find(cat);
+        if (it == a.categories().end() || it->second.parent < 0) {
+            return false;
+        }
+        cat = it->second.parent;
+    }
+    return false;
+}
+
+void bench(const gdt::Archive &a, const std::string &path, int rounds) {
+    double walk = 1e300, index = 1e300, build = 1e300;
+    size_t walked = 0, sliced = 0;
+    for (int r = 0; r < rounds; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        walked = 0;
+        for (const auto &kv : a.categories()) {
+            for (const gdt::DataType *t : a.types()) {
+                walked += below(a, t->category, kv.first);
+            }
+        }
+        walk = std::min(walk, ms_since(t0));
+
+        t0 = std::chrono::steady_clock::now();
+        gdt::CategoryIndex idx(a);
+        build = std::min(build, ms_since(t0));
+        t0 = std::chrono::steady_clock::now();
+        sliced = 0;
+        for (const auto &kv : a.categories()) {
+            sliced += idx.under(kv.first).size();
+        }
+        index = std::min(index, ms_since(t0));
+    }
+    if (walked != sliced) {
+        throw std::runtime_error("index finds " + std::to_string(sliced) + " types under categories, parent walks " +
+                                 std::to_string(walked));
+    }
+    std::printf("%s\t%zu\t%zu\t%.3f (%.3f)\t%.3f\n", path.c_str(), a.categories().size(), a.types().size(), index,
+                walk, build);
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    try {
+        gdt::Archive a(opt.in);
+        if (opt.bench > 0) {
+            bench(a, opt.in, opt.bench);
+            return 0;
+        }
+        gdt::CategoryIndex idx(a);
+        if (opt.paths.empty()) {
+            for (size_t pos = 0; pos < idx.size(); pos++) {
+                int64_t c = idx.category(pos);
+                std::printf("%s\t%zu\t%zu\n", a.category_path(c).c_str(), idx.in(c).size(), idx.under(c).size());
+            }
+            return 0;
+        }
+        std::unordered_map<int64_t, std::string> paths;  // category -> path, as printed
+        for (const std::string &path : opt.paths) {
+            gdt::TypeRange types;
+            if (!path.empty() && path.back() == '*') {
+                types = idx.prefix(path.substr(0, path.size() - 1));
+            } else {
+                int64_t c = idx.find(path);
+                if (c == gdt::NULL_ID) {
+                    throw std::runtime_error(path + ": no such category");
+                }
+                types = opt.direct ? idx.in(c) : idx.under(c);
+            }
+            for (const gdt::DataType *t : types) {
+                auto it = paths.find(t->category);
+                if (it == paths.end()) {
+                    it = paths.emplace(t->category, a.category_path(t->category)).first;
+                }
+                std::printf("%s\t%s\t%s\n", it->second.c_str(), a.type_name(t->id).c_str(), gdt::kind_name(*t));
+            }
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "gdt_ls: %s: %s\n", opt.in.c_str(), e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,473 @@
+/*
+ *   gdt_matrix: compile a C header into a family of .gdt archives, one per
+ *   combination of configuration options and data organizations.
+ *
+ *   Each --axis is one dimension of the matrix: a macro and the values it
+ *   is forced to, "-" leaving it to the header. Forced macros win over the
+ *   header's own #define and #undef, which the Lua options need (luaconf.h
+ *   sets LUA_32BITS and LUAI_MAXSTACK unconditionally, and the ltests.h
+ *   overrides are commented out). A --section is a dimension too: the
+ *   header with and without that section. For lua_all.h:
+ *
+ *     gdt_matrix --org ilp32,lp64 -DLUA_USE_LINUX --axis LUA_32BITS --axis LUA_USE_C89 \
+ *         --axis LUAI_MAXSTACK=-,50000 --axis LUAI_MAXCCALLS=-,180 --section ltests.h \
+ *         header/lua_all.h out/
+ *
+ *   makes 64 archives, out/lua_all-ilp32.gdt through
+ *   out/lua_all-lp64-LUA_32BITS-LUA_USE_C89-LUAI_MAXSTACK=50000-LUAI_MAXCCALLS=180-no-ltests.h.gdt.
+ *
+ *   Every variant is what gdt_cc would make with the same options, but the
+ *   work is shared. The header is split into sections as gdt_cc does;
+ *   the preprocessing and parsing of a section is kept with a trace of the
+ *   macros it looked at (common/c_preprocessor.hpp), and a later variant
+ *   that agrees on them reuses the parsed section instead of expanding it
+ *   again. The sections a variant does have to expand run in parallel.
+ *   Variants whose sections are the same up to some point share the
+ *   compiled types up to there (gdt/gdt_compile.hpp): the compiler state
+ *   is copied where they part. Options that only change a few constants
+ *   cost a few sections each, not a whole build.
+ *
+ *   One line per archive:
+ *
+ *     out  types  categories  bytes
+ *
+ *   and a last line with the sections expanded and compiled, of those a
+ *   build per variant would have taken. Diagnostics are reported once, as
+ *   gdt_cc does; a variant that stops at #error gets no archive.
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/gdt/gdt_matrix.cpp -o gdt_matrix
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "common/c_preprocessor.hpp"
+#include "common/hash.hpp"
+#include "common/mapped_file.hpp"
+#include "common/parallel.hpp"
+#include "gdt/gdt_compile.hpp"
+#include "gdt/gdt_cparse.hpp"
+#include "gdt/gdt_types.hpp"
+#include "gdt/gdt_write.hpp"
+
+
+namespace {
+
+struct Axis {
+    std::string name;
+    std::vector<std::string> values;  // "-": not forced
+};
+
+struct Options {
+    std::vector<std::pair<char, std::string>> macros;  // 'D' NAME[=VALUE] or 'U' NAME, for every variant
+    std::vector<Axis> axes;
+    std::vector<std::string> sections;
+    std::vector<std::string> orgs = {"ilp32", "lp64"};
+    int64_t time = -1;
+    unsigned jobs = common::default_jobs();
+    std::string in;
+    std::string out;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: gdt_matrix [options] header.h outdir\n"
+                 "  --axis NAME[=V,..]  variants with NAME forced to each value ('-': as the header has it);\n"
+                 "                      NAME alone is NAME=-,1\n"
+                 "  --section NAME      variants with and without section NAME of the header\n"
+                 "  --org LIST          data organizations (default ilp32,lp64; also llp64, i386)\n"
+                 "  -D NAME[=VALUE]     define a macro in every variant (also -DNAME)\n"
+                 "  -U NAME             undefine a macro in every variant\n"
+                 "  --time MS           creation time of the types, ms since 1970 (default: now)\n"
+                 "  -j N                sections expanded in parallel, and archives written\n");
+    std::exit(2);
+}
+
+std::vector<std::string> split_list(const std::string &s) {
+    std::vector<std::string> r;
+    size_t b = 0;
+    for (;;) {
+        size_t e = s.find(',', b);
+        r.push_back(s.substr(b, e == std::string::npos ? std::string::npos : e - b));
+        if (e == std::string::npos) {
+            return r;
+        }
+        b = e + 1;
+    }
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if ((a.rfind("-D", 0) == 0 || a.rfind("-U", 0) == 0) && a.size() >= 2) {
+            o.macros.emplace_back(a[1], a.size() > 2 ? a.substr(2) : std::string(next()));
+        } else if (a == "--axis") {
+            std::string s = next();
+            size_t eq = s.find('=');
+            Axis x;
+            x.name = s.substr(0, eq);
+            x.values = eq == std::string::npos ? std::vector<std::string>{"-", "1"} : split_list(s.substr(eq + 1));
+            if (x.name.empty()) {
+                usage();
+            }
+            o.axes.push_back(x);
+        } else if (a == "--section") {
+            o.sections.push_back(next());
+        } else if (a == "--org") {
+            o.orgs = split_list(next());
+        } else if (a == "--time") {
+            o.time = std::strtoll(next(), nullptr, 10);
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (o.in.empty()) {
+            o.in = a;
+        } else if (o.out.empty()) {
+            o.out = a;
+        } else {
+            usage();
+        }
+    }
+    if (o.out.empty()) {
+        usage();
+    }
+    return o;
+}
+
+std::string basename(const std::string &path) { return path.substr(path.find_last_of('/') + 1); }
+
+// One call on the compiler: the types (phase 0) or the defines (phase 1)
+// of a parsed section, keyed by a hash of what decides its outcome, the
+// section's tokens or its defines.
+struct Step {
+    int phase;
+    uint64_t key;
+    const gdt::CUnit *unit;
+};
+
+struct Variant {
+    std::string name;  // archive name: header stem, org, forced options, left-out sections
+    gdt::DataOrganization org;
+    std::vector<std::pair<std::string, std::string>> forced;
+    std::vector<size_t> parts;  // sections of the header it has, in order
+    std::vector<size_t> units;  // the parsed section used for each
+    std::vector<Step> steps;
+    std::string error;
+};
+
+// All combinations, the organization first and the first axis slowest.
+std::vector<Variant> variants(const Options &opt, const std::vector<gdt::HeaderPart> &parts) {
+    std::string stem = basename(opt.in);
+    stem = stem.substr(0, stem.find_last_of('.'));
+    std::vector<size_t> dims;
+    for (const Axis &x : opt.axes) {
+        dims.push_back(x.values.size());
+    }
+    dims.insert(dims.end(), opt.sections.size(), 2);
+    for (const std::string &s : opt.sections) {
+        bool found = false;
+        for (const gdt::HeaderPart &p : parts) {
+            found = found || p.name == s;
+        }
+        if (!found) {
+            throw std::runtime_error("no section " + s);
+        }
+    }
+    std::vector<Variant> out;
+    for (const std::string &org : opt.orgs) {
+        std::vector<size_t> at(dims.size());
+        for (;;) {
+            Variant v;
+            v.org = gdt::DataOrganization::named(org);
+            v.name = stem + "-" + org;
+            std::set<std::string> left_out;
+            for (size_t d = 0; d < dims.size(); d++) {
+                if (d < opt.axes.size()) {
+                    const Axis &x = opt.axes[d];
+                    const std::string &value = x.values[at[d]];
+                    if (value != "-") {
+                        v.forced.emplace_back(x.name, value);
+                        v.name += "-" + x.name + (value == "1" ? "" : "=" + value);
+                    }
+                } else if (at[d]) {
+                    left_out.insert(opt.sections[d - opt.axes.size()]);
+                    v.name += "-no-" + opt.sections[d - opt.axes.size()];
+                }
+            }
+            for (size_t k = 0; k < parts.size(); k++) {
+                if (!left_out.count(parts[k].name)) {
+                    v.parts.push_back(k);
+                }
+            }
+            out.push_back(v);
+            size_t d = dims.size();
+            while (d > 0 && ++at[d - 1] == dims[d - 1]) {
+                at[--d] = 0;
+            }
+            if (d == 0) {
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+// A section preprocessed and parsed once, for the variants that agree
+// with the macros it looked at.
+struct Parsed {
+    common::Preprocessor::Trace trace;
+    gdt::CUnit unit;
+    uint64_t tokens = 0;
+    uint64_t defines = 0;
+};
+
+struct Stats {
+    size_t expanded = 0;
+    size_t steps[2] = {0, 0};
+};
+
+// Runs the steps of the variants 'vs', which share their first 'depth'
+// steps, from c; the results go to 'done'.
+void compile(gdt::Compiler c, const std::vector<size_t> &vs, size_t depth, const std::vector<Variant> &all,
+             std::vector<gdt::Compiler> &done, std::vector<size_t> &result, Stats &stats) {
+    std::map<std::pair<int, uint64_t>, std::vector<size_t>> next;
+    std::vector<size_t> finished;
+    for (size_t v : vs) {
+        if (depth == all[v].steps.size()) {
+            finished.push_back(v);
+        } else {
+            next[{all[v].steps[depth].phase, all[v].steps[depth].key}].push_back(v);
+        }
+    }
+    if (!finished.empty()) {
+        done.push_back(c);
+        for (size_t v : finished) {
+            result[v] = done.size() - 1;
+        }
+    }
+    for (auto it = next.begin(); it != next.end(); ++it) {
+        gdt::Compiler d = std::next(it) == next.end() ? std::move(c) : c;
+        const Step &s = all[it->second[0]].steps[depth];
+        if (s.phase == 0) {
+            d.add(*s.unit);
+        } else {
+            d.add_defines(*s.unit);
+        }
+        stats.steps[s.phase]++;
+        compile(std::move(d), it->second, depth + 1, all, done, result, stats);
+    }
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::string where = opt.in;
+    try {
+        int64_t time = opt.time >= 0 ? opt.time
+                                     : std::chrono::duration_cast<std::chrono::milliseconds>(
+                                           std::chrono::system_clock::now().time_since_epoch())
+                                           .count();
+        common::MappedFile file(opt.in);
+        const char *text = reinterpret_cast<const char *>(file.data());
+        std::vector<gdt::HeaderPart> parts = gdt::header_parts(text, file.size(), basename(opt.in));
+        std::vector<std::vector<common::CLine>> lines(parts.size());
+        for (size_t k = 0; k < parts.size(); k++) {
+            lines[k] = common::c_lines(text + parts[k].begin, parts[k].end - parts[k].begin, parts[k].line);
+        }
+        std::vector<Variant> all = variants(opt, parts);
+
+        // Variant by variant: replay the sections an earlier variant parsed
+        // in the same macro state, expand the others in parallel from
+        // snapshots taken on a directives-only pass.
+        std::vector<std::vector<Parsed>> parsed(parts.size());
+        std::vector<std::vector<common::Preprocessor::Trace>> directives(parts.size());
+        std::set<std::pair<int, std::string>> reported;
+        Stats stats;
+        size_t planned = 0;
+        for (Variant &v : all) {
+            planned += v.parts.size();
+            common::Preprocessor pp(opt.in);
+            gdt::predefine(pp, v.org);
+            for (const auto &m : opt.macros) {
+                size_t eq = m.second.find('=');
+                if (m.first == 'U') {
+                    pp.undef(m.second);
+                } else if (eq == std::string::npos) {
+                    pp.define(m.second);
+                } else {
+                    pp.define(m.second.substr(0, eq), m.second.substr(eq + 1));
+                }
+            }
+            for (const auto &f : v.forced) {
+                pp.force(f.first, f.second);
+            }
+            struct Miss {
+                size_t index;  // into v.parts
+                common::Preprocessor start;
+                Parsed result;
+                std::string error;
+            };
+            std::vector<Miss> misses;
+            v.units.assign(v.parts.size(), 0);
+            try {
+                for (size_t i = 0; i < v.parts.size(); i++) {
+                    size_t k = v.parts[i];
+                    bool hit = false;
+                    for (size_t e = 0; e < parsed[k].size() && !hit; e++) {
+                        if (pp.replay(parsed[k][e].trace)) {
+                            v.units[i] = e;
+                            hit = true;
+                        }
+                    }
+                    if (hit) {
+                        continue;
+                    }
+                    misses.push_back({i, pp, {}, {}});
+                    bool replayed = false;
+                    for (const auto &t : directives[k]) {
+                        if ((replayed = pp.replay(t))) {
+                            break;
+                        }
+                    }
+                    if (!replayed) {
+                        common::Preprocessor::Trace t;
+                        pp.run(lines[k], nullptr, nullptr, &t);
+                        directives[k].push_back(std::move(t));
+                    }
+                }
+                pp.finish();
+            } catch (const common::CppError &e) {
+                v.error = e.what();
+                continue;
+            }
+            common::parallel_for(misses.size(), opt.jobs, [&](size_t m) {
+                Miss &x = misses[m];
+                std::vector<common::CToken> tokens;
+                x.result.unit.name = parts[v.parts[x.index]].name;
+                try {
+                    x.start.run(lines[v.parts[x.index]], &tokens, &x.result.unit.defines, &x.result.trace);
+                } catch (const common::CppError &e) {
+                    x.error = e.what();
+                    return;
+                }
+                gdt::CParser(tokens, x.result.unit).parse();
+                uint64_t h = v.parts[x.index];
+                for (const common::CToken &t : tokens) {
+                    h = common::combine(h, common::hash_string(t.text, uint64_t(t.line) << 8 | t.kind));
+                }
+                x.result.tokens = h;
+                h = v.parts[x.index];
+                for (const common::Preprocessor::Define &d : x.result.unit.defines) {
+                    h = common::combine(h, common::hash_string(d.name, uint64_t(d.line)));
+                    h = common::combine(h, uint64_t(d.value));
+                }
+                x.result.defines = h;
+            });
+            for (Miss &x : misses) {
+                size_t k = v.parts[x.index];
+                if (!x.error.empty()) {
+                    v.error = x.error;
+                    continue;
+                }
+                for (const gdt::CDiagnostic &d : x.result.unit.diagnostics) {
+                    if (reported.insert({d.line, d.message}).second) {
+                        std::fprintf(stderr, "gdt_matrix: %s:%d: %s\n", opt.in.c_str(), d.line, d.message.c_str());
+                    }
+                }
+                v.units[x.index] = parsed[k].size();
+                parsed[k].push_back(std::move(x.result));
+                stats.expanded++;
+            }
+        }
+
+        // Compile along the tree of shared step sequences, one root per data
+        // organization: the types of every section, then the defines.
+        std::map<std::string, std::vector<size_t>> by_org;
+        for (size_t v = 0; v < all.size(); v++) {
+            Variant &x = all[v];
+            if (!x.error.empty()) {
+                continue;
+            }
+            by_org[x.org.name].push_back(v);
+            for (int phase = 0; phase < 2; phase++) {
+                for (size_t i = 0; i < x.parts.size(); i++) {
+                    const Parsed &p = parsed[x.parts[i]][x.units[i]];
+                    x.steps.push_back({phase, phase == 0 ? p.tokens : p.defines, &p.unit});
+                }
+            }
+        }
+        std::vector<gdt::Compiler> done;
+        std::vector<size_t> result(all.size(), SIZE_MAX);
+        for (const auto &kv : by_org) {
+            compile(gdt::Compiler(all[kv.second[0]].org, time), kv.second, 0, all, done, result, stats);
+        }
+        for (const gdt::Compiler &c : done) {
+            for (const gdt::CDiagnostic &d : c.warnings()) {
+                if (reported.insert({d.line, d.message}).second) {
+                    std::fprintf(stderr, "gdt_matrix: %s:%d: %s\n", opt.in.c_str(), d.line, d.message.c_str());
+                }
+            }
+        }
+
+        where = opt.out;
+        if (::mkdir(opt.out.c_str(), 0777) != 0 && errno != EEXIST) {
+            throw std::runtime_error(std::strerror(errno));
+        }
+        std::vector<size_t> bytes(all.size());
+        common::parallel_for(all.size(), opt.jobs, [&](size_t v) {
+            if (result[v] == SIZE_MAX) {
+                return;
+            }
+            const Variant &x = all[v];
+            gdt::ArchiveWriter w;
+            done[result[v]].write(w);
+            int64_t id = int64_t(common::mix64(common::hash_string(x.name + "/" + x.org.name)) >> 1);
+            std::string path = opt.out + "/" + x.name + ".gdt";
+            w.write(path, id, x.name);
+            bytes[v] = common::MappedFile(path).size();
+        });
+        int status = 0;
+        for (size_t v = 0; v < all.size(); v++) {
+            if (result[v] == SIZE_MAX) {
+                std::fprintf(stderr, "gdt_matrix: %s: %s\n", all[v].name.c_str(), all[v].error.c_str());
+                status = 1;
+                continue;
+            }
+            const gdt::Compiler &c = done[result[v]];
+            std::printf("%s/%s.gdt\t%zu\t%zu\t%zu\n", opt.out.c_str(), all[v].name.c_str(), c.types(), c.categories(),
+                        bytes[v]);
+        }
+        std::printf("# %zu archives, %zu sections: %zu expanded, %zu compiled, %zu with their defines\n", all.size(),
+                    planned, stats.expanded, stats.steps[0], stats.steps[1]);
+        return status;
+    } catch (const common::CppError &e) {
+        std::fprintf(stderr, "gdt_matrix: %s\n", e.what());  // file:line: message
+        return 1;
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "gdt_matrix: %s: %s\n", where.c_str(), e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,132 @@
+/*
+ *   gdt_merge: three-way merge of data type archives. The changes made from
+ *   base.gdt to theirs.gdt (an upstream refresh) are applied to ours.gdt (a
+ *   local fork with types of its own) and the result is written to
+ *   out.gdt, under the universal id of ours unless --id is given.
+ *
+ *   Types are paired across the three by universal id, path and name,
+ *   and compared by structural signature (gdt/gdt_merge.hpp): what only
+ *   one side changed is taken from it, and composites and enums both sides
+ *   changed are merged member by member, so members and values added on
+ *   either side all go in. What cannot be merged is a conflict, settled
+ *   for ours (--prefer theirs for theirs) and listed, one line each:
+ *
+ *     conflict  kind  path  what  key  ours  theirs
+ *
+ *   then one line for the archive:
+ *
+ *     out  types  categories  from-theirs  merged  removed  conflicts
+ *
+ *   The exit status is 0 for a clean merge, 1 when there were conflicts
+ *   (the archive is written all the same) and 2 on errors.
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/gdt/gdt_merge.cpp -o gdt_merge
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "common/parallel.hpp"
+#include "gdt/gdt_merge.hpp"
+#include "gdt/gdt_types.hpp"
+#include "gdt/gdt_write.hpp"
+
+
+namespace {
+
+struct Options {
+    gdt::Merge::Side prefer = gdt::Merge::OURS;
+    std::string name = "Untitled";
+    std::string id;
+    std::string in[3];  // base, ours, theirs
+    std::string out;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: gdt_merge [options] base.gdt ours.gdt theirs.gdt out.gdt\n"
+                 "  --prefer SIDE  settle conflicts for ours (default) or theirs\n"
+                 "  --name NAME    archive name stored in the container (default Untitled)\n"
+                 "  --id HEX       universal id of the output (default: that of ours)\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    int n = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--prefer") {
+            std::string s = next();
+            if (s != "ours" && s != "theirs") {
+                usage();
+            }
+            o.prefer = s == "ours" ? gdt::Merge::OURS : gdt::Merge::THEIRS;
+        } else if (a == "--name") {
+            o.name = next();
+        } else if (a == "--id") {
+            o.id = next();
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (n < 3) {
+            o.in[n++] = a;
+        } else if (o.out.empty()) {
+            o.out = a;
+        } else {
+            usage();
+        }
+    }
+    if (o.out.empty()) {
+        usage();
+    }
+    return o;
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::unique_ptr<gdt::Archive> in[3];
+    bool failed = false;
+    common::parallel_for(3, 3, [&](size_t i) {
+        try {
+            in[i].reset(new gdt::Archive(opt.in[i]));
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "gdt_merge: %s: %s\n", opt.in[i].c_str(), e.what());
+            failed = true;
+        }
+    });
+    if (failed) {
+        return 2;
+    }
+    try {
+        gdt::Merge merge(*in[0], *in[1], *in[2], opt.prefer);
+        for (const gdt::MergeConflict &c : merge.conflicts()) {
+            std::printf("conflict\t%s\t%s\t%s\t%s\t%s\t%s\n", c.kind.c_str(), c.path.c_str(), c.what.c_str(),
+                        c.key.c_str(), c.ours.c_str(), c.theirs.c_str());
+        }
+        int64_t id = in[1]->db().database_id();
+        if (!opt.id.empty()) {
+            id = static_cast<int64_t>(std::strtoull(opt.id.c_str(), nullptr, 16));
+        }
+        gdt::ArchiveWriter w;
+        merge.write(w);
+        w.write(opt.out, id, opt.name);
+        std::printf("%s\t%zu\t%zu\t%zu\t%zu\t%zu\t%zu\n", opt.out.c_str(), merge.types(), merge.categories(),
+                    merge.from_theirs(), merge.merged(), merge.removed(), merge.conflicts().size());
+        return merge.conflicts().empty() ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "gdt_merge: %s: %s\n", opt.out.c_str(), e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,609 @@
+/*
+ *   Three-way merge of data type archives: the changes from 'base' to
+ *   'theirs' applied to 'ours', written as a new archive.
+ *
+ *   The named types of the three are paired up as gdt_diff.hpp pairs two
+ *   archives (base with ours, base with theirs, and the types added on
+ *   both sides with each other). Every such type has a header (name and
+ *   category) and a body (what its structural signature covers, and its
+ *   comment), merged separately: a side that changed one from the base
+ *   wins over a side that did not, and two sides that made the same change
+ *   agree. Where both changed a composite or an enum differently, its
+ *   members or values are merged the same way by name (unnamed members by
+ *   offset), so additions and edits to different members both go in; a
+ *   structure whose merged members overlap, and any other type changed
+ *   differently on both sides, is a conflict. A type removed on one side
+ *   is removed unless the other changed it (a conflict) or a type the
+ *   merge keeps still refers to it (a conflict as well; it stays).
+ *
+ *   Conflicts take the version of the preferred side (ours by default) and
+ *   are listed; the merge still produces a complete archive.
+ *
+ *   The merged archive uses the ids of ours: types from theirs get new ids
+ *   and their references are translated, pointers and arrays looked up by
+ *   what they point to, and categories by path. Pointers and arrays no
+ *   merged type refers to are kept while the type they point to is (from
+ *   theirs, only those that are not in the base). A merged type whose path
+ *   another already has is renamed NAME.conflict, as Ghidra does.
+ *
+ *   Signatures are computed once per type and pairing is hashed, so a merge
+ *   is linear in the size of the three archives.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "gdt/gdt_diff.hpp"
+#include "gdt/gdt_hash.hpp"
+#include "gdt/gdt_types.hpp"
+#include "gdt/gdt_write.hpp"
+
+
+namespace gdt {
+
+// A change of ours and one of theirs that do not go together. 'what' is
+// "name", "category", "member", "value", "kind", "packing", "alignment",
+// "comment", "type" (the whole body), "removed" (changed on one side,
+// removed on the other) or "used" (removed, but still referred to by
+// 'key'); 'ours' and 'theirs' describe the two versions ("" if absent).
+struct MergeConflict {
+    std::string kind;
+    std::string path;
+    std::string what;
+    std::string key;
+    std::string ours;
+    std::string theirs;
+};
+
+class Merge {
+  public:
+    enum Side { BASE = 0, OURS = 1, THEIRS = 2 };
+
+    Merge(const Archive &base, const Archive &ours, const Archive &theirs, Side prefer = OURS)
+        : in_{&base, &ours, &theirs}, prefer_(prefer) {
+        pair_up();
+        for (Entity &e : entities_) {
+            decide(e);
+        }
+        build();
+    }
+
+    const std::vector<MergeConflict> &conflicts() const { return conflicts_; }
+    size_t types() const { return out_.size(); }
+    size_t categories() const { return categories_.size() + !categories_.count(0); }
+    size_t from_theirs() const { return from_theirs_; }  // types with a change of theirs taken whole
+    size_t merged() const { return merged_; }             // composites and enums merged member by member
+    size_t removed() const { return removed_; }           // types of ours that are not in the result
+
+    void write(ArchiveWriter &w) const {
+        for (const auto &kv : categories_) {
+            w.add(kv.second);
+        }
+        for (const DataType &t : out_) {
+            w.add(t);
+        }
+        for (const SourceArchive &s : sources_) {
+            w.add(s);
+        }
+    }
+
+  private:
+    struct Entity {
+        const DataType *v[3] = {nullptr, nullptr, nullptr};
+        uint64_t sig[3] = {0, 0, 0};
+        bool keep = false;
+        Side header = OURS;  // name and category from
+        Side body = OURS;    // everything else from; BASE: 'merged'
+        DataType merged;
+        std::vector<Side> sides;  // merged composites: where each member's type id is from
+        int64_t id = 0;           // in the result, once kept
+    };
+
+    // The body digest of 'side''s version: its signature and comment.
+    static uint64_t digest(const Archive &a, const DataType &t) {
+        return common::combine(signature(a, t), common::hash_string(t.comment));
+    }
+
+    std::string path(Side s, const DataType &t) const { return type_path(*in_[s], t); }
+
+    // Which side's value to take: the one that changed it from the base, or
+    // either when they agree; a conflict (-1) when both changed it apart.
+    static int three_way(bool ours_changed, bool theirs_changed, bool agree) {
+        if (agree || !theirs_changed) {
+            return OURS;
+        }
+        return ours_changed ? -1 : THEIRS;
+    }
+
+    void conflict(const Entity &e, const std::string &what, const std::string &key, const std::string &ours,
+                  const std::string &theirs) {
+        const DataType &t = *e.v[e.v[OURS] ? OURS : THEIRS];
+        Side s = e.v[OURS] ? OURS : THEIRS;
+        conflicts_.push_back({kind_name(t), path(s, t), what, key, ours, theirs});
+    }
+
+    static std::vector<const DataType *> named(const Archive &a) {
+        std::vector<const DataType *> out;
+        for (const DataType *t : a.types()) {
+            if (named_kind(t->table())) {
+                out.push_back(t);
+            }
+        }
+        return out;
+    }
+
+    void pair_up() {
+        std::vector<const DataType *> all[3] = {named(*in_[BASE]), named(*in_[OURS]), named(*in_[THEIRS])};
+        std::vector<TypeMatch> with[3];
+        for (int s = OURS; s <= THEIRS; s++) {
+            with[s] = match_types(*in_[BASE], all[BASE], *in_[s], all[s]);
+        }
+        std::vector<const DataType *> added[3];
+        for (size_t i = 0; i < all[BASE].size(); i++) {
+            Entity e;
+            e.v[BASE] = all[BASE][i];
+            e.v[OURS] = with[OURS][i].b;
+            e.v[THEIRS] = with[THEIRS][i].b;
+            entities_.push_back(std::move(e));
+        }
+        for (int s = OURS; s <= THEIRS; s++) {
+            for (size_t i = all[BASE].size(); i < with[s].size(); i++) {
+                added[s].push_back(with[s][i].b);
+            }
+        }
+        for (const TypeMatch &m : match_types(*in_[OURS], added[OURS], *in_[THEIRS], added[THEIRS])) {
+            Entity e;
+            e.v[OURS] = m.a;
+            e.v[THEIRS] = m.b;
+            entities_.push_back(std::move(e));
+        }
+        for (size_t i = 0; i < entities_.size(); i++) {
+            Entity &e = entities_[i];
+            for (int s = BASE; s <= THEIRS; s++) {
+                if (e.v[s]) {
+                    e.sig[s] = digest(*in_[s], *e.v[s]);
+                    entity_of_[s][e.v[s]->id] = i;
+                }
+            }
+        }
+    }
+
+    bool same_header(const Entity &e, Side x, Side y) const {
+        return e.v[x]->name == e.v[y]->name &&
+               in_[x]->category_path(e.v[x]->category) == in_[y]->category_path(e.v[y]->category);
+    }
+
+    void decide(Entity &e) {
+        const DataType *b = e.v[BASE], *o = e.v[OURS], *t = e.v[THEIRS];
+        if (!o && !t) {
+            return;
+        }
+        if (!o || !t) {
+            Side s = o ? OURS : THEIRS;
+            e.header = e.body = s;
+            e.keep = !b;
+            if (b && (e.sig[s] != e.sig[BASE] || !same_header(e, BASE, s))) {
+                conflict(e, "removed", "", o ? summary(*in_[OURS], *o) : "", t ? summary(*in_[THEIRS], *t) : "");
+                e.keep = prefer_ == s;
+            }
+            if (!e.keep && o) {
+                removed_++;
+            }
+            if (e.keep && s == THEIRS) {
+                from_theirs_++;
+            }
+            return;
+        }
+        e.keep = true;
+        int h = three_way(!b || !same_header(e, BASE, OURS), !b || !same_header(e, BASE, THEIRS),
+                          same_header(e, OURS, THEIRS));
+        if (h < 0) {
+            std::string po = path(OURS, *o), pt = path(THEIRS, *t);
+            conflict(e, o->name != t->name ? "name" : "category", "", po, pt);
+            h = prefer_;
+        }
+        e.header = Side(h);
+        int d = three_way(!b || e.sig[OURS] != e.sig[BASE], !b || e.sig[THEIRS] != e.sig[BASE],
+                          e.sig[OURS] == e.sig[THEIRS]);
+        if (d < 0) {
+            d = merge_members(e) ? BASE : prefer_;
+        }
+        e.body = Side(d);
+        if (e.body == BASE) {
+            merged_++;
+        } else if (e.header == THEIRS || e.body == THEIRS) {
+            from_theirs_++;
+        }
+    }
+
+    // Composites and enums changed on both sides, member by member. False
+    // when the whole type conflicts.
+    bool merge_members(Entity &e) {
+        const DataType *b = e.v[BASE], *o = e.v[OURS], *t = e.v[THEIRS];
+        const Archive &ab = *in_[BASE], &ao = *in_[OURS], &at = *in_[THEIRS];
+        if (o->table() != T_COMPOSITE && o->table() != T_ENUM) {
+            conflict(e, "type", "", summary(ao, *o), summary(at, *t));
+            return false;
+        }
+        DataType m = *o;
+        auto scalar = [&](const char *what, const std::string &vb, const std::string &vo, const std::string &vt) {
+            int s = three_way(!b || vo != vb, !b || vt != vb, vo == vt);
+            if (s < 0) {
+                conflict(e, what, "", vo, vt);
+            }
+            return (s < 0 ? int(prefer_) : s) == THEIRS ? t : o;
+        };
+        // Sizes both changed grow to the larger.
+        auto length = [&]() {
+            int s = three_way(!b || o->length != b->length, !b || t->length != b->length, o->length == t->length);
+            return s < 0 ? std::max(o->length, t->length) : s == THEIRS ? t->length : o->length;
+        };
+        m.comment = scalar("comment", b ? b->comment : "", o->comment, t->comment)->comment;
+        if (o->table() == T_ENUM) {
+            std::unordered_map<std::string, int64_t> vb, vt;
+            if (b) {
+                for (const EnumValue &v : b->values) {
+                    vb.emplace(v.name, v.value);
+                }
+            }
+            for (const EnumValue &v : t->values) {
+                vt.emplace(v.name, v.value);
+            }
+            std::unordered_set<std::string> in_ours;
+            m.values.clear();
+            auto merge = [&](const std::string &name, const int64_t *x, const int64_t *y) {
+                auto ib = vb.find(name);
+                const int64_t *z = ib == vb.end() ? nullptr : &ib->second;
+                auto eq = [](const int64_t *p, const int64_t *q) { return p == q || (p && q && *p == *q); };
+                int s = three_way(!eq(z, x), !eq(z, y), eq(x, y));
+                if (s < 0) {
+                    conflict(e, "value", name, x ? std::to_string(*x) : "", y ? std::to_string(*y) : "");
+                    s = prefer_;
+                }
+                if (const int64_t *v = s == THEIRS ? y : x) {
+                    m.values.push_back({0, name, *v});
+                }
+            };
+            for (const EnumValue &v : o->values) {
+                in_ours.insert(v.name);
+                auto it = vt.find(v.name);
+                merge(v.name, &v.value, it == vt.end() ? nullptr : &it->second);
+            }
+            for (const EnumValue &v : t->values) {
+                if (!in_ours.count(v.name)) {
+                    merge(v.name, nullptr, &v.value);
+                }
+            }
+            m.length = length();
+            e.merged = std::move(m);
+            return true;
+        }
+
+        m.is_union = scalar("kind", b ? kind_name(*b) : "", kind_name(*o), kind_name(*t))->is_union;
+        m.packing = scalar("packing", b ? std::to_string(b->packing) : "", std::to_string(o->packing),
+                           std::to_string(t->packing))->packing;
+        m.alignment = scalar("alignment", b ? std::to_string(b->alignment) : "", std::to_string(o->alignment),
+                             std::to_string(t->alignment))->alignment;
+        using Keyed = std::unordered_map<std::string, const Component *>;
+        Keyed kb, kt;
+        if (b) {
+            for (const auto &k : diff_detail::keyed(*b)) {
+                kb.emplace(k.first, k.second);
+            }
+        }
+        std::vector<std::pair<std::string, const Component *>> ko = diff_detail::keyed(*o), lt = diff_detail::keyed(*t);
+        for (const auto &k : lt) {
+            kt.emplace(k.first, k.second);
+        }
+        auto eq = [](const Archive &x, const Component *p, const Archive &y, const Component *q) {
+            if (!p || !q) {
+                return p == q;
+            }
+            return p->name == q->name && p->offset == q->offset && p->size == q->size &&
+                   x.type_name(p->type) == y.type_name(q->type);
+        };
+        std::vector<std::pair<Component, Side>> members;
+        std::vector<std::string> keys;
+        auto merge = [&](const std::string &key, const Component *x, const Component *y) {
+            auto ib = kb.find(key);
+            const Component *z = ib == kb.end() ? nullptr : ib->second;
+            int s = three_way(!eq(ab, z, ao, x), !eq(ab, z, at, y), eq(ao, x, at, y));
+            if (s < 0) {
+                conflict(e, "member", key, x ? diff_detail::describe(ao, *x) : "",
+                         y ? diff_detail::describe(at, *y) : "");
+                s = prefer_;
+            }
+            if (const Component *c = s == THEIRS ? y : x) {
+                members.emplace_back(*c, Side(s));
+                keys.push_back(key);
+            }
+        };
+        std::unordered_set<std::string> in_ours;
+        for (const auto &k : ko) {
+            in_ours.insert(k.first);
+            auto it = kt.find(k.first);
+            merge(k.first, k.second, it == kt.end() ? nullptr : it->second);
+        }
+        for (const auto &k : lt) {
+            if (!in_ours.count(k.first)) {
+                merge(k.first, nullptr, k.second);
+            }
+        }
+
+        std::vector<size_t> order(members.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        if (!m.is_union) {
+            std::stable_sort(order.begin(), order.end(), [&](size_t x, size_t y) {
+                return members[x].first.offset < members[y].first.offset;
+            });
+        }
+        m.components.clear();
+        e.sides.clear();
+        int64_t end = 0, covered = 0, extent = 0;
+        const std::string *last = nullptr;
+        for (size_t i : order) {
+            Component c = members[i].first;
+            bool bits = table_of(c.type) == T_BITFIELD;
+            if (!m.is_union && !bits && c.offset < end) {
+                bool ours = members[i].second == OURS;
+                std::string d = diff_detail::describe(ours ? ao : at, c), x = "overlaps " + *last;
+                conflict(e, "member", keys[i], ours ? d : x, ours ? x : d);
+                return false;
+            }
+            if (!m.is_union && c.offset >= end) {
+                covered += c.offset - end;
+            }
+            if (!m.is_union && c.offset + c.size > end) {
+                end = c.offset + c.size;
+                last = &keys[i];
+            }
+            extent = std::max<int64_t>(extent, c.offset + c.size);
+            c.ordinal = int32_t(m.components.size());
+            m.components.push_back(c);
+            e.sides.push_back(members[i].second);
+        }
+        m.length = std::max<int32_t>(length(), int32_t(extent));
+        m.num_components = int32_t(m.components.size()) +
+                           (m.is_union ? 0 : int32_t(covered + std::max<int64_t>(0, m.length - end)));
+        e.merged = std::move(m);
+        return true;
+    }
+
+    // The id in the result of 'side''s type 'id', keeping what it refers to.
+    int64_t remap(Side s, int64_t id, size_t user) {
+        if (id == DEFAULT_ID || id == NULL_ID) {
+            return id;
+        }
+        if (table_of(id) == T_BITFIELD) {
+            int64_t base = remap(s, BitField(id).base, user);
+            return make_id(T_BITFIELD, key_of(base) << 24 | (key_of(id) & 0xffffff));
+        }
+        const DataType *t = in_[s]->get(id);
+        if (!t) {
+            return DEFAULT_ID;
+        }
+        if (named_kind(t->table())) {
+            return use(entity_of_[s].at(id), s, user);
+        }
+        int64_t target = remap(s, t->target, user);
+        // Ours' keep their ids, theirs' are looked up by what they are.
+        AnonKey key(t->table(), target, t->length, t->count, category(s, t->category));
+        int64_t out = s == OURS ? id : anonymous_.emplace(key, make_id(t->table(), next_[t->table()])).first->second;
+        if (out == make_id(t->table(), next_[t->table()])) {
+            next_[t->table()]++;
+        }
+        if (emitted_.insert(out).second) {
+            DataType d = *t;
+            d.id = out;
+            d.target = target;
+            d.category = std::get<4>(key);
+            out_.push_back(std::move(d));
+        }
+        return out;
+    }
+
+    // Entity 'i', referred to from 'side' by entity 'user'.
+    int64_t use(size_t i, Side s, size_t user) {
+        Entity &e = entities_[i];
+        if (!e.keep) {
+            const Entity &u = entities_[user];  // never an unreferenced pointer: those need a kept target
+            conflict(e, "used", path(u.header, *u.v[u.header]), e.v[OURS] ? summary(*in_[OURS], *e.v[OURS]) : "",
+                     e.v[THEIRS] ? summary(*in_[THEIRS], *e.v[THEIRS]) : "");
+            e.keep = true;
+            e.header = e.body = s;
+            if (e.v[OURS]) {
+                removed_--;
+            }
+            queue_.push_back(i);
+        }
+        if (!e.id) {
+            e.id = e.v[OURS] ? e.v[OURS]->id : make_id(e.v[THEIRS]->table(), next_[e.v[THEIRS]->table()]++);
+        }
+        return e.id;
+    }
+
+    // The category of the result at the path of 'side''s category 'id'.
+    int64_t category(Side s, int64_t id) {
+        if (s == OURS || id == 0) {
+            return id;
+        }
+        auto it = category_of_.find(id);
+        if (it != category_of_.end()) {
+            return it->second;
+        }
+        int64_t out = 0;
+        auto c = in_[s]->categories().find(id);
+        if (c != in_[s]->categories().end() && c->second.parent >= 0) {
+            std::string p = in_[s]->category_path(id);
+            auto known = by_path_.find(p);
+            if (known != by_path_.end()) {
+                out = known->second;
+            } else {
+                int64_t parent = category(s, c->second.parent);
+                out = ++last_category_;
+                categories_[out] = Category{out, c->second.name, parent};
+                by_path_[p] = out;
+            }
+        }
+        category_of_[id] = out;
+        return out;
+    }
+
+    // The type of entity 'i' in the result.
+    void emit(size_t i) {
+        Entity &e = entities_[i];
+        use(i, e.header, i);
+        const DataType &from = e.body == BASE ? e.merged : *e.v[e.body];
+        Side refs = e.body == BASE ? OURS : e.body;
+        DataType d = from;
+        d.id = e.id;
+        d.name = e.v[e.header]->name;
+        d.category = e.header == OURS ? e.v[OURS]->category : category(THEIRS, e.v[THEIRS]->category);
+        if (e.v[OURS]) {
+            d.universal_id = e.v[OURS]->universal_id;
+        }
+        for (size_t k = 0; k < d.components.size(); k++) {
+            d.components[k].type = remap(e.body == BASE ? e.sides[k] : refs, d.components[k].type, i);
+        }
+        for (Parameter &p : d.params) {
+            p.type = remap(refs, p.type, i);
+        }
+        if (d.table() == T_TYPEDEF) {
+            d.target = remap(refs, d.target, i);
+        }
+        if (d.table() == T_FUNCDEF) {
+            d.return_type = remap(refs, d.return_type, i);
+        }
+        slot_[i] = out_.size();
+        out_.push_back(std::move(d));
+    }
+
+    // Whether 'side''s pointer or array 't' ends at a type the result has.
+    bool live(Side s, const DataType *t) const {
+        for (int depth = 0; t && depth < 64; depth++) {
+            if (named_kind(t->table())) {
+                return entities_[entity_of_[s].at(t->id)].keep;
+            }
+            if (t->target == NULL_ID || table_of(t->target) == T_BITFIELD) {
+                return true;
+            }
+            t = in_[s]->get(t->target);
+        }
+        return false;
+    }
+
+    void build() {
+        const Archive &ours = *in_[OURS];
+        for (const auto &kv : ours.categories()) {
+            categories_[kv.first] = kv.second;
+            by_path_[ours.category_path(kv.first)] = kv.first;
+            last_category_ = std::max(last_category_, kv.first);
+        }
+        std::fill(next_, next_ + 256, 1);  // key 0 of the built-ins is "undefined"
+        for (const DataType *t : ours.types()) {
+            next_[t->table()] = std::max(next_[t->table()], key_of(t->id) + 1);
+            if (!named_kind(t->table())) {
+                anonymous_.emplace(AnonKey(t->table(), t->target, t->length, t->count, t->category), t->id);
+            }
+        }
+        slot_.assign(entities_.size(), SIZE_MAX);
+        for (size_t i = 0; i < entities_.size(); i++) {
+            if (entities_[i].keep) {
+                queue_.push_back(i);
+            }
+        }
+        for (size_t q = 0; q < queue_.size(); q++) {
+            if (slot_[queue_[q]] == SIZE_MAX) {
+                emit(queue_[q]);
+            }
+        }
+
+        // Pointers and arrays nothing refers to.
+        std::unordered_set<std::string> in_base;
+        for (const DataType *t : in_[BASE]->types()) {
+            if (!named_kind(t->table())) {
+                in_base.insert(in_[BASE]->type_name(t->id));
+            }
+        }
+        for (int s = OURS; s <= THEIRS; s++) {
+            for (const DataType *t : in_[s]->types()) {
+                if (!named_kind(t->table()) && live(Side(s), t) &&
+                    (s == OURS || !in_base.count(in_[s]->type_name(t->id)))) {
+                    remap(Side(s), t->id, SIZE_MAX);
+                }
+            }
+        }
+
+        // Paths taken twice.
+        std::unordered_set<std::string> paths;
+        for (size_t i = 0; i < entities_.size(); i++) {
+            if (slot_[i] == SIZE_MAX) {
+                continue;
+            }
+            DataType &d = out_[slot_[i]];
+            std::string dir = category_path(d.category), name = d.name;
+            for (int n = 0; !paths.insert(dir + "/" + name).second; n++) {
+                name = d.name + ".conflict" + (n ? std::to_string(n) : "");
+            }
+            if (name != d.name) {
+                conflict(entities_[i], "name", "", "", name);
+                d.name = name;
+            }
+        }
+
+        sources_ = ours.source_archives();
+        for (const SourceArchive &s : in_[THEIRS]->source_archives()) {
+            if (std::none_of(sources_.begin(), sources_.end(), [&](const SourceArchive &x) { return x.id == s.id; })) {
+                sources_.push_back(s);
+            }
+        }
+    }
+
+    std::string category_path(int64_t id) const {
+        std::string p;
+        for (int depth = 0; depth < 64; depth++) {
+            auto it = categories_.find(id);
+            if (it == categories_.end() || it->second.parent < 0) {
+                break;
+            }
+            p = "/" + it->second.name + p;
+            id = it->second.parent;
+        }
+        return p;
+    }
+
+    const Archive *in_[3];
+    Side prefer_;
+    std::vector<Entity> entities_;
+    std::unordered_map<int64_t, size_t> entity_of_[3];
+    std::vector<MergeConflict> conflicts_;
+    size_t from_theirs_ = 0;
+    size_t merged_ = 0;
+    size_t removed_ = 0;
+
+    std::vector<DataType> out_;
+    std::vector<size_t> slot_;   // entity -> index in out_
+    std::vector<size_t> queue_;  // entities to emit
+    std::map<int64_t, Category> categories_;
+    std::unordered_map<std::string, int64_t> by_path_;
+    std::unordered_map<int64_t, int64_t> category_of_;  // theirs -> result
+    int64_t last_category_ = 0;
+    using AnonKey = std::tuple<uint8_t, int64_t, int32_t, int32_t, int64_t>;  // table, target, length, count, category
+    std::map<AnonKey, int64_t> anonymous_;
+    std::unordered_set<int64_t> emitted_;
+    int64_t next_[256];
+    std::vector<SourceArchive> sources_;
+};
+
+}  // namespace gdt
@@ -0,0 +1,500 @@
+/*
+ *   gdt_probe: check struct layouts against real compilers. Every struct
+ *   and union a C header declares (header/lua_all.h) and every composite
+ *   of the given archives the header also declares (gdt/lua.gdt) is probed
+ *   for its size and member offsets (gdt/gdt_probe.hpp) with each compiler
+ *   of a list of ABIs, and what the compilers say is compared with
+ *
+ *     - the header compiled into types by the tools (gdt_cc's parts,
+ *       preprocessing, parsing and layout), for the ABI's data organization
+ *     - the offsets and lengths stored in each archive, for the ABIs of the
+ *       archive's data organization (guessed among those of the ABIs, as
+ *       gdt_header does)
+ *
+ *   An ABI is a data organization and a compiler command writing ELF
+ *   objects, --abi i386='cc -m32' or --abi ilp32=arm-linux-gnueabi-gcc.
+ *   By default the ones of
+ *
+ *     lp64   cc -m64, aarch64-linux-gnu-gcc
+ *     i386   cc -m32
+ *     ilp32  cc -mx32, arm-linux-gnueabi-gcc, mips-linux-gnu-gcc, powerpc-linux-gnu-gcc
+ *
+ *   that are installed. The header is compiled as the tools read it:
+ *   #include is not followed (gdt_cc does not), so the files it includes
+ *   are empty stand-ins under -nostdinc, but for <limits.h> from the
+ *   compiler's own macros. Parts of the header (gdt_cc's banners) that do
+ *   not compile for an ABI are left out for it and reported, as are probes
+ *   that do not compile. -D/-U go to the tools and the compilers alike:
+ *
+ *     gdt_probe -DLUA_USE_LINUX -DLUA_USE_C89 header/lua_all.h gdt/lua.gdt
+ *
+ *   The parts are checked, compiled and probed for all ABIs at once, the
+ *   probes in -j N files at a time. A line for each value that differs,
+ *
+ *     abi  source  type.member  archive  compiler
+ *
+ *   (".sizeof" for the size) and one per ABI and source on stderr with the
+ *   counts; the exit status is 1 when something differs. --keep DIR keeps
+ *   the probe files and objects in DIR.
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/gdt/gdt_probe.cpp -o gdt_probe
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/c_preprocessor.hpp"
+#include "common/mapped_file.hpp"
+#include "common/parallel.hpp"
+#include "gdt/gdt_compile.hpp"
+#include "gdt/gdt_cparse.hpp"
+#include "gdt/gdt_header.hpp"
+#include "gdt/gdt_probe.hpp"
+#include "gdt/gdt_types.hpp"
+#include "gdt/gdt_write.hpp"
+
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct Abi {
+    std::string org;
+    std::string command;
+};
+
+struct Options {
+    std::vector<std::pair<char, std::string>> macros;  // 'D' NAME[=VALUE] or 'U' NAME, in order
+    std::vector<std::string> skip;
+    std::vector<Abi> abis;
+    std::string keep;
+    unsigned jobs = common::default_jobs();
+    std::string header;
+    std::vector<std::string> archives;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: gdt_probe [options] header.h [archive.gdt...]\n"
+                 "  -D NAME[=VALUE]   define a macro (also -DNAME)\n"
+                 "  -U NAME           undefine a macro\n"
+                 "  --skip PART       leave out a part of the header (as named by its banner)\n"
+                 "  --abi ORG=CMD     probe with compiler command CMD for data organization ORG\n"
+                 "                    (lp64, llp64, ilp32, i386); default: the installed ones of a list\n"
+                 "  --keep DIR        write the probe files to DIR and keep them\n"
+                 "  -j N              compilers run in parallel\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if ((a.rfind("-D", 0) == 0 || a.rfind("-U", 0) == 0) && a.size() >= 2) {
+            o.macros.emplace_back(a[1], a.size() > 2 ? a.substr(2) : std::string(next()));
+        } else if (a == "--skip") {
+            o.skip.push_back(next());
+        } else if (a == "--abi") {
+            std::string s = next();
+            size_t eq = s.find('=');
+            if (eq == std::string::npos || eq == 0 || eq + 1 == s.size()) {
+                usage();
+            }
+            o.abis.push_back({s.substr(0, eq), s.substr(eq + 1)});
+        } else if (a == "--keep") {
+            o.keep = next();
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (o.header.empty()) {
+            o.header = a;
+        } else {
+            o.archives.push_back(a);
+        }
+    }
+    if (o.header.empty()) {
+        usage();
+    }
+    return o;
+}
+
+std::string basename(const std::string &path) { return path.substr(path.find_last_of('/') + 1); }
+
+std::string quote(const std::string &s) {
+    std::string q = "'";
+    for (char c : s) {
+        q += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+    return q + "'";
+}
+
+std::string read_text(const std::string &path) {
+    std::string s;
+    if (std::FILE *f = std::fopen(path.c_str(), "rb")) {
+        char buf[65536];
+        for (size_t n; (n = std::fread(buf, 1, sizeof buf, f)) > 0;) {
+            s.append(buf, n);
+        }
+        std::fclose(f);
+    }
+    return s;
+}
+
+void write_text(const std::string &path, const std::string &s) {
+    std::FILE *f = std::fopen(path.c_str(), "wb");
+    if (!f || std::fwrite(s.data(), 1, s.size(), f) != s.size() || std::fclose(f) != 0) {
+        throw std::runtime_error(path + ": cannot write");
+    }
+}
+
+// Where a compiler runs: the stand-in includes and macros of every run.
+struct Toolchain {
+    std::string include;
+    std::string macros;
+
+    // Runs the command on 'args' with its errors going to 'log'; true when
+    // it succeeds.
+    bool run(const Abi &abi, const std::string &args, const std::string &log) const {
+        std::string cmd = abi.command + " -nostdinc -I" + quote(include) + macros + " " + args + " 2>" + quote(log);
+        return std::system(cmd.c_str()) == 0;
+    }
+};
+
+// The probing of one ABI: the parts of the header it compiles, the
+// header as the tools compile them, and the probes of its sources.
+struct Run {
+    Abi abi;
+    std::string dir;
+    std::vector<size_t> parts;  // indices of the parts kept
+    std::vector<std::string> notes;
+    std::unique_ptr<gdt::Archive> compiled;
+    std::vector<const gdt::Archive *> sources;
+    std::vector<std::string> source_names;
+    gdt::ProbeSet probes;
+    std::vector<std::vector<gdt::Expected>> expected;  // by source
+    std::vector<size_t> types;                         // by source
+    std::vector<uint64_t> values;                      // by probe
+    std::vector<char> have;                            // by probe, set by the shards at once
+    std::vector<std::string> errors;                   // by probe, why the compiler rejected it
+};
+
+// Leaves out the parts of the header the ABI's compiler rejects, one at a
+// time, the part of the first error first; writes what is kept to
+// dir/header.h with #line markers so errors still name the header's lines.
+void keep_parts(Run &r, const Toolchain &tc, const std::string &path, const std::string &text,
+                const std::vector<gdt::HeaderPart> &parts) {
+    for (;;) {
+        std::string kept;
+        for (size_t k : r.parts) {
+            kept += "#line " + std::to_string(parts[k].line) + " \"" + path + "\"\n";
+            kept.append(text, parts[k].begin, parts[k].end - parts[k].begin);
+            kept += "\n";
+        }
+        write_text(r.dir + "/header.h", kept);
+        std::string log = r.dir + "/header.log";
+        if (tc.run(r.abi, "-fsyntax-only -x c " + quote(r.dir + "/header.h"), log)) {
+            return;
+        }
+        std::vector<gdt::CompilerError> errors = gdt::compiler_errors(read_text(log));
+        auto in_header = std::find_if(errors.begin(), errors.end(),
+                                      [&](const gdt::CompilerError &e) { return e.file == path; });
+        if (in_header == errors.end()) {
+            std::string first = read_text(log);
+            throw std::runtime_error(r.abi.command + ": " + first.substr(0, first.find('\n')));
+        }
+        size_t drop = r.parts.size();
+        for (size_t i = 0; i < r.parts.size(); i++) {
+            if (parts[r.parts[i]].line <= in_header->line) {
+                drop = i;
+            }
+        }
+        if (drop == r.parts.size()) {
+            throw std::runtime_error(r.abi.command + ": " + path + ":" + std::to_string(in_header->line) + ": " +
+                                     in_header->message);
+        }
+        r.notes.push_back(parts[r.parts[drop]].name + " left out: " + in_header->message);
+        r.parts.erase(r.parts.begin() + drop);
+    }
+}
+
+// The kept parts compiled into an archive for the ABI's data organization,
+// as gdt_cc compiles them.
+void compile_parts(Run &r, const Options &opt, const std::string &text, const std::vector<gdt::HeaderPart> &parts) {
+    gdt::DataOrganization org = gdt::DataOrganization::named(r.abi.org);
+    common::Preprocessor pp(opt.header);
+    gdt::predefine(pp, org);
+    for (const auto &m : opt.macros) {
+        size_t eq = m.second.find('=');
+        if (m.first == 'U') {
+            pp.undef(m.second);
+        } else {
+            pp.define(m.second.substr(0, eq), eq == std::string::npos ? "1" : m.second.substr(eq + 1));
+        }
+    }
+    gdt::Compiler compiler(org, 0);
+    std::vector<gdt::CUnit> units(r.parts.size());
+    for (size_t i = 0; i < r.parts.size(); i++) {
+        const gdt::HeaderPart &part = parts[r.parts[i]];
+        std::vector<common::CToken> tokens;
+        units[i].name = part.name;
+        pp.run(common::c_lines(text.data() + part.begin, part.end - part.begin, part.line), &tokens,
+               &units[i].defines);
+        gdt::CParser(tokens, units[i]).parse();
+        compiler.add(units[i]);
+    }
+    pp.finish();
+    gdt::ArchiveWriter w;
+    compiler.write(w);
+    w.write(r.dir + "/header.gdt", 1, basename(opt.header));
+    r.compiled = std::make_unique<gdt::Archive>(r.dir + "/header.gdt");
+}
+
+// Compiles the probes of a shard, leaving out those the compiler rejects,
+// and reads back their values.
+void probe_shard(Run &r, const Toolchain &tc, size_t shard, std::vector<size_t> probes) {
+    std::string base = r.dir + "/probe" + std::to_string(shard);
+    while (!probes.empty()) {
+        write_text(base + ".c", r.probes.source("header.h", probes));
+        if (tc.run(r.abi, "-c -x c " + quote(base + ".c") + " -o " + quote(base + ".o"), base + ".log")) {
+            std::vector<uint64_t> values = gdt::probe_values(base + ".o");
+            if (values.size() != probes.size()) {
+                throw std::runtime_error(base + ".o: " + std::to_string(values.size()) + " values for " +
+                                         std::to_string(probes.size()) + " probes");
+            }
+            for (size_t i = 0; i < probes.size(); i++) {
+                r.values[probes[i]] = values[i];
+                r.have[probes[i]] = true;
+            }
+            return;
+        }
+        std::vector<bool> bad(probes.size());
+        bool any = false;
+        for (const gdt::CompilerError &e : gdt::compiler_errors(read_text(base + ".log"))) {
+            size_t i = size_t(e.line - gdt::ProbeSet::FIRST_LINE);
+            if (e.file == base + ".c" && e.line >= gdt::ProbeSet::FIRST_LINE && i < probes.size() && !bad[i]) {
+                r.errors[probes[i]] = e.message;
+                bad[i] = true;
+                any = true;
+            }
+        }
+        if (!any) {
+            std::string log = read_text(base + ".log");
+            throw std::runtime_error(r.abi.command + ": " + log.substr(0, log.find('\n')));
+        }
+        std::vector<size_t> rest;
+        for (size_t i = 0; i < probes.size(); i++) {
+            if (!bad[i]) {
+                rest.push_back(probes[i]);
+            }
+        }
+        probes.swap(rest);
+    }
+}
+
+const Abi DEFAULT_ABIS[] = {
+    {"lp64", "cc -m64"},
+    {"i386", "cc -m32"},
+    {"ilp32", "cc -mx32"},
+    {"ilp32", "arm-linux-gnueabi-gcc"},
+    {"lp64", "aarch64-linux-gnu-gcc"},
+    {"ilp32", "mips-linux-gnu-gcc"},
+    {"ilp32", "powerpc-linux-gnu-gcc"},
+};
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::string where = opt.header;
+    std::string dir;
+    int status = 0;
+    try {
+        if (opt.keep.empty()) {
+            std::string t = (fs::temp_directory_path() / "gdt_probe.XXXXXX").string();
+            if (!::mkdtemp(&t[0])) {
+                throw std::runtime_error(t + ": cannot create");
+            }
+            dir = t;
+        } else {
+            fs::create_directories(opt.keep);
+            dir = opt.keep;
+        }
+
+        common::MappedFile file(opt.header);
+        std::string text(reinterpret_cast<const char *>(file.data()), file.size());
+        std::vector<gdt::HeaderPart> parts = gdt::header_parts(text.data(), text.size(), basename(opt.header));
+        std::vector<size_t> kept;
+        for (size_t k = 0; k < parts.size(); k++) {
+            if (std::find(opt.skip.begin(), opt.skip.end(), parts[k].name) == opt.skip.end()) {
+                kept.push_back(k);
+            }
+        }
+
+        // Empty stand-ins for every file the header includes.
+        Toolchain tc;
+        tc.include = dir + "/include";
+        fs::create_directories(tc.include);
+        for (size_t b = 0; b < text.size();) {
+            size_t e = std::min(text.find('\n', b), text.size());
+            std::string line = text.substr(b, e - b);
+            b = e + 1;
+            size_t hash = line.find_first_not_of(" \t");
+            if (hash == std::string::npos || line[hash] != '#') {
+                continue;
+            }
+            size_t kw = line.find_first_not_of(" \t", hash + 1);
+            size_t open = line.find_first_of("<\"", kw);
+            if (kw == std::string::npos || line.compare(kw, 7, "include") != 0 || open == std::string::npos) {
+                continue;
+            }
+            size_t close = line.find(line[open] == '<' ? '>' : '"', open + 1);
+            std::string name = close == std::string::npos ? "" : line.substr(open + 1, close - open - 1);
+            if (name.empty() || name.find("..") != std::string::npos || name[0] == '/') {
+                continue;
+            }
+            fs::path p = fs::path(tc.include) / name;
+            fs::create_directories(p.parent_path());
+            write_text(p.string(), name == "limits.h" ? gdt::limits_stand_in() : "");
+        }
+        for (const auto &m : opt.macros) {
+            tc.macros += " " + quote(std::string("-") + m.first + m.second);
+        }
+
+        // The ABIs there are compilers for.
+        bool chosen = !opt.abis.empty();
+        std::vector<Abi> candidates = chosen ? opt.abis : std::vector<Abi>(std::begin(DEFAULT_ABIS),
+                                                                             std::end(DEFAULT_ABIS));
+        for (const Abi &abi : candidates) {
+            gdt::DataOrganization::named(abi.org);
+        }
+        std::vector<bool> works(candidates.size());
+        write_text(dir + "/empty.c", "int gdt_probe;\n");
+        common::parallel_for(candidates.size(), opt.jobs, [&](size_t i) {
+            std::string base = dir + "/empty" + std::to_string(i);
+            works[i] = tc.run(candidates[i], "-c -x c " + quote(dir + "/empty.c") + " -o " + quote(base + ".o"),
+                              base + ".log");
+        });
+        std::vector<Run> runs;
+        for (size_t i = 0; i < candidates.size(); i++) {
+            if (works[i]) {
+                runs.emplace_back();
+                runs.back().abi = candidates[i];
+                runs.back().dir = dir + "/" + std::to_string(i);
+                runs.back().parts = kept;
+                fs::create_directories(runs.back().dir);
+            } else if (chosen) {
+                std::fprintf(stderr, "gdt_probe: %s: does not compile\n", candidates[i].command.c_str());
+            }
+        }
+        if (runs.empty()) {
+            throw std::runtime_error("no compiler for any ABI");
+        }
+
+        common::parallel_for(runs.size(), opt.jobs, [&](size_t i) {
+            keep_parts(runs[i], tc, opt.header, text, parts);
+            compile_parts(runs[i], opt, text, parts);
+        });
+
+        // Each archive is checked by the ABIs of its data organization.
+        std::vector<std::string> orgs;
+        for (const Run &r : runs) {
+            if (std::find(orgs.begin(), orgs.end(), r.abi.org) == orgs.end()) {
+                orgs.push_back(r.abi.org);
+            }
+        }
+        std::vector<std::unique_ptr<gdt::Archive>> archives;
+        std::vector<std::string> archive_orgs;
+        for (const std::string &path : opt.archives) {
+            where = path;
+            archives.push_back(std::make_unique<gdt::Archive>(path));
+            archive_orgs.push_back(gdt::guess_organization(*archives.back(), orgs).name);
+        }
+        where = opt.header;
+
+        std::vector<std::pair<size_t, std::vector<size_t>>> shards;  // run, probes
+        size_t per_run = std::max<size_t>(1, opt.jobs / runs.size());
+        for (size_t i = 0; i < runs.size(); i++) {
+            Run &r = runs[i];
+            gdt::CNames names(read_text(r.dir + "/header.h"));
+            r.sources.push_back(r.compiled.get());
+            r.source_names.push_back(opt.header);
+            for (size_t k = 0; k < archives.size(); k++) {
+                if (archive_orgs[k] == r.abi.org) {
+                    r.sources.push_back(archives[k].get());
+                    r.source_names.push_back(opt.archives[k]);
+                }
+            }
+            for (const gdt::Archive *a : r.sources) {
+                r.expected.emplace_back();
+                r.types.push_back(gdt::layout_probes(*a, names, r.probes, r.expected.back()));
+            }
+            size_t n = r.probes.exprs().size();
+            r.values.assign(n, 0);
+            r.have.assign(n, false);
+            r.errors.assign(n, std::string());
+            size_t count = std::min(per_run, n);
+            for (size_t s = 0; s < count; s++) {
+                shards.emplace_back(i, std::vector<size_t>());
+                for (size_t p = n * s / count; p < n * (s + 1) / count; p++) {
+                    shards.back().second.push_back(p);
+                }
+            }
+        }
+        common::parallel_for(shards.size(), opt.jobs, [&](size_t s) {
+            probe_shard(runs[shards[s].first], tc, s, shards[s].second);
+        });
+
+        for (const Run &r : runs) {
+            for (const std::string &note : r.notes) {
+                std::fprintf(stderr, "gdt_probe: %s: %s\n", r.abi.command.c_str(), note.c_str());
+            }
+            for (size_t k = 0; k < r.sources.size(); k++) {
+                size_t differ = 0, rejected = 0;
+                for (const gdt::Expected &e : r.expected[k]) {
+                    const gdt::DataType *t = r.sources[k]->get(e.type);
+                    std::string what = t->name + "." + (e.component < 0 ? "sizeof" : t->components[e.component].name);
+                    if (!r.have[e.probe]) {
+                        std::fprintf(stderr, "gdt_probe: %s: %s: %s: %s\n", r.abi.command.c_str(),
+                                     r.source_names[k].c_str(), what.c_str(), r.errors[e.probe].c_str());
+                        rejected++;
+                        continue;
+                    }
+                    if (r.values[e.probe] == e.value) {
+                        continue;
+                    }
+                    std::printf("%s\t%s\t%s\t%llu\t%llu\n", r.abi.command.c_str(), r.source_names[k].c_str(),
+                                what.c_str(), (unsigned long long)e.value, (unsigned long long)r.values[e.probe]);
+                    differ++;
+                }
+                std::fprintf(stderr, "gdt_probe: %s (%s): %s: %zu types, %zu probes, %zu differ, %zu not compiled\n",
+                             r.abi.command.c_str(), r.abi.org.c_str(), r.source_names[k].c_str(), r.types[k],
+                             r.expected[k].size(), differ, rejected);
+                status = differ ? 1 : status;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "gdt_probe: %s: %s\n", where.c_str(), e.what());
+        status = 1;
+    }
+    if (opt.keep.empty() && !dir.empty()) {
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+    }
+    return status;
+}
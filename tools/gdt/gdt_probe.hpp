@@ -0,0 +1,280 @@
+/*
+ *   Layout probes: C that has a compiler state the sizes and member offsets
+ *   of an archive's composites, to check the archive, and the data
+ *   organizations the tools lay types out for, against a real ABI.
+ *
+ *   A probe is a constant expression, "sizeof(struct lua_Debug)" or
+ *   "__builtin_offsetof(struct lua_Debug, i_ci)", on a line of its own in
+ *   an array initializer:
+ *
+ *     #include "header.h"
+ *     const unsigned long long gdt_probe[] = {
+ *         (unsigned long long)(sizeof(struct lua_Debug)),
+ *         ...
+ *     };
+ *
+ *   The file is only compiled, not linked or run, so a cross compiler needs
+ *   neither the target's libraries nor the target: the values are read
+ *   back from the section of the gdt_probe symbol in the ELF object
+ *   (common/elf.hpp), in its byte order. Compilers name the file and line
+ *   of each error, so a probe that does not compile is found by its line
+ *   and can be left out.
+ *
+ *   Types are spelled as the header declares them: by tag where it has
+ *   "struct NAME" or "union NAME", else by their name as a typedef. A
+ *   nested composite without a name of its own is reached through the
+ *   members that hold it, "sizeof(((struct CallInfo *)0)->u.l)", and its
+ *   offsets are taken from where it starts. Bit-fields have no offsetof
+ *   and are not probed.
+ */
+
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/elf.hpp"
+#include "common/mapped_file.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace gdt {
+
+// The identifiers of a C text outside comments and literals, and those
+// among them that follow "struct" or "union".
+struct CNames {
+    std::unordered_set<std::string> identifiers;
+    std::unordered_set<std::string> tags;
+
+    explicit CNames(const std::string &s) {
+        std::string last;
+        for (size_t i = 0, n = s.size(); i < n;) {
+            char c = s[i];
+            if (c == '/' && i + 1 < n && s[i + 1] == '/') {
+                i = s.find('\n', i);
+                i = i == std::string::npos ? n : i;
+            } else if (c == '/' && i + 1 < n && s[i + 1] == '*') {
+                i = s.find("*/", i + 2);
+                i = i == std::string::npos ? n : i + 2;
+            } else if (c == '"' || c == '\'') {
+                for (i++; i < n && s[i] != c && s[i] != '\n'; i++) {
+                    i += s[i] == '\\';
+                }
+                i++;
+            } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+                size_t b = i;
+                while (i < n && (std::isalnum(static_cast<unsigned char>(s[i])) || s[i] == '_')) {
+                    i++;
+                }
+                std::string id = s.substr(b, i - b);
+                if (last == "struct" || last == "union") {
+                    tags.insert(id);
+                }
+                identifiers.insert(id);
+                last = id;
+            } else {
+                if (!std::isspace(static_cast<unsigned char>(c))) {
+                    last.clear();
+                }
+                i++;
+            }
+        }
+    }
+};
+
+// What an archive says a probe comes to.
+struct Expected {
+    size_t probe;
+    uint64_t value;
+    int64_t type;   // the composite
+    int component;  // its index, -1 for the size
+};
+
+// Probe expressions, each once.
+class ProbeSet {
+  public:
+    static constexpr int FIRST_LINE = 3;  // of the first probe in source()
+
+    size_t add(const std::string &expr) {
+        auto it = index_.emplace(expr, exprs_.size());
+        if (it.second) {
+            exprs_.push_back(expr);
+        }
+        return it.first->second;
+    }
+
+    const std::vector<std::string> &exprs() const { return exprs_; }
+
+    // A C file with the given probes, probes[i] on line FIRST_LINE + i.
+    std::string source(const std::string &include, const std::vector<size_t> &probes) const {
+        std::string s = "#include \"" + include + "\"\nconst unsigned long long gdt_probe[] = {\n";
+        for (size_t p : probes) {
+            s += "    (unsigned long long)(" + exprs_.at(p) + "),\n";
+        }
+        return s + "};\n";
+    }
+
+  private:
+    std::vector<std::string> exprs_;
+    std::unordered_map<std::string, size_t> index_;
+};
+
+// Adds the probes of every composite of 'a' that has a layout and that the
+// header, named by 'names', declares or that is held by value in one it
+// declares (the nested "struct { ... } l;" of a union). Returns how many
+// composites that is.
+inline size_t layout_probes(const Archive &a, const CNames &names, ProbeSet &set, std::vector<Expected> &out) {
+    // How each composite is reached: a type the header names and a path of
+    // members from it, empty for that type itself.
+    struct Reach {
+        std::string base;
+        std::string path;
+    };
+    std::unordered_map<int64_t, Reach> reach;
+    std::vector<const DataType *> order;
+    for (const DataType *t : a.types()) {
+        if (t->table() != T_COMPOSITE || t->length <= 0) {
+            continue;
+        }
+        if (names.tags.count(t->name)) {
+            reach[t->id] = {(t->is_union ? "union " : "struct ") + t->name, ""};
+        } else if (names.identifiers.count(t->name)) {
+            reach[t->id] = {t->name, ""};
+        } else {
+            continue;
+        }
+        order.push_back(t);
+    }
+    for (size_t k = 0; k < order.size(); k++) {
+        const Reach r = reach.at(order[k]->id);
+        for (const Component &c : order[k]->components) {
+            const DataType *u = table_of(c.type) == T_COMPOSITE ? a.get(c.type) : nullptr;
+            if (u && u->length > 0 && !reach.count(u->id) && names.identifiers.count(c.name)) {
+                reach[u->id] = {r.base, r.path.empty() ? c.name : r.path + "." + c.name};
+                order.push_back(u);
+            }
+        }
+    }
+
+    for (const DataType *t : order) {
+        const Reach &r = reach.at(t->id);
+        std::string size = r.path.empty() ? "sizeof(" + r.base + ")" : "sizeof(((" + r.base + " *)0)->" + r.path + ")";
+        std::string prefix = r.path.empty() ? "" : r.path + ".";
+        std::string start = r.path.empty() ? "" : " - __builtin_offsetof(" + r.base + ", " + r.path + ")";
+        out.push_back({set.add(size), uint64_t(t->length), t->id, -1});
+        for (size_t i = 0; i < t->components.size(); i++) {
+            const Component &c = t->components[i];
+            if (table_of(c.type) == T_BITFIELD || c.offset < 0 || !names.identifiers.count(c.name)) {
+                continue;
+            }
+            std::string offset = "__builtin_offsetof(" + r.base + ", " + prefix + c.name + ")" + start;
+            out.push_back({set.add(offset), uint64_t(c.offset), t->id, int(i)});
+        }
+    }
+    return order.size();
+}
+
+// The values of the probes in an object file compiled from
+// ProbeSet::source, in order.
+inline std::vector<uint64_t> probe_values(const std::string &object) {
+    common::MappedFile file(object);
+    common::ElfFile elf(file.data(), file.size());
+    for (const common::ElfSymbol &s : elf.symbols()) {
+        if (s.name != "gdt_probe" || !s.defined() || s.shndx >= elf.sections().size()) {
+            continue;
+        }
+        const common::ElfSection &sec = elf.sections()[s.shndx];
+        if (sec.nobits() || s.value > sec.size || sec.size - s.value < s.size || s.size % 8) {
+            break;
+        }
+        std::vector<uint64_t> values;
+        for (uint64_t off = 0; off < s.size; off += 8) {
+            values.push_back(elf.u64(sec.offset + s.value + off));
+        }
+        return values;
+    }
+    throw std::runtime_error("no gdt_probe array");
+}
+
+// An error as compilers report it: "file:line:column: error: message".
+struct CompilerError {
+    std::string file;
+    int line = 0;
+    std::string message;
+};
+
+inline std::vector<CompilerError> compiler_errors(const std::string &log) {
+    std::vector<CompilerError> errors;
+    for (size_t b = 0; b < log.size();) {
+        size_t e = log.find('\n', b);
+        e = e == std::string::npos ? log.size() : e;
+        std::string line = log.substr(b, e - b);
+        b = e + 1;
+        size_t at = line.find(": error: "), len = 9;
+        if (at == std::string::npos) {
+            at = line.find(": fatal error: ");
+            len = 15;
+        }
+        if (at == std::string::npos) {
+            continue;
+        }
+        // "file:line:column" or "file:line"
+        std::string where = line.substr(0, at);
+        auto number = [&](size_t from, size_t to) {
+            return to > from && where.find_first_not_of("0123456789", from) >= to;
+        };
+        size_t last = where.rfind(':');
+        size_t before = last == std::string::npos || last == 0 ? std::string::npos : where.rfind(':', last - 1);
+        CompilerError err;
+        if (before != std::string::npos && number(before + 1, last) && number(last + 1, where.size())) {
+            err.file = where.substr(0, before);
+            err.line = std::atoi(where.c_str() + before + 1);
+        } else if (last != std::string::npos && number(last + 1, where.size())) {
+            err.file = where.substr(0, last);
+            err.line = std::atoi(where.c_str() + last + 1);
+        } else {
+            continue;
+        }
+        err.message = line.substr(at + len);
+        errors.push_back(err);
+    }
+    return errors;
+}
+
+// <limits.h> from the compiler's predefined macros, for compiling against
+// no C library (-nostdinc), as gdt_compile.hpp's predefine() sets it.
+inline const char *limits_stand_in() {
+    return "#define CHAR_BIT __CHAR_BIT__\n"
+           "#define SCHAR_MAX __SCHAR_MAX__\n"
+           "#define SCHAR_MIN (-SCHAR_MAX - 1)\n"
+           "#define UCHAR_MAX (SCHAR_MAX * 2 + 1)\n"
+           "#ifdef __CHAR_UNSIGNED__\n"
+           "#define CHAR_MIN 0\n"
+           "#define CHAR_MAX UCHAR_MAX\n"
+           "#else\n"
+           "#define CHAR_MIN SCHAR_MIN\n"
+           "#define CHAR_MAX SCHAR_MAX\n"
+           "#endif\n"
+           "#define SHRT_MAX __SHRT_MAX__\n"
+           "#define SHRT_MIN (-SHRT_MAX - 1)\n"
+           "#define USHRT_MAX (SHRT_MAX * 2 + 1)\n"
+           "#define INT_MAX __INT_MAX__\n"
+           "#define INT_MIN (-INT_MAX - 1)\n"
+           "#define UINT_MAX (INT_MAX * 2U + 1U)\n"
+           "#define LONG_MAX __LONG_MAX__\n"
+           "#define LONG_MIN (-LONG_MAX - 1L)\n"
+           "#define ULONG_MAX (LONG_MAX * 2UL + 1UL)\n"
+           "#define LLONG_MAX __LONG_LONG_MAX__\n"
+           "#define LLONG_MIN (-LLONG_MAX - 1LL)\n"
+           "#define ULLONG_MAX (LLONG_MAX * 2ULL + 1ULL)\n"
+           "#define SIZE_MAX __SIZE_MAX__\n"
+           "#define PTRDIFF_MAX __PTRDIFF_MAX__\n";
+}
+
+}  // namespace gdt
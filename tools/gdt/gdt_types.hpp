@@ -0,0 +1,624 @@
+/*
+ *   The data type model of a .gdt archive, assembled from its tables
+ *   (gdt_db.hpp), and layout of its types for a given data organization.
+ *
+ *   Data type ids carry their table in the top byte (DataTypeManagerDB):
+ *
+ *     0 built-in   1 composite   2 component   3 array   4 pointer
+ *     5 typedef    6 function definition   7 parameter   8 enum
+ *     9 bitfield (not a table: base type key, bit offset and size packed
+ *       into the id)
+ *
+ *   Archives store offsets and sizes for the pointer width they were made
+ *   with. layout() recomputes them for another DataOrganization, following
+ *   the System V rules gcc and clang use (natural alignment, bitfields
+ *   packed into units of their base type); composites that are not packed
+ *   ("internal alignment" -1) keep their stored offsets, and pointers with
+ *   a stored length keep it, unless the organization asks for a relayout.
+ *   That is what archives built from DWARF of one target (libcurl.gdt) need
+ *   to describe another. Layouter does the same for types reached through
+ *   any lookup, such as those of an archive still being compiled.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gdt/gdt_db.hpp"
+
+
+namespace gdt {
+
+enum TableCode : uint8_t {
+    T_BUILTIN = 0,
+    T_COMPOSITE = 1,
+    T_COMPONENT = 2,
+    T_ARRAY = 3,
+    T_POINTER = 4,
+    T_TYPEDEF = 5,
+    T_FUNCDEF = 6,
+    T_PARAMETER = 7,
+    T_ENUM = 8,
+    T_BITFIELD = 9,
+};
+
+constexpr int64_t DEFAULT_ID = 0;  // "undefined"
+constexpr int64_t NULL_ID = -1;
+
+inline uint8_t table_of(int64_t id) { return static_cast<uint8_t>(uint64_t(id) >> 56); }
+inline int64_t key_of(int64_t id) { return static_cast<int64_t>(uint64_t(id) & 0x00ffffffffffffffull); }
+inline int64_t make_id(uint8_t table, int64_t key) { return static_cast<int64_t>(uint64_t(table) << 56 | uint64_t(key)); }
+
+// Bitfield ids: bit size in bits 0-7, bit offset in 8-15, base type kind in
+// bits 21-22 (0 built-in, 1 typedef, 2 enum), base type key from bit 24.
+struct BitField {
+    unsigned bit_size;
+    unsigned bit_offset;
+    int64_t base;
+
+    explicit BitField(int64_t id)
+        : bit_size(unsigned(id & 0xff)), bit_offset(unsigned((id >> 8) & 0xff)), base(0) {
+        static const uint8_t tables[4] = {T_BUILTIN, T_TYPEDEF, T_ENUM, T_BUILTIN};
+        base = make_id(tables[(id >> 21) & 3], (id >> 24) & 0xffffffff);
+    }
+};
+
+struct Category {
+    int64_t id = 0;
+    std::string name;
+    int64_t parent = -1;
+};
+
+// A row of "Data Type Archive IDs": an archive types were taken from (id 0
+// is the archive itself).
+struct SourceArchive {
+    int64_t id = 0;
+    std::string domain_file_id;
+    std::string name;
+    uint8_t type = 0;
+    int64_t last_sync_time = 0;
+    bool dirty = false;
+};
+
+struct Component {
+    int64_t id = 0;
+    int32_t offset = 0;
+    int64_t type = DEFAULT_ID;
+    std::string name;
+    std::string comment;
+    int32_t size = 0;
+    int32_t ordinal = 0;
+};
+
+struct Parameter {
+    int64_t id = 0;
+    int64_t type = DEFAULT_ID;
+    std::string name;
+    std::string comment;
+    int32_t ordinal = 0;
+    int32_t length = 0;
+};
+
+struct EnumValue {
+    int64_t id = 0;
+    std::string name;
+    int64_t value = 0;
+};
+
+struct DataType {
+    int64_t id = 0;
+    std::string name;
+    std::string comment;
+    int64_t category = 0;
+    std::string class_name;   // built-ins: implementing Java class
+    int64_t target = NULL_ID; // pointer, typedef and array element type
+    int32_t length = -1;      // composite/enum size, pointer length (-1 default), array element length
+    int32_t count = 0;        // array dimension
+    bool is_union = false;
+    int32_t packing = -1;     // composites: internal alignment, -1 not packed
+    int32_t alignment = 0;    // composites: external alignment, 0 default
+    int32_t num_components = 0;
+    int64_t return_type = NULL_ID;
+    uint8_t flags = 0;        // function definitions
+    int64_t source_archive = 0;
+    int64_t universal_id = 0;
+    int64_t source_sync_time = 0;
+    int64_t last_change_time = 0;
+    std::vector<Component> components;  // by ordinal
+    std::vector<Parameter> params;      // by ordinal
+    std::vector<EnumValue> values;
+
+    uint8_t table() const { return table_of(id); }
+    bool varargs() const { return flags & 0x1; }
+    bool no_return() const { return flags & 0x2; }
+};
+
+// Sizes and alignments of the C scalar types for one target.
+struct DataOrganization {
+    std::string name;
+    unsigned pointer_size;
+    unsigned long_size;
+    unsigned long_long_align;  // also double
+    unsigned long_double_size;
+    bool relayout = false;  // lay out not-packed composites and sized pointers too
+
+    static DataOrganization named(const std::string &n) {
+        if (n == "lp64") return {n, 8, 8, 8, 16};
+        if (n == "llp64") return {n, 8, 4, 8, 8};
+        if (n == "ilp32") return {n, 4, 4, 8, 8};
+        if (n == "i386") return {n, 4, 4, 4, 12};
+        throw std::runtime_error("unknown data organization '" + n + "' (lp64, llp64, ilp32, i386)");
+    }
+
+    static DataOrganization for_pointer_size(unsigned p) { return named(p == 8 ? "lp64" : "ilp32"); }
+};
+
+struct TypeLayout {
+    uint64_t size = 0;
+    uint64_t align = 1;
+    std::vector<uint64_t> offsets;      // composites: per component, in ordinal order
+    std::vector<uint64_t> bit_offsets;  // composites: first bit of each component (bit-fields within their unit)
+};
+
+// Layout of the types reached through a lookup, for one data
+// organization. Results are memoized, so a Layouter is for types that no
+// longer change.
+class Layouter {
+  public:
+    using Lookup = std::function<const DataType *(int64_t)>;
+
+    Layouter(Lookup get, const DataOrganization &org) : get_(std::move(get)), org_(org) {}
+
+    TypeLayout layout(int64_t id) { return layout(id, 0); }
+
+    // Layout of a composite given by its record, which need not be
+    // reachable through the lookup yet.
+    TypeLayout layout(const DataType &t) { return t.table() == T_COMPOSITE ? composite_layout(t, 0) : layout(t.id, 0); }
+
+  private:
+    static uint64_t align_up(uint64_t v, uint64_t a) { return a > 1 ? (v + a - 1) / a * a : v; }
+
+    TypeLayout builtin_layout(const DataType &t) const {
+        std::string c = t.class_name.substr(t.class_name.rfind('.') + 1);
+        auto scalar = [](uint64_t s, uint64_t a) {
+            TypeLayout l;
+            l.size = s;
+            l.align = a;
+            return l;
+        };
+        if (c == "VoidDataType") return scalar(0, 1);
+        if (c == "PointerDataType") return scalar(org_.pointer_size, org_.pointer_size);
+        if (c == "LongDataType" || c == "UnsignedLongDataType") return scalar(org_.long_size, org_.long_size);
+        if (c == "LongLongDataType" || c == "UnsignedLongLongDataType" || c == "DoubleDataType" ||
+            c == "QWordDataType" || c == "Undefined8DataType") {
+            return scalar(8, org_.long_long_align);
+        }
+        if (c == "LongDoubleDataType") return scalar(org_.long_double_size, org_.long_double_size > 8 ? 16 : 8);
+        if (c == "IntegerDataType" || c == "UnsignedIntegerDataType" || c == "FloatDataType" ||
+            c == "DWordDataType" || c == "Undefined4DataType" || c == "WideChar32DataType") {
+            return scalar(4, 4);
+        }
+        if (c == "ShortDataType" || c == "UnsignedShortDataType" || c == "WordDataType" ||
+            c == "Undefined2DataType" || c == "WideChar16DataType") {
+            return scalar(2, 2);
+        }
+        if (c == "WideCharDataType") return scalar(org_.long_size == 4 && org_.pointer_size == 8 ? 2 : 4, 4);
+        return scalar(1, 1);  // char, uchar, byte, bool, undefined1, ...
+    }
+
+    TypeLayout layout(int64_t id, int depth) {
+        if (depth > 64) {
+            throw std::runtime_error("type nesting too deep at " + name_of(id));
+        }
+        auto m = memo_.find(id);
+        if (m != memo_.end()) {
+            return m->second;
+        }
+        TypeLayout l;
+        if (table_of(id) == T_BITFIELD) {
+            l = layout(BitField(id).base, depth + 1);
+            l.offsets.clear();
+            l.bit_offsets.clear();
+            return l;
+        }
+        const DataType *t = get_(id);
+        if (!t) {
+            return l;  // undefined: one byte
+        }
+        switch (t->table()) {
+        case T_BUILTIN:
+            l = builtin_layout(*t);
+            break;
+        case T_POINTER:
+            l.size = l.align = t->length > 0 && !org_.relayout ? uint64_t(t->length) : org_.pointer_size;
+            break;
+        case T_TYPEDEF:
+            l = layout(t->target, depth + 1);
+            l.offsets.clear();
+            l.bit_offsets.clear();
+            break;
+        case T_ENUM:
+            l.size = l.align = t->length > 0 ? uint64_t(t->length) : 4;
+            break;
+        case T_ARRAY: {
+            TypeLayout e = layout(t->target, depth + 1);
+            l.size = e.size * uint64_t(std::max(0, t->count));
+            l.align = e.align;
+            break;
+        }
+        case T_FUNCDEF:
+            l.size = 1;
+            break;
+        case T_COMPOSITE:
+            l = composite_layout(*t, depth);
+            break;
+        default:
+            break;
+        }
+        memo_.emplace(id, l);
+        return l;
+    }
+
+    TypeLayout composite_layout(const DataType &t, int depth) {
+        TypeLayout l;
+        if (t.packing < 0 && !org_.relayout) {  // not packed: offsets are as stored
+            l.size = t.length > 0 ? uint64_t(t.length) : 0;
+            for (const Component &c : t.components) {
+                l.offsets.push_back(uint64_t(std::max(0, c.offset)));
+                l.bit_offsets.push_back(l.offsets.back() * 8);
+                l.align = std::max(l.align, layout(c.type, depth + 1).align);
+            }
+            return l;
+        }
+        uint64_t bitpos = 0;
+        uint64_t size = 0;
+        for (const Component &c : t.components) {
+            TypeLayout cl = layout(c.type, depth + 1);
+            uint64_t a = cl.align;
+            if (t.packing > 0) {
+                a = std::min<uint64_t>(a, uint64_t(t.packing));
+            }
+            l.align = std::max(l.align, a);
+            if (t.is_union) {
+                l.offsets.push_back(0);
+                l.bit_offsets.push_back(0);
+                size = std::max(size, cl.size);
+                continue;
+            }
+            if (table_of(c.type) == T_BITFIELD) {
+                unsigned bits = BitField(c.type).bit_size;
+                uint64_t unit = std::max<uint64_t>(cl.size, 1) * 8;
+                if (bits == 0) {  // ":0" closes the unit
+                    bitpos = align_up(bitpos, unit);
+                    l.offsets.push_back(bitpos / 8);
+                    l.bit_offsets.push_back(bitpos);
+                    continue;
+                }
+                if (bitpos % unit + bits > unit) {
+                    bitpos = align_up(bitpos, unit);
+                }
+                l.offsets.push_back(bitpos / 8 / (unit / 8) * (unit / 8));
+                l.bit_offsets.push_back(bitpos);
+                bitpos += bits;
+                size = std::max(size, (bitpos + 7) / 8);
+                continue;
+            }
+            uint64_t off = align_up((bitpos + 7) / 8, a);
+            l.offsets.push_back(off);
+            l.bit_offsets.push_back(off * 8);
+            bitpos = (off + cl.size) * 8;
+            size = std::max(size, off + cl.size);
+        }
+        if (t.alignment > 0) {
+            l.align = std::max<uint64_t>(l.align, uint64_t(t.alignment));
+        }
+        l.size = align_up(size, l.align);
+        return l;
+    }
+
+    std::string name_of(int64_t id) const {
+        const DataType *t = table_of(id) == T_BITFIELD ? nullptr : get_(id);
+        return t && !t->name.empty() ? t->name : "id " + std::to_string(id);
+    }
+
+    Lookup get_;
+    DataOrganization org_;
+    std::map<int64_t, TypeLayout> memo_;
+};
+
+class Archive {
+  public:
+    explicit Archive(const std::string &path) : db_(path) { load(); }
+    // From a container or buffer file in memory (ArchiveWriter::image()).
+    Archive(const uint8_t *d, size_t n) : db_(d, n) { load(); }
+
+    const Database &db() const { return db_; }
+
+    // All data types in table order (built-ins, composites, ..., enums).
+    const std::vector<const DataType *> &types() const { return order_; }
+    const std::map<int64_t, Category> &categories() const { return categories_; }
+    const std::vector<SourceArchive> &source_archives() const { return sources_; }
+
+    const DataType *get(int64_t id) const {
+        auto it = types_.find(id);
+        return it == types_.end() ? nullptr : &it->second;
+    }
+
+    // First named type (built-in, composite, typedef, function definition or
+    // enum) called 'name', in table order.
+    const DataType *find(const std::string &name) const {
+        auto it = by_name_.find(name);
+        return it == by_name_.end() ? nullptr : it->second;
+    }
+
+    // "/jni_all.h/functions"
+    std::string category_path(int64_t cat) const {
+        std::string path;
+        for (int depth = 0; depth < 64; depth++) {
+            auto it = categories_.find(cat);
+            if (it == categories_.end() || it->second.parent < 0) {
+                break;
+            }
+            path = "/" + it->second.name + path;
+            cat = it->second.parent;
+        }
+        return path.empty() ? "/" : path;
+    }
+
+    // Type name as Ghidra displays it: "JNIEnv_ *", "char[16]", "uint:1".
+    std::string type_name(int64_t id) const {
+        if (id == DEFAULT_ID) {
+            return "undefined";
+        }
+        if (table_of(id) == T_BITFIELD) {
+            BitField bf(id);
+            return type_name(bf.base) + ":" + std::to_string(bf.bit_size);
+        }
+        const DataType *t = get(id);
+        if (!t) {
+            return "undefined";
+        }
+        switch (t->table()) {
+        case T_POINTER:
+            return (t->target == NULL_ID ? std::string("void") : type_name(t->target)) + " *";
+        case T_ARRAY:
+            return type_name(t->target) + "[" + std::to_string(t->count) + "]";
+        default:
+            return t->name;
+        }
+    }
+
+    // C declaration of 'inner' with type 'id': decl(ptr-to-funcdef, "cb")
+    // gives "int (*cb)(void *arg)". Function definitions expand to their
+    // signature.
+    std::string decl(int64_t id, const std::string &inner) const {
+        const DataType *t = table_of(id) == T_BITFIELD ? nullptr : get(id);
+        if (t && t->table() == T_POINTER) {
+            const DataType *to = get(t->target);
+            bool wrap = to && (to->table() == T_FUNCDEF || to->table() == T_ARRAY);
+            std::string ptr = "*" + inner;
+            return t->target == NULL_ID ? "void " + ptr : decl(t->target, wrap ? "(" + ptr + ")" : ptr);
+        }
+        if (t && t->table() == T_ARRAY) {
+            return decl(t->target, inner + "[" + std::to_string(t->count) + "]");
+        }
+        if (t && t->table() == T_FUNCDEF) {
+            std::string args;
+            for (const Parameter &p : t->params) {
+                args += (args.empty() ? "" : ", ") + decl(p.type, p.name);
+            }
+            if (t->varargs()) {
+                args += args.empty() ? "..." : ", ...";
+            } else if (args.empty()) {
+                args = "void";
+            }
+            return decl(t->return_type == NULL_ID ? DEFAULT_ID : t->return_type, inner + "(" + args + ")");
+        }
+        if (table_of(id) == T_BITFIELD) {
+            BitField bf(id);
+            return type_name(bf.base) + " " + inner + " : " + std::to_string(bf.bit_size);
+        }
+        std::string base = type_name(id);
+        if (inner.empty()) {
+            return base;
+        }
+        return base + " " + inner;
+    }
+
+    // Follows typedefs to the underlying type.
+    int64_t resolve(int64_t id) const {
+        for (int depth = 0; depth < 64; depth++) {
+            const DataType *t = get(id);
+            if (!t || t->table() != T_TYPEDEF) {
+                break;
+            }
+            id = t->target;
+        }
+        return id;
+    }
+
+    TypeLayout layout(int64_t id, const DataOrganization &org) const {
+        return Layouter([this](int64_t i) { return get(i); }, org).layout(id);
+    }
+
+  private:
+    void load() {
+        auto each = [&](const char *table, const std::function<void(int64_t, const Record &, const TableSchema &)> &fn) {
+            if (const TableSchema *s = db_.table(table)) {
+                db_.scan(*s, [&](int64_t k, const Record &r) { fn(k, r, *s); });
+            }
+        };
+        // Field lookup by column name, so older table versions with fewer
+        // columns still load.
+        auto str = [](const Record &r, const TableSchema &s, const char *f) -> std::string {
+            int i = s.field(f);
+            return i >= 0 ? r[size_t(i)].s : std::string();
+        };
+        auto num = [](const Record &r, const TableSchema &s, const char *f, int64_t def = 0) -> int64_t {
+            int i = s.field(f);
+            return i >= 0 ? r[size_t(i)].i : def;
+        };
+        auto provenance = [&](DataType &t, const Record &r, const TableSchema &s) {
+            t.source_archive = num(r, s, "Source Archive ID");
+            t.universal_id = num(r, s, "Source Data Type ID", num(r, s, "Universal Data Type ID"));
+            t.source_sync_time = num(r, s, "Source Sync Time");
+            t.last_change_time = num(r, s, "Last Change Time");
+        };
+
+        each("Categories", [&](int64_t k, const Record &r, const TableSchema &s) {
+            Category c;
+            c.id = k;
+            c.name = str(r, s, "Name");
+            c.parent = num(r, s, "Parent ID", -1);
+            categories_[k] = c;
+        });
+        if (!categories_.count(0)) {
+            categories_[0] = Category{0, "", -1};
+        }
+        each("Data Type Archive IDs", [&](int64_t k, const Record &r, const TableSchema &s) {
+            SourceArchive a;
+            a.id = k;
+            a.domain_file_id = str(r, s, "Domain File ID");
+            a.name = str(r, s, "Name");
+            a.type = static_cast<uint8_t>(num(r, s, "Type"));
+            a.last_sync_time = num(r, s, "Last Sync Time");
+            a.dirty = num(r, s, "Dirty Flag") != 0;
+            sources_.push_back(std::move(a));
+        });
+        each("Built-in datatypes", [&](int64_t k, const Record &r, const TableSchema &s) {
+            DataType &t = add(make_id(T_BUILTIN, k));
+            t.name = str(r, s, "Name");
+            t.class_name = str(r, s, "Class Name");
+            t.category = num(r, s, "Category ID");
+        });
+        each("Composite Data Types", [&](int64_t k, const Record &r, const TableSchema &s) {
+            DataType &t = add(k);
+            t.name = str(r, s, "Name");
+            t.comment = str(r, s, "Comment");
+            t.is_union = num(r, s, "Is Union") != 0;
+            t.category = num(r, s, "Category ID");
+            t.length = static_cast<int32_t>(num(r, s, "Length"));
+            t.num_components = static_cast<int32_t>(num(r, s, "Number Of Components"));
+            t.packing = static_cast<int32_t>(num(r, s, "Internal Alignment", -1));
+            t.alignment = static_cast<int32_t>(num(r, s, "External Alignment"));
+            provenance(t, r, s);
+        });
+        each("Component Data Types", [&](int64_t k, const Record &r, const TableSchema &s) {
+            DataType *parent = mutable_get(r[0].i);
+            if (!parent) {
+                return;
+            }
+            Component c;
+            c.id = k;
+            c.offset = static_cast<int32_t>(num(r, s, "Offset"));
+            c.type = r[2].i;
+            c.name = str(r, s, "Field Name");
+            c.comment = str(r, s, "Comment");
+            c.size = static_cast<int32_t>(num(r, s, "Component Size"));
+            c.ordinal = static_cast<int32_t>(num(r, s, "Ordinal"));
+            parent->components.push_back(std::move(c));
+        });
+        each("Arrays", [&](int64_t k, const Record &r, const TableSchema &s) {
+            DataType &t = add(k);
+            t.target = r[0].i;
+            t.count = static_cast<int32_t>(num(r, s, "Dimension"));
+            t.length = static_cast<int32_t>(num(r, s, "Length", -1));
+            t.category = num(r, s, "Cat ID");
+        });
+        each("Pointers", [&](int64_t k, const Record &r, const TableSchema &s) {
+            DataType &t = add(k);
+            t.target = r[0].i;
+            t.category = num(r, s, "Category ID");
+            t.length = static_cast<int32_t>(num(r, s, "Length", -1));
+        });
+        each("Typedefs", [&](int64_t k, const Record &r, const TableSchema &s) {
+            DataType &t = add(k);
+            t.target = r[0].i;
+            t.name = str(r, s, "Name");
+            t.category = num(r, s, "Category ID");
+            provenance(t, r, s);
+        });
+        each("Function Definitions", [&](int64_t k, const Record &r, const TableSchema &s) {
+            DataType &t = add(k);
+            t.name = str(r, s, "Name");
+            t.comment = str(r, s, "Comment");
+            t.category = num(r, s, "Category ID");
+            t.return_type = num(r, s, "Return Type ID", NULL_ID);
+            t.flags = static_cast<uint8_t>(num(r, s, "Flags"));
+            provenance(t, r, s);
+        });
+        each("Function Parameters", [&](int64_t k, const Record &r, const TableSchema &s) {
+            DataType *parent = mutable_get(r[0].i);
+            if (!parent) {
+                return;
+            }
+            Parameter p;
+            p.id = k;
+            p.type = r[1].i;
+            p.name = str(r, s, "Name");
+            p.comment = str(r, s, "Comment");
+            p.ordinal = static_cast<int32_t>(num(r, s, "Ordinal"));
+            p.length = static_cast<int32_t>(num(r, s, "Data Type Length"));
+            parent->params.push_back(std::move(p));
+        });
+        each("Enumeration Data Types", [&](int64_t k, const Record &r, const TableSchema &s) {
+            DataType &t = add(k);
+            t.name = str(r, s, "Name");
+            t.comment = str(r, s, "Comment");
+            t.category = num(r, s, "Category ID");
+            t.length = static_cast<int32_t>(num(r, s, "Size", 4));
+            provenance(t, r, s);
+        });
+        each("Enumeration Values", [&](int64_t k, const Record &r, const TableSchema &s) {
+            DataType *parent = mutable_get(num(r, s, "Enum ID"));
+            if (!parent) {
+                return;
+            }
+            parent->values.push_back(EnumValue{k, str(r, s, "Name"), num(r, s, "Value")});
+        });
+
+        for (auto &kv : types_) {
+            DataType &t = kv.second;
+            std::stable_sort(t.components.begin(), t.components.end(),
+                             [](const Component &a, const Component &b) { return a.ordinal < b.ordinal; });
+            std::stable_sort(t.params.begin(), t.params.end(),
+                             [](const Parameter &a, const Parameter &b) { return a.ordinal < b.ordinal; });
+        }
+        for (const DataType *t : order_) {
+            if (!t->name.empty()) {
+                by_name_.emplace(t->name, t);
+            }
+        }
+    }
+
+    DataType &add(int64_t id) {
+        auto r = types_.emplace(id, DataType());
+        DataType &t = r.first->second;
+        t.id = id;
+        if (r.second) {
+            order_.push_back(&t);
+        }
+        return t;
+    }
+
+    DataType *mutable_get(int64_t id) {
+        auto it = types_.find(id);
+        return it == types_.end() ? nullptr : &it->second;
+    }
+
+    Database db_;
+    std::unordered_map<int64_t, DataType> types_;  // node-based: pointers in order_ stay valid
+    std::vector<const DataType *> order_;
+    std::unordered_map<std::string, const DataType *> by_name_;
+    std::map<int64_t, Category> categories_;
+    std::vector<SourceArchive> sources_;
+};
+
+}  // namespace gdt
@@ -0,0 +1,199 @@
+/*
+ *   gdt_vtable: print the slot table of a function-pointer structure
+ *   (JNINativeInterface_, JNIInvokeInterface_, Curl_handler, ...) from a
+ *   .gdt archive: offset, member name and C signature of every member, with
+ *   offsets recomputed for each requested data organization.
+ *
+ *   --header writes the tables as a C++ header instead, so that scanners can
+ *   resolve offsets without reading the archive at run time; this is how
+ *   tools/jni/jni_interface.hpp is produced:
+ *
+ *     gdt_vtable --header jni --org ilp32,lp64 gdt/jni_all.gdt \
+ *         JNINativeInterface_ JNIInvokeInterface_ JNINativeMethod > tools/jni/jni_interface.hpp
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -Itools tools/gdt/gdt_vtable.cpp -o gdt_vtable
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "gdt/gdt_types.hpp"
+
+
+namespace {
+
+struct Options {
+    std::vector<std::string> orgs{"ilp32", "lp64"};
+    bool relayout = false;
+    std::string header_ns;
+    std::string archive;
+    std::vector<std::string> structs;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: gdt_vtable [options] archive.gdt struct...\n"
+                 "  --org LIST     data organizations, comma-separated (default ilp32,lp64;\n"
+                 "                 also llp64, i386)\n"
+                 "  --relayout     recompute offsets of structures stored with fixed offsets\n"
+                 "                 (archives built from DWARF, such as libcurl.gdt)\n"
+                 "  --header NS    emit a C++ header with the tables in namespace NS\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--org") {
+            o.orgs.clear();
+            std::string list = next();
+            size_t start = 0;
+            for (size_t comma; (comma = list.find(',', start)) != std::string::npos; start = comma + 1) {
+                o.orgs.push_back(list.substr(start, comma - start));
+            }
+            o.orgs.push_back(list.substr(start));
+        } else if (a == "--relayout") {
+            o.relayout = true;
+        } else if (a == "--header") {
+            o.header_ns = next();
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (o.archive.empty()) {
+            o.archive = a;
+        } else {
+            o.structs.push_back(a);
+        }
+    }
+    if (o.archive.empty() || o.structs.empty()) {
+        usage();
+    }
+    return o;
+}
+
+struct Slot {
+    uint64_t offset;
+    std::string name;
+    std::string signature;
+};
+
+std::vector<Slot> slots(const gdt::Archive &a, const gdt::DataType &s, const gdt::DataOrganization &org) {
+    gdt::TypeLayout l = a.layout(s.id, org);
+    std::vector<Slot> out;
+    for (size_t i = 0; i < s.components.size(); i++) {
+        const gdt::Component &c = s.components[i];
+        // A member that is a pointer to a function definition is shown as that
+        // function's declaration; anything else as the member declaration.
+        std::string sig;
+        const gdt::DataType *p = a.get(a.resolve(c.type));
+        const gdt::DataType *f = p && p->table() == gdt::T_POINTER ? a.get(a.resolve(p->target)) : nullptr;
+        if (f && f->table() == gdt::T_FUNCDEF) {
+            sig = a.decl(f->id, c.name);
+        } else {
+            sig = a.decl(c.type, c.name);
+        }
+        out.push_back({l.offsets[i], c.name, sig});
+    }
+    return out;
+}
+
+std::string c_string(const std::string &s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    try {
+        gdt::Archive a(opt.archive);
+        std::vector<gdt::DataOrganization> orgs;
+        for (const std::string &n : opt.orgs) {
+            orgs.push_back(gdt::DataOrganization::named(n));
+            orgs.back().relayout = opt.relayout;
+        }
+        std::vector<const gdt::DataType *> structs;
+        for (const std::string &n : opt.structs) {
+            const gdt::DataType *s = a.find(n);
+            if (!s || s->table() != gdt::T_COMPOSITE) {
+                throw std::runtime_error("no structure named " + n);
+            }
+            structs.push_back(s);
+        }
+
+        if (opt.header_ns.empty()) {
+            for (const gdt::DataType *s : structs) {
+                for (const gdt::DataOrganization &org : orgs) {
+                    std::printf("# %s (%s, %" PRIu64 " bytes)\n", s->name.c_str(), org.name.c_str(),
+                                a.layout(s->id, org).size);
+                    for (const Slot &sl : slots(a, *s, org)) {
+                        std::printf("0x%04" PRIx64 "\t%s\t%s\n", sl.offset, sl.name.c_str(), sl.signature.c_str());
+                    }
+                }
+            }
+            return 0;
+        }
+
+        for (size_t i = 0; i < orgs.size(); i++) {
+            for (size_t j = 0; j < i; j++) {
+                if (orgs[i].pointer_size == orgs[j].pointer_size) {
+                    throw std::runtime_error("--header names tables by pointer width; pass one organization per width");
+                }
+            }
+        }
+        std::string archive = opt.archive.substr(opt.archive.rfind('/') + 1);
+        std::printf("/*\n"
+                    " *   Slot tables of %s",
+                    archive.c_str());
+        for (size_t i = 0; i < structs.size(); i++) {
+            std::printf("%s%s", i == 0 ? ": " : i + 1 == structs.size() ? " and " : ", ", structs[i]->name.c_str());
+        }
+        std::printf(",\n *   one per pointer width.\n *\n"
+                    " *   Generated by tools/gdt/gdt_vtable.cpp; do not edit.\n */\n\n"
+                    "#pragma once\n\n#include <cstddef>\n#include <cstdint>\n\n\n"
+                    "namespace %s {\n\n"
+                    "struct Slot {\n"
+                    "    uint32_t offset;\n"
+                    "    const char *name;\n"
+                    "    const char *signature;\n"
+                    "};\n",
+                    opt.header_ns.c_str());
+        for (const gdt::DataType *s : structs) {
+            for (const gdt::DataOrganization &org : orgs) {
+                std::vector<Slot> sl = slots(a, *s, org);
+                std::printf("\n// %s, %s\n", s->name.c_str(), org.name.c_str());
+                std::printf("inline constexpr uint32_t %s_%u_SIZE = %" PRIu64 ";\n", s->name.c_str(),
+                            org.pointer_size * 8, a.layout(s->id, org).size);
+                std::printf("inline constexpr Slot %s_%u[] = {\n", s->name.c_str(), org.pointer_size * 8);
+                for (const Slot &x : sl) {
+                    std::printf("    {%" PRIu64 ", %s, %s},\n", x.offset, c_string(x.name).c_str(),
+                                c_string(x.signature).c_str());
+                }
+                std::printf("};\n");
+            }
+        }
+        std::printf("\n}  // namespace %s\n", opt.header_ns.c_str());
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "gdt_vtable: %s: %s\n", opt.archive.c_str(), e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,266 @@
+/*
+ *   Data type archives written from the model of gdt_types.hpp, in the
+ *   table schemas of the archives in gdt/ (those of Ghidra 9.1; composites
+ *   at table version 4).
+ *
+ *   Every type goes to the table its id names, under its id. Components,
+ *   parameters and enum values are numbered afresh in type order, since
+ *   nothing refers to their keys. DT_PARENT_CHILD, which Ghidra keeps to
+ *   propagate changes, gets a row per use of a type by a composite,
+ *   function definition, typedef, pointer or array (built-in types only
+ *   for arrays), and Metadata the type and category counts. Empty member,
+ *   parameter and function comments and names are written as null, as
+ *   Ghidra does. Archives from older Ghidra versions lack the Data Type
+ *   Archive and Metadata tables; metadata(false) leaves them out as well.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gdt/gdt_db.hpp"
+#include "gdt/gdt_db_write.hpp"
+#include "gdt/gdt_types.hpp"
+
+
+namespace gdt {
+
+constexpr const char *DB_VERSION = "2";  // "Data Type Archive" table
+
+class ArchiveWriter {
+  public:
+    // The root category (id 0) is implicit and not stored.
+    void add(const Category &c) {
+        if (c.id != 0) {
+            categories_[c.id] = c;
+        }
+    }
+
+    void add(const DataType &t) { types_.push_back(t); }
+
+    void add(const SourceArchive &a) { sources_.push_back(a); }
+
+    // Everything in 'a'.
+    void add(const Archive &a) {
+        for (const auto &kv : a.categories()) {
+            add(kv.second);
+        }
+        for (const DataType *t : a.types()) {
+            add(*t);
+        }
+        for (const SourceArchive &s : a.source_archives()) {
+            add(s);
+        }
+    }
+
+    size_t types() const { return types_.size(); }
+
+    // Whether the "Data Type Archive" and "Metadata" tables are written
+    // (default yes).
+    void metadata(bool on) { metadata_ = on; }
+
+    // The buffer file of the archive known as 'database_id' (its universal
+    // id, which programs using its types refer to).
+    std::vector<uint8_t> image(int64_t database_id, const std::string &name = "Untitled") const {
+        auto num = [](int64_t v) {
+            Value x;
+            x.i = v;
+            return x;
+        };
+        auto str = [](const std::string &s) {
+            Value x;
+            x.s = s;
+            return x;
+        };
+        auto opt = [](const std::string &s) {
+            Value x;
+            x.s = s;
+            x.null = s.empty();
+            return x;
+        };
+        std::vector<TableData> t = schemas();
+        enum {
+            BUILTIN, CATEGORY, ARRAY, TYPEDEF, COMPOSITE, COMPONENT, FUNCDEF, PARAMETER, SETTINGS, POINTER, ENUM,
+            ENUM_VALUE, PARENT_CHILD, ARCHIVE_IDS, ARCHIVE, METADATA
+        };
+        auto row = [&](int which, int64_t key, Record fields) { t[size_t(which)].rows.push_back({num(key), fields}); };
+
+        for (const auto &kv : categories_) {
+            row(CATEGORY, kv.first, {str(kv.second.name), num(kv.second.parent)});
+        }
+        int64_t components = 0, params = 0, values = 0, links = 0;
+        auto uses = [&](const DataType &p, int64_t child, bool builtins) {
+            if (table_of(child) == T_BITFIELD) {
+                child = BitField(child).base;
+            }
+            if (child != NULL_ID && child != DEFAULT_ID && (builtins || table_of(child) != T_BUILTIN)) {
+                row(PARENT_CHILD, links++, {num(p.id), num(child)});
+            }
+        };
+        for (const DataType &d : types_) {
+            switch (d.table()) {
+            case T_BUILTIN:
+                row(BUILTIN, key_of(d.id), {str(d.name), str(d.class_name), num(d.category)});
+                break;
+            case T_COMPOSITE:
+                row(COMPOSITE, d.id,
+                    {str(d.name), str(d.comment), num(d.is_union), num(d.category), num(d.length),
+                     num(components_count(d)), num(d.source_archive), num(d.universal_id), num(d.source_sync_time),
+                     num(d.last_change_time), num(d.packing), num(d.alignment)});
+                for (const Component &c : d.components) {
+                    row(COMPONENT, make_id(T_COMPONENT, components++),
+                        {num(d.id), num(c.offset), num(c.type), opt(c.name), opt(c.comment), num(c.size),
+                         num(c.ordinal)});
+                    uses(d, c.type, false);
+                }
+                break;
+            case T_ARRAY:
+                row(ARRAY, d.id, {num(d.target), num(d.count), num(d.length), num(d.category)});
+                uses(d, d.target, true);
+                break;
+            case T_POINTER:
+                row(POINTER, d.id, {num(d.target), num(d.category), num(d.length)});
+                uses(d, d.target, false);
+                break;
+            case T_TYPEDEF:
+                row(TYPEDEF, d.id,
+                    {num(d.target), str(d.name), num(d.category), num(d.source_archive), num(d.universal_id),
+                     num(d.source_sync_time), num(d.last_change_time)});
+                uses(d, d.target, false);
+                break;
+            case T_FUNCDEF:
+                row(FUNCDEF, d.id,
+                    {str(d.name), opt(d.comment), num(d.category), num(d.return_type), num(d.flags),
+                     num(d.source_archive), num(d.universal_id), num(d.source_sync_time), num(d.last_change_time)});
+                uses(d, d.return_type, false);
+                for (const Parameter &p : d.params) {
+                    row(PARAMETER, make_id(T_PARAMETER, params++),
+                        {num(d.id), num(p.type), opt(p.name), opt(p.comment), num(p.ordinal), num(p.length)});
+                    uses(d, p.type, false);
+                }
+                break;
+            case T_ENUM:
+                row(ENUM, d.id,
+                    {str(d.name), str(d.comment), num(d.category), num(d.length), num(d.source_archive),
+                     num(d.universal_id), num(d.source_sync_time), num(d.last_change_time)});
+                for (const EnumValue &v : d.values) {
+                    row(ENUM_VALUE, values++, {str(v.name), num(v.value), num(d.id)});
+                }
+                break;
+            default:
+                throw FormatError("type " + std::to_string(d.id) + " has no table");
+            }
+        }
+
+        bool local = false;
+        for (const SourceArchive &s : sources_) {
+            row(ARCHIVE_IDS, s.id,
+                {opt(s.domain_file_id), opt(s.name), num(s.type), num(s.last_sync_time), num(s.dirty)});
+            local = local || s.id == 0;
+        }
+        if (!local) {
+            row(ARCHIVE_IDS, 0, {opt(""), opt(""), num(0), num(0), num(1)});
+        }
+        if (metadata_) {
+            t[ARCHIVE].rows.push_back({str("DB Version"), {str(DB_VERSION)}});
+            row(METADATA, 1, {str("Data Type Archive Name"), str(name)});
+            row(METADATA, 2, {str("# of Data Types"), str(std::to_string(types_.size()))});
+            row(METADATA, 3, {str("# of Data Type Categories"), str(std::to_string(categories_.size() + 1))});
+        } else {
+            t.resize(ARCHIVE);
+        }
+
+        DatabaseWriter w(database_id);
+        for (TableData &d : t) {
+            w.add(std::move(d));
+        }
+        return w.image();
+    }
+
+    void write(const std::string &path, int64_t database_id, const std::string &name = "Untitled") const {
+        write_file(path, pack_container(image(database_id, name), name));
+    }
+
+  private:
+    // Structures count their undefined bytes as components as well; unions
+    // leave the column at 0.
+    static int64_t components_count(const DataType &d) {
+        return d.is_union ? d.num_components : std::max<int64_t>(d.num_components, int64_t(d.components.size()));
+    }
+
+    // The tables of a data type archive, in the order Ghidra creates them.
+    static std::vector<TableData> schemas() {
+        struct Def {
+            const char *name;
+            int32_t version;
+            uint8_t key_type;
+            std::vector<uint8_t> types;
+            std::vector<std::string> names;
+            std::vector<int32_t> indexed;
+        };
+        const uint8_t B = F_BYTE, I = F_INT, L = F_LONG, S = F_STRING, Z = F_BOOLEAN, X = F_BINARY;
+        static const Def defs[] = {
+            {"Built-in datatypes", 0, L, {S, S, L}, {"Data Type ID", "Name", "Class Name", "Category ID"}, {2}},
+            {"Categories", 0, L, {S, L}, {"Category ID", "Name", "Parent ID"}, {1}},
+            {"Arrays", 1, L, {L, I, I, L}, {"Array ID", "Data Type ID", "Dimension", "Length", "Cat ID"}, {3}},
+            {"Typedefs", 1, L, {L, S, L, L, L, L, L},
+             {"Typedef ID", "Data Type ID", "Name", "Category ID", "Source Archive ID", "Universal Data Type ID",
+              "Source Sync Time", "Last Change Time"},
+             {2, 4}},
+            {"Composite Data Types", 4, L, {S, S, Z, L, I, I, L, L, L, L, I, I},
+             {"Data Type ID", "Name", "Comment", "Is Union", "Category ID", "Length", "Number Of Components",
+              "Source Archive ID", "Source Data Type ID", "Source Sync Time", "Last Change Time",
+              "Internal Alignment", "External Alignment"},
+             {3, 7}},
+            {"Component Data Types", 0, L, {L, I, L, S, S, I, I},
+             {"Data Type ID", "Parent", "Offset", "Data Type ID", "Field Name", "Comment", "Component Size",
+              "Ordinal"},
+             {0}},
+            {"Function Definitions", 1, L, {S, S, L, L, B, L, L, L, L},
+             {"Data Type ID", "Name", "Comment", "Category ID", "Return Type ID", "Flags", "Source Archive ID",
+              "Source Data Type ID", "Source Sync Time", "Last Change Time"},
+             {2, 6}},
+            {"Function Parameters", 1, L, {L, L, S, S, I, I},
+             {"Parameter ID", "Parent ID", "Data Type ID", "Name", "Comment", "Ordinal", "Data Type Length"},
+             {0}},
+            {"Default Settings", 0, L, {L, S, L, S, X},
+             {"DT Settings ID", "Data Type ID", "Settings Name", "Long Value", "String Value", "Byte Value"},
+             {0}},
+            {"Pointers", 2, L, {L, L, B}, {"Pointer ID", "Data Type ID", "Category ID", "Length"}, {1}},
+            {"Enumeration Data Types", 1, L, {S, S, L, B, L, L, L, L},
+             {"Enum ID", "Name", "Comment", "Category ID", "Size", "Source Archive ID", "Source Data Type ID",
+              "Source Sync Time", "Last Change Time"},
+             {2, 5}},
+            {"Enumeration Values", 0, L, {S, L, L}, {"Enum Value ID", "Name", "Value", "Enum ID"}, {2}},
+            {"DT_PARENT_CHILD", 0, L, {L, L}, {"KEY", "Parent ID", "Child ID"}, {0, 1}},
+            {"Data Type Archive IDs", 0, L, {S, S, B, L, Z},
+             {"Archive ID", "Domain File ID", "Name", "Type", "Last Sync Time", "Dirty Flag"},
+             {}},
+            {"Data Type Archive", 0, S, {S}, {"Key", "Value"}, {}},
+            {"Metadata", 0, L, {S, S}, {"ID", "Key", "Value"}, {}},
+        };
+        std::vector<TableData> out;
+        for (const Def &d : defs) {
+            TableData t;
+            t.schema.name = d.name;
+            t.schema.version = d.version;
+            t.schema.key_type = d.key_type;
+            t.schema.field_types = d.types;
+            t.schema.field_names = d.names;
+            t.indexed = d.indexed;
+            out.push_back(std::move(t));
+        }
+        return out;
+    }
+
+    std::map<int64_t, Category> categories_;
+    std::vector<DataType> types_;
+    std::vector<SourceArchive> sources_;
+    bool metadata_ = true;
+};
+
+}  // namespace gdt
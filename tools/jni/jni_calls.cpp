@@ -0,0 +1,275 @@
+/*
+ *   jni_calls: resolve (*env)->Fn(...) and (*vm)->Fn(...) call sites in
+ *   Android native libraries to JNI function names and signatures.
+ *
+ *   Offsets are looked up in the slot tables generated from jni_all.gdt
+ *   (jni_interface.hpp) for the pointer width of each library, so no archive
+ *   is read at run time. Slots below 4 (JNIEnv) and 3 (JavaVM) are reserved
+ *   and never called; offsets that fit both tables are reported with the
+ *   JavaVM alternative ("FindClass|vm:GetEnv").
+ *
+ *   Libraries are scanned in parallel; by default only those exporting
+ *   Java_* or JNI_OnLoad symbols are looked into (--all scans every ELF).
+ *   Each site is tagged "jni" when it lies in an exported Java_* or JNI_*
+ *   function and "pattern" otherwise (which may be a C++ virtual call).
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/jni/jni_calls.cpp -o jni_calls
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/elf.hpp"
+#include "common/files.hpp"
+#include "common/mapped_file.hpp"
+#include "common/parallel.hpp"
+#include "jni/jni_callsite.hpp"
+#include "jni/jni_interface.hpp"
+
+
+namespace {
+
+struct Options {
+    bool all = false;
+    bool signatures = false;
+    bool summary = false;
+    bool jni_only = false;
+    unsigned jobs = common::default_jobs();
+    std::vector<std::string> paths;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: jni_calls [options] path...\n"
+                 "  --all       scan every ELF file, not only those exporting Java_*/JNI_OnLoad\n"
+                 "  --sig       print the C signature of each resolved function\n"
+                 "  --jni-only  report only sites inside Java_*/JNI_* functions\n"
+                 "  --summary   print call counts per JNI function instead of sites\n"
+                 "  -j N        number of files scanned in parallel\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--all") {
+            o.all = true;
+        } else if (a == "--sig") {
+            o.signatures = true;
+        } else if (a == "--jni-only") {
+            o.jni_only = true;
+        } else if (a == "--summary") {
+            o.summary = true;
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else {
+            o.paths.push_back(a);
+        }
+    }
+    if (o.paths.empty()) {
+        usage();
+    }
+    return o;
+}
+
+struct Table {
+    const jni::Slot *slots;
+    size_t count;
+    unsigned first;  // first callable slot
+
+    const jni::Slot *at(uint32_t off, unsigned ptr) const {
+        if (off % ptr || off / ptr >= count || off / ptr < first) {
+            return nullptr;
+        }
+        return &slots[off / ptr];
+    }
+};
+
+template <size_t N>
+Table table(const jni::Slot (&s)[N], unsigned first) {
+    return Table{s, N, first};
+}
+
+struct Resolved {
+    uint64_t addr;
+    std::string function;  // containing symbol
+    bool jni;              // containing symbol is Java_* / JNI_*
+    uint32_t offset;
+    bool tail;
+    const jni::Slot *env;
+    const jni::Slot *vm;
+};
+
+bool is_jni_symbol(const std::string &n) {
+    return n.compare(0, 5, "Java_") == 0 || n.compare(0, 4, "JNI_") == 0;
+}
+
+class Functions {
+  public:
+    explicit Functions(const common::ElfFile &elf) {
+        for (const common::ElfSymbol &s : elf.symbols()) {
+            if (s.function() && s.defined() && s.size && !s.name.empty()) {
+                uint64_t start = elf.machine() == common::EM_ARM ? s.value & ~uint64_t(1) : s.value;
+                spans_.push_back({start, start + s.size, &s.name});
+            }
+        }
+        std::sort(spans_.begin(), spans_.end(), [](const Span &a, const Span &b) { return a.start < b.start; });
+    }
+
+    const std::string *containing(uint64_t addr) const {
+        auto it = std::upper_bound(spans_.begin(), spans_.end(), addr,
+                                   [](uint64_t a, const Span &s) { return a < s.start; });
+        while (it != spans_.begin()) {
+            --it;
+            if (addr < it->end) {
+                return it->name;
+            }
+            if (addr - it->start > (uint64_t(1) << 24)) {
+                break;
+            }
+        }
+        return nullptr;
+    }
+
+  private:
+    struct Span {
+        uint64_t start, end;
+        const std::string *name;
+    };
+    std::vector<Span> spans_;
+};
+
+std::vector<Resolved> scan(const Options &opt, const common::ElfFile &elf) {
+    std::vector<Resolved> out;
+    unsigned ptr = elf.pointer_size();
+    Table env = ptr == 8 ? table(jni::JNINativeInterface__64, 4) : table(jni::JNINativeInterface__32, 4);
+    Table vm = ptr == 8 ? table(jni::JNIInvokeInterface__64, 3) : table(jni::JNIInvokeInterface__32, 3);
+    Functions funcs(elf);
+    for (const common::ElfSection &s : elf.sections()) {
+        const uint8_t *code = s.alloc() && s.exec() ? elf.section_data(s) : nullptr;
+        if (!code) {
+            continue;
+        }
+        jni::scan_call_sites(elf.machine(), elf.little_endian(), code, s.size, s.addr, [&](const jni::CallSite &c) {
+            Resolved r{c.addr, std::string(), false, c.offset, c.tail, env.at(c.offset, ptr), vm.at(c.offset, ptr)};
+            if (!r.env && !r.vm) {
+                return;
+            }
+            if (const std::string *f = funcs.containing(c.addr)) {
+                r.function = *f;
+                r.jni = is_jni_symbol(*f);
+            }
+            if (opt.jni_only && !r.jni) {
+                return;
+            }
+            out.push_back(std::move(r));
+        });
+    }
+    std::sort(out.begin(), out.end(), [](const Resolved &a, const Resolved &b) { return a.addr < b.addr; });
+    out.erase(std::unique(out.begin(), out.end(), [](const Resolved &a, const Resolved &b) { return a.addr == b.addr; }),
+              out.end());
+    return out;
+}
+
+bool exports_jni(const common::ElfFile &elf) {
+    for (const common::ElfSymbol &s : elf.symbols()) {
+        if (s.defined() && s.dynamic && is_jni_symbol(s.name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string name_of(const Resolved &r) {
+    std::string n = r.env ? r.env->name : "";
+    if (r.vm) {
+        n += (n.empty() ? "vm:" : "|vm:") + std::string(r.vm->name);
+    }
+    return n;
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::vector<std::string> files = common::collect_files(opt.paths, "jni_calls");
+    std::vector<std::string> text(files.size());
+    std::map<std::string, uint64_t> counts;
+    std::mutex lock;
+    int status = 0;
+
+    common::parallel_for(files.size(), opt.jobs, [&](size_t i) {
+        std::map<std::string, uint64_t> local;
+        std::ostringstream o;
+        try {
+            common::MappedFile f(files[i]);
+            if (!common::ElfFile::is_elf(f.data(), f.size())) {
+                return;
+            }
+            common::ElfFile elf(f.data(), f.size());
+            if (!opt.all && !exports_jni(elf)) {
+                return;
+            }
+            for (const Resolved &r : scan(opt, elf)) {
+                std::string name = name_of(r);
+                if (opt.summary) {
+                    local[name]++;
+                    continue;
+                }
+                char line[128];
+                std::snprintf(line, sizeof line, "\t0x%08" PRIx64 "\t+0x%03x\t%s\t", r.addr, r.offset,
+                              r.jni ? "jni" : "pattern");
+                o << files[i] << line << name << (r.tail ? " (tail)" : "") << '\t'
+                  << (r.function.empty() ? "?" : r.function);
+                if (opt.signatures) {
+                    o << '\t' << (r.env ? r.env->signature : r.vm->signature);
+                }
+                o << '\n';
+            }
+        } catch (const std::exception &e) {
+            std::lock_guard<std::mutex> g(lock);
+            std::fprintf(stderr, "jni_calls: %s: %s\n", files[i].c_str(), e.what());
+            status = 1;
+            return;
+        }
+        std::lock_guard<std::mutex> g(lock);
+        text[i] = o.str();
+        for (const auto &kv : local) {
+            counts[kv.first] += kv.second;
+        }
+    });
+
+    if (opt.summary) {
+        std::vector<std::pair<uint64_t, std::string>> rows;
+        for (const auto &kv : counts) {
+            rows.push_back({kv.second, kv.first});
+        }
+        std::sort(rows.rbegin(), rows.rend());
+        for (const auto &r : rows) {
+            std::printf("%10" PRIu64 "  %s\n", r.first, r.second.c_str());
+        }
+    } else {
+        for (const std::string &t : text) {
+            std::fwrite(t.data(), 1, t.size(), stdout);
+        }
+    }
+    return status;
+}
@@ -0,0 +1,224 @@
+/*
+ *   Recognition of calls through the JNI function tables in machine code.
+ *
+ *   Every JNIEnv/JavaVM call compiles to the same three steps: load the
+ *   table pointer from the interface (env->functions is at offset 0), load a
+ *   slot from the table, call it:
+ *
+ *     AArch64   ldr x8, [x0]           ldr x8, [x8, #0x30]     blr x8 / br x8
+ *     ARM/Thumb ldr r3, [r0]           ldr r3, [r3, #0x18]     blx r3 / bx r3
+ *     x86-64    mov rax, [rdi]                                 call [rax + 0x30]
+ *     i386      mov ecx, [eax]                                 call [ecx + 0x18]
+ *
+ *   The scanners follow which registers hold "*reg" and "(*reg)[off]" over a
+ *   short window and report (address, offset) for each call that completes
+ *   the pattern. This is not a disassembler; C++ virtual calls have the same
+ *   shape, so callers filter offsets against the table sizes (jni_interface.hpp)
+ *   and weigh sites by the function they occur in.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/elf.hpp"
+
+
+namespace jni {
+
+struct CallSite {
+    uint64_t addr;    // of the call instruction
+    uint32_t offset;  // slot offset in the function table
+    bool tail;        // br/bx/jmp rather than a call
+};
+
+namespace detail {
+
+// Byte distance over which a register keeps the value the pattern needs.
+constexpr uint64_t WINDOW = 32;
+constexpr uint64_t NONE = ~uint64_t(0);
+
+inline uint32_t rd32(const uint8_t *p, bool le) {
+    return le ? (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24)
+              : (uint32_t(p[3]) | uint32_t(p[2]) << 8 | uint32_t(p[1]) << 16 | uint32_t(p[0]) << 24);
+}
+
+inline uint16_t rd16(const uint8_t *p, bool le) {
+    return le ? uint16_t(p[0] | p[1] << 8) : uint16_t(p[1] | p[0] << 8);
+}
+
+// Register state shared by the load/load/call recognizers.
+template <unsigned NREGS>
+struct Tracker {
+    uint64_t table_at[NREGS];  // where reg = *base was loaded
+    uint64_t slot_at[NREGS];   // where reg = table[off] was loaded
+    uint32_t slot_off[NREGS];
+
+    Tracker() {
+        std::memset(table_at, 0xff, sizeof table_at);
+        std::memset(slot_at, 0xff, sizeof slot_at);
+    }
+
+    bool live(uint64_t at, uint64_t now) const { return at != NONE && now - at <= WINDOW; }
+
+    // rt = [rn + off]
+    void load(unsigned rt, unsigned rn, uint32_t off, uint64_t now) {
+        bool from_table = live(table_at[rn], now);
+        table_at[rt] = NONE;
+        slot_at[rt] = NONE;
+        if (off == 0) {
+            table_at[rt] = now;
+        } else if (from_table) {
+            slot_at[rt] = now;
+            slot_off[rt] = off;
+        }
+    }
+
+    // call [rn + off]
+    bool call_mem(unsigned rn, uint64_t now) const { return live(table_at[rn], now); }
+
+    // call rm
+    bool call_reg(unsigned rm, uint64_t now, uint32_t &off) const {
+        if (!live(slot_at[rm], now)) {
+            return false;
+        }
+        off = slot_off[rm];
+        return true;
+    }
+};
+
+template <typename Fn>
+void scan_aarch64(const uint8_t *p, size_t n, bool le, uint64_t base, Fn &fn) {
+    Tracker<32> t;
+    for (size_t i = 0; i + 4 <= n; i += 4) {
+        uint32_t w = rd32(p + i, le);
+        if ((w & 0xffc00000) == 0xf9400000) {  // ldr xt, [xn, #imm12*8]
+            t.load(w & 31, (w >> 5) & 31, ((w >> 10) & 0xfff) * 8, i);
+        } else if ((w & 0xfffffc1f) == 0xd63f0000 || (w & 0xfffffc1f) == 0xd61f0000) {  // blr / br
+            uint32_t off;
+            if (t.call_reg((w >> 5) & 31, i, off)) {
+                fn(CallSite{base + i, off, (w & 0x00200000) == 0});
+            }
+        }
+    }
+}
+
+template <typename Fn>
+void scan_a32(const uint8_t *p, size_t n, bool le, uint64_t base, Fn &fn) {
+    Tracker<16> t;
+    for (size_t i = 0; i + 4 <= n; i += 4) {
+        uint32_t w = rd32(p + i, le);
+        if ((w >> 28) == 0xf) {
+            continue;
+        }
+        if ((w & 0x0ff00000) == 0x05900000) {  // ldr rt, [rn, #+imm12]
+            t.load((w >> 12) & 15, (w >> 16) & 15, w & 0xfff, i);
+        } else if ((w & 0x0fffffd0) == 0x012fff10) {  // blx rm / bx rm
+            uint32_t off;
+            if (t.call_reg(w & 15, i, off)) {
+                fn(CallSite{base + i, off, (w & 0x20) == 0});
+            }
+        }
+    }
+}
+
+// Linear sweep; 32-bit Thumb-2 encodings start with 0b11101, 0b11110 or 0b11111.
+template <typename Fn>
+void scan_thumb(const uint8_t *p, size_t n, bool le, uint64_t base, Fn &fn) {
+    Tracker<16> t;
+    for (size_t i = 0; i + 2 <= n;) {
+        uint16_t h = rd16(p + i, le);
+        if ((h & 0xe000) == 0xe000 && (h & 0x1800) != 0) {
+            if (i + 4 > n) {
+                break;
+            }
+            uint16_t h2 = rd16(p + i + 2, le);
+            if ((h & 0xfff0) == 0xf8d0) {  // ldr.w rt, [rn, #imm12]
+                t.load(h2 >> 12, h & 15, h2 & 0xfff, i);
+            }
+            i += 4;
+            continue;
+        }
+        if ((h & 0xf800) == 0x6800) {  // ldr rt, [rn, #imm5*4]
+            t.load(h & 7, (h >> 3) & 7, ((h >> 6) & 31) * 4, i);
+        } else if ((h & 0xff07) == 0x4780 || (h & 0xff07) == 0x4700) {  // blx rm / bx rm
+            uint32_t off;
+            if (t.call_reg((h >> 3) & 15, i, off)) {
+                fn(CallSite{base + i, off, (h & 0x80) == 0});
+            }
+        }
+        i += 2;
+    }
+}
+
+// x86 and x86-64: byte-granular, every offset is tried as an instruction start.
+template <typename Fn>
+void scan_x86(const uint8_t *p, size_t n, bool x64, uint64_t base, Fn &fn) {
+    Tracker<16> t;
+    for (size_t i = 0; i + 2 <= n; i++) {
+        size_t j = i;
+        unsigned rex = 0;
+        if (x64 && (p[j] & 0xf0) == 0x40) {
+            rex = p[j++];
+        }
+        if (j + 2 > n) {
+            break;
+        }
+        uint8_t op = p[j], modrm = p[j + 1];
+        unsigned mod = modrm >> 6, reg = ((modrm >> 3) & 7) | (rex & 4 ? 8 : 0), rm = (modrm & 7) | (rex & 1 ? 8 : 0);
+        if ((modrm & 7) == 4 || (mod == 0 && (modrm & 7) == 5)) {
+            continue;  // SIB or rip/absolute addressing
+        }
+        uint32_t disp = 0;
+        if (mod == 1 && j + 3 <= n) {
+            disp = uint32_t(int32_t(int8_t(p[j + 2])));
+        } else if (mod == 2 && j + 6 <= n) {
+            disp = rd32(p + j + 2, true);
+        } else if (mod != 0 && mod != 3) {
+            continue;
+        }
+        if (op == 0x8b && mod != 3 && (!x64 || (rex & 8))) {  // mov r, [rm + disp]
+            if (int32_t(disp) >= 0) {
+                t.load(reg, rm, disp, i);
+            }
+        } else if (op == 0xff && (((modrm >> 3) & 7) == 2 || ((modrm >> 3) & 7) == 4)) {
+            bool tail = ((modrm >> 3) & 7) == 4;
+            if (mod == 3) {  // call/jmp reg
+                uint32_t off;
+                if (t.call_reg(rm, i, off)) {
+                    fn(CallSite{base + i, off, tail});
+                }
+            } else if (disp != 0 && int32_t(disp) > 0 && t.call_mem(rm, i)) {  // call/jmp [rm + disp]
+                fn(CallSite{base + i, disp, tail});
+            }
+        }
+    }
+}
+
+}  // namespace detail
+
+// Calls fn(CallSite) for every call through a table slot in 'code', which is
+// mapped at 'vaddr'. ARM code is swept both as A32 and as Thumb.
+template <typename Fn>
+void scan_call_sites(uint16_t machine, bool little_endian, const uint8_t *code, size_t n, uint64_t vaddr, Fn &&fn) {
+    switch (machine) {
+    case common::EM_AARCH64:
+        detail::scan_aarch64(code, n, little_endian, vaddr, fn);
+        break;
+    case common::EM_ARM:
+        detail::scan_a32(code, n, little_endian, vaddr, fn);
+        detail::scan_thumb(code, n, little_endian, vaddr, fn);
+        break;
+    case common::EM_X86_64:
+        detail::scan_x86(code, n, true, vaddr, fn);
+        break;
+    case common::EM_386:
+        detail::scan_x86(code, n, false, vaddr, fn);
+        break;
+    default:
+        break;
+    }
+}
+
+}  // namespace jni
@@ -0,0 +1,540 @@
+/*
+ *   Slot tables of jni_all.gdt: JNINativeInterface_, JNIInvokeInterface_ and JNINativeMethod,
+ *   one per pointer width.
+ *
+ *   Generated by tools/gdt/gdt_vtable.cpp; do not edit.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace jni {
+
+struct Slot {
+    uint32_t offset;
+    const char *name;
+    const char *signature;
+};
+
+// JNINativeInterface_, ilp32
+inline constexpr uint32_t JNINativeInterface__32_SIZE = 932;
+inline constexpr Slot JNINativeInterface__32[] = {
+    {0, "reserved0", "void *reserved0"},
+    {4, "reserved1", "void *reserved1"},
+    {8, "reserved2", "void *reserved2"},
+    {12, "reserved3", "void *reserved3"},
+    {16, "GetVersion", "jint GetVersion(JNIEnv *env)"},
+    {20, "DefineClass", "jclass DefineClass(JNIEnv *env, char *name, jobject loader, jbyte *buf, jsize len)"},
+    {24, "FindClass", "jclass FindClass(JNIEnv *env, char *name)"},
+    {28, "FromReflectedMethod", "jmethodID FromReflectedMethod(JNIEnv *env, jobject method)"},
+    {32, "FromReflectedField", "jfieldID FromReflectedField(JNIEnv *env, jobject field)"},
+    {36, "ToReflectedMethod", "jobject ToReflectedMethod(JNIEnv *env, jclass cls, jmethodID methodID, jboolean isStatic)"},
+    {40, "GetSuperclass", "jclass GetSuperclass(JNIEnv *env, jclass sub)"},
+    {44, "IsAssignableFrom", "jboolean IsAssignableFrom(JNIEnv *env, jclass sub, jclass sup)"},
+    {48, "ToReflectedField", "jobject ToReflectedField(JNIEnv *env, jclass cls, jfieldID fieldID, jboolean isStatic)"},
+    {52, "Throw", "jint Throw(JNIEnv *env, jthrowable obj)"},
+    {56, "ThrowNew", "jint ThrowNew(JNIEnv *env, jclass clazz, char *msg)"},
+    {60, "ExceptionOccurred", "jthrowable ExceptionOccurred(JNIEnv *env)"},
+    {64, "ExceptionDescribe", "void ExceptionDescribe(JNIEnv *env)"},
+    {68, "ExceptionClear", "void ExceptionClear(JNIEnv *env)"},
+    {72, "FatalError", "void FatalError(JNIEnv *env, char *msg)"},
+    {76, "PushLocalFrame", "jint PushLocalFrame(JNIEnv *env, jint capacity)"},
+    {80, "PopLocalFrame", "jobject PopLocalFrame(JNIEnv *env, jobject result)"},
+    {84, "NewGlobalRef", "jobject NewGlobalRef(JNIEnv *env, jobject lobj)"},
+    {88, "DeleteGlobalRef", "void DeleteGlobalRef(JNIEnv *env, jobject gref)"},
+    {92, "DeleteLocalRef", "void DeleteLocalRef(JNIEnv *env, jobject obj)"},
+    {96, "IsSameObject", "jboolean IsSameObject(JNIEnv *env, jobject obj1, jobject obj2)"},
+    {100, "NewLocalRef", "jobject NewLocalRef(JNIEnv *env, jobject ref)"},
+    {104, "EnsureLocalCapacity", "jint EnsureLocalCapacity(JNIEnv *env, jint capacity)"},
+    {108, "AllocObject", "jobject AllocObject(JNIEnv *env, jclass clazz)"},
+    {112, "NewObject", "jobject NewObject(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {116, "NewObjectV", "jobject NewObjectV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {120, "NewObjectA", "jobject NewObjectA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {124, "GetObjectClass", "jclass GetObjectClass(JNIEnv *env, jobject obj)"},
+    {128, "IsInstanceOf", "jboolean IsInstanceOf(JNIEnv *env, jobject obj, jclass clazz)"},
+    {132, "GetMethodID", "jmethodID GetMethodID(JNIEnv *env, jclass clazz, char *name, char *sig)"},
+    {136, "CallObjectMethod", "jobject CallObjectMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {140, "CallObjectMethodV", "jobject CallObjectMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {144, "CallObjectMethodA", "jobject CallObjectMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {148, "CallBooleanMethod", "jboolean CallBooleanMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {152, "CallBooleanMethodV", "jboolean CallBooleanMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {156, "CallBooleanMethodA", "jboolean CallBooleanMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {160, "CallByteMethod", "jbyte CallByteMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {164, "CallByteMethodV", "jbyte CallByteMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {168, "CallByteMethodA", "jbyte CallByteMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {172, "CallCharMethod", "jchar CallCharMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {176, "CallCharMethodV", "jchar CallCharMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {180, "CallCharMethodA", "jchar CallCharMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {184, "CallShortMethod", "jshort CallShortMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {188, "CallShortMethodV", "jshort CallShortMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {192, "CallShortMethodA", "jshort CallShortMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {196, "CallIntMethod", "jint CallIntMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {200, "CallIntMethodV", "jint CallIntMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {204, "CallIntMethodA", "jint CallIntMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {208, "CallLongMethod", "jlong CallLongMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {212, "CallLongMethodV", "jlong CallLongMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {216, "CallLongMethodA", "jlong CallLongMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {220, "CallFloatMethod", "jfloat CallFloatMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {224, "CallFloatMethodV", "jfloat CallFloatMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {228, "CallFloatMethodA", "jfloat CallFloatMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {232, "CallDoubleMethod", "jdouble CallDoubleMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {236, "CallDoubleMethodV", "jdouble CallDoubleMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {240, "CallDoubleMethodA", "jdouble CallDoubleMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {244, "CallVoidMethod", "void CallVoidMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {248, "CallVoidMethodV", "void CallVoidMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {252, "CallVoidMethodA", "void CallVoidMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {256, "CallNonvirtualObjectMethod", "jobject CallNonvirtualObjectMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {260, "CallNonvirtualObjectMethodV", "jobject CallNonvirtualObjectMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {264, "CallNonvirtualObjectMethodA", "jobject CallNonvirtualObjectMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {268, "CallNonvirtualBooleanMethod", "jboolean CallNonvirtualBooleanMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {272, "CallNonvirtualBooleanMethodV", "jboolean CallNonvirtualBooleanMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {276, "CallNonvirtualBooleanMethodA", "jboolean CallNonvirtualBooleanMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {280, "CallNonvirtualByteMethod", "jbyte CallNonvirtualByteMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {284, "CallNonvirtualByteMethodV", "jbyte CallNonvirtualByteMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {288, "CallNonvirtualByteMethodA", "jbyte CallNonvirtualByteMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {292, "CallNonvirtualCharMethod", "jchar CallNonvirtualCharMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {296, "CallNonvirtualCharMethodV", "jchar CallNonvirtualCharMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {300, "CallNonvirtualCharMethodA", "jchar CallNonvirtualCharMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {304, "CallNonvirtualShortMethod", "jshort CallNonvirtualShortMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {308, "CallNonvirtualShortMethodV", "jshort CallNonvirtualShortMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {312, "CallNonvirtualShortMethodA", "jshort CallNonvirtualShortMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {316, "CallNonvirtualIntMethod", "jint CallNonvirtualIntMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {320, "CallNonvirtualIntMethodV", "jint CallNonvirtualIntMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {324, "CallNonvirtualIntMethodA", "jint CallNonvirtualIntMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {328, "CallNonvirtualLongMethod", "jlong CallNonvirtualLongMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {332, "CallNonvirtualLongMethodV", "jlong CallNonvirtualLongMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {336, "CallNonvirtualLongMethodA", "jlong CallNonvirtualLongMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {340, "CallNonvirtualFloatMethod", "jfloat CallNonvirtualFloatMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {344, "CallNonvirtualFloatMethodV", "jfloat CallNonvirtualFloatMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {348, "CallNonvirtualFloatMethodA", "jfloat CallNonvirtualFloatMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {352, "CallNonvirtualDoubleMethod", "jdouble CallNonvirtualDoubleMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {356, "CallNonvirtualDoubleMethodV", "jdouble CallNonvirtualDoubleMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {360, "CallNonvirtualDoubleMethodA", "jdouble CallNonvirtualDoubleMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {364, "CallNonvirtualVoidMethod", "void CallNonvirtualVoidMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {368, "CallNonvirtualVoidMethodV", "void CallNonvirtualVoidMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {372, "CallNonvirtualVoidMethodA", "void CallNonvirtualVoidMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {376, "GetFieldID", "jfieldID GetFieldID(JNIEnv *env, jclass clazz, char *name, char *sig)"},
+    {380, "GetObjectField", "jobject GetObjectField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {384, "GetBooleanField", "jboolean GetBooleanField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {388, "GetByteField", "jbyte GetByteField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {392, "GetCharField", "jchar GetCharField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {396, "GetShortField", "jshort GetShortField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {400, "GetIntField", "jint GetIntField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {404, "GetLongField", "jlong GetLongField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {408, "GetFloatField", "jfloat GetFloatField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {412, "GetDoubleField", "jdouble GetDoubleField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {416, "SetObjectField", "void SetObjectField(JNIEnv *env, jobject obj, jfieldID fieldID, jobject val)"},
+    {420, "SetBooleanField", "void SetBooleanField(JNIEnv *env, jobject obj, jfieldID fieldID, jboolean val)"},
+    {424, "SetByteField", "void SetByteField(JNIEnv *env, jobject obj, jfieldID fieldID, jbyte val)"},
+    {428, "SetCharField", "void SetCharField(JNIEnv *env, jobject obj, jfieldID fieldID, jchar val)"},
+    {432, "SetShortField", "void SetShortField(JNIEnv *env, jobject obj, jfieldID fieldID, jshort val)"},
+    {436, "SetIntField", "void SetIntField(JNIEnv *env, jobject obj, jfieldID fieldID, jint val)"},
+    {440, "SetLongField", "void SetLongField(JNIEnv *env, jobject obj, jfieldID fieldID, jlong val)"},
+    {444, "SetFloatField", "void SetFloatField(JNIEnv *env, jobject obj, jfieldID fieldID, jfloat val)"},
+    {448, "SetDoubleField", "void SetDoubleField(JNIEnv *env, jobject obj, jfieldID fieldID, jdouble val)"},
+    {452, "GetStaticMethodID", "jmethodID GetStaticMethodID(JNIEnv *env, jclass clazz, char *name, char *sig)"},
+    {456, "CallStaticObjectMethod", "jobject CallStaticObjectMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {460, "CallStaticObjectMethodV", "jobject CallStaticObjectMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {464, "CallStaticObjectMethodA", "jobject CallStaticObjectMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {468, "CallStaticBooleanMethod", "jboolean CallStaticBooleanMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {472, "CallStaticBooleanMethodV", "jboolean CallStaticBooleanMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {476, "CallStaticBooleanMethodA", "jboolean CallStaticBooleanMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {480, "CallStaticByteMethod", "jbyte CallStaticByteMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {484, "CallStaticByteMethodV", "jbyte CallStaticByteMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {488, "CallStaticByteMethodA", "jbyte CallStaticByteMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {492, "CallStaticCharMethod", "jchar CallStaticCharMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {496, "CallStaticCharMethodV", "jchar CallStaticCharMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {500, "CallStaticCharMethodA", "jchar CallStaticCharMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {504, "CallStaticShortMethod", "jshort CallStaticShortMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {508, "CallStaticShortMethodV", "jshort CallStaticShortMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {512, "CallStaticShortMethodA", "jshort CallStaticShortMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {516, "CallStaticIntMethod", "jint CallStaticIntMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {520, "CallStaticIntMethodV", "jint CallStaticIntMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {524, "CallStaticIntMethodA", "jint CallStaticIntMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {528, "CallStaticLongMethod", "jlong CallStaticLongMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {532, "CallStaticLongMethodV", "jlong CallStaticLongMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {536, "CallStaticLongMethodA", "jlong CallStaticLongMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {540, "CallStaticFloatMethod", "jfloat CallStaticFloatMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {544, "CallStaticFloatMethodV", "jfloat CallStaticFloatMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {548, "CallStaticFloatMethodA", "jfloat CallStaticFloatMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {552, "CallStaticDoubleMethod", "jdouble CallStaticDoubleMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {556, "CallStaticDoubleMethodV", "jdouble CallStaticDoubleMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {560, "CallStaticDoubleMethodA", "jdouble CallStaticDoubleMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {564, "CallStaticVoidMethod", "void CallStaticVoidMethod(JNIEnv *env, jclass cls, jmethodID methodID, ...)"},
+    {568, "CallStaticVoidMethodV", "void CallStaticVoidMethodV(JNIEnv *env, jclass cls, jmethodID methodID, void *args)"},
+    {572, "CallStaticVoidMethodA", "void CallStaticVoidMethodA(JNIEnv *env, jclass cls, jmethodID methodID, jvalue *args)"},
+    {576, "GetStaticFieldID", "jfieldID GetStaticFieldID(JNIEnv *env, jclass clazz, char *name, char *sig)"},
+    {580, "GetStaticObjectField", "jobject GetStaticObjectField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {584, "GetStaticBooleanField", "jboolean GetStaticBooleanField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {588, "GetStaticByteField", "jbyte GetStaticByteField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {592, "GetStaticCharField", "jchar GetStaticCharField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {596, "GetStaticShortField", "jshort GetStaticShortField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {600, "GetStaticIntField", "jint GetStaticIntField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {604, "GetStaticLongField", "jlong GetStaticLongField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {608, "GetStaticFloatField", "jfloat GetStaticFloatField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {612, "GetStaticDoubleField", "jdouble GetStaticDoubleField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {616, "SetStaticObjectField", "void SetStaticObjectField(JNIEnv *env, jclass clazz, jfieldID fieldID, jobject value)"},
+    {620, "SetStaticBooleanField", "void SetStaticBooleanField(JNIEnv *env, jclass clazz, jfieldID fieldID, jboolean value)"},
+    {624, "SetStaticByteField", "void SetStaticByteField(JNIEnv *env, jclass clazz, jfieldID fieldID, jbyte value)"},
+    {628, "SetStaticCharField", "void SetStaticCharField(JNIEnv *env, jclass clazz, jfieldID fieldID, jchar value)"},
+    {632, "SetStaticShortField", "void SetStaticShortField(JNIEnv *env, jclass clazz, jfieldID fieldID, jshort value)"},
+    {636, "SetStaticIntField", "void SetStaticIntField(JNIEnv *env, jclass clazz, jfieldID fieldID, jint value)"},
+    {640, "SetStaticLongField", "void SetStaticLongField(JNIEnv *env, jclass clazz, jfieldID fieldID, jlong value)"},
+    {644, "SetStaticFloatField", "void SetStaticFloatField(JNIEnv *env, jclass clazz, jfieldID fieldID, jfloat value)"},
+    {648, "SetStaticDoubleField", "void SetStaticDoubleField(JNIEnv *env, jclass clazz, jfieldID fieldID, jdouble value)"},
+    {652, "NewString", "jstring NewString(JNIEnv *env, jchar *unicode, jsize len)"},
+    {656, "GetStringLength", "jsize GetStringLength(JNIEnv *env, jstring str)"},
+    {660, "GetStringChars", "jchar *GetStringChars(JNIEnv *env, jstring str, jboolean *isCopy)"},
+    {664, "ReleaseStringChars", "void ReleaseStringChars(JNIEnv *env, jstring str, jchar *chars)"},
+    {668, "NewStringUTF", "jstring NewStringUTF(JNIEnv *env, char *utf)"},
+    {672, "GetStringUTFLength", "jsize GetStringUTFLength(JNIEnv *env, jstring str)"},
+    {676, "GetStringUTFChars", "char *GetStringUTFChars(JNIEnv *env, jstring str, jboolean *isCopy)"},
+    {680, "ReleaseStringUTFChars", "void ReleaseStringUTFChars(JNIEnv *env, jstring str, char *chars)"},
+    {684, "GetArrayLength", "jsize GetArrayLength(JNIEnv *env, jarray array)"},
+    {688, "NewObjectArray", "jobjectArray NewObjectArray(JNIEnv *env, jsize len, jclass clazz, jobject init)"},
+    {692, "GetObjectArrayElement", "jobject GetObjectArrayElement(JNIEnv *env, jobjectArray array, jsize index)"},
+    {696, "SetObjectArrayElement", "void SetObjectArrayElement(JNIEnv *env, jobjectArray array, jsize index, jobject val)"},
+    {700, "NewBooleanArray", "jbooleanArray NewBooleanArray(JNIEnv *env, jsize len)"},
+    {704, "NewByteArray", "jbyteArray NewByteArray(JNIEnv *env, jsize len)"},
+    {708, "NewCharArray", "jcharArray NewCharArray(JNIEnv *env, jsize len)"},
+    {712, "NewShortArray", "jshortArray NewShortArray(JNIEnv *env, jsize len)"},
+    {716, "NewIntArray", "jintArray NewIntArray(JNIEnv *env, jsize len)"},
+    {720, "NewLongArray", "jlongArray NewLongArray(JNIEnv *env, jsize len)"},
+    {724, "NewFloatArray", "jfloatArray NewFloatArray(JNIEnv *env, jsize len)"},
+    {728, "NewDoubleArray", "jdoubleArray NewDoubleArray(JNIEnv *env, jsize len)"},
+    {732, "GetBooleanArrayElements", "jboolean *GetBooleanArrayElements(JNIEnv *env, jbooleanArray array, jboolean *isCopy)"},
+    {736, "GetByteArrayElements", "jbyte *GetByteArrayElements(JNIEnv *env, jbyteArray array, jboolean *isCopy)"},
+    {740, "GetCharArrayElements", "jchar *GetCharArrayElements(JNIEnv *env, jcharArray array, jboolean *isCopy)"},
+    {744, "GetShortArrayElements", "jshort *GetShortArrayElements(JNIEnv *env, jshortArray array, jboolean *isCopy)"},
+    {748, "GetIntArrayElements", "jint *GetIntArrayElements(JNIEnv *env, jintArray array, jboolean *isCopy)"},
+    {752, "GetLongArrayElements", "jlong *GetLongArrayElements(JNIEnv *env, jlongArray array, jboolean *isCopy)"},
+    {756, "GetFloatArrayElements", "jfloat *GetFloatArrayElements(JNIEnv *env, jfloatArray array, jboolean *isCopy)"},
+    {760, "GetDoubleArrayElements", "jdouble *GetDoubleArrayElements(JNIEnv *env, jdoubleArray array, jboolean *isCopy)"},
+    {764, "ReleaseBooleanArrayElements", "void ReleaseBooleanArrayElements(JNIEnv *env, jbooleanArray array, jboolean *elems, jint mode)"},
+    {768, "ReleaseByteArrayElements", "void ReleaseByteArrayElements(JNIEnv *env, jbyteArray array, jbyte *elems, jint mode)"},
+    {772, "ReleaseCharArrayElements", "void ReleaseCharArrayElements(JNIEnv *env, jcharArray array, jchar *elems, jint mode)"},
+    {776, "ReleaseShortArrayElements", "void ReleaseShortArrayElements(JNIEnv *env, jshortArray array, jshort *elems, jint mode)"},
+    {780, "ReleaseIntArrayElements", "void ReleaseIntArrayElements(JNIEnv *env, jintArray array, jint *elems, jint mode)"},
+    {784, "ReleaseLongArrayElements", "void ReleaseLongArrayElements(JNIEnv *env, jlongArray array, jlong *elems, jint mode)"},
+    {788, "ReleaseFloatArrayElements", "void ReleaseFloatArrayElements(JNIEnv *env, jfloatArray array, jfloat *elems, jint mode)"},
+    {792, "ReleaseDoubleArrayElements", "void ReleaseDoubleArrayElements(JNIEnv *env, jdoubleArray array, jdouble *elems, jint mode)"},
+    {796, "GetBooleanArrayRegion", "void GetBooleanArrayRegion(JNIEnv *env, jbooleanArray array, jsize start, jsize l, jboolean *buf)"},
+    {800, "GetByteArrayRegion", "void GetByteArrayRegion(JNIEnv *env, jbyteArray array, jsize start, jsize len, jbyte *buf)"},
+    {804, "GetCharArrayRegion", "void GetCharArrayRegion(JNIEnv *env, jcharArray array, jsize start, jsize len, jchar *buf)"},
+    {808, "GetShortArrayRegion", "void GetShortArrayRegion(JNIEnv *env, jshortArray array, jsize start, jsize len, jshort *buf)"},
+    {812, "GetIntArrayRegion", "void GetIntArrayRegion(JNIEnv *env, jintArray array, jsize start, jsize len, jint *buf)"},
+    {816, "GetLongArrayRegion", "void GetLongArrayRegion(JNIEnv *env, jlongArray array, jsize start, jsize len, jlong *buf)"},
+    {820, "GetFloatArrayRegion", "void GetFloatArrayRegion(JNIEnv *env, jfloatArray array, jsize start, jsize len, jfloat *buf)"},
+    {824, "GetDoubleArrayRegion", "void GetDoubleArrayRegion(JNIEnv *env, jdoubleArray array, jsize start, jsize len, jdouble *buf)"},
+    {828, "SetBooleanArrayRegion", "void SetBooleanArrayRegion(JNIEnv *env, jbooleanArray array, jsize start, jsize l, jboolean *buf)"},
+    {832, "SetByteArrayRegion", "void SetByteArrayRegion(JNIEnv *env, jbyteArray array, jsize start, jsize len, jbyte *buf)"},
+    {836, "SetCharArrayRegion", "void SetCharArrayRegion(JNIEnv *env, jcharArray array, jsize start, jsize len, jchar *buf)"},
+    {840, "SetShortArrayRegion", "void SetShortArrayRegion(JNIEnv *env, jshortArray array, jsize start, jsize len, jshort *buf)"},
+    {844, "SetIntArrayRegion", "void SetIntArrayRegion(JNIEnv *env, jintArray array, jsize start, jsize len, jint *buf)"},
+    {848, "SetLongArrayRegion", "void SetLongArrayRegion(JNIEnv *env, jlongArray array, jsize start, jsize len, jlong *buf)"},
+    {852, "SetFloatArrayRegion", "void SetFloatArrayRegion(JNIEnv *env, jfloatArray array, jsize start, jsize len, jfloat *buf)"},
+    {856, "SetDoubleArrayRegion", "void SetDoubleArrayRegion(JNIEnv *env, jdoubleArray array, jsize start, jsize len, jdouble *buf)"},
+    {860, "RegisterNatives", "jint RegisterNatives(JNIEnv *env, jclass clazz, JNINativeMethod *methods, jint nMethods)"},
+    {864, "UnregisterNatives", "jint UnregisterNatives(JNIEnv *env, jclass clazz)"},
+    {868, "MonitorEnter", "jint MonitorEnter(JNIEnv *env, jobject obj)"},
+    {872, "MonitorExit", "jint MonitorExit(JNIEnv *env, jobject obj)"},
+    {876, "GetJavaVM", "jint GetJavaVM(JNIEnv *env, JavaVM **vm)"},
+    {880, "GetStringRegion", "void GetStringRegion(JNIEnv *env, jstring str, jsize start, jsize len, jchar *buf)"},
+    {884, "GetStringUTFRegion", "void GetStringUTFRegion(JNIEnv *env, jstring str, jsize start, jsize len, char *buf)"},
+    {888, "GetPrimitiveArrayCritical", "void *GetPrimitiveArrayCritical(JNIEnv *env, jarray array, jboolean *isCopy)"},
+    {892, "ReleasePrimitiveArrayCritical", "void ReleasePrimitiveArrayCritical(JNIEnv *env, jarray array, void *carray, jint mode)"},
+    {896, "GetStringCritical", "jchar *GetStringCritical(JNIEnv *env, jstring string, jboolean *isCopy)"},
+    {900, "ReleaseStringCritical", "void ReleaseStringCritical(JNIEnv *env, jstring string, jchar *cstring)"},
+    {904, "NewWeakGlobalRef", "jweak NewWeakGlobalRef(JNIEnv *env, jobject obj)"},
+    {908, "DeleteWeakGlobalRef", "void DeleteWeakGlobalRef(JNIEnv *env, jweak ref)"},
+    {912, "ExceptionCheck", "jboolean ExceptionCheck(JNIEnv *env)"},
+    {916, "NewDirectByteBuffer", "jobject NewDirectByteBuffer(JNIEnv *env, void *address, jlong capacity)"},
+    {920, "GetDirectBufferAddress", "void *GetDirectBufferAddress(JNIEnv *env, jobject buf)"},
+    {924, "GetDirectBufferCapacity", "jlong GetDirectBufferCapacity(JNIEnv *env, jobject buf)"},
+    {928, "GetObjectRefType", "jobjectRefType GetObjectRefType(JNIEnv *env, jobject obj)"},
+};
+
+// JNINativeInterface_, lp64
+inline constexpr uint32_t JNINativeInterface__64_SIZE = 1864;
+inline constexpr Slot JNINativeInterface__64[] = {
+    {0, "reserved0", "void *reserved0"},
+    {8, "reserved1", "void *reserved1"},
+    {16, "reserved2", "void *reserved2"},
+    {24, "reserved3", "void *reserved3"},
+    {32, "GetVersion", "jint GetVersion(JNIEnv *env)"},
+    {40, "DefineClass", "jclass DefineClass(JNIEnv *env, char *name, jobject loader, jbyte *buf, jsize len)"},
+    {48, "FindClass", "jclass FindClass(JNIEnv *env, char *name)"},
+    {56, "FromReflectedMethod", "jmethodID FromReflectedMethod(JNIEnv *env, jobject method)"},
+    {64, "FromReflectedField", "jfieldID FromReflectedField(JNIEnv *env, jobject field)"},
+    {72, "ToReflectedMethod", "jobject ToReflectedMethod(JNIEnv *env, jclass cls, jmethodID methodID, jboolean isStatic)"},
+    {80, "GetSuperclass", "jclass GetSuperclass(JNIEnv *env, jclass sub)"},
+    {88, "IsAssignableFrom", "jboolean IsAssignableFrom(JNIEnv *env, jclass sub, jclass sup)"},
+    {96, "ToReflectedField", "jobject ToReflectedField(JNIEnv *env, jclass cls, jfieldID fieldID, jboolean isStatic)"},
+    {104, "Throw", "jint Throw(JNIEnv *env, jthrowable obj)"},
+    {112, "ThrowNew", "jint ThrowNew(JNIEnv *env, jclass clazz, char *msg)"},
+    {120, "ExceptionOccurred", "jthrowable ExceptionOccurred(JNIEnv *env)"},
+    {128, "ExceptionDescribe", "void ExceptionDescribe(JNIEnv *env)"},
+    {136, "ExceptionClear", "void ExceptionClear(JNIEnv *env)"},
+    {144, "FatalError", "void FatalError(JNIEnv *env, char *msg)"},
+    {152, "PushLocalFrame", "jint PushLocalFrame(JNIEnv *env, jint capacity)"},
+    {160, "PopLocalFrame", "jobject PopLocalFrame(JNIEnv *env, jobject result)"},
+    {168, "NewGlobalRef", "jobject NewGlobalRef(JNIEnv *env, jobject lobj)"},
+    {176, "DeleteGlobalRef", "void DeleteGlobalRef(JNIEnv *env, jobject gref)"},
+    {184, "DeleteLocalRef", "void DeleteLocalRef(JNIEnv *env, jobject obj)"},
+    {192, "IsSameObject", "jboolean IsSameObject(JNIEnv *env, jobject obj1, jobject obj2)"},
+    {200, "NewLocalRef", "jobject NewLocalRef(JNIEnv *env, jobject ref)"},
+    {208, "EnsureLocalCapacity", "jint EnsureLocalCapacity(JNIEnv *env, jint capacity)"},
+    {216, "AllocObject", "jobject AllocObject(JNIEnv *env, jclass clazz)"},
+    {224, "NewObject", "jobject NewObject(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {232, "NewObjectV", "jobject NewObjectV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {240, "NewObjectA", "jobject NewObjectA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {248, "GetObjectClass", "jclass GetObjectClass(JNIEnv *env, jobject obj)"},
+    {256, "IsInstanceOf", "jboolean IsInstanceOf(JNIEnv *env, jobject obj, jclass clazz)"},
+    {264, "GetMethodID", "jmethodID GetMethodID(JNIEnv *env, jclass clazz, char *name, char *sig)"},
+    {272, "CallObjectMethod", "jobject CallObjectMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {280, "CallObjectMethodV", "jobject CallObjectMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {288, "CallObjectMethodA", "jobject CallObjectMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {296, "CallBooleanMethod", "jboolean CallBooleanMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {304, "CallBooleanMethodV", "jboolean CallBooleanMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {312, "CallBooleanMethodA", "jboolean CallBooleanMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {320, "CallByteMethod", "jbyte CallByteMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {328, "CallByteMethodV", "jbyte CallByteMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {336, "CallByteMethodA", "jbyte CallByteMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {344, "CallCharMethod", "jchar CallCharMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {352, "CallCharMethodV", "jchar CallCharMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {360, "CallCharMethodA", "jchar CallCharMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {368, "CallShortMethod", "jshort CallShortMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {376, "CallShortMethodV", "jshort CallShortMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {384, "CallShortMethodA", "jshort CallShortMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {392, "CallIntMethod", "jint CallIntMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {400, "CallIntMethodV", "jint CallIntMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {408, "CallIntMethodA", "jint CallIntMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {416, "CallLongMethod", "jlong CallLongMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {424, "CallLongMethodV", "jlong CallLongMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {432, "CallLongMethodA", "jlong CallLongMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {440, "CallFloatMethod", "jfloat CallFloatMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {448, "CallFloatMethodV", "jfloat CallFloatMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {456, "CallFloatMethodA", "jfloat CallFloatMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {464, "CallDoubleMethod", "jdouble CallDoubleMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {472, "CallDoubleMethodV", "jdouble CallDoubleMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {480, "CallDoubleMethodA", "jdouble CallDoubleMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {488, "CallVoidMethod", "void CallVoidMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)"},
+    {496, "CallVoidMethodV", "void CallVoidMethodV(JNIEnv *env, jobject obj, jmethodID methodID, void *args)"},
+    {504, "CallVoidMethodA", "void CallVoidMethodA(JNIEnv *env, jobject obj, jmethodID methodID, jvalue *args)"},
+    {512, "CallNonvirtualObjectMethod", "jobject CallNonvirtualObjectMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {520, "CallNonvirtualObjectMethodV", "jobject CallNonvirtualObjectMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {528, "CallNonvirtualObjectMethodA", "jobject CallNonvirtualObjectMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {536, "CallNonvirtualBooleanMethod", "jboolean CallNonvirtualBooleanMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {544, "CallNonvirtualBooleanMethodV", "jboolean CallNonvirtualBooleanMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {552, "CallNonvirtualBooleanMethodA", "jboolean CallNonvirtualBooleanMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {560, "CallNonvirtualByteMethod", "jbyte CallNonvirtualByteMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {568, "CallNonvirtualByteMethodV", "jbyte CallNonvirtualByteMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {576, "CallNonvirtualByteMethodA", "jbyte CallNonvirtualByteMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {584, "CallNonvirtualCharMethod", "jchar CallNonvirtualCharMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {592, "CallNonvirtualCharMethodV", "jchar CallNonvirtualCharMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {600, "CallNonvirtualCharMethodA", "jchar CallNonvirtualCharMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {608, "CallNonvirtualShortMethod", "jshort CallNonvirtualShortMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {616, "CallNonvirtualShortMethodV", "jshort CallNonvirtualShortMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {624, "CallNonvirtualShortMethodA", "jshort CallNonvirtualShortMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {632, "CallNonvirtualIntMethod", "jint CallNonvirtualIntMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {640, "CallNonvirtualIntMethodV", "jint CallNonvirtualIntMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {648, "CallNonvirtualIntMethodA", "jint CallNonvirtualIntMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {656, "CallNonvirtualLongMethod", "jlong CallNonvirtualLongMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {664, "CallNonvirtualLongMethodV", "jlong CallNonvirtualLongMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {672, "CallNonvirtualLongMethodA", "jlong CallNonvirtualLongMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {680, "CallNonvirtualFloatMethod", "jfloat CallNonvirtualFloatMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {688, "CallNonvirtualFloatMethodV", "jfloat CallNonvirtualFloatMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {696, "CallNonvirtualFloatMethodA", "jfloat CallNonvirtualFloatMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {704, "CallNonvirtualDoubleMethod", "jdouble CallNonvirtualDoubleMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {712, "CallNonvirtualDoubleMethodV", "jdouble CallNonvirtualDoubleMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {720, "CallNonvirtualDoubleMethodA", "jdouble CallNonvirtualDoubleMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {728, "CallNonvirtualVoidMethod", "void CallNonvirtualVoidMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...)"},
+    {736, "CallNonvirtualVoidMethodV", "void CallNonvirtualVoidMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, void *args)"},
+    {744, "CallNonvirtualVoidMethodA", "void CallNonvirtualVoidMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {752, "GetFieldID", "jfieldID GetFieldID(JNIEnv *env, jclass clazz, char *name, char *sig)"},
+    {760, "GetObjectField", "jobject GetObjectField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {768, "GetBooleanField", "jboolean GetBooleanField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {776, "GetByteField", "jbyte GetByteField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {784, "GetCharField", "jchar GetCharField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {792, "GetShortField", "jshort GetShortField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {800, "GetIntField", "jint GetIntField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {808, "GetLongField", "jlong GetLongField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {816, "GetFloatField", "jfloat GetFloatField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {824, "GetDoubleField", "jdouble GetDoubleField(JNIEnv *env, jobject obj, jfieldID fieldID)"},
+    {832, "SetObjectField", "void SetObjectField(JNIEnv *env, jobject obj, jfieldID fieldID, jobject val)"},
+    {840, "SetBooleanField", "void SetBooleanField(JNIEnv *env, jobject obj, jfieldID fieldID, jboolean val)"},
+    {848, "SetByteField", "void SetByteField(JNIEnv *env, jobject obj, jfieldID fieldID, jbyte val)"},
+    {856, "SetCharField", "void SetCharField(JNIEnv *env, jobject obj, jfieldID fieldID, jchar val)"},
+    {864, "SetShortField", "void SetShortField(JNIEnv *env, jobject obj, jfieldID fieldID, jshort val)"},
+    {872, "SetIntField", "void SetIntField(JNIEnv *env, jobject obj, jfieldID fieldID, jint val)"},
+    {880, "SetLongField", "void SetLongField(JNIEnv *env, jobject obj, jfieldID fieldID, jlong val)"},
+    {888, "SetFloatField", "void SetFloatField(JNIEnv *env, jobject obj, jfieldID fieldID, jfloat val)"},
+    {896, "SetDoubleField", "void SetDoubleField(JNIEnv *env, jobject obj, jfieldID fieldID, jdouble val)"},
+    {904, "GetStaticMethodID", "jmethodID GetStaticMethodID(JNIEnv *env, jclass clazz, char *name, char *sig)"},
+    {912, "CallStaticObjectMethod", "jobject CallStaticObjectMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {920, "CallStaticObjectMethodV", "jobject CallStaticObjectMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {928, "CallStaticObjectMethodA", "jobject CallStaticObjectMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {936, "CallStaticBooleanMethod", "jboolean CallStaticBooleanMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {944, "CallStaticBooleanMethodV", "jboolean CallStaticBooleanMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {952, "CallStaticBooleanMethodA", "jboolean CallStaticBooleanMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {960, "CallStaticByteMethod", "jbyte CallStaticByteMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {968, "CallStaticByteMethodV", "jbyte CallStaticByteMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {976, "CallStaticByteMethodA", "jbyte CallStaticByteMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {984, "CallStaticCharMethod", "jchar CallStaticCharMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {992, "CallStaticCharMethodV", "jchar CallStaticCharMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {1000, "CallStaticCharMethodA", "jchar CallStaticCharMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {1008, "CallStaticShortMethod", "jshort CallStaticShortMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {1016, "CallStaticShortMethodV", "jshort CallStaticShortMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {1024, "CallStaticShortMethodA", "jshort CallStaticShortMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {1032, "CallStaticIntMethod", "jint CallStaticIntMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {1040, "CallStaticIntMethodV", "jint CallStaticIntMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {1048, "CallStaticIntMethodA", "jint CallStaticIntMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {1056, "CallStaticLongMethod", "jlong CallStaticLongMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {1064, "CallStaticLongMethodV", "jlong CallStaticLongMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {1072, "CallStaticLongMethodA", "jlong CallStaticLongMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {1080, "CallStaticFloatMethod", "jfloat CallStaticFloatMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {1088, "CallStaticFloatMethodV", "jfloat CallStaticFloatMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {1096, "CallStaticFloatMethodA", "jfloat CallStaticFloatMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {1104, "CallStaticDoubleMethod", "jdouble CallStaticDoubleMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)"},
+    {1112, "CallStaticDoubleMethodV", "jdouble CallStaticDoubleMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, void *args)"},
+    {1120, "CallStaticDoubleMethodA", "jdouble CallStaticDoubleMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, jvalue *args)"},
+    {1128, "CallStaticVoidMethod", "void CallStaticVoidMethod(JNIEnv *env, jclass cls, jmethodID methodID, ...)"},
+    {1136, "CallStaticVoidMethodV", "void CallStaticVoidMethodV(JNIEnv *env, jclass cls, jmethodID methodID, void *args)"},
+    {1144, "CallStaticVoidMethodA", "void CallStaticVoidMethodA(JNIEnv *env, jclass cls, jmethodID methodID, jvalue *args)"},
+    {1152, "GetStaticFieldID", "jfieldID GetStaticFieldID(JNIEnv *env, jclass clazz, char *name, char *sig)"},
+    {1160, "GetStaticObjectField", "jobject GetStaticObjectField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {1168, "GetStaticBooleanField", "jboolean GetStaticBooleanField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {1176, "GetStaticByteField", "jbyte GetStaticByteField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {1184, "GetStaticCharField", "jchar GetStaticCharField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {1192, "GetStaticShortField", "jshort GetStaticShortField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {1200, "GetStaticIntField", "jint GetStaticIntField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {1208, "GetStaticLongField", "jlong GetStaticLongField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {1216, "GetStaticFloatField", "jfloat GetStaticFloatField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {1224, "GetStaticDoubleField", "jdouble GetStaticDoubleField(JNIEnv *env, jclass clazz, jfieldID fieldID)"},
+    {1232, "SetStaticObjectField", "void SetStaticObjectField(JNIEnv *env, jclass clazz, jfieldID fieldID, jobject value)"},
+    {1240, "SetStaticBooleanField", "void SetStaticBooleanField(JNIEnv *env, jclass clazz, jfieldID fieldID, jboolean value)"},
+    {1248, "SetStaticByteField", "void SetStaticByteField(JNIEnv *env, jclass clazz, jfieldID fieldID, jbyte value)"},
+    {1256, "SetStaticCharField", "void SetStaticCharField(JNIEnv *env, jclass clazz, jfieldID fieldID, jchar value)"},
+    {1264, "SetStaticShortField", "void SetStaticShortField(JNIEnv *env, jclass clazz, jfieldID fieldID, jshort value)"},
+    {1272, "SetStaticIntField", "void SetStaticIntField(JNIEnv *env, jclass clazz, jfieldID fieldID, jint value)"},
+    {1280, "SetStaticLongField", "void SetStaticLongField(JNIEnv *env, jclass clazz, jfieldID fieldID, jlong value)"},
+    {1288, "SetStaticFloatField", "void SetStaticFloatField(JNIEnv *env, jclass clazz, jfieldID fieldID, jfloat value)"},
+    {1296, "SetStaticDoubleField", "void SetStaticDoubleField(JNIEnv *env, jclass clazz, jfieldID fieldID, jdouble value)"},
+    {1304, "NewString", "jstring NewString(JNIEnv *env, jchar *unicode, jsize len)"},
+    {1312, "GetStringLength", "jsize GetStringLength(JNIEnv *env, jstring str)"},
+    {1320, "GetStringChars", "jchar *GetStringChars(JNIEnv *env, jstring str, jboolean *isCopy)"},
+    {1328, "ReleaseStringChars", "void ReleaseStringChars(JNIEnv *env, jstring str, jchar *chars)"},
+    {1336, "NewStringUTF", "jstring NewStringUTF(JNIEnv *env, char *utf)"},
+    {1344, "GetStringUTFLength", "jsize GetStringUTFLength(JNIEnv *env, jstring str)"},
+    {1352, "GetStringUTFChars", "char *GetStringUTFChars(JNIEnv *env, jstring str, jboolean *isCopy)"},
+    {1360, "ReleaseStringUTFChars", "void ReleaseStringUTFChars(JNIEnv *env, jstring str, char *chars)"},
+    {1368, "GetArrayLength", "jsize GetArrayLength(JNIEnv *env, jarray array)"},
+    {1376, "NewObjectArray", "jobjectArray NewObjectArray(JNIEnv *env, jsize len, jclass clazz, jobject init)"},
+    {1384, "GetObjectArrayElement", "jobject GetObjectArrayElement(JNIEnv *env, jobjectArray array, jsize index)"},
+    {1392, "SetObjectArrayElement", "void SetObjectArrayElement(JNIEnv *env, jobjectArray array, jsize index, jobject val)"},
+    {1400, "NewBooleanArray", "jbooleanArray NewBooleanArray(JNIEnv *env, jsize len)"},
+    {1408, "NewByteArray", "jbyteArray NewByteArray(JNIEnv *env, jsize len)"},
+    {1416, "NewCharArray", "jcharArray NewCharArray(JNIEnv *env, jsize len)"},
+    {1424, "NewShortArray", "jshortArray NewShortArray(JNIEnv *env, jsize len)"},
+    {1432, "NewIntArray", "jintArray NewIntArray(JNIEnv *env, jsize len)"},
+    {1440, "NewLongArray", "jlongArray NewLongArray(JNIEnv *env, jsize len)"},
+    {1448, "NewFloatArray", "jfloatArray NewFloatArray(JNIEnv *env, jsize len)"},
+    {1456, "NewDoubleArray", "jdoubleArray NewDoubleArray(JNIEnv *env, jsize len)"},
+    {1464, "GetBooleanArrayElements", "jboolean *GetBooleanArrayElements(JNIEnv *env, jbooleanArray array, jboolean *isCopy)"},
+    {1472, "GetByteArrayElements", "jbyte *GetByteArrayElements(JNIEnv *env, jbyteArray array, jboolean *isCopy)"},
+    {1480, "GetCharArrayElements", "jchar *GetCharArrayElements(JNIEnv *env, jcharArray array, jboolean *isCopy)"},
+    {1488, "GetShortArrayElements", "jshort *GetShortArrayElements(JNIEnv *env, jshortArray array, jboolean *isCopy)"},
+    {1496, "GetIntArrayElements", "jint *GetIntArrayElements(JNIEnv *env, jintArray array, jboolean *isCopy)"},
+    {1504, "GetLongArrayElements", "jlong *GetLongArrayElements(JNIEnv *env, jlongArray array, jboolean *isCopy)"},
+    {1512, "GetFloatArrayElements", "jfloat *GetFloatArrayElements(JNIEnv *env, jfloatArray array, jboolean *isCopy)"},
+    {1520, "GetDoubleArrayElements", "jdouble *GetDoubleArrayElements(JNIEnv *env, jdoubleArray array, jboolean *isCopy)"},
+    {1528, "ReleaseBooleanArrayElements", "void ReleaseBooleanArrayElements(JNIEnv *env, jbooleanArray array, jboolean *elems, jint mode)"},
+    {1536, "ReleaseByteArrayElements", "void ReleaseByteArrayElements(JNIEnv *env, jbyteArray array, jbyte *elems, jint mode)"},
+    {1544, "ReleaseCharArrayElements", "void ReleaseCharArrayElements(JNIEnv *env, jcharArray array, jchar *elems, jint mode)"},
+    {1552, "ReleaseShortArrayElements", "void ReleaseShortArrayElements(JNIEnv *env, jshortArray array, jshort *elems, jint mode)"},
+    {1560, "ReleaseIntArrayElements", "void ReleaseIntArrayElements(JNIEnv *env, jintArray array, jint *elems, jint mode)"},
+    {1568, "ReleaseLongArrayElements", "void ReleaseLongArrayElements(JNIEnv *env, jlongArray array, jlong *elems, jint mode)"},
+    {1576, "ReleaseFloatArrayElements", "void ReleaseFloatArrayElements(JNIEnv *env, jfloatArray array, jfloat *elems, jint mode)"},
+    {1584, "ReleaseDoubleArrayElements", "void ReleaseDoubleArrayElements(JNIEnv *env, jdoubleArray array, jdouble *elems, jint mode)"},
+    {1592, "GetBooleanArrayRegion", "void GetBooleanArrayRegion(JNIEnv *env, jbooleanArray array, jsize start, jsize l, jboolean *buf)"},
+    {1600, "GetByteArrayRegion", "void GetByteArrayRegion(JNIEnv *env, jbyteArray array, jsize start, jsize len, jbyte *buf)"},
+    {1608, "GetCharArrayRegion", "void GetCharArrayRegion(JNIEnv *env, jcharArray array, jsize start, jsize len, jchar *buf)"},
+    {1616, "GetShortArrayRegion", "void GetShortArrayRegion(JNIEnv *env, jshortArray array, jsize start, jsize len, jshort *buf)"},
+    {1624, "GetIntArrayRegion", "void GetIntArrayRegion(JNIEnv *env, jintArray array, jsize start, jsize len, jint *buf)"},
+    {1632, "GetLongArrayRegion", "void GetLongArrayRegion(JNIEnv *env, jlongArray array, jsize start, jsize len, jlong *buf)"},
+    {1640, "GetFloatArrayRegion", "void GetFloatArrayRegion(JNIEnv *env, jfloatArray array, jsize start, jsize len, jfloat *buf)"},
+    {1648, "GetDoubleArrayRegion", "void GetDoubleArrayRegion(JNIEnv *env, jdoubleArray array, jsize start, jsize len, jdouble *buf)"},
+    {1656, "SetBooleanArrayRegion", "void SetBooleanArrayRegion(JNIEnv *env, jbooleanArray array, jsize start, jsize l, jboolean *buf)"},
+    {1664, "SetByteArrayRegion", "void SetByteArrayRegion(JNIEnv *env, jbyteArray array, jsize start, jsize len, jbyte *buf)"},
+    {1672, "SetCharArrayRegion", "void SetCharArrayRegion(JNIEnv *env, jcharArray array, jsize start, jsize len, jchar *buf)"},
+    {1680, "SetShortArrayRegion", "void SetShortArrayRegion(JNIEnv *env, jshortArray array, jsize start, jsize len, jshort *buf)"},
+    {1688, "SetIntArrayRegion", "void SetIntArrayRegion(JNIEnv *env, jintArray array, jsize start, jsize len, jint *buf)"},
+    {1696, "SetLongArrayRegion", "void SetLongArrayRegion(JNIEnv *env, jlongArray array, jsize start, jsize len, jlong *buf)"},
+    {1704, "SetFloatArrayRegion", "void SetFloatArrayRegion(JNIEnv *env, jfloatArray array, jsize start, jsize len, jfloat *buf)"},
+    {1712, "SetDoubleArrayRegion", "void SetDoubleArrayRegion(JNIEnv *env, jdoubleArray array, jsize start, jsize len, jdouble *buf)"},
+    {1720, "RegisterNatives", "jint RegisterNatives(JNIEnv *env, jclass clazz, JNINativeMethod *methods, jint nMethods)"},
+    {1728, "UnregisterNatives", "jint UnregisterNatives(JNIEnv *env, jclass clazz)"},
+    {1736, "MonitorEnter", "jint MonitorEnter(JNIEnv *env, jobject obj)"},
+    {1744, "MonitorExit", "jint MonitorExit(JNIEnv *env, jobject obj)"},
+    {1752, "GetJavaVM", "jint GetJavaVM(JNIEnv *env, JavaVM **vm)"},
+    {1760, "GetStringRegion", "void GetStringRegion(JNIEnv *env, jstring str, jsize start, jsize len, jchar *buf)"},
+    {1768, "GetStringUTFRegion", "void GetStringUTFRegion(JNIEnv *env, jstring str, jsize start, jsize len, char *buf)"},
+    {1776, "GetPrimitiveArrayCritical", "void *GetPrimitiveArrayCritical(JNIEnv *env, jarray array, jboolean *isCopy)"},
+    {1784, "ReleasePrimitiveArrayCritical", "void ReleasePrimitiveArrayCritical(JNIEnv *env, jarray array, void *carray, jint mode)"},
+    {1792, "GetStringCritical", "jchar *GetStringCritical(JNIEnv *env, jstring string, jboolean *isCopy)"},
+    {1800, "ReleaseStringCritical", "void ReleaseStringCritical(JNIEnv *env, jstring string, jchar *cstring)"},
+    {1808, "NewWeakGlobalRef", "jweak NewWeakGlobalRef(JNIEnv *env, jobject obj)"},
+    {1816, "DeleteWeakGlobalRef", "void DeleteWeakGlobalRef(JNIEnv *env, jweak ref)"},
+    {1824, "ExceptionCheck", "jboolean ExceptionCheck(JNIEnv *env)"},
+    {1832, "NewDirectByteBuffer", "jobject NewDirectByteBuffer(JNIEnv *env, void *address, jlong capacity)"},
+    {1840, "GetDirectBufferAddress", "void *GetDirectBufferAddress(JNIEnv *env, jobject buf)"},
+    {1848, "GetDirectBufferCapacity", "jlong GetDirectBufferCapacity(JNIEnv *env, jobject buf)"},
+    {1856, "GetObjectRefType", "jobjectRefType GetObjectRefType(JNIEnv *env, jobject obj)"},
+};
+
+// JNIInvokeInterface_, ilp32
+inline constexpr uint32_t JNIInvokeInterface__32_SIZE = 32;
+inline constexpr Slot JNIInvokeInterface__32[] = {
+    {0, "reserved0", "void *reserved0"},
+    {4, "reserved1", "void *reserved1"},
+    {8, "reserved2", "void *reserved2"},
+    {12, "DestroyJavaVM", "jint DestroyJavaVM(JavaVM *vm)"},
+    {16, "AttachCurrentThread", "jint AttachCurrentThread(JavaVM *vm, void **penv, void *args)"},
+    {20, "DetachCurrentThread", "jint DetachCurrentThread(JavaVM *vm)"},
+    {24, "GetEnv", "jint GetEnv(JavaVM *vm, void **penv, jint version)"},
+    {28, "AttachCurrentThreadAsDaemon", "jint AttachCurrentThreadAsDaemon(JavaVM *vm, void **penv, void *args)"},
+};
+
+// JNIInvokeInterface_, lp64
+inline constexpr uint32_t JNIInvokeInterface__64_SIZE = 64;
+inline constexpr Slot JNIInvokeInterface__64[] = {
+    {0, "reserved0", "void *reserved0"},
+    {8, "reserved1", "void *reserved1"},
+    {16, "reserved2", "void *reserved2"},
+    {24, "DestroyJavaVM", "jint DestroyJavaVM(JavaVM *vm)"},
+    {32, "AttachCurrentThread", "jint AttachCurrentThread(JavaVM *vm, void **penv, void *args)"},
+    {40, "DetachCurrentThread", "jint DetachCurrentThread(JavaVM *vm)"},
+    {48, "GetEnv", "jint GetEnv(JavaVM *vm, void **penv, jint version)"},
+    {56, "AttachCurrentThreadAsDaemon", "jint AttachCurrentThreadAsDaemon(JavaVM *vm, void **penv, void *args)"},
+};
+
+// JNINativeMethod, ilp32
+inline constexpr uint32_t JNINativeMethod_32_SIZE = 12;
+inline constexpr Slot JNINativeMethod_32[] = {
+    {0, "name", "char *name"},
+    {4, "signature", "char *signature"},
+    {8, "fnPtr", "void *fnPtr"},
+};
+
+// JNINativeMethod, lp64
+inline constexpr uint32_t JNINativeMethod_64_SIZE = 24;
+inline constexpr Slot JNINativeMethod_64[] = {
+    {0, "name", "char *name"},
+    {8, "signature", "char *signature"},
+    {16, "fnPtr", "void *fnPtr"},
+};
+
+}  // namespace jni
@@ -0,0 +1,157 @@
+/*
+ *   jni_natives: find the JNINativeMethod arrays passed to RegisterNatives in
+ *   Android native libraries and print a Java method -> native address map.
+ *
+ *   Every ELF file under the given paths is searched (in parallel) with
+ *   jni::NativeScanner; each line is one registered method:
+ *
+ *     file  array  index  name  signature  address  symbol
+ *
+ *   where 'array' is the address of the JNINativeMethod array, 'address' the
+ *   native function (with " thumb" appended for Thumb code on ARM) and
+ *   'symbol' the function symbol at that address, if any. The Java class is
+ *   not recorded in the array and is not reported.
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/jni/jni_natives.cpp -o jni_natives
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/elf.hpp"
+#include "common/files.hpp"
+#include "common/mapped_file.hpp"
+#include "common/parallel.hpp"
+#include "jni/jni_natives.hpp"
+
+
+namespace {
+
+struct Options {
+    size_t min_count = 1;
+    bool arrays = false;
+    unsigned jobs = common::default_jobs();
+    std::vector<std::string> paths;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: jni_natives [options] path...\n"
+                 "  --min N     report only arrays of at least N methods (default 1)\n"
+                 "  --arrays    print one line per array (address, count, symbol) instead\n"
+                 "  -j N        number of files scanned in parallel\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--min") {
+            o.min_count = static_cast<size_t>(std::strtoull(next(), nullptr, 0));
+        } else if (a == "--arrays") {
+            o.arrays = true;
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else {
+            o.paths.push_back(a);
+        }
+    }
+    if (o.paths.empty() || o.min_count == 0) {
+        usage();
+    }
+    return o;
+}
+
+// Symbol names by address: functions for native methods, objects for arrays.
+struct Symbols {
+    std::unordered_map<uint64_t, const std::string *> functions, objects;
+
+    explicit Symbols(const common::ElfFile &elf) {
+        for (const common::ElfSymbol &s : elf.symbols()) {
+            if (!s.defined() || s.name.empty()) {
+                continue;
+            }
+            if (s.function()) {
+                uint64_t a = elf.machine() == common::EM_ARM ? s.value & ~uint64_t(1) : s.value;
+                functions.emplace(a, &s.name);
+            } else if (s.type == 1 /* STT_OBJECT */) {
+                objects.emplace(s.value, &s.name);
+            }
+        }
+    }
+
+    static const char *lookup(const std::unordered_map<uint64_t, const std::string *> &m, uint64_t a) {
+        auto it = m.find(a);
+        return it == m.end() ? "?" : it->second->c_str();
+    }
+};
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::vector<std::string> files = common::collect_files(opt.paths, "jni_natives");
+    std::vector<std::string> text(files.size());
+    std::mutex lock;
+    int status = 0;
+
+    common::parallel_for(files.size(), opt.jobs, [&](size_t i) {
+        std::ostringstream o;
+        try {
+            common::MappedFile f(files[i]);
+            if (!common::ElfFile::is_elf(f.data(), f.size())) {
+                return;
+            }
+            common::ElfFile elf(f.data(), f.size());
+            std::vector<jni::NativeArray> arrays = jni::NativeScanner(elf).scan(opt.min_count);
+            if (arrays.empty()) {
+                return;
+            }
+            Symbols syms(elf);
+            char line[96];
+            for (const jni::NativeArray &a : arrays) {
+                if (opt.arrays) {
+                    std::snprintf(line, sizeof line, "\t0x%08" PRIx64 "\t%zu\t", a.addr, a.methods.size());
+                    o << files[i] << line << Symbols::lookup(syms.objects, a.addr) << '\n';
+                    continue;
+                }
+                for (size_t k = 0; k < a.methods.size(); k++) {
+                    const jni::NativeMethod &m = a.methods[k];
+                    std::snprintf(line, sizeof line, "\t0x%08" PRIx64 "\t%zu\t", a.addr, k);
+                    o << files[i] << line << m.name << '\t' << m.signature << '\t';
+                    std::snprintf(line, sizeof line, "0x%08" PRIx64 "%s\t", m.fn, m.thumb ? " thumb" : "");
+                    o << line << Symbols::lookup(syms.functions, m.fn) << '\n';
+                }
+            }
+        } catch (const std::exception &e) {
+            std::lock_guard<std::mutex> g(lock);
+            std::fprintf(stderr, "jni_natives: %s: %s\n", files[i].c_str(), e.what());
+            status = 1;
+            return;
+        }
+        std::lock_guard<std::mutex> g(lock);
+        text[i] = o.str();
+    });
+
+    for (const std::string &t : text) {
+        std::fwrite(t.data(), 1, t.size(), stdout);
+    }
+    return status;
+}
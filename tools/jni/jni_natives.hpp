@@ -0,0 +1,212 @@
+/*
+ *   Discovery of JNINativeMethod arrays (the argument of RegisterNatives) in
+ *   the data sections of ELF shared objects.
+ *
+ *   An entry is { char *name; char *signature; void *fnPtr; } with the
+ *   layout of jni_all.gdt (JNINativeMethod_32/_64 in jni_interface.hpp). In
+ *   PIC code the three pointers are filled in by the loader, so each data
+ *   section is first rebuilt as an array of pointer-sized words with the
+ *   relative and absolute dynamic relocations applied (common/words.hpp).
+ *
+ *   Candidate entries are found with a range filter over all words at once:
+ *   one bitmap marks words pointing into read-only data, another words
+ *   pointing into code, and an entry can only start where the pattern
+ *   rodata, rodata, code begins. Only the few surviving candidates have
+ *   their strings checked as a Java method name and a JNI method descriptor.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/elf.hpp"
+#include "common/words.hpp"
+#include "jni/jni_interface.hpp"
+
+
+namespace jni {
+
+struct NativeMethod {
+    uint64_t entry;  // address of the JNINativeMethod
+    std::string name;
+    std::string signature;
+    uint64_t fn;     // fnPtr with the Thumb bit cleared
+    bool thumb;
+};
+
+struct NativeArray {
+    uint64_t addr;
+    std::vector<NativeMethod> methods;
+};
+
+namespace detail {
+
+// Java identifier in modified UTF-8 ("<init>" cannot be registered).
+inline bool java_name(const std::string &s) {
+    if (s.empty() || (s[0] >= '0' && s[0] <= '9')) {
+        return false;
+    }
+    for (unsigned char c : s) {
+        if (!(c >= 0x80 || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' ||
+              c == '$')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// One field type of a descriptor starting at s[i]; advances i.
+inline bool field_type(const std::string &s, size_t &i) {
+    while (i < s.size() && s[i] == '[') {
+        i++;
+    }
+    if (i >= s.size()) {
+        return false;
+    }
+    switch (s[i]) {
+    case 'Z': case 'B': case 'C': case 'S': case 'I': case 'J': case 'F': case 'D':
+        i++;
+        return true;
+    case 'L': {
+        size_t semi = s.find(';', i);
+        if (semi == std::string::npos || semi == i + 1) {
+            return false;
+        }
+        for (size_t k = i + 1; k < semi; k++) {
+            if (s[k] == '.' || s[k] == '[' || s[k] == '(' || s[k] == ')' || (unsigned char)s[k] < 0x21) {
+                return false;
+            }
+        }
+        i = semi + 1;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// "(args)ret" as in JNI method signatures.
+inline bool method_descriptor(const std::string &s) {
+    if (s.size() < 3 || s[0] != '(') {
+        return false;
+    }
+    size_t i = 1;
+    while (i < s.size() && s[i] != ')') {
+        if (!field_type(s, i)) {
+            return false;
+        }
+    }
+    if (i >= s.size()) {
+        return false;
+    }
+    i++;
+    if (i < s.size() && s[i] == 'V') {
+        return i + 1 == s.size();
+    }
+    return field_type(s, i) && i == s.size();
+}
+
+}  // namespace detail
+
+class NativeScanner {
+  public:
+    explicit NativeScanner(const common::ElfFile &elf) : elf_(elf), ranges_(elf), ptr_(elf.pointer_size()) {
+        const Slot *layout = ptr_ == 8 ? JNINativeMethod_64 : JNINativeMethod_32;
+        stride_ = (ptr_ == 8 ? JNINativeMethod_64_SIZE : JNINativeMethod_32_SIZE) / ptr_;
+        name_ = layout[0].offset / ptr_;
+        sig_ = layout[1].offset / ptr_;
+        fn_ = layout[2].offset / ptr_;
+    }
+
+    // Arrays of at least 'min_count' consecutive valid entries.
+    std::vector<NativeArray> scan(size_t min_count = 1) const {
+        std::vector<NativeArray> out;
+        if (ranges_.code.empty() || ranges_.rodata.empty()) {
+            return out;
+        }
+        std::vector<common::ElfRelocation> relocs = elf_.dynamic_relocations();
+        for (const common::ElfSection &s : elf_.sections()) {
+            if (s.alloc() && !s.exec() && s.type == 1 && s.size >= uint64_t(stride_) * ptr_) {
+                scan_section(s, relocs, min_count, out);
+            }
+        }
+        return out;
+    }
+
+  private:
+    void scan_section(const common::ElfSection &s, const std::vector<common::ElfRelocation> &relocs,
+                      size_t min_count, std::vector<NativeArray> &out) const {
+        common::DataWords d = common::data_words(elf_, s, relocs);
+        const std::vector<uint64_t> &w = d.w;
+        uint64_t base = d.base;
+        size_t n = w.size();
+        std::vector<uint64_t> in_ro(common::mask_words(n)), in_code(common::mask_words(n));
+        common::classify_ranges(w.data(), n, ranges_.rodata, ranges_.code, in_ro.data(), in_code.data());
+
+        // bit i of 'cand': w[i + name_] and w[i + sig_] in rodata, w[i + fn_] in code
+        std::map<size_t, NativeMethod> found;
+        for (size_t k = 0; k + 1 < in_ro.size(); k++) {
+            uint64_t cand = common::mask_at(in_ro, k, name_) & common::mask_at(in_ro, k, sig_) &
+                            common::mask_at(in_code, k, fn_);
+            while (cand) {
+                size_t i = k * 64 + static_cast<size_t>(__builtin_ctzll(cand));
+                cand &= cand - 1;
+                NativeMethod m;
+                if (i + stride_ <= n && entry(w, i, base, m)) {
+                    found.emplace(i, std::move(m));
+                }
+            }
+        }
+        while (!found.empty()) {
+            size_t i = found.begin()->first;
+            NativeArray a{base + i * ptr_, {}};
+            for (auto it = found.find(i); it != found.end(); it = found.find(i)) {
+                a.methods.push_back(std::move(it->second));
+                found.erase(it);
+                i += stride_;
+            }
+            if (a.methods.size() >= min_count) {
+                out.push_back(std::move(a));
+            }
+        }
+    }
+
+    bool entry(const std::vector<uint64_t> &w, size_t i, uint64_t base, NativeMethod &m) const {
+        uint64_t fn = w[i + fn_];
+        bool thumb = elf_.machine() == common::EM_ARM && (fn & 1);
+        m.fn = thumb ? fn & ~uint64_t(1) : fn;
+        m.thumb = thumb;
+        if (!in_code_section(m.fn)) {
+            return false;
+        }
+        m.name = elf_.cstring_at(w[i + name_], 1024);
+        if (!detail::java_name(m.name)) {
+            return false;
+        }
+        m.signature = elf_.cstring_at(w[i + sig_], 4096);
+        if (!detail::method_descriptor(m.signature)) {
+            return false;
+        }
+        m.entry = base + i * ptr_;
+        return true;
+    }
+
+    bool in_code_section(uint64_t a) const {
+        for (const common::ElfSection &s : elf_.sections()) {
+            if (s.alloc() && s.exec() && a >= s.addr && a - s.addr < s.size) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const common::ElfFile &elf_;
+    common::ImageRanges ranges_;
+    unsigned ptr_;
+    unsigned stride_, name_, sig_, fn_;  // in words
+};
+
+}  // namespace jni
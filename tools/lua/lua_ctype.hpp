@@ -0,0 +1,265 @@
+/*
+ *   Lua's character classes ("// lctype.h" of header/lua_all.h) and a
+ *   vectorized classifier derived from them.
+ *
+ *   luai_ctype_ is the ASCII table of lctype.c (LUA_UCID off). Any set of
+ *   classes is turned at compile time into a pair of 16-entry nibble tables
+ *   such that byte c is in the set iff lo[c & 15] & hi[c >> 4] != 0, which
+ *   lets SSSE3 (pshufb) and NEON (tbl) classify 16 bytes per instruction.
+ *   Arbitrary byte sets (delimiters, line breaks) use the same machinery.
+ */
+
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LUA_CTYPE_SSSE3 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define LUA_CTYPE_NEON 1
+#endif
+
+
+namespace lua {
+
+constexpr int ALPHABIT = 0;
+constexpr int DIGITBIT = 1;
+constexpr int PRINTBIT = 2;
+constexpr int SPACEBIT = 3;
+constexpr int XDIGITBIT = 4;
+
+constexpr uint8_t MASK(int b) { return static_cast<uint8_t>(1 << b); }
+
+// one entry for each character and for -1 (EOZ)
+inline constexpr uint8_t luai_ctype_[UCHAR_MAX + 2] = {
+    0x00,  // EOZ
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  // 0.
+    0x00,  0x08,  0x08,  0x08,  0x08,  0x08,  0x00,  0x00,
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  // 1.
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,
+    0x0c,  0x04,  0x04,  0x04,  0x04,  0x04,  0x04,  0x04,  // 2.
+    0x04,  0x04,  0x04,  0x04,  0x04,  0x04,  0x04,  0x04,
+    0x16,  0x16,  0x16,  0x16,  0x16,  0x16,  0x16,  0x16,  // 3.
+    0x16,  0x16,  0x04,  0x04,  0x04,  0x04,  0x04,  0x04,
+    0x04,  0x15,  0x15,  0x15,  0x15,  0x15,  0x15,  0x05,  // 4.
+    0x05,  0x05,  0x05,  0x05,  0x05,  0x05,  0x05,  0x05,
+    0x05,  0x05,  0x05,  0x05,  0x05,  0x05,  0x05,  0x05,  // 5.
+    0x05,  0x05,  0x05,  0x04,  0x04,  0x04,  0x04,  0x05,
+    0x04,  0x15,  0x15,  0x15,  0x15,  0x15,  0x15,  0x05,  // 6.
+    0x05,  0x05,  0x05,  0x05,  0x05,  0x05,  0x05,  0x05,
+    0x05,  0x05,  0x05,  0x05,  0x05,  0x05,  0x05,  0x05,  // 7.
+    0x05,  0x05,  0x05,  0x04,  0x04,  0x04,  0x04,  0x00,
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  // 8.
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  // 9.
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  // A.
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  // B.
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  // C.
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  // D.
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  // E.
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  // F.
+    0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,  0x00,
+};
+
+constexpr int EOZ = -1;
+
+constexpr uint8_t testprop(int c, uint8_t p) { return luai_ctype_[c + 1] & p; }
+constexpr bool lislalpha(int c) { return testprop(c, MASK(ALPHABIT)); }
+constexpr bool lislalnum(int c) { return testprop(c, MASK(ALPHABIT) | MASK(DIGITBIT)); }
+constexpr bool lisdigit(int c) { return testprop(c, MASK(DIGITBIT)); }
+constexpr bool lisspace(int c) { return testprop(c, MASK(SPACEBIT)); }
+constexpr bool lisprint(int c) { return testprop(c, MASK(PRINTBIT)); }
+constexpr bool lisxdigit(int c) { return testprop(c, MASK(XDIGITBIT)); }
+
+
+// Membership of a byte set as two nibble lookups. Rows (high nibbles) with
+// the same set of low nibbles share one of the eight bits; 'ok' is false if
+// the set needs more than eight distinct rows.
+struct ByteClass {
+    alignas(16) uint8_t lo[16] = {};
+    alignas(16) uint8_t hi[16] = {};
+    bool ok = true;
+
+    constexpr bool contains(uint8_t c) const { return (lo[c & 15] & hi[c >> 4]) != 0; }
+};
+
+namespace detail {
+
+constexpr ByteClass make_class(const bool (&member)[256]) {
+    ByteClass bc;
+    uint16_t rows[8] = {};
+    int nrows = 0;
+    for (int h = 0; h < 16; h++) {
+        uint16_t row = 0;
+        for (int l = 0; l < 16; l++) {
+            if (member[h << 4 | l]) {
+                row = static_cast<uint16_t>(row | 1 << l);
+            }
+        }
+        if (!row) {
+            continue;
+        }
+        int idx = 0;
+        while (idx < nrows && rows[idx] != row) {
+            idx++;
+        }
+        if (idx == nrows) {
+            if (nrows == 8) {
+                bc.ok = false;
+                return bc;
+            }
+            rows[nrows++] = row;
+        }
+        bc.hi[h] = static_cast<uint8_t>(bc.hi[h] | 1 << idx);
+        for (int l = 0; l < 16; l++) {
+            if (row & 1 << l) {
+                bc.lo[l] = static_cast<uint8_t>(bc.lo[l] | 1 << idx);
+            }
+        }
+    }
+    return bc;
+}
+
+}  // namespace detail
+
+// Bytes having any of the luai_ctype_ properties in 'props'.
+constexpr ByteClass ctype_class(uint8_t props) {
+    bool member[256] = {};
+    for (int c = 0; c < 256; c++) {
+        member[c] = testprop(c, props) != 0;
+    }
+    return detail::make_class(member);
+}
+
+constexpr ByteClass byte_class(std::initializer_list<unsigned char> bytes) {
+    bool member[256] = {};
+    for (unsigned char c : bytes) {
+        member[c] = true;
+    }
+    return detail::make_class(member);
+}
+
+inline constexpr ByteClass CLASS_ALNUM = ctype_class(MASK(ALPHABIT) | MASK(DIGITBIT));
+inline constexpr ByteClass CLASS_XDIGIT_OR_DOT = [] {
+    bool member[256] = {};
+    for (int c = 0; c < 256; c++) {
+        member[c] = lisxdigit(c) || c == '.';
+    }
+    return detail::make_class(member);
+}();
+// Decimal numerals: without the hex letters, so the 'e' of an exponent
+// stops the run.
+inline constexpr ByteClass CLASS_DIGIT_OR_DOT = [] {
+    bool member[256] = {};
+    for (int c = 0; c < 256; c++) {
+        member[c] = lisdigit(c) || c == '.';
+    }
+    return detail::make_class(member);
+}();
+static_assert(CLASS_ALNUM.ok && CLASS_XDIGIT_OR_DOT.ok && CLASS_DIGIT_OR_DOT.ok,
+              "luai_ctype_ classes must fit the nibble encoding");
+static_assert(!CLASS_DIGIT_OR_DOT.contains('e') && !CLASS_DIGIT_OR_DOT.contains('E') &&
+                  CLASS_DIGIT_OR_DOT.contains('.') && CLASS_DIGIT_OR_DOT.contains('9'),
+              "a decimal run must stop at an exponent mark");
+
+namespace detail {
+
+inline unsigned ctz32(uint32_t m) { return static_cast<unsigned>(__builtin_ctz(m)); }
+
+inline size_t span_scalar(const uint8_t *p, size_t n, const ByteClass &bc, bool in) {
+    size_t i = 0;
+    while (i < n && bc.contains(p[i]) == in) {
+        i++;
+    }
+    return i;
+}
+
+#if LUA_CTYPE_SSSE3
+__attribute__((target("ssse3"))) inline size_t span_ssse3(const uint8_t *p, size_t n, const ByteClass &bc,
+                                                          bool in) {
+    const __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i *>(bc.lo));
+    const __m128i hi = _mm_load_si128(reinterpret_cast<const __m128i *>(bc.hi));
+    const __m128i nib = _mm_set1_epi8(0x0f);
+    const __m128i zero = _mm_setzero_si128();
+    const uint32_t flip = in ? 0xffff : 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        __m128i a = _mm_shuffle_epi8(lo, _mm_and_si128(v, nib));
+        __m128i b = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(v, 4), nib));
+        // bit set where the byte is in the class
+        uint32_t m = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(a, b), zero))) & 0xffff;
+        m ^= flip;
+        if (m) {
+            return i + ctz32(m);
+        }
+    }
+    return i + span_scalar(p + i, n - i, bc, in);
+}
+
+inline bool have_ssse3() {
+    static const bool yes = __builtin_cpu_supports("ssse3");
+    return yes;
+}
+#endif
+
+#if LUA_CTYPE_NEON
+inline size_t span_neon(const uint8_t *p, size_t n, const ByteClass &bc, bool in) {
+    const uint8x16_t lo = vld1q_u8(bc.lo);
+    const uint8x16_t hi = vld1q_u8(bc.hi);
+    const uint8x16_t nib = vdupq_n_u8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8(p + i);
+        uint8x16_t m = vtstq_u8(vqtbl1q_u8(lo, vandq_u8(v, nib)), vqtbl1q_u8(hi, vshrq_n_u8(v, 4)));
+        if (in) {
+            m = vmvnq_u8(m);
+        }
+        // narrow each byte to a nibble: 64-bit mask, 4 bits per byte
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+        if (bits) {
+            return i + static_cast<size_t>(__builtin_ctzll(bits) >> 2);
+        }
+    }
+    return i + span_scalar(p + i, n - i, bc, in);
+}
+#endif
+
+}  // namespace detail
+
+// Length of the prefix of p[0, n) whose bytes are all in (in = true) or all
+// outside (in = false) the class.
+inline size_t span(const uint8_t *p, size_t n, const ByteClass &bc, bool in = true) {
+    // most runs in source text are short; settle those without a vector load
+    size_t i = 0;
+    for (; i < 8 && i < n; i++) {
+        if (bc.contains(p[i]) != in) {
+            return i;
+        }
+    }
+    p += i;
+    n -= i;
+    if (n >= 16) {
+#if LUA_CTYPE_SSSE3
+        if (detail::have_ssse3()) {
+            return i + detail::span_ssse3(p, n, bc, in);
+        }
+#elif LUA_CTYPE_NEON
+        return i + detail::span_neon(p, n, bc, in);
+#endif
+    }
+    return i + detail::span_scalar(p, n, bc, in);
+}
+
+}  // namespace lua
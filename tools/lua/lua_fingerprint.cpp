@@ -0,0 +1,242 @@
+/*
+ *   lua_fingerprint: scan firmware trees for ELF binaries embedding Lua and
+ *   infer the luaconf.h options each was built with (LUA_32BITS,
+ *   LUA_USE_C89, LUAI_MAXSTACK, LUAI_MAXCCALLS), so that the matching
+ *   lua_all.h configuration can be selected before parsing.
+ *
+ *   Files are fingerprinted in parallel. Results are memoized by content
+ *   hash, so the many identical copies of a library found in an unpacked
+ *   firmware are analyzed once; --cache keeps the memo across runs.
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/lua/lua_fingerprint.cpp -o lua_fingerprint
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/elf.hpp"
+#include "common/files.hpp"
+#include "common/hash.hpp"
+#include "common/mapped_file.hpp"
+#include "common/parallel.hpp"
+#include "lua/lua_fingerprint.hpp"
+
+
+namespace {
+
+struct Options {
+    bool json = false;
+    bool all = false;
+    std::string cache;
+    unsigned jobs = common::default_jobs();
+    std::vector<std::string> paths;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: lua_fingerprint [options] file-or-directory...\n"
+                 "  --json        emit one JSON object per binary\n"
+                 "  --all         also report ELF files without Lua\n"
+                 "  --cache FILE  persistent memo of results by content hash\n"
+                 "  -j N          number of files fingerprinted in parallel\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--json") {
+            o.json = true;
+        } else if (a == "--all") {
+            o.all = true;
+        } else if (a == "--cache") {
+            o.cache = next();
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else {
+            o.paths.push_back(a);
+        }
+    }
+    if (o.paths.empty()) {
+        usage();
+    }
+    return o;
+}
+
+class Memo {
+  public:
+    void load(const std::string &path) {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            size_t tab = line.find('\t');
+            lua::Fingerprint fp;
+            if (tab != 16 || !lua::Fingerprint::deserialize(line.substr(tab + 1), fp)) {
+                continue;
+            }
+            map_[std::strtoull(line.substr(0, tab).c_str(), nullptr, 16)] = fp;
+        }
+    }
+
+    void save(const std::string &path) const {
+        std::ofstream out(path, std::ios::trunc);
+        for (const auto &kv : map_) {
+            out << common::hex64(kv.first) << '\t' << kv.second.serialize() << '\n';
+        }
+    }
+
+    bool find(uint64_t h, lua::Fingerprint &fp) {
+        std::lock_guard<std::mutex> g(lock_);
+        auto it = map_.find(h);
+        if (it == map_.end()) {
+            return false;
+        }
+        fp = it->second;
+        return true;
+    }
+
+    void insert(uint64_t h, const lua::Fingerprint &fp) {
+        std::lock_guard<std::mutex> g(lock_);
+        map_.emplace(h, fp);
+    }
+
+  private:
+    std::mutex lock_;
+    std::unordered_map<uint64_t, lua::Fingerprint> map_;
+};
+
+std::string json_string(const std::string &s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + '"';
+}
+
+std::string gcstat_flags(const lua::Fingerprint &fp) {
+    std::string s = "--abi " + fp.abi;
+    if (fp.lua_32bits == 1) {
+        s += " --lua32";
+    }
+    if (fp.c89 == 1) {
+        s += " --c89";
+    }
+    return s;
+}
+
+const char *tristate(int v) {
+    return v < 0 ? "?" : v ? "yes" : "no";
+}
+
+std::string format(const Options &opt, const std::string &path, uint64_t hash, const lua::Fingerprint &fp) {
+    std::ostringstream o;
+    if (opt.json) {
+        auto num = [](uint64_t v) { return v ? std::to_string(v) : std::string("null"); };
+        auto tri = [](int v) { return v < 0 ? "null" : v ? "true" : "false"; };
+        o << "{\"path\":" << json_string(path) << ",\"hash\":\"" << common::hex64(hash) << "\",\"lua\":"
+          << (fp.lua ? "true" : "false") << ",\"machine\":" << json_string(fp.machine)
+          << ",\"abi\":" << json_string(fp.abi);
+        if (fp.lua) {
+            o << ",\"version\":" << (fp.version.empty() ? "null" : json_string(fp.version))
+              << ",\"integer_size\":" << num(fp.integer_size) << ",\"number_size\":" << num(fp.number_size)
+              << ",\"LUA_32BITS\":" << tri(fp.lua_32bits) << ",\"LUA_USE_C89\":" << tri(fp.c89)
+              << ",\"LUAI_MAXSTACK\":" << num(fp.maxstack) << ",\"LUAI_MAXCCALLS\":" << num(fp.maxccalls)
+              << ",\"parse_options\":" << json_string(fp.parse_options())
+              << ",\"lua_gcstat\":" << json_string(gcstat_flags(fp)) << ",\"evidence\":[";
+            for (size_t i = 0; i < fp.evidence.size(); i++) {
+                o << (i ? "," : "") << json_string(fp.evidence[i]);
+            }
+            o << ']';
+        }
+        o << "}\n";
+        return o.str();
+    }
+    o << path << ": ";
+    if (!fp.lua) {
+        o << "no Lua (" << fp.machine << ")\n";
+        return o.str();
+    }
+    o << "Lua " << (fp.version.empty() ? "?" : fp.version) << ", " << fp.machine << " " << fp.abi << '\n';
+    o << "  lua_Integer " << (fp.integer_size ? std::to_string(fp.integer_size) : "?") << " bytes, lua_Number "
+      << (fp.number_size ? std::to_string(fp.number_size) : "?") << " bytes   LUA_32BITS "
+      << tristate(fp.lua_32bits) << "   LUA_USE_C89 " << tristate(fp.c89) << '\n';
+    o << "  LUAI_MAXSTACK " << (fp.maxstack ? std::to_string(fp.maxstack) : "?") << "   LUAI_MAXCCALLS "
+      << (fp.maxccalls ? std::to_string(fp.maxccalls) : "?") << '\n';
+    std::string popts = fp.parse_options();
+    o << "  parse options: " << (popts.empty() ? "(defaults)" : popts) << "   lua_gcstat " << gcstat_flags(fp)
+      << '\n';
+    o << "  evidence:";
+    for (const std::string &e : fp.evidence) {
+        o << ' ' << e;
+    }
+    o << '\n';
+    return o.str();
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::vector<std::string> files = common::collect_files(opt.paths, "lua_fingerprint");
+
+    Memo memo;
+    if (!opt.cache.empty()) {
+        memo.load(opt.cache);
+    }
+
+    std::vector<std::string> out(files.size());
+    std::mutex err_lock;
+    int status = 0;
+    common::parallel_for(files.size(), opt.jobs, [&](size_t i) {
+        try {
+            common::MappedFile mf(files[i]);
+            if (!common::ElfFile::is_elf(mf.data(), mf.size())) {
+                return;
+            }
+            mf.advise(MADV_SEQUENTIAL);
+            uint64_t h = common::hash_bytes(mf.data(), mf.size());
+            lua::Fingerprint fp;
+            if (!memo.find(h, fp)) {
+                fp = lua::fingerprint(common::ElfFile(mf.data(), mf.size()));
+                memo.insert(h, fp);
+            }
+            if (fp.lua || opt.all) {
+                out[i] = format(opt, files[i], h, fp);
+            }
+        } catch (const std::exception &e) {
+            std::lock_guard<std::mutex> g(err_lock);
+            std::fprintf(stderr, "lua_fingerprint: %s: %s\n", files[i].c_str(), e.what());
+            status = 1;
+        }
+    });
+
+    for (const std::string &s : out) {
+        std::fwrite(s.data(), 1, s.size(), stdout);
+    }
+    if (!opt.cache.empty()) {
+        memo.save(opt.cache);
+    }
+    return status;
+}
@@ -0,0 +1,468 @@
+/*
+ *   Infers the luaconf.h configuration a binary's embedded Lua was built with.
+ *
+ *   Evidence, strongest first:
+ *     - LUAL_NUMSIZES (sizeof(lua_Integer)*16 + sizeof(lua_Number)) passed next
+ *       to LUA_VERSION_NUM at every luaL_checkversion call site
+ *     - LUA_REGISTRYINDEX (-LUAI_MAXSTACK - 1000), an immediate in nearly every
+ *       registry access; its most frequent value gives LUAI_MAXSTACK
+ *     - the LUAI_MAXCCALLS / (LUAI_MAXCCALLS / 10 * 11) compare pair of
+ *       luaE_checkcstack
+ *     - LUAI_NUMFFORMAT / LUA_INTEGER_FMT strings and the LUAC_NUM (370.5)
+ *       constant in float or double form
+ *   When the binary carries symbols, the bodies of luaL_checkversion_,
+ *   luaE_checkcstack and lua_checkstack are searched directly instead.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/elf.hpp"
+#include "common/hash.hpp"
+#include "common/immediates.hpp"
+
+
+namespace lua {
+
+constexpr uint32_t LUA_VERSION_NUM_54 = 504;
+constexpr uint64_t DEFAULT_MAXSTACK = 1000000;
+constexpr uint64_t DEFAULT_MAXCCALLS = 200;
+
+struct Fingerprint {
+    bool lua = false;
+    std::string version;   // "5.4" when LUA_VERSION was found
+    std::string machine;
+    std::string abi;       // lua_layout.hpp ABI name
+    unsigned integer_size = 0;  // sizeof(lua_Integer), 0 if unknown
+    unsigned number_size = 0;   // sizeof(lua_Number), 0 if unknown
+    int lua_32bits = -1;        // -1 unknown, else 0/1
+    int c89 = -1;
+    uint64_t maxstack = 0;      // 0 if unknown
+    uint64_t maxccalls = 0;
+    std::vector<std::string> evidence;
+
+    // Preprocessor options selecting this configuration in header/lua_all.h.
+    std::string parse_options() const {
+        std::string s;
+        if (lua_32bits == 1) {
+            s += "-DLUA_32BITS ";
+        }
+        if (c89 == 1) {
+            s += "-DLUA_USE_C89 ";
+        }
+        if (maxstack && maxstack != DEFAULT_MAXSTACK) {
+            s += "-DLUAI_MAXSTACK=" + std::to_string(maxstack) + " ";
+        }
+        if (maxccalls && maxccalls != DEFAULT_MAXCCALLS) {
+            s += "-DLUAI_MAXCCALLS=" + std::to_string(maxccalls) + " ";
+        }
+        if (!s.empty()) {
+            s.pop_back();
+        }
+        return s;
+    }
+
+    // Tab-separated form used by the memoization cache.
+    std::string serialize() const {
+        std::ostringstream o;
+        o << lua << '\t' << (version.empty() ? "-" : version) << '\t' << machine << '\t' << abi << '\t'
+          << integer_size << '\t' << number_size << '\t' << lua_32bits << '\t' << c89 << '\t' << maxstack << '\t'
+          << maxccalls << '\t';
+        for (size_t i = 0; i < evidence.size(); i++) {
+            o << (i ? ";" : "") << evidence[i];
+        }
+        return o.str();
+    }
+
+    static bool deserialize(const std::string &line, Fingerprint &fp) {
+        std::vector<std::string> f;
+        size_t start = 0;
+        for (;;) {
+            size_t tab = line.find('\t', start);
+            f.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+            if (tab == std::string::npos) {
+                break;
+            }
+            start = tab + 1;
+        }
+        if (f.size() != 11) {
+            return false;
+        }
+        try {
+            fp.lua = f[0] == "1";
+            fp.version = f[1] == "-" ? "" : f[1];
+            fp.machine = f[2];
+            fp.abi = f[3];
+            fp.integer_size = static_cast<unsigned>(std::stoul(f[4]));
+            fp.number_size = static_cast<unsigned>(std::stoul(f[5]));
+            fp.lua_32bits = std::stoi(f[6]);
+            fp.c89 = std::stoi(f[7]);
+            fp.maxstack = std::stoull(f[8]);
+            fp.maxccalls = std::stoull(f[9]);
+        } catch (const std::exception &) {
+            return false;
+        }
+        fp.evidence.clear();
+        std::string e;
+        std::istringstream es(f[10]);
+        while (std::getline(es, e, ';')) {
+            fp.evidence.push_back(e);
+        }
+        return true;
+    }
+};
+
+namespace detail {
+
+inline size_t count_occurrences(const uint8_t *d, size_t n, const char *needle, size_t len,
+                                bool at_string_start = false) {
+    size_t count = 0;
+    const uint8_t *p = d;
+    const uint8_t *end = d + n;
+    while (p < end) {
+        const void *hit = ::memmem(p, end - p, needle, len);
+        if (!hit) {
+            break;
+        }
+        const uint8_t *h = static_cast<const uint8_t *>(hit);
+        if (!at_string_start || h == d || h[-1] == 0) {
+            count++;
+        }
+        p = h + 1;
+    }
+    return count;
+}
+
+inline size_t count(const uint8_t *d, size_t n, const char *s, bool at_string_start = false) {
+    return count_occurrences(d, n, s, std::strlen(s) + 1, at_string_start);  // includes the NUL
+}
+
+template <typename K>
+K mode(const std::unordered_map<K, unsigned> &h, unsigned min_count, unsigned *count_out = nullptr) {
+    K best{};
+    unsigned best_n = 0;
+    for (const auto &kv : h) {
+        if (kv.second > best_n || (kv.second == best_n && kv.first < best)) {
+            best = kv.first;
+            best_n = kv.second;
+        }
+    }
+    if (count_out) {
+        *count_out = best_n;
+    }
+    return best_n >= min_count ? best : K{};
+}
+
+// sizeof(lua_Integer)*16 + sizeof(lua_Number) for 4/8-byte integers and
+// float/double/long double numbers. A 16-byte long double carries into the
+// integer's digit: 0x50 and 0x90.
+inline bool is_numsizes(uint32_t v) {
+    unsigned f = v & 0xf;
+    if (f == 4 || f == 8 || f == 12) {
+        return v >> 4 == 4 || v >> 4 == 8;
+    }
+    return v == 0x50 || v == 0x90;
+}
+
+// LUA_VERSION_NUM as an integer, a float, or the high word of a double
+inline bool is_version_anchor(uint32_t v) {
+    return v == LUA_VERSION_NUM_54 || v == 0x43fc0000u || v == 0x407f8000u;
+}
+
+// luaE_checkcstack compares against LUAI_MAXCCALLS and LUAI_MAXCCALLS / 10 * 11;
+// compilers often turn the '>=' into '>' of the value minus one. Only
+// multiples of ten are taken: every shipped configuration uses one, and
+// byte-granular x86 scanning otherwise yields spurious pairs.
+inline bool is_ccalls_pair(uint32_t c, uint32_t v) {
+    if (c < 20 || c % 10 || c > 100000) {
+        return false;
+    }
+    uint32_t hi = c / 10 * 11;
+    return v == hi || v == hi - 1;
+}
+
+// Calls fn(value) for every constant in the body of a defined function symbol.
+template <typename Fn>
+bool symbol_immediates(const common::ElfFile &elf, const char *name, Fn &&fn) {
+    const common::ElfSymbol *s = elf.find_symbol(name);
+    if (!s || !s->defined() || !s->size) {
+        return false;
+    }
+    const uint8_t *body = elf.at_vaddr(s->value & ~uint64_t(1), s->size);  // strip the Thumb bit
+    if (!body) {
+        return false;
+    }
+    common::scan_immediates(elf.machine(), elf.little_endian(), body, s->size,
+                            [&](uint64_t, uint32_t v) { fn(v); });
+    return true;
+}
+
+}  // namespace detail
+
+inline std::string abi_for(const common::ElfFile &elf) {
+    if (elf.machine() == common::EM_386) {
+        return "i386";
+    }
+    std::string a = elf.is64() ? "lp64" : "ilp32";
+    return elf.little_endian() ? a : a + "be";
+}
+
+inline Fingerprint fingerprint(const common::ElfFile &elf) {
+    Fingerprint fp;
+    fp.machine = common::machine_name(elf.machine());
+    fp.abi = abi_for(elf);
+    const uint8_t *d = elf.data();
+    const size_t n = elf.size();
+
+    // Lua presence and version
+    unsigned markers = 0;
+    for (const char *m : {"C stack overflow", "_ENV", "attempt to compare two %s values",
+                          "core and library have incompatible numeric types", "__index"}) {
+        if (detail::count(d, n, m)) {
+            markers++;
+        }
+    }
+    const char ver[] = "$LuaVersion: Lua ";
+    const void *vh = ::memmem(d, n, ver, sizeof ver - 1);
+    if (vh) {
+        markers += 2;
+    }
+    const char ver2[] = "Lua 5.";  // LUA_VERSION, "Lua 5.x" then NUL
+    for (const uint8_t *p = d; p < d + n;) {
+        const void *h = ::memmem(p, d + n - p, ver2, sizeof ver2 - 1);
+        if (!h) {
+            break;
+        }
+        const uint8_t *q = static_cast<const uint8_t *>(h) + sizeof ver2 - 1;
+        if (q + 1 < d + n && q[0] >= '0' && q[0] <= '9' && q[1] == 0) {
+            fp.version = std::string("5.") + char(q[0]);
+            break;
+        }
+        p = static_cast<const uint8_t *>(h) + 1;
+    }
+    fp.lua = markers >= 2;
+    if (!fp.lua) {
+        return fp;
+    }
+
+    // Format strings (luaconf.h LUAI_NUMFFORMAT / LUA_INTEGER_FMT)
+    size_t f_double = detail::count(d, n, "%.14g");
+    size_t f_float = detail::count(d, n, "%.7g");
+    size_t f_ldouble = detail::count(d, n, "%.19Lg");
+    size_t f_lld = detail::count(d, n, "%lld", true);
+    size_t f_ld = detail::count(d, n, "%ld", true);
+    if (f_double) {
+        fp.evidence.push_back("fmt:%.14g");
+    }
+    if (f_float) {
+        fp.evidence.push_back("fmt:%.7g");
+    }
+    if (f_ldouble) {
+        fp.evidence.push_back("fmt:%.19Lg");
+    }
+    if (f_lld) {
+        fp.evidence.push_back("fmt:%lld");
+    }
+    if (f_ld) {
+        fp.evidence.push_back("fmt:%ld");
+    }
+
+    // LUAC_NUM in constant pools
+    unsigned luac_num_double = 0, luac_num_float = 0;
+    for (const common::ElfSection &s : elf.sections()) {
+        const uint8_t *p = elf.section_data(s);
+        if (!p || !s.alloc() || s.exec()) {
+            continue;
+        }
+        for (uint64_t o = 0; o + 8 <= s.size; o += 4) {
+            uint64_t v = elf.decode(p + o, 8);
+            if ((o & 7) == 0 && v == 0x4077290000000000ULL) {
+                luac_num_double++;
+            }
+            if (elf.decode(p + o, 4) == 0x43b94000u) {
+                luac_num_float++;
+            }
+        }
+    }
+
+    // Code immediates: one pass over every executable section
+    std::unordered_map<int32_t, unsigned> registry;     // LUA_REGISTRYINDEX candidates
+    std::unordered_map<uint32_t, unsigned> ccalls;      // LUAI_MAXCCALLS candidates
+    std::unordered_map<uint32_t, unsigned> numsizes;    // LUAL_NUMSIZES candidates
+    struct Recent {
+        uint64_t off;
+        uint32_t v;
+    };
+    std::deque<Recent> recent;
+    auto on_code = [&](uint64_t base, uint64_t off, uint32_t v) {
+        uint64_t at = base + off;
+        int32_t sv = static_cast<int32_t>(v);
+        if (sv <= -2000 && sv >= -(1 << 26)) {
+            registry[sv]++;
+        }
+        if (v == 0x43b94000u) {
+            luac_num_float++;
+        } else if (v == 0x40772900u) {
+            luac_num_double++;
+        }
+        if (v > 0x1000000 && !detail::is_version_anchor(v)) {
+            return;
+        }
+        while (!recent.empty() && (at < recent.front().off || at - recent.front().off > 96)) {
+            recent.pop_front();
+        }
+        for (const Recent &r : recent) {
+            if (detail::is_ccalls_pair(r.v, v)) {
+                ccalls[r.v]++;
+            } else if (detail::is_ccalls_pair(v, r.v)) {
+                ccalls[v]++;
+            }
+            // luaL_checkversion_(L, LUA_VERSION_NUM, LUAL_NUMSIZES)
+            if (at - r.off <= 32) {
+                if (detail::is_version_anchor(r.v) && detail::is_numsizes(v)) {
+                    numsizes[v]++;
+                } else if (detail::is_version_anchor(v) && detail::is_numsizes(r.v)) {
+                    numsizes[r.v]++;
+                }
+            }
+        }
+        if (recent.size() >= 48) {
+            recent.pop_front();
+        }
+        recent.push_back({at, v});
+    };
+    bool any_exec = false;
+    for (const common::ElfSection &s : elf.sections()) {
+        const uint8_t *p = elf.section_data(s);
+        if (!p || !s.exec()) {
+            continue;
+        }
+        any_exec = true;
+        recent.clear();
+        common::scan_immediates(elf.machine(), elf.little_endian(), p, s.size,
+                                [&](uint64_t off, uint32_t v) { on_code(s.offset, off, v); });
+    }
+    if (!any_exec) {  // stripped section headers: fall back to executable segments
+        for (const common::ElfProgramHeader &ph : elf.segments()) {
+            if (ph.type != 1 || !(ph.flags & 1) || ph.offset + ph.filesz > n) {
+                continue;
+            }
+            recent.clear();
+            common::scan_immediates(elf.machine(), elf.little_endian(), d + ph.offset, ph.filesz,
+                                    [&](uint64_t off, uint32_t v) { on_code(ph.offset, off, v); });
+        }
+    }
+
+    unsigned reg_n = 0, cc_n = 0, ns_n = 0;
+    int32_t reg = detail::mode(registry, 3, &reg_n);
+    uint32_t cc = detail::mode(ccalls, 1, &cc_n);
+    uint32_t ns = detail::mode(numsizes, 1, &ns_n);
+
+    // Symbols, when present, pin the values down inside the defining functions.
+    std::unordered_map<uint32_t, unsigned> sym_ns, sym_cc;
+    std::vector<uint32_t> sym_stack;
+    detail::symbol_immediates(elf, "luaL_checkversion_", [&](uint32_t v) {
+        if (detail::is_numsizes(v)) {
+            sym_ns[v]++;
+        }
+    });
+    std::vector<uint32_t> cstack;
+    detail::symbol_immediates(elf, "luaE_checkcstack", [&](uint32_t v) { cstack.push_back(v); });
+    for (uint32_t c : cstack) {
+        for (uint32_t v : cstack) {
+            if (detail::is_ccalls_pair(c, v)) {
+                sym_cc[c]++;
+            }
+        }
+    }
+    detail::symbol_immediates(elf, "lua_checkstack", [&](uint32_t v) {
+        if (v >= 1000 && v <= (1u << 26)) {
+            sym_stack.push_back(v);
+        }
+    });
+
+    if (reg) {
+        fp.maxstack = static_cast<uint64_t>(-int64_t(reg) - 1000);
+        fp.evidence.push_back("LUA_REGISTRYINDEX=" + std::to_string(reg) + "x" + std::to_string(reg_n));
+    }
+    if (fp.maxstack && std::find(sym_stack.begin(), sym_stack.end(), fp.maxstack) != sym_stack.end()) {
+        fp.evidence.push_back("lua_checkstack:confirmed");
+    } else if (!fp.maxstack && !sym_stack.empty()) {
+        fp.maxstack = *std::max_element(sym_stack.begin(), sym_stack.end());
+        fp.evidence.push_back("lua_checkstack:" + std::to_string(fp.maxstack));
+    }
+    if (uint32_t c = detail::mode(sym_cc, 1)) {
+        fp.maxccalls = c;
+        fp.evidence.push_back("luaE_checkcstack:" + std::to_string(c));
+    } else if (cc) {
+        fp.maxccalls = cc;
+        fp.evidence.push_back("LUAI_MAXCCALLS-pair=" + std::to_string(cc) + "x" + std::to_string(cc_n));
+    }
+    if (uint32_t v = detail::mode(sym_ns, 1)) {
+        ns = v;
+        fp.evidence.push_back("luaL_checkversion_:0x" + common::hex64(ns).substr(14));
+    } else if (ns) {
+        fp.evidence.push_back("LUAL_NUMSIZES=0x" + common::hex64(ns).substr(14) + "x" + std::to_string(ns_n));
+    }
+    if (ns) {
+        fp.number_size = (ns & 0xf) ? ns & 0xf : 16;
+        fp.integer_size = (ns - fp.number_size) >> 4;
+    }
+    if (luac_num_double) {
+        fp.evidence.push_back("LUAC_NUM:double");
+    }
+    if (luac_num_float) {
+        fp.evidence.push_back("LUAC_NUM:float");
+    }
+
+    // sizeof(lua_Number)
+    if (!fp.number_size) {
+        if (f_float && !f_double) {
+            fp.number_size = 4;
+        } else if (f_double && !f_float) {
+            fp.number_size = 8;
+        } else if (f_ldouble && !f_double) {
+            fp.number_size = elf.is64() ? 16 : 12;
+        } else if (luac_num_float && !luac_num_double) {
+            fp.number_size = 4;
+        } else if (luac_num_double && !luac_num_float) {
+            fp.number_size = 8;
+        }
+    }
+    // sizeof(lua_Integer): long long unless the formats say 'long' or 'int'
+    const unsigned long_size = elf.is64() ? 8 : 4;
+    bool fmt_long = f_ld && !f_lld;
+    if (!fp.integer_size) {
+        if (f_lld) {
+            fp.integer_size = 8;
+        } else if (fp.number_size == 4) {
+            fp.integer_size = 4;
+        } else if (fmt_long) {
+            fp.integer_size = long_size;
+        }
+    }
+
+    if (fp.number_size == 4 && fp.integer_size == 4) {
+        fp.lua_32bits = 1;
+        fp.c89 = -1;  // LUA_32BITS takes precedence over LUA_C89_NUMBERS
+    } else if (fp.number_size == 8) {
+        fp.lua_32bits = 0;
+        if (fp.integer_size == 8 && !fmt_long) {
+            fp.c89 = long_size == 8 && !f_lld ? -1 : 0;
+        } else if (fmt_long || (fp.integer_size == 4 && long_size == 4)) {
+            fp.c89 = 1;
+        }
+    }
+    return fp;
+}
+
+}  // namespace lua
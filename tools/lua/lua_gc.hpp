@@ -0,0 +1,321 @@
+/*
+ *   Collector state and collectable objects of a Lua heap inside a memory dump.
+ *
+ *   Tag values, GC states and age bits mirror "// lobject.h", "// lstate.h"
+ *   and "// lgc.h" in header/lua_all.h.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/memory_image.hpp"
+#include "lua/lua_layout.hpp"
+
+
+namespace lua {
+
+// Variant tags of collectable objects (makevariant(t, v) = t | v << 4).
+constexpr uint8_t LUA_VSHRSTR = 0x04;
+constexpr uint8_t LUA_VLNGSTR = 0x14;
+constexpr uint8_t LUA_VTABLE = 0x05;
+constexpr uint8_t LUA_VLCL = 0x06;
+constexpr uint8_t LUA_VCCL = 0x26;
+constexpr uint8_t LUA_VUSERDATA = 0x07;
+constexpr uint8_t LUA_VTHREAD = 0x08;
+constexpr uint8_t LUA_VUPVAL = 0x09;
+constexpr uint8_t LUA_VPROTO = 0x0a;
+
+// Dense index used for per-type statistics.
+enum ObjKind { K_SHRSTR, K_LNGSTR, K_TABLE, K_LCL, K_CCL, K_USERDATA, K_THREAD, K_UPVAL, K_PROTO, K_OTHER, K_COUNT };
+
+inline ObjKind kind_of(uint8_t tt) {
+    switch (tt) {
+    case LUA_VSHRSTR: return K_SHRSTR;
+    case LUA_VLNGSTR: return K_LNGSTR;
+    case LUA_VTABLE: return K_TABLE;
+    case LUA_VLCL: return K_LCL;
+    case LUA_VCCL: return K_CCL;
+    case LUA_VUSERDATA: return K_USERDATA;
+    case LUA_VTHREAD: return K_THREAD;
+    case LUA_VUPVAL: return K_UPVAL;
+    case LUA_VPROTO: return K_PROTO;
+    default: return K_OTHER;
+    }
+}
+
+inline const char *kind_name(int k) {
+    static const char *const names[K_COUNT] = {"shrstr", "lngstr", "table", "lclosure", "cclosure",
+                                               "userdata", "thread", "upval", "proto", "other"};
+    return (k >= 0 && k < K_COUNT) ? names[k] : "?";
+}
+
+// lgc.h: GCS* states
+inline const char *gcstate_name(unsigned s) {
+    static const char *const names[] = {"GCSpropagate", "GCSenteratomic", "GCSatomic", "GCSswpallgc", "GCSswpfinobj",
+                                        "GCSswptobefnz", "GCSswpend", "GCScallfin", "GCSpause"};
+    return s < 9 ? names[s] : "?";
+}
+
+// lgc.h: G_* ages (marked & AGEBITS)
+constexpr unsigned AGE_COUNT = 8;
+constexpr uint8_t AGEBITS = 7;
+inline const char *age_name(unsigned a) {
+    static const char *const names[AGE_COUNT] = {"G_NEW", "G_SURVIVAL", "G_OLD0", "G_OLD1",
+                                                 "G_OLD", "G_TOUCHED1", "G_TOUCHED2", "?7"};
+    return names[a & AGEBITS];
+}
+
+// lgc.h / lstate.h defaults
+constexpr unsigned LUAI_GCPAUSE = 200;
+constexpr unsigned LUAI_GCMUL = 100;
+constexpr unsigned LUAI_GCSTEPSIZE = 13;
+constexpr unsigned LUAI_GENMAJORMUL = 100;
+constexpr unsigned LUAI_GENMINORMUL = 20;
+constexpr unsigned KGC_INC = 0;
+constexpr unsigned KGC_GEN = 1;
+constexpr unsigned EXTRA_STACK = 5;
+
+// Decoded global_State scalars and list heads.
+struct GlobalState {
+    uint64_t addr = 0;
+    int64_t totalbytes = 0;
+    int64_t GCdebt = 0;
+    uint64_t GCestimate = 0;
+    uint64_t lastatomic = 0;
+    unsigned currentwhite = 0, gcstate = 0, gckind = 0, gcstopem = 0;
+    unsigned genminormul = 0, genmajormul = 0, gcrunning = 0, gcemergency = 0;
+    unsigned gcpause = 0, gcstepmul = 0, gcstepsize = 0;
+    uint64_t allgc = 0, finobj = 0, tobefnz = 0, fixedgc = 0;
+    uint64_t survival = 0, old1 = 0, reallyold = 0, firstold1 = 0;
+    uint64_t finobjsur = 0, finobjold1 = 0, finobjrold = 0;
+    uint64_t mainthread = 0;
+
+    // gettotalbytes(g)
+    uint64_t total() const { return static_cast<uint64_t>(totalbytes + GCdebt); }
+};
+
+class Heap {
+  public:
+    Heap(const common::MemoryImage &img, const Layouts &lay) : img_(img), lay_(lay) {
+        P = lay.scalars().ptr;
+        o_tt = lay.offset("GCObject", "tt");
+        o_marked = lay.offset("GCObject", "marked");
+        o_ts_shrlen = lay.offset("TString", "shrlen");
+        o_ts_u = lay.offset("TString", "u");
+        o_ts_contents = lay.offset("TString", "contents");
+        o_t_flags = lay.offset("Table", "flags");
+        o_t_lsizenode = lay.offset("Table", "lsizenode");
+        o_t_alimit = lay.offset("Table", "alimit");
+        o_t_lastfree = lay.offset("Table", "lastfree");
+        o_u_nuvalue = lay.offset("Udata", "nuvalue");
+        o_u_len = lay.offset("Udata", "len");
+        o_u_uv = lay.offset("Udata", "uv");
+        o_u0_bindata = lay.offset("Udata0", "bindata");
+        o_cl_nupvalues = lay.offset("LClosure", "nupvalues");
+        o_lcl_upvals = lay.offset("LClosure", "upvals");
+        o_ccl_upvalue = lay.offset("CClosure", "upvalue");
+        o_th_nci = lay.offset("lua_State", "nci");
+        o_th_stack = lay.offset("lua_State", "stack");
+        o_th_stack_last = lay.offset("lua_State", "stack_last");
+        o_th_l_G = lay.offset("lua_State", "l_G");
+        const StructLayout &pr = lay.get("Proto");
+        for (const char *f : {"sizeupvalues", "sizek", "sizecode", "sizelineinfo", "sizep", "sizelocvars",
+                              "sizeabslineinfo"}) {
+            o_p_sizes.push_back(pr.offset(f));
+        }
+        s_tvalue = lay.size("TValue");
+        s_node = lay.size("Node");
+        s_table = lay.size("Table");
+        s_uvalue = lay.size("UValue");
+        s_upval = lay.size("UpVal");
+        s_proto = lay.size("Proto");
+        s_locvar = lay.size("LocVar");
+        s_upvaldesc = lay.size("Upvaldesc");
+        s_absline = lay.size("AbsLineInfo");
+        s_stackvalue = lay.size("StackValue");
+        s_callinfo = lay.size("CallInfo");
+        s_lx = lay.size("LX");
+        lx_l = lay.offset("LX", "l");
+        const StructLayout &gs = lay.get("global_State");
+        // lstate.c: LG { LX l; global_State g; }
+        lg_g = (s_lx + gs.align - 1) / gs.align * gs.align;
+    }
+
+    const common::MemoryImage &image() const { return img_; }
+    const Layouts &layouts() const { return lay_; }
+
+    uint64_t ptr(uint64_t addr) const { return img_.read_or(addr, P, 0); }
+    uint64_t u8(uint64_t addr) const { return img_.read_or(addr, 1, 0); }
+
+    GlobalState global(uint64_t g) const {
+        const StructLayout &L = lay_.get("global_State");
+        auto rd = [&](const char *f) { return img_.read_or(g + L.offset(f), static_cast<unsigned>(field_size(L, f)), 0); };
+        auto sgn = [&](uint64_t v) { return P == 4 ? int64_t(int32_t(uint32_t(v))) : int64_t(v); };
+        GlobalState s;
+        s.addr = g;
+        s.totalbytes = sgn(rd("totalbytes"));
+        s.GCdebt = sgn(rd("GCdebt"));
+        s.GCestimate = rd("GCestimate");
+        s.lastatomic = rd("lastatomic");
+        s.currentwhite = unsigned(rd("currentwhite"));
+        s.gcstate = unsigned(rd("gcstate"));
+        s.gckind = unsigned(rd("gckind"));
+        s.gcstopem = unsigned(rd("gcstopem"));
+        s.genminormul = unsigned(rd("genminormul"));
+        s.genmajormul = unsigned(rd("genmajormul"));
+        s.gcrunning = unsigned(rd("gcrunning"));
+        s.gcemergency = unsigned(rd("gcemergency"));
+        s.gcpause = unsigned(rd("gcpause"));
+        s.gcstepmul = unsigned(rd("gcstepmul"));
+        s.gcstepsize = unsigned(rd("gcstepsize"));
+        s.allgc = rd("allgc");
+        s.finobj = rd("finobj");
+        s.tobefnz = rd("tobefnz");
+        s.fixedgc = rd("fixedgc");
+        s.survival = rd("survival");
+        s.old1 = rd("old1");
+        s.reallyold = rd("reallyold");
+        s.firstold1 = rd("firstold1");
+        s.finobjsur = rd("finobjsur");
+        s.finobjold1 = rd("finobjold1");
+        s.finobjrold = rd("finobjrold");
+        s.mainthread = rd("mainthread");
+        return s;
+    }
+
+    // global_State of the thread at 'L' (lua_State.l_G).
+    uint64_t global_of(uint64_t L) const { return ptr(L + o_th_l_G); }
+
+    // Finds main threads by their allocation shape: luaL_newstate allocates
+    // LG { LX l; global_State g; } in one block, so a main thread is a
+    // LUA_VTHREAD object whose l_G points a fixed distance past itself and
+    // whose global_State names it as mainthread.
+    std::vector<uint64_t> find_globals() const {
+        std::vector<uint64_t> out;
+        const uint64_t delta = lg_g - lx_l;
+        const uint64_t o_main = lay_.offset("global_State", "mainthread");
+        const uint64_t span = o_th_l_G + P;
+        for (const common::Segment &s : img_.segments()) {
+            if (s.size < span) {
+                continue;
+            }
+            uint64_t first = (s.vaddr + P - 1) / P * P;
+            for (uint64_t a = first; a + span <= s.vaddr + s.size; a += P) {
+                if (s.data[a - s.vaddr + o_tt] != LUA_VTHREAD) {
+                    continue;
+                }
+                uint64_t g = img_.decode(s.data + (a - s.vaddr) + o_th_l_G, P);
+                if (g != a + delta) {
+                    continue;
+                }
+                if (ptr(g + o_main) == a) {
+                    out.push_back(g);
+                }
+            }
+        }
+        return out;
+    }
+
+    // Bytes owned by the object at 'o' with variant tag 'tt', using the same
+    // formulas as the corresponding luaM_free calls in lgc.c:freeobj.
+    uint64_t object_size(uint64_t o, uint8_t tt) const {
+        switch (tt) {
+        case LUA_VSHRSTR:
+            return o_ts_contents + u8(o + o_ts_shrlen) + 1;
+        case LUA_VLNGSTR:
+            return o_ts_contents + img_.read_or(o + o_ts_u, P, 0) + 1;
+        case LUA_VTABLE: {
+            uint64_t sz = s_table;
+            if (ptr(o + o_t_lastfree) != 0) {  // !isdummy(t)
+                sz += (uint64_t(1) << (u8(o + o_t_lsizenode) & 31)) * s_node;
+            }
+            uint64_t asize = img_.read_or(o + o_t_alimit, 4, 0);
+            if ((u8(o + o_t_flags) & 0x80) && asize) {  // !isrealasize(t)
+                asize = ceil_pow2(asize);
+            }
+            return sz + asize * s_tvalue;
+        }
+        case LUA_VLCL:
+            return o_lcl_upvals + uint64_t(P) * u8(o + o_cl_nupvalues);
+        case LUA_VCCL:
+            return o_ccl_upvalue + s_tvalue * u8(o + o_cl_nupvalues);
+        case LUA_VUSERDATA: {
+            uint64_t nuv = img_.read_or(o + o_u_nuvalue, 2, 0);
+            uint64_t base = nuv == 0 ? o_u0_bindata : o_u_uv + s_uvalue * nuv;
+            return base + img_.read_or(o + o_u_len, P, 0);
+        }
+        case LUA_VTHREAD: {
+            uint64_t stack = ptr(o + o_th_stack), last = ptr(o + o_th_stack_last);
+            uint64_t slots = last > stack ? (last - stack) / s_stackvalue + EXTRA_STACK : 0;
+            return s_lx + slots * s_stackvalue + img_.read_or(o + o_th_nci, 2, 0) * s_callinfo;
+        }
+        case LUA_VUPVAL:
+            return s_upval;
+        case LUA_VPROTO: {
+            auto n = [&](int i) { return uint64_t(uint32_t(img_.read_or(o + o_p_sizes[i], 4, 0))); };
+            return s_proto + n(0) * s_upvaldesc + n(1) * s_tvalue + n(2) * 4 + n(3) + n(4) * P + n(5) * s_locvar +
+                   n(6) * s_absline;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    // Walks a 'next'-linked GC list. fn(addr, tt, marked) returns false to stop.
+    // Stops at NULL, at an unreadable object, or after 'limit' objects (which
+    // guards against corrupted, cyclic lists). Returns the number visited.
+    template <typename Fn>
+    uint64_t walk(uint64_t head, uint64_t limit, Fn &&fn, bool *broken = nullptr) const {
+        uint64_t n = 0;
+        for (uint64_t o = head; o != 0; n++) {
+            const uint8_t *h = img_.at(o, o_marked + 1);
+            if (!h || n >= limit) {
+                if (broken) {
+                    *broken = true;
+                }
+                break;
+            }
+            uint8_t tt = h[o_tt];
+            if (!fn(o, tt, h[o_marked])) {
+                break;
+            }
+            o = img_.decode(h, P);
+        }
+        return n;
+    }
+
+  private:
+    static uint64_t field_size(const StructLayout &s, const char *f) {
+        for (const Field &x : s.fields) {
+            if (x.name == f) {
+                return x.size;
+            }
+        }
+        return 0;
+    }
+
+    static uint64_t ceil_pow2(uint64_t x) {
+        uint64_t p = 1;
+        while (p < x) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    const common::MemoryImage &img_;
+    const Layouts &lay_;
+    unsigned P;
+    uint64_t o_tt, o_marked, o_ts_shrlen, o_ts_u, o_ts_contents;
+    uint64_t o_t_flags, o_t_lsizenode, o_t_alimit, o_t_lastfree;
+    uint64_t o_u_nuvalue, o_u_len, o_u_uv, o_u0_bindata;
+    uint64_t o_cl_nupvalues, o_lcl_upvals, o_ccl_upvalue;
+    uint64_t o_th_nci, o_th_stack, o_th_stack_last, o_th_l_G;
+    std::vector<uint64_t> o_p_sizes;
+    uint64_t s_tvalue, s_node, s_table, s_uvalue, s_upval, s_proto, s_locvar, s_upvaldesc, s_absline;
+    uint64_t s_stackvalue, s_callinfo, s_lx, lx_l, lg_g;
+};
+
+}  // namespace lua
@@ -0,0 +1,378 @@
+/*
+ *   Struct layouts of the Lua internals declared in header/lua_all.h, computed
+ *   for a target ABI and luaconf.h configuration.
+ *
+ *   The declarations follow the pinned Lua commit (9db4bfed); keep the field
+ *   lists below in the same order as the structs in lua_all.h.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace lua {
+
+// Target C ABI. Pointers, size_t and ptrdiff_t share one width.
+struct Abi {
+    unsigned ptr = 8;
+    unsigned long_size = 8;
+    unsigned llong_align = 8;
+    unsigned double_align = 8;
+    bool little_endian = true;
+
+    static Abi lp64() { return Abi{}; }
+    // 32-bit ARM/MIPS/PowerPC style: 8-byte alignment for 64-bit scalars.
+    static Abi ilp32() { return Abi{4, 4, 8, 8, true}; }
+    // i386 System V: 64-bit scalars are only 4-byte aligned inside structs.
+    static Abi i386() { return Abi{4, 4, 4, 4, true}; }
+
+    static Abi named(const std::string &name) {
+        if (name == "lp64") {
+            return lp64();
+        }
+        if (name == "ilp32") {
+            return ilp32();
+        }
+        if (name == "i386") {
+            return i386();
+        }
+        if (name == "ilp32be") {
+            Abi a = ilp32();
+            a.little_endian = false;
+            return a;
+        }
+        if (name == "lp64be") {
+            Abi a = lp64();
+            a.little_endian = false;
+            return a;
+        }
+        throw std::runtime_error("unknown ABI '" + name + "' (lp64, lp64be, ilp32, ilp32be, i386)");
+    }
+};
+
+// The luaconf.h switches that change type sizes (see "// luaconf.h").
+struct Config {
+    bool lua_32bits = false;  // LUA_32BITS
+    bool c89 = false;         // LUA_USE_C89
+
+    std::string describe() const {
+        std::string s;
+        if (lua_32bits) {
+            s += "-DLUA_32BITS ";
+        }
+        if (c89) {
+            s += "-DLUA_USE_C89 ";
+        }
+        if (!s.empty()) {
+            s.pop_back();
+        }
+        return s.empty() ? "(default)" : s;
+    }
+};
+
+struct Field {
+    std::string name;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct StructLayout {
+    std::string name;
+    uint64_t size = 0;
+    uint64_t align = 1;
+    std::vector<Field> fields;
+
+    uint64_t offset(const std::string &field) const {
+        for (const Field &f : fields) {
+            if (f.name == field) {
+                return f.offset;
+            }
+        }
+        throw std::runtime_error(name + " has no field '" + field + "'");
+    }
+};
+
+// Scalar sizes/alignments derived from the ABI and configuration.
+struct Scalars {
+    unsigned ptr, ptr_align;
+    unsigned integer, integer_align;  // lua_Integer
+    unsigned number, number_align;    // lua_Number
+    unsigned maxalign_size, maxalign; // union { LUAI_MAXALIGN; }
+
+    Scalars(const Abi &abi, const Config &cfg) {
+        ptr = ptr_align = abi.ptr;
+        if (cfg.lua_32bits) {
+            integer = integer_align = 4;
+            number = number_align = 4;
+        } else if (cfg.c89) {
+            integer = integer_align = abi.long_size;
+            number = 8;
+            number_align = abi.double_align;
+        } else {
+            integer = 8;
+            integer_align = abi.llong_align;
+            number = 8;
+            number_align = abi.double_align;
+        }
+        // LUAI_MAXALIGN: lua_Number n; double u; void *s; lua_Integer i; long l
+        maxalign = std::max({number_align, abi.double_align, ptr_align, integer_align, abi.long_size});
+        unsigned sz = std::max({number, 8u, ptr, integer, abi.long_size});
+        maxalign_size = (sz + maxalign - 1) / maxalign * maxalign;
+    }
+};
+
+class StructBuilder {
+  public:
+    explicit StructBuilder(std::string name) { s_.name = std::move(name); }
+
+    StructBuilder &add(const std::string &name, uint64_t size, uint64_t align) {
+        uint64_t off = (s_.size + align - 1) / align * align;
+        s_.fields.push_back({name, off, size});
+        s_.size = off + size;
+        s_.align = std::max(s_.align, align);
+        return *this;
+    }
+
+    StructBuilder &add(const std::string &name, const StructLayout &nested, uint64_t count = 1) {
+        return add(name, nested.size * count, nested.align);
+    }
+
+    StructLayout finish() {
+        s_.size = (s_.size + s_.align - 1) / s_.align * s_.align;
+        return s_;
+    }
+
+  private:
+    StructLayout s_;
+};
+
+// Members of a union all start at offset 0.
+inline StructLayout make_union(const std::string &name, const std::vector<Field> &members,
+                               uint64_t align) {
+    StructLayout u;
+    u.name = name;
+    u.align = align;
+    for (const Field &f : members) {
+        u.fields.push_back({f.name, 0, f.size});
+        u.size = std::max(u.size, f.size);
+    }
+    u.size = (u.size + align - 1) / align * align;
+    return u;
+}
+
+constexpr unsigned TM_N = 25;
+constexpr unsigned LUA_NUMTAGS = 9;
+constexpr unsigned STRCACHE_N = 53;
+constexpr unsigned STRCACHE_M = 2;
+
+class Layouts {
+  public:
+    Layouts(const Abi &abi, const Config &cfg) : abi_(abi), cfg_(cfg), sc_(abi, cfg) { build(); }
+
+    const Abi &abi() const { return abi_; }
+    const Config &config() const { return cfg_; }
+    const Scalars &scalars() const { return sc_; }
+
+    const StructLayout &get(const std::string &name) const {
+        auto it = structs_.find(name);
+        if (it == structs_.end()) {
+            throw std::runtime_error("no layout for '" + name + "'");
+        }
+        return it->second;
+    }
+
+    uint64_t offset(const std::string &s, const std::string &field) const { return get(s).offset(field); }
+    uint64_t size(const std::string &s) const { return get(s).size; }
+
+    const std::map<std::string, StructLayout> &all() const { return structs_; }
+
+  private:
+    void put(const StructLayout &s) { structs_[s.name] = s; }
+
+    // CommonHeader: struct GCObject *next; lu_byte tt; lu_byte marked
+    StructBuilder header(const std::string &name) const {
+        StructBuilder b(name);
+        b.add("next", sc_.ptr, sc_.ptr_align).add("tt", 1, 1).add("marked", 1, 1);
+        return b;
+    }
+
+    void build() {
+        const unsigned P = sc_.ptr, PA = sc_.ptr_align;
+
+        put(header("GCObject").finish());
+
+        unsigned value_align = std::max({PA, sc_.integer_align, sc_.number_align});
+        StructLayout value = make_union(
+            "Value", {{"gc", 0, P}, {"p", 0, P}, {"f", 0, P}, {"i", 0, sc_.integer}, {"n", 0, sc_.number}},
+            value_align);
+        put(value);
+
+        StructLayout tvalue = StructBuilder("TValue").add("value_", value).add("tt_", 1, 1).finish();
+        put(tvalue);
+
+        StructLayout tbclist =
+            StructBuilder("StackValue.tbclist").add("value_", value).add("tt_", 1, 1).add("delta", 2, 2).finish();
+        put(make_union("StackValue", {{"val", 0, tvalue.size}, {"tbclist", 0, tbclist.size}},
+                       std::max(tvalue.align, tbclist.align)));
+
+        put(header("TString")
+                .add("extra", 1, 1)
+                .add("shrlen", 1, 1)
+                .add("hash", 4, 4)
+                .add("u", P, PA)
+                .add("contents", 1, 1)
+                .finish());
+
+        StructLayout uvalue = make_union("UValue", {{"uv", 0, tvalue.size}, {"maxalign", 0, sc_.maxalign_size}},
+                                         std::max<uint64_t>(tvalue.align, sc_.maxalign));
+        put(uvalue);
+
+        put(header("Udata")
+                .add("nuvalue", 2, 2)
+                .add("len", P, PA)
+                .add("metatable", P, PA)
+                .add("gclist", P, PA)
+                .add("uv", uvalue)
+                .finish());
+        put(header("Udata0")
+                .add("nuvalue", 2, 2)
+                .add("len", P, PA)
+                .add("metatable", P, PA)
+                .add("bindata", sc_.maxalign_size, sc_.maxalign)
+                .finish());
+
+        put(StructBuilder("Upvaldesc").add("name", P, PA).add("instack", 1, 1).add("idx", 1, 1).add("kind", 1, 1).finish());
+        put(StructBuilder("LocVar").add("varname", P, PA).add("startpc", 4, 4).add("endpc", 4, 4).finish());
+        put(StructBuilder("AbsLineInfo").add("pc", 4, 4).add("line", 4, 4).finish());
+
+        StructBuilder proto = header("Proto");
+        proto.add("numparams", 1, 1).add("is_vararg", 1, 1).add("maxstacksize", 1, 1);
+        for (const char *f : {"sizeupvalues", "sizek", "sizecode", "sizelineinfo", "sizep", "sizelocvars",
+                              "sizeabslineinfo", "linedefined", "lastlinedefined"}) {
+            proto.add(f, 4, 4);
+        }
+        for (const char *f : {"k", "code", "p", "upvalues", "lineinfo", "abslineinfo", "locvars", "source", "gclist"}) {
+            proto.add(f, P, PA);
+        }
+        put(proto.finish());
+
+        StructLayout open = StructBuilder("UpVal.open").add("next", P, PA).add("previous", P, PA).finish();
+        StructLayout upu = make_union("UpVal.u", {{"open", 0, open.size}, {"value", 0, tvalue.size}},
+                                      std::max(open.align, tvalue.align));
+        put(header("UpVal").add("tbc", 1, 1).add("v", P, PA).add("u", upu).finish());
+
+        // ClosureHeader: CommonHeader; lu_byte nupvalues; GCObject *gclist
+        put(header("CClosure").add("nupvalues", 1, 1).add("gclist", P, PA).add("f", P, PA).add("upvalue", tvalue).finish());
+        put(header("LClosure").add("nupvalues", 1, 1).add("gclist", P, PA).add("p", P, PA).add("upvals", P, PA).finish());
+
+        StructLayout nodekey = StructBuilder("NodeKey")
+                                   .add("value_", value)
+                                   .add("tt_", 1, 1)
+                                   .add("key_tt", 1, 1)
+                                   .add("next", 4, 4)
+                                   .add("key_val", value)
+                                   .finish();
+        put(nodekey);
+        put(make_union("Node", {{"u", 0, nodekey.size}, {"i_val", 0, tvalue.size}},
+                       std::max(nodekey.align, tvalue.align)));
+
+        put(header("Table")
+                .add("flags", 1, 1)
+                .add("lsizenode", 1, 1)
+                .add("alimit", 4, 4)
+                .add("array", P, PA)
+                .add("node", P, PA)
+                .add("lastfree", P, PA)
+                .add("metatable", P, PA)
+                .add("gclist", P, PA)
+                .finish());
+
+        StructLayout strt = StructBuilder("stringtable").add("hash", P, PA).add("nuse", 4, 4).add("size", 4, 4).finish();
+        put(strt);
+
+        // CallInfo.u.l: savedpc, trap (sig_atomic_t), nextraargs
+        // CallInfo.u.c: k, old_errfunc (ptrdiff_t), ctx (lua_KContext)
+        StructLayout ul = StructBuilder("CallInfo.u.l").add("savedpc", P, PA).add("trap", 4, 4).add("nextraargs", 4, 4).finish();
+        StructLayout uc = StructBuilder("CallInfo.u.c").add("k", P, PA).add("old_errfunc", P, PA).add("ctx", P, PA).finish();
+        StructLayout cu = make_union("CallInfo.u", {{"l", 0, ul.size}, {"c", 0, uc.size}}, std::max(ul.align, uc.align));
+        StructLayout ci = StructBuilder("CallInfo")
+                              .add("func", P, PA)
+                              .add("top", P, PA)
+                              .add("previous", P, PA)
+                              .add("next", P, PA)
+                              .add("u", cu)
+                              .add("u2", 4, 4)
+                              .add("nresults", 2, 2)
+                              .add("callstatus", 2, 2)
+                              .finish();
+        put(ci);
+
+        StructBuilder g("global_State");
+        g.add("frealloc", P, PA).add("ud", P, PA);
+        for (const char *f : {"totalbytes", "GCdebt", "GCestimate", "lastatomic"}) {
+            g.add(f, P, PA);  // l_mem / lu_mem are ptrdiff_t / size_t
+        }
+        g.add("strt", strt).add("l_registry", tvalue).add("nilvalue", tvalue).add("seed", 4, 4);
+        for (const char *f : {"currentwhite", "gcstate", "gckind", "gcstopem", "genminormul", "genmajormul",
+                              "gcrunning", "gcemergency", "gcpause", "gcstepmul", "gcstepsize"}) {
+            g.add(f, 1, 1);
+        }
+        for (const char *f : {"allgc", "sweepgc", "finobj", "gray", "grayagain", "weak", "ephemeron", "allweak",
+                              "tobefnz", "fixedgc", "survival", "old1", "reallyold", "firstold1", "finobjsur",
+                              "finobjold1", "finobjrold", "twups", "panic", "mainthread", "memerrmsg"}) {
+            g.add(f, P, PA);
+        }
+        g.add("tmname", uint64_t(P) * TM_N, PA)
+            .add("mt", uint64_t(P) * LUA_NUMTAGS, PA)
+            .add("strcache", uint64_t(P) * STRCACHE_N * STRCACHE_M, PA)
+            .add("warnf", P, PA)
+            .add("ud_warn", P, PA);
+        put(g.finish());
+
+        StructBuilder th = header("lua_State");
+        th.add("status", 1, 1).add("allowhook", 1, 1).add("nci", 2, 2);
+        for (const char *f : {"top", "l_G", "ci", "stack_last", "stack", "openupval", "tbclist", "gclist", "twups",
+                              "errorJmp"}) {
+            th.add(f, P, PA);
+        }
+        th.add("base_ci", ci)
+            .add("hook", P, PA)
+            .add("errfunc", P, PA)
+            .add("nCcalls", 4, 4)
+            .add("oldpc", 4, 4)
+            .add("basehookcount", 4, 4)
+            .add("hookcount", 4, 4)
+            .add("hookmask", 4, 4);
+        StructLayout state = th.finish();
+        put(state);
+
+        // lstate.c: LX { lu_byte extra_[LUA_EXTRASPACE]; lua_State l; }
+        put(StructBuilder("LX").add("extra_", P, 1).add("l", state).finish());
+
+        put(StructBuilder("Mbuffer").add("buffer", P, PA).add("n", P, PA).add("buffsize", P, PA).finish());
+        put(StructBuilder("Zio").add("n", P, PA).add("p", P, PA).add("reader", P, PA).add("data", P, PA).add("L", P, PA).finish());
+
+        StructBuilder dbg("lua_Debug");
+        dbg.add("event", 4, 4);
+        for (const char *f : {"name", "namewhat", "what", "source", "srclen"}) {
+            dbg.add(f, P, PA);
+        }
+        dbg.add("currentline", 4, 4).add("linedefined", 4, 4).add("lastlinedefined", 4, 4);
+        dbg.add("nups", 1, 1).add("nparams", 1, 1).add("isvararg", 1, 1).add("istailcall", 1, 1);
+        dbg.add("ftransfer", 2, 2).add("ntransfer", 2, 2).add("short_src", 60, 1).add("i_ci", P, PA);
+        put(dbg.finish());
+    }
+
+    Abi abi_;
+    Config cfg_;
+    Scalars sc_;
+    std::map<std::string, StructLayout> structs_;
+};
+
+}  // namespace lua
@@ -0,0 +1,498 @@
+/*
+ *   Token-level reimplementation of llex.c for indexing Lua sources.
+ *
+ *   Token codes are those of "// llex.h" (single-char tokens are their own
+ *   character, enum RESERVED starts at FIRST_RESERVED) and the scanning rules
+ *   follow llex.c, including long brackets, line counting and the numeral
+ *   grammar. Unlike llex, nothing is interned or copied: names and string
+ *   tokens are views into the source (string escapes left undecoded), and
+ *   runs of identifier characters, blanks, comment and string bodies are
+ *   skipped with the vectorized classifier of lua_ctype.hpp.
+ */
+
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "lua/lua_ctype.hpp"
+
+
+namespace lua {
+
+constexpr int FIRST_RESERVED = UCHAR_MAX + 1;
+
+// WARNING: if you change the order of this enumeration, grep "ORDER RESERVED"
+enum RESERVED {
+    // terminal symbols denoted by reserved words
+    TK_AND = FIRST_RESERVED, TK_BREAK,
+    TK_DO, TK_ELSE, TK_ELSEIF, TK_END, TK_FALSE, TK_FOR, TK_FUNCTION,
+    TK_GOTO, TK_IF, TK_IN, TK_LOCAL, TK_NIL, TK_NOT, TK_OR, TK_REPEAT,
+    TK_RETURN, TK_THEN, TK_TRUE, TK_UNTIL, TK_WHILE,
+    // other terminal symbols
+    TK_IDIV, TK_CONCAT, TK_DOTS, TK_EQ, TK_GE, TK_LE, TK_NE,
+    TK_SHL, TK_SHR,
+    TK_DBCOLON, TK_EOS,
+    TK_FLT, TK_INT, TK_NAME, TK_STRING
+};
+
+// number of reserved words
+constexpr int NUM_RESERVED = TK_WHILE - FIRST_RESERVED + 1;
+
+// ORDER RESERVED
+inline constexpr const char *const luaX_tokens[] = {
+    "and", "break", "do", "else", "elseif",
+    "end", "false", "for", "function", "goto", "if",
+    "in", "local", "nil", "not", "or", "repeat",
+    "return", "then", "true", "until", "while",
+    "//", "..", "...", "==", ">=", "<=", "~=",
+    "<<", ">>", "::", "<eof>",
+    "<number>", "<integer>", "<name>", "<string>"
+};
+
+inline std::string token2str(int token) {
+    if (token < FIRST_RESERVED) {
+        if (lisprint(token)) {
+            return std::string("'") + char(token) + "'";
+        }
+        return "'<\\" + std::to_string(token) + ">'";
+    }
+    const char *s = luaX_tokens[token - FIRST_RESERVED];
+    return token < TK_EOS ? std::string("'") + s + "'" : s;
+}
+
+typedef union {
+    double r;
+    int64_t i;
+} SemInfo;  // TK_FLT / TK_INT values (default luaconf: double, long long)
+
+struct Token {
+    int token = TK_EOS;
+    int line = 1;
+    size_t begin = 0;  // source offsets of the whole token
+    size_t end = 0;
+    SemInfo seminfo{};
+    std::string_view text;  // TK_NAME: the name; TK_STRING: body between the delimiters
+};
+
+class LexError : public std::runtime_error {
+  public:
+    LexError(const std::string &msg, int line)
+        : std::runtime_error(std::to_string(line) + ": " + msg), line_(line) {}
+
+    int line() const { return line_; }
+
+  private:
+    int line_;
+};
+
+namespace detail {
+
+inline constexpr ByteClass CLASS_BLANK = byte_class({' ', '\f', '\t', '\v'});
+inline constexpr ByteClass CLASS_EOL = byte_class({'\n', '\r'});
+inline constexpr ByteClass CLASS_LONG_STOP = byte_class({']', '\n', '\r'});
+inline constexpr ByteClass CLASS_DQ_STOP = byte_class({'"', '\\', '\n', '\r'});
+inline constexpr ByteClass CLASS_SQ_STOP = byte_class({'\'', '\\', '\n', '\r'});
+
+// Reserved words are told apart by (first char, length, last char); the
+// hash of that triple is collision-free over the 22 words, so a lookup is
+// one table probe, a length check and one memcmp.
+constexpr unsigned reserved_hash(unsigned char first, size_t n, unsigned char last) {
+    return (first ^ (n << 4) ^ last) & 255;
+}
+
+struct ReservedTable {
+    uint8_t slot[256] = {};  // token - FIRST_RESERVED + 1, 0 if empty
+    uint8_t len[256] = {};   // length of the word in slot
+    bool ok = true;
+};
+
+constexpr ReservedTable make_reserved_table() {
+    ReservedTable rt;
+    for (int t = TK_AND; t <= TK_WHILE; t++) {
+        const char *w = luaX_tokens[t - FIRST_RESERVED];
+        size_t n = 0;
+        while (w[n]) {
+            n++;
+        }
+        unsigned h = reserved_hash(static_cast<unsigned char>(w[0]), n, static_cast<unsigned char>(w[n - 1]));
+        if (rt.slot[h]) {
+            rt.ok = false;
+        }
+        rt.slot[h] = static_cast<uint8_t>(t - FIRST_RESERVED + 1);
+        rt.len[h] = static_cast<uint8_t>(n);
+    }
+    return rt;
+}
+
+inline constexpr ReservedTable RESERVED_TABLE = make_reserved_table();
+static_assert(RESERVED_TABLE.ok, "reserved word hash must be collision-free");
+
+inline int reserved(const char *s, size_t n) {
+    if (n < 2 || n > 8) {
+        return 0;
+    }
+    unsigned h = reserved_hash(static_cast<unsigned char>(s[0]), n, static_cast<unsigned char>(s[n - 1]));
+    unsigned slot = RESERVED_TABLE.slot[h];
+    // A shorter word in the slot would have memcmp read past its end.
+    if (!slot || RESERVED_TABLE.len[h] != n) {
+        return 0;
+    }
+    return std::memcmp(luaX_tokens[slot - 1], s, n) == 0 ? FIRST_RESERVED + int(slot) - 1 : 0;
+}
+
+}  // namespace detail
+
+class Lexer {
+  public:
+    // Skips a UTF-8 BOM and a first line starting with '#', as luaL_loadfilex does.
+    Lexer(const char *src, size_t n) : p_(reinterpret_cast<const uint8_t *>(src)), n_(n) {
+        if (n_ >= 3 && std::memcmp(p_, "\xEF\xBB\xBF", 3) == 0) {
+            pos_ = 3;
+        }
+        if (pos_ < n_ && p_[pos_] == '#') {
+            pos_ += span(p_ + pos_, n_ - pos_, detail::CLASS_EOL, false);
+        }
+    }
+
+    explicit Lexer(std::string_view s) : Lexer(s.data(), s.size()) {}
+
+    int linenumber() const { return line_; }
+
+    // Reads the next token; returns false once TK_EOS has been produced.
+    bool next(Token &t) {
+        t.seminfo.i = 0;
+        t.text = {};
+        t.token = llex(t);
+        t.line = tokline_;
+        t.end = pos_;
+        return t.token != TK_EOS;
+    }
+
+  private:
+    const uint8_t *p_;
+    size_t n_;
+    size_t pos_ = 0;
+    int line_ = 1;
+    int tokline_ = 1;
+
+    int current() const { return pos_ < n_ ? p_[pos_] : EOZ; }
+    int peek(size_t k) const { return pos_ + k < n_ ? p_[pos_ + k] : EOZ; }
+
+    [[noreturn]] void error(const char *msg) const { throw LexError(msg, line_); }
+
+    bool check_next1(int c) {
+        if (current() == c) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    bool check_next2(const char *set) {
+        int c = current();
+        if (c == set[0] || c == set[1]) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    // skip a sequence '\n\r' or '\r\n'
+    void inclinenumber() {
+        int old = current();
+        pos_++;
+        int c = current();
+        if ((c == '\n' || c == '\r') && c != old) {
+            pos_++;
+        }
+        if (++line_ >= INT_MAX) {
+            error("chunk has too many lines");
+        }
+    }
+
+    // Reads a sequence '[=*[' or ']=*]', leaving the last bracket. If the
+    // sequence is well formed, returns its number of '='s + 2; otherwise
+    // returns 1 if it is a single bracket (no '='s and no 2nd bracket) or 0
+    // (a malformed long bracket).
+    size_t skip_sep() {
+        size_t count = 0;
+        int s = current();
+        pos_++;
+        while (current() == '=') {
+            pos_++;
+            count++;
+        }
+        return current() == s ? count + 2 : count == 0 ? 1 : 0;
+    }
+
+    void read_long_string(Token *t, size_t sep) {
+        int line = line_;
+        pos_++;  // skip 2nd bracket
+        if (current() == '\r' || current() == '\n') {
+            inclinenumber();  // skip first newline
+        }
+        size_t body = pos_;
+        for (;;) {
+            pos_ += span(p_ + pos_, n_ - pos_, detail::CLASS_LONG_STOP, false);
+            switch (current()) {
+            case EOZ:
+                throw LexError(t ? "unfinished long string (starting at line " + std::to_string(line) + ")"
+                                 : "unfinished long comment (starting at line " + std::to_string(line) + ")",
+                               line_);
+            case ']': {
+                size_t close = pos_;
+                if (skip_sep() == sep) {
+                    pos_++;  // skip 2nd bracket
+                    if (t) {
+                        t->text = std::string_view(reinterpret_cast<const char *>(p_) + body, close - body);
+                    }
+                    return;
+                }
+                break;
+            }
+            default:
+                inclinenumber();
+            }
+        }
+    }
+
+    void read_string(int del, Token &t) {
+        const ByteClass &stop = del == '"' ? detail::CLASS_DQ_STOP : detail::CLASS_SQ_STOP;
+        pos_++;  // skip delimiter
+        size_t body = pos_;
+        for (;;) {
+            pos_ += span(p_ + pos_, n_ - pos_, stop, false);
+            int c = current();
+            if (c == del) {
+                break;
+            }
+            if (c == EOZ || c == '\n' || c == '\r') {
+                error("unfinished string");
+            }
+            // escape: '\' newline continues the string, \z skips following blanks,
+            // everything else (\x.., \ddd, \u{...}) has no delimiter or newline in it
+            pos_++;
+            c = current();
+            if (c == '\n' || c == '\r') {
+                inclinenumber();
+            } else if (c == 'z') {
+                pos_++;
+                while (lisspace(current())) {
+                    if (current() == '\n' || current() == '\r') {
+                        inclinenumber();
+                    } else {
+                        pos_++;
+                    }
+                }
+            } else if (c != EOZ) {
+                pos_++;
+            }
+        }
+        t.text = std::string_view(reinterpret_cast<const char *>(p_) + body, pos_ - body);
+        pos_++;  // skip delimiter
+    }
+
+    // The numeral grammar of llex: digits, '.', hex digits and exponent signs
+    // are read greedily and validated by the conversion.
+    int read_numeral(Token &t) {
+        size_t start = pos_;
+        const char *expo = "Ee";
+        const ByteClass *digits = &CLASS_DIGIT_OR_DOT;
+        int first = current();
+        pos_++;
+        if (first == '0' && check_next2("xX")) {
+            expo = "Pp";
+            digits = &CLASS_XDIGIT_OR_DOT;
+        }
+        for (;;) {
+            if (check_next2(expo)) {
+                check_next2("-+");
+            } else if (lisxdigit(current()) || current() == '.') {
+                // Runs stop short of an exponent mark; a hex letter in a
+                // decimal numeral is taken alone, as llex.c does.
+                size_t k = span(p_ + pos_, n_ - pos_, *digits);
+                pos_ += k ? k : 1;
+            } else {
+                break;
+            }
+        }
+        if (lislalpha(current())) {  // is numeral touching a letter?
+            pos_++;                  // force an error
+        }
+        std::string s(reinterpret_cast<const char *>(p_) + start, pos_ - start);
+        if (str2int(s, t.seminfo.i)) {
+            return TK_INT;
+        }
+        char *end = nullptr;
+        t.seminfo.r = std::strtod(s.c_str(), &end);
+        if (*end) {
+            error("malformed number");
+        }
+        return TK_FLT;
+    }
+
+    // l_str2int: decimal overflow falls back to float; hexadecimal wraps around.
+    static bool str2int(const std::string &s, int64_t &out) {
+        uint64_t a = 0;
+        size_t i = 0;
+        bool empty = true;
+        if (s.size() > 1 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+            for (i = 2; i < s.size() && lisxdigit(static_cast<unsigned char>(s[i])); i++) {
+                int c = static_cast<unsigned char>(s[i]);
+                a = a * 16 + static_cast<uint64_t>(lisdigit(c) ? c - '0' : (c | 0x20) - 'a' + 10);
+                empty = false;
+            }
+        } else {
+            const uint64_t maxby10 = uint64_t(INT64_MAX) / 10;
+            const uint64_t maxlastd = uint64_t(INT64_MAX) % 10;
+            for (; i < s.size() && lisdigit(static_cast<unsigned char>(s[i])); i++) {
+                uint64_t d = static_cast<uint64_t>(s[i] - '0');
+                if (a >= maxby10 && (a > maxby10 || d > maxlastd)) {
+                    return false;  // overflow: accept it as a float
+                }
+                a = a * 10 + d;
+                empty = false;
+            }
+        }
+        if (empty || i != s.size()) {
+            return false;
+        }
+        out = static_cast<int64_t>(a);
+        return true;
+    }
+
+    int llex(Token &t) {
+        for (;;) {
+            t.begin = pos_;
+            tokline_ = line_;
+            switch (current()) {
+            case '\n':
+            case '\r':
+                inclinenumber();
+                break;
+            case ' ':
+            case '\f':
+            case '\t':
+            case '\v':
+                pos_ += span(p_ + pos_, n_ - pos_, detail::CLASS_BLANK);
+                break;
+            case '-':
+                pos_++;
+                if (current() != '-') {
+                    return '-';
+                }
+                // else is a comment
+                pos_++;
+                if (current() == '[') {  // long comment?
+                    size_t sep = skip_sep();
+                    if (sep >= 2) {
+                        read_long_string(nullptr, sep);
+                        break;
+                    }
+                }
+                // else short comment
+                pos_ += span(p_ + pos_, n_ - pos_, detail::CLASS_EOL, false);
+                break;
+            case '[': {
+                size_t sep = skip_sep();
+                if (sep >= 2) {
+                    read_long_string(&t, sep);
+                    return TK_STRING;
+                }
+                if (sep == 0) {  // '[=...' missing second bracket?
+                    error("invalid long string delimiter");
+                }
+                return '[';
+            }
+            case '=':
+                pos_++;
+                if (check_next1('=')) {
+                    return TK_EQ;
+                }
+                return '=';
+            case '<':
+                pos_++;
+                if (check_next1('=')) {
+                    return TK_LE;
+                }
+                if (check_next1('<')) {
+                    return TK_SHL;
+                }
+                return '<';
+            case '>':
+                pos_++;
+                if (check_next1('=')) {
+                    return TK_GE;
+                }
+                if (check_next1('>')) {
+                    return TK_SHR;
+                }
+                return '>';
+            case '/':
+                pos_++;
+                if (check_next1('/')) {
+                    return TK_IDIV;
+                }
+                return '/';
+            case '~':
+                pos_++;
+                if (check_next1('=')) {
+                    return TK_NE;
+                }
+                return '~';
+            case ':':
+                pos_++;
+                if (check_next1(':')) {
+                    return TK_DBCOLON;
+                }
+                return ':';
+            case '"':
+            case '\'':
+                read_string(current(), t);
+                return TK_STRING;
+            case '.':
+                if (peek(1) == '.') {
+                    pos_ += 2;
+                    if (check_next1('.')) {
+                        return TK_DOTS;
+                    }
+                    return TK_CONCAT;
+                }
+                if (!lisdigit(peek(1))) {
+                    pos_++;
+                    return '.';
+                }
+                return read_numeral(t);
+            case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+                return read_numeral(t);
+            case EOZ:
+                return TK_EOS;
+            default: {
+                int c = current();
+                if (lislalpha(c)) {  // identifier or reserved word?
+                    size_t start = pos_;
+                    pos_ += 1 + span(p_ + pos_ + 1, n_ - pos_ - 1, CLASS_ALNUM);
+                    const char *s = reinterpret_cast<const char *>(p_) + start;
+                    if (int r = detail::reserved(s, pos_ - start)) {
+                        return r;
+                    }
+                    t.text = std::string_view(s, pos_ - start);
+                    return TK_NAME;
+                }
+                // single-char tokens ('+', '*', '%', '{', '}', ...)
+                pos_++;
+                return c;
+            }
+            }
+        }
+    }
+};
+
+}  // namespace lua
@@ -0,0 +1,310 @@
+/*
+ *   Flattened function prototypes ("// lobject.h" Proto) and their columnar
+ *   tables.
+ *
+ *   A ProtoRecord is one Proto without its nested functions: constants,
+ *   upvalue descriptions, locals and line information are kept, children
+ *   are referenced by id. Records come from bytecode (lua_undump.hpp) or
+ *   from memory dumps (read_proto below) and are streamed into five tables:
+ *
+ *     protos     one row per function
+ *     constants  one row per k[] entry
+ *     locals     one row per locvars[] entry
+ *     upvalues   one row per upvalues[] entry
+ *     lines      one row per instruction with its source line
+ *
+ *   Ids are (input index << 32 | pre-order index within the input), so they
+ *   do not depend on how inputs are distributed over worker threads.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/columnar.hpp"
+#include "lua/lua_gc.hpp"
+#include "lua/lua_layout.hpp"
+
+
+namespace lua {
+
+// Variant tags of non-collectable constants (lobject.h)
+constexpr uint8_t LUA_VNIL = 0x00;
+constexpr uint8_t LUA_VFALSE = 0x01;
+constexpr uint8_t LUA_VTRUE = 0x11;
+constexpr uint8_t LUA_VNUMINT = 0x03;
+constexpr uint8_t LUA_VNUMFLT = 0x13;
+
+constexpr int ABSLINEINFO = -0x80;  // ldebug.h: marks lineinfo entries kept in abslineinfo
+
+struct ProtoConstant {
+    uint8_t tag = LUA_VNIL;
+    int64_t i = 0;
+    double n = 0;
+    std::string s;
+};
+
+struct ProtoUpvalue {
+    std::string name;
+    uint8_t instack = 0;
+    uint8_t idx = 0;
+    uint8_t kind = 0;
+};
+
+struct ProtoLocal {
+    std::string name;
+    int32_t startpc = 0;
+    int32_t endpc = 0;
+};
+
+struct ProtoRecord {
+    uint64_t id = 0;
+    int64_t parent = -1;
+    uint32_t input = 0;
+    uint64_t address = 0;  // of the Proto in a memory dump, 0 for bytecode
+    std::string source;
+    int32_t linedefined = 0;
+    int32_t lastlinedefined = 0;
+    uint8_t numparams = 0;
+    uint8_t is_vararg = 0;
+    uint8_t maxstacksize = 0;
+    uint32_t sizecode = 0;
+    uint32_t sizep = 0;
+    std::vector<ProtoConstant> k;
+    std::vector<ProtoUpvalue> upvalues;
+    std::vector<ProtoLocal> locvars;
+    std::vector<int8_t> lineinfo;
+    std::vector<std::pair<int32_t, int32_t>> abslineinfo;  // (pc, line)
+};
+
+class ProtoTables {
+  public:
+    explicit ProtoTables(const std::string &dir)
+        : protos_(dir, "protos",
+                  {{"id", common::ColType::U64}, {"parent", common::ColType::I64}, {"input", common::ColType::U32},
+                   {"address", common::ColType::U64}, {"source", common::ColType::STR},
+                   {"linedefined", common::ColType::I32}, {"lastlinedefined", common::ColType::I32},
+                   {"numparams", common::ColType::U8}, {"is_vararg", common::ColType::U8},
+                   {"maxstacksize", common::ColType::U8}, {"sizecode", common::ColType::U32},
+                   {"sizek", common::ColType::U32}, {"sizep", common::ColType::U32},
+                   {"sizeupvalues", common::ColType::U32}, {"sizelocvars", common::ColType::U32},
+                   {"sizelineinfo", common::ColType::U32}, {"sizeabslineinfo", common::ColType::U32}}),
+          constants_(dir, "constants",
+                     {{"proto", common::ColType::U64}, {"idx", common::ColType::U32}, {"tag", common::ColType::U8},
+                      {"i", common::ColType::I64}, {"n", common::ColType::F64}, {"s", common::ColType::STR}}),
+          locals_(dir, "locals",
+                  {{"proto", common::ColType::U64}, {"idx", common::ColType::U32}, {"name", common::ColType::STR},
+                   {"startpc", common::ColType::I32}, {"endpc", common::ColType::I32}}),
+          upvalues_(dir, "upvalues",
+                    {{"proto", common::ColType::U64}, {"idx", common::ColType::U32}, {"name", common::ColType::STR},
+                     {"instack", common::ColType::U8}, {"index", common::ColType::U8}, {"kind", common::ColType::U8}}),
+          lines_(dir, "lines",
+                 {{"proto", common::ColType::U64}, {"pc", common::ColType::U32}, {"line", common::ColType::I32}}) {}
+
+    void add(const ProtoRecord &p) {
+        protos_.u64(p.id).i64(p.parent).u32(p.input).u64(p.address).str(p.source).i32(p.linedefined)
+            .i32(p.lastlinedefined).u8(p.numparams).u8(p.is_vararg).u8(p.maxstacksize).u32(p.sizecode)
+            .u32(static_cast<uint32_t>(p.k.size())).u32(p.sizep).u32(static_cast<uint32_t>(p.upvalues.size()))
+            .u32(static_cast<uint32_t>(p.locvars.size())).u32(static_cast<uint32_t>(p.lineinfo.size()))
+            .u32(static_cast<uint32_t>(p.abslineinfo.size()))
+            .end_row();
+        for (size_t i = 0; i < p.k.size(); i++) {
+            const ProtoConstant &c = p.k[i];
+            constants_.u64(p.id).u32(static_cast<uint32_t>(i)).u8(c.tag).i64(c.i).f64(c.n).str(c.s).end_row();
+        }
+        for (size_t i = 0; i < p.locvars.size(); i++) {
+            const ProtoLocal &l = p.locvars[i];
+            locals_.u64(p.id).u32(static_cast<uint32_t>(i)).str(l.name).i32(l.startpc).i32(l.endpc).end_row();
+        }
+        for (size_t i = 0; i < p.upvalues.size(); i++) {
+            const ProtoUpvalue &u = p.upvalues[i];
+            upvalues_.u64(p.id).u32(static_cast<uint32_t>(i)).str(u.name).u8(u.instack).u8(u.idx).u8(u.kind)
+                .end_row();
+        }
+        // luaG_getfuncline, evaluated for every pc in one forward pass
+        int32_t line = p.linedefined;
+        size_t abs = 0;
+        for (size_t pc = 0; pc < p.lineinfo.size(); pc++) {
+            if (abs < p.abslineinfo.size() && size_t(p.abslineinfo[abs].first) == pc) {
+                line = p.abslineinfo[abs++].second;
+            } else {
+                line += p.lineinfo[pc];
+            }
+            lines_.u64(p.id).u32(static_cast<uint32_t>(pc)).i32(line).end_row();
+        }
+    }
+
+    uint64_t protos() const { return protos_.rows(); }
+
+    void close() {
+        protos_.close();
+        constants_.close();
+        locals_.close();
+        upvalues_.close();
+        lines_.close();
+    }
+
+  private:
+    common::TableWriter protos_, constants_, locals_, upvalues_, lines_;
+};
+
+
+// Proto objects inside a memory dump, read with the layouts of the heap.
+class HeapProtoReader {
+  public:
+    explicit HeapProtoReader(const Heap &heap) : heap_(heap), img_(heap.image()) {
+        const Layouts &lay = heap.layouts();
+        P = lay.scalars().ptr;
+        isz_ = lay.scalars().integer;
+        nsz_ = lay.scalars().number;
+        const StructLayout &pr = lay.get("Proto");
+        for (const Field &f : pr.fields) {
+            off_[f.name] = f.offset;
+        }
+        o_tt_ = lay.offset("GCObject", "tt");
+        o_ts_shrlen_ = lay.offset("TString", "shrlen");
+        o_ts_u_ = lay.offset("TString", "u");
+        o_ts_contents_ = lay.offset("TString", "contents");
+        o_tv_tt_ = lay.offset("TValue", "tt_");
+        s_tvalue_ = lay.size("TValue");
+        o_uv_name_ = lay.offset("Upvaldesc", "name");
+        o_uv_instack_ = lay.offset("Upvaldesc", "instack");
+        o_uv_idx_ = lay.offset("Upvaldesc", "idx");
+        o_uv_kind_ = lay.offset("Upvaldesc", "kind");
+        s_upvaldesc_ = lay.size("Upvaldesc");
+        o_lv_varname_ = lay.offset("LocVar", "varname");
+        o_lv_startpc_ = lay.offset("LocVar", "startpc");
+        o_lv_endpc_ = lay.offset("LocVar", "endpc");
+        s_locvar_ = lay.size("LocVar");
+        s_absline_ = lay.size("AbsLineInfo");
+    }
+
+    // Children of the Proto at 'addr' (its p[] array).
+    std::vector<uint64_t> children(uint64_t addr) const {
+        std::vector<uint64_t> out;
+        uint64_t n = u32(addr + off_.at("sizep"));
+        uint64_t p = heap_.ptr(addr + off_.at("p"));
+        for (uint64_t i = 0; i < n && i < LIMIT; i++) {
+            out.push_back(heap_.ptr(p + i * P));
+        }
+        return out;
+    }
+
+    void read(uint64_t addr, ProtoRecord &r) const {
+        auto i32 = [&](const char *f) { return static_cast<int32_t>(u32(addr + off_.at(f))); };
+        auto n = [&](const char *f) { return std::min<uint64_t>(u32(addr + off_.at(f)), LIMIT); };
+        auto ptr = [&](const char *f) { return heap_.ptr(addr + off_.at(f)); };
+        r.address = addr;
+        r.source = string(ptr("source"));
+        r.linedefined = i32("linedefined");
+        r.lastlinedefined = i32("lastlinedefined");
+        r.numparams = static_cast<uint8_t>(heap_.u8(addr + off_.at("numparams")));
+        r.is_vararg = static_cast<uint8_t>(heap_.u8(addr + off_.at("is_vararg")));
+        r.maxstacksize = static_cast<uint8_t>(heap_.u8(addr + off_.at("maxstacksize")));
+        r.sizecode = static_cast<uint32_t>(n("sizecode"));
+        r.sizep = static_cast<uint32_t>(n("sizep"));
+
+        uint64_t k = ptr("k");
+        r.k.resize(n("sizek"));
+        for (size_t i = 0; i < r.k.size(); i++) {
+            uint64_t tv = k + i * s_tvalue_;
+            ProtoConstant &c = r.k[i];
+            c.tag = static_cast<uint8_t>(heap_.u8(tv + o_tv_tt_) & 0x3f);  // drop BIT_ISCOLLECTABLE
+            switch (c.tag) {
+            case LUA_VNUMINT:
+                c.i = sign_extend(img_.read_or(tv, isz_, 0), isz_);
+                break;
+            case LUA_VNUMFLT:
+                c.n = number(img_.read_or(tv, nsz_, 0));
+                break;
+            case LUA_VSHRSTR:
+            case LUA_VLNGSTR:
+                c.s = string(heap_.ptr(tv));
+                break;
+            default:
+                break;
+            }
+        }
+
+        uint64_t uv = ptr("upvalues");
+        r.upvalues.resize(n("sizeupvalues"));
+        for (size_t i = 0; i < r.upvalues.size(); i++) {
+            uint64_t d = uv + i * s_upvaldesc_;
+            ProtoUpvalue &u = r.upvalues[i];
+            u.name = string(heap_.ptr(d + o_uv_name_));
+            u.instack = static_cast<uint8_t>(heap_.u8(d + o_uv_instack_));
+            u.idx = static_cast<uint8_t>(heap_.u8(d + o_uv_idx_));
+            u.kind = static_cast<uint8_t>(heap_.u8(d + o_uv_kind_));
+        }
+
+        uint64_t lv = ptr("locvars");
+        r.locvars.resize(n("sizelocvars"));
+        for (size_t i = 0; i < r.locvars.size(); i++) {
+            uint64_t d = lv + i * s_locvar_;
+            ProtoLocal &l = r.locvars[i];
+            l.name = string(heap_.ptr(d + o_lv_varname_));
+            l.startpc = static_cast<int32_t>(u32(d + o_lv_startpc_));
+            l.endpc = static_cast<int32_t>(u32(d + o_lv_endpc_));
+        }
+
+        r.lineinfo.clear();
+        uint64_t nli = n("sizelineinfo");
+        if (const uint8_t *li = img_.at(ptr("lineinfo"), nli ? nli : 1)) {
+            r.lineinfo.assign(reinterpret_cast<const int8_t *>(li), reinterpret_cast<const int8_t *>(li) + nli);
+        }
+        uint64_t al = ptr("abslineinfo");
+        r.abslineinfo.resize(n("sizeabslineinfo"));
+        for (size_t i = 0; i < r.abslineinfo.size(); i++) {
+            r.abslineinfo[i] = {static_cast<int32_t>(u32(al + i * s_absline_)),
+                                static_cast<int32_t>(u32(al + i * s_absline_ + 4))};
+        }
+    }
+
+    // Contents of a TString; empty for NULL or unreadable strings.
+    std::string string(uint64_t ts) const {
+        if (!ts) {
+            return std::string();
+        }
+        uint8_t tt = static_cast<uint8_t>(heap_.u8(ts + o_tt_));
+        uint64_t len = tt == LUA_VLNGSTR ? img_.read_or(ts + o_ts_u_, P, 0) : heap_.u8(ts + o_ts_shrlen_);
+        const uint8_t *p = len ? img_.at(ts + o_ts_contents_, len) : nullptr;
+        return p ? std::string(reinterpret_cast<const char *>(p), len) : std::string();
+    }
+
+  private:
+    static constexpr uint64_t LIMIT = 1 << 24;  // sanity bound on array sizes read from a dump
+
+    uint64_t u32(uint64_t a) const { return img_.read_or(a, 4, 0); }
+
+    static int64_t sign_extend(uint64_t v, unsigned size) {
+        return size == 4 ? int64_t(int32_t(uint32_t(v))) : int64_t(v);
+    }
+
+    double number(uint64_t bits) const {
+        if (nsz_ == 4) {
+            float f;
+            uint32_t b = static_cast<uint32_t>(bits);
+            std::memcpy(&f, &b, 4);
+            return f;
+        }
+        double d;
+        std::memcpy(&d, &bits, 8);
+        return d;
+    }
+
+    const Heap &heap_;
+    const common::MemoryImage &img_;
+    unsigned P, isz_, nsz_;
+    std::map<std::string, uint64_t> off_;
+    uint64_t o_tt_, o_ts_shrlen_, o_ts_u_, o_ts_contents_, o_tv_tt_, s_tvalue_;
+    uint64_t o_uv_name_, o_uv_instack_, o_uv_idx_, o_uv_kind_, s_upvaldesc_;
+    uint64_t o_lv_varname_, o_lv_startpc_, o_lv_endpc_, s_locvar_, s_absline_;
+};
+
+}  // namespace lua
@@ -0,0 +1,291 @@
+/*
+ *   lua_protodump: flatten the function prototypes of precompiled chunks and
+ *   of memory dumps into columnar tables (see lua_proto.hpp for the tables
+ *   and common/columnar.hpp for the file layout).
+ *
+ *   Chunks are named as for lua_chunk (PATH or PATH@OFFSET+LENGTH,...);
+ *   memory dumps are given with --heap, and every Proto on the collector's
+ *   lists of each global_State found in them is written. Records are
+ *   streamed: one Proto is held in memory at a time, whatever the number of
+ *   functions.
+ *
+ *   With -j N inputs are processed in parallel and each worker writes its own
+ *   set of tables under DIR/part-K; ids carry the input index, so the parts
+ *   can be concatenated in any order.
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/lua/lua_protodump.cpp -o lua_protodump
+ */
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "common/memory_image.hpp"
+#include "common/parallel.hpp"
+#include "lua/lua_gc.hpp"
+#include "lua/lua_layout.hpp"
+#include "lua/lua_proto.hpp"
+#include "lua/lua_undump.hpp"
+#include "lua/lua_zio.hpp"
+
+
+namespace {
+
+struct Input {
+    std::string spec;
+    bool heap = false;
+};
+
+struct Options {
+    std::string out;
+    size_t window = 0;
+    std::string abi;
+    lua::Config cfg;
+    uint64_t base = 0;
+    unsigned jobs = 1;
+    std::vector<Input> inputs;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: lua_protodump --out DIR [options] [chunk...] [--heap dump...]\n"
+                 "  chunk        PATH or PATH@OFFSET+LENGTH[,PATH@OFFSET+LENGTH...] of a binary chunk\n"
+                 "  --heap DUMP  memory dump; every Proto of every global_State found is written\n"
+                 "  --out DIR    directory for the tables (created if missing)\n"
+                 "  --window N   hand chunk files to the reader in N-byte windows\n"
+                 "  --abi NAME   target ABI of dumps: lp64 (default), lp64be, ilp32, ilp32be, i386\n"
+                 "  --lua32      dumps built with LUA_32BITS\n"
+                 "  --c89        dumps built with LUA_USE_C89\n"
+                 "  --base ADDR  load address of raw (non-ELF) dumps\n"
+                 "  -j N         inputs processed in parallel, one table set per worker\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--out") {
+            o.out = next();
+        } else if (a == "--heap") {
+            o.inputs.push_back({next(), true});
+        } else if (a == "--window") {
+            o.window = std::strtoull(next(), nullptr, 0);
+        } else if (a == "--abi") {
+            o.abi = next();
+        } else if (a == "--lua32") {
+            o.cfg.lua_32bits = true;
+        } else if (a == "--c89") {
+            o.cfg.c89 = true;
+        } else if (a == "--base") {
+            o.base = std::strtoull(next(), nullptr, 0);
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else {
+            o.inputs.push_back({a, false});
+        }
+    }
+    if (o.out.empty() || o.inputs.empty()) {
+        usage();
+    }
+    return o;
+}
+
+void make_dir(const std::string &path) {
+    if (::mkdir(path.c_str(), 0777) != 0 && errno != EEXIST) {
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+    }
+}
+
+struct Source {
+    std::unique_ptr<lua::MappedReader> mapped;
+    std::unique_ptr<lua::ScatterReader> scatter;
+    lua::lua_Reader reader = nullptr;
+    void *data = nullptr;
+
+    Source(const std::string &spec, size_t window) {
+        if (spec.find_first_of("@,") == std::string::npos) {
+            mapped.reset(new lua::MappedReader(spec, window));
+            reader = lua::MappedReader::read;
+            data = mapped.get();
+        } else {
+            scatter.reset(new lua::ScatterReader());
+            scatter->add_spec(spec);
+            reader = lua::ScatterReader::read;
+            data = scatter.get();
+        }
+    }
+};
+
+uint64_t dump_chunk(const Options &opt, uint32_t input, lua::ProtoTables &out) {
+    Source src(opt.inputs[input].spec, opt.window);
+    lua::Zio z;
+    lua::luaZ_init(nullptr, &z, src.reader, src.data);
+    lua::ChunkReader cr(&z);
+    cr.header();
+    return cr.load_functions(input, [&](const lua::ProtoRecord &r) { out.add(r); });
+}
+
+// Protos are numbered in list order; parents come from the p[] arrays of the
+// protos themselves, so only addresses are kept between the two passes.
+uint64_t dump_heap(const Options &opt, uint32_t input, lua::ProtoTables &out) {
+    common::MemoryImage img(opt.inputs[input].spec, opt.base);
+    std::string abi_name = opt.abi;
+    if (abi_name.empty()) {
+        abi_name = img.elf_pointer_size() == 4 ? "ilp32" : "lp64";
+    }
+    lua::Abi abi = lua::Abi::named(abi_name);
+    if (img.elf_pointer_size() == 0) {
+        img.set_little_endian(abi.little_endian);
+    }
+    lua::Layouts lay(abi, opt.cfg);
+    lua::Heap heap(img, lay);
+    uint64_t limit = 0;
+    for (const common::Segment &s : img.segments()) {
+        limit += s.size;
+    }
+    limit /= 8;
+
+    std::vector<uint64_t> protos;
+    for (uint64_t ga : heap.find_globals()) {
+        lua::GlobalState g = heap.global(ga);
+        for (uint64_t head : {g.allgc, g.finobj, g.tobefnz, g.fixedgc}) {
+            heap.walk(head, limit, [&](uint64_t o, uint8_t tt, uint8_t) {
+                if (tt == lua::LUA_VPROTO) {
+                    protos.push_back(o);
+                }
+                return true;
+            });
+        }
+    }
+    if (protos.empty()) {
+        throw std::runtime_error("no Proto objects found (check --abi/--lua32/--c89)");
+    }
+
+    lua::HeapProtoReader reader(heap);
+    std::unordered_map<uint64_t, uint64_t> id_of;
+    id_of.reserve(protos.size());
+    for (size_t i = 0; i < protos.size(); i++) {
+        id_of.emplace(protos[i], uint64_t(input) << 32 | i);
+    }
+    std::unordered_map<uint64_t, uint64_t> parent_of;
+    for (uint64_t p : protos) {
+        for (uint64_t c : reader.children(p)) {
+            auto it = id_of.find(c);
+            if (it != id_of.end()) {
+                parent_of.emplace(it->second, id_of[p]);
+            }
+        }
+    }
+
+    lua::ProtoRecord r;
+    for (uint64_t p : protos) {
+        r.id = id_of[p];
+        auto it = parent_of.find(r.id);
+        r.parent = it == parent_of.end() ? -1 : static_cast<int64_t>(it->second);
+        r.input = input;
+        reader.read(p, r);
+        out.add(r);
+    }
+    return protos.size();
+}
+
+// Table sets handed to workers; at most 'jobs' are ever created.
+class Writers {
+  public:
+    Writers(const std::string &dir, bool parts) : dir_(dir), parts_(parts) {}
+
+    lua::ProtoTables *acquire() {
+        std::lock_guard<std::mutex> g(lock_);
+        if (!free_.empty()) {
+            lua::ProtoTables *t = free_.back();
+            free_.pop_back();
+            return t;
+        }
+        std::string dir = dir_;
+        if (parts_) {
+            dir += "/part-" + std::to_string(all_.size());
+            make_dir(dir);
+        }
+        all_.emplace_back(new lua::ProtoTables(dir));
+        return all_.back().get();
+    }
+
+    void release(lua::ProtoTables *t) {
+        std::lock_guard<std::mutex> g(lock_);
+        free_.push_back(t);
+    }
+
+    void close() {
+        for (auto &t : all_) {
+            t->close();
+        }
+    }
+
+    size_t count() const { return all_.size(); }
+
+  private:
+    std::string dir_;
+    bool parts_;
+    std::mutex lock_;
+    std::vector<std::unique_ptr<lua::ProtoTables>> all_;
+    std::vector<lua::ProtoTables *> free_;
+};
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::mutex out_lock;
+    int status = 0;
+    uint64_t total = 0;
+    try {
+        make_dir(opt.out);
+        Writers writers(opt.out, opt.jobs > 1 && opt.inputs.size() > 1);
+        common::parallel_for(opt.inputs.size(), opt.jobs, [&](size_t i) {
+            lua::ProtoTables *t = writers.acquire();
+            uint64_t n = 0;
+            try {
+                uint32_t input = static_cast<uint32_t>(i);
+                n = opt.inputs[i].heap ? dump_heap(opt, input, *t) : dump_chunk(opt, input, *t);
+            } catch (const std::exception &e) {
+                writers.release(t);
+                std::lock_guard<std::mutex> g(out_lock);
+                std::fprintf(stderr, "lua_protodump: %s: %s\n", opt.inputs[i].spec.c_str(), e.what());
+                status = 1;
+                return;
+            }
+            writers.release(t);
+            std::lock_guard<std::mutex> g(out_lock);
+            std::printf("%s: %" PRIu64 " function(s)\n", opt.inputs[i].spec.c_str(), n);
+            total += n;
+        });
+        writers.close();
+        std::printf("%" PRIu64 " function(s) from %zu input(s) in %zu table set(s) under %s\n", total,
+                    opt.inputs.size(), writers.count(), opt.out.c_str());
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "lua_protodump: %s: %s\n", opt.out.c_str(), e.what());
+        return 1;
+    }
+    return status;
+}
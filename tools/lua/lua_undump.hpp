@@ -0,0 +1,283 @@
+/*
+ *   Reading precompiled Lua 5.4 chunks (lundump.c) through a Zio.
+ *
+ *   Unlike luaU_undump, the header is not required to match the host: the
+ *   sizes of Instruction, lua_Integer and lua_Number and the byte order are
+ *   taken from the chunk itself (LUAC_INT and LUAC_NUM identify them), so
+ *   chunks compiled for any target can be read.
+ *
+ *   Functions are delivered one at a time as flattened ProtoRecords
+ *   (lua_proto.hpp); instructions are skipped in place, so only the Proto
+ *   being read is ever held in memory.
+ */
+
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "lua/lua_proto.hpp"
+#include "lua/lua_zio.hpp"
+
+
+namespace lua {
+
+constexpr char LUA_SIGNATURE[] = "\x1bLua";
+constexpr uint8_t LUAC_VERSION = 0x54;  // LUA_VERSION_MAJOR * 16 + LUA_VERSION_MINOR
+constexpr uint8_t LUAC_FORMAT = 0;      // this is the official format
+constexpr char LUAC_DATA[] = "\x19\x93\r\n\x1a\n";
+constexpr int64_t LUAC_INT = 0x5678;
+constexpr double LUAC_NUM = 370.5;
+constexpr size_t MAX_NESTING = 200;  // LUAI_MAXCCALLS bounds how deeply the parser nests functions
+
+class UndumpError : public std::runtime_error {
+  public:
+    explicit UndumpError(const std::string &msg) : std::runtime_error("bad binary format (" + msg + ")") {}
+};
+
+struct ChunkHeader {
+    uint8_t version = 0;
+    uint8_t format = 0;
+    unsigned instruction_size = 0;
+    unsigned integer_size = 0;
+    unsigned number_size = 0;
+    bool little_endian = true;
+    unsigned sizeupvalues = 0;  // of the main closure
+};
+
+class ChunkReader {
+  public:
+    explicit ChunkReader(Zio *z) : z_(z) {}
+
+    // Reads the header of a chunk whose first byte has not been consumed.
+    const ChunkHeader &header() {
+        std::string scratch;
+        const char *sig = luaZ_view(z_, 4, scratch);
+        if (!sig || std::memcmp(sig, LUA_SIGNATURE, 4) != 0) {
+            throw UndumpError("not a binary chunk");
+        }
+        h_.version = byte();
+        if (h_.version != LUAC_VERSION) {
+            throw UndumpError("version mismatch");
+        }
+        h_.format = byte();
+        if (h_.format != LUAC_FORMAT) {
+            throw UndumpError("format mismatch");
+        }
+        const char *data = luaZ_view(z_, sizeof LUAC_DATA - 1, scratch);
+        if (!data || std::memcmp(data, LUAC_DATA, sizeof LUAC_DATA - 1) != 0) {
+            throw UndumpError("corrupted chunk");
+        }
+        h_.instruction_size = byte();
+        h_.integer_size = byte();
+        h_.number_size = byte();
+        if (h_.instruction_size != 4 || (h_.integer_size != 4 && h_.integer_size != 8) ||
+            (h_.number_size != 4 && h_.number_size != 8)) {
+            throw UndumpError("unsupported sizes");
+        }
+        const uint8_t *ip = block(h_.integer_size);
+        if (ip[0] == 0x78) {
+            h_.little_endian = true;
+        } else if (ip[h_.integer_size - 1] == 0x78) {
+            h_.little_endian = false;
+        } else {
+            throw UndumpError("integer format mismatch");
+        }
+        if (decode(ip, h_.integer_size) != uint64_t(LUAC_INT)) {
+            throw UndumpError("integer format mismatch");
+        }
+        if (number(block(h_.number_size)) != LUAC_NUM) {
+            throw UndumpError("float format mismatch");
+        }
+        h_.sizeupvalues = byte();
+        return h_;
+    }
+
+    const ChunkHeader &chunk_header() const { return h_; }
+
+    uint8_t byte() {
+        int b = zgetc(z_);
+        if (b == EOZ) {
+            throw UndumpError("truncated chunk");
+        }
+        return static_cast<uint8_t>(b);
+    }
+
+    // Next n bytes, in place when the reader's block holds them.
+    const uint8_t *block(size_t n) {
+        const char *p = luaZ_view(z_, n, scratch_);
+        if (!p) {
+            throw UndumpError("truncated chunk");
+        }
+        return reinterpret_cast<const uint8_t *>(p);
+    }
+
+    uint64_t decode(const uint8_t *p, unsigned n) const {
+        uint64_t v = 0;
+        for (unsigned i = 0; i < n; i++) {
+            v |= uint64_t(p[h_.little_endian ? i : n - 1 - i]) << (8 * i);
+        }
+        return v;
+    }
+
+    double number(const uint8_t *p) const {
+        uint64_t bits = decode(p, h_.number_size);
+        if (h_.number_size == 4) {
+            float f;
+            uint32_t b32 = static_cast<uint32_t>(bits);
+            std::memcpy(&f, &b32, 4);
+            return f;
+        }
+        double d;
+        std::memcpy(&d, &bits, 8);
+        return d;
+    }
+
+    Zio *zio() const { return z_; }
+
+    size_t load_size(size_t limit = SIZE_MAX) {
+        size_t x = 0;
+        int b;
+        limit >>= 7;
+        do {
+            b = byte();
+            if (x >= limit) {
+                throw UndumpError("integer overflow");
+            }
+            x = (x << 7) | (b & 0x7f);
+        } while ((b & 0x80) == 0);
+        return x;
+    }
+
+    int32_t load_int() { return static_cast<int32_t>(load_size(INT_MAX)); }
+
+    // loadStringN: false for a NULL string
+    bool load_string(std::string &s) {
+        size_t size = load_size();
+        if (size == 0) {
+            s.clear();
+            return false;
+        }
+        size--;
+        const uint8_t *p = size ? block(size) : nullptr;
+        s.assign(reinterpret_cast<const char *>(p), size);
+        return true;
+    }
+
+    int64_t load_integer() {
+        uint64_t v = decode(block(h_.integer_size), h_.integer_size);
+        return h_.integer_size == 4 ? int64_t(int32_t(uint32_t(v))) : int64_t(v);
+    }
+
+    double load_number() { return number(block(h_.number_size)); }
+
+    // Reads the main function and everything nested in it, after header().
+    // fn(const ProtoRecord &) sees every function once its debug information
+    // is read, i.e. nested functions before the function containing them.
+    template <typename Fn>
+    uint64_t load_functions(uint32_t input, Fn &&fn) {
+        std::vector<ProtoRecord> stack(MAX_NESTING);  // one record per nesting level, reused by siblings
+        uint64_t next = 0;
+        load_function(stack, 0, -1, std::string(), input, next, fn);
+        return next;
+    }
+
+  private:
+    template <typename Fn>
+    void load_function(std::vector<ProtoRecord> &stack, size_t depth, int64_t parent, const std::string &psource,
+                       uint32_t input, uint64_t &next, Fn &fn) {
+        if (depth >= stack.size()) {
+            throw UndumpError("functions nested too deeply");
+        }
+        ProtoRecord &f = stack[depth];
+        f.id = uint64_t(input) << 32 | next++;
+        f.parent = parent;
+        f.input = input;
+        if (!load_string(f.source)) {
+            f.source = psource;
+        }
+        f.linedefined = load_int();
+        f.lastlinedefined = load_int();
+        f.numparams = byte();
+        f.is_vararg = byte();
+        f.maxstacksize = byte();
+
+        // code: not needed in the tables, skipped without copying
+        f.sizecode = static_cast<uint32_t>(load_int());
+        if (luaZ_skip(z_, size_t(f.sizecode) * h_.instruction_size) != 0) {
+            throw UndumpError("truncated chunk");
+        }
+
+        f.k.resize(static_cast<size_t>(load_int()));
+        for (ProtoConstant &c : f.k) {
+            c = ProtoConstant();
+            c.tag = byte();
+            switch (c.tag) {
+            case LUA_VNIL:
+            case LUA_VFALSE:
+            case LUA_VTRUE:
+                break;
+            case LUA_VNUMFLT:
+                c.n = load_number();
+                break;
+            case LUA_VNUMINT:
+                c.i = load_integer();
+                break;
+            case LUA_VSHRSTR:
+            case LUA_VLNGSTR:
+                if (!load_string(c.s)) {
+                    throw UndumpError("bad format for constant string");
+                }
+                break;
+            default:
+                throw UndumpError("bad format for constant");
+            }
+        }
+
+        f.upvalues.resize(static_cast<size_t>(load_int()));
+        for (ProtoUpvalue &u : f.upvalues) {
+            u.name.clear();
+            u.instack = byte();
+            u.idx = byte();
+            u.kind = byte();
+        }
+
+        f.sizep = static_cast<uint32_t>(load_int());
+        for (uint32_t i = 0; i < f.sizep; i++) {
+            load_function(stack, depth + 1, static_cast<int64_t>(f.id), f.source, input, next, fn);
+        }
+
+        // debug information
+        size_t n = static_cast<size_t>(load_int());
+        const int8_t *li = n ? reinterpret_cast<const int8_t *>(block(n)) : nullptr;
+        f.lineinfo.assign(li, li + n);
+        f.abslineinfo.resize(static_cast<size_t>(load_int()));
+        for (auto &a : f.abslineinfo) {
+            a.first = load_int();
+            a.second = load_int();
+        }
+        f.locvars.resize(static_cast<size_t>(load_int()));
+        for (ProtoLocal &l : f.locvars) {
+            load_string(l.name);
+            l.startpc = load_int();
+            l.endpc = load_int();
+        }
+        n = static_cast<size_t>(load_int());
+        if (n != 0) {  // does it have debug information?
+            for (ProtoUpvalue &u : f.upvalues) {  // must be this many
+                load_string(u.name);
+            }
+        }
+        fn(static_cast<const ProtoRecord &>(f));
+    }
+
+    Zio *z_;
+    ChunkHeader h_;
+    std::string scratch_;
+};
+
+}  // namespace lua
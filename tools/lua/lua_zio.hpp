@@ -0,0 +1,284 @@
+/*
+ *   The buffered stream of "// lzio.h" (Zio, zgetc, luaZ_fill, luaZ_read)
+ *   and lua_Reader implementations that hand out mapped memory instead of
+ *   copies.
+ *
+ *   MappedReader gives lua_load/luaU_undump a file's mapping either as one
+ *   block or in windows; in windowed mode pages of finished windows are
+ *   dropped from the process (MADV_DONTNEED) while the next window is read
+ *   ahead, so resident memory stays near two windows however large the
+ *   chunk. ScatterReader presents fragments carved from one or more images
+ *   as a single chunk, returning each fragment in place.
+ *
+ *   The reader callbacks have the lua_Reader signature of lua.h, so the same
+ *   objects can be passed to a real Lua state or to the tools in this
+ *   directory, which consume them through Zio exactly as lzio.c does.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "common/mapped_file.hpp"
+#include "lua/lua_ctype.hpp"  // EOZ
+
+
+struct lua_State;  // never dereferenced here
+
+namespace lua {
+
+typedef const char *(*lua_Reader)(lua_State *L, void *ud, size_t *sz);
+
+struct Zio {
+    size_t n;          // bytes still unread
+    const char *p;     // current position in buffer
+    lua_Reader reader; // reader function
+    void *data;        // additional data
+    lua_State *L;      // Lua state (for reader)
+};
+
+inline void luaZ_init(lua_State *L, Zio *z, lua_Reader reader, void *data) {
+    z->L = L;
+    z->reader = reader;
+    z->data = data;
+    z->n = 0;
+    z->p = nullptr;
+}
+
+inline int luaZ_fill(Zio *z) {
+    size_t size;
+    const char *buff = z->reader(z->L, z->data, &size);
+    if (buff == nullptr || size == 0) {
+        return EOZ;
+    }
+    z->n = size - 1;  // discount char being returned
+    z->p = buff;
+    return static_cast<unsigned char>(*(z->p++));
+}
+
+inline int zgetc(Zio *z) {
+    return (z->n--) > 0 ? static_cast<unsigned char>(*z->p++) : luaZ_fill(z);
+}
+
+// Reads the next n bytes into b; returns the number of missing bytes (0 on success).
+inline size_t luaZ_read(Zio *z, void *b, size_t n) {
+    while (n) {
+        if (z->n == 0) {  // no bytes in buffer?
+            if (luaZ_fill(z) == EOZ) {  // try to read more
+                return n;               // no more input; return number of missing bytes
+            }
+            z->n++;  // luaZ_fill consumed first byte; put it back
+            z->p--;
+        }
+        size_t m = n <= z->n ? n : z->n;  // min. between n and z->n
+        std::memcpy(b, z->p, m);
+        z->n -= m;
+        z->p += m;
+        b = static_cast<char *>(b) + m;
+        n -= m;
+    }
+    return 0;
+}
+
+// Zero-copy counterpart of luaZ_read: returns a pointer to the next n bytes,
+// which points into the reader's block when they are contiguous there and
+// into 'scratch' only when they straddle blocks. nullptr if the stream ends.
+inline const char *luaZ_view(Zio *z, size_t n, std::string &scratch) {
+    if (z->n == 0) {
+        if (n == 0) {
+            return z->p ? z->p : "";
+        }
+        if (luaZ_fill(z) == EOZ) {
+            return nullptr;
+        }
+        z->n++;
+        z->p--;
+    }
+    if (n <= z->n) {
+        const char *p = z->p;
+        z->n -= n;
+        z->p += n;
+        return p;
+    }
+    scratch.resize(n);
+    if (luaZ_read(z, &scratch[0], n) != 0) {
+        return nullptr;
+    }
+    return scratch.data();
+}
+
+// Skips n bytes without touching them; returns the number of missing bytes.
+inline size_t luaZ_skip(Zio *z, size_t n) {
+    while (n) {
+        if (z->n == 0) {
+            if (luaZ_fill(z) == EOZ) {
+                return n;
+            }
+            z->n++;
+            z->p--;
+        }
+        size_t m = n <= z->n ? n : z->n;
+        z->n -= m;
+        z->p += m;
+        n -= m;
+    }
+    return 0;
+}
+
+
+// A file's mapping as a lua_Reader. window == 0 returns the whole mapping
+// in one block.
+class MappedReader {
+  public:
+    explicit MappedReader(const std::string &path, size_t window = 0) : file_(path), window_(window) {
+        if (window_) {
+            size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            window_ = (window_ + page - 1) & ~(page - 1);
+            file_.advise(MADV_SEQUENTIAL);
+        }
+    }
+
+    // Serves [off, off + len) of the file only (a chunk embedded in a larger image).
+    MappedReader(const std::string &path, size_t off, size_t len, size_t window) : MappedReader(path, window) {
+        if (off > file_.size() || len > file_.size() - off) {
+            throw std::runtime_error(path + ": range beyond end of file");
+        }
+        begin_ = pos_ = off;
+        end_ = off + len;
+    }
+
+    static const char *read(lua_State *, void *ud, size_t *sz) {
+        return static_cast<MappedReader *>(ud)->next(sz);
+    }
+
+    const char *next(size_t *sz) {
+        size_t end = end_ == SIZE_MAX ? file_.size() : end_;
+        if (pos_ >= end) {
+            *sz = 0;
+            return nullptr;
+        }
+        size_t len = window_ ? std::min(window_, end - pos_) : end - pos_;
+        if (window_) {
+            // lzio is done with the block before the previous one (luaZ_view
+            // callers may still hold the previous one)
+            if (prev_ != SIZE_MAX && prev_ >= begin_ + window_) {
+                file_.advise(MADV_DONTNEED, prev_ - window_, window_);
+            }
+            if (pos_ + len < end) {
+                file_.advise(MADV_WILLNEED, pos_ + len, std::min(window_, end - pos_ - len));
+            }
+            prev_ = pos_;
+        }
+        const char *p = reinterpret_cast<const char *>(file_.data()) + pos_;
+        pos_ += len;
+        *sz = len;
+        return p;
+    }
+
+    size_t size() const { return (end_ == SIZE_MAX ? file_.size() : end_) - begin_; }
+    const common::MappedFile &file() const { return file_; }
+
+  private:
+    common::MappedFile file_;
+    size_t window_;
+    size_t begin_ = 0;
+    size_t pos_ = 0;
+    size_t prev_ = SIZE_MAX;
+    size_t end_ = SIZE_MAX;
+};
+
+
+// Fragments concatenated into one chunk, each returned in place.
+class ScatterReader {
+  public:
+    struct Fragment {
+        const char *data;
+        size_t size;
+    };
+
+    void add(const void *data, size_t size) {
+        if (size) {  // an empty block would read as end of chunk
+            frags_.push_back({static_cast<const char *>(data), size});
+            total_ += size;
+        }
+    }
+
+    // Maps 'path' (once per distinct path) and adds [off, off + len) of it;
+    // the default length runs to the end of the file.
+    void add_file(const std::string &path, size_t off = 0, size_t len = SIZE_MAX) {
+        const common::MappedFile *f = nullptr;
+        for (const common::MappedFile &m : files_) {
+            if (m.path() == path) {
+                f = &m;
+            }
+        }
+        if (!f) {
+            files_.emplace_back(path);
+            f = &files_.back();
+        }
+        if (off > f->size() || (len != SIZE_MAX && len > f->size() - off)) {
+            throw std::runtime_error(path + ": fragment beyond end of file");
+        }
+        add(f->data() + off, len == SIZE_MAX ? f->size() - off : len);
+    }
+
+    // Parses "PATH[@OFFSET[+LENGTH]]{,PATH[@OFFSET[+LENGTH]]}"; offsets and
+    // lengths accept any strtoull base prefix.
+    void add_spec(const std::string &spec) {
+        size_t start = 0;
+        while (start <= spec.size()) {
+            size_t comma = spec.find(',', start);
+            std::string part = spec.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+            size_t at = part.rfind('@');
+            std::string path = part.substr(0, at);
+            size_t off = 0, len = SIZE_MAX;
+            if (at != std::string::npos) {
+                std::string range = part.substr(at + 1);
+                size_t plus = range.find('+');
+                off = std::strtoull(range.substr(0, plus).c_str(), nullptr, 0);
+                if (plus != std::string::npos) {
+                    len = std::strtoull(range.substr(plus + 1).c_str(), nullptr, 0);
+                }
+            }
+            add_file(path, off, len);
+            if (comma == std::string::npos) {
+                break;
+            }
+            start = comma + 1;
+        }
+    }
+
+    static const char *read(lua_State *, void *ud, size_t *sz) {
+        return static_cast<ScatterReader *>(ud)->next(sz);
+    }
+
+    const char *next(size_t *sz) {
+        if (cur_ >= frags_.size()) {
+            *sz = 0;
+            return nullptr;
+        }
+        const Fragment &f = frags_[cur_++];
+        *sz = f.size;
+        return f.data;
+    }
+
+    void rewind() { cur_ = 0; }
+    size_t size() const { return total_; }
+    const std::vector<Fragment> &fragments() const { return frags_; }
+
+  private:
+    std::deque<common::MappedFile> files_;  // stable addresses for the fragments
+    std::vector<Fragment> frags_;
+    size_t cur_ = 0;
+    size_t total_ = 0;
+};
+
+}  // namespace lua
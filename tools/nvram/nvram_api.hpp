@@ -0,0 +1,91 @@
+/*
+ *   The key-taking functions of libnvram, from the prototypes of a .gdt
+ *   archive (gdt/libnvram.gdt):
+ *
+ *     char *nvram_get(char *key)                 read
+ *     int nvram_get_buf(char *key, char *buf, size_t sz)
+ *     int nvram_set(char *key, char *val)        write
+ *     int nvram_bufset(int idx, char *key, char *val)
+ *
+ *   A function belongs to the API when it has a char * parameter named
+ *   "key" among its first four (the ones passed in registers or found by
+ *   the call-site trackers); 'val' is the value it writes. Whether a call
+ *   reads or writes the key follows from the function name: set, unset and
+ *   the list add/del functions write, everything else reads.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "gdt/gdt_types.hpp"
+
+
+namespace nvram {
+
+enum class Access { READ, WRITE };
+
+struct ApiFunction {
+    std::string name;
+    int key = -1;            // argument index of the key
+    int value = -1;          // argument index of the value written, -1 if none
+    bool value_is_string = false;
+    Access access = Access::READ;
+    std::string decl;
+};
+
+inline const char *access_name(Access a) { return a == Access::WRITE ? "W" : "R"; }
+
+// Key-taking functions of the archive, in archive order; with 'only' given,
+// just the functions named there.
+inline std::vector<ApiFunction> api_functions(const gdt::Archive &a, const std::vector<std::string> &only = {}) {
+    std::vector<ApiFunction> out;
+    auto is_char_ptr = [&](int64_t type) {
+        const gdt::DataType *t = a.get(a.resolve(type));
+        const gdt::DataType *to = t && t->table() == gdt::T_POINTER ? a.get(a.resolve(t->target)) : nullptr;
+        return to && to->name == "char";
+    };
+    for (const gdt::DataType *t : a.types()) {
+        if (t->table() != gdt::T_FUNCDEF) {
+            continue;
+        }
+        bool wanted = only.empty();
+        for (const std::string &n : only) {
+            wanted = wanted || n == t->name;
+        }
+        bool seen = false;
+        for (const ApiFunction &f : out) {
+            seen = seen || f.name == t->name;
+        }
+        if (!wanted || seen) {
+            continue;
+        }
+        ApiFunction f;
+        f.name = t->name;
+        for (size_t i = 0; i < t->params.size() && i < 4; i++) {
+            const gdt::Parameter &p = t->params[i];
+            if (p.name == "key" && is_char_ptr(p.type)) {
+                f.key = int(i);
+            } else if (p.name == "val") {
+                f.value = int(i);
+                f.value_is_string = is_char_ptr(p.type);
+            }
+        }
+        if (f.key < 0) {
+            continue;
+        }
+        const std::string &n = f.name;
+        bool writes = n.find("set") != std::string::npos || n.find("_add") != std::string::npos ||
+                      n.find("_del") != std::string::npos;
+        f.access = writes ? Access::WRITE : Access::READ;
+        if (!writes) {
+            f.value = -1;  // nvram_default_get's val is a fallback, nvram_match's a comparand
+        }
+        f.decl = a.decl(t->id, t->name);
+        out.push_back(std::move(f));
+    }
+    return out;
+}
+
+}  // namespace nvram
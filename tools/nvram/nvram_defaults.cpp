@@ -0,0 +1,275 @@
+/*
+ *   nvram_defaults: extract the default NVRAM settings of flash dumps,
+ *   firmware blobs and memory dumps as key/value pairs.
+ *
+ *   NVRAM partitions, headerless "key=value" blocks and the pointer tables
+ *   handed to nvram_set_default_table (nvram/nvram_defaults.hpp) are
+ *   located in one pass over each input. The input is mapped and cut into
+ *   windows (--window, 64 MiB by default) that are scanned in parallel, a
+ *   batch of -j windows at a time; the pages of a window are dropped once it
+ *   is scanned, so resident memory stays near jobs * window for dumps of any
+ *   size. Pointer tables need the addresses of the dump: ELF cores supply
+ *   them, raw dumps take --base and --abi.
+ *
+ *   Output, one line per setting, in address order:
+ *
+ *     file  address  kind  key  value
+ *
+ *   with tabs, newlines and backslashes of values escaped. --tables prints
+ *   one line per table instead (file, address, kind, entries, bytes), and
+ *   --out DIR writes the dataset as columnar tables "tables" and "entries"
+ *   (common/columnar.hpp).
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/nvram/nvram_defaults.cpp -o nvram_defaults
+ */
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common/columnar.hpp"
+#include "common/files.hpp"
+#include "common/memory_image.hpp"
+#include "common/parallel.hpp"
+#include "nvram/nvram_defaults.hpp"
+
+
+namespace {
+
+struct Options {
+    uint64_t base = 0;
+    unsigned ptr_size = 0;  // 0: from the core, 4 for raw dumps
+    bool big_endian = false;
+    size_t min_entries = 8;
+    uint64_t window = 64u << 20;
+    bool tables = false;
+    std::string out;
+    unsigned jobs = common::default_jobs();
+    std::vector<std::string> paths;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: nvram_defaults [options] dump...\n"
+                 "  --base ADDR   load address of raw (non-ELF) dumps\n"
+                 "  --abi NAME    pointers of raw dumps: ilp32 (default), ilp32be, lp64, lp64be\n"
+                 "  --min N       entries a headerless block or pointer table needs (default 8)\n"
+                 "  --window N    bytes scanned per window (default 64 MiB)\n"
+                 "  --tables      one line per table: entries and size\n"
+                 "  --out DIR     write columnar tables \"tables\" and \"entries\" to DIR\n"
+                 "  -j N          number of windows scanned in parallel\n");
+    std::exit(2);
+}
+
+uint64_t parse_number(const char *s) {
+    char *end = nullptr;
+    uint64_t v = std::strtoull(s, &end, 0);
+    if (!end || *end) {
+        std::fprintf(stderr, "nvram_defaults: bad number '%s'\n", s);
+        std::exit(2);
+    }
+    return v;
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--base") {
+            o.base = parse_number(next());
+        } else if (a == "--abi") {
+            std::string abi = next();
+            if (abi == "ilp32" || abi == "ilp32be") {
+                o.ptr_size = 4;
+            } else if (abi == "lp64" || abi == "lp64be") {
+                o.ptr_size = 8;
+            } else {
+                usage();
+            }
+            o.big_endian = abi.size() > 2 && abi.compare(abi.size() - 2, 2, "be") == 0;
+        } else if (a == "--min") {
+            o.min_entries = static_cast<size_t>(parse_number(next()));
+        } else if (a == "--window") {
+            o.window = parse_number(next());
+        } else if (a == "--tables") {
+            o.tables = true;
+        } else if (a == "--out") {
+            o.out = next();
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else {
+            o.paths.push_back(a);
+        }
+    }
+    if (o.paths.empty() || o.window == 0) {
+        usage();
+    }
+    return o;
+}
+
+std::string escaped(const std::string &s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '\t') {
+            out += "\\t";
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\r') {
+            out += "\\r";
+        } else if (c == '\\') {
+            out += "\\\\";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+class Dataset {
+  public:
+    explicit Dataset(const std::string &dir)
+        : tables_(dir, "tables",
+                  {{"file", common::ColType::STR}, {"address", common::ColType::U64}, {"kind", common::ColType::STR},
+                   {"entries", common::ColType::U32}, {"size", common::ColType::U64}}),
+          entries_(dir, "entries",
+                   {{"file", common::ColType::STR}, {"table", common::ColType::U64}, {"idx", common::ColType::U32},
+                    {"key", common::ColType::STR}, {"value", common::ColType::STR}}) {}
+
+    void add(const std::string &file, const nvram::DefaultsTable &t) {
+        tables_.str(file).u64(t.addr).str(nvram::defaults_kind_name(t.kind))
+            .u32(static_cast<uint32_t>(t.entries.size())).u64(t.size).end_row();
+        for (size_t i = 0; i < t.entries.size(); i++) {
+            entries_.str(file).u64(t.addr).u32(static_cast<uint32_t>(i)).str(t.entries[i].key)
+                .str(t.entries[i].value).end_row();
+        }
+    }
+
+    uint64_t rows() const { return entries_.rows(); }
+
+    void close() {
+        tables_.close();
+        entries_.close();
+    }
+
+  private:
+    common::TableWriter tables_;
+    common::TableWriter entries_;
+};
+
+struct Window {
+    const common::Segment *segment;
+    uint64_t begin;
+    uint64_t end;
+};
+
+void print(const std::string &file, const nvram::DefaultsTable &t, bool tables) {
+    const char *kind = nvram::defaults_kind_name(t.kind);
+    if (tables) {
+        std::printf("%s\t0x%" PRIx64 "\t%s\t%zu\t%" PRIu64 "\n", file.c_str(), t.addr, kind, t.entries.size(), t.size);
+        return;
+    }
+    for (const nvram::DefaultEntry &e : t.entries) {
+        std::printf("%s\t0x%" PRIx64 "\t%s\t%s\t%s\n", file.c_str(), t.addr, kind, e.key.c_str(),
+                    escaped(e.value).c_str());
+    }
+}
+
+// Scans one dump window by window; returns the number of tables found.
+size_t scan(const Options &opt, const std::string &path, Dataset *dataset) {
+    common::MemoryImage img(path, opt.base);
+    unsigned ptr = img.elf_pointer_size();
+    if (!ptr) {
+        ptr = opt.ptr_size ? opt.ptr_size : 4;
+        img.set_little_endian(!opt.big_endian);
+    }
+    nvram::DefaultsScanner scanner(img, ptr, opt.min_entries);
+
+    std::vector<Window> windows;
+    for (const common::Segment &s : img.segments()) {
+        for (uint64_t b = 0; b < s.size; b += opt.window) {
+            windows.push_back({&s, b, std::min(s.size, b + opt.window)});
+        }
+    }
+    const common::MappedFile &file = img.file();
+    size_t found = 0;
+    size_t batch = std::max(1u, opt.jobs);
+    for (size_t first = 0; first < windows.size(); first += batch) {
+        size_t n = std::min(batch, windows.size() - first);
+        std::vector<std::vector<nvram::DefaultsTable>> results(n);
+        common::parallel_for(n, opt.jobs, [&](size_t i) {
+            const Window &w = windows[first + i];
+            size_t off = size_t(w.segment->data - file.data());
+            file.advise(MADV_WILLNEED, off + w.begin, w.end - w.begin);
+            results[i] = scanner.scan(*w.segment, w.begin, w.end);
+            file.advise(MADV_DONTNEED, off + w.begin, w.end - w.begin);
+        });
+        for (const std::vector<nvram::DefaultsTable> &r : results) {
+            for (const nvram::DefaultsTable &t : r) {
+                if (dataset) {
+                    dataset->add(path, t);
+                } else {
+                    print(path, t, opt.tables);
+                }
+            }
+            found += r.size();
+        }
+    }
+    return found;
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::unique_ptr<Dataset> dataset;
+    if (!opt.out.empty()) {
+        try {
+            if (::mkdir(opt.out.c_str(), 0777) != 0 && errno != EEXIST) {
+                throw std::runtime_error(std::strerror(errno));
+            }
+            dataset.reset(new Dataset(opt.out));
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "nvram_defaults: %s: %s\n", opt.out.c_str(), e.what());
+            return 1;
+        }
+    }
+
+    int status = 0;
+    size_t tables = 0;
+    for (const std::string &path : common::collect_files(opt.paths, "nvram_defaults")) {
+        try {
+            tables += scan(opt, path, dataset.get());
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "nvram_defaults: %s: %s\n", path.c_str(), e.what());
+            status = 1;
+        }
+    }
+    if (dataset) {
+        try {
+            dataset->close();
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "nvram_defaults: %s: %s\n", opt.out.c_str(), e.what());
+            return 1;
+        }
+        std::printf("%zu table(s), %" PRIu64 " setting(s) under %s\n", tables, dataset->rows(), opt.out.c_str());
+    }
+    return status;
+}
@@ -0,0 +1,367 @@
+/*
+ *   Default NVRAM tables in flash dumps, firmware blobs and memory dumps, in
+ *   the forms the default functions of libnvram (gdt/libnvram.gdt) load:
+ *
+ *     IMAGE   a flash NVRAM partition, struct nvram_header {magic "FLSH",
+ *             len, crc_ver_init, config_refresh, config_ncdl} followed by
+ *             "key=value\0" strings up to an empty one
+ *             (nvram_set_default_image, nvram_commit)
+ *     TEXT    the same strings without a header: defaults files read by
+ *             foreach_nvram_from(file, fp, data), built-in blocks
+ *             (nvram_set_default_builtin)
+ *     TABLE   char *tbl[] = {key, value, ..., NULL}
+ *             (nvram_set_default_table)
+ *     TUPLES  struct nvram_tuple {char *name, *value; struct nvram_tuple
+ *             *next;}[] ending with a NULL name (Broadcom router_defaults,
+ *             also accepted by nvram_set_default_table)
+ *
+ *   DefaultsScanner::scan looks at one window [begin, end) of a segment and
+ *   returns the tables whose first byte lies in it, reading on past the
+ *   window where a table continues; a table that starts in an earlier window
+ *   is left to that window. Windows are therefore independent and can be
+ *   scanned in parallel and released one by one, whatever the size of the
+ *   dump. Pointer tables are found through the addresses of the image
+ *   (ELF core segments, or the base given for a raw dump) and need at least
+ *   'min_entries' entries, as do TEXT runs; IMAGEs are taken on their header.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common/memory_image.hpp"
+
+
+namespace nvram {
+
+enum class DefaultsKind { IMAGE, TEXT, TABLE, TUPLES };
+
+inline const char *defaults_kind_name(DefaultsKind k) {
+    switch (k) {
+    case DefaultsKind::IMAGE: return "IMAGE";
+    case DefaultsKind::TEXT: return "TEXT";
+    case DefaultsKind::TABLE: return "TABLE";
+    case DefaultsKind::TUPLES: return "TUPLES";
+    }
+    return "?";
+}
+
+struct DefaultEntry {
+    std::string key;
+    std::string value;
+};
+
+struct DefaultsTable {
+    DefaultsKind kind = DefaultsKind::TEXT;
+    uint64_t addr = 0;  // first byte: header, first string or first pointer
+    uint64_t size = 0;  // bytes of the table itself, terminator included
+    std::vector<DefaultEntry> entries;
+};
+
+constexpr uint64_t NVRAM_HEADER_SIZE = 20;
+constexpr uint64_t NVRAM_MAX_IMAGE = 4u << 20;
+constexpr size_t NVRAM_MAX_KEY = 128;
+constexpr size_t NVRAM_MAX_VALUE = 4096;
+
+namespace detail {
+
+inline bool key_start(uint8_t c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+inline bool key_char(uint8_t c) { return key_start(c) || c == '.' || c == '-' || c == ':' || c == '/'; }
+
+// Values are text, UTF-8 included (SSIDs, descriptions).
+inline bool value_char(uint8_t c) { return (c >= 0x20 && c != 0x7f) || c == '\t' || c == '\n' || c == '\r'; }
+
+inline bool valid_key(const uint8_t *p, size_t n) {
+    if (n == 0 || n > NVRAM_MAX_KEY || !key_start(p[0])) {
+        return false;
+    }
+    for (size_t i = 1; i < n; i++) {
+        if (!key_char(p[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool valid_value(const uint8_t *p, size_t n) {
+    if (n > NVRAM_MAX_VALUE) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (!value_char(p[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Position of the '=' of a "key=value" string of n bytes, 0 if it is not one.
+inline size_t split(const uint8_t *p, size_t n) {
+    const uint8_t *eq = static_cast<const uint8_t *>(std::memchr(p, '=', std::min(n, NVRAM_MAX_KEY + 1)));
+    if (!eq) {
+        return 0;
+    }
+    size_t k = size_t(eq - p);
+    return valid_key(p, k) && valid_value(eq + 1, n - k - 1) ? k : 0;
+}
+
+}  // namespace detail
+
+class DefaultsScanner {
+  public:
+    DefaultsScanner(const common::MemoryImage &img, unsigned ptr_size, size_t min_entries)
+        : img_(img), ptr_(ptr_size), min_(std::max<size_t>(min_entries, 1)) {
+        const uint16_t one = 1;
+        swap_ = img.little_endian() != (*reinterpret_cast<const uint8_t *>(&one) == 1);
+        for (const common::Segment &s : img.segments()) {
+            lo_ = std::min(lo_, s.vaddr);
+            hi_ = std::max(hi_, s.vaddr + s.size);
+        }
+    }
+
+    // Tables starting in [begin, end) of segment s (offsets into the
+    // segment), sorted by address.
+    std::vector<DefaultsTable> scan(const common::Segment &s, uint64_t begin, uint64_t end) const {
+        std::vector<DefaultsTable> out;
+        end = std::min(end, s.size);
+        images(s, begin, end, out);
+        text(s, begin, end, out);
+        pointers(s, begin, end, 2, out);
+        pointers(s, begin, end, 3, out);
+        std::sort(out.begin(), out.end(),
+                  [](const DefaultsTable &a, const DefaultsTable &b) { return a.addr < b.addr; });
+        return out;
+    }
+
+  private:
+    // Byte order of a partition header at p, from its magic (0x48534c46,
+    // "FLSH" when little-endian): 1 little, 2 big, 0 none.
+    static int header_order(const uint8_t *p) {
+        if (std::memcmp(p, "FLSH", 4) == 0) {
+            return 1;
+        }
+        return std::memcmp(p, "HSLF", 4) == 0 ? 2 : 0;
+    }
+
+    static uint32_t u32(const uint8_t *p, int order) {
+        return order == 1 ? uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24
+                          : uint32_t(p[3]) | uint32_t(p[2]) << 8 | uint32_t(p[1]) << 16 | uint32_t(p[0]) << 24;
+    }
+
+    // Length of the partition whose header is at off, 0 if there is none.
+    static uint64_t image_length(const common::Segment &s, uint64_t off) {
+        if (s.size - off < NVRAM_HEADER_SIZE + 2) {
+            return 0;
+        }
+        int order = header_order(s.data + off);
+        if (!order) {
+            return 0;
+        }
+        uint64_t len = u32(s.data + off + 4, order);
+        if (len < NVRAM_HEADER_SIZE + 2 || len > NVRAM_MAX_IMAGE) {
+            return 0;
+        }
+        return std::min(len, s.size - off);
+    }
+
+    // "key=value\0" strings of [off, limit) up to the first empty one; the
+    // offset past the last string read is returned.
+    static uint64_t strings(const common::Segment &s, uint64_t off, uint64_t limit, bool lenient,
+                            std::vector<DefaultEntry> *out, size_t &count) {
+        count = 0;
+        while (off < limit && s.data[off]) {
+            const uint8_t *p = s.data + off;
+            const uint8_t *z = static_cast<const uint8_t *>(std::memchr(p, 0, limit - off));
+            size_t n = z ? size_t(z - p) : size_t(limit - off);
+            size_t k = z ? detail::split(p, n) : 0;
+            if (k) {
+                count++;
+                if (out) {
+                    out->push_back({std::string(p, p + k), std::string(p + k + 1, p + n)});
+                }
+            } else if (!lenient) {
+                break;
+            }
+            off += n + 1;
+        }
+        return std::min(off, limit);
+    }
+
+    void images(const common::Segment &s, uint64_t begin, uint64_t end, std::vector<DefaultsTable> &out) const {
+        for (uint64_t off = (begin + 3) & ~uint64_t(3); off + 4 <= end; off += 4) {
+            uint64_t len = image_length(s, off);
+            if (!len) {
+                continue;
+            }
+            DefaultsTable t;
+            t.kind = DefaultsKind::IMAGE;
+            t.addr = s.vaddr + off;
+            t.size = len;
+            size_t n;
+            strings(s, off + NVRAM_HEADER_SIZE, off + len, true, &t.entries, n);
+            if (n) {
+                out.push_back(std::move(t));
+            }
+        }
+    }
+
+    // Whether the string ending just before off is a "key=value" entry.
+    static bool entry_before(const common::Segment &s, uint64_t off) {
+        if (off < 2 || s.data[off - 1] != 0 || s.data[off - 2] == 0) {
+            return false;
+        }
+        const uint64_t longest = NVRAM_MAX_KEY + NVRAM_MAX_VALUE + 1;
+        uint64_t from = off - 1 > longest ? off - 1 - longest : 0;
+        uint64_t start = off - 1;
+        while (start > from && s.data[start - 1]) {
+            start--;
+        }
+        if (start == from && start > 0 && s.data[start - 1]) {
+            return false;  // longer than any entry
+        }
+        return detail::split(s.data + start, off - 1 - start) != 0;
+    }
+
+    void text(const common::Segment &s, uint64_t begin, uint64_t end, std::vector<DefaultsTable> &out) const {
+        uint64_t off = begin;
+        if (off > 0 && s.data[off - 1]) {
+            const void *z = off < end ? std::memchr(s.data + off, 0, end - off) : nullptr;
+            if (!z) {
+                return;
+            }
+            off = uint64_t(static_cast<const uint8_t *>(z) - s.data) + 1;
+        }
+        bool continued = entry_before(s, off);  // the run there belongs to an earlier window
+        while (off < end) {
+            size_t n;
+            uint64_t stop = strings(s, off, s.size, false, nullptr, n);
+            if (n >= min_ && !continued && !(off >= NVRAM_HEADER_SIZE && image_length(s, off - NVRAM_HEADER_SIZE))) {
+                DefaultsTable t;
+                t.kind = DefaultsKind::TEXT;
+                t.addr = s.vaddr + off;
+                t.size = stop - off;
+                strings(s, off, stop, false, &t.entries, n);
+                out.push_back(std::move(t));
+            }
+            continued = false;
+            // On to the next string after the run.
+            off = stop;
+            if (off < s.size && s.data[off] == 0) {
+                off++;
+            } else if (off < end) {
+                const void *z = std::memchr(s.data + off, 0, end - off);
+                off = z ? uint64_t(static_cast<const uint8_t *>(z) - s.data) + 1 : end;
+            }
+        }
+    }
+
+    // The pointer at off; a load and at most a byte swap, as every word of a
+    // window is looked at.
+    uint64_t word(const common::Segment &s, uint64_t off) const {
+        if (ptr_ == 4) {
+            uint32_t v;
+            std::memcpy(&v, s.data + off, 4);
+            return swap_ ? __builtin_bswap32(v) : v;
+        }
+        uint64_t v;
+        std::memcpy(&v, s.data + off, 8);
+        return swap_ ? __builtin_bswap64(v) : v;
+    }
+
+    // Length of the string at addr if it is a key (a value), -1 otherwise.
+    long string_length(uint64_t addr, bool key) const {
+        if (addr < lo_ || addr >= hi_) {
+            return -1;
+        }
+        uint64_t n = std::min<uint64_t>(img_.extent(addr), (key ? NVRAM_MAX_KEY : NVRAM_MAX_VALUE) + 1);
+        const uint8_t *p = n ? img_.at(addr, n) : nullptr;
+        const uint8_t *z = p ? static_cast<const uint8_t *>(std::memchr(p, 0, n)) : nullptr;
+        if (!z) {
+            return -1;
+        }
+        size_t len = size_t(z - p);
+        return (key ? detail::valid_key(p, len) : detail::valid_value(p, len)) ? long(len) : -1;
+    }
+
+    // Entry of 'stride' pointers at off: key, value and, for tuples, a NULL next.
+    bool entry_at(const common::Segment &s, uint64_t off, unsigned stride) const {
+        if (off + uint64_t(stride) * ptr_ > s.size) {
+            return false;
+        }
+        if (stride == 3) {
+            uint64_t next = word(s, off + 2 * ptr_);
+            if (next > 1) {
+                return false;
+            }
+        }
+        return string_length(word(s, off), true) >= 0 && string_length(word(s, off + ptr_), false) >= 0;
+    }
+
+    // Whether the next 'min_' entries at off have the shape of a table, from
+    // the words alone: key and value inside the image, tuple links NULL.
+    // Only then are strings read, so random data costs no page faults.
+    bool shaped(const common::Segment &s, uint64_t off, unsigned stride) const {
+        uint64_t step = uint64_t(stride) * ptr_;
+        if (s.size - off < min_ * step) {
+            return false;
+        }
+        for (size_t e = 0; e < min_; e++, off += step) {
+            uint64_t k = word(s, off), v = word(s, off + ptr_);
+            if (k < lo_ || k >= hi_ || v < lo_ || v >= hi_ || (stride == 3 && word(s, off + 2 * ptr_) > 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string string_at(uint64_t addr) const {
+        const uint8_t *p = img_.at(addr, 1);
+        return std::string(reinterpret_cast<const char *>(p), size_t(string_length(addr, false)));
+    }
+
+    void pointers(const common::Segment &s, uint64_t begin, uint64_t end, unsigned stride,
+                  std::vector<DefaultsTable> &out) const {
+        uint64_t step = uint64_t(stride) * ptr_;
+        uint64_t first = (s.vaddr + begin + ptr_ - 1) / ptr_ * ptr_ - s.vaddr;
+        for (uint64_t off = first; off < end; off += ptr_) {
+            if (!shaped(s, off, stride) || !entry_at(s, off, stride) ||
+                (off >= step && entry_at(s, off - step, stride))) {
+                continue;
+            }
+            uint64_t at = off;
+            size_t n = 0;
+            while (entry_at(s, at, stride)) {
+                at += step;
+                n++;
+            }
+            uint64_t tail = stride == 3 ? step : ptr_;
+            if (n >= min_ && at + tail <= s.size && word(s, at) == 0) {
+                DefaultsTable t;
+                t.kind = stride == 3 ? DefaultsKind::TUPLES : DefaultsKind::TABLE;
+                t.addr = s.vaddr + off;
+                t.size = at + tail - off;
+                for (uint64_t e = off; e < at; e += step) {
+                    t.entries.push_back({string_at(word(s, e)), string_at(word(s, e + ptr_))});
+                }
+                out.push_back(std::move(t));
+            }
+            off = at - ptr_;  // past the run, table or not
+        }
+    }
+
+    const common::MemoryImage &img_;
+    unsigned ptr_;
+    size_t min_;
+    bool swap_ = false;
+    uint64_t lo_ = ~uint64_t(0);
+    uint64_t hi_ = 0;
+};
+
+}  // namespace nvram
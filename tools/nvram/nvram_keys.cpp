@@ -0,0 +1,218 @@
+/*
+ *   nvram_keys: index the NVRAM keys a router firmware reads and writes.
+ *
+ *   The key-taking functions of libnvram (nvram_get, nvram_safe_get,
+ *   nvram_set, nvram_unset, ...) and the position of their key argument
+ *   come from a .gdt archive (nvram::api_functions). Every executable and
+ *   library of the image is scanned in one parallel pass for calls to them
+ *   (common/callsites.hpp: PLT, MIPS GOT and stubs, or the definition inside
+ *   libnvram itself), and the constant key strings are collected into one
+ *   index, sorted by key:
+ *
+ *     key  R|W  file  caller  function  [value]
+ *
+ *   with the value for writes ("?" where it is not a constant; strings
+ *   are quoted). --keys prints one line per key instead: key, reads,
+ *   writes, files.
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/nvram/nvram_keys.cpp -o nvram_keys
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "common/callsites.hpp"
+#include "common/elf.hpp"
+#include "common/files.hpp"
+#include "common/mapped_file.hpp"
+#include "common/parallel.hpp"
+#include "common/symbols.hpp"
+#include "gdt/gdt_types.hpp"
+#include "nvram/nvram_api.hpp"
+
+
+namespace {
+
+struct Options {
+    bool keys = false;
+    bool unresolved = false;
+    std::vector<std::string> functions;
+    unsigned jobs = common::default_jobs();
+    std::string archive;
+    std::vector<std::string> paths;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: nvram_keys [options] libnvram.gdt path...\n"
+                 "  --keys            one line per key: reads, writes, files\n"
+                 "  --unresolved      also list calls whose key is not a constant (as \"?\")\n"
+                 "  --function NAME   only calls to NAME (repeatable)\n"
+                 "  -j N              number of files scanned in parallel\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--keys") {
+            o.keys = true;
+        } else if (a == "--unresolved") {
+            o.unresolved = true;
+        } else if (a == "--function") {
+            o.functions.push_back(next());
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (o.archive.empty()) {
+            o.archive = a;
+        } else {
+            o.paths.push_back(a);
+        }
+    }
+    if (o.archive.empty() || o.paths.empty()) {
+        usage();
+    }
+    return o;
+}
+
+struct Use {
+    size_t file;
+    uint64_t addr;
+    std::string caller;
+    const nvram::ApiFunction *function;
+    std::string value;
+};
+
+// NVRAM keys and values are short printable strings.
+bool printable(const std::string &s, bool allow_empty) {
+    if ((s.empty() && !allow_empty) || s.size() > 256) {
+        return false;
+    }
+    for (char c : s) {
+        if (c < 0x20 || c > 0x7e) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The string argument 'arg' points to, if it is a constant address.
+bool string_at(const common::ElfFile &elf, const common::DirectCall &c, int arg, bool allow_empty, std::string &s) {
+    if (arg < 0 || !(c.known & (1u << arg)) || !elf.at_vaddr(c.args[arg])) {
+        return false;
+    }
+    s = elf.cstring_at(c.args[arg], 257);
+    return printable(s, allow_empty);
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::vector<nvram::ApiFunction> api;
+    try {
+        gdt::Archive a(opt.archive);
+        api = nvram::api_functions(a, opt.functions);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "nvram_keys: %s: %s\n", opt.archive.c_str(), e.what());
+        return 1;
+    }
+    if (api.empty()) {
+        std::fprintf(stderr, "nvram_keys: %s: no functions with a key parameter\n", opt.archive.c_str());
+        return 1;
+    }
+    std::vector<std::string> names;
+    for (const nvram::ApiFunction &f : api) {
+        names.push_back(f.name);
+    }
+
+    std::vector<std::string> files = common::collect_files(opt.paths, "nvram_keys");
+    std::map<std::string, std::vector<Use>> index;
+    std::mutex lock;
+    int status = 0;
+
+    common::parallel_for(files.size(), opt.jobs, [&](size_t i) {
+        std::vector<std::pair<std::string, Use>> found;
+        try {
+            common::MappedFile f(files[i]);
+            if (!common::ElfFile::is_elf(f.data(), f.size())) {
+                return;
+            }
+            common::ElfFile elf(f.data(), f.size());
+            common::CallTargets targets(elf, names);
+            if (targets.empty()) {
+                return;
+            }
+            common::SymbolMap syms(elf);
+            common::scan_direct_calls(elf, targets, [&](const common::DirectCall &c) {
+                const nvram::ApiFunction &fn = api[size_t(c.function)];
+                std::string key;
+                if (!string_at(elf, c, fn.key, false, key)) {
+                    if (!opt.unresolved) {
+                        return;
+                    }
+                    key = "?";
+                }
+                Use u{i, c.addr, syms.containing(c.addr), &fn, "?"};
+                if (fn.value >= 0 && fn.value_is_string) {
+                    std::string v;
+                    u.value = string_at(elf, c, fn.value, true, v) ? "\"" + v + "\"" : "?";
+                } else if (fn.value >= 0 && (c.known & (1u << fn.value))) {
+                    u.value = std::to_string(int32_t(c.args[fn.value]));
+                }
+                found.push_back({key, std::move(u)});
+            });
+        } catch (const std::exception &e) {
+            std::lock_guard<std::mutex> g(lock);
+            std::fprintf(stderr, "nvram_keys: %s: %s\n", files[i].c_str(), e.what());
+            status = 1;
+            return;
+        }
+        std::lock_guard<std::mutex> g(lock);
+        for (auto &kv : found) {
+            index[kv.first].push_back(std::move(kv.second));
+        }
+    });
+
+    for (auto &kv : index) {
+        std::vector<Use> &uses = kv.second;
+        std::sort(uses.begin(), uses.end(),
+                  [](const Use &x, const Use &y) { return x.file != y.file ? x.file < y.file : x.addr < y.addr; });
+        if (opt.keys) {
+            size_t reads = 0, writes = 0;
+            std::set<size_t> in;
+            for (const Use &u : uses) {
+                (u.function->access == nvram::Access::WRITE ? writes : reads)++;
+                in.insert(u.file);
+            }
+            std::printf("%s\t%zu\t%zu\t%zu\n", kv.first.c_str(), reads, writes, in.size());
+            continue;
+        }
+        for (const Use &u : uses) {
+            std::printf("%s\t%s\t%s\t%s\t%s", kv.first.c_str(), nvram::access_name(u.function->access),
+                        files[u.file].c_str(), u.caller.c_str(), u.function->name.c_str());
+            if (u.function->value >= 0) {
+                std::printf("\t%s", u.value.c_str());
+            }
+            std::printf("\n");
+        }
+    }
+    return status;
+}
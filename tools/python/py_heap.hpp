@@ -0,0 +1,306 @@
+/*
+ *   CPython objects in a process dump, found through their ob_type pointers.
+ *
+ *   Every object starts with a PyObject whose ob_type points at a type
+ *   object, and every type object is itself an object whose ob_type is
+ *   PyType_Type or a subclass of it (a metaclass such as ABCMeta). So:
+ *
+ *     1. PyType_Type is the object whose ob_type points to itself and whose
+ *        tp_name is "type";
+ *     2. the type objects are the objects whose ob_type is a known metatype;
+ *        types found that derive from a metatype (tp_base chain) are
+ *        metatypes as well, and the pass is repeated for them;
+ *     3. every pointer-aligned word that equals a known type address is the
+ *        ob_type of an object, which is attributed to that type.
+ *
+ *   Each pass reads the dump in chunks of pointer-sized words. A chunk is
+ *   first reduced with the SIMD range filter of common/words.hpp against
+ *   the hull of the addresses looked for, and only the surviving words are
+ *   probed in the hash set of addresses, so the work per word is a vector
+ *   compare. Chunks are independent and are scanned in parallel.
+ *
+ *   Candidates are checked on their header: a type object needs a printable
+ *   tp_name, sane tp_basicsize/tp_itemsize and Py_TPFLAGS_READY; an object
+ *   needs a positive reference count (immortal objects of 3.12+ included).
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "common/memory_image.hpp"
+#include "common/parallel.hpp"
+#include "common/words.hpp"
+#include "python/py_layout.hpp"
+
+
+namespace python {
+
+constexpr uint64_t Py_TPFLAGS_READY = uint64_t(1) << 12;
+constexpr uint64_t MAX_BASICSIZE = 1u << 20;
+
+struct TypeInfo {
+    uint64_t addr = 0;
+    uint64_t metatype = 0;  // its ob_type
+    std::string name;
+    uint64_t basicsize = 0;
+    uint64_t itemsize = 0;
+    uint64_t flags = 0;
+    uint64_t base = 0;
+    bool meta = false;  // PyType_Type or derived from it
+};
+
+struct Tally {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+// A chunk of the dump: [begin, end) of a segment.
+struct Chunk {
+    const common::Segment *segment;
+    uint64_t begin;
+    uint64_t end;
+};
+
+class Heap {
+  public:
+    Heap(const common::MemoryImage &img, const Layouts &l, unsigned jobs, uint64_t chunk_size)
+        : img_(img), l_(l), ptr_(unsigned(l.organization().pointer_size)), jobs_(jobs) {
+        chunk_size = std::max<uint64_t>(chunk_size / ptr_ * ptr_, ptr_ * 64);
+        for (const common::Segment &s : img.segments()) {
+            for (uint64_t b = 0; b < s.size; b += chunk_size) {
+                chunks_.push_back({&s, b, std::min(s.size, b + chunk_size)});
+            }
+        }
+        refcnt_ = l.object().offset("ob_refcnt");
+        ob_type_ = l.object().offset("ob_type");
+        ob_size_ = l.var_object().offset("ob_size");
+        tp_name_ = l.type().offset("tp_name");
+        tp_basicsize_ = l.type().offset("tp_basicsize");
+        tp_itemsize_ = l.type().offset("tp_itemsize");
+        tp_flags_ = l.type().offset("tp_flags");
+        tp_flags_size_ = unsigned(l.type().field("tp_flags").size);
+        tp_base_ = l.type().offset("tp_base");
+    }
+
+    // Steps 1 and 2: PyType_Type and every type object reachable from it.
+    void find_types() {
+        std::vector<uint64_t> roots;
+        std::mutex lock;
+        each_chunk([&](const std::vector<uint64_t> &w, uint64_t first) {
+            for (size_t i = 0; i < w.size(); i++) {
+                uint64_t at = first + i * ptr_;
+                TypeInfo t;
+                if (w[i] + ob_type_ == at && read_type(w[i], t) && t.name == "type") {
+                    std::lock_guard<std::mutex> g(lock);
+                    roots.push_back(w[i]);
+                }
+            }
+        });
+        std::vector<uint64_t> metas;
+        for (uint64_t r : roots) {
+            TypeInfo t;
+            read_type(r, t);
+            t.meta = true;
+            types_[r] = t;
+            metas.push_back(r);
+        }
+        for (int round = 0; round < 8 && !metas.empty(); round++) {
+            std::unordered_set<uint64_t> wanted(metas.begin(), metas.end());
+            std::vector<TypeInfo> found;
+            references(wanted, [&](uint64_t obj, uint64_t) {
+                TypeInfo t;
+                if (read_type(obj, t)) {
+                    std::lock_guard<std::mutex> g(lock);
+                    found.push_back(t);
+                }
+            });
+            for (TypeInfo &t : found) {
+                types_.emplace(t.addr, t);
+            }
+            metas.clear();
+            for (auto &kv : types_) {
+                if (!kv.second.meta && derives_from_meta(kv.second)) {
+                    kv.second.meta = true;
+                    metas.push_back(kv.first);
+                }
+            }
+        }
+    }
+
+    // Step 3: objects per type, in one pass.
+    std::unordered_map<uint64_t, Tally> classify() const {
+        std::unordered_set<uint64_t> wanted;
+        for (const auto &kv : types_) {
+            wanted.insert(kv.first);
+        }
+        std::unordered_map<uint64_t, Tally> total;
+        std::mutex lock;
+        each_chunk([&](const std::vector<uint64_t> &w, uint64_t first) {
+            std::unordered_map<uint64_t, Tally> local;
+            probe(w, first, wanted, [&](uint64_t obj, uint64_t type) {
+                uint64_t size;
+                if (object_size(obj, types_.at(type), size)) {
+                    Tally &t = local[type];
+                    t.count++;
+                    t.bytes += size;
+                }
+            });
+            std::lock_guard<std::mutex> g(lock);
+            for (const auto &kv : local) {
+                total[kv.first].count += kv.second.count;
+                total[kv.first].bytes += kv.second.bytes;
+            }
+        });
+        return total;
+    }
+
+    const std::unordered_map<uint64_t, TypeInfo> &types() const { return types_; }
+
+    // The type object at addr, if its header looks like one.
+    bool read_type(uint64_t addr, TypeInfo &t) const {
+        uint64_t name, flags;
+        if (!img_.contains(addr, l_.type().size) || !img_.read(addr + tp_name_, ptr_, name) ||
+            !img_.read(addr + tp_flags_, tp_flags_size_, flags) || !(flags & Py_TPFLAGS_READY)) {
+            return false;
+        }
+        t.addr = addr;
+        t.metatype = img_.read_or(addr + ob_type_, ptr_, 0);
+        t.basicsize = img_.read_or(addr + tp_basicsize_, ptr_, 0);
+        t.itemsize = img_.read_or(addr + tp_itemsize_, ptr_, 0);
+        t.flags = flags;
+        t.base = img_.read_or(addr + tp_base_, ptr_, 0);
+        if (t.basicsize < l_.object().size || t.basicsize > MAX_BASICSIZE || t.itemsize > MAX_BASICSIZE) {
+            return false;
+        }
+        return read_name(name, t.name);
+    }
+
+  private:
+    // fn(words of a chunk, address of the first word) on every chunk, in
+    // parallel; the chunk's pages are released afterwards.
+    template <typename Fn>
+    void each_chunk(Fn &&fn) const {
+        const common::MappedFile &file = img_.file();
+        common::parallel_for(chunks_.size(), jobs_, [&](size_t i) {
+            const Chunk &c = chunks_[i];
+            uint64_t first = (c.segment->vaddr + c.begin + ptr_ - 1) / ptr_ * ptr_;
+            uint64_t off = first - c.segment->vaddr;
+            std::vector<uint64_t> w;
+            w.reserve(size_t((c.end - c.begin) / ptr_));
+            for (; off + ptr_ <= c.end; off += ptr_) {
+                w.push_back(img_.decode(c.segment->data + off, ptr_));
+            }
+            fn(w, first);
+            size_t at = size_t(c.segment->data - file.data());
+            file.advise(MADV_DONTNEED, at + c.begin, c.end - c.begin);
+        });
+    }
+
+    // fn(object, type) for every word of w that is one of 'wanted', through
+    // the range filter on the hull of 'wanted'.
+    template <typename Fn>
+    void probe(const std::vector<uint64_t> &w, uint64_t first, const std::unordered_set<uint64_t> &wanted,
+               Fn &&fn) const {
+        common::Range hull, none{0, 0};
+        for (uint64_t a : wanted) {
+            hull.add(a, 1);
+        }
+        std::vector<uint64_t> in(common::mask_words(w.size())), unused(in.size());
+        common::classify_ranges(w.data(), w.size(), hull, none, in.data(), unused.data());
+        for (size_t k = 0; k + 1 < in.size(); k++) {
+            for (uint64_t m = in[k]; m; m &= m - 1) {
+                size_t i = k * 64 + size_t(__builtin_ctzll(m));
+                uint64_t at = first + i * ptr_;
+                if (wanted.count(w[i]) && at >= ob_type_ && refcount_ok(at - ob_type_)) {
+                    fn(at - ob_type_, w[i]);
+                }
+            }
+        }
+    }
+
+    template <typename Fn>
+    void references(const std::unordered_set<uint64_t> &wanted, Fn &&fn) const {
+        each_chunk([&](const std::vector<uint64_t> &w, uint64_t first) { probe(w, first, wanted, fn); });
+    }
+
+    bool refcount_ok(uint64_t obj) const {
+        uint64_t r;
+        if (!img_.read(obj + refcnt_, ptr_, r)) {
+            return false;
+        }
+        if (ptr_ == 4) {
+            return int32_t(r) > 0;
+        }
+        return int64_t(r) > 0 && r <= 0xffffffffu;  // 3.12+ immortals sit at 2^32 - 1
+    }
+
+    bool object_size(uint64_t obj, const TypeInfo &t, uint64_t &size) const {
+        size = t.basicsize;
+        if (t.itemsize) {
+            uint64_t n;
+            if (!img_.read(obj + ob_size_, ptr_, n)) {
+                return false;
+            }
+            int64_t items = ptr_ == 4 ? int64_t(int32_t(n)) : int64_t(n);  // negative for negative ints
+            uint64_t count = uint64_t(items < 0 ? -items : items);
+            if (count > (uint64_t(1) << 40) / t.itemsize) {
+                return false;
+            }
+            size += count * t.itemsize;
+        }
+        return true;
+    }
+
+    bool derives_from_meta(const TypeInfo &t) const {
+        uint64_t b = t.base;
+        for (int depth = 0; b && depth < 64; depth++) {
+            auto it = types_.find(b);
+            if (it == types_.end()) {
+                return false;
+            }
+            if (it->second.meta) {
+                return true;
+            }
+            b = it->second.base;
+        }
+        return false;
+    }
+
+    bool read_name(uint64_t addr, std::string &out) const {
+        uint64_t n = std::min<uint64_t>(img_.extent(addr), 256);
+        const uint8_t *p = n ? img_.at(addr, n) : nullptr;
+        const uint8_t *z = p ? static_cast<const uint8_t *>(std::memchr(p, 0, n)) : nullptr;
+        if (!z || z == p) {
+            return false;
+        }
+        for (const uint8_t *q = p; q < z; q++) {
+            if (*q < 0x20 || *q > 0x7e) {
+                return false;
+            }
+        }
+        out.assign(reinterpret_cast<const char *>(p), size_t(z - p));
+        return true;
+    }
+
+    const common::MemoryImage &img_;
+    const Layouts &l_;
+    unsigned ptr_;
+    unsigned jobs_;
+    std::vector<Chunk> chunks_;
+    std::unordered_map<uint64_t, TypeInfo> types_;
+    uint64_t refcnt_, ob_type_, ob_size_;
+    uint64_t tp_name_, tp_basicsize_, tp_itemsize_, tp_flags_, tp_base_;
+    unsigned tp_flags_size_;
+};
+
+}  // namespace python
@@ -0,0 +1,173 @@
+/*
+ *   py_heapstat: count the CPython objects of process dumps per type.
+ *
+ *   The type objects of the interpreter are located from PyType_Type, and
+ *   every object of the dump is then attributed to its type by its ob_type
+ *   pointer (python/py_heap.hpp), with layouts for the given CPython version
+ *   (python/py_layout.hpp). Output per dump, largest types first:
+ *
+ *     count  bytes  type  address
+ *
+ *   where bytes is tp_basicsize plus ob_size * tp_itemsize per object (GC
+ *   headers and allocator slack not included). --types lists the type
+ *   objects found instead: address, metatype, basicsize, itemsize, flags,
+ *   name.
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -pthread -Itools tools/python/py_heapstat.cpp -o py_heapstat
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "common/memory_image.hpp"
+#include "common/parallel.hpp"
+#include "python/py_heap.hpp"
+#include "python/py_layout.hpp"
+
+
+namespace {
+
+struct Options {
+    std::string version = "3.8";
+    std::string abi;
+    uint64_t base = 0;
+    bool trace_refs = false;
+    bool types = false;
+    uint64_t chunk = 8u << 20;
+    unsigned jobs = common::default_jobs();
+    std::vector<std::string> dumps;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: py_heapstat [options] dump...\n"
+                 "  --version X.Y  CPython version of the process (default 3.8)\n"
+                 "  --abi NAME     target ABI of raw dumps: lp64 (default), lp64be, ilp32, ilp32be\n"
+                 "  --base ADDR    load address of raw (non-ELF) dumps\n"
+                 "  --trace-refs   Py_TRACE_REFS build\n"
+                 "  --types        list the type objects instead of the object counts\n"
+                 "  --chunk N      bytes per work item (default 8 MiB)\n"
+                 "  -j N           number of chunks scanned in parallel\n");
+    std::exit(2);
+}
+
+uint64_t parse_number(const char *s) {
+    char *end = nullptr;
+    uint64_t v = std::strtoull(s, &end, 0);
+    if (!end || *end) {
+        std::fprintf(stderr, "py_heapstat: bad number '%s'\n", s);
+        std::exit(2);
+    }
+    return v;
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--version") {
+            o.version = next();
+        } else if (a == "--abi") {
+            o.abi = next();
+        } else if (a == "--base") {
+            o.base = parse_number(next());
+        } else if (a == "--trace-refs") {
+            o.trace_refs = true;
+        } else if (a == "--types") {
+            o.types = true;
+        } else if (a == "--chunk") {
+            o.chunk = parse_number(next());
+        } else if (a == "-j") {
+            o.jobs = static_cast<unsigned>(std::atoi(next()));
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else {
+            o.dumps.push_back(a);
+        }
+    }
+    if (o.dumps.empty()) {
+        usage();
+    }
+    return o;
+}
+
+void report(const Options &opt, const std::string &path) {
+    python::Version version = python::Version::parse(opt.version);
+    common::MemoryImage img(path, opt.base);
+    std::string org = "lp64";
+    if (img.elf_pointer_size()) {
+        org = img.elf_pointer_size() == 8 ? "lp64" : "ilp32";
+    } else if (!opt.abi.empty()) {
+        if (opt.abi != "lp64" && opt.abi != "lp64be" && opt.abi != "ilp32" && opt.abi != "ilp32be") {
+            throw std::runtime_error("unknown ABI '" + opt.abi + "' (lp64, lp64be, ilp32, ilp32be)");
+        }
+        org = opt.abi.substr(0, opt.abi.size() - (opt.abi.back() == 'e' ? 2 : 0));
+        img.set_little_endian(opt.abi.back() != 'e');
+    }
+    python::Layouts layouts(version, gdt::DataOrganization::named(org), opt.trace_refs);
+    python::Heap heap(img, layouts, opt.jobs, opt.chunk);
+    heap.find_types();
+    if (heap.types().empty()) {
+        throw std::runtime_error("no PyType_Type found (wrong --version or --abi?)");
+    }
+
+    std::vector<const python::TypeInfo *> types;
+    for (const auto &kv : heap.types()) {
+        types.push_back(&kv.second);
+    }
+    if (opt.types) {
+        std::sort(types.begin(), types.end(),
+                  [](const python::TypeInfo *a, const python::TypeInfo *b) { return a->addr < b->addr; });
+        for (const python::TypeInfo *t : types) {
+            std::printf("0x%" PRIx64 "\t0x%" PRIx64 "\t%" PRIu64 "\t%" PRIu64 "\t0x%" PRIx64 "\t%s\n", t->addr,
+                        t->metatype, t->basicsize, t->itemsize, t->flags, t->name.c_str());
+        }
+        return;
+    }
+
+    std::unordered_map<uint64_t, python::Tally> tally = heap.classify();
+    std::vector<std::pair<const python::TypeInfo *, python::Tally>> rows;
+    python::Tally total;
+    for (const auto &kv : tally) {
+        rows.push_back({&heap.types().at(kv.first), kv.second});
+        total.count += kv.second.count;
+        total.bytes += kv.second.bytes;
+    }
+    std::sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) {
+        return a.second.bytes != b.second.bytes ? a.second.bytes > b.second.bytes : a.first->addr < b.first->addr;
+    });
+    std::printf("# %s: CPython %s %s, %zu types, %" PRIu64 " objects, %" PRIu64 " bytes\n", path.c_str(),
+                version.str().c_str(), org.c_str(), types.size(), total.count, total.bytes);
+    for (const auto &r : rows) {
+        std::printf("%" PRIu64 "\t%" PRIu64 "\t%s\t0x%" PRIx64 "\n", r.second.count, r.second.bytes,
+                    r.first->name.c_str(), r.first->addr);
+    }
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    int status = 0;
+    for (const std::string &path : opt.dumps) {
+        try {
+            report(opt, path);
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "py_heapstat: %s: %s\n", path.c_str(), e.what());
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,292 @@
+/*
+ *   Object layouts of CPython (Include/object.h, Include/cpython/object.h)
+ *   per interpreter version and data organization.
+ *
+ *   libCPython.gdt only knows PyObject as the 16 bytes a decompiler saw
+ *   (field_0x0 .. field_0xf); the members below are the real ones:
+ *
+ *     PyObject       ob_refcnt, ob_type (+ _ob_next, _ob_prev before them
+ *                    in Py_TRACE_REFS builds)
+ *     PyVarObject    ob_base, ob_size
+ *     PyTypeObject   PyObject_VAR_HEAD, then the tp_* slots, whose set and
+ *                    order changed over 2.7 and 3.0 - 3.13 (tp_print became
+ *                    tp_vectorcall_offset in 3.8, tp_compare tp_reserved and
+ *                    then tp_as_async, trailing slots were appended)
+ *
+ *   Members carry their C type and a scalar class; sizes and offsets follow
+ *   from the gdt::DataOrganization (natural alignment, as gcc, clang and
+ *   MSVC lay these structures out). Free-threaded 3.13 builds
+ *   (Py_GIL_DISABLED) have another PyObject and are not covered.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gdt/gdt_types.hpp"
+
+
+namespace python {
+
+struct Version {
+    unsigned major = 3;
+    unsigned minor = 8;
+
+    static Version parse(const std::string &s) {
+        Version v;
+        char dot = 0;
+        if (std::sscanf(s.c_str(), "%u%c%u", &v.major, &dot, &v.minor) != 3 || dot != '.' || !v.supported()) {
+            throw std::runtime_error("unsupported CPython version '" + s + "' (2.7, 3.0 - 3.13)");
+        }
+        return v;
+    }
+
+    bool supported() const { return (major == 2 && minor == 7) || (major == 3 && minor <= 13); }
+    bool at_least(unsigned ma, unsigned mi) const { return major > ma || (major == ma && minor >= mi); }
+    std::string str() const { return std::to_string(major) + "." + std::to_string(minor); }
+};
+
+// Scalar class of a member; its size comes from the data organization.
+enum class Scalar { SSIZE, POINTER, LONG, ULONG, UINT, U16, UCHAR };
+
+struct Member {
+    std::string name;
+    std::string ctype;  // as declared: "Py_ssize_t", "destructor", "struct _typeobject *"
+    Scalar scalar;
+    std::string nested;  // PyObject / PyVarObject embedded as a whole, else empty
+};
+
+struct Field {
+    std::string name;
+    std::string ctype;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct StructLayout {
+    std::string name;
+    uint64_t size = 0;
+    uint64_t align = 1;
+    std::vector<Field> fields;
+
+    const Field &field(const std::string &n) const {
+        for (const Field &f : fields) {
+            if (f.name == n) {
+                return f;
+            }
+        }
+        throw std::runtime_error(name + " has no field '" + n + "'");
+    }
+    uint64_t offset(const std::string &n) const { return field(n).offset; }
+};
+
+// The function-pointer typedefs of the tp_* slots, as object.h declares them.
+struct SlotType {
+    const char *name;
+    const char *decl;  // with "(*name)" where the name goes
+};
+
+inline const std::vector<SlotType> &slot_types() {
+    static const std::vector<SlotType> t = {
+        {"destructor", "void (*destructor)(PyObject *)"},
+        {"printfunc", "int (*printfunc)(PyObject *, FILE *, int)"},
+        {"getattrfunc", "PyObject *(*getattrfunc)(PyObject *, char *)"},
+        {"setattrfunc", "int (*setattrfunc)(PyObject *, char *, PyObject *)"},
+        {"cmpfunc", "int (*cmpfunc)(PyObject *, PyObject *)"},
+        {"reprfunc", "PyObject *(*reprfunc)(PyObject *)"},
+        {"hashfunc", "Py_hash_t (*hashfunc)(PyObject *)"},
+        {"ternaryfunc", "PyObject *(*ternaryfunc)(PyObject *, PyObject *, PyObject *)"},
+        {"getattrofunc", "PyObject *(*getattrofunc)(PyObject *, PyObject *)"},
+        {"setattrofunc", "int (*setattrofunc)(PyObject *, PyObject *, PyObject *)"},
+        {"visitproc", "int (*visitproc)(PyObject *, void *)"},
+        {"traverseproc", "int (*traverseproc)(PyObject *, visitproc, void *)"},
+        {"inquiry", "int (*inquiry)(PyObject *)"},
+        {"richcmpfunc", "PyObject *(*richcmpfunc)(PyObject *, PyObject *, int)"},
+        {"getiterfunc", "PyObject *(*getiterfunc)(PyObject *)"},
+        {"iternextfunc", "PyObject *(*iternextfunc)(PyObject *)"},
+        {"descrgetfunc", "PyObject *(*descrgetfunc)(PyObject *, PyObject *, PyObject *)"},
+        {"descrsetfunc", "int (*descrsetfunc)(PyObject *, PyObject *, PyObject *)"},
+        {"initproc", "int (*initproc)(PyObject *, PyObject *, PyObject *)"},
+        {"allocfunc", "PyObject *(*allocfunc)(struct _typeobject *, Py_ssize_t)"},
+        {"newfunc", "PyObject *(*newfunc)(struct _typeobject *, PyObject *, PyObject *)"},
+        {"freefunc", "void (*freefunc)(void *)"},
+        {"vectorcallfunc", "PyObject *(*vectorcallfunc)(PyObject *, PyObject *const *, size_t, PyObject *)"},
+    };
+    return t;
+}
+
+inline std::vector<Member> object_members(bool trace_refs) {
+    std::vector<Member> m;
+    if (trace_refs) {
+        m.push_back({"_ob_next", "struct _object *", Scalar::POINTER, ""});
+        m.push_back({"_ob_prev", "struct _object *", Scalar::POINTER, ""});
+    }
+    m.push_back({"ob_refcnt", "Py_ssize_t", Scalar::SSIZE, ""});
+    m.push_back({"ob_type", "struct _typeobject *", Scalar::POINTER, ""});
+    return m;
+}
+
+inline std::vector<Member> var_object_members() {
+    return {{"ob_base", "PyObject", Scalar::POINTER, "PyObject"}, {"ob_size", "Py_ssize_t", Scalar::SSIZE, ""}};
+}
+
+inline std::vector<Member> type_members(const Version &v) {
+    const Scalar P = Scalar::POINTER;
+    std::vector<Member> m = {{"ob_base", "PyVarObject", P, "PyVarObject"},
+                             {"tp_name", "const char *", P, ""},
+                             {"tp_basicsize", "Py_ssize_t", Scalar::SSIZE, ""},
+                             {"tp_itemsize", "Py_ssize_t", Scalar::SSIZE, ""},
+                             {"tp_dealloc", "destructor", P, ""}};
+    if (v.at_least(3, 8)) {
+        m.push_back({"tp_vectorcall_offset", "Py_ssize_t", Scalar::SSIZE, ""});
+    } else {
+        m.push_back({"tp_print", "printfunc", P, ""});
+    }
+    m.push_back({"tp_getattr", "getattrfunc", P, ""});
+    m.push_back({"tp_setattr", "setattrfunc", P, ""});
+    if (v.major == 2) {
+        m.push_back({"tp_compare", "cmpfunc", P, ""});
+    } else if (!v.at_least(3, 5)) {
+        m.push_back({"tp_reserved", "void *", P, ""});
+    } else {
+        m.push_back({"tp_as_async", "PyAsyncMethods *", P, ""});
+    }
+    m.push_back({"tp_repr", "reprfunc", P, ""});
+    m.push_back({"tp_as_number", "PyNumberMethods *", P, ""});
+    m.push_back({"tp_as_sequence", "PySequenceMethods *", P, ""});
+    m.push_back({"tp_as_mapping", "PyMappingMethods *", P, ""});
+    m.push_back({"tp_hash", "hashfunc", P, ""});
+    m.push_back({"tp_call", "ternaryfunc", P, ""});
+    m.push_back({"tp_str", "reprfunc", P, ""});
+    m.push_back({"tp_getattro", "getattrofunc", P, ""});
+    m.push_back({"tp_setattro", "setattrofunc", P, ""});
+    m.push_back({"tp_as_buffer", "PyBufferProcs *", P, ""});
+    if (v.major == 2) {
+        m.push_back({"tp_flags", "long", Scalar::LONG, ""});
+    } else {
+        m.push_back({"tp_flags", "unsigned long", Scalar::ULONG, ""});
+    }
+    m.push_back({"tp_doc", "const char *", P, ""});
+    m.push_back({"tp_traverse", "traverseproc", P, ""});
+    m.push_back({"tp_clear", "inquiry", P, ""});
+    m.push_back({"tp_richcompare", "richcmpfunc", P, ""});
+    m.push_back({"tp_weaklistoffset", "Py_ssize_t", Scalar::SSIZE, ""});
+    m.push_back({"tp_iter", "getiterfunc", P, ""});
+    m.push_back({"tp_iternext", "iternextfunc", P, ""});
+    m.push_back({"tp_methods", "struct PyMethodDef *", P, ""});
+    m.push_back({"tp_members", "struct PyMemberDef *", P, ""});
+    m.push_back({"tp_getset", "struct PyGetSetDef *", P, ""});
+    m.push_back({"tp_base", "struct _typeobject *", P, ""});
+    m.push_back({"tp_dict", "PyObject *", P, ""});
+    m.push_back({"tp_descr_get", "descrgetfunc", P, ""});
+    m.push_back({"tp_descr_set", "descrsetfunc", P, ""});
+    m.push_back({"tp_dictoffset", "Py_ssize_t", Scalar::SSIZE, ""});
+    m.push_back({"tp_init", "initproc", P, ""});
+    m.push_back({"tp_alloc", "allocfunc", P, ""});
+    m.push_back({"tp_new", "newfunc", P, ""});
+    m.push_back({"tp_free", "freefunc", P, ""});
+    m.push_back({"tp_is_gc", "inquiry", P, ""});
+    m.push_back({"tp_bases", "PyObject *", P, ""});
+    m.push_back({"tp_mro", "PyObject *", P, ""});
+    m.push_back({"tp_cache", "PyObject *", P, ""});
+    m.push_back({"tp_subclasses", v.at_least(3, 12) ? "void *" : "PyObject *", P, ""});
+    m.push_back({"tp_weaklist", "PyObject *", P, ""});
+    m.push_back({"tp_del", "destructor", P, ""});
+    m.push_back({"tp_version_tag", "unsigned int", Scalar::UINT, ""});
+    if (v.at_least(3, 4)) {
+        m.push_back({"tp_finalize", "destructor", P, ""});
+    }
+    if (v.at_least(3, 8)) {
+        m.push_back({"tp_vectorcall", "vectorcallfunc", P, ""});
+    }
+    if (v.major == 3 && v.minor == 8) {
+        m.push_back({"tp_print", "printfunc", P, ""});  // kept for binary compatibility, gone in 3.9
+    }
+    if (v.at_least(3, 12)) {
+        m.push_back({"tp_watched", "unsigned char", Scalar::UCHAR, ""});
+    }
+    if (v.at_least(3, 13)) {
+        m.push_back({"tp_versions_used", "uint16_t", Scalar::U16, ""});
+    }
+    return m;
+}
+
+// The three structures for one version, build flavour and organization.
+class Layouts {
+  public:
+    Layouts(const Version &v, const gdt::DataOrganization &org, bool trace_refs = false)
+        : version_(v), org_(org), trace_refs_(trace_refs) {
+        object_ = lay_out("PyObject", object_members(trace_refs));
+        var_object_ = lay_out("PyVarObject", var_object_members());
+        type_ = lay_out("PyTypeObject", type_members(v));
+    }
+
+    const Version &version() const { return version_; }
+    const gdt::DataOrganization &organization() const { return org_; }
+    bool trace_refs() const { return trace_refs_; }
+
+    const StructLayout &object() const { return object_; }
+    const StructLayout &var_object() const { return var_object_; }
+    const StructLayout &type() const { return type_; }
+    std::vector<const StructLayout *> all() const { return {&object_, &var_object_, &type_}; }
+
+    // The members each structure is built from, in order.
+    std::vector<Member> members(const std::string &name) const {
+        if (name == "PyObject") {
+            return object_members(trace_refs_);
+        }
+        if (name == "PyVarObject") {
+            return var_object_members();
+        }
+        return type_members(version_);
+    }
+
+    uint64_t scalar_size(Scalar s) const {
+        switch (s) {
+        case Scalar::SSIZE:
+        case Scalar::POINTER: return org_.pointer_size;
+        case Scalar::LONG:
+        case Scalar::ULONG: return org_.long_size;
+        case Scalar::UINT: return 4;
+        case Scalar::U16: return 2;
+        case Scalar::UCHAR: return 1;
+        }
+        return 0;
+    }
+
+  private:
+    StructLayout lay_out(const std::string &name, const std::vector<Member> &members) const {
+        StructLayout s;
+        s.name = name;
+        for (const Member &m : members) {
+            uint64_t size, align;
+            if (!m.nested.empty()) {
+                const StructLayout &n = m.nested == "PyObject" ? object_ : var_object_;
+                size = n.size;
+                align = n.align;
+            } else {
+                size = align = scalar_size(m.scalar);
+            }
+            uint64_t off = (s.size + align - 1) / align * align;
+            s.fields.push_back({m.name, m.ctype, off, size});
+            s.size = off + size;
+            s.align = std::max(s.align, align);
+        }
+        s.size = (s.size + s.align - 1) / s.align * s.align;
+        return s;
+    }
+
+    Version version_;
+    gdt::DataOrganization org_;
+    bool trace_refs_;
+    StructLayout object_;
+    StructLayout var_object_;
+    StructLayout type_;
+};
+
+}  // namespace python
@@ -0,0 +1,437 @@
+/*
+ *   py_types: recover the CPython object layouts that libCPython.gdt only
+ *   has as placeholders (PyObject as field_0x0 .. field_0xf), for a given
+ *   interpreter version and data organization (python/py_layout.hpp).
+ *
+ *   The version comes from --version or is detected from a binary with
+ *   --detect (the "libpythonX.Y" / "pythonX.Y" names it links against or
+ *   embeds). With an archive, the pointer width is taken from the size of
+ *   its PyObject unless --org is given, and every placeholder member is
+ *   mapped onto the real member that covers it.
+ *
+ *   The default output lists PyObject, PyVarObject and PyTypeObject like
+ *   gdt_vtable does (offset, member, declaration); --header writes them as
+ *   C declarations with the slot typedefs. --gdt writes an archive instead:
+ *   those declarations are compiled for the organization
+ *   (gdt/gdt_compile.hpp) and added to the input archive through the
+ *   native writer (gdt/gdt_write.hpp). The placeholder PyObject keeps its
+ *   id, name and category and takes the real members. Everything else goes
+ *   to a new /object.h category under ids after the archive's own, sharing
+ *   the built-ins, pointers and arrays the archive has. Without an input
+ *   archive, the layouts are written alone. One line on stdout:
+ *
+ *     out  types  bytes
+ *
+ *   Build:
+ *     c++ -std=c++17 -O2 -Itools tools/python/py_types.cpp -o py_types
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/hash.hpp"
+#include "common/mapped_file.hpp"
+#include "gdt/gdt_compile.hpp"
+#include "gdt/gdt_types.hpp"
+#include "gdt/gdt_write.hpp"
+#include "python/py_layout.hpp"
+
+
+namespace {
+
+struct Options {
+    std::string version;
+    std::string detect;
+    std::string org;
+    bool trace_refs = false;
+    bool header = false;
+    std::string gdt;
+    std::string archive;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: py_types [options] [libCPython.gdt]\n"
+                 "  --version X.Y  CPython version (2.7, 3.0 - 3.13; default 3.8)\n"
+                 "  --detect FILE  take the version from a binary linked against or embedding libpython\n"
+                 "  --org NAME     data organization: lp64, ilp32, llp64, i386 (default: from the\n"
+                 "                 archive's PyObject, else lp64)\n"
+                 "  --trace-refs   Py_TRACE_REFS build (_ob_next/_ob_prev in every object)\n"
+                 "  --header       emit C declarations instead of the layout listing\n"
+                 "  --gdt OUT      write the layouts as an archive: the input archive with them added, or\n"
+                 "                 them alone\n");
+    std::exit(2);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (++i >= argc) {
+                usage();
+            }
+            return argv[i];
+        };
+        if (a == "--version") {
+            o.version = next();
+        } else if (a == "--detect") {
+            o.detect = next();
+        } else if (a == "--org") {
+            o.org = next();
+        } else if (a == "--trace-refs") {
+            o.trace_refs = true;
+        } else if (a == "--header") {
+            o.header = true;
+        } else if (a == "--gdt") {
+            o.gdt = next();
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+        } else if (o.archive.empty()) {
+            o.archive = a;
+        } else {
+            usage();
+        }
+    }
+    return o;
+}
+
+std::string basename(const std::string &path) { return path.substr(path.find_last_of('/') + 1); }
+
+// First "libpythonX.Y" in the file, else the first "pythonX.Y".
+bool detect_version(const std::string &path, python::Version &v) {
+    common::MappedFile f(path);
+    const char *d = reinterpret_cast<const char *>(f.data());
+    const char *end = d + f.size();
+    for (const std::string needle : {"libpython", "python"}) {
+        for (const char *p = d; (p = std::search(p, end, needle.begin(), needle.end())) != end; p++) {
+            const char *q = p + needle.size();
+            std::string s;
+            while (q < end && s.size() < 6 && ((*q >= '0' && *q <= '9') || *q == '.')) {
+                s += *q++;
+            }
+            unsigned major, minor;
+            char dot;
+            if (std::sscanf(s.c_str(), "%u%c%u", &major, &dot, &minor) == 3 && dot == '.') {
+                python::Version c{major, minor};
+                if (c.supported()) {
+                    v = c;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// The member of 'real' that covers byte 'offset', or "(padding)".
+std::string covering(const python::StructLayout &real, uint64_t offset) {
+    for (const python::Field &f : real.fields) {
+        if (offset >= f.offset && offset < f.offset + f.size) {
+            return f.name;
+        }
+    }
+    return "(padding)";
+}
+
+void print_placeholders(const gdt::Archive &a, const gdt::DataType &placeholder, const python::StructLayout &real) {
+    std::printf("# %s in the archive (%d bytes) -> %s (%" PRIu64 " bytes)\n", placeholder.name.c_str(),
+                placeholder.length, real.name.c_str(), real.size);
+    for (const gdt::Component &c : placeholder.components) {
+        std::printf("0x%04x\t%s\t%s\n", c.offset, a.decl(c.type, c.name).c_str(),
+                    covering(real, uint64_t(c.offset)).c_str());
+    }
+}
+
+std::string declaration(const python::Field &f) {
+    const std::string &t = f.ctype;
+    return t.back() == '*' ? t + f.name : t + " " + f.name;
+}
+
+// The three structures as C declarations, with the slot typedefs and what
+// they refer to.
+std::string header_text(const python::Layouts &l) {
+    const gdt::DataOrganization &org = l.organization();
+    std::string ssize = org.pointer_size == 8 ? (org.long_size == 8 ? "long" : "long long") : "int";
+    std::string h = "/*\n"
+                    " *   CPython " + l.version().str() + " object layouts, " + org.name + " (" +
+                    std::to_string(org.pointer_size) + "-byte pointers)" + (l.trace_refs() ? ", Py_TRACE_REFS" : "") +
+                    ".\n"
+                    " *\n"
+                    " *   Generated by tools/python/py_types.cpp.\n"
+                    " */\n\n";
+    h += "typedef " + ssize + " Py_ssize_t;\ntypedef Py_ssize_t Py_hash_t;\ntypedef unsigned " + ssize +
+         " size_t;\ntypedef unsigned short uint16_t;\ntypedef struct _IO_FILE FILE;\n\n";
+    h += "struct _object;\nstruct _typeobject;\ntypedef struct _object PyObject;\n"
+         "typedef struct _typeobject PyTypeObject;\n";
+    for (const char *opaque : {"PyAsyncMethods", "PyNumberMethods", "PySequenceMethods", "PyMappingMethods",
+                               "PyBufferProcs"}) {
+        h += std::string("typedef struct ") + opaque + " " + opaque + ";\n";
+    }
+    h += "struct PyMethodDef;\nstruct PyMemberDef;\nstruct PyGetSetDef;\n\n";
+    for (const python::SlotType &s : python::slot_types()) {
+        h += std::string("typedef ") + s.decl + ";\n";
+    }
+    const char *tags[] = {"_object", "", "_typeobject"};
+    std::vector<const python::StructLayout *> all = l.all();
+    char hex[32];
+    for (size_t i = 0; i < all.size(); i++) {
+        const python::StructLayout &s = *all[i];
+        h += "\n/* " + std::to_string(s.size) + " bytes */\n";
+        h += *tags[i] ? std::string("struct ") + tags[i] + " {\n" : "typedef struct {\n";
+        for (const python::Field &f : s.fields) {
+            std::snprintf(hex, sizeof hex, "0x%" PRIx64, f.offset);
+            h += "    " + declaration(f) + ";  /* " + hex + " */\n";
+        }
+        h += *tags[i] ? "};\n" : "} " + s.name + ";\n";
+    }
+    return h;
+}
+
+// The declarations of header_text() compiled into an archive, in one
+// category named after CPython's object.h.
+std::vector<uint8_t> compile_layouts(const python::Layouts &l, int64_t id) {
+    std::string text = header_text(l);
+    common::Preprocessor pp("object.h");
+    gdt::predefine(pp, l.organization());
+    gdt::CUnit unit;
+    unit.name = "object.h";
+    std::vector<common::CToken> tokens;
+    pp.run(common::c_lines(text.data(), text.size()), &tokens, &unit.defines);
+    pp.finish();
+    gdt::CParser(tokens, unit).parse();
+    gdt::Compiler compiler(l.organization(), 0);
+    compiler.add(unit);
+    if (!unit.diagnostics.empty() || !compiler.warnings().empty()) {
+        const gdt::CDiagnostic &d = unit.diagnostics.empty() ? compiler.warnings()[0] : unit.diagnostics[0];
+        throw std::runtime_error("object.h:" + std::to_string(d.line) + ": " + d.message);
+    }
+    gdt::ArchiveWriter w;
+    compiler.write(w);
+    return w.image(id, "object.h");
+}
+
+// 'in' with the compiled layouts added under fresh ids: the placeholder
+// takes the members of struct _object and stands for it and for the
+// PyObject typedef, built-ins, pointers and arrays the archive already has
+// are shared, and the rest goes to the /object.h category.
+void enrich(const gdt::Archive &in, const gdt::DataType &placeholder, const gdt::Archive &layouts,
+            gdt::ArchiveWriter &w) {
+    std::map<int64_t, int64_t> category{{0, 0}};
+    int64_t next_category = 1;
+    for (const auto &kv : in.categories()) {
+        next_category = std::max(next_category, kv.first + 1);
+        if (kv.second.parent == 0 && kv.second.name == "object.h") {
+            throw std::runtime_error("the archive already has /object.h");
+        }
+    }
+    for (const auto &kv : layouts.categories()) {
+        if (kv.first != 0) {
+            category[kv.first] = next_category++;
+        }
+    }
+
+    // Ids by table continue after those of the archive.
+    std::map<uint8_t, int64_t> next_key;
+    std::map<std::string, int64_t> builtins;  // by name
+    std::map<std::pair<int64_t, int32_t>, int64_t> derived;  // pointers and arrays by (target, length or count)
+    for (const gdt::DataType *t : in.types()) {
+        int64_t &k = next_key[t->table()];
+        k = std::max(k, gdt::key_of(t->id) + 1);
+        if (t->table() == gdt::T_BUILTIN) {
+            builtins.emplace(t->name, t->id);
+        } else if (t->table() == gdt::T_POINTER || t->table() == gdt::T_ARRAY) {
+            derived.emplace(std::make_pair(t->target, t->table() == gdt::T_POINTER ? t->length : t->count), t->id);
+        }
+    }
+
+    std::map<int64_t, int64_t> ids;
+    for (const gdt::DataType *t : layouts.types()) {
+        if (t->name == "_object" && t->table() == gdt::T_COMPOSITE) {
+            ids[t->id] = placeholder.id;
+        } else if (t->name == "PyObject" && t->table() == gdt::T_TYPEDEF) {
+            ids[t->id] = placeholder.id;
+        }
+    }
+    std::vector<gdt::DataType> added;
+    std::function<int64_t(int64_t)> map = [&](int64_t id) -> int64_t {
+        if (id == gdt::NULL_ID || id == gdt::DEFAULT_ID) {
+            return id;
+        }
+        auto it = ids.find(id);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        const gdt::DataType *t = layouts.get(id);
+        if (!t) {
+            throw std::runtime_error("compiled layouts refer to a missing type");
+        }
+        gdt::DataType d = *t;
+        if (d.table() == gdt::T_BUILTIN && builtins.count(d.name)) {
+            return ids[id] = builtins.at(d.name);
+        }
+        if (d.table() == gdt::T_POINTER || d.table() == gdt::T_ARRAY) {
+            d.target = map(d.target);
+            auto key = std::make_pair(d.target, d.table() == gdt::T_POINTER ? d.length : d.count);
+            auto same = derived.find(key);
+            if (same != derived.end()) {
+                return ids[id] = same->second;
+            }
+            d.id = gdt::make_id(d.table(), next_key[d.table()]++);
+            derived.emplace(key, d.id);
+        } else {
+            d.id = gdt::make_id(d.table(), next_key[d.table()]++);
+        }
+        ids[id] = d.id;
+        d.category = category.at(d.category);
+        added.push_back(std::move(d));
+        return ids[id];
+    };
+    auto refs = [&](gdt::DataType &d) {
+        d.return_type = map(d.return_type);
+        if (d.table() != gdt::T_POINTER && d.table() != gdt::T_ARRAY) {  // mapped when added
+            d.target = map(d.target);
+        }
+        for (gdt::Component &c : d.components) {
+            c.type = map(c.type);
+        }
+        for (gdt::Parameter &p : d.params) {
+            p.type = map(p.type);
+        }
+    };
+    for (const gdt::DataType *t : layouts.types()) {
+        map(t->id);
+    }
+    for (size_t i = 0; i < added.size(); i++) {  // map() may append
+        gdt::DataType d = added[i];
+        refs(d);
+        added[i] = std::move(d);
+    }
+
+    gdt::DataType object = placeholder;
+    const gdt::DataType *real = nullptr;
+    for (const gdt::DataType *t : layouts.types()) {
+        if (t->name == "_object" && t->table() == gdt::T_COMPOSITE) {
+            real = t;
+        }
+    }
+    if (!real) {
+        throw std::runtime_error("compiled layouts lack struct _object");
+    }
+    object.length = real->length;
+    object.num_components = real->num_components;
+    object.packing = real->packing;
+    object.alignment = real->alignment;
+    object.components = real->components;
+    refs(object);
+
+    for (const auto &kv : in.categories()) {
+        w.add(kv.second);
+    }
+    for (const auto &kv : layouts.categories()) {
+        if (kv.first != 0) {
+            gdt::Category c = kv.second;
+            c.id = category.at(c.id);
+            c.parent = category.at(c.parent);
+            w.add(c);
+        }
+    }
+    for (const gdt::DataType *t : in.types()) {
+        w.add(t->id == placeholder.id ? object : *t);
+    }
+    for (const gdt::DataType &d : added) {
+        w.add(d);
+    }
+    for (const gdt::SourceArchive &s : in.source_archives()) {
+        w.add(s);
+    }
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    Options opt = parse_args(argc, argv);
+    std::string where = opt.archive;
+    try {
+        python::Version version = python::Version::parse("3.8");
+        if (!opt.version.empty()) {
+            version = python::Version::parse(opt.version);
+        } else if (!opt.detect.empty()) {
+            where = opt.detect;
+            if (!detect_version(opt.detect, version)) {
+                throw std::runtime_error("no libpython version found");
+            }
+            std::fprintf(stderr, "py_types: %s: CPython %s\n", opt.detect.c_str(), version.str().c_str());
+        }
+
+        std::unique_ptr<gdt::Archive> archive;
+        const gdt::DataType *placeholder = nullptr;
+        where = opt.archive;
+        if (!opt.archive.empty()) {
+            archive.reset(new gdt::Archive(opt.archive));
+            placeholder = archive->find("PyObject");
+            if (!placeholder || placeholder->table() != gdt::T_COMPOSITE) {
+                throw std::runtime_error("no PyObject structure");
+            }
+        }
+        std::string org = opt.org;
+        if (org.empty()) {
+            // ob_refcnt and ob_type: two words, four with Py_TRACE_REFS.
+            unsigned words = opt.trace_refs ? 4 : 2;
+            org = placeholder && placeholder->length == int32_t(4 * words) ? "ilp32" : "lp64";
+        }
+        python::Layouts layouts(version, gdt::DataOrganization::named(org), opt.trace_refs);
+        if (placeholder && uint64_t(placeholder->length) != layouts.object().size) {
+            std::fprintf(stderr, "py_types: %s: PyObject is %d bytes, %s on %s has %" PRIu64 "\n",
+                         opt.archive.c_str(), placeholder->length, version.str().c_str(), org.c_str(),
+                         layouts.object().size);
+        }
+
+        if (opt.header) {
+            std::fputs(header_text(layouts).c_str(), stdout);
+            return 0;
+        }
+        if (!opt.gdt.empty()) {
+            uint64_t h = common::hash_string("object.h/" + version.str() + "/" + org);
+            int64_t id = archive ? archive->db().database_id() : int64_t(common::mix64(h) >> 1);
+            std::vector<uint8_t> image = compile_layouts(layouts, id);
+            gdt::Archive compiled(image.data(), image.size());
+            gdt::ArchiveWriter w;
+            if (archive) {
+                enrich(*archive, *placeholder, compiled, w);
+                w.metadata(archive->db().table("Metadata") != nullptr);
+            } else {
+                w.add(compiled);
+            }
+            where = opt.gdt;
+            w.write(opt.gdt, id, basename(opt.gdt));
+            common::MappedFile written(opt.gdt);
+            std::printf("%s\t%zu\t%zu\n", opt.gdt.c_str(), w.types(), written.size());
+            return 0;
+        }
+        if (placeholder) {
+            print_placeholders(*archive, *placeholder, layouts.object());
+        }
+        for (const python::StructLayout *s : layouts.all()) {
+            std::printf("# %s (%s, %s, %" PRIu64 " bytes)\n", s->name.c_str(), version.str().c_str(), org.c_str(),
+                        s->size);
+            for (const python::Field &f : s->fields) {
+                std::printf("0x%04" PRIx64 "\t%s\t%s\n", f.offset, f.name.c_str(), declaration(f).c_str());
+            }
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "py_types: %s: %s\n", where.empty() ? "-" : where.c_str(), e.what());
+        return 1;
+    }
+    return 0;
+}